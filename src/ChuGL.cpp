@@ -70,6 +70,11 @@ t_CKBOOL chugl_main_loop_hook(void* bindle)
 
     ASSERT(g_chuglAPI && g_chuglVM);
 
+    // log_*() calls are queued and written by a background thread from here on,
+    // so they are safe to leave on the render + audio thread hot paths.
+    // Stopped by chugl_on_shutdown()
+    log_set_async(true);
+
     App::init(&chugl_app, g_chuglVM, g_chuglAPI);
     App::start(&chugl_app); // blocking
 
@@ -79,6 +84,12 @@ t_CKBOOL chugl_main_loop_hook(void* bindle)
         if (g_chuglVM && g_chuglAPI) g_chuglAPI->vm->remove_all_shreds(g_chuglVM);
 
         App::end(&chugl_app);
+
+        // after App::end(), nothing is stepping box2d worlds anymore
+        b2_Scheduler_FreeAll();
+
+        // write out anything the render thread queued while shutting down
+        log_flush();
     }
 
     return true;
@@ -99,6 +110,15 @@ t_CKBOOL chugl_main_loop_quit(void* bindle)
     return true;
 }
 
+// runs on host shutdown whether or not the main loop hook ever ran
+void chugl_on_shutdown(void* bindle)
+{
+    UNUSED_VAR(bindle);
+
+    // write out anything still queued and stop the async log writer
+    log_shutdown();
+}
+
 // ChuGL chugin info func
 CK_DLL_INFO(ChuGL)
 {
@@ -265,6 +285,61 @@ static void FlushGraphicsToAudioCQ()
                 Event_Broadcast(cmd->texture_save_event);
                 API->object->release((Chuck_Object*)cmd->texture_save_event);
             } break;
+            case SG_COMMAND_G2A_TEXTURE_LOADED: {
+                SG_Command_G2A_TextureLoaded* cmd
+                  = (SG_Command_G2A_TextureLoaded*)command;
+                SG_Texture* texture = SG_GetTexture(cmd->texture_id);
+
+                // if texture was already GC'd, skip
+                if (!texture) break;
+
+                // on failure the texture keeps its placeholder contents, still
+                // broadcast so that shreds waiting on it don't hang
+                texture->loading = false;
+                if (cmd->success) texture->desc = cmd->desc;
+                if (texture->texture_loaded_event) {
+                    Event_Broadcast(texture->texture_loaded_event);
+                }
+            } break;
+            case SG_COMMAND_G2A_VIDEO_STATS: {
+                SG_Command_G2A_VideoStats* cmd = (SG_Command_G2A_VideoStats*)command;
+                SG_Video* video                = SG_GetVideo(cmd->video_id);
+                if (video) {
+                    video->stats = cmd->stats;
+                    if (cmd->stats.resync) {
+                        ulib_video_resync(video, cmd->stats.stream_time);
+                    }
+                }
+            } break;
+            case SG_COMMAND_G2A_TEXT_BOUNDS: {
+                SG_Command_G2A_TextBounds* cmd = (SG_Command_G2A_TextBounds*)command;
+                SG_Text* text                  = SG_GetText(cmd->text_id);
+                if (text) {
+                    text->bounds = { cmd->min_x, cmd->min_y, cmd->max_x, cmd->max_y };
+                }
+            } break;
+            case SG_COMMAND_G2A_FONT_STATS: {
+                SG_Command_G2A_FontStats* cmd = (SG_Command_G2A_FontStats*)command;
+                ulib_text_font_references     = cmd->font_references;
+            } break;
+            case SG_COMMAND_G2A_SCENE_LIGHT_STATS: {
+                SG_Command_G2A_SceneLightStats* cmd
+                  = (SG_Command_G2A_SceneLightStats*)command;
+                SG_Scene* scene = SG_GetScene(cmd->scene_id);
+                if (scene) {
+                    scene->lights_active   = cmd->lights_active;
+                    scene->lights_uploaded = cmd->lights_uploaded;
+                }
+            } break;
+            case SG_COMMAND_G2A_SCENE_PASS_CULL_STATS: {
+                SG_Command_G2A_ScenePassCullStats* cmd
+                  = (SG_Command_G2A_ScenePassCullStats*)command;
+                SG_Pass* pass = SG_GetPass(cmd->pass_id);
+                if (pass) {
+                    pass->scene_pass_visible_instances  = cmd->visible_instances;
+                    pass->scene_pass_occluded_instances = cmd->occluded_instances;
+                }
+            } break;
             case SG_COMMAND_G2A_GAMEPAD_STATE: {
                 SG_Command_G2A_GamepadState* cmd
                   = (SG_Command_G2A_GamepadState*)command;
@@ -370,6 +445,12 @@ static void chugl_GraphicsShredPerformNextFrameUpdate(Chuck_VM_Shred* SHRED)
 #endif
         }
 
+        // copy box2d transforms into GGens bound with b2Body.bind()
+        ulib_box2d_syncBoundGGens();
+
+        // swap in geometry finished building on the job pool
+        ulib_geometry_applyAsyncBuilds();
+
         // traverse rendegraph chuck-defined update() on all render passes
         if (gg_config.auto_update_scenegraph) {
             SG_Pass* pass = SG_GetPass(gg_config.root_pass_id);
@@ -599,6 +680,13 @@ CK_DLL_SFUN(chugl_set_log_level)
     log_set_level(GET_NEXT_INT(ARGS));
 }
 
+CK_DLL_SFUN(chugl_set_subsystem_log_level)
+{
+    t_CKINT subsystem = GET_NEXT_INT(ARGS);
+    t_CKINT level     = GET_NEXT_INT(ARGS);
+    log_set_subsystem_level(subsystem, level);
+}
+
 CK_DLL_SFUN(chugl_get_window_width)
 {
     RETURN->v_float = CHUGL_Window_WindowSize().x;
@@ -845,6 +933,7 @@ CK_DLL_QUERY(ChuGL)
 #ifdef CHUGL_RELEASE
     log_set_level(LOG_WARN); // only log errors and fatal in release mode
 #endif
+    QUERY->register_callback_on_shutdown(QUERY, chugl_on_shutdown, NULL);
 
     // remember
     g_chuglVM  = QUERY->ck_vm(QUERY);
@@ -1015,6 +1104,32 @@ CK_DLL_QUERY(ChuGL)
           "Setting a log level will allow all messages of that level and higher "
           "to be printed to the console. Default is GG.LogLevel_Error.");
 
+        static t_CKUINT gg_log_subsystem_render  = LOG_SUBSYSTEM_RENDER;
+        static t_CKUINT gg_log_subsystem_chuck   = LOG_SUBSYSTEM_CHUCK;
+        static t_CKUINT gg_log_subsystem_video   = LOG_SUBSYSTEM_VIDEO;
+        static t_CKUINT gg_log_subsystem_physics = LOG_SUBSYSTEM_PHYSICS;
+        SVAR("int", "LogSubsystem_Render", &gg_log_subsystem_render);
+        DOC_VAR(
+          "Log subsystem for the renderer and graphics thread. "
+          "See GG.logLevel(int, int)");
+        SVAR("int", "LogSubsystem_ChucK", &gg_log_subsystem_chuck);
+        DOC_VAR(
+          "Log subsystem for the ChucK-facing API on the audio thread. "
+          "See GG.logLevel(int, int)");
+        SVAR("int", "LogSubsystem_Video", &gg_log_subsystem_video);
+        DOC_VAR("Log subsystem for video decoding. See GG.logLevel(int, int)");
+        SVAR("int", "LogSubsystem_Physics", &gg_log_subsystem_physics);
+        DOC_VAR("Log subsystem for box2d physics. See GG.logLevel(int, int)");
+
+        SFUN(chugl_set_subsystem_log_level, "void", "logLevel");
+        ARG("int", "subsystem");
+        ARG("int", "level");
+        DOC_FUNC(
+          "Set the log level for a single ChuGL subsystem, overriding GG.logLevel(). "
+          "Subsystems are: GG.LogSubsystem_Render, GG.LogSubsystem_ChucK, "
+          "GG.LogSubsystem_Video, GG.LogSubsystem_Physics. Pass a level of -1 to "
+          "go back to using the global log level.");
+
         QUERY->add_sfun(QUERY, chugl_next_frame, "NextFrameEvent", "nextFrame");
         QUERY->doc_func(
           QUERY,
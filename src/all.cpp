@@ -32,11 +32,14 @@
 
 #include "chugl_defines.h"
 #include "graphics.cpp"
+#include "texture_compress.cpp"
 #include "geometry.cpp"
 #include "sync.cpp"
 #include "sg_component.cpp" // chugl scenegraph API
 #include "sg_command.cpp"
 #include "r_component.cpp" // chugl renderer API
+#include "text_layout.cpp"
+#include "physics.cpp"
 #include "app.cpp"
 
 // clang-format on
@@ -56,11 +56,13 @@ static_assert(sizeof(u32) == sizeof(b2WorldId), "b2WorldId != u32");
 
 // #include "camera.cpp"
 #include "graphics.h"
+#include "physics.h"
 #include "r_component.h"
 #include "sg_command.h"
 #include "sg_component.h"
 
 #include "core/hashmap.h"
+#include "core/jobs.h"
 #include "core/log.h"
 
 #include "compressed_fonts.h"
@@ -250,7 +252,9 @@ struct App;
 static void _R_HandleCommand(App* app, SG_Command* command);
 
 static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* camera,
-                           G_DrawCallListID dc_list);
+                           G_DrawCallListID dc_list, int instance_cull_pass);
+static int _R_AddInstanceCullPass(App* app, R_Scene* scene, R_Pass* pass);
+static void _R_MapCullStats(App* app);
 
 static void _R_glfwErrorCallback(int error, const char* description)
 {
@@ -297,12 +301,12 @@ struct App {
     // box2D physics
     b2_SimulateDesc b2_sim_desc;
 
-    // FreeType
-    FT_Library FTLibrary;
+    // fonts
     R_Font* default_font;
 
     // memory
     Arena frameArena;
+    Arena cull_stats_map_list; // SG_ID of passes to map cull stats for after submit
 
     // render graph
     SG_ID root_pass_id;
@@ -324,6 +328,7 @@ struct App {
         app->ckapi = api;
 
         Arena::init(&app->frameArena, MEGABYTE); // 1MB
+        Arena::init(&app->cull_stats_map_list, 16 * sizeof(SG_ID));
 
         // init rendergraph
         app->rendergraph.init();
@@ -383,19 +388,16 @@ struct App {
             return;
         }
 
-        { // Initialize FT and builtin fonts
-            FT_Error error = FT_Init_FreeType(&app->FTLibrary);
-            if (error) {
-                log_fatal("Failed to initialize FreeType\n");
+        { // Initialize builtin fonts
+            R_Font* builtin_font = Component_GetFont(&app->gctx, "chugl:cousine-regular");
+            if (!builtin_font || !builtin_font->ready) {
+                log_fatal("Failed to load builtin font\n");
                 return;
             }
 
-            R_Font* builtin_font
-              = Component_GetFont(&app->gctx, app->FTLibrary, "chugl:cousine-regular");
-            ASSERT(builtin_font);
-
-            app->default_font = builtin_font; // safe to store ptr because all fonts are
-                                              // kept in static array
+            // the registry keeps fonts alive while referenced
+            Component_FontAcquire(builtin_font);
+            app->default_font = builtin_font;
         }
 
         // initialize R_Component manager
@@ -531,6 +533,10 @@ struct App {
 
     static void end(App* app)
     {
+        // stop background work before tearing down the state it touches
+        Physics_Shutdown(); // physics tasks run on the Jobs pool
+        Jobs_Shutdown();
+
         // free R_Components
         Component_Free();
 
@@ -551,6 +557,7 @@ struct App {
 
         // free memory
         Arena::free(&app->frameArena);
+        Arena::free(&app->cull_stats_map_list);
     }
 
     // ============================================================================
@@ -678,21 +685,11 @@ struct App {
             // critical_section_stats.update(stm_since(critical_start));
 
             // physics
-            // we intentionally are NOT having a fixed timestep for the sake of
-            // simplicity.
-            // instead, rely on vsync + stable framerate
-            // https://gafferongames.com/post/fix_your_timestep/
-            b2WorldId b2_world_id = *(b2WorldId*)&app->b2_sim_desc.world_id;
-            if (b2World_IsValid(b2_world_id)) {
-                b2World_Step(b2_world_id, app->b2_sim_desc.rate * app->dt,
-                             app->b2_sim_desc.substeps);
-                // log_trace("simulating b2 substeps: %d rate: %f",
-                //           app->b2_sim_desc.substeps, app->b2_sim_desc.rate);
-
-                // debug draw
-                // log_trace("drawing debug");
-                // b2World_Draw(app->b2_world_id, &debug_draw);
-            }
+            // steps at b2_sim_desc.fixed_timestep with an accumulator. When
+            // threaded, this only hands the frame's dt to the physics thread,
+            // which steps while chuck runs its next frame
+            Physics_Update(&app->b2_sim_desc, app->dt);
+            Physics_SyncTransforms();
         }
 
         // done swapping the double buffer, let chuck know it's good to continue
@@ -736,6 +733,12 @@ struct App {
             CQ_ReadCommandQueueClear();
         }
 
+        // upload textures decoded in the background since last frame
+        R_Texture::flushAsyncLoads(&app->gctx);
+
+        // simplify and upload geometry LOD chains
+        R_Geometry::flushLODJobs(&app->gctx);
+
         // garbage collection! delete GPU-side data for any scenegraph objects
         // that were deleted in chuck
         // renderer.ProcessDeletionQueue(
@@ -750,23 +753,36 @@ struct App {
             return;
         }
 
-        { // update webcam textures
+        // finish fonts loaded on the Jobs pool, evict unused ones
+        Component_UpdateFonts(&app->gctx, app->default_font);
+
+        { // upload webcam and video frames. Capture and decoding run on other threads
+            WGPUCommandEncoder cmd_encoder = NULL;
+
             size_t webcam_idx = 0;
             R_Webcam* webcam  = NULL;
             while (Component_WebcamIter(&webcam_idx, &webcam)) {
-                R_Webcam::updateTexture(&app->gctx, webcam);
+                if (!cmd_encoder) {
+                    cmd_encoder = wgpuDeviceCreateCommandEncoder(app->gctx.device, NULL);
+                }
+                R_Webcam::updateTexture(&app->gctx, cmd_encoder, webcam);
             }
-        }
 
-        { // decode all current video textures
-            // ==optimize== threadpool for decoding
             size_t video_idx = 0;
             R_Video* video   = NULL;
             while (Component_VideoIter(&video_idx, &video)) {
-                if (video->plm) {
-                    // log_info("decoding video %d, dt: %f", video->id, dt_sec);
-                    plm_decode_last_frame_only(video->plm, dt_sec * video->rate);
+                if (!cmd_encoder) {
+                    cmd_encoder = wgpuDeviceCreateCommandEncoder(app->gctx.device, NULL);
                 }
+                R_Video::update(&app->gctx, cmd_encoder, video, dt_sec);
+            }
+
+            if (cmd_encoder) { // yuv to rgba conversions
+                WGPUCommandBuffer command_buffer
+                  = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+                WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder);
+                wgpuQueueSubmit(app->gctx.queue, 1, &command_buffer);
+                WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer);
             }
         }
 
@@ -831,18 +847,56 @@ struct App {
                     ASSERT(scene && color_target && camera);
 
                     R_Scene::update(scene, &app->gctx, app->fc, &app->frameArena,
-                                    &app->rendergraph, &frameUniforms);
+                                    &app->rendergraph, &frameUniforms, camera,
+                                    camera->params.auto_update_aspect ?
+                                      aspect :
+                                      camera->params.aspect);
                     ASSERT(scene->last_fc_updated == app->fc);
 
-                    // shadow pass --------------------------------------------
-                    snprintf(string_buff, sizeof(string_buff),
-                             "Scene Shadow Pass[%d] %s", pass->id, pass->name);
-                    // app->rendergraph.addRenderPass(string_buff);
-                    // app->rendergraph
-                    //   .renderPassDepthTarget()
+                    // shadow passes are added by R_Scene::update() above, and
+                    // only for lights whose shadow casters or views changed
 
-                    // mesh pass ----------------------------------------------
+                    // light cluster pass -------------------------------------
+                    if (!pass->light_cluster_buffer.buf) {
+                        GPU_Buffer::init(&app->gctx, &pass->light_cluster_buffer,
+                                         WGPUBufferUsage_Storage,
+                                         CHUGL_LIGHT_CLUSTER_BUFFER_SIZE);
+                    }
+                    // sized up front so culling the lights below never recreates it
+                    u64 active_light_buffer_size
+                      = MAX(R_Scene::numLights(scene), 1) * sizeof(u32);
+                    GPU_Buffer::resizeNoCopy(&app->gctx, &pass->active_light_buffer,
+                                             active_light_buffer_size,
+                                             WGPUBufferUsage_Storage);
+                    // lit shaders skip the cluster lookup when there are no lights
+                    if (R_Scene::numLights(scene) > 0) {
+                        snprintf(string_buff, sizeof(string_buff),
+                                 "LightClusterPass[%d:%s] for Scene[%d:%s]", pass->id,
+                                 pass->sg_pass.name, scene->id, scene->name);
+                        app->rendergraph.addLightClusterPass(
+                          string_buff, app->gctx.light_cluster_shader_module,
+                          pass->frame_uniform_buffer, scene->light_info_buffer.buf,
+                          scene->light_info_buffer.size, pass->active_light_buffer.buf,
+                          active_light_buffer_size, pass->light_cluster_buffer.buf);
+                    }
+
+                    // resized before the cull pass binds last frame's pyramid
                     R_Pass::updateScenePass(pass, color_target, app->gctx.device);
+                    bool occlusion_culling = pass->sg_pass.scene_pass_occlusion_culling;
+                    if (occlusion_culling) {
+                        R_Pass::updateHiZ(pass, app->gctx.device);
+                    } else {
+                        pass->hiz_valid = false;
+                    }
+
+                    // instance cull pass -------------------------------------
+                    // dispatches are added by _R_RenderScene()
+                    int instance_cull_pass = -1;
+                    if (pass->sg_pass.scene_pass_gpu_culling || occlusion_culling) {
+                        instance_cull_pass = _R_AddInstanceCullPass(app, scene, pass);
+                    }
+
+                    // mesh pass ----------------------------------------------
                     snprintf(string_buff, sizeof(string_buff),
                              "ScenePass[%d:%s] for Scene[%d:%s]", pass->id,
                              pass->sg_pass.name, scene->id, scene->name);
@@ -908,9 +962,28 @@ struct App {
                                                  pass->sg_pass.scissor_h, color_target);
                     }
 
+                    G_RenderPassParams* rp
+                      = &app->rendergraph.pass_list[app->rendergraph.pass_count - 1].rp;
+                    glm::vec4 viewport(rp->viewport_x, rp->viewport_y, rp->viewport_w,
+                                       rp->viewport_h);
+
                     G_DrawCallListID dc_list
                       = app->rendergraph.renderPassAddDrawCallList();
-                    _R_RenderScene(app, scene, pass, camera, dc_list);
+                    _R_RenderScene(app, scene, pass, camera, dc_list,
+                                   instance_cull_pass);
+
+                    // hi-z pass ----------------------------------------------
+                    // pyramid of this frame's depth, tested against next frame
+                    if (occlusion_culling) {
+                        snprintf(string_buff, sizeof(string_buff),
+                                 "HiZPass[%d:%s] for Scene[%d:%s]", pass->id,
+                                 pass->sg_pass.name, scene->id, scene->name);
+                        // a pyramid that wasn't built mustn't cull next frame
+                        pass->hiz_valid = app->rendergraph.addHiZPass(
+                          string_buff, pass->depth_texture, pass->hiz_texture);
+                        pass->hiz_viewport = viewport;
+                        // hiz_projection_view is set with the frame uniforms below
+                    }
                 } break;
                 case SG_PassType_Screen: {
                     R_Material* material
@@ -984,8 +1057,9 @@ struct App {
                     // create draw call
                     if (material) {
                         G_DrawCall* d = app->rendergraph.addDraw(dc_list);
-                        R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
-                                            &app->rendergraph, screen_shader, NULL);
+                        R_BindFrameUniforms(pass->frame_uniform_buffer, NULL,
+                                            &app->gctx, d, &app->rendergraph,
+                                            screen_shader, NULL);
                         d->sort_key = G_SortKey::create(false, G_RenderingLayer_World,
                                                         material->id, 0, 1);
                         d->vertex_count   = 3;
@@ -1197,6 +1271,20 @@ struct App {
                       = glm::inverse(frameUniforms.projection
                                      * glm::mat4(glm::mat3(frameUniforms.view)));
                     frameUniforms.camera_pos = camera->_pos;
+
+                    // perspective clusters are sliced logarithmically in depth so
+                    // near froxels stay small. orthographic depth is linear anyways
+                    frameUniforms.projection_inverse
+                      = glm::inverse(frameUniforms.projection);
+                    frameUniforms.cluster_near = camera->params.near_plane;
+                    frameUniforms.cluster_far  = camera->params.far_plane;
+                    frameUniforms.cluster_log_depth
+                      = (camera->params.camera_type == SG_CameraType_PERPSECTIVE)
+                        && camera->params.near_plane > 0.0f;
+
+                    // camera the hi-z pyramid built this frame is seen from
+                    pass->hiz_projection_view
+                      = frameUniforms.projection * frameUniforms.view;
                 } else {
                     FrameUniforms_ZeroCameraFields(&frameUniforms);
                 }
@@ -1205,6 +1293,15 @@ struct App {
                     frameUniforms.ambient_light    = scene->sg_scene_desc.ambient_light;
                     frameUniforms.num_lights       = R_Scene::numLights(scene);
                     frameUniforms.background_color = scene->sg_scene_desc.bg_color;
+
+                    // drop lights whose range can't reach this camera's view
+                    frameUniforms.num_active_lights
+                      = camera ? R_Scene::cullLights(
+                                   &app->gctx, scene,
+                                   frameUniforms.projection * frameUniforms.view,
+                                   &pass->active_light_buffer) :
+                                 0;
+                    R_Scene::sendLightStats(scene);
                 } else {
                     FrameUniforms_ZeroLightingFields(&frameUniforms);
                 }
@@ -1246,6 +1343,9 @@ struct App {
         }
 
         GraphicsContext::presentFrame(&app->gctx);
+
+        // buffers can only be mapped once the copies into them are submitted
+        _R_MapCullStats(app);
     }
 
     static void _calculateFPS(GLFWwindow* window, bool print_to_title)
@@ -1397,13 +1497,239 @@ struct SceneDrawCall {
     SG_ID geo_id;
 };
 
+// adds the compute pass that frustum culls, and occlusion culls if enabled, the
+// opaque instances of a ScenePass. returns its index for _R_RenderScene()
+static int _R_AddInstanceCullPass(App* app, R_Scene* scene, R_Pass* pass)
+{
+    static char name[128]          = {};
+    static const u32 zero_stats[2] = {}; // visible, occluded
+
+    GPU_Buffer::resizeNoCopy(&app->gctx, &pass->cull_stats_buffer, sizeof(zero_stats),
+                             WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc);
+    wgpuQueueWriteBuffer(app->gctx.queue, pass->cull_stats_buffer.buf, 0, zero_stats,
+                         sizeof(zero_stats));
+    if (!pass->cull_stats_readback) {
+        WGPUBufferDescriptor desc = {};
+        desc.label                = "cull stats readback";
+        desc.usage                = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        desc.size                 = sizeof(zero_stats);
+        pass->cull_stats_readback = wgpuDeviceCreateBuffer(app->gctx.device, &desc);
+    }
+    // skip the readback while the last one is still being mapped
+    WGPUBuffer stats_readback
+      = pass->cull_stats_mapping ? NULL : pass->cull_stats_readback;
+
+    // test against last frame's pyramid, if there is one
+    OcclusionCullParams occlusion = {};
+    WGPUTexture hiz_texture       = app->gctx.sentinel_hiz_texture;
+    if (pass->sg_pass.scene_pass_occlusion_culling && pass->hiz_valid) {
+        occlusion.prev_projection_view = pass->hiz_projection_view;
+        occlusion.viewport             = pass->hiz_viewport;
+        occlusion.mip_count = wgpuTextureGetMipLevelCount(pass->hiz_texture);
+        occlusion.enabled   = 1;
+        hiz_texture         = pass->hiz_texture;
+    }
+    GPU_Buffer::resizeNoCopy(&app->gctx, &pass->occlusion_params_buffer,
+                             sizeof(occlusion), WGPUBufferUsage_Uniform);
+    wgpuQueueWriteBuffer(app->gctx.queue, pass->occlusion_params_buffer.buf, 0,
+                         &occlusion, sizeof(occlusion));
+
+    snprintf(name, sizeof(name), "InstanceCullPass[%d:%s] for Scene[%d:%s]", pass->id,
+             pass->sg_pass.name, scene->id, scene->name);
+    int pass_idx = app->rendergraph.addInstanceCullPass(
+      name, app->gctx.instance_cull_shader_module, pass->frame_uniform_buffer,
+      pass->occlusion_params_buffer.buf, pass->cull_stats_buffer.buf, hiz_texture,
+      stats_readback);
+
+    if (pass_idx >= 0 && stats_readback) {
+        pass->cull_stats_mapping                           = true;
+        *ARENA_PUSH_TYPE(&app->cull_stats_map_list, SG_ID) = pass->id;
+    }
+    return pass_idx;
+}
+
+static void _R_OnCullStatsMapped(WGPUBufferMapAsyncStatus status, void* udata)
+{
+    R_Pass* pass = Component_GetPass((SG_ID)(intptr_t)udata);
+    if (!pass) return;
+
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        const u32* stats = (const u32*)wgpuBufferGetConstMappedRange(
+          pass->cull_stats_readback, 0, 2 * sizeof(u32));
+        CQ_PushCommand_G2A_ScenePassCullStats(pass->id, stats[0], stats[1]);
+        wgpuBufferUnmap(pass->cull_stats_readback);
+    }
+    pass->cull_stats_mapping = false;
+}
+
+// maps the cull stats copied this frame, see _R_AddInstanceCullPass()
+static void _R_MapCullStats(App* app)
+{
+    for (int i = 0; i < ARENA_LENGTH(&app->cull_stats_map_list, SG_ID); ++i) {
+        SG_ID pass_id = *ARENA_GET_TYPE(&app->cull_stats_map_list, SG_ID, i);
+        R_Pass* pass  = Component_GetPass(pass_id);
+        if (!pass) continue;
+        wgpuBufferMapAsync(pass->cull_stats_readback, WGPUMapMode_Read, 0,
+                           2 * sizeof(u32), _R_OnCullStatsMapped,
+                           (void*)(intptr_t)pass_id);
+    }
+    Arena::clear(&app->cull_stats_map_list);
+}
+
+// camera state for picking mesh LODs, see _R_LODScreenSize()
+struct R_LODView {
+    glm::mat4 view;
+    f32 projection_scale; // projection[1][1], independent of aspect
+    f32 near_plane;
+    bool perspective;
+};
+
+// fraction of the viewport height covered by an instance's bounding sphere
+static f32 _R_LODScreenSize(R_LODView* lod_view, glm::vec4 bounding_sphere,
+                            glm::mat4 model)
+{
+    glm::vec3 center = model * glm::vec4(glm::vec3(bounding_sphere), 1.0f);
+    f32 scale2       = MAX(MAX(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                               glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))),
+                           glm::dot(glm::vec3(model[2]), glm::vec3(model[2])));
+    f32 radius       = bounding_sphere.w * sqrtf(scale2);
+    f32 size         = radius * lod_view->projection_scale;
+    if (!lod_view->perspective) return size;
+
+    f32 depth = -(lod_view->view * glm::vec4(center, 1.0f)).z;
+    // camera is inside or right next to the mesh
+    if (depth <= MAX(radius, lod_view->near_plane)) return FLT_MAX;
+    return size / depth;
+}
+
+// counting sort of a primitive's instances by LOD level. The DrawUniforms of
+// each level are copied to the staging memory at lod_offset, every group aligned
+// for binding. Returns the offset past the last group
+static u64 _R_GroupInstancesByLOD(App* app, GeometryToXforms* primitive,
+                                  R_Geometry* geo, R_LODView* lod_view,
+                                  u64 staging_offset, u64 lod_offset,
+                                  u32* group_size, u64* group_offset)
+{
+    int instance_count = GeometryToXforms::count(primitive);
+    u32 align          = app->gctx.limits.minStorageBufferOffsetAlignment;
+
+    u8* levels = ARENA_PUSH_COUNT(&app->frameArena, u8, instance_count);
+    for (int i = 0; i < instance_count; ++i) {
+        DrawUniforms* draw_uniforms = GeometryToXforms::drawUniform(primitive, i);
+        f32 screen_size
+          = _R_LODScreenSize(lod_view, geo->bounding_sphere, draw_uniforms->model);
+        levels[i] = (u8)R_Geometry::selectLOD(geo, screen_size);
+        ++group_size[levels[i]];
+    }
+
+    u32 cursor[CHUGL_GEOMETRY_MAX_LODS] = {};
+    for (int level = 0; level < geo->lod_count; ++level) {
+        group_offset[level] = lod_offset;
+        lod_offset += NEXT_MULT(group_size[level] * sizeof(DrawUniforms), align);
+    }
+
+    u8* staging = (u8*)Arena::get(&app->frameArena, staging_offset);
+    for (int i = 0; i < instance_count; ++i) {
+        u8 level   = levels[i];
+        u64 offset = group_offset[level] + cursor[level]++ * sizeof(DrawUniforms);
+        memcpy(staging + offset, GeometryToXforms::drawUniform(primitive, i),
+               sizeof(DrawUniforms));
+    }
+
+    ARENA_POP_COUNT(&app->frameArena, u8, instance_count);
+    return lod_offset;
+}
+
+// draw only the index range of one LOD level
+static void _R_DrawLOD(G_DrawCall* d, R_Geometry* geo, int level)
+{
+    d->index_count         = geo->lod_index_count[level];
+    d->index_buffer_offset = geo->lod_index_offset[level] * sizeof(u32);
+    d->index_buffer_size   = geo->lod_index_count[level] * sizeof(u32);
+}
+
 // move this into R_Scene, call build drawcall struct?
+// if instance_cull_pass >= 0, opaque draws are frustum culled by that pass and
+// drawn indirectly
 static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* camera,
-                           G_DrawCallListID dc_list)
+                           G_DrawCallListID dc_list, int instance_cull_pass)
 {
-    // form draw call list and sort
     size_t hashmap_idx_DONT_USE = 0;
     GeometryToXforms* primitive = NULL;
+
+    // gpu culling: each opaque draw gets InstanceCullParams, 5 u32 of indirect args
+    // and a region of the visible DrawUniforms buffer. sized up front so the
+    // buffers aren't recreated after being bound
+    const u32 draw_args_stride = 5 * sizeof(u32);
+    u32 cull_params_stride     = NEXT_MULT(
+      sizeof(InstanceCullParams), app->gctx.limits.minUniformBufferOffsetAlignment);
+    u32 visible_align          = app->gctx.limits.minStorageBufferOffsetAlignment;
+    u32 cull_draw_count        = 0;
+    u64 cull_params_offset     = 0; // into frame arena
+    u64 draw_args_offset       = 0; // into frame arena
+    u64 visible_offset         = 0; // into pass->visible_draw_buffer
+
+    // LODs: opaque instances of a primitive are grouped by level, each non-empty
+    // level is its own draw over that level's index range. The regrouped
+    // DrawUniforms are staged in the frame arena and uploaded to
+    // pass->lod_draw_buffer
+    R_LODView lod_view        = {};
+    lod_view.view             = R_Camera::viewMatrix(camera);
+    lod_view.projection_scale = R_Camera::projectionMatrix(camera, 1.0f)[1][1];
+    lod_view.near_plane       = camera->params.near_plane;
+    lod_view.perspective
+      = (camera->params.camera_type == SG_CameraType_PERPSECTIVE);
+    u64 lod_staging_offset = 0; // into frame arena
+    u64 lod_offset         = 0; // into pass->lod_draw_buffer
+
+    // one pass over the primitives to size the buffers
+    u32 opaque_draw_count = 0;
+    u64 visible_size      = 0;
+    u64 lod_size          = 0;
+    while (
+      hashmap_iter(scene->geo_to_xform, &hashmap_idx_DONT_USE, (void**)&primitive)) {
+        R_Material* material = Component_GetMaterial(primitive->key.mat_id);
+        if (material->pso.transparent) continue;
+        R_Geometry* geo = Component_GetGeometry(primitive->key.geo_id);
+        u64 size        = GeometryToXforms::count(primitive) * sizeof(DrawUniforms);
+        int draws       = 1;
+        if (R_Geometry::usesLOD(geo, material)) {
+            draws = geo->lod_count;
+            lod_size += size + draws * visible_align;
+        }
+        opaque_draw_count += draws;
+        visible_size += size + draws * visible_align;
+    }
+    hashmap_idx_DONT_USE = 0;
+
+    if (lod_size > 0) {
+        GPU_Buffer::resizeNoCopy(&app->gctx, &pass->lod_draw_buffer, lod_size,
+                                 WGPUBufferUsage_Storage);
+        lod_staging_offset = Arena::offsetOf(
+          &app->frameArena, Arena::push(&app->frameArena, lod_size));
+    }
+
+    if (instance_cull_pass >= 0) {
+        u32 draw_slots = MAX(opaque_draw_count, 1);
+        GPU_Buffer::resizeNoCopy(&app->gctx, &pass->instance_cull_params_buffer,
+                                 draw_slots * cull_params_stride,
+                                 WGPUBufferUsage_Uniform);
+        GPU_Buffer::resizeNoCopy(&app->gctx, &pass->draw_args_buffer,
+                                 draw_slots * draw_args_stride,
+                                 WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect);
+        GPU_Buffer::resizeNoCopy(&app->gctx, &pass->visible_draw_buffer,
+                                 MAX(visible_size, sizeof(DrawUniforms)),
+                                 WGPUBufferUsage_Storage);
+
+        cull_params_offset = Arena::offsetOf(
+          &app->frameArena,
+          Arena::pushZero(&app->frameArena, draw_slots * cull_params_stride));
+        draw_args_offset   = Arena::offsetOf(
+          &app->frameArena,
+          Arena::pushZero(&app->frameArena, draw_slots * draw_args_stride));
+    }
+
+    // form draw call list and sort
     while (
       hashmap_iter(scene->geo_to_xform, &hashmap_idx_DONT_USE, (void**)&primitive)) {
         int instance_count = GeometryToXforms::count(primitive);
@@ -1417,9 +1743,13 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
         SG_ID shader_id  = material->pso.sg_shader_id;
         R_Shader* shader = Component_GetShader(shader_id);
 
+        // LOD draws are copies of this one with their own index range
+        bool uses_lod = R_Geometry::usesLOD(geo, material);
+
         // add to draw call list
-        G_DrawCall* d = is_transparent ? app->rendergraph.templateDraw() :
-                                         app->rendergraph.addDraw(dc_list);
+        G_DrawCall* d = (is_transparent || uses_lod) ?
+                          app->rendergraph.templateDraw() :
+                          app->rendergraph.addDraw(dc_list);
 
         // populate index buffer
         bool indexed_draw               = (R_Geometry::indexCount(geo) > 0);
@@ -1427,16 +1757,17 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
         bool user_provided_vertex_count = (geo->vertex_count >= 0);
         if (material->pso.wireframe) {
             R_Geometry::rebuildWireframe(geo, &app->gctx);
-            // wireframe is always an indexed draw
+            // wireframe is always an indexed draw. Partial draws keep the edges
+            // of the leading triangles
             if (indexed_draw) {
                 d->index_count = user_provided_index_count ?
-                                   MIN(R_Geometry::wireframeIndicesCount(geo),
-                                       geo->indices_count * 2) :
+                                   R_Geometry::wireframeIndicesCount(
+                                     geo, geo->indices_count / 3) :
                                    R_Geometry::wireframeIndicesCount(geo);
             } else {
                 d->index_count = user_provided_vertex_count ?
-                                   MIN(R_Geometry::wireframeIndicesCount(geo),
-                                       geo->vertex_count * 2) :
+                                   R_Geometry::wireframeIndicesCount(
+                                     geo, geo->vertex_count / 3) :
                                    R_Geometry::wireframeIndicesCount(geo);
             }
             d->index_buffer        = geo->gpu_wireframe_index_buffer.buf;
@@ -1452,11 +1783,7 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
                 d->index_buffer_offset = 0;
                 d->index_buffer_size   = geo->gpu_index_buffer.size;
             } else {
-                // TODO come up with a better way to set a custom number of vertices to
-                // draw having -1 actually mean ALL is confusing 2 different states.
-                d->vertex_count = user_provided_vertex_count ?
-                                    geo->vertex_count :
-                                    R_Geometry::vertexCount(geo);
+                d->vertex_count = R_Geometry::drawVertexCount(geo);
             }
         }
 
@@ -1468,7 +1795,8 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
 
         { // set bindgroups
             // set frame uniforms
-            R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
+            R_BindFrameUniforms(pass->frame_uniform_buffer,
+                                pass->light_cluster_buffer.buf, &app->gctx, d,
                                 &app->rendergraph, shader, scene);
 
             // set material uniforms
@@ -1511,6 +1839,12 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
 
                 DrawUniforms* draw_uniforms
                   = GeometryToXforms::drawUniform(primitive, instance_idx);
+                if (uses_lod) {
+                    f32 screen_size = _R_LODScreenSize(
+                      &lod_view, geo->bounding_sphere, draw_uniforms->model);
+                    _R_DrawLOD(td, geo, R_Geometry::selectLOD(geo, screen_size));
+                }
+
                 glm::vec3 world_pos    = glm::vec3(draw_uniforms->model[3]);
                 float dist_from_camera = 0.0;
                 switch (camera->params.camera_type) {
@@ -1539,19 +1873,103 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
                   instance_idx * primitive->push_size, sizeof(DrawUniforms));
             }
         } else {
-            d->instance_count = instance_count;
-            float dist_from_camera
-              = 0.0; // ==optimize== sort opaque geometry front-to-back
-            d->sort_key = G_SortKey::create(false, G_RenderingLayer_World, material->id,
-                                            dist_from_camera, camera->params.far_plane);
-
-            // set @group(3) per-draw bindings (xform matrices)
-            app->rendergraph.bindBuffer(d, PER_DRAW_GROUP, 0,
-                                        primitive->xform_storage_buffer.buf, 0,
-                                        primitive->xform_storage_buffer.size);
+            // opaque draws are instanced, one draw per LOD level in use
+            int group_count                           = 1;
+            u32 group_size[CHUGL_GEOMETRY_MAX_LODS]   = {};
+            u64 group_offset[CHUGL_GEOMETRY_MAX_LODS] = {};
+            WGPUBuffer instance_buffer = primitive->xform_storage_buffer.buf;
+            u64 instance_size          = primitive->xform_storage_buffer.size;
+            if (uses_lod) {
+                group_count     = geo->lod_count;
+                instance_buffer = pass->lod_draw_buffer.buf;
+                lod_offset      = _R_GroupInstancesByLOD(app, primitive, geo, &lod_view,
+                                                         lod_staging_offset, lod_offset,
+                                                         group_size, group_offset);
+            } else {
+                group_size[0] = instance_count;
+            }
+
+            for (int group = 0; group < group_count; ++group) {
+                if (group_size[group] == 0) continue;
+                G_DrawCall* gd = d;
+                if (uses_lod) {
+                    gd = app->rendergraph.addTemplatedDraw(dc_list);
+                    gd->bg_list[PER_DRAW_GROUP].start
+                      = ARENA_LENGTH(app->rendergraph.bind_group_entry_list
+                                       + PER_DRAW_GROUP,
+                                     G_CacheBindGroupEntry);
+                    _R_DrawLOD(gd, geo, group);
+                    instance_size = group_size[group] * sizeof(DrawUniforms);
+                }
+
+                float dist_from_camera
+                  = 0.0; // ==optimize== sort opaque geometry front-to-back
+                gd->sort_key
+                  = G_SortKey::create(false, G_RenderingLayer_World, material->id,
+                                      dist_from_camera, camera->params.far_plane);
+
+                if (instance_cull_pass >= 0) {
+                    // the cull pass counts visible instances into the args, starting
+                    // from 0
+                    u32 draw_idx = cull_draw_count++;
+                    u32* draw_args
+                      = (u32*)Arena::get(&app->frameArena, draw_args_offset)
+                        + draw_idx * 5;
+                    draw_args[0]
+                      = gd->index_buffer ?
+                          MIN(gd->index_count, gd->index_buffer_size / sizeof(u32)) :
+                          gd->vertex_count;
+                    gd->indirect_buffer = pass->draw_args_buffer.buf;
+                    gd->indirect_offset = draw_idx * draw_args_stride;
+
+                    InstanceCullParams* params
+                      = (InstanceCullParams*)((u8*)Arena::get(&app->frameArena,
+                                                              cull_params_offset)
+                                              + draw_idx * cull_params_stride);
+                    params->bounding_sphere = geo->bounding_sphere;
+                    params->instance_count  = group_size[group];
+                    params->draw_args_idx   = draw_idx * 5;
+
+                    u32 visible_size = group_size[group] * sizeof(DrawUniforms);
+                    app->rendergraph.instanceCullDispatch(
+                      instance_cull_pass, group_size[group],
+                      pass->instance_cull_params_buffer.buf,
+                      draw_idx * cull_params_stride, instance_buffer,
+                      group_offset[group], instance_size, pass->visible_draw_buffer.buf,
+                      visible_offset, visible_size, pass->draw_args_buffer.buf,
+                      pass->draw_args_buffer.size);
+
+                    // visible instances are the @group(2) (PER_DRAW_GROUP) draws
+                    app->rendergraph.bindBuffer(gd, PER_DRAW_GROUP, 0,
+                                                pass->visible_draw_buffer.buf,
+                                                visible_offset, visible_size);
+                    visible_offset += NEXT_MULT(visible_size, visible_align);
+                } else {
+                    gd->instance_count = group_size[group];
+
+                    // set @group(3) per-draw bindings (xform matrices)
+                    app->rendergraph.bindBuffer(gd, PER_DRAW_GROUP, 0, instance_buffer,
+                                                group_offset[group], instance_size);
+                }
+            }
         }
     }
 
+    if (lod_offset > 0) {
+        wgpuQueueWriteBuffer(app->gctx.queue, pass->lod_draw_buffer.buf, 0,
+                             Arena::get(&app->frameArena, lod_staging_offset),
+                             lod_offset);
+    }
+
+    if (cull_draw_count > 0) {
+        wgpuQueueWriteBuffer(app->gctx.queue, pass->instance_cull_params_buffer.buf, 0,
+                             Arena::get(&app->frameArena, cull_params_offset),
+                             cull_draw_count * cull_params_stride);
+        wgpuQueueWriteBuffer(app->gctx.queue, pass->draw_args_buffer.buf, 0,
+                             Arena::get(&app->frameArena, draw_args_offset),
+                             cull_draw_count * draw_args_stride);
+    }
+
     { // skybox pass
         R_Material* skybox_material
           = Component_GetMaterial(scene->sg_scene_desc.skybox_material_id);
@@ -1571,8 +1989,8 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
 
         R_Shader* skybox_shader
           = Component_GetShader(skybox_material->pso.sg_shader_id);
-        R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
-                            &app->rendergraph, skybox_shader, scene);
+        R_BindFrameUniforms(pass->frame_uniform_buffer, pass->light_cluster_buffer.buf,
+                            &app->gctx, d, &app->rendergraph, skybox_shader, scene);
         R_Material::createBindGroupEntries(skybox_material, PER_MATERIAL_GROUP,
                                            &app->rendergraph, d, &app->gctx);
     }
@@ -1933,6 +2351,10 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_b2World_Set* cmd = (SG_Command_b2World_Set*)command;
             app->b2_sim_desc            = cmd->desc;
         } break;
+        case SG_COMMAND_b2_BODY_BIND: {
+            SG_Command_b2Body_Bind* cmd = (SG_Command_b2Body_Bind*)command;
+            Physics_BindTransform(cmd->sg_id, *(b2BodyId*)&cmd->body_id);
+        } break;
         // component --------------
         case SG_COMMAND_COMPONENT_UPDATE_NAME: {
             SG_Command_ComponentUpdateName* cmd
@@ -1973,7 +2395,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             }
         } break;
         case SG_COMMAND_COMPONENT_FREE: {
-            Component_FreeComponent(((SG_Command_ComponentFree*)command)->id);
+            SG_ID id          = ((SG_Command_ComponentFree*)command)->id;
+            R_Component* comp = Component_GetComponent(id);
+            if (comp && comp->type == SG_COMPONENT_SHADER) {
+                // evict pipelines built from this shader before its modules are
+                // released
+                R_Shader* shader = (R_Shader*)comp;
+                app->rendergraph.cache.releaseShaderPipelines(
+                  shader->id, shader->compute_shader_module);
+            }
+            Component_FreeComponent(id);
         } break;
         case SG_COMMAND_CREATE_XFORM:
             Component_CreateTransform((SG_Command_CreateXform*)command);
@@ -2028,6 +2459,7 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_MaterialUpdatePSO* cmd = (SG_Command_MaterialUpdatePSO*)command;
             R_Material* material              = Component_GetMaterial(cmd->sg_id);
             material->pso                     = cmd->pso;
+            ++material->version;
         } break;
         case SG_COMMAND_MATERIAL_SET_UNIFORM: {
             SG_Command_MaterialSetUniform* cmd
@@ -2110,14 +2542,17 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         // text
         case SG_COMMAND_TEXT_REBUILD: {
             SG_Command_TextRebuild* cmd = (SG_Command_TextRebuild*)command;
-            Component_CreateText(&app->gctx, app->FTLibrary, cmd, app->default_font);
+            Component_CreateText(&app->gctx, cmd, app->default_font);
         } break;
         case SG_COMMAND_TEXT_DEFAULT_FONT: {
             SG_Command_TextDefaultFont* cmd = (SG_Command_TextDefaultFont*)command;
             R_Font* default_font            = Component_GetFont(
-              &app->gctx, app->FTLibrary,
-              (char*)CQ_ReadCommandGetOffset(cmd->font_path_str_offset));
-            if (default_font) app->default_font = default_font;
+              &app->gctx, (char*)CQ_ReadCommandGetOffset(cmd->font_path_str_offset));
+            if (default_font && default_font != app->default_font) {
+                Component_FontAcquire(default_font);
+                Component_FontRelease(app->default_font);
+                app->default_font = default_font;
+            }
         } break;
         // pass
         case SG_COMMAND_PASS_CREATE: {
@@ -2172,12 +2607,14 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               = (SG_Command_GeometrySetVertexCount*)command;
             R_Geometry* geo   = Component_GetGeometry(cmd->sg_id);
             geo->vertex_count = cmd->count;
+            ++geo->version;
         } break;
         case SG_COMMAND_GEO_SET_INDICES_COUNT: {
             SG_Command_GeometrySetIndicesCount* cmd
               = (SG_Command_GeometrySetIndicesCount*)command;
             R_Geometry* geo    = Component_GetGeometry(cmd->sg_id);
             geo->indices_count = cmd->count;
+            ++geo->version;
         } break;
         case SG_COMMAND_GEO_SET_INDICES: {
             SG_Command_GeoSetIndices* cmd = (SG_Command_GeoSetIndices*)command;
@@ -2187,6 +2624,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
 
             R_Geometry::setIndices(&app->gctx, geo, indices, cmd->index_count);
         } break;
+        case SG_COMMAND_GEO_SET_LOD: {
+            SG_Command_GeometrySetLOD* cmd = (SG_Command_GeometrySetLOD*)command;
+            R_Geometry::setLOD(Component_GetGeometry(cmd->sg_id), cmd->levels,
+                               cmd->thresholds, cmd->force);
+        } break;
+        case SG_COMMAND_GEO_SET_SHARED: {
+            SG_Command_GeometrySetShared* cmd = (SG_Command_GeometrySetShared*)command;
+            R_Geometry::setShared(Component_GetGeometry(cmd->sg_id),
+                                  cmd->shared_geo_id);
+        } break;
 
         // textures ---------------------
         case SG_COMMAND_TEXTURE_CREATE: {
@@ -2198,6 +2645,11 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_TextureWrite* cmd = (SG_Command_TextureWrite*)command;
             R_Texture* texture           = Component_GetTexture(cmd->sg_id);
             void* data                   = CQ_ReadCommandGetOffset(cmd->data_offset);
+            R_Texture::finishAsyncLoad(&app->gctx, texture);
+            if (G_isCompressedFormat(texture->desc.format)) {
+                log_warn("cannot write to compressed texture '%s'", texture->name);
+                break;
+            }
             R_Texture::write(&app->gctx, texture, &cmd->write_desc, data,
                              cmd->data_size_bytes);
         } break;
@@ -2206,16 +2658,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             R_Texture* texture              = Component_GetTexture(cmd->sg_id);
             const char* path
               = (const char*)CQ_ReadCommandGetOffset(cmd->filepath_offset);
-            R_Texture::load(&app->gctx, texture, path, cmd->flip_vertically,
-                            cmd->gen_mips);
+            R_Texture::loadAsync(&app->gctx, texture, path, cmd->flip_vertically,
+                                 cmd->gen_mips, cmd->compress);
         } break;
         case SG_COMMAND_TEXTURE_FROM_RAW_DATA: {
             SG_Command_TextureFromRawData* cmd
               = (SG_Command_TextureFromRawData*)command;
             R_Texture* texture = Component_GetTexture(cmd->sg_id);
             u8* buffer         = (u8*)CQ_ReadCommandGetOffset(cmd->buffer_offset);
-            R_Texture::load(&app->gctx, texture, buffer, cmd->buffer_len,
-                            cmd->flip_vertically, cmd->gen_mips);
+            R_Texture::loadAsync(&app->gctx, texture, buffer, cmd->buffer_len,
+                                 cmd->flip_vertically, cmd->gen_mips, cmd->compress);
         } break;
         case SG_COMMAND_CUBEMAP_TEXTURE_FROM_FILE: {
             SG_Command_CubemapTextureFromFile* cmd
@@ -2233,9 +2685,9 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               = (const char*)CQ_ReadCommandGetOffset(cmd->back_face_offset);
             const char* front_path
               = (const char*)CQ_ReadCommandGetOffset(cmd->front_face_offset);
-            R_Texture::loadCubemap(&app->gctx, texture, right_path, left_path, top_path,
-                                   bottom_path, back_path, front_path,
-                                   cmd->flip_vertically);
+            R_Texture::loadCubemapAsync(&app->gctx, texture, right_path, left_path,
+                                        top_path, bottom_path, back_path, front_path,
+                                        cmd->flip_vertically);
         } break;
         case SG_COMMAND_COPY_TEXTURE_TO_TEXTURE: {
             SG_Command_CopyTextureToTexture* cmd
@@ -2243,6 +2695,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
 
             R_Texture* src_texture   = Component_GetTexture(cmd->src_texture_id);
             R_Texture* dst_texture   = Component_GetTexture(cmd->dst_texture_id);
+            R_Texture::finishAsyncLoad(&app->gctx, src_texture);
+            R_Texture::finishAsyncLoad(&app->gctx, dst_texture);
+            if (src_texture->desc.format != dst_texture->desc.format
+                && (G_isCompressedFormat(src_texture->desc.format)
+                    || G_isCompressedFormat(dst_texture->desc.format))) {
+                log_warn("cannot copy between compressed texture '%s' and '%s' of a "
+                         "different format",
+                         src_texture->name, dst_texture->name);
+                break;
+            }
             WGPUImageCopyTexture src = SG_TextureLocation::wgpuImageCopyTexture(
               cmd->src_location, src_texture->gpu_texture);
             WGPUImageCopyTexture dst = SG_TextureLocation::wgpuImageCopyTexture(
@@ -2266,10 +2728,28 @@ static void _R_HandleCommand(App* app, SG_Command* command)
 
             WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
         } break;
+        case SG_COMMAND_TEXTURE_EQUIRECT_TO_CUBEMAP: {
+            SG_Command_TextureEquirectToCubemap* cmd
+              = (SG_Command_TextureEquirectToCubemap*)command;
+            R_Texture* equirect = Component_GetTexture(cmd->equirect_id);
+            R_Texture* cubemap  = Component_GetTexture(cmd->cubemap_id);
+            // source is usually an hdr still being decoded
+            R_Texture::finishAsyncLoad(&app->gctx, equirect);
+            R_Texture::finishAsyncLoad(&app->gctx, cubemap);
+            EquirectToCubemap_convert(&app->gctx, equirect->gpu_texture,
+                                      cubemap->gpu_texture);
+        } break;
         case SG_COMMAND_COPY_TEXTURE_TO_CPU: {
             SG_Command_CopyTextureToCPU* cmd = (SG_Command_CopyTextureToCPU*)command;
             R_Texture* tex                   = Component_GetTexture(cmd->id);
-            WGPUBuffer mapped_buffer         = R_Texture::read(&app->gctx, tex);
+            R_Texture::finishAsyncLoad(&app->gctx, tex);
+            if (G_isCompressedFormat(tex->desc.format)) {
+                log_warn("cannot read compressed texture '%s'", tex->name);
+                CQ_PushCommand_G2A_TextureRead(tex->id, NULL, 0,
+                                               WGPUBufferMapAsyncStatus_ValidationError);
+                break;
+            }
+            WGPUBuffer mapped_buffer = R_Texture::read(&app->gctx, tex);
 
             { // map buffer
                 auto onBufferMapped = [](WGPUBufferMapAsyncStatus status, void* udata) {
@@ -2324,7 +2804,13 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_SAVE_TEXTURE: {
             SG_Command_SaveTexture* cmd = (SG_Command_SaveTexture*)command;
             R_Texture* tex              = Component_GetTexture(cmd->id);
-            WGPUBuffer mapped_buffer    = R_Texture::read(&app->gctx, tex);
+            R_Texture::finishAsyncLoad(&app->gctx, tex);
+            if (G_isCompressedFormat(tex->desc.format)) {
+                log_warn("cannot save compressed texture '%s'", tex->name);
+                CQ_PushCommand_G2A_TextureSave(cmd->save_event, 1);
+                break;
+            }
+            WGPUBuffer mapped_buffer = R_Texture::read(&app->gctx, tex);
 
             { // map buffer
                 int index                = 0;
@@ -2372,7 +2858,8 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             if (!light)
                 light = Component_CreateLight(cmd->light_id, &cmd->desc,
                                               app->gctx.device, &app->gctx.limits);
-            light->desc = cmd->desc; // copy light properties
+            light->desc                 = cmd->desc; // copy light properties
+            light->light_uniforms_stale = true;
         } break;
         case SG_COMMAND_SHADOW_ADD_MESH: {
             SG_Command_ShadowAddMesh* cmd = (SG_Command_ShadowAddMesh*)command;
@@ -2402,16 +2889,14 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_VIDEO_SEEK: {
             SG_Command_VideoSeek* cmd = (SG_Command_VideoSeek*)command;
             R_Video* video            = Component_GetVideo(cmd->video_id);
-            if (video && video->plm) {
-                plm_seek(video->plm, cmd->time_secs, false);
-            }
+            if (video) R_Video::seek(video, cmd->time_secs);
         } break;
         case SG_COMMAND_VIDEO_RATE: {
             SG_Command_VideoRate* cmd = (SG_Command_VideoRate*)command;
             R_Video* video            = Component_GetVideo(cmd->video_id);
-            if (video && video->plm) {
-                video->rate = cmd->rate;
-                plm_set_loop(video->plm, cmd->loop);
+            if (video) {
+                R_Video::setRate(video, cmd->rate);
+                R_Video::setLoop(video, cmd->loop);
             }
         } break;
         case SG_COMMAND_WEBCAM_CREATE: {
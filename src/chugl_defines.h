@@ -3,7 +3,7 @@
 // ChuGL version string
 #define CHUGL_VERSION_STRING "0.2.8 (alpha)"
 
-#define CHUGL_RENDERGRAPH_MAX_PASSES 32
+#define CHUGL_RENDERGRAPH_MAX_PASSES 128 // shadow maps take up to 13 passes per light
 #define CHUGL_MATERIAL_MAX_BINDINGS 32 // @group(1) @binding(0 - 31)
 #define CHUGL_MAX_BINDGROUPS 4
 
@@ -13,12 +13,35 @@
 #define CHUGL_CACHE_TEXTURE_VIEW_FRAMES_TILL_EXPIRED 30
 
 #define CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS 4 // @group(4) storage buffers
+#define CHUGL_GEOMETRY_MAX_LODS 6 // level 0 plus up to 5 simplified levels
 
 #define CHUGL_COMPUTE_ENTRY_POINT "main"
 
+// clustered lighting
+// lit builtin shaders look up lights in a per-camera froxel grid (X*Y screen tiles,
+// Z depth slices). must match the constants in the LIGHT_CLUSTER_PARAMS shader include
+#define CHUGL_LIGHT_CLUSTER_X 16
+#define CHUGL_LIGHT_CLUSTER_Y 9
+#define CHUGL_LIGHT_CLUSTER_Z 24
+#define CHUGL_LIGHT_CLUSTER_MAX_LIGHTS 63 // lights past this per cluster are dropped
+// each cluster is a u32 light count followed by CHUGL_LIGHT_CLUSTER_MAX_LIGHTS indices
+#define CHUGL_LIGHT_CLUSTER_BUFFER_SIZE                                                \
+    (CHUGL_LIGHT_CLUSTER_X * CHUGL_LIGHT_CLUSTER_Y * CHUGL_LIGHT_CLUSTER_Z             \
+     * (CHUGL_LIGHT_CLUSTER_MAX_LIGHTS + 1) * sizeof(u32))
+
 // shadow stuff
 #define CHUGL_SPOT_SHADOWMAP_DEFAULT_DIM 512
 #define CHUGL_DIR_SHADOWMAP_DEFAULT_DIM 1024
+#define CHUGL_POINT_SHADOWMAP_DEFAULT_DIM 512
+#define CHUGL_POINT_SHADOW_NEAR .1f // must match POINT_SHADOW_NEAR in the phong shader
+#define CHUGL_MAX_SHADOW_CASCADES 4 // must match LightUniforms.cascades
+#define CHUGL_SHADOW_MAX_VIEWS 6    // point lights render one view per cube face
+// shadow casters that haven't moved for this many frames are cached in a light's
+// static shadow layer, the rest are re-rendered on top of it every frame they move
+#define CHUGL_SHADOW_STATIC_FRAMES 60
+// render graph passes left free for the scene passes after the shadow passes. a
+// light whose shadow passes don't fit is skipped for the frame
+#define CHUGL_SHADOW_PASS_RESERVE 16
 
 // from E. Lengyel Foundations of Game Engine Development Volume II pg. 191
 #define CHUGL_SHADOW_MAP_DEPTH_OFFSET                                                  \
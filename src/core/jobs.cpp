@@ -0,0 +1,160 @@
+#include "core/jobs.h"
+#include "core/log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define JOBS_MAX_WORKERS 64
+
+struct Jobs_Job {
+    Jobs_Fn fn;
+    void* udata;
+    Jobs_Counter* counter;
+};
+
+struct Jobs_State {
+    std::mutex lock; // guards everything below
+    std::condition_variable cv;
+    std::deque<Jobs_Job> queue;
+    std::vector<std::thread> workers;
+    bool shutdown;
+};
+
+// intentionally leaked: if the host exits without calling Jobs_Shutdown(),
+// destroying joinable std::threads from a static destructor would terminate()
+static Jobs_State& jobs = *(new Jobs_State());
+
+static void Jobs_Run(Jobs_Job job)
+{
+    job.fn(job.udata);
+    if (job.counter) job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+static void Jobs_WorkerMain()
+{
+    for (;;) {
+        Jobs_Job job = {};
+        {
+            std::unique_lock<std::mutex> lock(jobs.lock);
+            jobs.cv.wait(lock, [] { return jobs.shutdown || !jobs.queue.empty(); });
+            // drain the queue before exiting
+            if (jobs.queue.empty()) return;
+            job = jobs.queue.front();
+            jobs.queue.pop_front();
+        }
+        Jobs_Run(job);
+    }
+}
+
+static void Jobs_InitLocked(int num_workers)
+{
+    if (!jobs.workers.empty()) return;
+
+    if (num_workers <= 0) {
+        num_workers = (int)std::thread::hardware_concurrency() - 1;
+    }
+    num_workers = num_workers < 1 ? 1 : num_workers;
+    num_workers = num_workers > JOBS_MAX_WORKERS ? JOBS_MAX_WORKERS : num_workers;
+
+    jobs.shutdown = false;
+    for (int i = 0; i < num_workers; i++) jobs.workers.emplace_back(Jobs_WorkerMain);
+
+    log_debug("started %d job worker threads", num_workers);
+}
+
+void Jobs_Init(int num_workers)
+{
+    std::lock_guard<std::mutex> lock(jobs.lock);
+    Jobs_InitLocked(num_workers);
+}
+
+void Jobs_Shutdown()
+{
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(jobs.lock);
+        jobs.shutdown = true;
+        workers.swap(jobs.workers);
+    }
+    jobs.cv.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+int Jobs_WorkerCount()
+{
+    std::lock_guard<std::mutex> lock(jobs.lock);
+    return (int)jobs.workers.size();
+}
+
+void Jobs_Submit(Jobs_Fn fn, void* udata, Jobs_Counter* counter)
+{
+    ASSERT(fn);
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(jobs.lock);
+        if (jobs.workers.empty()) Jobs_InitLocked(0);
+        jobs.queue.push_back({ fn, udata, counter });
+    }
+    jobs.cv.notify_one();
+}
+
+bool Jobs_Done(Jobs_Counter* counter)
+{
+    return counter->pending.load(std::memory_order_acquire) == 0;
+}
+
+bool Jobs_RunOne()
+{
+    Jobs_Job job = {};
+    {
+        std::lock_guard<std::mutex> lock(jobs.lock);
+        if (jobs.queue.empty()) return false;
+        job = jobs.queue.front();
+        jobs.queue.pop_front();
+    }
+    Jobs_Run(job);
+    return true;
+}
+
+void Jobs_Wait(Jobs_Counter* counter)
+{
+    while (!Jobs_Done(counter)) {
+        // help out rather than block. Any queued job will do, the counter only
+        // tells us when to stop.
+        if (!Jobs_RunOne()) {
+            // remaining jobs are in flight on the workers
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Jobs_WaitOwn(Jobs_Counter* counter)
+{
+    while (!Jobs_Done(counter)) {
+        Jobs_Job job = {};
+        {
+            std::lock_guard<std::mutex> lock(jobs.lock);
+            auto it = std::find_if(jobs.queue.begin(), jobs.queue.end(),
+                                   [counter](const Jobs_Job& queued) {
+                                       return queued.counter == counter;
+                                   });
+            if (it != jobs.queue.end()) {
+                job = *it;
+                jobs.queue.erase(it);
+            }
+        }
+
+        if (job.fn) {
+            Jobs_Run(job);
+        } else {
+            // remaining jobs are in flight on the workers
+            std::this_thread::yield();
+        }
+    }
+}
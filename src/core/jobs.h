@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core/macros.h"
+
+#include <atomic>
+
+// ============================================================================
+// Jobs
+// ============================================================================
+// Shared pool of worker threads for CPU-heavy background work (image decoding,
+// geometry generation, physics tasks...). Everything in ChuGL that wants to
+// get work off the render or audio thread should go through here rather than
+// spinning up its own threads.
+//
+// Jobs are a plain function pointer + user data. Completion can be tracked by
+// passing a Jobs_Counter to Jobs_Submit(), which is decremented after the job
+// runs. Jobs that need to hand results back to a specific thread should push
+// them onto their own completion queue (see R_Texture async loading)
+
+typedef void (*Jobs_Fn)(void* udata);
+
+struct Jobs_Counter {
+    std::atomic<i32> pending = { 0 };
+};
+
+// num_workers <= 0 picks (hardware threads - 1), minimum 1.
+// Safe to call multiple times, only the first call creates the workers.
+void Jobs_Init(int num_workers = 0);
+
+// runs all queued jobs to completion and joins the workers
+void Jobs_Shutdown();
+
+// number of worker threads, 0 if the pool hasn't been initialized
+int Jobs_WorkerCount();
+
+// thread-safe. Lazily initializes the pool with the default worker count.
+void Jobs_Submit(Jobs_Fn fn, void* udata, Jobs_Counter* counter = NULL);
+
+bool Jobs_Done(Jobs_Counter* counter);
+
+// runs one queued job on the calling thread. Returns false if the queue was
+// empty. For callers that wait on something other than a Jobs_Counter.
+bool Jobs_RunOne();
+
+// blocks until all jobs tracked by counter have finished. The calling thread
+// helps by running queued jobs while it waits.
+void Jobs_Wait(Jobs_Counter* counter);
+
+// like Jobs_Wait(), but only helps with jobs tracked by counter. For callers
+// that can't afford to pick up unrelated work (e.g. the audio thread)
+void Jobs_WaitOwn(Jobs_Counter* counter);
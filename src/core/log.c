@@ -22,8 +22,123 @@
 
 #include "log.h"
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tinycthread/tinycthread.h>
+
 #define MAX_CALLBACKS 32
 
+// async ring buffer
+#define LOG_RING_CAPACITY 1024 // must be power of 2
+#define LOG_MAX_ARGS 12
+#define LOG_RECORD_STRINGS_SIZE 256 // inline storage for %s args
+#define LOG_MSG_SIZE 1024
+#define LOG_WRITER_SLEEP_NS 5000000 // 5ms poll interval when ring is empty
+#define LOG_WRITER_BATCH_SIZE 64
+#define LOG_DEFAULT_RATE_LIMIT 20
+
+// ============================================================================
+// atomics (log.c is compiled as C, so no std::atomic)
+// all atomic fields are 32-bit ints
+// ============================================================================
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define log_atomic_load(p) ((unsigned int)_InterlockedOr((volatile long*)(p), 0))
+#define log_atomic_store(p, v) _InterlockedExchange((volatile long*)(p), (long)(v))
+#define log_atomic_add(p, v)                                                           \
+    ((unsigned int)_InterlockedExchangeAdd((volatile long*)(p), (long)(v)))
+#define log_atomic_exchange(p, v)                                                      \
+    ((unsigned int)_InterlockedExchange((volatile long*)(p), (long)(v)))
+#define log_atomic_cas(p, expected, desired)                                           \
+    (_InterlockedCompareExchange((volatile long*)(p), (long)(desired),                 \
+                                 (long)(expected))                                     \
+     == (long)(expected))
+#else
+#define log_atomic_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define log_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define log_atomic_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define log_atomic_exchange(p, v) __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define log_atomic_cas(p, expected, desired)                                           \
+    log_atomic_cas_impl((volatile unsigned int*)(p), (expected), (desired))
+
+static bool log_atomic_cas_impl(volatile unsigned int* p, unsigned int expected,
+                                unsigned int desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+// ============================================================================
+// records
+// Format args are captured by value at the callsite (strings are copied
+// inline) and formatted later by whichever thread drains the ring.
+// Format strings must be string literals (true for all log_*() macros).
+// ============================================================================
+
+enum {
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_INTMAX,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR, // value is offset into record strings
+};
+
+typedef union {
+    int i;
+    long l;
+    long long ll;
+    size_t z;
+    intmax_t j;
+    ptrdiff_t t;
+    double d;
+    long double ld;
+    const void* p;
+    unsigned int str;
+} log_Arg;
+
+typedef struct {
+    const char* fmt;
+    const char* file;
+    int line;
+    int level;
+    int subsystem;
+    time_t time;
+    unsigned int suppressed; // rate-limited repeats of this callsite
+    unsigned char nargs;
+    unsigned char truncated; // more args than LOG_MAX_ARGS
+    unsigned short strings_used;
+    unsigned char arg_types[LOG_MAX_ARGS];
+    log_Arg args[LOG_MAX_ARGS];
+    char strings[LOG_RECORD_STRINGS_SIZE];
+} log_Record;
+
+typedef struct {
+    volatile unsigned int sequence;
+    log_Record record;
+} log_Cell;
+
+// bounded MPSC queue, after Dmitry Vyukov's bounded MPMC queue
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// Producers never block: if the ring is full the record is dropped and counted.
+// Only the thread holding `L.consumer` may dequeue.
+static struct {
+    log_Cell cells[LOG_RING_CAPACITY];
+    volatile unsigned int enqueue_pos;
+    unsigned int dequeue_pos;
+    volatile unsigned int dropped;
+    bool initialized;
+} R;
+
 typedef struct {
     log_LogFn fn;
     void* udata;
@@ -34,13 +149,30 @@ static struct {
     void* udata;
     log_LockFn lock;
     int level;
+    int subsystem_levels[LOG_SUBSYSTEM_COUNT];
+    int rate_limit;
+    int sync_level;
     bool quiet;
     Callback callbacks[MAX_CALLBACKS];
-} L;
+
+    // async state
+    volatile unsigned int async;
+    volatile unsigned int writer_running;
+    volatile unsigned int consumer; // 1 while some thread is draining + writing
+    thrd_t writer;
+} L = {
+    .level            = LOG_TRACE,
+    .subsystem_levels = { -1, -1, -1, -1, -1 },
+    .rate_limit       = LOG_DEFAULT_RATE_LIMIT,
+    .sync_level       = LOG_FATAL,
+};
 
 static const char* level_strings[]
   = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
 
+static const char* subsystem_strings[]
+  = { "core", "render", "chuck", "video", "physics" };
+
 #ifdef LOG_USE_COLOR
 static const char* level_colors[]
   = { "\x1b[94m", "\x1b[36m", "\x1b[32m", "\x1b[33m", "\x1b[31m", "\x1b[35m" };
@@ -53,30 +185,25 @@ static void stdout_callback(log_Event* ev)
 #ifdef LOG_USE_COLOR
 #ifdef CHUGL_RELEASE
     // remove file, time, and line number from logs in release mode
-    fprintf(ev->udata, "[ChuGL]: %s%-5s\x1b[0m", level_colors[ev->level],
-            level_strings[ev->level]);
+    fprintf(ev->udata, "[ChuGL]: %s%-5s\x1b[0m%s\n", level_colors[ev->level],
+            level_strings[ev->level], ev->msg);
 #else  // CHUGL_RELEASE
-    fprintf(ev->udata, "[ChuGL]: %s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m", buf,
-            level_colors[ev->level], level_strings[ev->level], ev->file, ev->line);
+    fprintf(ev->udata, "[ChuGL]: %s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m%s\n", buf,
+            level_colors[ev->level], level_strings[ev->level], ev->file, ev->line,
+            ev->msg);
 #endif // CHUGL_RELEASE
 #else
-    fprintf(ev->udata, "[ChuGL]: %s %-5s %s:%d: ", buf, level_strings[ev->level],
-            ev->file, ev->line);
+    fprintf(ev->udata, "[ChuGL]: %s %-5s %s:%d: %s\n", buf, level_strings[ev->level],
+            ev->file, ev->line, ev->msg);
 #endif
-    vfprintf(ev->udata, ev->fmt, ev->ap);
-    fprintf(ev->udata, "\n");
-    fflush(ev->udata);
 }
 
 static void file_callback(log_Event* ev)
 {
     char buf[64];
     buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", ev->time)] = '\0';
-    fprintf(ev->udata, "%s %-5s %s:%d: ", buf, level_strings[ev->level], ev->file,
-            ev->line);
-    vfprintf(ev->udata, ev->fmt, ev->ap);
-    fprintf(ev->udata, "\n");
-    fflush(ev->udata);
+    fprintf(ev->udata, "%s %-5s %s:%d: %s\n", buf, level_strings[ev->level], ev->file,
+            ev->line, ev->msg);
 }
 
 static void lock(void)
@@ -98,6 +225,11 @@ const char* log_level_string(int level)
     return level_strings[level];
 }
 
+const char* log_subsystem_string(int subsystem)
+{
+    return subsystem_strings[subsystem];
+}
+
 void log_set_lock(log_LockFn fn, void* udata)
 {
     L.lock  = fn;
@@ -109,11 +241,27 @@ void log_set_level(int level)
     L.level = level;
 }
 
+void log_set_subsystem_level(int subsystem, int level)
+{
+    if (subsystem < 0 || subsystem >= LOG_SUBSYSTEM_COUNT) return;
+    L.subsystem_levels[subsystem] = level;
+}
+
 void log_set_quiet(bool enable)
 {
     L.quiet = enable;
 }
 
+void log_set_rate_limit(int max_per_second)
+{
+    L.rate_limit = max_per_second;
+}
+
+void log_set_sync_level(int level)
+{
+    L.sync_level = level;
+}
+
 int log_add_callback(log_LogFn fn, void* udata, int level)
 {
     for (int i = 0; i < MAX_CALLBACKS; i++) {
@@ -130,44 +278,581 @@ int log_add_fp(FILE* fp, int level)
     return log_add_callback(file_callback, fp, level);
 }
 
-static void init_event(log_Event* ev, void* udata)
+// ============================================================================
+// filtering
+// ============================================================================
+
+static int log_subsystem_for_file(const char* file)
+{
+    static const struct {
+        const char* prefix;
+        int subsystem;
+    } prefixes[] = {
+        // first match wins
+        { "ulib_video", LOG_SUBSYSTEM_VIDEO },
+        { "ulib_box2d", LOG_SUBSYSTEM_PHYSICS },
+        { "ulib_", LOG_SUBSYSTEM_CHUCK },
+        { "sg_", LOG_SUBSYSTEM_CHUCK },
+        { "ChuGL", LOG_SUBSYSTEM_CHUCK },
+        { "r_", LOG_SUBSYSTEM_RENDER },
+        { "app", LOG_SUBSYSTEM_RENDER },
+        { "graphics", LOG_SUBSYSTEM_RENDER },
+    };
+
+    const char* basename = file;
+    for (const char* p = file; *p; p++) {
+        if (*p == '/' || *p == '\\') basename = p + 1;
+    }
+
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        if (strncmp(basename, prefixes[i].prefix, strlen(prefixes[i].prefix)) == 0) {
+            return prefixes[i].subsystem;
+        }
+    }
+    return LOG_SUBSYSTEM_CORE;
+}
+
+static int log_callsite_subsystem(log_Callsite* cs)
 {
-    if (!ev->time) {
-        time_t t = time(NULL);
-        ev->time = localtime(&t);
+    int subsystem = (int)log_atomic_load(&cs->subsystem);
+    if (subsystem < 0) {
+        // benign race, every thread computes the same value
+        subsystem = log_subsystem_for_file(cs->file);
+        log_atomic_store(&cs->subsystem, subsystem);
     }
-    ev->udata = udata;
+    return subsystem;
 }
 
-void log_log(int level, const char* file, int line, const char* fmt, ...)
+static int stderr_level(int subsystem)
 {
-    log_Event ev = {
-        .fmt   = fmt,
-        .file  = file,
-        .line  = line,
-        .level = level,
-    };
+    int level = L.subsystem_levels[subsystem];
+    return level < 0 ? L.level : level;
+}
 
-    lock();
+static bool log_wanted(int level, int subsystem)
+{
+    if (!L.quiet && level >= stderr_level(subsystem)) return true;
+    for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+        if (level >= L.callbacks[i].level) return true;
+    }
+    return false;
+}
+
+// returns false if this message should be dropped.
+// Limits each callsite to L.rate_limit messages per second; the number of
+// dropped repeats is reported with the first message of a later window.
+static bool log_rate_limit(log_Callsite* cs, time_t now, unsigned int* suppressed)
+{
+    *suppressed = 0;
+    if (!cs || L.rate_limit <= 0) return true;
+
+    unsigned int window     = (unsigned int)now;
+    unsigned int old_window = log_atomic_load(&cs->window);
+    if (old_window != window && log_atomic_cas(&cs->window, old_window, window)) {
+        *suppressed = log_atomic_exchange(&cs->suppressed, 0);
+        log_atomic_store(&cs->count, 0);
+    }
+
+    if (log_atomic_add(&cs->count, 1) >= (unsigned int)L.rate_limit) {
+        log_atomic_add(&cs->suppressed, 1);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// deferred formatting
+// ============================================================================
+
+typedef struct {
+    const char* start;
+    int len;
+    int stars; // number of '*' width/precision args
+    char length[3];
+    char conv; // 0 if malformed
+} log_Spec;
+
+// p points at '%'. returns pointer past the conversion spec
+static const char* log_parse_spec(const char* p, log_Spec* spec)
+{
+    memset(spec, 0, sizeof(*spec));
+    spec->start = p++;
+
+    if (*p == '%') {
+        spec->conv = '%';
+        spec->len  = 2;
+        return p + 1;
+    }
+
+    // flags
+    while (*p && strchr("-+ #0'", *p)) p++;
+
+    // width
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    // precision
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    // length modifier
+    for (int i = 0; i < 2 && *p && strchr("hlLzjt", *p); i++) {
+        spec->length[i] = *p++;
+    }
+
+    spec->conv = *p;
+    if (*p) p++;
+    spec->len = (int)(p - spec->start);
+    return p;
+}
+
+// returns -1 for unsupported conversions
+static int log_arg_type(const log_Spec* spec)
+{
+    const char* len = spec->length;
+    switch (spec->conv) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (strcmp(len, "l") == 0) return LOG_ARG_LONG;
+            if (strcmp(len, "ll") == 0) return LOG_ARG_LLONG;
+            if (strcmp(len, "z") == 0) return LOG_ARG_SIZE;
+            if (strcmp(len, "j") == 0) return LOG_ARG_INTMAX;
+            if (strcmp(len, "t") == 0) return LOG_ARG_PTRDIFF;
+            return LOG_ARG_INT; // h, hh are promoted to int
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': return strcmp(len, "L") == 0 ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+        case 'p':
+        case 'n': return LOG_ARG_PTR;
+        case 's': return len[0] ? -1 : LOG_ARG_STR; // no wide strings
+        default: return -1;
+    }
+}
+
+static void log_capture_args(log_Record* rec, const char* fmt, va_list ap)
+{
+    rec->nargs        = 0;
+    rec->truncated    = 0;
+    rec->strings_used = 0;
+
+    log_Spec spec;
+    const char* p = fmt;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        p = log_parse_spec(p, &spec);
+        if (spec.conv == '%') continue;
+
+        int type = log_arg_type(&spec);
+        if (type < 0 || rec->nargs + spec.stars + 1 > LOG_MAX_ARGS) {
+            // can't safely walk the va_list any further
+            rec->truncated = 1;
+            return;
+        }
+
+        for (int i = 0; i < spec.stars; i++) {
+            rec->arg_types[rec->nargs]  = LOG_ARG_INT;
+            rec->args[rec->nargs++].i = va_arg(ap, int);
+        }
+
+        log_Arg* arg                = &rec->args[rec->nargs];
+        rec->arg_types[rec->nargs++] = (unsigned char)type;
+        switch (type) {
+            case LOG_ARG_INT: arg->i = va_arg(ap, int); break;
+            case LOG_ARG_LONG: arg->l = va_arg(ap, long); break;
+            case LOG_ARG_LLONG: arg->ll = va_arg(ap, long long); break;
+            case LOG_ARG_SIZE: arg->z = va_arg(ap, size_t); break;
+            case LOG_ARG_INTMAX: arg->j = va_arg(ap, intmax_t); break;
+            case LOG_ARG_PTRDIFF: arg->t = va_arg(ap, ptrdiff_t); break;
+            case LOG_ARG_DOUBLE: arg->d = va_arg(ap, double); break;
+            case LOG_ARG_LDOUBLE: arg->ld = va_arg(ap, long double); break;
+            case LOG_ARG_PTR: arg->p = va_arg(ap, const void*); break;
+            case LOG_ARG_STR: {
+                const char* str = va_arg(ap, const char*);
+                if (!str) str = "(null)";
+                // copy, truncating to whatever space is left
+                size_t avail = LOG_RECORD_STRINGS_SIZE - rec->strings_used;
+                size_t n     = strlen(str);
+                if (avail == 0) {
+                    arg->str = LOG_RECORD_STRINGS_SIZE - 1; // points at '\0'
+                    break;
+                }
+                if (n >= avail) n = avail - 1;
+                memcpy(rec->strings + rec->strings_used, str, n);
+                rec->strings[rec->strings_used + n] = '\0';
+                arg->str                            = rec->strings_used;
+                rec->strings_used += (unsigned short)(n + 1);
+            } break;
+        }
+    }
+}
+
+static void log_append(char* buf, size_t* len, const char* src, size_t n)
+{
+    size_t avail = LOG_MSG_SIZE - 1 - *len;
+    if (n > avail) n = avail;
+    memcpy(buf + *len, src, n);
+    *len += n;
+    buf[*len] = '\0';
+}
+
+static void log_format_record(const log_Record* rec, char* buf)
+{
+    size_t len    = 0;
+    int arg_index = 0;
+    buf[0]        = '\0';
+
+    log_Spec spec;
+    const char* p = rec->fmt;
+    while (*p) {
+        const char* literal = p;
+        while (*p && *p != '%') p++;
+        log_append(buf, &len, literal, p - literal);
+        if (!*p) break;
+
+        const char* spec_start = p;
+        p                      = log_parse_spec(p, &spec);
+        if (spec.conv == '%') {
+            log_append(buf, &len, "%", 1);
+            continue;
+        }
 
-    if (!L.quiet && level >= L.level) {
-        init_event(&ev, stderr);
-        va_start(ev.ap, fmt);
+        if (arg_index + spec.stars + 1 > rec->nargs
+            || spec.len >= 32) { // args were not captured, print the rest raw
+            log_append(buf, &len, spec_start, strlen(spec_start));
+            break;
+        }
+
+        char fmt[32];
+        memcpy(fmt, spec.start, spec.len);
+        fmt[spec.len] = '\0';
+
+        int star[2] = { 0, 0 };
+        for (int i = 0; i < spec.stars; i++) star[i] = rec->args[arg_index++].i;
+
+        const log_Arg* arg = &rec->args[arg_index];
+        int type           = rec->arg_types[arg_index++];
+        if (spec.conv == 'n') continue; // never write through captured pointers
+
+        char* dst    = buf + len;
+        size_t avail = LOG_MSG_SIZE - len;
+        int n        = 0;
+
+#define LOG_SNPRINTF(value)                                                            \
+    (spec.stars == 0 ? snprintf(dst, avail, fmt, value) :                              \
+     spec.stars == 1 ? snprintf(dst, avail, fmt, star[0], value) :                     \
+                       snprintf(dst, avail, fmt, star[0], star[1], value))
+
+        switch (type) {
+            case LOG_ARG_INT: n = LOG_SNPRINTF(arg->i); break;
+            case LOG_ARG_LONG: n = LOG_SNPRINTF(arg->l); break;
+            case LOG_ARG_LLONG: n = LOG_SNPRINTF(arg->ll); break;
+            case LOG_ARG_SIZE: n = LOG_SNPRINTF(arg->z); break;
+            case LOG_ARG_INTMAX: n = LOG_SNPRINTF(arg->j); break;
+            case LOG_ARG_PTRDIFF: n = LOG_SNPRINTF(arg->t); break;
+            case LOG_ARG_DOUBLE: n = LOG_SNPRINTF(arg->d); break;
+            case LOG_ARG_LDOUBLE: n = LOG_SNPRINTF(arg->ld); break;
+            case LOG_ARG_PTR: n = LOG_SNPRINTF(arg->p); break;
+            case LOG_ARG_STR: n = LOG_SNPRINTF(rec->strings + arg->str); break;
+        }
+#undef LOG_SNPRINTF
+
+        if (n > 0) len += ((size_t)n < avail) ? (size_t)n : avail - 1;
+    }
+
+    if (rec->truncated) log_append(buf, &len, " [...]", 6);
+}
+
+// ============================================================================
+// output
+// ============================================================================
+
+static void log_write(const char* msg, int level, int subsystem, const char* file,
+                      int line, time_t t)
+{
+    struct tm* time = localtime(&t);
+    log_Event ev    = {
+           .msg       = msg,
+           .file      = file,
+           .time      = time,
+           .line      = line,
+           .level     = level,
+           .subsystem = subsystem,
+    };
+
+    if (!L.quiet && level >= stderr_level(subsystem)) {
+        ev.udata = stderr;
         stdout_callback(&ev);
-        va_end(ev.ap);
     }
 
     for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
         Callback* cb = &L.callbacks[i];
         if (level >= cb->level) {
-            init_event(&ev, cb->udata);
-            va_start(ev.ap, fmt);
+            ev.udata = cb->udata;
             cb->fn(&ev);
-            va_end(ev.ap);
         }
     }
+}
+
+static void log_write_suppressed(unsigned int suppressed, int level, int subsystem,
+                                 const char* file, int line, time_t t)
+{
+    if (!suppressed) return;
+    char msg[64];
+    snprintf(msg, sizeof(msg), "(suppressed %u repeats of the following message)",
+             suppressed);
+    log_write(msg, level, subsystem, file, line, t);
+}
+
+static void log_flush_outputs(void)
+{
+    fflush(stderr);
+    for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+        if (L.callbacks[i].fn == file_callback) fflush(L.callbacks[i].udata);
+    }
+}
+
+// ============================================================================
+// ring
+// ============================================================================
+
+static void log_ring_init(void)
+{
+    if (R.initialized) return;
+    for (unsigned int i = 0; i < LOG_RING_CAPACITY; i++) R.cells[i].sequence = i;
+    R.enqueue_pos = 0;
+    R.dequeue_pos = 0;
+    R.initialized = true;
+}
+
+// returns NULL if the ring is full. On success the caller fills the record and
+// publishes it with log_ring_commit()
+static log_Cell* log_ring_reserve(unsigned int* pos_out)
+{
+    unsigned int pos = log_atomic_load(&R.enqueue_pos);
+    for (;;) {
+        log_Cell* cell    = &R.cells[pos & (LOG_RING_CAPACITY - 1)];
+        unsigned int seq  = log_atomic_load(&cell->sequence);
+        int diff          = (int)(seq - pos);
+        if (diff == 0) {
+            if (log_atomic_cas(&R.enqueue_pos, pos, pos + 1)) {
+                *pos_out = pos;
+                return cell;
+            }
+            pos = log_atomic_load(&R.enqueue_pos);
+        } else if (diff < 0) {
+            return NULL; // full
+        } else {
+            pos = log_atomic_load(&R.enqueue_pos);
+        }
+    }
+}
+
+static void log_ring_commit(log_Cell* cell, unsigned int pos)
+{
+    log_atomic_store(&cell->sequence, pos + 1);
+}
+
+// must hold L.consumer
+static log_Cell* log_ring_peek(void)
+{
+    log_Cell* cell   = &R.cells[R.dequeue_pos & (LOG_RING_CAPACITY - 1)];
+    unsigned int seq = log_atomic_load(&cell->sequence);
+    return ((int)(seq - (R.dequeue_pos + 1)) == 0) ? cell : NULL;
+}
+
+// must hold L.consumer
+static void log_ring_pop(log_Cell* cell)
+{
+    log_atomic_store(&cell->sequence, R.dequeue_pos + LOG_RING_CAPACITY);
+    R.dequeue_pos++;
+}
+
+static bool log_try_acquire_consumer(void)
+{
+    return log_atomic_cas(&L.consumer, 0, 1);
+}
+
+static void log_acquire_consumer(void)
+{
+    while (!log_try_acquire_consumer()) thrd_yield();
+}
 
+static void log_release_consumer(void)
+{
+    log_atomic_store(&L.consumer, 0);
+}
+
+// must hold L.consumer. Pass max_records = 0 to drain everything.
+// returns number of records written
+static int log_drain(int max_records)
+{
+    char msg[LOG_MSG_SIZE];
+    int count = 0;
+
+    unsigned int dropped = log_atomic_exchange(&R.dropped, 0);
+    if (dropped) {
+        snprintf(msg, sizeof(msg), "log ring full, dropped %u messages", dropped);
+        lock();
+        log_write(msg, LOG_WARN, LOG_SUBSYSTEM_CORE, __FILE__, __LINE__, time(NULL));
+        unlock();
+    }
+
+    if (!R.initialized) return count;
+
+    log_Cell* cell = NULL;
+    lock();
+    while ((max_records == 0 || count < max_records) && (cell = log_ring_peek())) {
+        const log_Record* rec = &cell->record;
+        log_write_suppressed(rec->suppressed, rec->level, rec->subsystem, rec->file,
+                             rec->line, rec->time);
+        log_format_record(rec, msg);
+        log_write(msg, rec->level, rec->subsystem, rec->file, rec->line, rec->time);
+        log_ring_pop(cell);
+        count++;
+    }
+    unlock();
+
+    if (count || dropped) log_flush_outputs();
+    return count;
+}
+
+void log_flush(void)
+{
+    log_acquire_consumer();
+    log_drain(0);
+    log_release_consumer();
+}
+
+static int log_writer_thread(void* arg)
+{
+    (void)arg;
+    struct timespec sleep_time = { 0, LOG_WRITER_SLEEP_NS };
+    while (log_atomic_load(&L.writer_running)) {
+        int written = 0;
+        if (log_try_acquire_consumer()) {
+            written = log_drain(LOG_WRITER_BATCH_SIZE);
+            log_release_consumer();
+        }
+        if (written < LOG_WRITER_BATCH_SIZE) thrd_sleep(&sleep_time, NULL);
+    }
+    return 0;
+}
+
+void log_set_async(bool enable)
+{
+    bool running = log_atomic_load(&L.writer_running);
+    if (enable == running) return;
+
+    if (enable) {
+        log_ring_init();
+        log_atomic_store(&L.writer_running, 1);
+        if (thrd_create(&L.writer, log_writer_thread, NULL) != thrd_success) {
+            log_atomic_store(&L.writer_running, 0);
+            return; // stay synchronous
+        }
+        log_atomic_store(&L.async, 1);
+    } else {
+        log_atomic_store(&L.async, 0);
+        log_atomic_store(&L.writer_running, 0);
+        thrd_join(L.writer, NULL);
+        log_flush();
+    }
+}
+
+void log_shutdown(void)
+{
+    // later log_*() calls are written synchronously, so nothing is lost
+    log_set_async(false);
+}
+
+// ============================================================================
+// entry points
+// ============================================================================
+
+static void log_log_va(log_Callsite* callsite, int level, int subsystem,
+                       const char* file, int line, const char* fmt, va_list ap)
+{
+    if (!log_wanted(level, subsystem)) return;
+
+    time_t now = time(NULL);
+    unsigned int suppressed;
+    if (!log_rate_limit(callsite, now, &suppressed)) return;
+
+    bool async = log_atomic_load(&L.async);
+    if (async && level < L.sync_level && level < LOG_FATAL) {
+        unsigned int pos;
+        log_Cell* cell = log_ring_reserve(&pos);
+        if (!cell) {
+            log_atomic_add(&R.dropped, 1);
+            return;
+        }
+        log_Record* rec = &cell->record;
+        rec->fmt        = fmt;
+        rec->file       = file;
+        rec->line       = line;
+        rec->level      = level;
+        rec->subsystem  = subsystem;
+        rec->time       = now;
+        rec->suppressed = suppressed;
+        log_capture_args(rec, fmt, ap);
+        log_ring_commit(cell, pos);
+        return;
+    }
+
+    // synchronous path: write everything queued before us first so ordering is
+    // kept, then format + write on the calling thread
+    char msg[LOG_MSG_SIZE];
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+
+    log_acquire_consumer();
+    if (async) log_drain(0);
+    lock();
+    log_write_suppressed(suppressed, level, subsystem, file, line, now);
+    log_write(msg, level, subsystem, file, line, now);
     unlock();
+    log_flush_outputs();
+    log_release_consumer();
+}
+
+void log_log(int level, const char* file, int line, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    log_log_va(NULL, level, log_subsystem_for_file(file), file, line, fmt, ap);
+    va_end(ap);
+}
+
+void log_log_callsite(log_Callsite* callsite, int level, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    log_log_va(callsite, level, log_callsite_subsystem(callsite), callsite->file,
+               callsite->line, fmt, ap);
+    va_end(ap);
 }
 
 void hexDump(const char* desc, const void* addr, const int len)
@@ -12,16 +12,16 @@
 #include <stdio.h>
 #include <time.h>
 
-#define LOG_VERSION "0.1.0"
+#define LOG_VERSION "0.2.0"
 
 typedef struct {
-    va_list ap;
-    const char* fmt;
+    const char* msg; // fully formatted message (no trailing newline)
     const char* file;
     struct tm* time;
     void* udata;
     int line;
     int level;
+    int subsystem;
 } log_Event;
 
 typedef void (*log_LogFn)(log_Event* ev);
@@ -29,25 +29,76 @@ typedef void (*log_LockFn)(bool lock, void* udata);
 
 enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 
-#define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define log_info(...) log_log(LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...) log_log(LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
-#define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+// subsystems are derived from the source file of the log callsite, see
+// log_subsystem_for_file() in log.c
+enum {
+    LOG_SUBSYSTEM_CORE,
+    LOG_SUBSYSTEM_RENDER,  // render thread: app, graphics, r_component
+    LOG_SUBSYSTEM_CHUCK,   // audio thread: ChuGL.cpp, sg_*, ulib_*
+    LOG_SUBSYSTEM_VIDEO,   // ulib_video
+    LOG_SUBSYSTEM_PHYSICS, // ulib_box2d
+    LOG_SUBSYSTEM_COUNT
+};
+
+// per-callsite state, one static instance per log_*() macro expansion.
+// Caches the subsystem and holds the rate limiting counters so that no
+// shared table (or lock) is needed on the hot path.
+// All fields after `line` are accessed atomically inside log.c
+typedef struct {
+    const char* file;
+    int line;
+    int subsystem; // -1 until first use
+    unsigned int window;     // rate limit window (seconds since epoch, truncated)
+    unsigned int count;      // messages logged in current window
+    unsigned int suppressed; // messages dropped by rate limit in current window
+} log_Callsite;
+
+#define log_log_at(level, ...)                                                         \
+    do {                                                                               \
+        static log_Callsite _log_callsite = { __FILE__, __LINE__, -1, 0, 0, 0 };       \
+        log_log_callsite(&_log_callsite, level, __VA_ARGS__);                          \
+    } while (0)
+
+#define log_trace(...) log_log_at(LOG_TRACE, __VA_ARGS__)
+#define log_debug(...) log_log_at(LOG_DEBUG, __VA_ARGS__)
+#define log_info(...) log_log_at(LOG_INFO, __VA_ARGS__)
+#define log_warn(...) log_log_at(LOG_WARN, __VA_ARGS__)
+#define log_error(...) log_log_at(LOG_ERROR, __VA_ARGS__)
+#define log_fatal(...) log_log_at(LOG_FATAL, __VA_ARGS__)
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 const char* log_level_string(int level);
+const char* log_subsystem_string(int subsystem);
 void log_set_lock(log_LockFn fn, void* udata);
 void log_set_level(int level);
+// level < 0 means the subsystem inherits the global level
+void log_set_subsystem_level(int subsystem, int level);
 void log_set_quiet(bool enable);
+// max messages per second from a single callsite, 0 to disable rate limiting
+void log_set_rate_limit(int max_per_second);
 int log_add_callback(log_LogFn fn, void* udata, int level);
 int log_add_fp(FILE* fp, int level);
 
+// Async mode: log_*() calls only capture their format args into a fixed-size
+// record on a lock-free ring; a background thread formats and writes them.
+// Messages at or above the sync level (default LOG_FATAL) are still written on
+// the calling thread (after draining pending records, so ordering is preserved).
+// Calls are safe from any thread, including the audio thread.
+// Nothing flushes the ring on a crash: records still queued when the process
+// dies are lost. Call log_flush() before exiting on an error path.
+void log_set_async(bool enable);
+void log_set_sync_level(int level);
+// writes out all pending records. Called automatically on log_fatal()
+void log_flush(void);
+// stops the writer thread after draining every pending record. Call before the
+// library is unloaded
+void log_shutdown(void);
+
 void log_log(int level, const char* file, int line, const char* fmt, ...);
+void log_log_callsite(log_Callsite* callsite, int level, const char* fmt, ...);
 
 // Usage:
 //     hexDump(desc, addr, len, perLine);
@@ -26,6 +26,7 @@
  SOFTWARE.
 -----------------------------------------------------------------------------*/
 #include "geometry.h"
+#include "core/jobs.h"
 #include "core/memory.h"
 #include "suzanne_geo.cpp"
 
@@ -105,6 +106,73 @@ static int GAB_vertexCount(GeometryArenaBuilder* builder)
 //     return ARENA_LENGTH(builder->indices_arena, u32);
 // }
 
+// ============================================================================
+// Row-parallel builders
+// ============================================================================
+// The parametric builders push their full vertex and index buffers up front, then
+// fill them one row of the parameter grid at a time. Rows write disjoint ranges,
+// so large grids are split across the job pool. The sin/cos of every grid column
+// (and row) is tabulated once, leaving the per-vertex loops trig-free
+// multiply-adds over contiguous arrays that the compiler can vectorize
+
+typedef void (*GeometryRowFn)(void* udata, u32 row_begin, u32 row_end);
+
+struct GeometryRowJob {
+    GeometryRowFn fn;
+    void* udata;
+    u32 row_begin, row_end;
+};
+
+static void Geometry_rowJobRun(void* udata)
+{
+    GeometryRowJob* job = (GeometryRowJob*)udata;
+    job->fn(job->udata, job->row_begin, job->row_end);
+}
+
+// calls fn over [0, row_count), on the job pool if there are enough vertices.
+// Returns once every row is written. Only waits on its own rows, so builds on the
+// audio thread never end up running unrelated queued jobs
+static void Geometry_forRows(GeometryRowFn fn, void* udata, u32 row_count,
+                             u32 vertices_per_row)
+{
+    u64 vertex_count = (u64)row_count * vertices_per_row;
+    if (vertex_count < GEOMETRY_PARALLEL_MIN_VERTICES || row_count < 2) {
+        fn(udata, 0, row_count);
+        return;
+    }
+
+    Jobs_Init();
+    GeometryRowJob jobs[64];
+    u32 job_count = MIN((u32)ARRAY_LENGTH(jobs), (u32)Jobs_WorkerCount() + 1);
+    job_count     = MIN(job_count, row_count);
+    u32 rows_per_job = (row_count + job_count - 1) / job_count;
+
+    Jobs_Counter counter;
+    u32 submitted = 0;
+    for (u32 row = 0; row < row_count; row += rows_per_job) {
+        GeometryRowJob* job = &jobs[submitted++];
+        job->fn             = fn;
+        job->udata          = udata;
+        job->row_begin      = row;
+        job->row_end        = MIN(row + rows_per_job, row_count);
+        // the calling thread takes the first chunk itself
+        if (row > 0) Jobs_Submit(Geometry_rowJobRun, job, &counter);
+    }
+    Geometry_rowJobRun(&jobs[0]);
+    Jobs_WaitOwn(&counter);
+}
+
+// cos/sin of start + i / segments * length for i in [0, segments]
+static void Geometry_trigTable(f32* cos_out, f32* sin_out, u32 segments, f32 start,
+                               f32 length)
+{
+    for (u32 i = 0; i <= segments; i++) {
+        const f32 angle = start + (f32)i / (f32)segments * length;
+        cos_out[i]      = glm::cos(angle);
+        sin_out[i]      = glm::sin(angle);
+    }
+}
+
 void Geometry_buildPlane(GeometryArenaBuilder* builder, PlaneParams* params)
 {
     const f32 width_half  = params->width * 0.5f;
@@ -158,6 +226,79 @@ void Geometry_buildPlane(GeometryArenaBuilder* builder, PlaneParams* params)
     ASSERT(index == index_tri_count);
 }
 
+struct GeometrySphereRows {
+    const SphereParams* params;
+    const f32 *cos_phi, *sin_phi, *cos_theta, *sin_theta;
+    f32 radius_sign;
+    f32 u_offset_first, u_offset_last; // uv shift at the poles
+    bool tri_a_first, tri_b_last;      // whether the pole rows have both triangles
+    glm::vec3* positions;
+    glm::vec3* normals;
+    gvec2f* uvs;
+    u32* indices;
+};
+
+static void Geometry_sphereRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometrySphereRows* r = (GeometrySphereRows*)udata;
+    const f32 radius      = r->params->radius;
+    const u32 width_seg   = r->params->widthSeg;
+    const u32 height_seg  = r->params->heightSeg;
+    const u32 row_size    = width_seg + 1;
+
+    for (u32 iy = row_begin; iy < row_end; iy++) {
+        // generate vertices, normals and uvs
+        const f32 v = (f32)iy / (f32)height_seg;
+
+        f32 u_offset = 0;
+        if (iy == 0) u_offset = r->u_offset_first;
+        if (iy == height_seg) u_offset = r->u_offset_last;
+
+        const f32 cos_theta = r->cos_theta[iy];
+        const f32 sin_theta = r->sin_theta[iy];
+
+        glm::vec3* positions = r->positions + (u64)iy * row_size;
+        glm::vec3* normals   = r->normals + (u64)iy * row_size;
+        gvec2f* uvs          = r->uvs + (u64)iy * row_size;
+        for (u32 ix = 0; ix <= width_seg; ix++) {
+            // unit direction, scaled by the radius
+            const f32 nx = -r->cos_phi[ix] * sin_theta;
+            const f32 nz = r->sin_phi[ix] * sin_theta;
+
+            positions[ix] = { radius * nx, radius * cos_theta, radius * nz };
+            normals[ix]   = { r->radius_sign * nx, r->radius_sign * cos_theta,
+                              r->radius_sign * nz };
+            uvs[ix]       = { (f32)ix / (f32)width_seg + u_offset, 1 - v };
+        }
+
+        // generate the triangles between this row and the next. The pole rows
+        // skip their degenerate triangle
+        if (iy == height_seg) continue;
+        const bool tri_a = iy != 0 || r->tri_a_first;
+        const bool tri_b = iy != height_seg - 1 || r->tri_b_last;
+        u32 tri = 0;
+        if (iy > 0) tri = (r->tri_a_first ? 1 : 0) + (iy - 1) + iy;
+        u32* indices = r->indices + (u64)tri * width_seg * 3;
+        for (u32 ix = 0; ix < width_seg; ix++) {
+            const u32 a = (iy * row_size) + ix + 1;
+            const u32 b = (iy * row_size) + ix;
+            const u32 c = (row_size * (iy + 1)) + ix;
+            const u32 d = row_size * (iy + 1) + (ix + 1);
+
+            if (tri_a) {
+                *indices++ = a;
+                *indices++ = b;
+                *indices++ = d;
+            }
+            if (tri_b) {
+                *indices++ = b;
+                *indices++ = c;
+                *indices++ = d;
+            }
+        }
+    }
+}
+
 void Geometry_buildSphere(GeometryArenaBuilder* builder, SphereParams* params)
 {
 
@@ -166,85 +307,49 @@ void Geometry_buildSphere(GeometryArenaBuilder* builder, SphereParams* params)
 
     const f32 thetaEnd = MIN(params->thetaStart + params->thetaLength, PI);
 
-    int num_vertices = (params->widthSeg + 1) * (params->heightSeg + 1);
-
-    glm::vec3* positions
-      = ARENA_PUSH_COUNT(builder->pos_arena, glm::vec3, num_vertices);
-    glm::vec3* normals = ARENA_PUSH_COUNT(builder->norm_arena, glm::vec3, num_vertices);
-    gvec2f* uvs        = ARENA_PUSH_COUNT(builder->uv_arena, gvec2f, num_vertices);
-
-    u32 index = 0;
-    std::vector<u32> grid;
-    std::vector<u32> indices;
-
-    // generate vertices, normals and uvs
-    for (u32 iy = 0; iy <= params->heightSeg; iy++) {
-
-        const f32 v = (f32)iy / (f32)params->heightSeg;
-
-        // special case for the poles
-        f32 uOffset = 0;
-        if (iy == 0 && glm::epsilonEqual(params->thetaStart, 0.0f, EPSILON)) {
-            uOffset = 0.5f / params->widthSeg;
-        } else if (iy == params->heightSeg
-                   && glm::epsilonEqual(thetaEnd, PI, EPSILON)) {
-            uOffset = -0.5 / params->widthSeg;
-        }
-
-        for (u32 ix = 0; ix <= params->widthSeg; ix++) {
-
-            const f32 u = (f32)ix / (f32)params->widthSeg;
-
-            // vertex
-            positions[index].x
-              = -params->radius * glm::cos(params->phiStart + u * params->phiLength)
-                * glm::sin(params->thetaStart + v * params->thetaLength);
-            positions[index].y
-              = params->radius * glm::cos(params->thetaStart + v * params->thetaLength);
-            positions[index].z
-              = params->radius * glm::sin(params->phiStart + u * params->phiLength)
-                * glm::sin(params->thetaStart + v * params->thetaLength);
-
-            // normal
-            normals[index] = glm::normalize(positions[index]);
+    const u32 num_vertices = (params->widthSeg + 1) * (params->heightSeg + 1);
 
-            // uv
-            uvs[index].x = u + uOffset;
-            uvs[index].y = 1 - v;
+    GeometrySphereRows rows = {};
+    rows.params             = params;
+    rows.radius_sign        = params->radius < 0 ? -1.0f : 1.0f;
 
-            grid.push_back(index++);
-        }
+    // special case for the poles
+    if (glm::epsilonEqual(params->thetaStart, 0.0f, EPSILON)) {
+        rows.u_offset_first = 0.5f / params->widthSeg;
     }
-
-    const size_t rowSize = (size_t)params->widthSeg + 1;
-    for (size_t iy = 0; iy < params->heightSeg; iy++) {
-        for (size_t ix = 0; ix < params->widthSeg; ix++) {
-
-            const u32 a = grid[(iy * rowSize) + ix + 1];
-            const u32 b = grid[(iy * rowSize) + ix];
-            const u32 c = grid[(rowSize * (iy + 1)) + ix];
-            const u32 d = grid[rowSize * (iy + 1) + (ix + 1)];
-
-            if (iy != 0 || params->thetaStart > EPSILON) {
-                indices.push_back(a);
-                indices.push_back(b);
-                indices.push_back(d);
-            }
-            if (iy != (size_t)params->heightSeg - 1 || thetaEnd < PI - EPSILON) {
-                indices.push_back(b);
-                indices.push_back(c);
-                indices.push_back(d);
-            }
-        }
+    if (glm::epsilonEqual(thetaEnd, PI, EPSILON)) {
+        rows.u_offset_last = -0.5 / params->widthSeg;
     }
-
-    size_t index_count = indices.size();
-    ASSERT(index_count % 3 == 0); // must be a multiple of 3 triangles only
-
-    u32* indices_array = ARENA_PUSH_COUNT(builder->indices_arena, u32, index_count);
-
-    // copy indices
-    memcpy(indices_array, indices.data(), indices.size() * sizeof(*indices_array));
+    rows.tri_a_first = params->thetaStart > EPSILON;
+    rows.tri_b_last  = thetaEnd < PI - EPSILON;
+
+    const u32 tri_row_count = 2 * (params->heightSeg - 1) + (rows.tri_a_first ? 1 : 0)
+                              + (rows.tri_b_last ? 1 : 0);
+    const u32 index_count   = tri_row_count * params->widthSeg * 3;
+
+    rows.positions = ARENA_PUSH_COUNT(builder->pos_arena, glm::vec3, num_vertices);
+    rows.normals   = ARENA_PUSH_COUNT(builder->norm_arena, glm::vec3, num_vertices);
+    rows.uvs       = ARENA_PUSH_COUNT(builder->uv_arena, gvec2f, num_vertices);
+    rows.indices   = ARENA_PUSH_COUNT(builder->indices_arena, u32, index_count);
+
+    const u32 table_size = params->widthSeg + params->heightSeg + 2;
+    f32* cos_table       = ALLOCATE_COUNT(f32, table_size);
+    f32* sin_table       = ALLOCATE_COUNT(f32, table_size);
+    rows.cos_phi         = cos_table;
+    rows.sin_phi         = sin_table;
+    rows.cos_theta       = cos_table + params->widthSeg + 1;
+    rows.sin_theta       = sin_table + params->widthSeg + 1;
+    Geometry_trigTable(cos_table, sin_table, params->widthSeg, params->phiStart,
+                       params->phiLength);
+    Geometry_trigTable(cos_table + params->widthSeg + 1,
+                       sin_table + params->widthSeg + 1, params->heightSeg,
+                       params->thetaStart, params->thetaLength);
+
+    Geometry_forRows(Geometry_sphereRows, &rows, params->heightSeg + 1,
+                     params->widthSeg + 1);
+
+    FREE_ARRAY(f32, cos_table, table_size);
+    FREE_ARRAY(f32, sin_table, table_size);
     ASSERT(ARENA_LENGTH(builder->indices_arena, u32) == index_count);
 }
 
@@ -393,6 +498,57 @@ void Geometry_buildCircle(GeometryArenaBuilder* gab, CircleParams* params)
     }
 }
 
+struct GeometryTorusRows {
+    const TorusParams* params;
+    const f32 *cos_u, *sin_u, *cos_v, *sin_v;
+    f32 tube_sign;
+    glm::vec3* positions;
+    glm::vec3* normals;
+    gvec2f* uvs;
+    gvec3i* indices;
+};
+
+static void Geometry_torusRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometryTorusRows* r = (GeometryTorusRows*)udata;
+    const u32 tubular    = r->params->tubularSegments;
+    const u32 radial     = r->params->radialSegments;
+    const u32 row_size   = tubular + 1;
+
+    for (u32 j = row_begin; j < row_end; j++) {
+        const f32 cos_v = r->cos_v[j];
+        const f32 sin_v = r->sin_v[j];
+        const f32 ring  = r->params->radius + r->params->tubeRadius * cos_v;
+        const f32 z     = r->params->tubeRadius * sin_v;
+
+        glm::vec3* positions = r->positions + (u64)j * row_size;
+        glm::vec3* normals   = r->normals + (u64)j * row_size;
+        gvec2f* uvs          = r->uvs + (u64)j * row_size;
+        for (u32 i = 0; i <= tubular; i++) {
+            positions[i] = { ring * r->cos_u[i], ring * r->sin_u[i], z };
+
+            // direction from the center of the tube
+            normals[i] = { r->tube_sign * cos_v * r->cos_u[i],
+                           r->tube_sign * cos_v * r->sin_u[i], r->tube_sign * sin_v };
+
+            uvs[i] = { (float)i / (float)tubular, (float)j / (float)radial };
+        }
+
+        // the quads between this row and the previous one
+        if (j == 0) continue;
+        gvec3i* indices = r->indices + (u64)(j - 1) * tubular * 2;
+        for (u32 i = 1; i <= tubular; i++) {
+            const u32 a = row_size * j + i - 1;
+            const u32 b = row_size * (j - 1) + i - 1;
+            const u32 c = row_size * (j - 1) + i;
+            const u32 d = row_size * j + i;
+
+            *indices++ = { a, b, d };
+            *indices++ = { b, c, d };
+        }
+    }
+}
+
 void Geometry_buildTorus(GeometryArenaBuilder* gab, TorusParams* params)
 {
     const int num_vertices
@@ -400,125 +556,122 @@ void Geometry_buildTorus(GeometryArenaBuilder* gab, TorusParams* params)
     const int num_indices = params->radialSegments * params->tubularSegments * 2;
 
     ASSERT(sizeof(glm::vec3) == sizeof(gvec3f));
-    glm::vec3* positions = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, num_vertices);
-    glm::vec3* normals   = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, num_vertices);
-    gvec2f* uvs          = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
-    gvec3i* indices      = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
+    GeometryTorusRows rows = {};
+    rows.params            = params;
+    rows.tube_sign         = params->tubeRadius < 0 ? -1.0f : 1.0f;
+
+    rows.positions = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, num_vertices);
+    rows.normals   = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, num_vertices);
+    rows.uvs       = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
+    rows.indices   = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
+
+    const int table_size = params->tubularSegments + params->radialSegments + 2;
+    f32* cos_table       = ALLOCATE_COUNT(f32, table_size);
+    f32* sin_table       = ALLOCATE_COUNT(f32, table_size);
+    rows.cos_u           = cos_table;
+    rows.sin_u           = sin_table;
+    rows.cos_v           = cos_table + params->tubularSegments + 1;
+    rows.sin_v           = sin_table + params->tubularSegments + 1;
+    Geometry_trigTable(cos_table, sin_table, params->tubularSegments, 0,
+                       params->arcLength);
+    Geometry_trigTable(cos_table + params->tubularSegments + 1,
+                       sin_table + params->tubularSegments + 1,
+                       params->radialSegments, 0, PI * 2.0f);
+
+    Geometry_forRows(Geometry_torusRows, &rows, params->radialSegments + 1,
+                     params->tubularSegments + 1);
+
+    FREE_ARRAY(f32, cos_table, table_size);
+    FREE_ARRAY(f32, sin_table, table_size);
+}
 
-    int index = 0;
-    for (int j = 0; j <= params->radialSegments; j++) {
-        for (int i = 0; i <= params->tubularSegments; i++) {
-            const float u
-              = (float)i / (float)params->tubularSegments * params->arcLength;
-            const float v = (float)j / (float)params->radialSegments * PI * 2.0f;
+// Cylinder ============================================================================
+struct GeometryCylinderRows {
+    const CylinderParams* p;
+    const f32 *cos_theta, *sin_theta;
+    f32 normal_y, normal_xz; // the side normal is constant along a column
+    gvec3f* positions;
+    gvec3f* normals;
+    gvec2f* uvs;
+    gvec3i* indices;
+};
 
-            // vertex
-            positions[index]
-              = { (params->radius + params->tubeRadius * glm::cos(v)) * glm::cos(u),
-                  (params->radius + params->tubeRadius * glm::cos(v)) * glm::sin(u),
-                  params->tubeRadius * glm::sin(v) };
+static void Geometry_cylinderRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometryCylinderRows* r = (GeometryCylinderRows*)udata;
+    const CylinderParams& p = *r->p;
+    const float halfHeight  = p.height / 2.0f;
+    const u32 row_size      = p.radialSegments + 1;
+
+    for (u32 y = row_begin; y < row_end; y++) {
+        const float v = (float)y / (float)p.heightSegments;
 
-            // normal
-            glm::vec3 center
-              = { params->radius * glm::cos(u), params->radius * glm::sin(u), 0 };
-            normals[index] = glm::normalize(positions[index] - center);
+        // calculate the radius of the current row
+        const float radius = v * (p.radiusBottom - p.radiusTop) + p.radiusTop;
+        const float py     = -v * p.height + halfHeight;
 
-            // uv
-            uvs[index] = { (float)i / (float)params->tubularSegments,
-                           (float)j / (float)params->radialSegments };
+        gvec3f* positions = r->positions + (u64)y * row_size;
+        gvec3f* normals   = r->normals + (u64)y * row_size;
+        gvec2f* uvs       = r->uvs + (u64)y * row_size;
+        for (u32 x = 0; x <= p.radialSegments; x++) {
+            const float u = (float)x / (float)p.radialSegments;
 
-            index++;
+            positions[x] = { radius * r->sin_theta[x], py, radius * r->cos_theta[x] };
+            normals[x]   = { r->normal_xz * r->sin_theta[x], r->normal_y,
+                             r->normal_xz * r->cos_theta[x] };
+            uvs[x]       = { u, 1.0f - v };
         }
-    }
-
-    // generate indices
-    index = 0;
-    for (u32 j = 1; j <= params->radialSegments; j++) {
-        for (u32 i = 1; i <= params->tubularSegments; i++) {
-            // indices
-            const u32 a = (params->tubularSegments + 1) * j + i - 1;
-            const u32 b = (params->tubularSegments + 1) * (j - 1) + i - 1;
-            const u32 c = (params->tubularSegments + 1) * (j - 1) + i;
-            const u32 d = (params->tubularSegments + 1) * j + i;
 
-            indices[index++] = { a, b, d };
-            indices[index++] = { b, c, d };
+        // faces between this row and the next, indices are ordered column-major
+        if (y == p.heightSegments) continue;
+        for (u32 x = 0; x < p.radialSegments; x++) {
+            const u32 a = y * row_size + x;
+            const u32 b = (y + 1) * row_size + x;
+            const u32 c = (y + 1) * row_size + x + 1;
+            const u32 d = y * row_size + x + 1;
+
+            gvec3i* quad = r->indices + ((u64)x * p.heightSegments + y) * 2;
+            quad[0]      = { a, b, d };
+            quad[1]      = { b, c, d };
         }
     }
 }
 
-// Cylinder ============================================================================
 static void Geometry_Cylinder_GenerateTorso(GeometryArenaBuilder* gab,
                                             const CylinderParams& p)
 {
-    const float halfHeight = p.height / 2.0f;
+    // the torso is built first, so its indices start at 0
+    ASSERT(GAB_vertexCount(gab) == 0);
 
     const int num_vertices = (p.heightSegments + 1) * (p.radialSegments + 1);
     const int num_indices  = p.heightSegments * p.radialSegments * 2;
-    gvec3f* positions      = ARENA_PUSH_COUNT(gab->pos_arena, gvec3f, num_vertices);
-    gvec3f* normals        = ARENA_PUSH_COUNT(gab->norm_arena, gvec3f, num_vertices);
-    gvec2f* uvs            = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
-    gvec3i* indices        = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
-
-    static Arena index_array_arena{};
-    ASSERT(ARENA_LENGTH(&index_array_arena, int) == 0);
-    int* indexArray = ARENA_PUSH_COUNT(&index_array_arena, int, num_vertices);
-    defer(Arena::clear(&index_array_arena));
 
-    // this will be used to calculate the normal
-    const float slope = (p.radiusBottom - p.radiusTop) / p.height;
+    GeometryCylinderRows rows = {};
+    rows.p                    = &p;
 
-    // generate vertices, normals and uvs
-    int index = 0;
-    for (unsigned int y = 0; y <= p.heightSegments; y++) {
-
-        std::vector<unsigned int> indexRow;
-
-        const float v = (float)y / (float)p.heightSegments;
-
-        // calculate the radius of the current row
-        const float radius = v * (p.radiusBottom - p.radiusTop) + p.radiusTop;
-
-        for (unsigned int x = 0; x <= p.radialSegments; x++) {
-            const float u = (float)x / (float)p.radialSegments;
+    rows.positions = ARENA_PUSH_COUNT(gab->pos_arena, gvec3f, num_vertices);
+    rows.normals   = ARENA_PUSH_COUNT(gab->norm_arena, gvec3f, num_vertices);
+    rows.uvs       = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
+    rows.indices   = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
 
-            const float theta = u * p.thetaLength + p.thetaStart;
+    // this will be used to calculate the normal, normalize(sin, slope, cos)
+    const float slope      = (p.radiusBottom - p.radiusTop) / p.height;
+    const float normal_len = glm::sqrt(1.0f + slope * slope);
+    rows.normal_y          = slope / normal_len;
+    rows.normal_xz         = 1.0f / normal_len;
 
-            const float sinTheta = glm::sin(theta);
-            const float cosTheta = glm::cos(theta);
-
-            // vertex
-            positions[index]
-              = { radius * sinTheta, -v * p.height + halfHeight, radius * cosTheta };
-
-            // normal
-            glm::vec3 normal = glm::normalize(glm::vec3(sinTheta, slope, cosTheta));
-            normals[index]   = { normal.x, normal.y, normal.z };
-
-            // uv
-            uvs[index] = { u, 1.0f - v };
-
-            indexArray[y * (p.radialSegments + 1) + x] = index;
-            index++;
-        }
-    }
-
-    // generate indices
-    index = 0;
-    for (unsigned int x = 0; x < p.radialSegments; x++) {
-        for (unsigned int y = 0; y < p.heightSegments; y++) {
+    f32* cos_theta = ALLOCATE_COUNT(f32, p.radialSegments + 1);
+    f32* sin_theta = ALLOCATE_COUNT(f32, p.radialSegments + 1);
+    Geometry_trigTable(cos_theta, sin_theta, p.radialSegments, p.thetaStart,
+                       p.thetaLength);
+    rows.cos_theta = cos_theta;
+    rows.sin_theta = sin_theta;
 
-            // we use the index array to access the correct indices
-            const unsigned int a = indexArray[y * (p.radialSegments + 1) + x];
-            const unsigned int b = indexArray[(y + 1) * (p.radialSegments + 1) + x];
-            const unsigned int c = indexArray[(y + 1) * (p.radialSegments + 1) + x + 1];
-            const unsigned int d = indexArray[y * (p.radialSegments + 1) + x + 1];
+    Geometry_forRows(Geometry_cylinderRows, &rows, p.heightSegments + 1,
+                     p.radialSegments + 1);
 
-            // faces
-            indices[index++] = { a, b, d };
-            indices[index++] = { b, c, d };
-        }
-    }
+    FREE_ARRAY(f32, cos_theta, p.radialSegments + 1);
+    FREE_ARRAY(f32, sin_theta, p.radialSegments + 1);
 }
 
 static void Geometry_Cylinder_GenerateCap(GeometryArenaBuilder* gab,
@@ -616,17 +769,22 @@ static void Geometry_Knot_calculatePositionOnCurve(float u, int p, int q, float
     position.z = radius * glm::sin(quOverP) * 0.5;
 }
 
-void Geometry_buildKnot(GeometryArenaBuilder* gab, KnotParams* params)
-{
-    // buffers
-    const int num_vertices
-      = (params->tubularSegments + 1) * (params->radialSegments + 1);
-    const int num_indices = 2 * params->tubularSegments * params->radialSegments;
+struct GeometryKnotRows {
+    const KnotParams* params;
+    const f32 *cos_v, *sin_v;
+    f32 tube_sign;
+    glm::vec3* positions;
+    glm::vec3* normals;
+    gvec2f* uvs;
+    gvec3i* indices;
+};
 
-    glm::vec3* positions = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, num_vertices);
-    glm::vec3* normals   = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, num_vertices);
-    gvec2f* uvs          = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
-    gvec3i* indices      = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
+static void Geometry_knotRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometryKnotRows* r      = (GeometryKnotRows*)udata;
+    const KnotParams* params = r->params;
+    const u32 radial         = params->radialSegments;
+    const u32 row_size       = radial + 1;
 
     glm::vec3 P1 = glm::vec3(0.0f);
     glm::vec3 P2 = glm::vec3(0.0f);
@@ -635,9 +793,7 @@ void Geometry_buildKnot(GeometryArenaBuilder* gab, KnotParams* params)
     glm::vec3 T = glm::vec3(0.0f);
     glm::vec3 N = glm::vec3(0.0f);
 
-    // generate vertices, normals and uvs
-    int index = 0;
-    for (int i = 0; i <= params->tubularSegments; ++i) {
+    for (u32 i = row_begin; i < row_end; i++) {
 
         // the radian "u" is used to calculate the position on the torus curve of the
         // current tubular segment
@@ -659,56 +815,63 @@ void Geometry_buildKnot(GeometryArenaBuilder* gab, KnotParams* params)
         B = glm::normalize(glm::cross(T, N));
         N = glm::normalize(glm::cross(B, T));
 
-        for (int j = 0; j <= params->radialSegments; ++j) {
-
-            // now calculate the vertices. they are nothing more than an extrusion of
-            // the torus curve. because we extrude a shape in the xy-plane, there is no
-            // need to calculate a z-value.
-
-            const float v  = (f32)j / params->radialSegments * PI * 2.0f;
-            const float cx = -params->tube * glm::cos(v);
-            const float cy = params->tube * glm::sin(v);
-
-            // now calculate the final vertex position.
-            // first we orient the extrusion with our basis vectors, then we add it to
-            // the current position on the curve
-
-            positions[index].x = P1.x + (cx * N.x + cy * B.x);
-            positions[index].y = P1.y + (cx * N.y + cy * B.y);
-            positions[index].z = P1.z + (cx * N.z + cy * B.z);
-
-            // normal (P1 is always the center/origin of the extrusion, thus we can use
-            // it to calculate the normal)
-
-            normals[index] = glm::normalize(positions[index] - P1);
+        // now calculate the vertices. they are nothing more than an extrusion of the
+        // torus curve in the plane of N and B. P1 is the center of the extrusion, so
+        // the normal is the unit extrusion direction
+        glm::vec3* positions = r->positions + (u64)i * row_size;
+        glm::vec3* normals   = r->normals + (u64)i * row_size;
+        gvec2f* uvs          = r->uvs + (u64)i * row_size;
+        for (u32 j = 0; j <= radial; j++) {
+            const glm::vec3 dir = -r->cos_v[j] * N + r->sin_v[j] * B;
+
+            positions[j] = P1 + params->tube * dir;
+            normals[j]   = r->tube_sign * dir;
+            uvs[j]       = { (float)i / params->tubularSegments, (float)j / radial };
+        }
 
-            // uv
-            uvs[index].x = (float)i / params->tubularSegments;
-            uvs[index].y = (float)j / params->radialSegments;
+        // the quads between this ring and the previous one
+        if (i == 0) continue;
+        gvec3i* indices = r->indices + (u64)(i - 1) * radial * 2;
+        for (u32 j = 1; j <= radial; j++) {
+            const u32 a = row_size * (i - 1) + (j - 1);
+            const u32 b = row_size * i + (j - 1);
+            const u32 c = row_size * i + j;
+            const u32 d = row_size * (i - 1) + j;
 
-            index++;
+            // faces
+            *indices++ = { a, b, d };
+            *indices++ = { b, c, d };
         }
     }
-    ASSERT(index == num_vertices);
+}
 
-    // generate indices
+void Geometry_buildKnot(GeometryArenaBuilder* gab, KnotParams* params)
+{
+    // buffers
+    const int num_vertices
+      = (params->tubularSegments + 1) * (params->radialSegments + 1);
+    const int num_indices = 2 * params->tubularSegments * params->radialSegments;
 
-    index = 0;
-    for (int j = 1; j <= params->tubularSegments; j++) {
-        for (int i = 1; i <= params->radialSegments; i++) {
+    GeometryKnotRows rows = {};
+    rows.params           = params;
+    rows.tube_sign        = params->tube < 0 ? -1.0f : 1.0f;
 
-            // indices
-            const u32 a = (params->radialSegments + 1) * (j - 1) + (i - 1);
-            const u32 b = (params->radialSegments + 1) * j + (i - 1);
-            const u32 c = (params->radialSegments + 1) * j + i;
-            const u32 d = (params->radialSegments + 1) * (j - 1) + i;
+    rows.positions = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, num_vertices);
+    rows.normals   = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, num_vertices);
+    rows.uvs       = ARENA_PUSH_COUNT(gab->uv_arena, gvec2f, num_vertices);
+    rows.indices   = ARENA_PUSH_COUNT(gab->indices_arena, gvec3i, num_indices);
 
-            // faces
-            indices[index++] = { a, b, d };
-            indices[index++] = { b, c, d };
-        }
-    }
-    ASSERT(index == num_indices);
+    f32* cos_v = ALLOCATE_COUNT(f32, params->radialSegments + 1);
+    f32* sin_v = ALLOCATE_COUNT(f32, params->radialSegments + 1);
+    Geometry_trigTable(cos_v, sin_v, params->radialSegments, 0, PI * 2.0f);
+    rows.cos_v = cos_v;
+    rows.sin_v = sin_v;
+
+    Geometry_forRows(Geometry_knotRows, &rows, params->tubularSegments + 1,
+                     params->radialSegments + 1);
+
+    FREE_ARRAY(f32, cos_v, params->radialSegments + 1);
+    FREE_ARRAY(f32, sin_v, params->radialSegments + 1);
 }
 
 void Geometry_buildPolygon(GeometryArenaBuilder* gab, PolygonParams* params)
@@ -837,20 +1000,840 @@ void Geometry_buildPolyhedron(GeometryArenaBuilder* gab, PolyhedronType type)
             par_shapes_rotate(par_mesh, -PI / 6.0, (float*)&axis);
         }
     }
-    par_shapes_unweld(par_mesh, true);
-    par_shapes_compute_normals(par_mesh);
 
-    glm::vec3* positions
-      = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, par_mesh->npoints);
-    glm::vec3* normals
-      = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, par_mesh->npoints);
-    gvec2f* uvs = ARENA_PUSH_ZERO_COUNT(gab->uv_arena, gvec2f, par_mesh->npoints);
+    // flat shaded: unweld straight into the arenas, one vertex per face corner with
+    // the face normal, rather than par_shapes_unweld() + par_shapes_compute_normals()
+    const int num_vertices = par_mesh->ntriangles * 3;
+    glm::vec3* positions = ARENA_PUSH_COUNT(gab->pos_arena, glm::vec3, num_vertices);
+    glm::vec3* normals   = ARENA_PUSH_COUNT(gab->norm_arena, glm::vec3, num_vertices);
+    gvec2f* uvs          = ARENA_PUSH_ZERO_COUNT(gab->uv_arena, gvec2f, num_vertices);
     UNUSED_VAR(uvs);
-    u32* indices = ARENA_PUSH_COUNT(gab->indices_arena, u32, par_mesh->ntriangles * 3);
-
-    memcpy(positions, par_mesh->points, par_mesh->npoints * sizeof(*positions));
-    memcpy(normals, par_mesh->normals, par_mesh->npoints * sizeof(*normals));
-    memcpy(indices, par_mesh->triangles, par_mesh->ntriangles * 3 * sizeof(*indices));
+    u32* indices = ARENA_PUSH_COUNT(gab->indices_arena, u32, num_vertices);
+
+    const glm::vec3* points = (glm::vec3*)par_mesh->points;
+    for (int i = 0; i < num_vertices; i += 3) {
+        const glm::vec3 a = points[par_mesh->triangles[i + 0]];
+        const glm::vec3 b = points[par_mesh->triangles[i + 1]];
+        const glm::vec3 c = points[par_mesh->triangles[i + 2]];
+        const glm::vec3 n = glm::normalize(glm::cross(b - a, c - a));
+
+        positions[i + 0] = a;
+        positions[i + 1] = b;
+        positions[i + 2] = c;
+        normals[i + 0]   = n;
+        normals[i + 1]   = n;
+        normals[i + 2]   = n;
+        indices[i + 0]   = i + 0;
+        indices[i + 1]   = i + 1;
+        indices[i + 2]   = i + 2;
+    }
 
     par_shapes_free_mesh(par_mesh);
+}
+
+// ============================================================================
+// Simplification
+// ============================================================================
+// Quadric error metric edge collapse (Garland & Heckbert '97). Collapses are
+// half-edge: a vertex moves onto one of its neighbors, so the simplified indices
+// keep referencing the original vertex buffers and can share them with level 0.
+// Vertices with the same position (uv/normal seams) are welded and collapse
+// together. Each pass collapses an independent set of edges in order of cost,
+// passes repeat until the target is reached or nothing can collapse
+
+struct GeoQuadric {
+    f64 a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+};
+
+static void GeoQuadric_addPlane(GeoQuadric* q, glm::vec3 n, f64 d, f64 weight)
+{
+    f64 a = n.x, b = n.y, c = n.z;
+    q->a2 += weight * a * a;
+    q->ab += weight * a * b;
+    q->ac += weight * a * c;
+    q->ad += weight * a * d;
+    q->b2 += weight * b * b;
+    q->bc += weight * b * c;
+    q->bd += weight * b * d;
+    q->c2 += weight * c * c;
+    q->cd += weight * c * d;
+    q->d2 += weight * d * d;
+}
+
+static void GeoQuadric_add(GeoQuadric* q, const GeoQuadric* o)
+{
+    f64* dst       = (f64*)q;
+    const f64* src = (const f64*)o;
+    for (int i = 0; i < 10; i++) dst[i] += src[i];
+}
+
+static f64 GeoQuadric_error(const GeoQuadric* q, glm::vec3 p)
+{
+    f64 x = p.x, y = p.y, z = p.z;
+    f64 err = q->a2 * x * x + 2 * q->ab * x * y + 2 * q->ac * x * z + 2 * q->ad * x
+              + q->b2 * y * y + 2 * q->bc * y * z + 2 * q->bd * y + q->c2 * z * z
+              + 2 * q->cd * z + q->d2;
+    return err < 0 ? 0 : err;
+}
+
+struct GeoWeldKey {
+    f32 x, y, z;
+    u32 index;
+};
+
+static int GeoWeldKey_compare(const void* a, const void* b)
+{
+    const GeoWeldKey* ka = (const GeoWeldKey*)a;
+    const GeoWeldKey* kb = (const GeoWeldKey*)b;
+    if (ka->x != kb->x) return ka->x < kb->x ? -1 : 1;
+    if (ka->y != kb->y) return ka->y < kb->y ? -1 : 1;
+    if (ka->z != kb->z) return ka->z < kb->z ? -1 : 1;
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+static int GeoEdgeKey_compare(const void* a, const void* b)
+{
+    u64 ka = *(const u64*)a, kb = *(const u64*)b;
+    return ka < kb ? -1 : (ka > kb);
+}
+
+struct GeoCollapse {
+    u32 from, to;
+    f64 cost;
+};
+
+static int GeoCollapse_compare(const void* a, const void* b)
+{
+    f64 ca = ((const GeoCollapse*)a)->cost, cb = ((const GeoCollapse*)b)->cost;
+    return ca < cb ? -1 : (ca > cb);
+}
+
+static u64 GeoEdgeKey(u32 a, u32 b)
+{
+    return a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+}
+
+u32 Geometry_simplify(u32* dst, const u32* indices, u32 index_count,
+                      const f32* positions, u32 vertex_count, u32 target_index_count)
+{
+    index_count -= index_count % 3;
+    memcpy(dst, indices, index_count * sizeof(*indices));
+    if (index_count <= target_index_count || vertex_count == 0) return index_count;
+
+    const glm::vec3* pos = (const glm::vec3*)positions;
+    u32 tri_count        = index_count / 3;
+    const u32 NONE       = UINT32_MAX;
+
+    // weld vertices by position. remap[v] is the first vertex at v's position
+    u32* remap       = ALLOCATE_COUNT(u32, vertex_count);
+    GeoWeldKey* keys = ALLOCATE_COUNT(GeoWeldKey, vertex_count);
+    for (u32 i = 0; i < vertex_count; i++) {
+        keys[i] = { pos[i].x, pos[i].y, pos[i].z, i };
+    }
+    qsort(keys, vertex_count, sizeof(*keys), GeoWeldKey_compare);
+    for (u32 i = 0; i < vertex_count; i++) {
+        bool same = i > 0 && keys[i].x == keys[i - 1].x && keys[i].y == keys[i - 1].y
+                    && keys[i].z == keys[i - 1].z;
+        remap[keys[i].index] = same ? remap[keys[i - 1].index] : keys[i].index;
+    }
+    FREE_ARRAY(GeoWeldKey, keys, vertex_count);
+
+    u32* collapse_to   = ALLOCATE_COUNT(u32, vertex_count);
+    u8* locked         = ALLOCATE_COUNT(u8, vertex_count);
+    u32* adj_start     = ALLOCATE_COUNT(u32, vertex_count + 1);
+    u32* adj_tris      = ALLOCATE_COUNT(u32, index_count);
+    u64* edges         = ALLOCATE_COUNT(u64, index_count);
+    GeoCollapse* cands = ALLOCATE_COUNT(GeoCollapse, index_count);
+    GeoQuadric* quadrics = ALLOCATE_COUNT(GeoQuadric, vertex_count);
+    memset(quadrics, 0, sizeof(GeoQuadric) * vertex_count);
+
+    // area weighted face quadrics
+    for (u32 t = 0; t < tri_count; t++) {
+        u32 v[3] = { remap[dst[t * 3]], remap[dst[t * 3 + 1]], remap[dst[t * 3 + 2]] };
+        glm::vec3 n = glm::cross(pos[v[1]] - pos[v[0]], pos[v[2]] - pos[v[0]]);
+        f32 len     = glm::length(n);
+        if (len <= 0.0f) continue;
+        n /= len;
+        f64 d = -glm::dot(n, pos[v[0]]);
+        for (int k = 0; k < 3; k++) GeoQuadric_addPlane(&quadrics[v[k]], n, d, len);
+    }
+
+    // open borders get a heavily weighted plane perpendicular to their face,
+    // so they may slide along themselves but not shrink inwards
+    for (u32 t = 0; t < tri_count; t++) {
+        for (int k = 0; k < 3; k++) {
+            edges[t * 3 + k]
+              = GeoEdgeKey(remap[dst[t * 3 + k]], remap[dst[t * 3 + (k + 1) % 3]]);
+        }
+    }
+    qsort(edges, index_count, sizeof(*edges), GeoEdgeKey_compare);
+    for (u32 t = 0; t < tri_count; t++) {
+        u32 v[3] = { remap[dst[t * 3]], remap[dst[t * 3 + 1]], remap[dst[t * 3 + 2]] };
+        glm::vec3 face = glm::cross(pos[v[1]] - pos[v[0]], pos[v[2]] - pos[v[0]]);
+        if (glm::length(face) <= 0.0f) continue;
+        for (int k = 0; k < 3; k++) {
+            u32 a = v[k], b = v[(k + 1) % 3];
+            u64 key   = GeoEdgeKey(a, b);
+            u64* it   = (u64*)bsearch(&key, edges, index_count, sizeof(*edges),
+                                      GeoEdgeKey_compare);
+            bool open = (it == edges || it[-1] != key)
+                        && (it == edges + index_count - 1 || it[1] != key);
+            if (!open) continue;
+            glm::vec3 e = pos[b] - pos[a];
+            glm::vec3 n = glm::cross(e, face);
+            f32 len     = glm::length(n);
+            if (len <= 0.0f) continue;
+            n /= len;
+            f64 d      = -glm::dot(n, pos[a]);
+            f64 weight = 10.0 * glm::dot(e, e);
+            GeoQuadric_addPlane(&quadrics[a], n, d, weight);
+            GeoQuadric_addPlane(&quadrics[b], n, d, weight);
+        }
+    }
+
+    for (u32 i = 0; i < vertex_count; i++) collapse_to[i] = NONE;
+
+    u32 target_tri_count = target_index_count / 3;
+    while (tri_count > target_tri_count) {
+        u32 corner_count = tri_count * 3;
+
+        // unique edges of the welded mesh
+        for (u32 t = 0; t < tri_count; t++) {
+            for (int k = 0; k < 3; k++) {
+                edges[t * 3 + k]
+                  = GeoEdgeKey(remap[dst[t * 3 + k]], remap[dst[t * 3 + (k + 1) % 3]]);
+            }
+        }
+        qsort(edges, corner_count, sizeof(*edges), GeoEdgeKey_compare);
+
+        u32 cand_count = 0;
+        for (u32 i = 0; i < corner_count; i++) {
+            if (i > 0 && edges[i] == edges[i - 1]) continue;
+            u32 a = (u32)(edges[i] >> 32), b = (u32)(edges[i] & 0xFFFFFFFF);
+            GeoQuadric q = quadrics[a];
+            GeoQuadric_add(&q, &quadrics[b]);
+            f64 cost_ab         = GeoQuadric_error(&q, pos[b]); // a moves onto b
+            f64 cost_ba         = GeoQuadric_error(&q, pos[a]);
+            cands[cand_count++] = cost_ab <= cost_ba ? GeoCollapse{ a, b, cost_ab } :
+                                                        GeoCollapse{ b, a, cost_ba };
+        }
+        qsort(cands, cand_count, sizeof(*cands), GeoCollapse_compare);
+
+        // vertex -> triangle adjacency
+        memset(adj_start, 0, (vertex_count + 1) * sizeof(*adj_start));
+        for (u32 i = 0; i < corner_count; i++) adj_start[remap[dst[i]] + 1]++;
+        for (u32 i = 0; i < vertex_count; i++) adj_start[i + 1] += adj_start[i];
+        for (u32 i = 0; i < corner_count; i++) {
+            adj_tris[adj_start[remap[dst[i]]]++] = i / 3;
+        }
+        for (u32 i = vertex_count; i > 0; i--) adj_start[i] = adj_start[i - 1];
+        adj_start[0] = 0;
+
+        memset(locked, 0, vertex_count);
+        u32 removed = 0, collapsed = 0;
+        for (u32 c = 0; c < cand_count && tri_count - removed > target_tri_count; c++) {
+            u32 from = cands[c].from, to = cands[c].to;
+            if (locked[from] || locked[to]) continue;
+
+            // reject collapses that fold a triangle over
+            bool flips     = false;
+            u32 degenerate = 0;
+            for (u32 i = adj_start[from]; i < adj_start[from + 1] && !flips; i++) {
+                u32* tri = dst + adj_tris[i] * 3;
+                u32 v[3] = { remap[tri[0]], remap[tri[1]], remap[tri[2]] };
+                if (v[0] == to || v[1] == to || v[2] == to) {
+                    degenerate++;
+                    continue;
+                }
+                glm::vec3 p[3] = { pos[v[0]], pos[v[1]], pos[v[2]] };
+                glm::vec3 n0   = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; k++) {
+                    if (v[k] == from) p[k] = pos[to];
+                }
+                glm::vec3 n1 = glm::cross(p[1] - p[0], p[2] - p[0]);
+                flips = glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1);
+            }
+            if (flips) continue;
+
+            collapse_to[from] = to;
+            GeoQuadric_add(&quadrics[to], &quadrics[from]);
+            for (u32 i = adj_start[from]; i < adj_start[from + 1]; i++) {
+                u32* tri = dst + adj_tris[i] * 3;
+                for (int k = 0; k < 3; k++) locked[remap[tri[k]]] = 1;
+            }
+            locked[to] = 1;
+            removed += degenerate;
+            collapsed++;
+        }
+        if (collapsed == 0) break;
+
+        // apply, dropping triangles that became degenerate
+        u32 write = 0;
+        for (u32 t = 0; t < tri_count; t++) {
+            u32 tri[3];
+            for (int k = 0; k < 3; k++) {
+                u32 v  = dst[t * 3 + k];
+                u32 to = collapse_to[remap[v]];
+                tri[k] = (to == NONE) ? v : to;
+            }
+            u32 a = remap[tri[0]], b = remap[tri[1]], c = remap[tri[2]];
+            if (a == b || b == c || c == a) continue;
+            dst[write++] = tri[0];
+            dst[write++] = tri[1];
+            dst[write++] = tri[2];
+        }
+        tri_count = write / 3;
+        for (u32 i = 0; i < vertex_count; i++) collapse_to[i] = NONE;
+    }
+
+    FREE_ARRAY(u32, remap, vertex_count);
+    FREE_ARRAY(u32, collapse_to, vertex_count);
+    FREE_ARRAY(u8, locked, vertex_count);
+    FREE_ARRAY(u32, adj_start, vertex_count + 1);
+    FREE_ARRAY(u32, adj_tris, index_count);
+    FREE_ARRAY(u64, edges, index_count);
+    FREE_ARRAY(GeoCollapse, cands, index_count);
+    FREE_ARRAY(GeoQuadric, quadrics, vertex_count);
+
+    return tri_count * 3;
+}
+
+
+// ============================================================================
+// Optimization
+// ============================================================================
+// Reorders indexed triangle lists for the GPU. Vertices that are bitwise equal in
+// every attribute are welded, triangles are ordered for the post-transform vertex
+// cache (Tipsify, Sander et al. '07), runs of cache-friendly triangles are sorted
+// from the outside in to reduce overdraw, and vertices are renumbered in the order
+// they are first fetched
+
+f32 Geometry_acmr(const u32* indices, u32 index_count, u32 vertex_count,
+                  u32 cache_size)
+{
+    u32 tri_count = index_count / 3;
+    if (tri_count == 0 || vertex_count == 0) return 0.0f;
+
+    // FIFO cache: a vertex is resident until cache_size more vertices are loaded
+    u32* timestamps = ALLOCATE_COUNT(u32, vertex_count);
+    memset(timestamps, 0, sizeof(u32) * vertex_count);
+    u32 time   = cache_size + 1;
+    u32 misses = 0;
+    for (u32 i = 0; i < tri_count * 3; i++) {
+        u32 v = indices[i];
+        if (time - timestamps[v] > cache_size) {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+    FREE_ARRAY(u32, timestamps, vertex_count);
+    return (f32)misses / tri_count;
+}
+
+static u32 Geometry_hashVertex(const u32* const* attributes, const int* num_components,
+                               int attribute_count, u32 v)
+{
+    u32 hash = 2166136261u; // FNV-1a
+    for (int a = 0; a < attribute_count; a++) {
+        const u32* data = attributes[a] + (u64)v * num_components[a];
+        for (int c = 0; c < num_components[a]; c++) {
+            hash ^= data[c];
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+static bool Geometry_equalVertex(const u32* const* attributes,
+                                 const int* num_components, int attribute_count, u32 a,
+                                 u32 b)
+{
+    for (int i = 0; i < attribute_count; i++) {
+        u64 n = num_components[i];
+        if (memcmp(attributes[i] + a * n, attributes[i] + b * n, n * sizeof(u32)))
+            return false;
+    }
+    return true;
+}
+
+u32 Geometry_weldVertices(u32* remap, const u32* const* attributes,
+                          const int* num_components, int attribute_count,
+                          u32 vertex_count)
+{
+    const u32 NONE = UINT32_MAX;
+
+    // open addressing table of the first vertex seen with each value
+    u32 table_size = 1;
+    while (table_size < vertex_count * 2) table_size <<= 1;
+    u32* table = ALLOCATE_COUNT(u32, table_size);
+    memset(table, 0xFF, sizeof(u32) * table_size);
+
+    u32 unique_count = 0;
+    for (u32 v = 0; v < vertex_count; v++) {
+        u32 slot = Geometry_hashVertex(attributes, num_components, attribute_count, v)
+                   & (table_size - 1);
+        while (table[slot] != NONE
+               && !Geometry_equalVertex(attributes, num_components, attribute_count,
+                                        table[slot], v)) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        if (table[slot] == NONE) {
+            table[slot] = v;
+            remap[v]    = unique_count++;
+        } else {
+            remap[v] = remap[table[slot]];
+        }
+    }
+
+    FREE_ARRAY(u32, table, table_size);
+    return unique_count;
+}
+
+void Geometry_optimizeVertexCache(u32* dst, const u32* indices, u32 index_count,
+                                  u32 vertex_count, u32 cache_size)
+{
+    u32 tri_count = index_count / 3;
+    if (tri_count == 0) return;
+    const u32 NONE = UINT32_MAX;
+
+    u32* live       = ALLOCATE_COUNT(u32, vertex_count); // triangles left to emit
+    u32* adj_start  = ALLOCATE_COUNT(u32, vertex_count + 1);
+    u32* adj_tris   = ALLOCATE_COUNT(u32, tri_count * 3);
+    u32* timestamps = ALLOCATE_COUNT(u32, vertex_count);
+    u32* dead_end   = ALLOCATE_COUNT(u32, tri_count * 3);
+    u32* candidates = ALLOCATE_COUNT(u32, tri_count * 3);
+    u8* emitted     = ALLOCATE_COUNT(u8, tri_count);
+
+    // vertex -> triangle adjacency
+    memset(live, 0, sizeof(u32) * vertex_count);
+    for (u32 i = 0; i < tri_count * 3; i++) live[indices[i]]++;
+    adj_start[0] = 0;
+    for (u32 v = 0; v < vertex_count; v++) {
+        adj_start[v + 1] = adj_start[v] + live[v];
+        timestamps[v]    = adj_start[v];
+    }
+    for (u32 t = 0; t < tri_count; t++) {
+        for (int k = 0; k < 3; k++) adj_tris[timestamps[indices[t * 3 + k]]++] = t;
+    }
+    memset(timestamps, 0, sizeof(u32) * vertex_count);
+    memset(emitted, 0, tri_count);
+
+    u32 time           = cache_size + 1;
+    u32 dead_end_count = 0;
+    u32 cursor         = 0;
+    u32 out            = 0;
+    u32 fan            = indices[0];
+    while (fan != NONE) {
+        // emit every remaining triangle around the fanning vertex
+        u32 candidate_count = 0;
+        for (u32 a = adj_start[fan]; a < adj_start[fan + 1]; a++) {
+            u32 t = adj_tris[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                u32 v                         = indices[t * 3 + k];
+                dst[out++]                    = v;
+                dead_end[dead_end_count++]    = v;
+                candidates[candidate_count++] = v;
+                live[v]--;
+                if (time - timestamps[v] > cache_size) timestamps[v] = time++;
+            }
+        }
+
+        // fan around the oldest neighbor that stays cached while its remaining
+        // triangles are emitted
+        fan               = NONE;
+        i64 best_priority = -1;
+        for (u32 c = 0; c < candidate_count; c++) {
+            u32 v = candidates[c];
+            if (live[v] == 0) continue;
+            i64 priority = 0;
+            if (time - timestamps[v] + 2 * live[v] <= cache_size) {
+                priority = time - timestamps[v];
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                fan           = v;
+            }
+        }
+
+        // dead end: back up to a recently emitted vertex, else the next in order
+        while (fan == NONE && dead_end_count > 0) {
+            u32 v = dead_end[--dead_end_count];
+            if (live[v] > 0) fan = v;
+        }
+        while (fan == NONE && cursor < vertex_count) {
+            if (live[cursor] > 0) fan = cursor;
+            cursor++;
+        }
+    }
+    ASSERT(out == tri_count * 3);
+
+    FREE_ARRAY(u32, live, vertex_count);
+    FREE_ARRAY(u32, adj_start, vertex_count + 1);
+    FREE_ARRAY(u32, adj_tris, tri_count * 3);
+    FREE_ARRAY(u32, timestamps, vertex_count);
+    FREE_ARRAY(u32, dead_end, tri_count * 3);
+    FREE_ARRAY(u32, candidates, tri_count * 3);
+    FREE_ARRAY(u8, emitted, tri_count);
+}
+
+struct GeoCluster {
+    f32 sort_key;
+    u32 index;
+};
+
+static int GeoCluster_compare(const void* a, const void* b)
+{
+    const GeoCluster* ca = (const GeoCluster*)a;
+    const GeoCluster* cb = (const GeoCluster*)b;
+    if (ca->sort_key != cb->sort_key) return ca->sort_key > cb->sort_key ? -1 : 1;
+    return ca->index < cb->index ? -1 : (ca->index > cb->index);
+}
+
+void Geometry_optimizeOverdraw(u32* dst, const u32* indices, u32 index_count,
+                               const f32* positions, u32 vertex_count, u32 cache_size)
+{
+    u32 tri_count = index_count / 3;
+    if (tri_count == 0) return;
+    const glm::vec3* pos = (const glm::vec3*)positions;
+
+    // split wherever the cache goes cold, i.e. a triangle misses on all its
+    // vertices. Moving whole clusters keeps the vertex cache order within them
+    u32* timestamps    = ALLOCATE_COUNT(u32, vertex_count);
+    u32* cluster_start = ALLOCATE_COUNT(u32, tri_count + 1);
+    memset(timestamps, 0, sizeof(u32) * vertex_count);
+    u32 cluster_count = 0;
+    u32 time          = cache_size + 1;
+    for (u32 t = 0; t < tri_count; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            u32 v = indices[t * 3 + k];
+            if (time - timestamps[v] > cache_size) {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) cluster_start[cluster_count++] = t;
+    }
+    cluster_start[cluster_count] = tri_count;
+
+    // area weighted centroids and normals
+    glm::vec3 mesh_centroid(0.0f);
+    f32 mesh_area = 0.0f;
+    for (u32 t = 0; t < tri_count; t++) {
+        glm::vec3 a = pos[indices[t * 3]], b = pos[indices[t * 3 + 1]],
+                  c = pos[indices[t * 3 + 2]];
+        f32 area    = glm::length(glm::cross(b - a, c - a));
+        mesh_centroid += (a + b + c) * area;
+        mesh_area += area;
+    }
+    if (mesh_area > 0.0f) mesh_centroid /= 3.0f * mesh_area;
+
+    // clusters facing away from the center are drawn first, they are the most
+    // likely to occlude the rest of the mesh
+    GeoCluster* clusters = ALLOCATE_COUNT(GeoCluster, cluster_count);
+    for (u32 i = 0; i < cluster_count; i++) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        f32 area = 0.0f;
+        for (u32 t = cluster_start[i]; t < cluster_start[i + 1]; t++) {
+            glm::vec3 a = pos[indices[t * 3]], b = pos[indices[t * 3 + 1]],
+                      c = pos[indices[t * 3 + 2]];
+            glm::vec3 n = glm::cross(b - a, c - a);
+            f32 len     = glm::length(n);
+            centroid += (a + b + c) * len;
+            normal += n;
+            area += len;
+        }
+        f32 normal_len = glm::length(normal);
+        clusters[i]    = { 0.0f, i };
+        if (area > 0.0f && normal_len > 0.0f) {
+            centroid /= 3.0f * area;
+            clusters[i].sort_key
+              = glm::dot(centroid - mesh_centroid, normal / normal_len);
+        }
+    }
+    qsort(clusters, cluster_count, sizeof(*clusters), GeoCluster_compare);
+
+    u32 out = 0;
+    for (u32 i = 0; i < cluster_count; i++) {
+        u32 start = cluster_start[clusters[i].index];
+        u32 count = cluster_start[clusters[i].index + 1] - start;
+        memcpy(dst + out, indices + start * 3, count * 3 * sizeof(u32));
+        out += count * 3;
+    }
+
+    FREE_ARRAY(u32, timestamps, vertex_count);
+    FREE_ARRAY(u32, cluster_start, tri_count + 1);
+    FREE_ARRAY(GeoCluster, clusters, cluster_count);
+}
+
+u32 Geometry_optimizeVertexFetch(u32* remap, u32* indices, u32 index_count,
+                                 u32 vertex_count)
+{
+    memset(remap, 0xFF, sizeof(u32) * vertex_count);
+    u32 used_count = 0;
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = indices[i];
+        if (remap[v] == UINT32_MAX) remap[v] = used_count++;
+        indices[i] = remap[v];
+    }
+    return used_count;
+}
+
+// ============================================================================
+// Topology
+// ============================================================================
+
+static u32 Geometry_corner(const u32* indices, u32 i)
+{
+    return indices ? indices[i] : i;
+}
+
+// false if face f references a vertex past vertex_count
+static bool Geometry_faceCorners(const u32* indices, u32 f, u32 vertex_count,
+                                 u32 corners[3])
+{
+    for (int k = 0; k < 3; k++) {
+        corners[k] = Geometry_corner(indices, f * 3 + k);
+        if (corners[k] >= vertex_count) return false;
+    }
+    return true;
+}
+
+void GeometryTopology_free(GeometryTopology* topo)
+{
+    FREE_ARRAY(u32, topo->offsets, topo->vertex_count + 1);
+    FREE_ARRAY(u32, topo->faces, topo->index_count);
+    *topo = {};
+}
+
+void GeometryTopology_build(GeometryTopology* topo, const u32* indices, u32 index_count,
+                            u32 vertex_count)
+{
+    GeometryTopology_free(topo);
+    index_count -= index_count % 3;
+
+    topo->vertex_count = vertex_count;
+    topo->index_count  = index_count;
+    topo->offsets      = ALLOCATE_COUNT(u32, vertex_count + 1);
+    topo->faces        = ALLOCATE_COUNT(u32, index_count);
+
+    // counting sort of the corners by vertex. After the fill pass offsets[v] has
+    // advanced to the start of v + 1, so shift back by one
+    memset(topo->offsets, 0, sizeof(u32) * (vertex_count + 1));
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = Geometry_corner(indices, i);
+        if (v < vertex_count) topo->offsets[v + 1]++;
+    }
+    for (u32 v = 0; v < vertex_count; v++) topo->offsets[v + 1] += topo->offsets[v];
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = Geometry_corner(indices, i);
+        if (v < vertex_count) topo->faces[topo->offsets[v]++] = i / 3;
+    }
+    for (u32 v = vertex_count; v > 0; v--) topo->offsets[v] = topo->offsets[v - 1];
+    topo->offsets[0] = 0;
+}
+
+u32 Geometry_buildEdges(u32* dst, u32* tri_edge_end, const u32* indices,
+                        u32 index_count)
+{
+    const u32 tri_count = index_count / 3;
+
+    // open addressing set of (min, max) vertex pairs, kept at most half full
+    u64 capacity = 16;
+    while (capacity < (u64)tri_count * 3 * 2) capacity <<= 1;
+    u64* table = ALLOCATE_COUNT(u64, capacity);
+    memset(table, 0xFF, sizeof(u64) * capacity);
+
+    u32 edge_count = 0;
+    for (u32 f = 0; f < tri_count; f++) {
+        for (u32 k = 0; k < 3; k++) {
+            u32 a   = Geometry_corner(indices, f * 3 + k);
+            u32 b   = Geometry_corner(indices, f * 3 + (k + 1) % 3);
+            u64 key = ((u64)MIN(a, b) << 32) | MAX(a, b);
+
+            u64 slot = ((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+            while (table[slot] != UINT64_MAX && table[slot] != key) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (table[slot] == key) continue;
+
+            table[slot]             = key;
+            dst[edge_count * 2]     = a;
+            dst[edge_count * 2 + 1] = b;
+            edge_count++;
+        }
+        tri_edge_end[f] = edge_count;
+    }
+
+    FREE_ARRAY(u64, table, capacity);
+    return edge_count;
+}
+
+u32 Geometry_movedNeighborhood(u32* dst, const GeometryTopology* topo,
+                               const u32* indices, const f32* positions,
+                               const f32* prev_positions)
+{
+    const u32 vertex_count = topo->vertex_count;
+    u8* marked             = ALLOCATE_COUNT(u8, vertex_count);
+    memset(marked, 0, vertex_count);
+
+    u32 count = 0;
+    for (u32 v = 0; v < vertex_count; v++) {
+        if (memcmp(positions + v * 3, prev_positions + v * 3, 3 * sizeof(f32)) == 0)
+            continue;
+
+        if (!marked[v]) {
+            marked[v]    = 1;
+            dst[count++] = v;
+        }
+        for (u32 a = topo->offsets[v]; a < topo->offsets[v + 1]; a++) {
+            u32 corners[3];
+            if (!Geometry_faceCorners(indices, topo->faces[a], vertex_count, corners))
+                continue;
+            for (int k = 0; k < 3; k++) {
+                if (marked[corners[k]]) continue;
+                marked[corners[k]] = 1;
+                dst[count++]       = corners[k];
+            }
+        }
+    }
+
+    FREE_ARRAY(u8, marked, vertex_count);
+    return count;
+}
+
+// per-vertex gathers over the adjacency, so vertices are independent and large
+// meshes split across the job pool like the builders
+struct GeometryVertexRows {
+    f32* out;
+    const glm::vec3* positions;
+    const glm::vec3* normals;
+    const glm::vec2* uvs;
+    const u32* indices;
+    const GeometryTopology* topo;
+    const u32* vertices; // NULL for all
+};
+
+static void Geometry_normalRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometryVertexRows* r        = (GeometryVertexRows*)udata;
+    const GeometryTopology* topo = r->topo;
+    const u32 vertex_count       = topo->vertex_count;
+    glm::vec3* normals           = (glm::vec3*)r->out;
+
+    for (u32 i = row_begin; i < row_end; i++) {
+        const u32 v = r->vertices ? r->vertices[i] : i;
+
+        // the cross product's length is twice the face area
+        glm::vec3 n = glm::vec3(0.0f);
+        for (u32 a = topo->offsets[v]; a < topo->offsets[v + 1]; a++) {
+            u32 c[3];
+            if (!Geometry_faceCorners(r->indices, topo->faces[a], vertex_count, c))
+                continue;
+            const glm::vec3 p0 = r->positions[c[0]];
+            n += glm::cross(r->positions[c[1]] - p0, r->positions[c[2]] - p0);
+        }
+
+        const f32 len2 = glm::dot(n, n);
+        normals[v]     = len2 > 0.0f ? n / glm::sqrt(len2) : n;
+    }
+}
+
+void Geometry_computeNormals(f32* normals, const f32* positions, const u32* indices,
+                             const GeometryTopology* topo, const u32* vertices,
+                             u32 count)
+{
+    GeometryVertexRows rows = {};
+    rows.out                = normals;
+    rows.positions          = (const glm::vec3*)positions;
+    rows.indices            = indices;
+    rows.topo               = topo;
+    rows.vertices           = vertices;
+    Geometry_forRows(Geometry_normalRows, &rows, count, 1);
+}
+
+static glm::vec3 Geometry_projectNormalized(glm::vec3 v, glm::vec3 n)
+{
+    v -= glm::dot(n, v) * n;
+    const f32 len2 = glm::dot(v, v);
+    return len2 > 0.0f ? v / glm::sqrt(len2) : v;
+}
+
+static void Geometry_tangentRows(void* udata, u32 row_begin, u32 row_end)
+{
+    GeometryVertexRows* r        = (GeometryVertexRows*)udata;
+    const GeometryTopology* topo = r->topo;
+    const u32 vertex_count       = topo->vertex_count;
+    glm::vec4* tangents          = (glm::vec4*)r->out;
+
+    for (u32 i = row_begin; i < row_end; i++) {
+        const u32 v       = r->vertices ? r->vertices[i] : i;
+        const glm::vec3 n = r->normals[v];
+
+        glm::vec3 tangent = glm::vec3(0.0f);
+        f32 orientation   = 0.0f;
+        for (u32 a = topo->offsets[v]; a < topo->offsets[v + 1]; a++) {
+            u32 c[3];
+            if (!Geometry_faceCorners(r->indices, topo->faces[a], vertex_count, c))
+                continue;
+
+            // rotate the corners so v comes first
+            int k = (c[0] == v) ? 0 : (c[1] == v) ? 1 : 2;
+
+            const u32 v1 = c[(k + 1) % 3];
+            const u32 v2 = c[(k + 2) % 3];
+
+            const glm::vec3 d1  = r->positions[v1] - r->positions[v];
+            const glm::vec3 d2  = r->positions[v2] - r->positions[v];
+            const glm::vec2 t21 = r->uvs[v1] - r->uvs[v];
+            const glm::vec2 t31 = r->uvs[v2] - r->uvs[v];
+
+            // twice the signed uv area, its sign is the face orientation
+            const f32 area = t21.x * t31.y - t21.y * t31.x;
+            if (area == 0.0f) continue;
+            const f32 orient = area > 0.0f ? 1.0f : -1.0f;
+
+            // face tangent, projected into the plane of the vertex normal
+            const glm::vec3 os           = orient * (t31.y * d1 - t21.y * d2);
+            const glm::vec3 face_tangent = Geometry_projectNormalized(os, n);
+
+            // weighted by the angle of this corner, measured in the same plane
+            const glm::vec3 e1 = Geometry_projectNormalized(d1, n);
+            const glm::vec3 e2 = Geometry_projectNormalized(d2, n);
+            const f32 angle    = glm::acos(glm::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+
+            tangent     += angle * face_tangent;
+            orientation += angle * orient;
+        }
+
+        const f32 len2 = glm::dot(tangent, tangent);
+        if (len2 > 0.0f) {
+            tangent /= glm::sqrt(len2);
+        } else {
+            // no uv gradient around this vertex, any vector orthogonal to n will do
+            glm::vec3 axis = glm::vec3(0, 1, 0);
+            if (glm::abs(n.x) < 0.9f) axis = glm::vec3(1, 0, 0);
+            tangent = Geometry_projectNormalized(axis, n);
+        }
+        tangents[v] = glm::vec4(tangent, orientation < 0.0f ? -1.0f : 1.0f);
+    }
+}
+
+void Geometry_computeTangents(f32* tangents, const f32* positions, const f32* normals,
+                              const f32* uvs, const u32* indices,
+                              const GeometryTopology* topo, const u32* vertices,
+                              u32 count)
+{
+    GeometryVertexRows rows = {};
+    rows.out                = tangents;
+    rows.positions          = (const glm::vec3*)positions;
+    rows.normals            = (const glm::vec3*)normals;
+    rows.uvs                = (const glm::vec2*)uvs;
+    rows.indices            = indices;
+    rows.topo               = topo;
+    rows.vertices           = vertices;
+    Geometry_forRows(Geometry_tangentRows, &rows, count, 1);
 }
\ No newline at end of file
@@ -120,6 +120,10 @@ struct GeometryArenaBuilder {
     Arena* indices_arena;
 };
 
+// sphere, torus, cylinder and knot builders split grids with at least this many
+// vertices across the job pool
+#define GEOMETRY_PARALLEL_MIN_VERTICES (1 << 15)
+
 void Geometry_buildPlane(GeometryArenaBuilder* builder, PlaneParams* params);
 void Geometry_buildSphere(GeometryArenaBuilder* builder, SphereParams* params);
 void Geometry_buildSuzanne(GeometryArenaBuilder* builder);
@@ -130,3 +134,89 @@ void Geometry_buildCylinder(GeometryArenaBuilder* gab, CylinderParams* params);
 void Geometry_buildKnot(GeometryArenaBuilder* gab, KnotParams* params);
 void Geometry_buildPolygon(GeometryArenaBuilder* gab, PolygonParams* params);
 void Geometry_buildPolyhedron(GeometryArenaBuilder* gab, PolyhedronType type);
+
+// quadric error edge-collapse simplification of an indexed triangle list.
+// positions are xyz floats. Writes at most index_count indices referencing the
+// original vertices to dst, returns how many were written. Stops early if no
+// more edges can be collapsed without folding triangles over
+u32 Geometry_simplify(u32* dst, const u32* indices, u32 index_count,
+                      const f32* positions, u32 vertex_count, u32 target_index_count);
+
+
+// vertex cache optimization. The cache size is that of the FIFO modelled when
+// reordering and when measuring ACMR
+#define GEOMETRY_VERTEX_CACHE_SIZE 16
+
+// average cache miss ratio: vertices transformed per triangle with a FIFO
+// post-transform cache. 3 is the worst case, ~0.5 the best for large meshes
+f32 Geometry_acmr(const u32* indices, u32 index_count, u32 vertex_count,
+                  u32 cache_size);
+// welds vertices that are bitwise equal in every attribute. attributes[i] holds
+// vertex_count * num_components[i] 4-byte values. Writes remap[old] = new, numbered
+// in order of first occurrence (so remap[v] <= v), returns the unique vertex count
+u32 Geometry_weldVertices(u32* remap, const u32* const* attributes,
+                          const int* num_components, int attribute_count,
+                          u32 vertex_count);
+// reorders triangles for the post-transform vertex cache (Tipsify). dst must not
+// alias indices
+void Geometry_optimizeVertexCache(u32* dst, const u32* indices, u32 index_count,
+                                  u32 vertex_count, u32 cache_size);
+// reorders runs of cache-optimized triangles so outward facing runs draw first.
+// positions are xyz floats. dst must not alias indices
+void Geometry_optimizeOverdraw(u32* dst, const u32* indices, u32 index_count,
+                               const f32* positions, u32 vertex_count, u32 cache_size);
+// renumbers vertices in the order indices first use them, rewriting indices in place.
+// Writes remap[old] = new, UINT32_MAX for unused vertices. Returns the used count
+u32 Geometry_optimizeVertexFetch(u32* remap, u32* indices, u32 index_count,
+                                 u32 vertex_count);
+
+// ============================================================================
+// Topology
+// ============================================================================
+// For the functions below, indices is a triangle list. NULL indices means
+// non-indexed triangles, vertex 3f + k is corner k of face f
+
+// vertex -> face adjacency in CSR form: the faces around vertex v are
+// faces[offsets[v] .. offsets[v + 1]). Only depends on the index buffer, so it is
+// built once and reused while only vertex data changes
+struct GeometryTopology {
+    u32 vertex_count;
+    u32 index_count;
+    u32 index_version; // set by the owner, to tell when the index buffer changed
+    u32* offsets;   // vertex_count + 1
+    u32* faces;     // index_count
+};
+
+void GeometryTopology_build(GeometryTopology* topo, const u32* indices, u32 index_count,
+                            u32 vertex_count);
+void GeometryTopology_free(GeometryTopology* topo);
+
+// unique edges of a triangle list as line list indices, in the order faces first
+// use them. dst holds up to index_count * 2 indices. tri_edge_end[f] is the number
+// of edges used by faces 0..f, so the first n faces draw exactly the first
+// tri_edge_end[n - 1] edges. Returns the edge count
+u32 Geometry_buildEdges(u32* dst, u32* tri_edge_end, const u32* indices,
+                        u32 index_count);
+
+// vertices whose normals and tangents depend on a vertex that moved between
+// prev_positions and positions (xyz floats): every vertex sharing a face with one.
+// dst holds up to vertex_count entries. Returns the count written
+u32 Geometry_movedNeighborhood(u32* dst, const GeometryTopology* topo,
+                               const u32* indices, const f32* positions,
+                               const f32* prev_positions);
+
+// smooth normals, summing the area weighted normals of the faces around each
+// vertex. Only the count vertices listed in vertices are written, or all of them
+// if vertices is NULL
+void Geometry_computeNormals(f32* normals, const f32* positions, const u32* indices,
+                             const GeometryTopology* topo, const u32* vertices,
+                             u32 count);
+
+// per-vertex tangents, xyz and the bitangent sign in w, following the MikkTSpace
+// conventions: face tangents are projected into the plane of the vertex normal,
+// weighted by the corner angle, and bitangent = w * cross(normal, tangent).
+// vertices and count as in Geometry_computeNormals
+void Geometry_computeTangents(f32* tangents, const f32* positions, const f32* normals,
+                              const f32* uvs, const u32* indices,
+                              const GeometryTopology* topo, const u32* vertices,
+                              u32 count);
\ No newline at end of file
@@ -167,6 +167,7 @@ static void on_device_error(WGPUErrorType type, char const* message,
                             void* /* pUserData */)
 {
     log_error("Uncaptured device error: type %d (%s)", type, message);
+    log_flush();        // the error above is still queued on the async log ring
     exit(EXIT_FAILURE); // intentionally crash here, even in release mode, so we can see
                         // shader compilation errors
 };
@@ -321,22 +322,40 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
     logWGPULimits(&context->limits);
 
     requiredLimits.limits = context->limits;
+#endif
 
     // clang-format off
-    WGPUFeatureName requiredFeatures[] = {
-        (WGPUFeatureName)WGPUNativeFeature_VertexWritableStorage,
-        // (WGPUFeatureName) WGPUNativeFeature_TextureAdapterSpecificFormatFeatures,  // allows passing 32-bit float textures to texture_2d<f32> in shaders
+    WGPUFeatureName requiredFeatures[8] = {};
+    u32 requiredFeaturesCount = 0;
+#ifdef WEBGPU_BACKEND_WGPU
+    requiredFeatures[requiredFeaturesCount++] = (WGPUFeatureName)WGPUNativeFeature_VertexWritableStorage;
+    // requiredFeatures[requiredFeaturesCount++] = (WGPUFeatureName) WGPUNativeFeature_TextureAdapterSpecificFormatFeatures,  // allows passing 32-bit float textures to texture_2d<f32> in shaders
 
-        // enabling this feature still doesn't work
-        WGPUFeatureName_Float32Filterable // needed to sample 32-bit float textures in shaders
-    };
-    // clang-format on
-    const u32 requiredFeaturesCount = ARRAY_LENGTH(requiredFeatures);
-    log_trace("required features: %d", ARRAY_LENGTH(requiredFeatures));
-#else
-    const u32 requiredFeaturesCount   = 0;
-    WGPUFeatureName* requiredFeatures = NULL;
+    // enabling this feature still doesn't work
+    requiredFeatures[requiredFeaturesCount++] = WGPUFeatureName_Float32Filterable; // needed to sample 32-bit float textures in shaders
 #endif
+    // clang-format on
+
+    // compressed texture formats, only requested when the adapter has them.
+    // Loading a texture in an unsupported format fails with a warning
+    context->texture_compression_bc
+      = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionBC);
+    context->texture_compression_etc2
+      = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionETC2);
+    context->texture_compression_astc
+      = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionASTC);
+    if (context->texture_compression_bc)
+        requiredFeatures[requiredFeaturesCount++] = WGPUFeatureName_TextureCompressionBC;
+    if (context->texture_compression_etc2)
+        requiredFeatures[requiredFeaturesCount++]
+          = WGPUFeatureName_TextureCompressionETC2;
+    if (context->texture_compression_astc)
+        requiredFeatures[requiredFeaturesCount++]
+          = WGPUFeatureName_TextureCompressionASTC;
+    log_info("Texture compression support: BC %d, ETC2 %d, ASTC %d",
+             context->texture_compression_bc, context->texture_compression_etc2,
+             context->texture_compression_astc);
+    log_trace("required features: %d", requiredFeaturesCount);
 
     // see your machine's supported features here: https://webgpureport.org/
     WGPUDeviceDescriptor deviceDescriptor = {};
@@ -406,6 +425,7 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
 
     // init mip map generator
     MipMapGenerator_init(context);
+    HiZGenerator_init(context);
 
     { // create default resources
         WGPUSamplerDescriptor samplerDesc = {};
@@ -438,6 +458,30 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
         desc.label = "Sentinel Dirlight Depth2DArray";
         context->sentinel_dirlight_depth_2d_array
           = wgpuDeviceCreateTexture(context->device, &desc);
+
+        desc.label = "Sentinel Pointlight Depth2DArray";
+        context->sentinel_pointlight_depth_2d_array
+          = wgpuDeviceCreateTexture(context->device, &desc);
+
+        // zeroed, i.e. one cluster with no lights
+        WGPUBufferDescriptor buffer_desc = {};
+        buffer_desc.label                = "Sentinel Light Cluster Buffer";
+        buffer_desc.usage                = WGPUBufferUsage_Storage;
+        buffer_desc.size                 = 4 * sizeof(u32);
+        context->sentinel_light_cluster_buffer
+          = wgpuDeviceCreateBuffer(context->device, &buffer_desc);
+
+        // 1x1 pyramid for gpu culled passes that don't occlusion cull
+        desc.label  = "Sentinel Hi-Z Texture";
+        desc.size   = { 1, 1, 1 };
+        desc.format = WGPUTextureFormat_R32Float;
+        desc.usage  = WGPUTextureUsage_TextureBinding;
+        context->sentinel_hiz_texture = wgpuDeviceCreateTexture(context->device, &desc);
+
+        context->light_cluster_shader_module = G_createShaderModule(
+          context, light_cluster_shader_string, "light cluster shader");
+        context->instance_cull_shader_module = G_createShaderModule(
+          context, instance_cull_shader_string, "instance cull shader");
     }
 
     return true;
@@ -534,6 +578,14 @@ void GraphicsContext::release(GraphicsContext* ctx)
 {
     // mip map gen
     MipMapGenerator_release();
+    HiZGenerator_release();
+    EquirectToCubemap_release();
+    YUVToRGBA_release();
+
+    WGPU_RELEASE_RESOURCE(ShaderModule, ctx->light_cluster_shader_module);
+    WGPU_RELEASE_RESOURCE(ShaderModule, ctx->instance_cull_shader_module);
+    WGPU_RELEASE_RESOURCE(Buffer, ctx->sentinel_light_cluster_buffer);
+    WGPU_RELEASE_RESOURCE(Texture, ctx->sentinel_hiz_texture);
 
     wgpuSurfaceUnconfigure(ctx->surface);
     wgpuSurfaceRelease(ctx->surface);
@@ -797,9 +849,86 @@ int G_bytesPerTexel(WGPUTextureFormat format)
     return 0;
 }
 
+bool G_formatBlockInfo(WGPUTextureFormat format, G_FormatBlockInfo* info)
+{
+    switch (format) {
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_RGBA16Float:
+        case WGPUTextureFormat_RGBA32Float:
+        case WGPUTextureFormat_R32Float:
+            *info = { 1, 1, (u32)G_bytesPerTexel(format) };
+            return true;
+        case WGPUTextureFormat_BC1RGBAUnorm:
+        case WGPUTextureFormat_BC4RUnorm:
+        case WGPUTextureFormat_BC4RSnorm:
+        case WGPUTextureFormat_ETC2RGB8Unorm:
+        case WGPUTextureFormat_ETC2RGB8A1Unorm:
+        case WGPUTextureFormat_EACR11Unorm:
+        case WGPUTextureFormat_EACR11Snorm: *info = { 4, 4, 8 }; return true;
+        case WGPUTextureFormat_BC2RGBAUnorm:
+        case WGPUTextureFormat_BC3RGBAUnorm:
+        case WGPUTextureFormat_BC5RGUnorm:
+        case WGPUTextureFormat_BC5RGSnorm:
+        case WGPUTextureFormat_BC6HRGBUfloat:
+        case WGPUTextureFormat_BC6HRGBFloat:
+        case WGPUTextureFormat_BC7RGBAUnorm:
+        case WGPUTextureFormat_ETC2RGBA8Unorm:
+        case WGPUTextureFormat_EACRG11Unorm:
+        case WGPUTextureFormat_EACRG11Snorm:
+        case WGPUTextureFormat_ASTC4x4Unorm: *info = { 4, 4, 16 }; return true;
+        case WGPUTextureFormat_ASTC5x4Unorm: *info = { 5, 4, 16 }; return true;
+        case WGPUTextureFormat_ASTC5x5Unorm: *info = { 5, 5, 16 }; return true;
+        case WGPUTextureFormat_ASTC6x5Unorm: *info = { 6, 5, 16 }; return true;
+        case WGPUTextureFormat_ASTC6x6Unorm: *info = { 6, 6, 16 }; return true;
+        case WGPUTextureFormat_ASTC8x5Unorm: *info = { 8, 5, 16 }; return true;
+        case WGPUTextureFormat_ASTC8x6Unorm: *info = { 8, 6, 16 }; return true;
+        case WGPUTextureFormat_ASTC8x8Unorm: *info = { 8, 8, 16 }; return true;
+        case WGPUTextureFormat_ASTC10x5Unorm: *info = { 10, 5, 16 }; return true;
+        case WGPUTextureFormat_ASTC10x6Unorm: *info = { 10, 6, 16 }; return true;
+        case WGPUTextureFormat_ASTC10x8Unorm: *info = { 10, 8, 16 }; return true;
+        case WGPUTextureFormat_ASTC10x10Unorm: *info = { 10, 10, 16 }; return true;
+        case WGPUTextureFormat_ASTC12x10Unorm: *info = { 12, 10, 16 }; return true;
+        case WGPUTextureFormat_ASTC12x12Unorm: *info = { 12, 12, 16 }; return true;
+        default: return false;
+    }
+}
+
+bool G_isCompressedFormat(WGPUTextureFormat format)
+{
+    G_FormatBlockInfo info = {};
+    return G_formatBlockInfo(format, &info) && info.width > 1;
+}
+
+bool G_isFormatSupported(GraphicsContext* gctx, WGPUTextureFormat format)
+{
+    if (format >= WGPUTextureFormat_BC1RGBAUnorm
+        && format <= WGPUTextureFormat_BC7RGBAUnormSrgb)
+        return gctx->texture_compression_bc;
+    if (format >= WGPUTextureFormat_ETC2RGB8Unorm
+        && format <= WGPUTextureFormat_EACRG11Snorm)
+        return gctx->texture_compression_etc2;
+    if (format >= WGPUTextureFormat_ASTC4x4Unorm
+        && format <= WGPUTextureFormat_ASTC12x12UnormSrgb)
+        return gctx->texture_compression_astc;
+    return true;
+}
+
+// 32-bit float textures can't be sampled with a filtering sampler unless the
+// float32-filterable feature is enabled, which we don't rely on
+static bool G_isFilterableFormat(WGPUTextureFormat format)
+{
+    switch (format) {
+        case WGPUTextureFormat_R32Float:
+        case WGPUTextureFormat_RG32Float:
+        case WGPUTextureFormat_RGBA32Float: return false;
+        default: return true;
+    }
+}
+
 // TODO make part of GraphicsContext and cleanup
 struct {
     WGPUSampler sampler;
+    WGPUSampler sampler_nearest; // for unfilterable formats
 
     // Pipeline for every texture format used.
     // TODO: can layout be shared?
@@ -833,6 +962,11 @@ void MipMapGenerator_init(GraphicsContext* ctx)
 
     mip_map_generator.sampler = wgpuDeviceCreateSampler(ctx->device, &sampler_desc);
 
+    sampler_desc.label     = "mip map sampler nearest";
+    sampler_desc.minFilter = WGPUFilterMode_Nearest;
+    mip_map_generator.sampler_nearest
+      = wgpuDeviceCreateSampler(ctx->device, &sampler_desc);
+
     // Vertex state and Fragment state are shared between all pipelines, so
     // only create once.
     if (!mip_map_generator.vertexState.module
@@ -862,10 +996,12 @@ void MipMapGenerator_release()
 {
     // release sampler
     WGPU_RELEASE_RESOURCE(Sampler, mip_map_generator.sampler);
+    WGPU_RELEASE_RESOURCE(Sampler, mip_map_generator.sampler_nearest);
 
     // release pipelines
     for (int i = 0; i < ARRAY_LENGTH(mip_map_generator.pipelines); ++i) {
         WGPU_RELEASE_RESOURCE(RenderPipeline, mip_map_generator.pipelines[i]);
+        WGPU_RELEASE_RESOURCE(BindGroupLayout, mip_map_generator.pipeline_layouts[i]);
     }
 
     WGPU_RELEASE_RESOURCE(ShaderModule, mip_map_generator.vertexState.module);
@@ -896,7 +1032,37 @@ static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
     color_target_state_desc.blend                = &blend_state;
     color_target_state_desc.writeMask            = WGPUColorWriteMask_All;
 
-    mip_map_generator.fragmentState.targets = &color_target_state_desc;
+    WGPUFragmentState fragment_state = mip_map_generator.fragmentState;
+    fragment_state.targets           = &color_target_state_desc;
+
+    // unfilterable formats need an explicit layout, `auto` assumes a filtering
+    // sampler because of textureSample() in fs_main
+    bool filterable                       = G_isFilterableFormat(format);
+    WGPUBindGroupLayout bind_group_layout = NULL;
+    WGPUPipelineLayout pipeline_layout    = NULL;
+    if (!filterable) {
+        fragment_state.entryPoint = "fs_main_unfilterable";
+
+        WGPUBindGroupLayoutEntry entries[2] = {};
+        entries[0].binding                  = 0;
+        entries[0].visibility               = WGPUShaderStage_Fragment;
+        entries[0].sampler.type             = WGPUSamplerBindingType_NonFiltering;
+        entries[1].binding                  = 1;
+        entries[1].visibility               = WGPUShaderStage_Fragment;
+        entries[1].texture.sampleType       = WGPUTextureSampleType_UnfilterableFloat;
+        entries[1].texture.viewDimension    = WGPUTextureViewDimension_2D;
+
+        WGPUBindGroupLayoutDescriptor bgl_desc = {};
+        bgl_desc.label                         = "mipmap unfilterable layout";
+        bgl_desc.entryCount                    = ARRAY_LENGTH(entries);
+        bgl_desc.entries                       = entries;
+        bind_group_layout = wgpuDeviceCreateBindGroupLayout(ctx->device, &bgl_desc);
+
+        WGPUPipelineLayoutDescriptor layout_desc = {};
+        layout_desc.bindGroupLayoutCount         = 1;
+        layout_desc.bindGroupLayouts             = &bind_group_layout;
+        pipeline_layout = wgpuDeviceCreatePipelineLayout(ctx->device, &layout_desc);
+    }
 
     // Multisample state
     WGPUMultisampleState multisampleState   = {};
@@ -905,11 +1071,12 @@ static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
     multisampleState.alphaToCoverageEnabled = false;
 
     WGPURenderPipelineDescriptor pipelineDesc = {};
-    // layout: defaults to `auto`
+    // layout: defaults to `auto` for filterable formats
     pipelineDesc.label       = "mipmap blit render pipeline";
+    pipelineDesc.layout      = pipeline_layout;
     pipelineDesc.primitive   = primitiveStateDesc;
     pipelineDesc.vertex      = mip_map_generator.vertexState;
-    pipelineDesc.fragment    = &mip_map_generator.fragmentState;
+    pipelineDesc.fragment    = &fragment_state;
     pipelineDesc.multisample = multisampleState;
 
     // Create rendering pipeline using the specified states
@@ -918,9 +1085,14 @@ static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
     ASSERT(mip_map_generator.pipelines[pipeline_index] != NULL);
 
     // Store the bind group layout of the created pipeline
-    mip_map_generator.pipeline_layouts[pipeline_index]
-      = wgpuRenderPipelineGetBindGroupLayout(
-        mip_map_generator.pipelines[pipeline_index], 0);
+    if (filterable) {
+        mip_map_generator.pipeline_layouts[pipeline_index]
+          = wgpuRenderPipelineGetBindGroupLayout(
+            mip_map_generator.pipelines[pipeline_index], 0);
+    } else {
+        mip_map_generator.pipeline_layouts[pipeline_index] = bind_group_layout;
+        WGPU_RELEASE_RESOURCE(PipelineLayout, pipeline_layout);
+    }
     ASSERT(mip_map_generator.pipeline_layouts[pipeline_index] != NULL)
 
     return mip_map_generator.pipelines[pipeline_index];
@@ -928,6 +1100,21 @@ static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
 
 void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
                               const char* label)
+{
+    WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(ctx->device, NULL);
+    MipMapGenerator_generate(ctx, cmd_encoder, texture, label);
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+    ASSERT(command_buffer != NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
+
+    // Sumbit commmand buffer
+    wgpuQueueSubmit(ctx->queue, 1, &command_buffer);
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
+}
+
+void MipMapGenerator_generate(GraphicsContext* ctx, WGPUCommandEncoder cmd_encoder,
+                              WGPUTexture texture, const char* label)
 {
     ASSERT(mip_map_generator.sampler && mip_map_generator.vertexState.module
            && mip_map_generator.fragmentState.module);
@@ -978,8 +1165,7 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
         ASSERT(mip_texture != NULL);
     }
 
-    WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(ctx->device, NULL);
-    u32 pipeline_index             = (u32)format;
+    u32 pipeline_index = (u32)format;
     WGPUBindGroupLayout bind_group_layout
       = mip_map_generator.pipeline_layouts[pipeline_index];
 
@@ -1041,7 +1227,9 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
             // sampler bind group
             bg_entries[0]         = {};
             bg_entries[0].binding = 0;
-            bg_entries[0].sampler = mip_map_generator.sampler;
+            bg_entries[0].sampler = G_isFilterableFormat(format) ?
+                                      mip_map_generator.sampler :
+                                      mip_map_generator.sampler_nearest;
 
             // source texture bind group
             bg_entries[1]             = {};
@@ -1095,16 +1283,9 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
         }
     }
 
-    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(cmd_encoder, NULL);
-    ASSERT(command_buffer != NULL);
-    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
-
-    // Sumbit commmand buffer
-    wgpuQueueSubmit(ctx->queue, 1, &command_buffer);
-
     { // cleanup
-        WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
-
+        // safe to release before the encoder is submitted, wgpu keeps recorded
+        // resources alive until the command buffer finishes executing
         if (!render_to_source) {
             WGPU_RELEASE_RESOURCE(Texture, mip_texture);
         }
@@ -1121,6 +1302,395 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
     }
 }
 
+// ============================================================================
+// HiZGenerator (static)
+// ============================================================================
+
+// same per-mip view + bind group walk as MipMapGenerator, but max-reduces with a
+// compute shader because R32Float depth can't be blended or linearly filtered
+enum : u8 {
+    HIZ_PIPELINE_COPY_DEPTH = 0,
+    HIZ_PIPELINE_COPY_DEPTH_MSAA,
+    HIZ_PIPELINE_REDUCE,
+    HIZ_PIPELINE_COUNT,
+};
+
+static struct {
+    WGPUComputePipeline pipelines[HIZ_PIPELINE_COUNT];
+    // cached because wgpuComputePipelineGetBindGroupLayout leaks memory
+    WGPUBindGroupLayout layouts[HIZ_PIPELINE_COUNT];
+} hiz_generator = {};
+
+void HiZGenerator_init(GraphicsContext* ctx)
+{
+    if (hiz_generator.pipelines[0]) return;
+
+    static const char* entry_points[HIZ_PIPELINE_COUNT]
+      = { "copy_depth", "copy_depth_msaa", "reduce" };
+
+    WGPUShaderModule module
+      = G_createShaderModule(ctx, hiz_shader_string, "hi-z pyramid shader");
+
+    for (int i = 0; i < HIZ_PIPELINE_COUNT; ++i) {
+        WGPUComputePipelineDescriptor desc = {};
+        desc.label                         = entry_points[i];
+        desc.compute.module                = module;
+        desc.compute.entryPoint            = entry_points[i];
+        hiz_generator.pipelines[i]
+          = wgpuDeviceCreateComputePipeline(ctx->device, &desc);
+        ASSERT(hiz_generator.pipelines[i] != NULL);
+        hiz_generator.layouts[i]
+          = wgpuComputePipelineGetBindGroupLayout(hiz_generator.pipelines[i], 0);
+    }
+
+    WGPU_RELEASE_RESOURCE(ShaderModule, module);
+}
+
+void HiZGenerator_release()
+{
+    for (int i = 0; i < HIZ_PIPELINE_COUNT; ++i) {
+        WGPU_RELEASE_RESOURCE(ComputePipeline, hiz_generator.pipelines[i]);
+        WGPU_RELEASE_RESOURCE(BindGroupLayout, hiz_generator.layouts[i]);
+    }
+}
+
+void HiZGenerator_generate(WGPUDevice device, WGPUCommandEncoder cmd_encoder,
+                           WGPUTexture depth_texture, WGPUTexture hiz_texture)
+{
+    ASSERT(hiz_generator.pipelines[0]);
+    ASSERT(wgpuTextureGetFormat(hiz_texture) == WGPUTextureFormat_R32Float);
+    ASSERT(wgpuTextureGetWidth(hiz_texture) == wgpuTextureGetWidth(depth_texture));
+    ASSERT(wgpuTextureGetHeight(hiz_texture) == wgpuTextureGetHeight(depth_texture));
+
+    const u32 mip_level_count = wgpuTextureGetMipLevelCount(hiz_texture);
+    const bool msaa           = wgpuTextureGetSampleCount(depth_texture) > 1;
+
+    // views[0] is the depth texture, views[i + 1] is hi-z mip i
+    const u32 views_count      = mip_level_count + 1;
+    WGPUTextureView* views     = ALLOCATE_COUNT(WGPUTextureView, views_count);
+    WGPUBindGroup* bind_groups = ALLOCATE_COUNT(WGPUBindGroup, mip_level_count);
+
+    WGPUTextureViewDescriptor view_desc = {};
+    view_desc.label                     = "hi-z depth view";
+    view_desc.aspect                    = WGPUTextureAspect_All;
+    view_desc.dimension                 = WGPUTextureViewDimension_2D;
+    view_desc.baseMipLevel              = 0;
+    view_desc.mipLevelCount             = 1;
+    view_desc.baseArrayLayer            = 0;
+    view_desc.arrayLayerCount           = 1;
+    views[0] = wgpuTextureCreateView(depth_texture, &view_desc);
+
+    view_desc.label = "hi-z mip view";
+    for (u32 i = 0; i < mip_level_count; ++i) {
+        view_desc.baseMipLevel = i;
+        views[i + 1]           = wgpuTextureCreateView(hiz_texture, &view_desc);
+    }
+
+    WGPUComputePassDescriptor pass_desc = {};
+    pass_desc.label                     = "hi-z pyramid";
+    WGPUComputePassEncoder compute_pass
+      = wgpuCommandEncoderBeginComputePass(cmd_encoder, &pass_desc);
+
+    u32 width  = wgpuTextureGetWidth(hiz_texture);
+    u32 height = wgpuTextureGetHeight(hiz_texture);
+    for (u32 i = 0; i < mip_level_count; ++i) {
+        int pipeline = HIZ_PIPELINE_REDUCE;
+        if (i == 0) {
+            pipeline = msaa ? HIZ_PIPELINE_COPY_DEPTH_MSAA : HIZ_PIPELINE_COPY_DEPTH;
+        }
+
+        // source is the depth texture for mip 0, else the mip above
+        WGPUBindGroupEntry bg_entries[2] = {};
+        bg_entries[0].binding            = (i > 0) ? 0 : (msaa ? 3 : 2);
+        bg_entries[0].textureView        = views[i];
+        bg_entries[1].binding            = 1;
+        bg_entries[1].textureView        = views[i + 1];
+
+        WGPUBindGroupDescriptor bg_desc = {};
+        bg_desc.label                   = "hi-z bind group";
+        bg_desc.layout                  = hiz_generator.layouts[pipeline];
+        bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
+        bg_desc.entries                 = bg_entries;
+        bind_groups[i]                  = wgpuDeviceCreateBindGroup(device, &bg_desc);
+
+        wgpuComputePassEncoderSetPipeline(compute_pass,
+                                          hiz_generator.pipelines[pipeline]);
+        wgpuComputePassEncoderSetBindGroup(compute_pass, 0, bind_groups[i], 0, NULL);
+        // matches @workgroup_size(8, 8, 1)
+        wgpuComputePassEncoderDispatchWorkgroups(compute_pass, (width + 7) / 8,
+                                                 (height + 7) / 8, 1);
+
+        width  = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+
+    wgpuComputePassEncoderEnd(compute_pass);
+    WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
+
+    { // cleanup
+        // safe to release before the encoder is submitted, wgpu keeps recorded
+        // resources alive until the command buffer finishes executing
+        for (u32 i = 0; i < views_count; ++i) {
+            WGPU_RELEASE_RESOURCE(TextureView, views[i]);
+        }
+        FREE_ARRAY(WGPUTextureView, views, views_count);
+
+        for (u32 i = 0; i < mip_level_count; ++i) {
+            WGPU_RELEASE_RESOURCE(BindGroup, bind_groups[i]);
+        }
+        FREE_ARRAY(WGPUBindGroup, bind_groups, mip_level_count);
+    }
+}
+
+// ============================================================================
+// EquirectToCubemap (static)
+// ============================================================================
+
+static struct {
+    WGPUComputePipeline pipeline;
+    WGPUBindGroupLayout bind_group_layout;
+} equirect_to_cubemap = {};
+
+static void EquirectToCubemap_init(GraphicsContext* ctx)
+{
+    if (equirect_to_cubemap.pipeline) return;
+
+    // explicit layout so 32-bit float (unfilterable) sources are accepted
+    WGPUBindGroupLayoutEntry entries[2]     = {};
+    entries[0].binding                      = 0;
+    entries[0].visibility                   = WGPUShaderStage_Compute;
+    entries[0].texture.sampleType           = WGPUTextureSampleType_UnfilterableFloat;
+    entries[0].texture.viewDimension        = WGPUTextureViewDimension_2D;
+    entries[1].binding                      = 1;
+    entries[1].visibility                   = WGPUShaderStage_Compute;
+    entries[1].storageTexture.access        = WGPUStorageTextureAccess_WriteOnly;
+    entries[1].storageTexture.format        = WGPUTextureFormat_RGBA16Float;
+    entries[1].storageTexture.viewDimension = WGPUTextureViewDimension_2DArray;
+
+    WGPUBindGroupLayoutDescriptor bgl_desc = {};
+    bgl_desc.label                         = "equirect to cubemap layout";
+    bgl_desc.entryCount                    = ARRAY_LENGTH(entries);
+    bgl_desc.entries                       = entries;
+    equirect_to_cubemap.bind_group_layout
+      = wgpuDeviceCreateBindGroupLayout(ctx->device, &bgl_desc);
+
+    WGPUPipelineLayoutDescriptor layout_desc = {};
+    layout_desc.bindGroupLayoutCount         = 1;
+    layout_desc.bindGroupLayouts             = &equirect_to_cubemap.bind_group_layout;
+    WGPUPipelineLayout pipeline_layout
+      = wgpuDeviceCreatePipelineLayout(ctx->device, &layout_desc);
+
+    WGPUShaderModule module = G_createShaderModule(
+      ctx, equirect_to_cubemap_shader_string, "equirect to cubemap shader");
+
+    WGPUComputePipelineDescriptor desc = {};
+    desc.label                         = "equirect to cubemap pipeline";
+    desc.layout                        = pipeline_layout;
+    desc.compute.module                = module;
+    desc.compute.entryPoint            = "main";
+    equirect_to_cubemap.pipeline = wgpuDeviceCreateComputePipeline(ctx->device, &desc);
+    ASSERT(equirect_to_cubemap.pipeline != NULL);
+
+    WGPU_RELEASE_RESOURCE(ShaderModule, module);
+    WGPU_RELEASE_RESOURCE(PipelineLayout, pipeline_layout);
+}
+
+void EquirectToCubemap_release()
+{
+    WGPU_RELEASE_RESOURCE(ComputePipeline, equirect_to_cubemap.pipeline);
+    WGPU_RELEASE_RESOURCE(BindGroupLayout, equirect_to_cubemap.bind_group_layout);
+}
+
+void EquirectToCubemap_convert(GraphicsContext* ctx, WGPUTexture equirect,
+                               WGPUTexture cubemap)
+{
+    ASSERT(wgpuTextureGetFormat(cubemap) == WGPUTextureFormat_RGBA16Float);
+    ASSERT(wgpuTextureGetDepthOrArrayLayers(cubemap) == 6);
+    ASSERT(wgpuTextureGetUsage(cubemap) & WGPUTextureUsage_StorageBinding);
+
+    EquirectToCubemap_init(ctx);
+
+    WGPUTextureViewDescriptor src_view_desc = {};
+    src_view_desc.label                     = "equirect to cubemap src view";
+    src_view_desc.format                    = wgpuTextureGetFormat(equirect);
+    src_view_desc.dimension                 = WGPUTextureViewDimension_2D;
+    src_view_desc.baseMipLevel              = 0;
+    src_view_desc.mipLevelCount             = 1;
+    src_view_desc.baseArrayLayer            = 0;
+    src_view_desc.arrayLayerCount           = 1;
+    src_view_desc.aspect                    = WGPUTextureAspect_All;
+    WGPUTextureView src_view = wgpuTextureCreateView(equirect, &src_view_desc);
+
+    WGPUTextureViewDescriptor dst_view_desc = src_view_desc;
+    dst_view_desc.label                     = "equirect to cubemap dst view";
+    dst_view_desc.format                    = WGPUTextureFormat_RGBA16Float;
+    dst_view_desc.dimension                 = WGPUTextureViewDimension_2DArray;
+    dst_view_desc.arrayLayerCount           = 6;
+    WGPUTextureView dst_view = wgpuTextureCreateView(cubemap, &dst_view_desc);
+
+    WGPUBindGroupEntry bg_entries[2] = {};
+    bg_entries[0].binding            = 0;
+    bg_entries[0].textureView        = src_view;
+    bg_entries[1].binding            = 1;
+    bg_entries[1].textureView        = dst_view;
+
+    WGPUBindGroupDescriptor bg_desc = {};
+    bg_desc.label                   = "equirect to cubemap bind group";
+    bg_desc.layout                  = equirect_to_cubemap.bind_group_layout;
+    bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
+    bg_desc.entries                 = bg_entries;
+    WGPUBindGroup bind_group        = wgpuDeviceCreateBindGroup(ctx->device, &bg_desc);
+
+    const u32 face_size = wgpuTextureGetWidth(cubemap);
+    const u32 groups    = (face_size + 7) / 8; // matches @workgroup_size(8, 8, 1)
+
+    WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(ctx->device, NULL);
+    WGPUComputePassEncoder compute_pass
+      = wgpuCommandEncoderBeginComputePass(cmd_encoder, NULL);
+    wgpuComputePassEncoderSetPipeline(compute_pass, equirect_to_cubemap.pipeline);
+    wgpuComputePassEncoderSetBindGroup(compute_pass, 0, bind_group, 0, NULL);
+    wgpuComputePassEncoderDispatchWorkgroups(compute_pass, groups, groups, 6);
+    wgpuComputePassEncoderEnd(compute_pass);
+    WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
+
+    // regenerate the cubemap mip chain (if any) from the new face data
+    MipMapGenerator_generate(ctx, cmd_encoder, cubemap, "equirect to cubemap");
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+    ASSERT(command_buffer != NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder);
+
+    wgpuQueueSubmit(ctx->queue, 1, &command_buffer);
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer);
+
+    WGPU_RELEASE_RESOURCE(BindGroup, bind_group);
+    WGPU_RELEASE_RESOURCE(TextureView, dst_view);
+    WGPU_RELEASE_RESOURCE(TextureView, src_view);
+}
+
+// ============================================================================
+// YUVToRGBA (static)
+// ============================================================================
+
+static struct {
+    WGPUComputePipeline pipelines[YUV_LAYOUT_COUNT];
+    WGPUBindGroupLayout bind_group_layout;
+} yuv_to_rgba = {};
+
+static void YUVToRGBA_init(GraphicsContext* ctx)
+{
+    if (yuv_to_rgba.bind_group_layout) return;
+
+    WGPUBindGroupLayoutEntry entries[4] = {};
+    for (int i = 0; i < 3; i++) { // y, cb, cr
+        entries[i].binding               = i;
+        entries[i].visibility            = WGPUShaderStage_Compute;
+        entries[i].texture.sampleType    = WGPUTextureSampleType_Float;
+        entries[i].texture.viewDimension = WGPUTextureViewDimension_2D;
+    }
+    entries[3].binding                      = 3;
+    entries[3].visibility                   = WGPUShaderStage_Compute;
+    entries[3].storageTexture.access        = WGPUStorageTextureAccess_WriteOnly;
+    entries[3].storageTexture.format        = WGPUTextureFormat_RGBA8Unorm;
+    entries[3].storageTexture.viewDimension = WGPUTextureViewDimension_2D;
+
+    WGPUBindGroupLayoutDescriptor bgl_desc = {};
+    bgl_desc.label                         = "yuv to rgba layout";
+    bgl_desc.entryCount                    = ARRAY_LENGTH(entries);
+    bgl_desc.entries                       = entries;
+    yuv_to_rgba.bind_group_layout = wgpuDeviceCreateBindGroupLayout(ctx->device, &bgl_desc);
+
+    WGPUPipelineLayoutDescriptor layout_desc = {};
+    layout_desc.bindGroupLayoutCount         = 1;
+    layout_desc.bindGroupLayouts             = &yuv_to_rgba.bind_group_layout;
+    WGPUPipelineLayout pipeline_layout
+      = wgpuDeviceCreatePipelineLayout(ctx->device, &layout_desc);
+
+    WGPUShaderModule module
+      = G_createShaderModule(ctx, yuv_to_rgba_shader_string, "yuv to rgba shader");
+
+    // one entry point per YUVLayout
+    const char* entry_points[YUV_LAYOUT_COUNT] = { "main_i420", "main_nv12", "main_yuyv" };
+    for (u32 i = 0; i < YUV_LAYOUT_COUNT; i++) {
+        WGPUComputePipelineDescriptor desc = {};
+        desc.label                         = "yuv to rgba pipeline";
+        desc.layout                        = pipeline_layout;
+        desc.compute.module                = module;
+        desc.compute.entryPoint            = entry_points[i];
+        yuv_to_rgba.pipelines[i] = wgpuDeviceCreateComputePipeline(ctx->device, &desc);
+        ASSERT(yuv_to_rgba.pipelines[i] != NULL);
+    }
+
+    WGPU_RELEASE_RESOURCE(ShaderModule, module);
+    WGPU_RELEASE_RESOURCE(PipelineLayout, pipeline_layout);
+}
+
+void YUVToRGBA_release()
+{
+    for (u32 i = 0; i < YUV_LAYOUT_COUNT; i++) {
+        WGPU_RELEASE_RESOURCE(ComputePipeline, yuv_to_rgba.pipelines[i]);
+    }
+    WGPU_RELEASE_RESOURCE(BindGroupLayout, yuv_to_rgba.bind_group_layout);
+}
+
+WGPUBindGroup YUVToRGBA_createBindGroup(GraphicsContext* ctx, WGPUTexture y,
+                                        WGPUTexture cb, WGPUTexture cr,
+                                        WGPUTexture rgba)
+{
+    ASSERT(wgpuTextureGetFormat(rgba) == WGPUTextureFormat_RGBA8Unorm);
+    ASSERT(wgpuTextureGetUsage(rgba) & WGPUTextureUsage_StorageBinding);
+
+    YUVToRGBA_init(ctx);
+
+    WGPUTexture textures[4] = { y, cb, cr, rgba };
+    WGPUTextureView views[4] = {};
+    WGPUBindGroupEntry bg_entries[4] = {};
+    for (int i = 0; i < 4; i++) {
+        WGPUTextureViewDescriptor view_desc = {};
+        view_desc.label                     = "yuv to rgba view";
+        view_desc.format                    = wgpuTextureGetFormat(textures[i]);
+        view_desc.dimension                 = WGPUTextureViewDimension_2D;
+        view_desc.baseMipLevel              = 0;
+        view_desc.mipLevelCount             = 1;
+        view_desc.baseArrayLayer            = 0;
+        view_desc.arrayLayerCount           = 1;
+        view_desc.aspect                    = WGPUTextureAspect_All;
+        views[i] = wgpuTextureCreateView(textures[i], &view_desc);
+
+        bg_entries[i].binding     = i;
+        bg_entries[i].textureView = views[i];
+    }
+
+    WGPUBindGroupDescriptor bg_desc = {};
+    bg_desc.label                   = "yuv to rgba bind group";
+    bg_desc.layout                  = yuv_to_rgba.bind_group_layout;
+    bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
+    bg_desc.entries                 = bg_entries;
+    WGPUBindGroup bind_group        = wgpuDeviceCreateBindGroup(ctx->device, &bg_desc);
+
+    // the bind group keeps its views alive
+    for (int i = 0; i < 4; i++) WGPU_RELEASE_RESOURCE(TextureView, views[i]);
+
+    return bind_group;
+}
+
+void YUVToRGBA_convert(GraphicsContext* ctx, WGPUCommandEncoder cmd_encoder,
+                       WGPUBindGroup bind_group, YUVLayout layout, u32 width,
+                       u32 height)
+{
+    YUVToRGBA_init(ctx);
+
+    WGPUComputePassEncoder compute_pass
+      = wgpuCommandEncoderBeginComputePass(cmd_encoder, NULL);
+    wgpuComputePassEncoderSetPipeline(compute_pass, yuv_to_rgba.pipelines[layout]);
+    wgpuComputePassEncoderSetBindGroup(compute_pass, 0, bind_group, 0, NULL);
+    // matches @workgroup_size(8, 8, 1)
+    wgpuComputePassEncoderDispatchWorkgroups(compute_pass, (width + 7) / 8,
+                                             (height + 7) / 8, 1);
+    wgpuComputePassEncoderEnd(compute_pass);
+    WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
+}
+
 // ============================================================================
 // Sampler
 // ============================================================================
@@ -83,10 +83,20 @@ struct GraphicsContext {
     // Device limits --------
     WGPULimits limits;
 
+    // Device features --------
+    bool texture_compression_bc;
+    bool texture_compression_etc2;
+    bool texture_compression_astc;
+
     // Default resources ---------
     WGPUSampler shadow_comparison_sampler;
     WGPUTexture sentinel_spotlight_depth_2d_array;
     WGPUTexture sentinel_dirlight_depth_2d_array;
+    WGPUTexture sentinel_pointlight_depth_2d_array;
+    WGPUBuffer sentinel_light_cluster_buffer; // bound where no cluster grid is built
+    WGPUTexture sentinel_hiz_texture;         // bound where no Hi-Z pyramid is built
+    WGPUShaderModule light_cluster_shader_module;
+    WGPUShaderModule instance_cull_shader_module;
 
     // Methods --------
     static bool init(GraphicsContext* context, GLFWwindow* window);
@@ -327,6 +337,55 @@ void MipMapGenerator_init(GraphicsContext* ctx);
 void MipMapGenerator_release();
 void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
                               const char* label);
+// records into an existing encoder so mip generation for many textures can be
+// batched into a single submit
+void MipMapGenerator_generate(GraphicsContext* ctx, WGPUCommandEncoder cmd_encoder,
+                              WGPUTexture texture, const char* label);
+
+// ============================================================================
+// HiZGenerator
+// ============================================================================
+
+void HiZGenerator_init(GraphicsContext* ctx);
+void HiZGenerator_release();
+// records a max-depth pyramid of depth_texture into every mip of hiz_texture, which
+// must be R32Float with StorageBinding | TextureBinding usage and the same size
+void HiZGenerator_generate(WGPUDevice device, WGPUCommandEncoder cmd_encoder,
+                           WGPUTexture depth_texture, WGPUTexture hiz_texture);
+
+// ============================================================================
+// EquirectToCubemap
+// ============================================================================
+
+void EquirectToCubemap_release();
+// resamples an equirectangular 2D texture into all 6 faces of an RGBA16Float
+// cubemap created with StorageBinding usage. Regenerates the cubemap mips.
+void EquirectToCubemap_convert(GraphicsContext* ctx, WGPUTexture equirect,
+                               WGPUTexture cubemap);
+
+// ============================================================================
+// YUVToRGBA
+// ============================================================================
+
+// how the BT.601 source is laid out across the three input bindings
+enum YUVLayout : u8 {
+    YUV_LAYOUT_I420 = 0, // y, cb, cr: R8Unorm planes, chroma at half resolution
+    YUV_LAYOUT_NV12,     // y: R8Unorm, cb = cr: RG8Unorm CbCr at half resolution
+    YUV_LAYOUT_YUYV,     // y = cb = cr: RGBA8Unorm Y0 Cb Y1 Cr, half width
+    YUV_LAYOUT_COUNT
+};
+
+void YUVToRGBA_release();
+// bind group for converting YUV planes into an RGBA8Unorm texture created with
+// StorageBinding usage. Packed layouts pass the same texture more than once.
+// Caller releases
+WGPUBindGroup YUVToRGBA_createBindGroup(GraphicsContext* ctx, WGPUTexture y,
+                                        WGPUTexture cb, WGPUTexture cr,
+                                        WGPUTexture rgba);
+// records the conversion of a width x height region into encoder
+void YUVToRGBA_convert(GraphicsContext* ctx, WGPUCommandEncoder cmd_encoder,
+                       WGPUBindGroup bind_group, YUVLayout layout, u32 width,
+                       u32 height);
 
 // ============================================================================
 // Pipeline State Helpers (blend, depth/stencil, multisample)
@@ -359,6 +418,18 @@ WGPUTextureView G_createTextureViewAtMipLevel(WGPUTexture texture, u32 base_mip_
 int G_componentsPerTexel(WGPUTextureFormat format);
 int G_bytesPerTexel(WGPUTextureFormat format);
 
+// texel block layout, uncompressed formats are 1x1 blocks of bytesPerTexel.
+// returns false for formats ChuGL can't load data into
+struct G_FormatBlockInfo {
+    u32 width; // texels
+    u32 height;
+    u32 bytes;
+};
+bool G_formatBlockInfo(WGPUTextureFormat format, G_FormatBlockInfo* info);
+bool G_isCompressedFormat(WGPUTextureFormat format);
+// false if the format needs a texture compression feature the device lacks
+bool G_isFormatSupported(GraphicsContext* gctx, WGPUTextureFormat format);
+
 struct G_Util {
 
     static WGPUTextureFormat textureFormatSrgbVariant(WGPUTextureFormat format);
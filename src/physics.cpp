@@ -0,0 +1,695 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "physics.h"
+#include "r_component.h"
+#include "sg_command.h"
+
+#include "core/log.h"
+#include "core/memory.h"
+#include "core/spinlock.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct Physics_BodyState {
+    b2BodyId body_id; // null if the slot has never been written
+    b2Transform prev;
+    b2Transform curr;
+    b2Vec2 linear_velocity;
+    f32 angular_velocity;
+    u32 step;  // step that wrote curr
+    u32 batch; // for deduplicating move events within a frame
+};
+
+struct Physics_Snapshot {
+    Arena bodies; // Physics_BodyState, indexed by b2BodyId.index1 - 1
+    u32 step;     // last step taken when this snapshot was published
+    f32 alpha = 1.0f;
+};
+
+struct Physics_State {
+    u32 world_id; // b2WorldId, same packing as b2_SimulateDesc
+    f64 accumulator;
+    u32 step;
+    u32 batch;
+
+    // front is read by any thread under snapshot_lock. back is only touched by
+    // whichever thread is stepping
+    Physics_Snapshot snapshots[2];
+    int front;
+    spinlock snapshot_lock;
+
+    // events over all steps of the last batch
+    Arena move_events;          // b2BodyMoveEvent
+    Arena sensor_begin_events;  // b2SensorBeginTouchEvent
+    Arena sensor_end_events;    // b2SensorEndTouchEvent
+    Arena contact_begin_events; // b2ContactBeginTouchEvent
+    Arena contact_end_events;   // b2ContactEndTouchEvent
+    Arena contact_hit_events;   // b2ContactHitEvent
+
+    // Physics_Write made while the physics thread was busy. Swapped with
+    // applying_writes at the start of a batch
+    spinlock writes_lock;
+    Arena writes;
+    Arena applying_writes; // stepping thread only
+
+    // physics thread
+    std::thread* thread;
+    std::mutex lock; // guards everything below
+    std::condition_variable cv;
+    bool requested;
+    bool shutdown;
+    b2_SimulateDesc pending_desc;
+    f64 pending_dt;
+    std::atomic<bool> busy;
+};
+
+static Physics_State physics;
+static Physics_Bindings physics_render_bindings;
+
+// ============================================================================
+// Stepping
+// ============================================================================
+
+#define PHYSICS_APPEND_EVENTS(arena, type, events, count)                              \
+    if ((count) > 0) memcpy(ARENA_PUSH_COUNT(arena, type, count), events,              \
+                            sizeof(type) * (count))
+
+static void Physics_ClearEvents()
+{
+    Arena::clear(&physics.move_events);
+    Arena::clear(&physics.sensor_begin_events);
+    Arena::clear(&physics.sensor_end_events);
+    Arena::clear(&physics.contact_begin_events);
+    Arena::clear(&physics.contact_end_events);
+    Arena::clear(&physics.contact_hit_events);
+}
+
+static Physics_BodyState* Physics_GetBodyState(Physics_Snapshot* snapshot,
+                                               b2BodyId body_id)
+{
+    u32 index = body_id.index1 - 1;
+    u32 count = ARENA_LENGTH(&snapshot->bodies, Physics_BodyState);
+    if (index >= count) {
+        ARENA_PUSH_ZERO_COUNT(&snapshot->bodies, Physics_BodyState, index + 1 - count);
+    }
+    return ARENA_GET_TYPE(&snapshot->bodies, Physics_BodyState, index);
+}
+
+static void Physics_Step(b2WorldId world_id, f32 dt, int substeps,
+                         Physics_Snapshot* back)
+{
+    b2World_Step(world_id, dt, substeps);
+    physics.step++;
+
+    b2BodyEvents body_events = b2World_GetBodyEvents(world_id);
+    for (int i = 0; i < body_events.moveCount; i++) {
+        b2BodyMoveEvent* move   = &body_events.moveEvents[i];
+        Physics_BodyState* body = Physics_GetBodyState(back, move->bodyId);
+        if (B2_ID_EQUALS(body->body_id, move->bodyId)) {
+            body->prev = body->curr;
+        } else {
+            // new body, or a destroyed body's slot being reused
+            body->body_id = move->bodyId;
+            body->prev    = move->transform;
+        }
+        body->curr = move->transform;
+        body->step = physics.step;
+
+        if (move->fellAsleep) {
+            body->linear_velocity  = b2Vec2_zero;
+            body->angular_velocity = 0.0f;
+        } else {
+            body->linear_velocity  = b2Body_GetLinearVelocity(move->bodyId);
+            body->angular_velocity = b2Body_GetAngularVelocity(move->bodyId);
+        }
+    }
+    PHYSICS_APPEND_EVENTS(&physics.move_events, b2BodyMoveEvent, body_events.moveEvents,
+                          body_events.moveCount);
+
+    b2SensorEvents sensor_events = b2World_GetSensorEvents(world_id);
+    PHYSICS_APPEND_EVENTS(&physics.sensor_begin_events, b2SensorBeginTouchEvent,
+                          sensor_events.beginEvents, sensor_events.beginCount);
+    PHYSICS_APPEND_EVENTS(&physics.sensor_end_events, b2SensorEndTouchEvent,
+                          sensor_events.endEvents, sensor_events.endCount);
+
+    b2ContactEvents contact_events = b2World_GetContactEvents(world_id);
+    PHYSICS_APPEND_EVENTS(&physics.contact_begin_events, b2ContactBeginTouchEvent,
+                          contact_events.beginEvents, contact_events.beginCount);
+    PHYSICS_APPEND_EVENTS(&physics.contact_end_events, b2ContactEndTouchEvent,
+                          contact_events.endEvents, contact_events.endCount);
+    PHYSICS_APPEND_EVENTS(&physics.contact_hit_events, b2ContactHitEvent,
+                          contact_events.hitEvents, contact_events.hitCount);
+}
+
+// a body that moved on several steps this frame only keeps its latest move
+// event, so ChucK sees one event per body like it did with a single step
+static void Physics_DedupMoveEvents(Physics_Snapshot* back)
+{
+    int count = ARENA_LENGTH(&physics.move_events, b2BodyMoveEvent);
+    if (count == 0) return;
+
+    b2BodyMoveEvent* events = ARENA_GET_TYPE(&physics.move_events, b2BodyMoveEvent, 0);
+
+    // walk backwards keeping the first (latest) event of each body, compacting
+    // towards the end of the array, then shift the survivors down
+    int write = count;
+    for (int read = count - 1; read >= 0; read--) {
+        Physics_BodyState* body = Physics_GetBodyState(back, events[read].bodyId);
+        if (body->batch == physics.batch) continue;
+        body->batch     = physics.batch;
+        events[--write] = events[read];
+    }
+    memmove(events, events + write, sizeof(*events) * (count - write));
+    ARENA_POP_COUNT(&physics.move_events, b2BodyMoveEvent, write);
+}
+
+static void Physics_ResetSnapshots()
+{
+    spinlock::lock(&physics.snapshot_lock);
+    for (u32 i = 0; i < ARRAY_LENGTH(physics.snapshots); i++) {
+        Arena::clear(&physics.snapshots[i].bodies);
+        physics.snapshots[i].step  = 0;
+        physics.snapshots[i].alpha = 1.0f;
+    }
+    spinlock::unlock(&physics.snapshot_lock);
+}
+
+// swaps the back snapshot to the front, then brings the new back up to date
+// so the next batch continues from the published state
+static void Physics_Publish()
+{
+    spinlock::lock(&physics.snapshot_lock);
+    physics.front = 1 - physics.front;
+    spinlock::unlock(&physics.snapshot_lock);
+
+    // the new front is only read from here on, safe to copy without the lock
+    Physics_Snapshot* front = &physics.snapshots[physics.front];
+    Physics_Snapshot* back  = &physics.snapshots[1 - physics.front];
+    Arena::clear(&back->bodies);
+    if (front->bodies.curr > 0) {
+        memcpy(Arena::push(&back->bodies, front->bodies.curr), front->bodies.base,
+               front->bodies.curr);
+    }
+    back->step  = front->step;
+    back->alpha = front->alpha;
+}
+
+static bool Physics_InSimulatedWorld(b2BodyId body_id)
+{
+    b2WorldId world_id = *(b2WorldId*)&physics.world_id;
+    return B2_IS_NON_NULL(world_id) && body_id.world0 == world_id.index1 - 1;
+}
+
+// brings the body's snapshot entry up to date after a write. A teleport resets
+// the interpolation, other writes only refresh the velocities of bodies that
+// are already in the snapshot
+static void Physics_SnapshotWrite(Physics_Snapshot* snapshot, b2BodyId body_id,
+                                  bool teleport)
+{
+    Physics_BodyState* body = Physics_GetBodyState(snapshot, body_id);
+    bool present            = B2_ID_EQUALS(body->body_id, body_id);
+    if (!present && !teleport) return;
+
+    if (teleport) {
+        body->body_id = body_id;
+        body->prev = body->curr = b2Body_GetTransform(body_id);
+        body->step              = snapshot->step;
+    }
+    body->linear_velocity  = b2Body_GetLinearVelocity(body_id);
+    body->angular_velocity = b2Body_GetAngularVelocity(body_id);
+}
+
+// returns true if the write moved the body
+static bool Physics_ApplyWrite(const Physics_Write* w)
+{
+    if (!b2Body_IsValid(w->body_id)) return false;
+
+    switch (w->type) {
+        case PHYSICS_WRITE_TRANSFORM: {
+            b2Body_SetTransform(w->body_id, w->v, w->q);
+            return true;
+        }
+        case PHYSICS_WRITE_POSITION: {
+            b2Body_SetTransform(w->body_id, w->v, b2Body_GetRotation(w->body_id));
+            return true;
+        }
+        case PHYSICS_WRITE_ROTATION: {
+            b2Body_SetTransform(w->body_id, b2Body_GetPosition(w->body_id), w->q);
+            return true;
+        }
+        case PHYSICS_WRITE_LINEAR_VELOCITY: {
+            b2Body_SetLinearVelocity(w->body_id, w->v);
+        } break;
+        case PHYSICS_WRITE_ANGULAR_VELOCITY: {
+            b2Body_SetAngularVelocity(w->body_id, w->f);
+        } break;
+        case PHYSICS_WRITE_FORCE: {
+            b2Body_ApplyForce(w->body_id, w->v, w->point, w->wake);
+        } break;
+        case PHYSICS_WRITE_FORCE_TO_CENTER: {
+            b2Body_ApplyForceToCenter(w->body_id, w->v, w->wake);
+        } break;
+        case PHYSICS_WRITE_TORQUE: {
+            b2Body_ApplyTorque(w->body_id, w->f, w->wake);
+        } break;
+        case PHYSICS_WRITE_LINEAR_IMPULSE: {
+            b2Body_ApplyLinearImpulse(w->body_id, w->v, w->point, w->wake);
+        } break;
+        case PHYSICS_WRITE_LINEAR_IMPULSE_TO_CENTER: {
+            b2Body_ApplyLinearImpulseToCenter(w->body_id, w->v, w->wake);
+        } break;
+        case PHYSICS_WRITE_ANGULAR_IMPULSE: {
+            b2Body_ApplyAngularImpulse(w->body_id, w->f, w->wake);
+        } break;
+        default: ASSERT(false);
+    }
+    return false;
+}
+
+// stepping thread. Writes land in the back snapshot, which is published at the
+// end of the batch
+static void Physics_ApplyQueuedWrites(Physics_Snapshot* back)
+{
+    spinlock::lock(&physics.writes_lock);
+    Arena tmp               = physics.writes;
+    physics.writes          = physics.applying_writes;
+    physics.applying_writes = tmp;
+    spinlock::unlock(&physics.writes_lock);
+
+    int count = ARENA_LENGTH(&physics.applying_writes, Physics_Write);
+    for (int i = 0; i < count; i++) {
+        Physics_Write* w = ARENA_GET_TYPE(&physics.applying_writes, Physics_Write, i);
+        bool teleport    = Physics_ApplyWrite(w);
+        if (Physics_InSimulatedWorld(w->body_id) && b2Body_IsValid(w->body_id)) {
+            Physics_SnapshotWrite(back, w->body_id, teleport);
+        }
+    }
+    Arena::clear(&physics.applying_writes);
+}
+
+static void Physics_RunBatch(const b2_SimulateDesc* desc, f64 dt)
+{
+    b2WorldId world_id = *(b2WorldId*)&desc->world_id;
+
+    // writes queued during the last batch, before anything else touches the
+    // world. Snapshot entries are only written for the world that was being
+    // simulated, a world switch below clears them anyway
+    Physics_ApplyQueuedWrites(&physics.snapshots[1 - physics.front]);
+
+    Physics_ClearEvents();
+    if (!b2World_IsValid(world_id)) return;
+
+    if (desc->world_id != physics.world_id) {
+        physics.world_id    = desc->world_id;
+        physics.accumulator = 0;
+        Physics_ResetSnapshots();
+    }
+
+    physics.batch++;
+    Physics_Snapshot* back = &physics.snapshots[1 - physics.front];
+    f64 sim_dt             = desc->rate * dt;
+
+    f32 alpha = 1.0f;
+    if (desc->fixed_timestep <= 0.0f) {
+        Physics_Step(world_id, (f32)sim_dt, desc->substeps, back);
+    } else {
+        f64 h = desc->fixed_timestep;
+        physics.accumulator += sim_dt;
+
+        int steps = 0;
+        while (physics.accumulator >= h && steps < PHYSICS_MAX_STEPS_PER_FRAME) {
+            Physics_Step(world_id, (f32)h, desc->substeps, back);
+            physics.accumulator -= h;
+            steps++;
+        }
+
+        // fell too far behind (e.g. the window was dragged), drop the backlog
+        // rather than spiralling
+        if (physics.accumulator >= h) {
+            physics.accumulator = fmod(physics.accumulator, h);
+        }
+
+        alpha = (f32)(physics.accumulator / h);
+    }
+
+    Physics_DedupMoveEvents(back);
+
+    back->step  = physics.step;
+    back->alpha = alpha;
+    Physics_Publish();
+}
+
+// ============================================================================
+// Physics thread
+// ============================================================================
+
+static void Physics_ThreadMain()
+{
+    while (true) {
+        b2_SimulateDesc desc;
+        f64 dt;
+        {
+            std::unique_lock<std::mutex> lk(physics.lock);
+            physics.cv.wait(lk, [] { return physics.requested || physics.shutdown; });
+            if (physics.shutdown) return;
+            physics.requested = false;
+            desc              = physics.pending_desc;
+            dt                = physics.pending_dt;
+        }
+
+        Physics_RunBatch(&desc, dt);
+
+        {
+            std::lock_guard<std::mutex> lk(physics.lock);
+            physics.busy.store(false);
+        }
+        physics.cv.notify_all();
+    }
+}
+
+static void Physics_StopThread()
+{
+    if (!physics.thread) return;
+    {
+        std::lock_guard<std::mutex> lk(physics.lock);
+        physics.shutdown = true;
+    }
+    physics.cv.notify_all();
+    physics.thread->join();
+    delete physics.thread;
+    physics.thread   = NULL;
+    physics.shutdown = false;
+}
+
+// ============================================================================
+// Physics API
+// ============================================================================
+
+void Physics_Update(const b2_SimulateDesc* desc, f64 dt)
+{
+    // normally finished long ago, during the previous ChucK frame
+    Physics_Wait();
+
+    if (!desc->threaded) {
+        Physics_StopThread();
+        Physics_RunBatch(desc, dt);
+        return;
+    }
+
+    if (!physics.thread) {
+        physics.thread = new std::thread(Physics_ThreadMain);
+        log_debug("started physics thread");
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(physics.lock);
+        physics.pending_desc = *desc;
+        physics.pending_dt   = dt;
+        physics.requested    = true;
+        physics.busy.store(true);
+    }
+    physics.cv.notify_all();
+}
+
+void Physics_Wait()
+{
+    if (!physics.busy.load()) return;
+    std::unique_lock<std::mutex> lk(physics.lock);
+    physics.cv.wait(lk, [] { return !physics.busy.load(); });
+}
+
+void Physics_Shutdown()
+{
+    Physics_Wait();
+    Physics_StopThread();
+
+    Physics_ClearEvents();
+    Arena::free(&physics.move_events);
+    Arena::free(&physics.sensor_begin_events);
+    Arena::free(&physics.sensor_end_events);
+    Arena::free(&physics.contact_begin_events);
+    Arena::free(&physics.contact_end_events);
+    Arena::free(&physics.contact_hit_events);
+    Arena::free(&physics.writes);
+    Arena::free(&physics.applying_writes);
+    Arena::free(&physics_render_bindings.bindings);
+    physics_render_bindings.index.clear();
+    for (u32 i = 0; i < ARRAY_LENGTH(physics.snapshots); i++) {
+        Arena::free(&physics.snapshots[i].bodies);
+    }
+}
+
+// body transforms are in world space. Writes the body's x/y position and
+// rotation into the GGen's parent-local transform, keeping its world z.
+// Cached world matrices aren't rebuilt until later in the frame, so the
+// parent chain is walked from the local transforms
+static void Physics_SetWorldXform(R_Transform* xform, const b2Transform& body_xform)
+{
+    glm::quat rot
+      = glm::angleAxis(b2Rot_GetAngle(body_xform.q), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    R_Transform* parent = Component_GetXform(xform->parentID);
+    if (!parent) {
+        R_Transform::pos(xform,
+                         glm::vec3(body_xform.p.x, body_xform.p.y, xform->_pos.z));
+        R_Transform::rot(xform, rot);
+        return;
+    }
+
+    glm::mat4 parent_world = glm::mat4(1.0f);
+    glm::quat parent_rot   = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    for (R_Transform* p = parent; p; p = Component_GetXform(p->parentID)) {
+        parent_world = R_Transform::localMatrix(p) * parent_world;
+        parent_rot   = p->_rot * parent_rot;
+    }
+
+    glm::vec3 world_pos = parent_world * glm::vec4(xform->_pos, 1.0f);
+    world_pos.x         = body_xform.p.x;
+    world_pos.y         = body_xform.p.y;
+    R_Transform::pos(xform, glm::inverse(parent_world) * glm::vec4(world_pos, 1.0f));
+    R_Transform::rot(xform, glm::inverse(parent_rot) * rot);
+}
+
+void Physics_BindTransform(SG_ID sg_id, b2BodyId body_id)
+{
+    Physics_Bindings::bind(&physics_render_bindings, sg_id, body_id);
+}
+
+void Physics_SyncTransforms()
+{
+    for (u32 i = 0; i < Physics_Bindings::count(&physics_render_bindings); i++) {
+        Physics_Binding* binding = Physics_Bindings::get(&physics_render_bindings, i);
+        R_Transform* xform       = Component_GetXform(binding->sg_id);
+        if (!xform) { // GGen was freed
+            Physics_Bindings::remove(&physics_render_bindings, i--);
+            continue;
+        }
+
+        b2Transform body_xform;
+        if (!Physics_InterpolatedTransform(binding->body_id, &body_xform)) continue;
+        Physics_SetWorldXform(xform, body_xform);
+    }
+}
+
+bool Physics_InterpolatedTransform(b2BodyId body_id, b2Transform* xform)
+{
+    bool found = false;
+
+    spinlock::lock(&physics.snapshot_lock);
+    Physics_Snapshot* snapshot = &physics.snapshots[physics.front];
+    u32 index                  = body_id.index1 - 1;
+    if (index < ARENA_LENGTH(&snapshot->bodies, Physics_BodyState)) {
+        Physics_BodyState* body
+          = ARENA_GET_TYPE(&snapshot->bodies, Physics_BodyState, index);
+        if (B2_ID_EQUALS(body->body_id, body_id)) {
+            found = true;
+            if (body->step == snapshot->step) {
+                xform->p = b2Lerp(body->prev.p, body->curr.p, snapshot->alpha);
+                xform->q = b2NLerp(body->prev.q, body->curr.q, snapshot->alpha);
+            } else {
+                // didn't move on the last step, nothing to interpolate
+                *xform = body->curr;
+            }
+        }
+    }
+    spinlock::unlock(&physics.snapshot_lock);
+
+    return found;
+}
+
+f32 Physics_Alpha()
+{
+    spinlock::lock(&physics.snapshot_lock);
+    f32 alpha = physics.snapshots[physics.front].alpha;
+    spinlock::unlock(&physics.snapshot_lock);
+    return alpha;
+}
+
+bool Physics_Busy()
+{
+    return physics.busy.load();
+}
+
+bool Physics_BodySnapshot(b2BodyId body_id, Physics_BodyView* view)
+{
+    bool found = false;
+
+    spinlock::lock(&physics.snapshot_lock);
+    Physics_Snapshot* snapshot = &physics.snapshots[physics.front];
+    u32 index                  = body_id.index1 - 1;
+    if (index < ARENA_LENGTH(&snapshot->bodies, Physics_BodyState)) {
+        Physics_BodyState* body
+          = ARENA_GET_TYPE(&snapshot->bodies, Physics_BodyState, index);
+        if (B2_ID_EQUALS(body->body_id, body_id)) {
+            found                  = true;
+            view->xform            = body->curr;
+            view->linear_velocity  = body->linear_velocity;
+            view->angular_velocity = body->angular_velocity;
+        }
+    }
+    spinlock::unlock(&physics.snapshot_lock);
+
+    return found;
+}
+
+void Physics_BodyWrite(const Physics_Write* write)
+{
+    if (Physics_Busy()) {
+        spinlock::lock(&physics.writes_lock);
+        *ARENA_PUSH_TYPE(&physics.writes, Physics_Write) = *write;
+        spinlock::unlock(&physics.writes_lock);
+        return;
+    }
+
+    // nothing is stepping, so both snapshots are safe to update. Readers of the
+    // front one still go through the lock
+    bool teleport = Physics_ApplyWrite(write);
+    if (!Physics_InSimulatedWorld(write->body_id) || !b2Body_IsValid(write->body_id)) {
+        return;
+    }
+    Physics_SnapshotWrite(&physics.snapshots[1 - physics.front], write->body_id,
+                          teleport);
+    spinlock::lock(&physics.snapshot_lock);
+    Physics_SnapshotWrite(&physics.snapshots[physics.front], write->body_id, teleport);
+    spinlock::unlock(&physics.snapshot_lock);
+}
+
+static bool Physics_IsSimulating(b2WorldId world_id)
+{
+    return *(u32*)&world_id == physics.world_id && physics.batch > 0;
+}
+
+b2BodyEvents Physics_GetBodyEvents(b2WorldId world_id)
+{
+    if (!Physics_IsSimulating(world_id)) return b2World_GetBodyEvents(world_id);
+
+    b2BodyEvents events = {};
+    events.moveEvents   = (b2BodyMoveEvent*)physics.move_events.base;
+    events.moveCount    = ARENA_LENGTH(&physics.move_events, b2BodyMoveEvent);
+    return events;
+}
+
+b2SensorEvents Physics_GetSensorEvents(b2WorldId world_id)
+{
+    if (!Physics_IsSimulating(world_id)) return b2World_GetSensorEvents(world_id);
+
+    b2SensorEvents events = {};
+    events.beginEvents = (b2SensorBeginTouchEvent*)physics.sensor_begin_events.base;
+    events.beginCount
+      = ARENA_LENGTH(&physics.sensor_begin_events, b2SensorBeginTouchEvent);
+    events.endEvents = (b2SensorEndTouchEvent*)physics.sensor_end_events.base;
+    events.endCount  = ARENA_LENGTH(&physics.sensor_end_events, b2SensorEndTouchEvent);
+    return events;
+}
+
+b2ContactEvents Physics_GetContactEvents(b2WorldId world_id)
+{
+    if (!Physics_IsSimulating(world_id)) return b2World_GetContactEvents(world_id);
+
+    b2ContactEvents events = {};
+    events.beginEvents = (b2ContactBeginTouchEvent*)physics.contact_begin_events.base;
+    events.beginCount
+      = ARENA_LENGTH(&physics.contact_begin_events, b2ContactBeginTouchEvent);
+    events.endEvents = (b2ContactEndTouchEvent*)physics.contact_end_events.base;
+    events.endCount
+      = ARENA_LENGTH(&physics.contact_end_events, b2ContactEndTouchEvent);
+    events.hitEvents = (b2ContactHitEvent*)physics.contact_hit_events.base;
+    events.hitCount  = ARENA_LENGTH(&physics.contact_hit_events, b2ContactHitEvent);
+    return events;
+}
+
+// ============================================================================
+// Physics_Bindings
+// ============================================================================
+
+void Physics_Bindings::bind(Physics_Bindings* b, SG_ID sg_id, b2BodyId body_id)
+{
+    auto it = b->index.find(sg_id);
+    if (B2_IS_NULL(body_id)) {
+        if (it != b->index.end()) remove(b, it->second);
+        return;
+    }
+
+    if (it != b->index.end()) {
+        get(b, it->second)->body_id = body_id;
+        return;
+    }
+
+    b->index[sg_id]          = count(b);
+    Physics_Binding* binding = ARENA_PUSH_TYPE(&b->bindings, Physics_Binding);
+    binding->sg_id           = sg_id;
+    binding->body_id         = body_id;
+}
+
+void Physics_Bindings::remove(Physics_Bindings* b, u32 i)
+{
+    ASSERT(i < count(b));
+    b->index.erase(get(b, i)->sg_id);
+    u32 last = count(b) - 1;
+    if (i != last) {
+        *get(b, i)                 = *get(b, last);
+        b->index[get(b, i)->sg_id] = i;
+    }
+    ARENA_POP_TYPE(&b->bindings, Physics_Binding);
+}
+
+u32 Physics_Bindings::count(Physics_Bindings* b)
+{
+    return ARENA_LENGTH(&b->bindings, Physics_Binding);
+}
+
+Physics_Binding* Physics_Bindings::get(Physics_Bindings* b, u32 i)
+{
+    return ARENA_GET_TYPE(&b->bindings, Physics_Binding, i);
+}
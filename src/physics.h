@@ -0,0 +1,165 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include "core/macros.h"
+#include "core/memory.h"
+#include "sg_component.h"
+
+#include <unordered_map>
+
+struct b2_SimulateDesc;
+
+// ============================================================================
+// Physics
+// ============================================================================
+// Steps the active box2d world (b2_SimulateDesc.world_id). The render thread
+// calls Physics_Update() once per frame from the critical section with the
+// frame's dt.
+//
+// With a fixed timestep, time is accumulated and consumed in steps of
+// b2_SimulateDesc.fixed_timestep (at most PHYSICS_MAX_STEPS_PER_FRAME per
+// frame). The leftover fraction of a step becomes the interpolation alpha used
+// by Physics_InterpolatedTransform(), so rendering stays smooth when the frame
+// rate and the simulation rate differ. A fixed_timestep <= 0 takes a single
+// step of the frame's dt, which is how ChuGL has always stepped.
+//
+// With b2_SimulateDesc.threaded the steps run on a dedicated physics thread.
+// They overlap the next ChucK frame and the renderer instead of lengthening
+// the critical section. Anything that touches the box2d world from another
+// thread must call Physics_Wait() first; the ulib_box2d_accessAllowed macro
+// does this for the ChucK API.
+//
+// Body transforms and velocities are double buffered: the stepping thread
+// writes the back snapshot and publishes it when the frame's steps are done,
+// so Physics_InterpolatedTransform() and Physics_BodySnapshot() read a
+// consistent snapshot without waiting. Common body writes (transform,
+// velocity, forces and impulses) go through Physics_BodyWrite(), which queues
+// them while the physics thread is busy and applies them at the start of the
+// next batch, so per-frame body access from ChucK never blocks on a step.
+
+#define PHYSICS_MAX_STEPS_PER_FRAME 8
+
+// render thread only
+void Physics_Update(const b2_SimulateDesc* desc, f64 dt);
+void Physics_Shutdown();
+
+// blocks until the steps started by the last Physics_Update() have finished.
+// Returns immediately when stepping on the render thread.
+void Physics_Wait();
+
+// thread-safe, never waits on the physics thread.
+// Returns false if the body has not been moved by the simulation yet
+bool Physics_InterpolatedTransform(b2BodyId body_id, b2Transform* xform);
+f32 Physics_Alpha();
+
+// true while the physics thread is stepping. Only changes from the render
+// thread's critical section, so it stays put for the rest of a ChucK frame
+bool Physics_Busy();
+
+struct Physics_BodyView {
+    b2Transform xform;
+    b2Vec2 linear_velocity;
+    f32 angular_velocity;
+};
+
+// thread-safe, never waits on the physics thread. The body as of the last
+// published step, not interpolated. Returns false if the body is not in the
+// snapshot
+bool Physics_BodySnapshot(b2BodyId body_id, Physics_BodyView* view);
+
+enum Physics_WriteType : u8 {
+    PHYSICS_WRITE_TRANSFORM = 0,
+    PHYSICS_WRITE_POSITION, // keeps the rotation
+    PHYSICS_WRITE_ROTATION, // keeps the position
+    PHYSICS_WRITE_LINEAR_VELOCITY,
+    PHYSICS_WRITE_ANGULAR_VELOCITY,
+    PHYSICS_WRITE_FORCE,
+    PHYSICS_WRITE_FORCE_TO_CENTER,
+    PHYSICS_WRITE_TORQUE,
+    PHYSICS_WRITE_LINEAR_IMPULSE,
+    PHYSICS_WRITE_LINEAR_IMPULSE_TO_CENTER,
+    PHYSICS_WRITE_ANGULAR_IMPULSE,
+};
+
+struct Physics_Write {
+    Physics_WriteType type;
+    b2BodyId body_id;
+    b2Vec2 v;     // position, linear velocity, force or linear impulse
+    b2Vec2 point; // world point a force or impulse is applied at
+    b2Rot q;
+    f32 f; // angular velocity, torque or angular impulse
+    bool wake;
+};
+
+// audio thread. Applied right away when nothing is stepping, otherwise queued
+// for the start of the next batch. Transform writes also update the body's
+// snapshot entry, so bodies the simulation doesn't move (asleep, static,
+// kinematic at rest) still show up where they were placed
+void Physics_BodyWrite(const Physics_Write* write);
+
+// Events accumulated over every step of the last Physics_Update(). box2d only
+// keeps the events of the most recent step, which would drop events whenever
+// a frame takes several fixed steps. Worlds that aren't being simulated fall
+// back to box2d's own event buffers.
+// Call Physics_Wait() first. Valid until the next Physics_Update().
+b2BodyEvents Physics_GetBodyEvents(b2WorldId world_id);
+b2SensorEvents Physics_GetSensorEvents(b2WorldId world_id);
+b2ContactEvents Physics_GetContactEvents(b2WorldId world_id);
+
+// ============================================================================
+// Physics_Bindings
+// ============================================================================
+// GGens that follow a box2d body. The audio and render threads each keep their
+// own table and copy the interpolated snapshot into SG_Transform and
+// R_Transform respectively, so bound GGens cost no VM calls or commands per
+// frame. Only x/y position and rotation about z are written; z and scale are
+// left alone. Body transforms are in world space and are converted into the
+// GGen's parent space, so bound GGens may be parented.
+
+struct Physics_Binding {
+    SG_ID sg_id;
+    b2BodyId body_id;
+};
+
+struct Physics_Bindings {
+    Arena bindings;                       // Physics_Binding, dense for iteration
+    std::unordered_map<SG_ID, u32> index; // sg_id --> index into bindings
+
+    // a GGen follows at most one body. A null body_id removes the binding
+    static void bind(Physics_Bindings* b, SG_ID sg_id, b2BodyId body_id);
+    static void remove(Physics_Bindings* b, u32 i);
+    static u32 count(Physics_Bindings* b);
+    static Physics_Binding* get(Physics_Bindings* b, u32 i);
+};
+
+// render thread. Physics_SyncTransforms() runs after Physics_Update()
+void Physics_BindTransform(SG_ID sg_id, b2BodyId body_id);
+void Physics_SyncTransforms();
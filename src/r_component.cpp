@@ -30,21 +30,30 @@
 #include "geometry.h"
 #include "graphics.h"
 #include "shaders.h"
+#include "text_layout.h"
+#include "texture_compress.h"
 
 #include "compressed_fonts.h"
 
 #include "core/file.h"
+#include "core/jobs.h"
 #include "core/log.h"
 #include "core/spinlock.h"
 
 #include <stb/stb_image.h>
 
+#include <glm/gtc/packing.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include <sr_webcam/include/sr_webcam.h>
 
 #include <sokol/sokol_time.h>
 
+#include <chrono>
+#include <new>        // placement new
+#include <sys/stat.h> // stat, to key video indices on file size + mtime
+#include <vector>
+
 static int compareSGIDs(const void* a, const void* b, void* udata)
 {
     return *(SG_ID*)a - *(SG_ID*)b;
@@ -379,8 +388,10 @@ static void _Transform_RebuildDescendants(R_Scene* scene, R_Transform* xform,
         R_Scene::markPrimitiveStale(scene, xform);
     }
 
-    // TODO ==optimize==: this is where we would mark lights as stale
-    // For now we rebuild the light storage buffer every frame, no memoization
+    // light needs its slot in the scene light buffer re-uploaded
+    if (xform->type == SG_COMPONENT_LIGHT) {
+        ((R_Light*)xform)->light_uniforms_stale = true;
+    }
 
     // rebuild local mat
     if (xform->_stale == R_Transform_STALE_LOCAL)
@@ -389,6 +400,7 @@ static void _Transform_RebuildDescendants(R_Scene* scene, R_Transform* xform,
     // always rebuild world mat
     xform->world  = (*parentWorld) * xform->local;
     xform->normal = glm::transpose(glm::inverse(xform->world));
+    ++xform->world_version;
 
     // set fresh
     xform->_stale = R_Transform_STALE_NONE;
@@ -520,12 +532,16 @@ void R_Geometry::init(R_Geometry* geo)
 
 u32 R_Geometry::indexCount(R_Geometry* geo)
 {
+    // simplified levels follow level 0 in the index buffer
+    if (geo->lod_count > 0) return geo->lod_index_count[0];
     return geo->gpu_index_buffer.size / sizeof(u32);
 }
 
-u32 R_Geometry::wireframeIndicesCount(R_Geometry* geo)
+u32 R_Geometry::wireframeIndicesCount(R_Geometry* geo, u32 tri_count)
 {
-    return geo->gpu_wireframe_index_buffer.size / sizeof(u32);
+    tri_count = MIN(tri_count, geo->wireframe_tri_count);
+    if (tri_count == 0) return 0;
+    return geo->wireframe_tri_edge_end_MALLOC[tri_count - 1] * 2;
 }
 
 u32 R_Geometry::vertexCount(R_Geometry* geo)
@@ -536,6 +552,13 @@ u32 R_Geometry::vertexCount(R_Geometry* geo)
            / (sizeof(f32) * geo->vertex_attribute_num_components[0]);
 }
 
+u32 R_Geometry::drawVertexCount(R_Geometry* geo)
+{
+    u32 count = (geo->vertex_count >= 0) ? geo->vertex_count : vertexCount(geo);
+    if (geo->indices_count >= 0) count = MIN(count, (u32)geo->indices_count);
+    return count;
+}
+
 // returns # of contiguous non-zero vertex attributes
 u32 R_Geometry::vertexAttributeCount(R_Geometry* geo)
 {
@@ -545,6 +568,188 @@ u32 R_Geometry::vertexAttributeCount(R_Geometry* geo)
     return ARRAY_LENGTH(geo->vertex_attribute_num_components);
 }
 
+// ----------------------------------------------------------------------------
+// R_Geometry LOD chains
+// ----------------------------------------------------------------------------
+// Levels are simplified with Geometry_simplify() on the Jobs pool from copies of
+// the positions and level 0 indices. Finished chains are pushed onto a completion
+// queue and uploaded by R_Geometry::flushLODJobs()
+
+struct R_GeometryLODJob {
+    SG_ID geo_id;
+    int levels;
+    u32 vertex_count;
+    u32 index_capacity;
+    f32* positions_OWNED;
+    u32* indices_OWNED; // level 0 followed by the simplified levels
+
+    int lod_count;
+    u32 lod_index_offset[CHUGL_GEOMETRY_MAX_LODS];
+    u32 lod_index_count[CHUGL_GEOMETRY_MAX_LODS];
+};
+
+static struct {
+    spinlock lock;   // guards completed
+    Arena completed; // R_GeometryLODJob*, written by workers
+    Arena draining;  // R_GeometryLODJob*, render thread only
+    Arena stale;     // SG_ID of geometries to regenerate, render thread only
+} r_geometry_lod;
+
+static void R_Geometry_MarkLODStale(R_Geometry* geo)
+{
+    // a job in flight was built from the old data, drop it when it completes
+    geo->pending_lod = NULL;
+    if (geo->lod_levels <= 1 || geo->lod_stale) return;
+    geo->lod_stale                                 = true;
+    *ARENA_PUSH_TYPE(&r_geometry_lod.stale, SG_ID) = geo->id;
+}
+
+static void R_Geometry_LODJobRun(void* udata)
+{
+    R_GeometryLODJob* job = (R_GeometryLODJob*)udata;
+
+    bool valid = true;
+    for (u32 i = 0; i < job->lod_index_count[0]; i++) {
+        if (job->indices_OWNED[i] >= job->vertex_count) valid = false;
+    }
+
+    for (int level = 1; valid && level < job->levels; level++) {
+        u32 src_offset = job->lod_index_offset[level - 1];
+        u32 src_count  = job->lod_index_count[level - 1];
+        u32 dst_offset = src_offset + src_count;
+        if (dst_offset + src_count > job->index_capacity) break;
+
+        u32 count = Geometry_simplify(
+          job->indices_OWNED + dst_offset, job->indices_OWNED + src_offset, src_count,
+          job->positions_OWNED, job->vertex_count, src_count / 2);
+
+        // not worth a level if simplification got stuck
+        if (count == 0 || count > src_count * 9 / 10) break;
+        job->lod_index_offset[level] = dst_offset;
+        job->lod_index_count[level]  = count;
+        job->lod_count               = level + 1;
+    }
+
+    // after this the render thread owns the job
+    spinlock::lock(&r_geometry_lod.lock);
+    *ARENA_PUSH_TYPE(&r_geometry_lod.completed, R_GeometryLODJob*) = job;
+    spinlock::unlock(&r_geometry_lod.lock);
+}
+
+static void R_Geometry_FreeLODJob(R_GeometryLODJob* job)
+{
+    FREE(job->positions_OWNED);
+    FREE(job->indices_OWNED);
+    FREE_TYPE(R_GeometryLODJob, job);
+}
+
+static void R_Geometry_SubmitLODJob(R_Geometry* geo)
+{
+    u32 index_count = R_Geometry::indexCount(geo);
+    if (!geo->positions_MALLOC || !geo->index_buffer_MALLOC || index_count < 3) return;
+
+    // worst case every level keeps 9/10 of the previous one, see
+    // R_Geometry_LODJobRun(). level k is simplified into the space after level
+    // k-1, which must hold a full copy of level k-1 first
+    u64 index_capacity = index_count;
+    u64 level_offset = 0, level_count = index_count;
+    for (int level = 1; level < geo->lod_levels; level++) {
+        level_offset += level_count;
+        index_capacity = MAX(index_capacity, level_offset + level_count);
+        level_count    = level_count * 9 / 10;
+    }
+
+    R_GeometryLODJob* job = ALLOCATE_TYPE(R_GeometryLODJob);
+    memset(job, 0, sizeof(*job));
+    job->geo_id             = geo->id;
+    job->levels             = geo->lod_levels;
+    job->vertex_count       = geo->positions_count;
+    job->index_capacity     = (u32)index_capacity;
+    job->lod_count          = 1;
+    job->lod_index_count[0] = index_count;
+    job->positions_OWNED    = ALLOCATE_COUNT(f32, geo->positions_count * 3);
+    job->indices_OWNED      = ALLOCATE_COUNT(u32, job->index_capacity);
+    memcpy(job->positions_OWNED, geo->positions_MALLOC,
+           geo->positions_count * 3 * sizeof(f32));
+    memcpy(job->indices_OWNED, geo->index_buffer_MALLOC, index_count * sizeof(u32));
+
+    geo->pending_lod = job;
+    Jobs_Submit(R_Geometry_LODJobRun, job);
+}
+
+void R_Geometry::setLOD(R_Geometry* geo, int levels, f32* thresholds, int force)
+{
+    memcpy(geo->lod_thresholds, thresholds, sizeof(geo->lod_thresholds));
+    geo->lod_force = force;
+
+    levels = CLAMP(levels, 1, CHUGL_GEOMETRY_MAX_LODS);
+    if (levels == geo->lod_levels) return;
+    geo->lod_levels = levels;
+    R_Geometry_MarkLODStale(geo);
+}
+
+bool R_Geometry::usesLOD(R_Geometry* geo, R_Material* material)
+{
+    // partial draws and line topologies index the buffer directly
+    return geo->lod_levels > 1 && geo->lod_count > 1 && geo->indices_count < 0
+           && !material->pso.wireframe
+           && material->pso.primitive_topology == WGPUPrimitiveTopology_TriangleList;
+}
+
+int R_Geometry::selectLOD(R_Geometry* geo, f32 screen_size)
+{
+    if (geo->lod_force >= 0) return MIN(geo->lod_force, geo->lod_count - 1);
+
+    int level = 0;
+    while (level < geo->lod_count - 1 && screen_size < geo->lod_thresholds[level]) {
+        ++level;
+    }
+    return level;
+}
+
+void R_Geometry::flushLODJobs(GraphicsContext* gctx)
+{
+    for (int i = 0; i < ARENA_LENGTH(&r_geometry_lod.stale, SG_ID); i++) {
+        R_Geometry* geo
+          = Component_GetGeometry(*ARENA_GET_TYPE(&r_geometry_lod.stale, SG_ID, i));
+        if (!geo) continue;
+        geo->lod_stale = false;
+        if (geo->lod_levels > 1) R_Geometry_SubmitLODJob(geo);
+    }
+    Arena::clear(&r_geometry_lod.stale);
+
+    spinlock::lock(&r_geometry_lod.lock);
+    Arena tmp                = r_geometry_lod.completed;
+    r_geometry_lod.completed = r_geometry_lod.draining;
+    r_geometry_lod.draining  = tmp;
+    spinlock::unlock(&r_geometry_lod.lock);
+
+    Arena* draining = &r_geometry_lod.draining;
+    for (int i = 0; i < ARENA_LENGTH(draining, R_GeometryLODJob*); i++) {
+        R_GeometryLODJob* job = *ARENA_GET_TYPE(draining, R_GeometryLODJob*, i);
+        R_Geometry* geo       = Component_GetGeometry(job->geo_id);
+
+        // skip if geometry was freed, or its data changed since the job started
+        if (geo && geo->pending_lod == job) {
+            u32 last        = job->lod_count - 1;
+            u32 index_count = job->lod_index_offset[last] + job->lod_index_count[last];
+            GPU_Buffer::write(gctx, &geo->gpu_index_buffer,
+                              (WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst),
+                              job->indices_OWNED, index_count * sizeof(u32));
+            geo->lod_count = job->lod_count;
+            memcpy(geo->lod_index_offset, job->lod_index_offset,
+                   sizeof(geo->lod_index_offset));
+            memcpy(geo->lod_index_count, job->lod_index_count,
+                   sizeof(geo->lod_index_count));
+            geo->pending_lod = NULL;
+            ++geo->version;
+        }
+
+        R_Geometry_FreeLODJob(job);
+    }
+    Arena::clear(draining);
+}
+
 void R_Geometry::setVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
                                     u32 location, u32 num_components_per_attrib,
                                     void* data, size_t size)
@@ -552,13 +757,55 @@ void R_Geometry::setVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
     ASSERT(location >= 0
            && location < ARRAY_LENGTH(geo->vertex_attribute_num_components));
 
+    u32 prev_vertex_count = R_Geometry::vertexCount(geo);
     geo->vertex_attribute_num_components[location] = num_components_per_attrib;
     GPU_Buffer::write(gctx, &geo->gpu_vertex_buffers[location],
                       (WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst), data, size);
 
     if (location == SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION) {
-        geo->gpu_wireframe_index_buffer_stale = 1;
+        // moving vertices keeps the edges, non-indexed edges follow the vertex count
+        if (R_Geometry::indexCount(geo) == 0
+            && R_Geometry::vertexCount(geo) != prev_vertex_count) {
+            geo->gpu_wireframe_index_buffer_stale = 1;
+        }
+
+        // bounding sphere around the aabb center
+        geo->bounding_sphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        size_t num_positions = size / (3 * sizeof(f32));
+        if (num_components_per_attrib == 3 && num_positions > 0) {
+            glm::vec3* positions = (glm::vec3*)data;
+            glm::vec3 aabb_min   = positions[0];
+            glm::vec3 aabb_max   = positions[0];
+            for (size_t i = 1; i < num_positions; ++i) {
+                aabb_min = glm::min(aabb_min, positions[i]);
+                aabb_max = glm::max(aabb_max, positions[i]);
+            }
+            glm::vec3 center = (aabb_min + aabb_max) * .5f;
+            f32 radius2      = 0.0f;
+            for (size_t i = 0; i < num_positions; ++i) {
+                glm::vec3 d = positions[i] - center;
+                radius2     = MAX(radius2, glm::dot(d, d));
+            }
+            geo->bounding_sphere = glm::vec4(center, sqrtf(radius2));
+        }
+
+        // kept for LOD generation. Existing levels index the same vertices, so
+        // they stay usable until the chain is regenerated if the count matches
+        u32 positions_count = (num_components_per_attrib == 3) ? num_positions : 0;
+        // otherwise truncate the index buffer to level 0 until new levels arrive
+        if (positions_count != geo->positions_count && geo->lod_count > 0) {
+            geo->gpu_index_buffer.size = geo->lod_index_count[0] * sizeof(u32);
+            geo->lod_count             = 0;
+        }
+        geo->positions_count  = positions_count;
+        geo->positions_MALLOC = (f32*)realloc(geo->positions_MALLOC,
+                                              positions_count * 3 * sizeof(f32));
+        if (positions_count) {
+            memcpy(geo->positions_MALLOC, data, positions_count * 3 * sizeof(f32));
+        }
+        R_Geometry_MarkLODStale(geo);
     }
+    ++geo->version;
 }
 
 void R_Geometry::setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
@@ -570,6 +817,9 @@ void R_Geometry::setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices
     geo->index_buffer_MALLOC = (u32*)realloc(geo->index_buffer_MALLOC, size);
     memcpy(geo->index_buffer_MALLOC, indices, size);
     geo->gpu_wireframe_index_buffer_stale = true;
+    geo->lod_count                        = 0; // buffer only holds level 0 now
+    R_Geometry_MarkLODStale(geo);
+    ++geo->version;
 }
 
 bool R_Geometry::usesVertexPulling(R_Geometry* geo)
@@ -597,6 +847,7 @@ void R_Geometry::setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo
 {
     GPU_Buffer::write(gctx, &geo->pull_buffers[location], WGPUBufferUsage_Storage, data,
                       size_bytes);
+    ++geo->version;
 }
 
 void R_Geometry::rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx)
@@ -606,39 +857,23 @@ void R_Geometry::rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx)
 
     log_trace("rebuilding wireframe");
 
-    u32 num_indices        = R_Geometry::indexCount(geo);
-    int wireframe_i        = 0;
-    u64 size_bytes         = 0;
-    u32* wireframe_indices = NULL;
-    if (num_indices > 0) {
-        wireframe_indices = ARENA_PUSH_COUNT(&gctx->frame_arena, u32, num_indices * 2);
-        size_bytes        = sizeof(u32) * num_indices * 2;
-        for (int i = 0; i < num_indices; i += 3) {
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 1];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 1];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 2];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 2];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i];
-        }
-        ASSERT(wireframe_i == num_indices * 2);
-    } else {
-        u32 num_vertices  = R_Geometry::vertexCount(geo);
-        wireframe_indices = ARENA_PUSH_COUNT(&gctx->frame_arena, u32, num_vertices * 2);
-        size_bytes        = sizeof(u32) * num_vertices * 2;
-        for (int i = 0; i < num_vertices; i += 3) {
-            wireframe_indices[wireframe_i++] = i;
-            wireframe_indices[wireframe_i++] = i + 1;
-            wireframe_indices[wireframe_i++] = i + 1;
-            wireframe_indices[wireframe_i++] = i + 2;
-            wireframe_indices[wireframe_i++] = i + 2;
-            wireframe_indices[wireframe_i++] = i;
-        }
-        ASSERT(wireframe_i == num_vertices * 2);
-    }
+    // edges shared by neighboring triangles are drawn once
+    bool indexed    = R_Geometry::indexCount(geo) > 0;
+    u32 num_indices = R_Geometry::indexCount(geo);
+    if (!indexed) num_indices = R_Geometry::vertexCount(geo);
+    u32 tri_count = num_indices / 3;
+    u32* wireframe_indices
+      = ARENA_PUSH_COUNT(&gctx->frame_arena, u32, MAX(num_indices * 2, 1));
+    geo->wireframe_tri_edge_end_MALLOC = (u32*)realloc(
+      geo->wireframe_tri_edge_end_MALLOC, MAX(tri_count, 1) * sizeof(u32));
+    geo->wireframe_tri_count = tri_count;
+    u32 edge_count
+      = Geometry_buildEdges(wireframe_indices, geo->wireframe_tri_edge_end_MALLOC,
+                            indexed ? geo->index_buffer_MALLOC : NULL, num_indices);
+
     GPU_Buffer::write(gctx, &geo->gpu_wireframe_index_buffer,
                       (WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst),
-                      wireframe_indices, size_bytes);
+                      wireframe_indices, edge_count * 2 * sizeof(u32));
 }
 
 // ============================================================================
@@ -673,63 +908,116 @@ struct LoadImageParams {
     const char* filepath;
 };
 
-static LoadImageResult R_Texture_LoadImage(LoadImageParams p)
+static void* R_Texture_StbiLoad(LoadImageParams* p, int bits_per_channel,
+                                LoadImageResult* r)
 {
-    LoadImageResult result = {};
     // Force loading 3 channel images to 4 channel by stb becasue Dawn
     // doesn't support 3 channel formats currently. The group is discussing
     // on whether webgpu shoud support 3 channel format.
     // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
-    i32 desired_comps = STBI_rgb_alpha; // force 4 channels
-
-    stbi_set_flip_vertically_on_load(p.flip_y);
-
-    // currently only support ldr (TODO add hdr f16 and f32)
-    ASSERT(p.format == WGPUTextureFormat_RGBA8Unorm);
-
-    if (p.type == LoadImageType_File) {
-        result.pixel_data_OWNED = stbi_load(p.filepath,         //
-                                            &result.width,      //
-                                            &result.height,     //
-                                            &result.components, //
-                                            desired_comps       //
-        );
-    } else if (p.type == LoadImageType_Raw) {
-        // STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer,
-        // int len   , int *x, int *y, int *channels_in_file, int desired_channels);
-        result.pixel_data_OWNED = stbi_load_from_memory(p.buffer, p.buffer_len,
-                                                        &result.width,      //
-                                                        &result.height,     //
-                                                        &result.components, //
-                                                        desired_comps       //
-        );
-    } else {
-        UNREACHABLE;
+    const i32 desired_comps = STBI_rgb_alpha; // force 4 channels
+
+    if (p->type == LoadImageType_File) {
+        switch (bits_per_channel) {
+            case 8:
+                return stbi_load(p->filepath, &r->width, &r->height, &r->components,
+                                 desired_comps);
+            case 16:
+                return stbi_load_16(p->filepath, &r->width, &r->height,
+                                    &r->components, desired_comps);
+            case 32:
+                return stbi_loadf(p->filepath, &r->width, &r->height, &r->components,
+                                  desired_comps);
+        }
+    } else if (p->type == LoadImageType_Raw) {
+        switch (bits_per_channel) {
+            case 8:
+                return stbi_load_from_memory(p->buffer, p->buffer_len, &r->width,
+                                             &r->height, &r->components,
+                                             desired_comps);
+            case 16:
+                return stbi_load_16_from_memory(p->buffer, p->buffer_len, &r->width,
+                                                &r->height, &r->components,
+                                                desired_comps);
+            case 32:
+                return stbi_loadf_from_memory(p->buffer, p->buffer_len, &r->width,
+                                              &r->height, &r->components,
+                                              desired_comps);
+        }
     }
-    bool is_hdr = false;
+    UNREACHABLE;
+    return NULL;
+}
 
-    // update byte size
-    if (result.pixel_data_OWNED) {
-        result.pixel_data_size = result.width * result.height * desired_comps;
-    }
+// Decodes into p.format:
+// - RGBA8Unorm: 8 bits per channel, stb tonemaps hdr images
+// - RGBA16Float, RGBA32Float: .hdr images keep their full range, everything
+//   else is decoded at 16 bits per channel and normalized to [0, 1] so 16-bit
+//   pngs don't lose precision
+// Thread-safe, called from the Jobs workers
+static LoadImageResult R_Texture_LoadImage(LoadImageParams p)
+{
+    LoadImageResult result = {};
+
+    // thread-local, this can run on any of the Jobs workers
+    stbi_set_flip_vertically_on_load_thread(p.flip_y);
+
+    bool is_hdr = (p.type == LoadImageType_File) ?
+                    stbi_is_hdr(p.filepath) :
+                    stbi_is_hdr_from_memory(p.buffer, p.buffer_len);
 
-    // if (texture->desc.format == WGPUTextureFormat_RGBA32Float) {
-    //     pixelData = stbi_loadf(filepath,     //
-    //                            &width,       //
-    //                            &height,      //
-    //                            &read_comps,  //
-    //                            desired_comps //
-    //     );
+    switch (p.format) {
+        case WGPUTextureFormat_RGBA8Unorm: {
+            result.pixel_data_OWNED = R_Texture_StbiLoad(&p, 8, &result);
+        } break;
+        case WGPUTextureFormat_RGBA16Float:
+        case WGPUTextureFormat_RGBA32Float: {
+            result.pixel_data_OWNED = R_Texture_StbiLoad(&p, is_hdr ? 32 : 16, &result);
+        } break;
+        default: {
+            log_error("Cannot load image into texture format %s",
+                      G_Util::textureFormatToString(p.format));
+            return result;
+        }
+    }
 
     if (result.pixel_data_OWNED == NULL) {
-        log_error("Couldn't load image from raw data\n. Reason: %s",
+        log_error("Couldn't load image from %s. Reason: %s",
+                  p.type == LoadImageType_File ? p.filepath : "raw data",
                   stbi_failure_reason());
-    } else {
-        log_info("Loaded %s image from raw data (%d, %d, %d / %d)\n",
-                 is_hdr ? "HDR" : "LDR", result.width, result.height, result.components,
-                 desired_comps);
+        return result;
+    }
+
+    // convert to the texture format
+    size_t num_channels = (size_t)result.width * result.height * 4;
+    if (p.format == WGPUTextureFormat_RGBA16Float) {
+        // same or smaller element size, convert in place
+        u16* dst = (u16*)result.pixel_data_OWNED;
+        if (is_hdr) {
+            f32* src = (f32*)result.pixel_data_OWNED;
+            for (size_t i = 0; i < num_channels; i++)
+                dst[i] = glm::packHalf1x16(src[i]);
+        } else {
+            u16* src = (u16*)result.pixel_data_OWNED;
+            for (size_t i = 0; i < num_channels; i++)
+                dst[i] = glm::packHalf1x16(src[i] / (f32)UINT16_MAX);
+        }
+    } else if (p.format == WGPUTextureFormat_RGBA32Float && !is_hdr) {
+        // stbi_image_free() is plain free(), so the new buffer can take its place
+        u16* src = (u16*)result.pixel_data_OWNED;
+        f32* dst = (f32*)malloc(num_channels * sizeof(f32));
+        for (size_t i = 0; i < num_channels; i++) dst[i] = src[i] / (f32)UINT16_MAX;
+        stbi_image_free(src);
+        result.pixel_data_OWNED = dst;
     }
 
+    result.pixel_data_size = num_channels / 4 * G_bytesPerTexel(p.format);
+
+    log_info("Loaded %s image from %s (%d, %d, %d) as %s", is_hdr ? "HDR" : "LDR",
+             p.type == LoadImageType_File ? p.filepath : "raw data", result.width,
+             result.height, result.components,
+             G_Util::textureFormatToString(p.format));
+
     return result;
 }
 
@@ -830,6 +1118,461 @@ void R_Texture::loadCubemap(GraphicsContext* gctx, R_Texture* texture,
     }
 }
 
+// ----------------------------------------------------------------------------
+// R_Texture async loading
+// ----------------------------------------------------------------------------
+// Decoding runs on the Jobs pool, the render thread only touches the GPU.
+// Finished jobs are pushed onto a completion queue which is drained once per
+// frame by R_Texture::flushAsyncLoads()
+
+#define R_TEXTURE_PLACEHOLDER_COLOR { 0.5, 0.5, 0.5, 1.0 }
+
+struct R_TextureLoadJob {
+    SG_ID texture_id; // 0 if already uploaded by R_Texture::finishAsyncLoad()
+    int num_images;   // 1 for 2D textures, 6 for cubemaps
+    LoadImageParams params[6];
+    LoadImageResult results[6];
+    i32 expected_width, expected_height; // 0 to accept any size
+    bool gen_mips;
+    bool compress; // transcode through TextureCache, only if the GPU supports BC
+    bool failed;
+    void* data_OWNED; // copies of filepaths or raw image data
+
+    // filled instead of results[] for KTX2/DDS files and transcoded images
+    CompressedImage compressed;
+
+    // the worker pushes the job to the completion queue before the pool
+    // decrements this, so flushAsyncLoads() only frees jobs that are done
+    Jobs_Counter decode_job;
+};
+
+static struct {
+    spinlock lock;   // guards completed
+    Arena completed; // R_TextureLoadJob*, written by workers
+    Arena draining;  // R_TextureLoadJob*, render thread only
+
+    // placeholder clears recorded while flushing the command queue. Must be
+    // submitted before any decoded image is written to the queue
+    WGPUCommandEncoder clear_encoder;
+} r_texture_loader;
+
+static void R_Texture_DecodeImages(R_TextureLoadJob* job)
+{
+    for (int i = 0; i < job->num_images; i++) {
+        LoadImageResult* result = &job->results[i];
+        *result                 = R_Texture_LoadImage(job->params[i]);
+
+        if (result->pixel_data_OWNED == NULL) {
+            job->failed = true;
+        } else if (job->expected_width
+                   && (result->width != job->expected_width
+                       || result->height != job->expected_height)) {
+            log_warn("image %s changed size since it was loaded (%dx%d vs %dx%d)",
+                     job->params[i].filepath, result->width, result->height,
+                     job->expected_width, job->expected_height);
+            job->failed = true;
+        }
+    }
+}
+
+// BC transcode of a png/jpg through the on-disk TextureCache. Fills either
+// job->compressed or, if the image can't be encoded, job->results[0]. Returns
+// false to fall back to a plain decode
+static bool R_Texture_LoadTranscoded(R_TextureLoadJob* job)
+{
+    LoadImageParams* p = &job->params[0];
+    // hdr and 16-bit images stay float
+    if (p->format != WGPUTextureFormat_RGBA8Unorm) return false;
+
+    // key on the encoded source bytes, hashing is much cheaper than decoding
+    FileReadResult file = {};
+    u8* source          = p->buffer;
+    size_t source_size  = (size_t)p->buffer_len;
+    if (p->type == LoadImageType_File) {
+        file = File_read(p->filepath, false);
+        if (!file.data_owned) return false;
+        source      = (u8*)file.data_owned;
+        source_size = file.size;
+    }
+    defer(free(file.data_owned));
+
+    std::string entry_path
+      = TextureCache_entryPath(source, source_size, p->flip_y, job->gen_mips);
+    if (CompressedImage_load(entry_path.c_str(), &job->compressed)) {
+        log_trace("texture cache hit %s", entry_path.c_str());
+        return true;
+    }
+
+    // miss, decode from the bytes already in memory
+    LoadImageParams raw    = *p;
+    raw.type               = LoadImageType_Raw;
+    raw.buffer             = source;
+    raw.buffer_len         = (int)source_size;
+    LoadImageResult pixels = R_Texture_LoadImage(raw);
+    if (!pixels.pixel_data_OWNED) {
+        job->failed = true;
+        return true;
+    }
+
+    if (!CompressedImage_encodeBC((u8*)pixels.pixel_data_OWNED, pixels.width,
+                                  pixels.height, job->gen_mips, &job->compressed)) {
+        // e.g. not a multiple of 4 in size, upload uncompressed
+        log_info("not compressing %s: %s", p->filepath ? p->filepath : "raw data",
+                 CompressedImage_failureReason());
+        job->results[0] = pixels;
+        return true;
+    }
+    stbi_image_free(pixels.pixel_data_OWNED);
+
+    if (!TextureCache_store(entry_path, &job->compressed)) {
+        log_warn("could not write texture cache entry %s: %s", entry_path.c_str(),
+                 CompressedImage_failureReason());
+    }
+    return true;
+}
+
+static void R_Texture_LoadJobRun(void* udata)
+{
+    R_TextureLoadJob* job = (R_TextureLoadJob*)udata;
+
+    if (job->num_images == 1 && job->params[0].type == LoadImageType_File
+        && CompressedImage_isContainer(job->params[0].filepath)) {
+        if (!CompressedImage_load(job->params[0].filepath, &job->compressed)) {
+            log_warn("could not load texture file '%s': %s", job->params[0].filepath,
+                     CompressedImage_failureReason());
+            job->failed = true;
+        }
+    } else if (job->compress && job->num_images == 1 && R_Texture_LoadTranscoded(job)) {
+        // loaded from the cache, or transcoded
+    } else {
+        R_Texture_DecodeImages(job);
+    }
+
+    // after this the render thread owns the job
+    spinlock::lock(&r_texture_loader.lock);
+    *ARENA_PUSH_TYPE(&r_texture_loader.completed, R_TextureLoadJob*) = job;
+    spinlock::unlock(&r_texture_loader.lock);
+}
+
+
+static void R_Texture_FreeLoadJob(R_TextureLoadJob* job)
+{
+    for (int i = 0; i < job->num_images; i++) {
+        if (job->results[i].pixel_data_OWNED)
+            stbi_image_free(job->results[i].pixel_data_OWNED);
+    }
+    CompressedImage_free(&job->compressed);
+    FREE(job->data_OWNED);
+    FREE_TYPE(R_TextureLoadJob, job);
+}
+
+static void R_Texture_ClearToPlaceholder(GraphicsContext* gctx, R_Texture* texture)
+{
+    if (!(texture->desc.usage & WGPUTextureUsage_RenderAttachment)) return;
+
+    if (!r_texture_loader.clear_encoder) {
+        r_texture_loader.clear_encoder
+          = wgpuDeviceCreateCommandEncoder(gctx->device, NULL);
+    }
+
+    u32 mip_level_count = wgpuTextureGetMipLevelCount(texture->gpu_texture);
+    for (u32 layer = 0; layer < (u32)texture->desc.depth; layer++) {
+        for (u32 mip = 0; mip < mip_level_count; mip++) {
+            WGPUTextureViewDescriptor view_desc = {};
+            view_desc.label                     = "placeholder clear view";
+            view_desc.dimension                 = WGPUTextureViewDimension_2D;
+            view_desc.aspect                    = WGPUTextureAspect_All;
+            view_desc.baseMipLevel              = mip;
+            view_desc.mipLevelCount             = 1;
+            view_desc.baseArrayLayer            = layer;
+            view_desc.arrayLayerCount           = 1;
+            WGPUTextureView view
+              = wgpuTextureCreateView(texture->gpu_texture, &view_desc);
+
+            WGPURenderPassColorAttachment color_attachment = {};
+            color_attachment.view                          = view;
+            color_attachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
+            color_attachment.loadOp     = WGPULoadOp_Clear;
+            color_attachment.storeOp    = WGPUStoreOp_Store;
+            color_attachment.clearValue = R_TEXTURE_PLACEHOLDER_COLOR;
+
+            WGPURenderPassDescriptor pass_desc = {};
+            pass_desc.colorAttachmentCount     = 1;
+            pass_desc.colorAttachments         = &color_attachment;
+
+            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(
+              r_texture_loader.clear_encoder, &pass_desc);
+            wgpuRenderPassEncoderEnd(pass);
+
+            WGPU_RELEASE_RESOURCE(RenderPassEncoder, pass);
+            WGPU_RELEASE_RESOURCE(TextureView, view);
+        }
+    }
+}
+
+static void R_Texture_SubmitPlaceholderClears(GraphicsContext* gctx)
+{
+    if (!r_texture_loader.clear_encoder) return;
+
+    WGPUCommandBuffer command_buffer
+      = wgpuCommandEncoderFinish(r_texture_loader.clear_encoder, NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, r_texture_loader.clear_encoder);
+    wgpuQueueSubmit(gctx->queue, 1, &command_buffer);
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer);
+}
+
+static R_TextureLoadJob* R_Texture_BeginLoadJob(GraphicsContext* gctx,
+                                                R_Texture* texture, int num_images,
+                                                size_t data_size, bool flip_y,
+                                                bool gen_mips, bool compress)
+{
+    // value-initialized, so results and failed start zeroed
+    R_TextureLoadJob* job = new (ALLOCATE_TYPE(R_TextureLoadJob)) R_TextureLoadJob{};
+    job->texture_id       = texture->id;
+    job->num_images       = num_images;
+    job->gen_mips         = gen_mips;
+    job->compress         = compress && gctx->texture_compression_bc;
+    job->data_OWNED       = ALLOCATE_BYTES(void, data_size);
+    for (int i = 0; i < num_images; i++) {
+        job->params[i].format = texture->desc.format;
+        job->params[i].flip_y = flip_y;
+    }
+
+    // a newer load supersedes any pending one
+    texture->pending_load = job;
+    R_Texture_ClearToPlaceholder(gctx, texture);
+
+    return job;
+}
+
+// uploads every (layer, mip) of image as-is. The texture was created as an
+// RGBA8 placeholder, so it is recreated first with the image's format and mip
+// chain. Returns false if the GPU doesn't support the format
+static bool R_Texture_UploadCompressed(GraphicsContext* gctx, R_Texture* texture,
+                                       CompressedImage* image)
+{
+    if (!G_isFormatSupported(gctx, image->format)) {
+        log_warn("could not load texture '%s'", texture->name);
+        log_warn(" |- Reason: format %s is not supported by this GPU",
+                 G_Util::textureFormatToString(image->format));
+        return false;
+    }
+
+    SG_TextureDesc* desc = &texture->desc;
+    if (desc->format != image->format || desc->width != (int)image->width
+        || desc->height != (int)image->height || desc->depth != (int)image->layers
+        || desc->mip_levels != (int)image->mip_levels) {
+        desc->format      = image->format;
+        desc->width       = image->width;
+        desc->height      = image->height;
+        desc->depth       = image->layers;
+        desc->mip_levels  = image->mip_levels;
+        desc->gen_mips    = false;
+        desc->resize_mode = SG_TextureResizeMode_Fixed;
+        // compressed formats can't be render or storage targets
+        if (G_isCompressedFormat(image->format)) {
+            desc->usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst
+                          | WGPUTextureUsage_CopySrc;
+        }
+
+        WGPU_RELEASE_RESOURCE(Texture, texture->gpu_texture);
+        R_Texture::resize(texture, image->width, image->height, gctx->device);
+    }
+
+    G_FormatBlockInfo block = {};
+    G_formatBlockInfo(image->format, &block);
+    for (u32 layer = 0; layer < image->layers; layer++) {
+        for (u32 mip = 0; mip < image->mip_levels; mip++) {
+            G_MipSize size = G_mipLevelSize(image->width, image->height, mip);
+            u32 blocks_x   = (size.width + block.width - 1) / block.width;
+            u32 blocks_y   = (size.height + block.height - 1) / block.height;
+
+            WGPUImageCopyTexture destination = {};
+            destination.texture              = texture->gpu_texture;
+            destination.mipLevel             = mip;
+            destination.origin               = { 0, 0, layer };
+            destination.aspect               = WGPUTextureAspect_All;
+
+            WGPUTextureDataLayout source = {};
+            source.bytesPerRow           = blocks_x * block.bytes;
+            source.rowsPerImage          = blocks_y;
+
+            // extent of a compressed mip is rounded up to whole blocks
+            WGPUExtent3D extent = { blocks_x * block.width, blocks_y * block.height, 1 };
+
+            wgpuQueueWriteTexture(gctx->queue, &destination,
+                                  image->data_OWNED + image->offsets[layer][mip],
+                                  image->sizes[mip], &source, &extent);
+        }
+    }
+    return true;
+}
+
+static void R_Texture_UploadLoadJob(GraphicsContext* gctx, R_Texture* texture,
+                                    R_TextureLoadJob* job,
+                                    WGPUCommandEncoder mip_encoder)
+{
+    ASSERT(texture->pending_load == job);
+    texture->pending_load = NULL;
+
+    if (job->failed) {
+        log_warn("could not load texture '%s', keeping placeholder", texture->name);
+        CQ_PushCommand_G2A_TextureLoaded(texture->id, false, &texture->desc);
+        return;
+    }
+
+    if (job->compressed.data_OWNED) {
+        bool success = R_Texture_UploadCompressed(gctx, texture, &job->compressed);
+        CQ_PushCommand_G2A_TextureLoaded(texture->id, success, &texture->desc);
+        return;
+    }
+
+    for (int i = 0; i < job->num_images; i++) {
+        LoadImageResult* result        = &job->results[i];
+        SG_TextureWriteDesc write_desc = {};
+        write_desc.offset_z            = i; // cubemap face
+        write_desc.width               = result->width;
+        write_desc.height              = result->height;
+        R_Texture::write(gctx, texture, &write_desc, result->pixel_data_OWNED,
+                         result->pixel_data_size);
+    }
+
+    if (job->gen_mips) {
+        if (mip_encoder) {
+            MipMapGenerator_generate(gctx, mip_encoder, texture->gpu_texture,
+                                     texture->name);
+        } else {
+            MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name);
+        }
+    }
+
+    CQ_PushCommand_G2A_TextureLoaded(texture->id, true, &texture->desc);
+}
+
+void R_Texture::loadAsync(GraphicsContext* gctx, R_Texture* texture,
+                          const char* filepath, bool flip_vertically, bool gen_mips,
+                          bool compress)
+{
+    size_t len            = strlen(filepath) + 1;
+    R_TextureLoadJob* job = R_Texture_BeginLoadJob(gctx, texture, 1, len,
+                                                   flip_vertically, gen_mips, compress);
+    memcpy(job->data_OWNED, filepath, len);
+
+    job->params[0].type     = LoadImageType_File;
+    job->params[0].filepath = (const char*)job->data_OWNED;
+
+    Jobs_Submit(R_Texture_LoadJobRun, job, &job->decode_job);
+}
+
+void R_Texture::loadAsync(GraphicsContext* gctx, R_Texture* texture, u8* buffer,
+                          int buffer_len, bool flip_vertically, bool gen_mips,
+                          bool compress)
+{
+    // buffer lives in the command queue, which is recycled next frame
+    R_TextureLoadJob* job = R_Texture_BeginLoadJob(gctx, texture, 1, buffer_len,
+                                                   flip_vertically, gen_mips, compress);
+    memcpy(job->data_OWNED, buffer, buffer_len);
+
+    job->params[0].type       = LoadImageType_Raw;
+    job->params[0].buffer     = (u8*)job->data_OWNED;
+    job->params[0].buffer_len = buffer_len;
+
+    Jobs_Submit(R_Texture_LoadJobRun, job, &job->decode_job);
+}
+
+void R_Texture::loadCubemapAsync(GraphicsContext* gctx, R_Texture* texture,
+                                 const char* right_face_path,
+                                 const char* left_face_path, const char* top_face_path,
+                                 const char* bottom_face_path,
+                                 const char* back_face_path,
+                                 const char* front_face_path, bool flip_y)
+{
+    ASSERT(texture->desc.depth == 6);
+    ASSERT(!texture->desc.gen_mips);
+
+    const char* faces[6] = { right_face_path,  left_face_path, top_face_path,
+                             bottom_face_path, back_face_path, front_face_path };
+
+    size_t lengths[6] = {};
+    size_t total_len  = 0;
+    for (int i = 0; i < 6; i++) {
+        lengths[i] = strlen(faces[i]) + 1;
+        total_len += lengths[i];
+    }
+
+    R_TextureLoadJob* job
+      = R_Texture_BeginLoadJob(gctx, texture, 6, total_len, flip_y, false, false);
+    job->expected_width  = texture->desc.width;
+    job->expected_height = texture->desc.height;
+
+    char* paths = (char*)job->data_OWNED;
+    for (int i = 0; i < 6; i++) {
+        memcpy(paths, faces[i], lengths[i]);
+        job->params[i].type     = LoadImageType_File;
+        job->params[i].filepath = paths;
+        paths += lengths[i];
+    }
+
+    Jobs_Submit(R_Texture_LoadJobRun, job, &job->decode_job);
+}
+
+void R_Texture::finishAsyncLoad(GraphicsContext* gctx, R_Texture* texture)
+{
+    R_TextureLoadJob* job = texture ? texture->pending_load : NULL;
+    if (!job) return;
+
+    // only runs this texture's decode, not whatever else is queued
+    Jobs_WaitOwn(&job->decode_job);
+    R_Texture_SubmitPlaceholderClears(gctx);
+    R_Texture_UploadLoadJob(gctx, texture, job, NULL);
+
+    // job is already on the completion queue, flushAsyncLoads() frees it
+    job->texture_id = 0;
+}
+
+void R_Texture::flushAsyncLoads(GraphicsContext* gctx)
+{
+    R_Texture_SubmitPlaceholderClears(gctx);
+
+    spinlock::lock(&r_texture_loader.lock);
+    Arena tmp                  = r_texture_loader.completed;
+    r_texture_loader.completed = r_texture_loader.draining;
+    r_texture_loader.draining  = tmp;
+    spinlock::unlock(&r_texture_loader.lock);
+
+    Arena* draining = &r_texture_loader.draining;
+    int count       = ARENA_LENGTH(draining, R_TextureLoadJob*);
+    if (count == 0) return;
+
+    WGPUCommandEncoder mip_encoder = wgpuDeviceCreateCommandEncoder(gctx->device, NULL);
+    for (int i = 0; i < count; i++) {
+        R_TextureLoadJob* job = *ARENA_GET_TYPE(draining, R_TextureLoadJob*, i);
+
+        // queued, but the pool still holds its counter. Try again next frame
+        if (!Jobs_Done(&job->decode_job)) {
+            spinlock::lock(&r_texture_loader.lock);
+            *ARENA_PUSH_TYPE(&r_texture_loader.completed, R_TextureLoadJob*) = job;
+            spinlock::unlock(&r_texture_loader.lock);
+            continue;
+        }
+
+        R_Texture* texture = Component_GetTexture(job->texture_id);
+
+        // skip if texture was freed, or superseded by a newer load
+        if (texture && texture->pending_load == job) {
+            R_Texture_UploadLoadJob(gctx, texture, job, mip_encoder);
+        }
+
+        R_Texture_FreeLoadJob(job);
+    }
+    Arena::clear(draining);
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(mip_encoder, NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, mip_encoder);
+    wgpuQueueSubmit(gctx->queue, 1, &command_buffer);
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer);
+}
+
 // ============================================================================
 // R_Material
 // ============================================================================
@@ -958,6 +1701,7 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
     R_Binding* binding = &mat->bindings[location];
     binding->type      = type;
     binding->size      = bytes;
+    ++mat->version;
 
     // create new binding
     switch (type) {
@@ -998,6 +1742,13 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
 // GeometryToXforms (scene helper)
 // ============================================================================
 
+// meshes are batched under the geometry they draw with, see R_Geometry::shared_id
+static SG_ID R_Scene_drawGeoID(R_Transform* mesh)
+{
+    R_Geometry* geo = Component_GetGeometry(mesh->_geoID);
+    return (geo && geo->shared_id) ? geo->shared_id : mesh->_geoID;
+}
+
 struct GeometryToXformKey {
     SG_ID geo_id;
     SG_ID mat_id;
@@ -1101,12 +1852,9 @@ struct GeometryToXforms {
 
             // all xforms should be valid here (can't delete xforms while
             // iterating)
-            bool xform_same_mesh
-              = (xform->_geoID == g2x->key.geo_id && xform->_matID == g2x->key.mat_id);
-            bool xform_same_scene = (xform->scene_id == scene->id);
-            ASSERT(xform && xform_same_mesh && xform_same_scene);
-            UNUSED_VAR(xform_same_mesh);
-            UNUSED_VAR(xform_same_scene);
+            ASSERT(xform && R_Scene_drawGeoID(xform) == g2x->key.geo_id
+                   && xform->_matID == g2x->key.mat_id);
+            ASSERT(xform->scene_id == scene->id);
 
             // world matrix should already have been computed by now
             ASSERT(xform->_stale == R_Transform_STALE_NONE);
@@ -1159,6 +1907,38 @@ static GeometryToXforms* R_Scene_getPrimitive(R_Scene* scene, SG_ID mat_id,
     return g2x;
 }
 
+// ============================================================================
+// R_Frustum
+// ============================================================================
+
+R_Frustum R_Frustum::fromProjectionView(const glm::mat4& proj_view)
+{
+    // Gribb-Hartmann plane extraction, clip space depth is [0, 1]
+    glm::mat4 m       = glm::transpose(proj_view); // rows of proj_view
+    R_Frustum frustum = {};
+    frustum.planes[0] = m[3] + m[0]; // left
+    frustum.planes[1] = m[3] - m[0]; // right
+    frustum.planes[2] = m[3] + m[1]; // bottom
+    frustum.planes[3] = m[3] - m[1]; // top
+    frustum.planes[4] = m[2];        // near
+    frustum.planes[5] = m[3] - m[2]; // far
+
+    for (int i = 0; i < ARRAY_LENGTH(frustum.planes); ++i) {
+        f32 len = glm::length(glm::vec3(frustum.planes[i]));
+        if (len > 0.0f) frustum.planes[i] /= len;
+    }
+    return frustum;
+}
+
+bool R_Frustum::intersectsSphere(R_Frustum* frustum, glm::vec3 center, f32 radius)
+{
+    for (int i = 0; i < ARRAY_LENGTH(frustum->planes); ++i) {
+        const glm::vec4& plane = frustum->planes[i];
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+    }
+    return true;
+}
+
 // ============================================================================
 // R_Scene
 // ============================================================================
@@ -1191,10 +1971,21 @@ void R_Scene::removeSubgraphFromRenderState(R_Scene* scene, R_Transform* root)
         xform->scene_id = 0;
 
         if (xform->type == SG_COMPONENT_LIGHT) {
-            // remove from light set
-            const void* prev_item = hashmap_delete(scene->light_id_set, &xform->id);
-            UNUSED_VAR(prev_item);
-            ASSERT(prev_item);
+            // remove from light buffer slots (via swap-delete with last slot)
+            R_Light* light = (R_Light*)xform;
+            u32 last       = ARENA_LENGTH(&scene->light_ids, SG_ID) - 1;
+            ASSERT(*ARENA_GET_TYPE(&scene->light_ids, SG_ID, light->scene_light_idx)
+                   == light->id);
+            if (light->scene_light_idx != last) {
+                SG_ID moved_id = *ARENA_GET_TYPE(&scene->light_ids, SG_ID, last);
+                *ARENA_GET_TYPE(&scene->light_ids, SG_ID, light->scene_light_idx)
+                  = moved_id;
+                R_Light* moved              = Component_GetLight(moved_id);
+                moved->scene_light_idx      = light->scene_light_idx;
+                moved->light_uniforms_stale = true;
+            }
+            ARENA_POP_TYPE(&scene->light_ids, SG_ID);
+            ARENA_POP_TYPE(&scene->light_uniforms, LightUniforms);
             // TODO: somehow consolidate GText into also being a mesh...
         } else if (xform->type == SG_COMPONENT_MESH) {
             R_Scene::unregisterMesh(scene, xform);
@@ -1229,11 +2020,14 @@ void R_Scene::addSubgraphToRenderState(R_Scene* scene, R_Transform* root)
 
         // lighting logic
         if (xform->type == SG_COMPONENT_LIGHT) {
-            // add light to scene
-            const void* replaced = hashmap_set(scene->light_id_set, &xform->id);
-            // light should not already be in scene
-            UNUSED_VAR(replaced);
-            ASSERT(!replaced);
+            // add light to the end of the light buffer
+            R_Light* light              = (R_Light*)xform;
+            light->scene_light_idx      = ARENA_LENGTH(&scene->light_ids, SG_ID);
+            light->light_uniforms_stale = true;
+            light->shadow_hash          = 0; // its layers may have been reused
+            light->shadow_static_cached = false;
+            *ARENA_PUSH_TYPE(&scene->light_ids, SG_ID) = light->id;
+            ARENA_PUSH_ZERO_TYPE(&scene->light_uniforms, LightUniforms);
         } else if (xform->_geoID != 0 && xform->_matID != 0) { // for all renderables
             ASSERT(xform->type == SG_COMPONENT_MESH);
             R_Scene::registerMesh(scene, xform);
@@ -1241,255 +2035,489 @@ void R_Scene::addSubgraphToRenderState(R_Scene* scene, R_Transform* root)
     }
 }
 
-void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
-                                     G_Graph* graph, FrameUniforms* frame_uniforms)
+glm::mat4 R_Light::shadowView(int view_idx, const glm::vec4* cascades)
 {
-    static Arena light_info_arena{};
-    ASSERT(light_info_arena.curr == 0);
-    defer(Arena::clear(&light_info_arena));
-
-    int shadow_generators_count                 = 0;
-    int shadow_generators_total_renderlist_size = 0;
-
-    char string_buf[128] = {};
-    u32 shadow_map_write_indices[SG_LightType_Count]
-      = {}; // which array layer of the shadowmap Texture2D array to write to
-    u32 shadow_map_counts_by_type[SG_LightType_Count] = {};
-
-    // allocate cpu memory for light uniform data
-    int num_lights = R_Scene::numLights(scene);
-    LightUniforms* light_uniforms
-      = ARENA_PUSH_COUNT(&light_info_arena, LightUniforms, num_lights);
-
-    size_t hashmap_idx_DONT_USE = 0;
-    SG_ID* light_id             = NULL;
-    int light_idx               = 0;
-    while (
-      hashmap_iter(scene->light_id_set, &hashmap_idx_DONT_USE, (void**)&light_id)) {
-        LightUniforms* light_uniform = &light_uniforms[light_idx++];
-        *light_uniform               = {};
-
-        R_Light* light = Component_GetLight(*light_id);
-        ASSERT(light);
-        ASSERT(light->_stale == R_Transform_STALE_NONE);
+    switch (desc.type) {
+        case SG_LightType_Spot: {
+            return projection(false) * R_Transform::viewMatrix(this);
+        }
+        case SG_LightType_Directional: {
+            const glm::vec4& c = cascades[view_idx];
+            return glm::ortho(c.x - c.z, c.x + c.z, c.y - c.z, c.y + c.z,
+                              -desc.dirlight_shadow_bounds.depth * .5f,
+                              desc.dirlight_shadow_bounds.depth * .5f)
+                   * R_Transform::viewMatrix(this);
+        }
+        case SG_LightType_Point: {
+            // must match POINT_SHADOW_FACE_DIR and POINT_SHADOW_FACE_UP in the phong
+            // shader
+            static const glm::vec3 face_dir[6]
+              = { { 1, 0, 0 },  { -1, 0, 0 }, { 0, 1, 0 },
+                  { 0, -1, 0 }, { 0, 0, 1 },  { 0, 0, -1 } };
+            static const glm::vec3 face_up[6]
+              = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 },
+                  { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+            glm::vec3 pos = world[3];
+            return projection(false)
+                   * glm::lookAt(pos, pos + face_dir[view_idx], face_up[view_idx]);
+        }
+        default: UNREACHABLE;
+    }
+    return glm::mat4(1.0);
+}
 
-        { // initialize uniform struct
-            light_uniform->color      = light->desc.intensity * light->desc.color;
-            light_uniform->light_type = (i32)light->desc.type;
-            light_uniform->position   = light->world[3];
-            light_uniform->direction  = -glm::normalize(light->world[2]);
+// fits each shadow cascade of a directional light around a depth slice of the
+// camera frustum. returns the cascade count
+static i32 R_Light_fitShadowCascades(R_Light* light, R_Camera* camera, f32 aspect,
+                                     glm::vec4* cascades)
+{
+    i32 count = light->shadowViewCount();
+    if (count == 1 || !camera) {
+        // fixed square around the light
+        for (int i = 0; i < count; ++i) {
+            cascades[i]
+              = glm::vec4(0.0f, 0.0f, light->desc.dirlight_shadow_bounds.size * .5f, 0);
+        }
+        return count;
+    }
 
-            if (light->desc.generates_shadows) {
-                light_uniform->proj_view
-                  = light->projection(false) * R_Transform::viewMatrix(light);
-                light_uniform->generates_shadows = 1;
-                light_uniform->shadow_map_idx
-                  = shadow_map_counts_by_type[light->desc.type];
-                light_uniform->bias = light->desc.bias;
-                ++shadow_map_counts_by_type[light->desc.type];
-                ++shadow_generators_count;
-                shadow_generators_total_renderlist_size
-                  += hashmap_count(light->shadow_render_id_set);
-            }
+    bool perspective = camera->params.camera_type == SG_CameraType_PERPSECTIVE;
+    f32 z_near       = camera->params.near_plane;
+    f32 z_far
+      = MIN(camera->params.far_plane, light->desc.dirlight_shadow_cascades.distance);
+    glm::mat4 light_view = R_Transform::viewMatrix(light);
+
+    f32 slice_near = z_near;
+    for (int i = 0; i < count; ++i) {
+        // blend of logarithmic and uniform splits
+        f32 t     = (f32)(i + 1) / count;
+        f32 split = z_near + (z_far - z_near) * t;
+        if (perspective && z_near > 0.0f && z_far > z_near) {
+            split = glm::mix(split, z_near * powf(z_far / z_near, t), .75f);
+        }
 
-            switch (light->desc.type) {
-                case SG_LightType_None: break;
-                case SG_LightType_Directional: {
-                } break;
-                case SG_LightType_Point: {
-                    light_uniform->point_and_spot_radius  = light->desc.radius;
-                    light_uniform->point_and_spot_falloff = light->desc.falloff;
-
-                } break;
-                case SG_LightType_Spot: {
-                    light_uniform->point_and_spot_radius  = light->desc.radius;
-                    light_uniform->point_and_spot_falloff = light->desc.falloff;
-                    light_uniform->spot_cos_angle_min     = cosf(light->desc.angle_min);
-                    light_uniform->spot_cos_angle_max     = cosf(light->desc.angle_max);
-                    light_uniform->spot_angular_falloff   = light->desc.angle_falloff;
-                } break;
-                default: ASSERT(false);
-            }
+        // bounding sphere of the slice, so the cascade size doesn't change as the
+        // camera rotates
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int c = 0; c < 8; ++c) {
+            f32 depth  = (c & 4) ? split : slice_near;
+            f32 half_h = perspective ?
+                           depth * tanf(camera->params.fov_radians * .5f) :
+                           camera->params.size * .5f;
+            f32 half_w = half_h * aspect;
+            glm::vec4 corner((c & 1) ? half_w : -half_w, (c & 2) ? half_h : -half_h,
+                             -depth, 1.0f);
+            corners[c] = glm::vec3(camera->world * corner);
+            center += corners[c] / 8.0f;
+        }
+        f32 radius = 0.0f;
+        for (int c = 0; c < 8; ++c) {
+            radius = MAX(radius, glm::length(corners[c] - center));
         }
+        radius = MAX(ceilf(radius * 16.0f) / 16.0f, 1.0f / 16.0f);
+
+        // snap to whole shadow map texels so edges don't shimmer as the camera moves
+        glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+        f32 texel              = 2.0f * radius / CHUGL_DIR_SHADOWMAP_DEFAULT_DIM;
+        cascades[i] = glm::vec4(floorf(light_center.x / texel) * texel,
+                                floorf(light_center.y / texel) * texel, radius, split);
+        slice_near  = split;
     }
+    return count;
+}
 
-    // upload light uniforms to gpu
-    GPU_Buffer::write(gctx, &scene->light_info_buffer, WGPUBufferUsage_Storage,
-                      light_info_arena.base, light_info_arena.curr);
-
-    // rebuild shadow map arrays if resized
-    for (int light_type = 0; light_type < SG_LightType_Count; ++light_type) {
-        if (light_type != SG_LightType_Spot && light_type != SG_LightType_Directional)
-            continue; // other types not impl
-
-        int curr_layers = 0;
-        if (light_type == SG_LightType_Spot) {
-            curr_layers
-              = scene->spot_shadow_map_array ?
-                  wgpuTextureGetDepthOrArrayLayers(scene->spot_shadow_map_array) :
-                  0;
-        } else if (light_type == SG_LightType_Directional) {
-            curr_layers
-              = scene->dir_shadow_map_array ?
-                  wgpuTextureGetDepthOrArrayLayers(scene->dir_shadow_map_array) :
-                  0;
+static void R_Light_writeUniforms(R_Light* light, LightUniforms* light_uniform,
+                                  i32 shadow_map_idx, i32 cascade_count,
+                                  const glm::vec4* cascades)
+{
+    *light_uniform            = {};
+    light_uniform->color      = light->desc.intensity * light->desc.color;
+    light_uniform->light_type = (i32)light->desc.type;
+    light_uniform->position   = light->world[3];
+    light_uniform->direction  = -glm::normalize(light->world[2]);
+
+    if (light->desc.generates_shadows) {
+        light_uniform->generates_shadows = 1;
+        light_uniform->shadow_map_idx    = shadow_map_idx;
+        light_uniform->bias              = light->desc.bias;
+        if (light->desc.type != SG_LightType_Point) {
+            light_uniform->proj_view
+              = light->projection(false) * R_Transform::viewMatrix(light);
         }
+        light_uniform->cascade_count = cascade_count;
+        memcpy(light_uniform->cascades, cascades, sizeof(light_uniform->cascades));
+    }
 
-        // add +1 to prevent crash from not binding anything
-        u32 min_layers = shadow_map_counts_by_type[light_type] + 1;
+    switch (light->desc.type) {
+        case SG_LightType_None: break;
+        case SG_LightType_Directional: {
+        } break;
+        case SG_LightType_Point: {
+            light_uniform->point_and_spot_radius  = light->desc.radius;
+            light_uniform->point_and_spot_falloff = light->desc.falloff;
+
+        } break;
+        case SG_LightType_Spot: {
+            light_uniform->point_and_spot_radius  = light->desc.radius;
+            light_uniform->point_and_spot_falloff = light->desc.falloff;
+            light_uniform->spot_cos_angle_min     = cosf(light->desc.angle_min);
+            light_uniform->spot_cos_angle_max     = cosf(light->desc.angle_max);
+            light_uniform->spot_angular_falloff   = light->desc.angle_falloff;
+        } break;
+        default: ASSERT(false);
+    }
+}
+
+// records the shadow pass for view `view_idx` of a light, drawing
+// casters[caster_start, caster_end). the DrawUniforms of casters[i] are at index i
+// of the light's draw storage buffer
+static void R_Scene_addShadowPass(GraphicsContext* gctx, R_Scene* scene,
+                                  G_Graph* graph, R_Light* light,
+                                  WGPUTexture depth_target, WGPUTexture color_target,
+                                  int layer, int view_idx, bool load_depth,
+                                  SG_ID* casters, int caster_start, int caster_end,
+                                  int draw_uniform_size)
+{
+    char string_buf[128] = {};
+    snprintf(string_buf, sizeof(string_buf),
+             "Shadow Pass for Scene[%d:%s] Light[%d:%s] view %d", scene->id,
+             scene->name, light->id, light->name, view_idx);
+    graph->addRenderPass(string_buf);
+    graph->renderPassDepthTarget(depth_target, layer, 1);
+    graph->renderPassColorTarget(color_target, 0, layer);
+    if (load_depth) graph->renderPassDepthOp(WGPULoadOp_Load);
+
+    // TODO: test with WGPUStoreOp_Discard see if it still writes to depth tex
+    WGPUColor clear_color
+      = { scene->sg_scene_desc.bg_color.r, scene->sg_scene_desc.bg_color.g,
+          scene->sg_scene_desc.bg_color.b, scene->sg_scene_desc.bg_color.a };
+    graph->renderPassColorOp(clear_color, WGPULoadOp_Clear, WGPUStoreOp_Store);
+
+    G_DrawCallListID dc_list = graph->renderPassAddDrawCallList();
+
+    // iterate over light's shadowcaster renderlist
+    for (int caster_idx = caster_start; caster_idx < caster_end; ++caster_idx) {
+        R_Transform* mesh = Component_GetMesh(casters[caster_idx]);
+        ASSERT(mesh->_stale == R_Transform_STALE_NONE);
+
+        // below is mostly copied from _R_RenderScene(...)
+        R_Material* material = Component_GetMaterial(mesh->_matID);
+        R_Geometry* geo      = Component_GetDrawGeometry(mesh->_geoID);
+
+        // add to draw call list
+        G_DrawCall* d = graph->addDraw(dc_list);
+        float dist_from_camera
+          = 0.0; // ==optimize== sort opaque geometry front-to-back
+        d->sort_key = G_SortKey::create(false, G_RenderingLayer_World, material->id,
+                                        dist_from_camera, 1.0);
+
+        { // set bindgroup state
+            // @group(0)
+            R_BindFrameUniforms(light->frame_uniform_buffer, NULL, gctx, d, graph,
+                                Component_GetShader(material->pso.sg_shader_id),
+                                scene, true, view_idx * light->frame_uniform_stride);
+
+            // @group(1)
+            // ==optimize== only run fragment shader if alpha-test discard on
+            // material is true
+            R_Material::createBindGroupEntries(material, 1, graph, d, gctx);
+
+            // @group(2)
+            graph->bindBuffer(d, PER_DRAW_GROUP, 0, light->draw_storage_buffer,
+                              caster_idx * draw_uniform_size, draw_uniform_size);
+
+            // @group(3) pulled vertex attribs
+            R_Geometry::addPullBindGroupEntries(geo, graph, d);
+
+            // ==optimize== after moving to dynamic bg offsets and sharing a single
+            // G_DynamicBuffer across all drawcalls for a frame, we will only need
+            // to upload the per-draw uniform data *once* per mesh, rather than once
+            // per mesh per pass that it appears in
+        }
+
+        { // set vertex info
+            // shadow passes currently don't support instanced draws
+            d->instance_count = 1;
+
+            // populate index buffer
+            bool indexed_draw = (R_Geometry::indexCount(geo) > 0);
+            if (indexed_draw) {
+                bool user_provided_index_count = (geo->indices_count >= 0);
+                d->index_count
+                  = user_provided_index_count ?
+                      MIN(R_Geometry::indexCount(geo), geo->indices_count) :
+                      R_Geometry::indexCount(geo);
+                d->index_buffer        = geo->gpu_index_buffer.buf;
+                d->index_buffer_offset = 0;
+                d->index_buffer_size   = geo->gpu_index_buffer.size;
+            } else {
+                d->vertex_count = R_Geometry::drawVertexCount(geo);
+            }
+
+            // set vertex attributes
+            for (int vertex_slot = 0;
+                 vertex_slot < ARRAY_LENGTH(geo->gpu_vertex_buffers); ++vertex_slot) {
+                GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[vertex_slot];
+                if (gpu_buffer->buf && gpu_buffer->size > 0)
+                    graph->vertexBuffer(d, vertex_slot, gpu_buffer->buf, 0,
+                                        gpu_buffer->size);
+            }
+        }
+
+        // set pso
+        // ==optimize== create duplicate shader that only has vertex shader, no
+        // fragment
+        d->pipelineDesc(material->pso.sg_shader_id, material->pso.cull_mode,
+                        material->pso.primitive_topology, &material->pso.blend_state,
+                        false, true);
+    }
+}
+
+void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
+                                     G_Graph* graph, FrameUniforms* frame_uniforms,
+                                     u64 frame_count, R_Camera* camera, f32 aspect)
+{
+    char string_buf[128] = {};
+    u32 shadow_map_write_indices[SG_LightType_Count]
+      = {}; // which array layer of the shadowmap Texture2D array to write to
+    u32 shadow_map_counts_by_type[SG_LightType_Count] = {};
+
+    int num_lights                = R_Scene::numLights(scene);
+    LightUniforms* light_uniforms = (LightUniforms*)scene->light_uniforms.base;
+    ASSERT(ARENA_LENGTH(&scene->light_uniforms, LightUniforms) == (u64)num_lights);
+
+    // only rebuild the slots of lights whose desc or transform changed.
+    // shadow map layers are handed out in slot order, so a light also goes stale
+    // when a light before it starts or stops casting shadows. cascaded dirlights
+    // also go stale when their cascades move with the camera
+    u64 light_buffer_size = num_lights * sizeof(LightUniforms);
+    bool full_upload      = light_buffer_size > scene->light_info_buffer.capacity;
+    int run_start         = -1; // first slot of the current run of stale slots
+    scene->lights_uploaded = 0;
+    for (int light_idx = 0; light_idx <= num_lights; ++light_idx) {
+        bool stale = false;
+        if (light_idx < num_lights) {
+            R_Light* light = Component_GetLight(
+              *ARENA_GET_TYPE(&scene->light_ids, SG_ID, light_idx));
+            ASSERT(light && light->scene_light_idx == (u32)light_idx);
+            ASSERT(light->_stale == R_Transform_STALE_NONE);
+            LightUniforms* light_uniform = &light_uniforms[light_idx];
+
+            // each shadow view (spot 1, dirlight cascade or point face) takes a layer
+            i32 shadow_map_idx                              = 0;
+            i32 cascade_count                               = 0;
+            glm::vec4 cascades[CHUGL_MAX_SHADOW_CASCADES] = {};
+            if (light->desc.generates_shadows) {
+                shadow_map_idx = shadow_map_counts_by_type[light->desc.type];
+                shadow_map_counts_by_type[light->desc.type] += light->shadowViewCount();
+                if (light->desc.type == SG_LightType_Directional) {
+                    cascade_count
+                      = R_Light_fitShadowCascades(light, camera, aspect, cascades);
+                }
+            }
+
+            stale = light->light_uniforms_stale
+                    || (bool)light_uniform->generates_shadows
+                         != (bool)light->desc.generates_shadows
+                    || light_uniform->shadow_map_idx != shadow_map_idx
+                    || light_uniform->cascade_count != cascade_count
+                    || memcmp(light_uniform->cascades, cascades, sizeof(cascades)) != 0;
+            if (stale) {
+                R_Light_writeUniforms(light, light_uniform, shadow_map_idx,
+                                      cascade_count, cascades);
+                light->light_uniforms_stale = false;
+                ++scene->lights_uploaded;
+            }
+        }
+
+        // upload each contiguous run of stale slots
+        if (full_upload) continue;
+        if (stale && run_start < 0) run_start = light_idx;
+        if (!stale && run_start >= 0) {
+            GPU_Buffer::write(gctx, &scene->light_info_buffer, WGPUBufferUsage_Storage,
+                              run_start * sizeof(LightUniforms),
+                              light_uniforms + run_start,
+                              (light_idx - run_start) * sizeof(LightUniforms));
+            run_start = -1;
+        }
+    }
+
+    // growing the buffer recreates it, so every slot is uploaded
+    if (full_upload) {
+        GPU_Buffer::write(gctx, &scene->light_info_buffer, WGPUBufferUsage_Storage,
+                          light_uniforms, light_buffer_size);
+        scene->lights_uploaded = num_lights;
+    }
+    scene->light_info_buffer.size = light_buffer_size;
+
+    // rebuild shadow map arrays if resized
+    for (int light_type = 0; light_type < SG_LightType_Count; ++light_type) {
+        WGPUTexture* shadow_map_array = NULL;
+        WGPUTexture* color_map_array  = NULL;
+        u32 dim                       = 0;
+        const char* type_name         = NULL;
+        switch (light_type) {
+            case SG_LightType_Spot: {
+                shadow_map_array = &scene->spot_shadow_map_array;
+                color_map_array  = &scene->spot_shadow_color_map_array;
+                dim              = CHUGL_SPOT_SHADOWMAP_DEFAULT_DIM;
+                type_name        = "Spot";
+            } break;
+            case SG_LightType_Directional: {
+                shadow_map_array = &scene->dir_shadow_map_array;
+                color_map_array  = &scene->dir_shadow_color_map_array;
+                dim              = CHUGL_DIR_SHADOWMAP_DEFAULT_DIM;
+                type_name        = "Directional";
+            } break;
+            case SG_LightType_Point: {
+                shadow_map_array = &scene->point_shadow_map_array;
+                color_map_array  = &scene->point_shadow_color_map_array;
+                dim              = CHUGL_POINT_SHADOWMAP_DEFAULT_DIM;
+                type_name        = "Point";
+            } break;
+            default: continue; // no shadows
+        }
+
+        u32 curr_layers
+          = *shadow_map_array ? wgpuTextureGetDepthOrArrayLayers(*shadow_map_array) : 0;
+
+        // add +1 to prevent crash from not binding anything
+        u32 min_layers = shadow_map_counts_by_type[light_type] + 1;
         if (curr_layers >= min_layers) continue;
 
+        // TODO ==api==: setting for shadowmap resolution
         WGPUTextureDescriptor shadowmap_desc = {};
-        shadowmap_desc.usage
-          = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding;
+        shadowmap_desc.usage = WGPUTextureUsage_RenderAttachment
+                               | WGPUTextureUsage_TextureBinding
+                               | WGPUTextureUsage_CopyDst;
         shadowmap_desc.dimension     = WGPUTextureDimension_2D;
         shadowmap_desc.format        = WGPUTextureFormat_Depth32Float;
         shadowmap_desc.mipLevelCount = 1;
         shadowmap_desc.sampleCount   = 1;
+        shadowmap_desc.size          = { dim, dim, min_layers };
+        snprintf(string_buf, sizeof(string_buf), "%s shadowmap array for Scene[%d] %s",
+                 type_name, scene->id, scene->name);
+        shadowmap_desc.label = string_buf;
 
-        if (light_type == SG_LightType_Spot) {
-            shadowmap_desc.size // TODO ==api==: setting for shadowmap resolution
-              = { CHUGL_SPOT_SHADOWMAP_DEFAULT_DIM, CHUGL_SPOT_SHADOWMAP_DEFAULT_DIM,
-                  min_layers };
-            snprintf(string_buf, sizeof(string_buf),
-                     "Spot shadowmap array for Scene[%d] %s", scene->id, scene->name);
-            shadowmap_desc.label = string_buf;
+        WGPU_RELEASE_RESOURCE(Texture, *shadow_map_array);
+        *shadow_map_array = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
 
-            WGPU_RELEASE_RESOURCE(Texture, scene->spot_shadow_map_array);
-            scene->spot_shadow_map_array
-              = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
+        // static layers are only ever copied into the shadow map
+        snprintf(string_buf, sizeof(string_buf),
+                 "%s static shadowmap array for Scene[%d] %s", type_name, scene->id,
+                 scene->name);
+        shadowmap_desc.usage
+          = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc;
 
-            // create color target
-            snprintf(string_buf, sizeof(string_buf),
-                     "Spot ShadowPass Color Target array for Scene[%d] %s", scene->id,
-                     scene->name);
-            shadowmap_desc.format = WGPUTextureFormat_RGBA8Unorm;
-
-            WGPU_RELEASE_RESOURCE(Texture, scene->spot_shadow_color_map_array);
-            scene->spot_shadow_color_map_array
-              = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
-        } else if (light_type == SG_LightType_Directional) {
-            shadowmap_desc.size // TODO ==api==: setting for shadowmap resolution
-              = { CHUGL_DIR_SHADOWMAP_DEFAULT_DIM, CHUGL_DIR_SHADOWMAP_DEFAULT_DIM,
-                  min_layers };
-            snprintf(string_buf, sizeof(string_buf),
-                     "Directional shadowmap array for Scene[%d] %s", scene->id,
-                     scene->name);
-            shadowmap_desc.label = string_buf;
+        WGPU_RELEASE_RESOURCE(Texture, scene->static_shadow_map_arrays[light_type]);
+        scene->static_shadow_map_arrays[light_type]
+          = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
 
-            WGPU_RELEASE_RESOURCE(Texture, scene->dir_shadow_map_array);
-            scene->dir_shadow_map_array
-              = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
+        // create color target
+        snprintf(string_buf, sizeof(string_buf),
+                 "%s ShadowPass Color Target array for Scene[%d] %s", type_name,
+                 scene->id, scene->name);
+        shadowmap_desc.format = WGPUTextureFormat_RGBA8Unorm;
+        shadowmap_desc.usage
+          = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding;
 
-            // create color target
-            snprintf(string_buf, sizeof(string_buf),
-                     "Directional ShadowPass Color Target array for Scene[%d] %s",
-                     scene->id, scene->name);
-            shadowmap_desc.format = WGPUTextureFormat_RGBA8Unorm;
+        WGPU_RELEASE_RESOURCE(Texture, *color_map_array);
+        *color_map_array = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
 
-            WGPU_RELEASE_RESOURCE(Texture, scene->dir_shadow_color_map_array);
-            scene->dir_shadow_color_map_array
-              = wgpuDeviceCreateTexture(gctx->device, &shadowmap_desc);
-        }
+        // new textures start out empty
+        ++scene->shadow_map_generation[light_type];
     }
 
     // prepare frame uniforms
     FrameUniforms light_frame_uniforms = {};
     COPY_STRUCT(&light_frame_uniforms, frame_uniforms);
 
-    // shadowmap passes
-    hashmap_idx_DONT_USE = 0;
-    light_id             = NULL;
-    light_idx            = 0;
-    while (
-      hashmap_iter(scene->light_id_set, &hashmap_idx_DONT_USE, (void**)&light_id)) {
-        LightUniforms* light_uniform = &light_uniforms[light_idx++];
-        if (!light_uniform->generates_shadows) continue;
-
-        R_Light* light = Component_GetLight(*light_id);
-        ASSERT(light->scene_id == scene->id);
-        int layer = shadow_map_write_indices[light->desc.type]++;
-        ASSERT(layer == light_uniform->shadow_map_idx); // should match
-        if (light->desc.type != SG_LightType_Spot
-            && light->desc.type != SG_LightType_Directional)
-            continue; // others not impl
-
-        // update frame uniform buffer
-        light_frame_uniforms.projection = light->projection(false);
-        light_frame_uniforms.view       = R_Transform::viewMatrix(light);
-        light_frame_uniforms.projection_view_inverse_no_translation
-          = glm::inverse(light_frame_uniforms.projection
-                         * glm::mat4(glm::mat3(light_frame_uniforms.view)));
-        light_frame_uniforms.camera_pos = light->_pos;
-
-        // 0 num lights to save compute and not recalculate shadows in a shadow pass
-        // ==api== in future can add mesh.depthMaterial() which bypasses frag shader or
-        // just does simple alpha test
-        light_frame_uniforms.num_lights = 0;
-
-        wgpuQueueWriteBuffer(gctx->queue, light->frame_uniform_buffer, 0,
-                             &light_frame_uniforms, sizeof(light_frame_uniforms));
-
-        // resize the per-draw storage buffer
-        size_t shadow_renderlist_count = hashmap_count(light->shadow_render_id_set);
-        int draw_uniform_size          = NEXT_MULT(sizeof(DrawUniforms),
-                                                   gctx->limits.minStorageBufferOffsetAlignment);
-        if (light->draw_storage_buffer == NULL
-            || wgpuBufferGetSize(light->draw_storage_buffer)
-                 < shadow_renderlist_count * draw_uniform_size) {
+    // 0 num lights to save compute and not recalculate shadows in a shadow pass
+    // ==api== in future can add mesh.depthMaterial() which bypasses frag shader or
+    // just does simple alpha test
+    light_frame_uniforms.num_lights        = 0;
+    light_frame_uniforms.num_active_lights = 0;
 
-            snprintf(string_buf, sizeof(string_buf),
-                     "Shadow Pass DrawUniforms for Scene[%d:%s], Light[%d:%s]",
-                     scene->id, scene->name, light->id, light->name);
-            WGPUBufferDescriptor buff_desc = {};
-            buff_desc.label                = string_buf;
-            buff_desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-            buff_desc.size  = shadow_renderlist_count * draw_uniform_size;
+    int draw_uniform_size = NEXT_MULT(sizeof(DrawUniforms),
+                                      gctx->limits.minStorageBufferOffsetAlignment);
 
-            WGPU_RELEASE_RESOURCE(Buffer, light->draw_storage_buffer);
-            light->draw_storage_buffer
-              = wgpuDeviceCreateBuffer(gctx->device, &buff_desc);
-            ASSERT(light->draw_storage_buffer);
+    // shadowmap passes
+    // A light's shadow map is only re-rendered when a hash of its views and its
+    // casters' (mesh, geometry, material, world + geometry + material version)
+    // changes. Casters outside every view of the light are left out. Casters that
+    // changed within the last CHUGL_SHADOW_STATIC_FRAMES frames are
+    // dynamic, the rest are static. With no dynamic casters everything is drawn
+    // straight into the shadow map. Otherwise the static casters are cached in the
+    // static layer, which is copied into the shadow map before the dynamic casters
+    // are drawn on top
+    bool pass_budget_exhausted = false;
+    for (int light_idx = 0; light_idx < num_lights; ++light_idx) {
+        LightUniforms* light_uniform = &light_uniforms[light_idx];
+        R_Light* light
+          = Component_GetLight(*ARENA_GET_TYPE(&scene->light_ids, SG_ID, light_idx));
+        if (!light_uniform->generates_shadows) {
+            // other lights may take over its layers while shadows are off
+            light->shadow_hash          = 0;
+            light->shadow_static_cached = false;
+            continue;
         }
 
-        // write draw uniforms cpu --> gpu
-        u8* cpu_draw_uniform_list = (u8*)Arena::push(
-          &gctx->frame_arena, shadow_renderlist_count * draw_uniform_size);
-        u64 cpu_draw_uniform_offset
-          = Arena::offsetOf(&gctx->frame_arena, cpu_draw_uniform_list);
-        defer(
-          wgpuQueueWriteBuffer(gctx->queue, light->draw_storage_buffer, 0,
-                               Arena::get(&gctx->frame_arena, cpu_draw_uniform_offset),
-                               shadow_renderlist_count * draw_uniform_size););
-
-        // set up the renderpass
-        snprintf(string_buf, sizeof(string_buf),
-                 "Shadow Pass for Scene[%d:%s] Light[%d:%s]", scene->id, scene->name,
-                 light->id, light->name);
-        graph->addRenderPass(string_buf);
-
-        if (light->desc.type == SG_LightType_Spot) {
-            graph->renderPassDepthTarget(scene->spot_shadow_map_array, layer, 1);
-            graph->renderPassColorTarget(scene->spot_shadow_color_map_array, 0, layer);
-        } else if (light->desc.type == SG_LightType_Directional) {
-            graph->renderPassDepthTarget(scene->dir_shadow_map_array, layer, 1);
-            graph->renderPassColorTarget(scene->dir_shadow_color_map_array, 0, layer);
-        } else {
-            UNREACHABLE;
+        ASSERT(light->scene_id == scene->id);
+        int view_count = light->shadowViewCount();
+        int layer      = shadow_map_write_indices[light->desc.type];
+        shadow_map_write_indices[light->desc.type] += view_count;
+        ASSERT(layer == light_uniform->shadow_map_idx); // should match
+        if (view_count == 0) continue;
+
+        WGPUTexture shadow_map_array = NULL;
+        WGPUTexture color_map_array  = NULL;
+        switch (light->desc.type) {
+            case SG_LightType_Spot:
+                shadow_map_array = scene->spot_shadow_map_array;
+                color_map_array  = scene->spot_shadow_color_map_array;
+                break;
+            case SG_LightType_Directional:
+                shadow_map_array = scene->dir_shadow_map_array;
+                color_map_array  = scene->dir_shadow_color_map_array;
+                break;
+            case SG_LightType_Point:
+                shadow_map_array = scene->point_shadow_map_array;
+                color_map_array  = scene->point_shadow_color_map_array;
+                break;
+            default: UNREACHABLE;
         }
+        WGPUTexture static_shadow_map_array
+          = scene->static_shadow_map_arrays[light->desc.type];
 
-        // TODO: test with WGPUStoreOp_Discard see if it still writes to depth tex
-        WGPUColor clear_color
-          = { scene->sg_scene_desc.bg_color.r, scene->sg_scene_desc.bg_color.g,
-              scene->sg_scene_desc.bg_color.b, scene->sg_scene_desc.bg_color.a };
-        graph->renderPassColorOp(clear_color, WGPULoadOp_Clear, WGPUStoreOp_Store);
-
-        G_DrawCallListID dc_list = graph->renderPassAddDrawCallList();
+        // views of this light
+        glm::mat4 views[CHUGL_SHADOW_MAX_VIEWS] = {};
+        for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+            views[view_idx] = light->shadowView(view_idx, light_uniform->cascades);
+        }
+        u64 light_hash
+          = hashmap_xxhash3(views, sizeof(views), light_uniform->shadow_map_idx,
+                            scene->shadow_map_generation[light->desc.type]);
+        R_Frustum frustums[CHUGL_SHADOW_MAX_VIEWS] = {};
+        for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+            frustums[view_idx] = R_Frustum::fromProjectionView(views[view_idx]);
+        }
 
+        // sort casters into static ones (from the front) and dynamic ones (from the
+        // back). frame arena pointers are fetched after all pushes, which may move it
+        int caster_capacity = (int)hashmap_count(light->shadow_render_id_set);
+        u64 casters_offset  = Arena::offsetOf(
+          &gctx->frame_arena,
+          ARENA_PUSH_COUNT(&gctx->frame_arena, SG_ID, MAX(caster_capacity, 1)));
+        u64 draw_uniforms_offset = Arena::offsetOf(
+          &gctx->frame_arena,
+          Arena::push(&gctx->frame_arena, MAX(caster_capacity, 1) * draw_uniform_size));
+        SG_ID* casters = (SG_ID*)Arena::get(&gctx->frame_arena, casters_offset);
+
+        u64 static_sum = 0, dynamic_sum = 0;
+        int static_count = 0, dynamic_count = 0;
         size_t shadowmap_renderlist_idx_DONT_USE = 0;
         SG_ID* mesh_id                           = NULL;
-        int draw_uniform_idx                     = 0;
-        // iterate over light's shadowcaster renderlist
         while (hashmap_iter(light->shadow_render_id_set,
                             &shadowmap_renderlist_idx_DONT_USE, (void**)&mesh_id)) {
             R_Transform* mesh = Component_GetMesh(*mesh_id);
@@ -1500,109 +2528,248 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
             bool mesh_belongs_to_scene = (mesh->scene_id == scene->id);
             if (!mesh_belongs_to_scene) continue;
 
-            // below is mostly copied from _R_RenderScene(...)
             R_Material* material = Component_GetMaterial(mesh->_matID);
-            R_Geometry* geo      = Component_GetGeometry(mesh->_geoID);
-            R_Shader* shader     = Component_GetShader(material->pso.sg_shader_id);
+            R_Geometry* geo      = Component_GetDrawGeometry(mesh->_geoID);
+            R_Shader* shader
+              = material ? Component_GetShader(material->pso.sg_shader_id) : NULL;
             if (!material || !geo || !shader) continue; // incomplete mesh
 
-            // add to draw call list
-            G_DrawCall* d = graph->addDraw(dc_list);
-            float dist_from_camera
-              = 0.0; // ==optimize== sort opaque geometry front-to-back
-            d->sort_key = G_SortKey::create(false, G_RenderingLayer_World, material->id,
-                                            dist_from_camera, 1.0);
-
-            { // set bindgroup state
-                // @group(0)
-                R_BindFrameUniforms(light->frame_uniform_buffer, gctx, d, graph, shader,
-                                    scene, true);
-
-                // @group(1)
-                // ==optimize== only run fragment shader if alpha-test discard on
-                // material is true
-                R_Material::createBindGroupEntries(material, 1, graph, d, gctx);
-
-                // @group(2)
-                DrawUniforms* draw_uniform
-                  = (DrawUniforms*)(cpu_draw_uniform_list
-                                    + draw_uniform_idx * draw_uniform_size);
-                *draw_uniform
-                  = { mesh->world, mesh->normal, mesh->id, mesh->receives_shadows, {} };
-                graph->bindBuffer(d, PER_DRAW_GROUP, 0, light->draw_storage_buffer,
-                                  draw_uniform_idx * draw_uniform_size,
-                                  draw_uniform_size);
-
-                ++draw_uniform_idx;
-
-                // @group(3) pulled vertex attribs
-                R_Geometry::addPullBindGroupEntries(geo, graph, d);
-
-                // ==optimize== after moving to dynamic bg offsets and sharing a single
-                // G_DynamicBuffer across all drawcalls for a frame, we will only need
-                // to upload the per-draw uniform data *once* per mesh, rather than once
-                // per mesh per pass that it appears in
+            // skip casters no view of the light can see, unbounded ones always draw
+            if (geo->bounding_sphere.w >= 0.0f) {
+                const glm::mat4& model = mesh->world;
+                glm::vec3 center
+                  = model * glm::vec4(glm::vec3(geo->bounding_sphere), 1.0f);
+                f32 scale2
+                  = MAX(MAX(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                            glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))),
+                        glm::dot(glm::vec3(model[2]), glm::vec3(model[2])));
+                f32 radius   = geo->bounding_sphere.w * sqrtf(scale2);
+                bool visible = false;
+                for (int view_idx = 0; view_idx < view_count && !visible; ++view_idx) {
+                    visible = R_Frustum::intersectsSphere(&frustums[view_idx], center,
+                                                          radius);
+                }
+                if (!visible) continue;
             }
 
-            { // set vertex info
-                d->instance_count
-                  = 1; // shadow passes currently don't support instanced draws
-
-                // populate index buffer
-                bool indexed_draw = (R_Geometry::indexCount(geo) > 0);
-                if (indexed_draw) {
-                    bool user_provided_index_count = (geo->indices_count >= 0);
-                    d->index_count
-                      = user_provided_index_count ?
-                          MIN(R_Geometry::indexCount(geo), geo->indices_count) :
-                          R_Geometry::indexCount(geo);
-                    d->index_buffer        = geo->gpu_index_buffer.buf;
-                    d->index_buffer_offset = 0;
-                    d->index_buffer_size   = geo->gpu_index_buffer.size;
-                } else {
-                    // TODO come up with a better way to set a custom number of
-                    // vertices to draw having -1 actually mean ALL is confusing 2
-                    // different states.
-                    u32 vertex_count                = R_Geometry::vertexCount(geo);
-                    bool user_provided_vertex_count = geo->vertex_count >= 0;
-                    d->vertex_count
-                      = user_provided_vertex_count ? geo->vertex_count : vertex_count;
-                }
+            // casters are shared between lights, so only the first light to see a
+            // change records it
+            u32 versions[3] = { geo->version, mesh->world_version, material->version };
+            u64 key         = hashmap_xxhash3(versions, sizeof(versions), 0, 0);
+            if (key != mesh->shadow_caster_key) {
+                mesh->shadow_caster_key      = key;
+                mesh->shadow_caster_moved_fc = frame_count;
+            }
+            bool dynamic
+              = frame_count - mesh->shadow_caster_moved_fc < CHUGL_SHADOW_STATIC_FRAMES;
+
+            // summed so the hash doesn't depend on iteration order
+            u64 caster_state[4] = { mesh->id, geo->id, material->id, key };
+            u64 caster_hash = hashmap_xxhash3(caster_state, sizeof(caster_state), 0, 0);
+            if (dynamic) {
+                casters[caster_capacity - 1 - dynamic_count++] = mesh->id;
+                dynamic_sum += caster_hash;
+            } else {
+                casters[static_count++] = mesh->id;
+                static_sum += caster_hash;
+            }
+        }
 
-                // set vertex attributes
-                for (int vertex_slot = 0;
-                     vertex_slot < ARRAY_LENGTH(geo->gpu_vertex_buffers);
-                     ++vertex_slot) {
-                    GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[vertex_slot];
-                    if (gpu_buffer->buf && gpu_buffer->size > 0)
-                        graph->vertexBuffer(d, vertex_slot, gpu_buffer->buf, 0,
-                                            gpu_buffer->size);
-                }
+        u64 static_state[3] = { light_hash, static_sum, (u64)static_count };
+        u64 static_hash     = hashmap_xxhash3(static_state, sizeof(static_state), 0, 0);
+        u64 shadow_state[3] = { static_hash, dynamic_sum, (u64)dynamic_count };
+        u64 shadow_hash     = hashmap_xxhash3(shadow_state, sizeof(shadow_state), 0, 0);
+        if (shadow_hash == light->shadow_hash) continue; // cached shadow map is valid
+
+        // a point light with dynamic casters takes up to 13 passes. leave the light
+        // stale to retry next frame rather than overflow the render graph
+        bool restatic = !light->shadow_static_cached
+                        || light->shadow_static_hash != static_hash;
+        int pass_count = (dynamic_count == 0) ?
+                           view_count :
+                           (restatic ? view_count : 0) + 1 + view_count;
+        if (graph->pass_count + pass_count
+            > CHUGL_RENDERGRAPH_MAX_PASSES - CHUGL_SHADOW_PASS_RESERVE) {
+            if (!scene->shadow_pass_budget_exhausted) {
+                log_warn("Scene[%d:%s] shadows of Light[%d:%s] skipped, out of render "
+                         "passes (max %d)",
+                         scene->id, scene->name, light->id, light->name,
+                         CHUGL_RENDERGRAPH_MAX_PASSES);
+            }
+            pass_budget_exhausted = true;
+            continue;
+        }
+        light->shadow_hash = shadow_hash;
+
+        // update frame uniform buffer, one per view
+        for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+            // point faces fold their view into the projection
+            glm::mat4 view = (light->desc.type == SG_LightType_Point) ?
+                               glm::mat4(1.0f) :
+                               R_Transform::viewMatrix(light);
+            light_frame_uniforms.projection = views[view_idx] * glm::inverse(view);
+            light_frame_uniforms.view       = view;
+            light_frame_uniforms.projection_view_inverse_no_translation
+              = glm::inverse(light_frame_uniforms.projection
+                             * glm::mat4(glm::mat3(light_frame_uniforms.view)));
+            light_frame_uniforms.camera_pos = light->world[3];
+
+            wgpuQueueWriteBuffer(gctx->queue, light->frame_uniform_buffer,
+                                 view_idx * light->frame_uniform_stride,
+                                 &light_frame_uniforms, sizeof(light_frame_uniforms));
+        }
+
+        // resize the per-draw storage buffer
+        if (light->draw_storage_buffer == NULL
+            || wgpuBufferGetSize(light->draw_storage_buffer)
+                 < (u64)caster_capacity * draw_uniform_size) {
+
+            snprintf(string_buf, sizeof(string_buf),
+                     "Shadow Pass DrawUniforms for Scene[%d:%s], Light[%d:%s]",
+                     scene->id, scene->name, light->id, light->name);
+            WGPUBufferDescriptor buff_desc = {};
+            buff_desc.label                = string_buf;
+            buff_desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
+            buff_desc.size  = MAX(caster_capacity, 1) * draw_uniform_size;
+
+            WGPU_RELEASE_RESOURCE(Buffer, light->draw_storage_buffer);
+            light->draw_storage_buffer
+              = wgpuDeviceCreateBuffer(gctx->device, &buff_desc);
+            ASSERT(light->draw_storage_buffer);
+        }
+
+        // write draw uniforms cpu --> gpu, shared by every view
+        u8* cpu_draw_uniform_list
+          = (u8*)Arena::get(&gctx->frame_arena, draw_uniforms_offset);
+        for (int caster_idx = 0; caster_idx < caster_capacity; ++caster_idx) {
+            bool used = caster_idx < static_count
+                        || caster_idx >= caster_capacity - dynamic_count;
+            if (!used) continue;
+            R_Transform* mesh = Component_GetMesh(casters[caster_idx]);
+            DrawUniforms* draw_uniform
+              = (DrawUniforms*)(cpu_draw_uniform_list + caster_idx * draw_uniform_size);
+            *draw_uniform
+              = { mesh->world, mesh->normal, mesh->id, mesh->receives_shadows, {} };
+        }
+        if (caster_capacity > 0) {
+            wgpuQueueWriteBuffer(gctx->queue, light->draw_storage_buffer, 0,
+                                 cpu_draw_uniform_list,
+                                 caster_capacity * draw_uniform_size);
+        }
+
+        if (dynamic_count == 0) {
+            // everything is still, draw straight into the shadow map
+            for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+                R_Scene_addShadowPass(gctx, scene, graph, light, shadow_map_array,
+                                      color_map_array, layer + view_idx, view_idx,
+                                      false, casters, 0, static_count,
+                                      draw_uniform_size);
             }
+            light->shadow_static_cached = false;
+            continue;
+        }
+
+        // re-render the static layer only if the still casters changed
+        if (restatic) {
+            for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+                R_Scene_addShadowPass(gctx, scene, graph, light,
+                                      static_shadow_map_array, color_map_array,
+                                      layer + view_idx, view_idx, false, casters, 0,
+                                      static_count, draw_uniform_size);
+            }
+            light->shadow_static_cached = true;
+            light->shadow_static_hash   = static_hash;
+        }
 
-            // set pso
-            // ==optimize== create duplicate shader that only has vertex shader, no
-            // fragment
-            d->pipelineDesc(material->pso.sg_shader_id, material->pso.cull_mode,
-                            material->pso.primitive_topology,
-                            &material->pso.blend_state, false, true);
+        // composite: static layer + dynamic casters
+        snprintf(string_buf, sizeof(string_buf),
+                 "Static Shadow Copy for Scene[%d:%s] Light[%d:%s]", scene->id,
+                 scene->name, light->id, light->name);
+        graph->addTextureCopyPass(string_buf, static_shadow_map_array, layer,
+                                  shadow_map_array, layer, view_count);
+        for (int view_idx = 0; view_idx < view_count; ++view_idx) {
+            R_Scene_addShadowPass(gctx, scene, graph, light, shadow_map_array,
+                                  color_map_array, layer + view_idx, view_idx, true,
+                                  casters, caster_capacity - dynamic_count,
+                                  caster_capacity, draw_uniform_size);
         }
     }
 
+    scene->shadow_pass_budget_exhausted = pass_budget_exhausted;
+
     // validation
     for (int i = 0; i < ARRAY_LENGTH(shadow_map_write_indices); ++i) {
         ASSERT(shadow_map_counts_by_type[i] == shadow_map_write_indices[i]);
     }
 }
 
+u32 R_Scene::cullLights(GraphicsContext* gctx, R_Scene* scene,
+                        const glm::mat4& proj_view, GPU_Buffer* active_light_buffer)
+{
+    int num_lights = R_Scene::numLights(scene);
+    ASSERT(active_light_buffer->capacity >= MAX(num_lights, 1) * sizeof(u32));
+
+    R_Frustum frustum = R_Frustum::fromProjectionView(proj_view);
+
+    u32* active_lights = ARENA_PUSH_COUNT(&gctx->frame_arena, u32, MAX(num_lights, 1));
+    u32 active_count   = 0;
+    for (int light_idx = 0; light_idx < num_lights; ++light_idx) {
+        R_Light* light
+          = Component_GetLight(*ARENA_GET_TYPE(&scene->light_ids, SG_ID, light_idx));
+        ASSERT(light);
+        if (light->desc.intensity == 0.0f) continue;
+
+        switch (light->desc.type) {
+            case SG_LightType_Directional: break; // reaches everything
+            case SG_LightType_Point:
+            case SG_LightType_Spot: {
+                // spot cone is bounded by the same sphere as a point light
+                if (!R_Frustum::intersectsSphere(&frustum, light->world[3],
+                                                 light->desc.radius))
+                    continue;
+            } break;
+            default: continue;
+        }
+        active_lights[active_count++] = (u32)light_idx;
+    }
+
+    if (active_count > 0) {
+        wgpuQueueWriteBuffer(gctx->queue, active_light_buffer->buf, 0, active_lights,
+                             active_count * sizeof(u32));
+    }
+    scene->lights_active = active_count;
+    return active_count;
+}
+
+void R_Scene::sendLightStats(R_Scene* scene)
+{
+    if (scene->lights_active == scene->lights_active_sent
+        && scene->lights_uploaded == scene->lights_uploaded_sent)
+        return;
+
+    scene->lights_active_sent   = scene->lights_active;
+    scene->lights_uploaded_sent = scene->lights_uploaded;
+    CQ_PushCommand_G2A_SceneLightStats(scene->id, scene->lights_active,
+                                       scene->lights_uploaded);
+}
+
 void R_Scene::registerMesh(R_Scene* scene, R_Transform* mesh)
 {
     if (!scene || !mesh) return;
     if (mesh->_geoID == 0 || mesh->_matID == 0) return;
 
     ASSERT(mesh->type == SG_COMPONENT_MESH);
-    GeometryToXforms::addXform(R_Scene_getPrimitive(scene, mesh->_matID, mesh->_geoID),
-                               mesh->id);
+    GeometryToXforms::addXform(
+      R_Scene_getPrimitive(scene, mesh->_matID, R_Scene_drawGeoID(mesh)), mesh->id);
+
+    R_Geometry* geo = Component_GetGeometry(mesh->_geoID);
+    if (geo) {
+        if (!geo->mesh_id_set) {
+            geo->mesh_id_set
+              = hashmap_new_simple(sizeof(SG_ID), hashSGID, compareSGIDs);
+        }
+        hashmap_set(geo->mesh_id_set, &mesh->id);
+    }
 }
 
 void R_Scene::unregisterMesh(R_Scene* scene, R_Transform* mesh)
@@ -1610,8 +2777,12 @@ void R_Scene::unregisterMesh(R_Scene* scene, R_Transform* mesh)
     if (!scene || !mesh) return;
     if (mesh->_geoID == 0 || mesh->_matID == 0) return;
 
+    R_Geometry* geo = Component_GetGeometry(mesh->_geoID);
+    if (geo) hashmap_delete(geo->mesh_id_set, &mesh->id);
+
     // get xforms from geometry
-    GeometryToXforms* g2x = R_Scene_getPrimitive(scene, mesh->_matID, mesh->_geoID);
+    GeometryToXforms* g2x
+      = R_Scene_getPrimitive(scene, mesh->_matID, R_Scene_drawGeoID(mesh));
 
     ASSERT(GeometryToXforms::hasXform(g2x, mesh->id));
 
@@ -1630,8 +2801,9 @@ void R_Scene::unregisterMesh(R_Scene* scene, R_Transform* mesh)
 void R_Scene::markPrimitiveStale(R_Scene* scene, R_Transform* mesh)
 {
     if (!scene || !mesh) return;
-    GeometryToXforms* g2x = R_Scene_getPrimitive(scene, mesh->_matID, mesh->_geoID);
-    g2x->buffer_stale     = true;
+    GeometryToXforms* g2x
+      = R_Scene_getPrimitive(scene, mesh->_matID, R_Scene_drawGeoID(mesh));
+    g2x->buffer_stale = true;
 }
 
 int R_Scene::numPrimitives(R_Scene* scene, SG_ID material_id, SG_ID geo_id)
@@ -1669,8 +2841,8 @@ void R_Scene::initFromSG(GraphicsContext* gctx, R_Scene* r_scene, SG_ID scene_id
       = hashmap_new(sizeof(GeometryToXforms), 0, seed, seed, GeometryToXforms::hash,
                     GeometryToXforms::compare, GeometryToXforms::free, NULL);
 
-    r_scene->light_id_set
-      = hashmap_new(sizeof(SG_ID), 0, seed, seed, hashSGID, compareSGIDs, NULL, NULL);
+    Arena::init(&r_scene->light_ids, sizeof(SG_ID) * 16);
+    Arena::init(&r_scene->light_uniforms, sizeof(LightUniforms) * 16);
 
     GPU_Buffer::init(gctx, &r_scene->light_info_buffer, WGPUBufferUsage_Storage,
                      sizeof(LightUniforms) * 16);
@@ -1702,33 +2874,240 @@ static Arena webcamArena;
 static hashmap* r_locator = NULL;
 
 // fonts
-// each font is 600bytes, 128 fonts is 76.8KB
-static R_Font component_fonts[128];
-static int component_font_count = 0;
+// heap allocated so R_Text can hold pointers while the registry grows
+static std::unordered_map<std::string, R_Font*> font_registry;
+static R_Font* font_fallback = NULL; // first builtin font, stands in while loading
+static u64 font_frame        = 0;    // Component_UpdateFonts() calls
+// sum of every font's refcount, and its value as of the last G2A_FONT_STATS
+static u32 font_references      = 0;
+static u32 font_references_sent = 0;
+// fonts that failed to load are taken out of the registry and kept here until
+// the texts holding them let go
+static std::vector<R_Font*> font_failed;
+// font path --> font_frame of its last failed load. Not retried for
+// R_FONT_EVICT_FRAMES, so a text with a bad path doesn't reload it every rebuild
+static std::unordered_map<std::string, u64> font_failed_frame;
+
+// ----------------------------------------------------------------------------
+// R_Webcam capture
+// ----------------------------------------------------------------------------
+// Frames arrive on the capture thread of each device (sr_webcam's callback, or
+// the generator thread of the synthetic device). They are packed into the
+// device's upload format and handed to the render thread through a triple
+// buffer, so neither side ever waits on the other and the render thread only
+// uploads the newest frame.
+
+// set in R_WebcamDevice::middle while it holds a frame the render thread
+// hasn't picked up yet
+#define R_WEBCAM_FRAME_NEW 0x4
+
+struct R_WebcamFrame {
+    u8* data_OWNED; // sized for RGBA, the largest format
+    u64 frame_count;
+    SG_WebcamFormat format;
+};
 
-// webcam
-/*
-set user data to be the device id
-have a stack lock-protected array of 8 webcam data slots
-in callback, webcam thread locks the device id of its bucket and copies rgb data,
-setting has_frame = true
+struct R_WebcamDevice {
+    int device_id;
+    sr_webcam_device* webcam; // NULL for SG_WEBCAM_DEVICE_SYNTHETIC
+    int width, height, fps;
+    int count; // number of ChuGL webcam objects using this device
+
+    // set by the render thread, read on the capture thread
+    std::atomic<bool> capture;
+    std::atomic<u8> format; // SG_WebcamFormat
+
+    // triple buffer. The capture thread fills frames[back] and swaps it with
+    // middle, the render thread swaps front with middle when middle is new
+    R_WebcamFrame frames[3];
+    u32 back;                // capture thread
+    std::atomic<u32> middle; // frame index | R_WEBCAM_FRAME_NEW
+    u32 front;               // render thread
+    u64 frame_count;         // capture thread
+
+    // synthetic device
+    std::thread* generator;
+    std::atomic<bool> running;
+};
 
-in app, before rendering, check all buckets for has_frame = true and copy data to
-texture
-*/
+// BT.601 video range, inverse of yuv_to_rgba_shader_string
+static u8 R_Webcam_Y(int r, int g, int b)
+{
+    return (u8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
 
-struct R_WebcamData {
-    sr_webcam_device* webcam;
-    u8* data;
-    size_t size;
-    int count;           // number of ChuGL webcam objects using this device id
-    u64 frame_count;     // incremented every time the webcam writes a new frame
-    bool capture = true; // whether to capture frames
-    spinlock lock;
-};
+static u8 R_Webcam_Cb(int r, int g, int b)
+{
+    return (u8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static u8 R_Webcam_Cr(int r, int g, int b)
+{
+    return (u8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Y0 Cb Y1 Cr per pair of pixels, chroma averaged over the pair
+static void R_Webcam_PackYUYV(const u8* rgba, u8* dst, int width, int height)
+{
+    for (int y = 0; y < height; y++) {
+        const u8* row = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < width; x += 2) {
+            const u8* p0 = row + x * 4;
+            const u8* p1 = (x + 1 < width) ? p0 + 4 : p0;
+            int r = (p0[0] + p1[0] + 1) >> 1;
+            int g = (p0[1] + p1[1] + 1) >> 1;
+            int b = (p0[2] + p1[2] + 1) >> 1;
+            dst[0] = R_Webcam_Y(p0[0], p0[1], p0[2]);
+            dst[1] = R_Webcam_Cb(r, g, b);
+            dst[2] = R_Webcam_Y(p1[0], p1[1], p1[2]);
+            dst[3] = R_Webcam_Cr(r, g, b);
+            dst += 4;
+        }
+    }
+}
+
+// full resolution Y plane, then one Cb Cr pair per 2x2 block
+static void R_Webcam_PackNV12(const u8* rgba, u8* dst, int width, int height)
+{
+    u8* cbcr = dst + (size_t)width * height;
+    for (int y = 0; y < height; y += 2) {
+        const u8* row0 = rgba + (size_t)y * width * 4;
+        const u8* row1 = (y + 1 < height) ? row0 + width * 4 : row0;
+        u8* y0         = dst + (size_t)y * width;
+        u8* y1         = (y + 1 < height) ? y0 + width : NULL;
+        for (int x = 0; x < width; x += 2) {
+            int x1             = (x + 1 < width) ? x + 1 : x;
+            const u8* block[4] = { row0 + x * 4, row0 + x1 * 4, row1 + x * 4, row1 + x1 * 4 };
+
+            y0[x] = R_Webcam_Y(block[0][0], block[0][1], block[0][2]);
+            if (x1 != x) y0[x1] = R_Webcam_Y(block[1][0], block[1][1], block[1][2]);
+            if (y1) {
+                y1[x] = R_Webcam_Y(block[2][0], block[2][1], block[2][2]);
+                if (x1 != x) y1[x1] = R_Webcam_Y(block[3][0], block[3][1], block[3][2]);
+            }
+
+            int r = (block[0][0] + block[1][0] + block[2][0] + block[3][0] + 2) >> 2;
+            int g = (block[0][1] + block[1][1] + block[2][1] + block[3][1] + 2) >> 2;
+            int b = (block[0][2] + block[1][2] + block[2][2] + block[3][2] + 2) >> 2;
+            cbcr[0] = R_Webcam_Cb(r, g, b);
+            cbcr[1] = R_Webcam_Cr(r, g, b);
+            cbcr += 2;
+        }
+    }
+}
+
+// CAPTURE THREAD. Packs an RGBA frame into the back buffer and publishes it
+static void R_WebcamDevice_Deliver(R_WebcamDevice* dev, const u8* rgba)
+{
+    if (!dev->capture.load(std::memory_order_relaxed)) return;
+
+    R_WebcamFrame* frame = &dev->frames[dev->back];
+    frame->format        = (SG_WebcamFormat)dev->format.load(std::memory_order_relaxed);
+    frame->frame_count   = ++dev->frame_count;
+    switch (frame->format) {
+        case SG_WEBCAM_FORMAT_YUYV:
+            R_Webcam_PackYUYV(rgba, frame->data_OWNED, dev->width, dev->height);
+            break;
+        case SG_WEBCAM_FORMAT_NV12:
+            R_Webcam_PackNV12(rgba, frame->data_OWNED, dev->width, dev->height);
+            break;
+        default:
+            memcpy(frame->data_OWNED, rgba, (size_t)dev->width * dev->height * 4);
+            break;
+    }
+
+    // publish, and take whichever buffer was in the middle as the next back
+    u32 prev  = dev->middle.exchange(dev->back | R_WEBCAM_FRAME_NEW,
+                                     std::memory_order_acq_rel);
+    dev->back = prev & ~R_WEBCAM_FRAME_NEW;
+}
+
+// RENDER THREAD. Newest frame captured so far, frame_count 0 if none yet
+static R_WebcamFrame* R_WebcamDevice_Acquire(R_WebcamDevice* dev)
+{
+    if (dev->middle.load(std::memory_order_relaxed) & R_WEBCAM_FRAME_NEW) {
+        u32 prev   = dev->middle.exchange(dev->front, std::memory_order_acq_rel);
+        dev->front = prev & ~R_WEBCAM_FRAME_NEW;
+    }
+    return &dev->frames[dev->front];
+}
+
+// EXECUTED ON SEPARATE THREAD
+static void R_Webcam_Callback(sr_webcam_device* device, void* data)
+{
+    // static u64 last_time{ stm_now() };
+    // double time_sec = stm_sec(stm_laptime(&last_time));
+    // log_trace("%f sec since last webcam update; framerate: %f", time_sec,
+    //           1.0 / time_sec);
+
+    // sr_webcam hands over RGBA (see sr_webcam_get_format_size)
+    R_WebcamDevice_Deliver((R_WebcamDevice*)sr_webcam_get_user(device), (u8*)data);
+}
+
+// synthetic device thread: scrolling color bars, so that motion, color and
+// frame pacing can be checked without a camera
+static void R_WebcamDevice_Generate(R_WebcamDevice* dev)
+{
+    u8* rgba = ALLOCATE_BYTES(u8, (size_t)dev->width * dev->height * 4);
+
+    std::chrono::steady_clock::duration frame_time = std::chrono::microseconds(1000000 / dev->fps);
+    std::chrono::steady_clock::time_point next     = std::chrono::steady_clock::now();
+    for (u32 t = 0; dev->running.load(std::memory_order_relaxed); t++) {
+        for (int y = 0; y < dev->height; y++) {
+            u8* p = rgba + (size_t)y * dev->width * 4;
+            for (int x = 0; x < dev->width; x++) {
+                u32 bar = ((x + t * 4) * 8 / MAX(dev->width, 8)) & 7;
+                p[0]    = (bar & 1) ? 255 : 0;
+                p[1]    = (bar & 2) ? 255 : 0;
+                p[2]    = (bar & 4) ? 255 : 0;
+                p[3]    = 255;
+                if (y > dev->height * 3 / 4) { // gradient strip, shows YUV banding
+                    p[0] = p[1] = p[2] = (u8)(x * 255 / MAX(dev->width - 1, 1));
+                }
+                p += 4;
+            }
+        }
+        R_WebcamDevice_Deliver(dev, rgba);
+
+        next += frame_time;
+        std::this_thread::sleep_until(next);
+    }
+
+    FREE(rgba);
+}
 
-// stores webcam pixel data, device id is the key
-static R_WebcamData _r_webcam_data[8] = {}; // supports up to 8 webcams
+static Arena r_webcam_devices; // R_WebcamDevice*, device id is the key
+
+static R_WebcamDevice* R_WebcamDevice_Get(int device_id)
+{
+    int count = (int)ARENA_LENGTH(&r_webcam_devices, R_WebcamDevice*);
+    for (int i = 0; i < count; i++) {
+        R_WebcamDevice* dev = *ARENA_GET_TYPE(&r_webcam_devices, R_WebcamDevice*, i);
+        if (dev->device_id == device_id) return dev;
+    }
+    return NULL;
+}
+
+static void R_WebcamDevice_FreeAll()
+{
+    int count = (int)ARENA_LENGTH(&r_webcam_devices, R_WebcamDevice*);
+    for (int i = 0; i < count; i++) {
+        R_WebcamDevice* dev = *ARENA_GET_TYPE(&r_webcam_devices, R_WebcamDevice*, i);
+        log_info("Closing webcam device %d", dev->device_id);
+        if (dev->webcam) {
+            // doesn't crash here, see SG_CreateWebcam()
+            sr_webcam_delete(dev->webcam);
+        }
+        if (dev->generator) {
+            dev->running.store(false, std::memory_order_relaxed);
+            dev->generator->join();
+            delete dev->generator;
+        }
+        for (u32 f = 0; f < ARRAY_LENGTH(dev->frames); f++) FREE(dev->frames[f].data_OWNED);
+        FREE_TYPE(R_WebcamDevice, dev);
+    }
+    Arena::free(&r_webcam_devices);
+}
 
 struct R_Location {
     SG_ID id;     // key
@@ -1780,6 +3159,25 @@ void Component_Free()
 {
     // TODO: should we also free the individual components?
 
+    // videos may still have decode jobs in flight
+    size_t video_idx = 0;
+    R_Video* video   = NULL;
+    while (Component_VideoIter(&video_idx, &video)) R_Video::free(video);
+
+    // keyframe indices are built on the Jobs pool too
+    Jobs_WaitOwn(&r_video_index_jobs);
+    for (int i = 0; i < (int)ARENA_LENGTH(&r_video_indices, R_VideoIndex*); i++) {
+        R_VideoIndex* index = *ARENA_GET_TYPE(&r_video_indices, R_VideoIndex*, i);
+        Arena::free(&index->keyframes);
+        index->~R_VideoIndex();
+        FREE_TYPE(R_VideoIndex, index);
+    }
+    Arena::free(&r_video_indices);
+
+    size_t webcam_idx = 0;
+    R_Webcam* webcam  = NULL;
+    while (Component_WebcamIter(&webcam_idx, &webcam)) R_Webcam::free(webcam);
+
     // free arena memory
     Arena::free(&xformArena);
     Arena::free(&sceneArena);
@@ -1790,20 +3188,30 @@ void Component_Free()
     Arena::free(&cameraArena);
     Arena::free(&textArena);
     Arena::free(&passArena);
+    TextLayout_Free();
+
+    // free fonts, waiting out any that are still loading
+    for (auto& entry : font_registry) {
+        Jobs_Wait(&entry.second->load_job);
+        R_Font::free(entry.second);
+        delete entry.second;
+    }
+    font_registry.clear();
+    for (R_Font* font : font_failed) {
+        R_Font::free(font);
+        delete font;
+    }
+    font_failed.clear();
+    font_failed_frame.clear();
+    font_fallback = NULL;
     // Arena::free(&bufferArena);
 
     // free locator
     hashmap_free(r_locator);
     r_locator = NULL;
 
-    // free webcam (doesn't crash)
-    for (int i = 0; i < ARRAY_LENGTH(_r_webcam_data); i++) {
-        if (_r_webcam_data[i].webcam) {
-            log_info("Closing webcam device %d", i);
-            sr_webcam_delete(_r_webcam_data[i].webcam);
-            _r_webcam_data[i].webcam = NULL;
-        }
-    }
+    // free webcams (doesn't crash)
+    R_WebcamDevice_FreeAll();
 }
 
 // analgous to audio thread's `_SG_ComponentManagerFree`
@@ -1844,6 +3252,40 @@ static void _Component_FreeComponent(SG_ID id, int component_size)
     ASSERT(delete_result);
 }
 
+// R_Text holds std::strings, which can't be moved with the memcpy in
+// _Component_FreeComponent. Releases the text's font and layout, then
+// swap-deletes with a move instead
+static void _Component_FreeText(R_Text* text)
+{
+    SG_ID id = text->id;
+
+    R_Transform* parent = Component_GetXform(text->parentID);
+    if (parent) R_Transform::removeChild(parent, text);
+    R_Scene* scene = Component_GetScene(text->scene_id);
+    if (scene) R_Scene::unregisterMesh(scene, text);
+
+    if (text->font) Component_FontRelease(text->font);
+    text->font = NULL;
+    Arena::free(&text->children);
+    Arena::free(&text->layout_paragraphs);
+    Arena::free(&text->layout_lines);
+    Arena::free(&text->layout_glyphs);
+
+    R_Text* last = ARENA_GET_LAST_TYPE(&textArena, R_Text);
+    if (text != last) {
+        *text             = std::move(*last);
+        R_Location* moved = (R_Location*)hashmap_get(r_locator, &text->id);
+        ASSERT(moved && moved->arena == &textArena);
+        moved->offset = Arena::offsetOf(&textArena, text);
+    }
+    last->~R_Text();
+    ARENA_POP_TYPE(&textArena, R_Text);
+
+    const void* delete_result = hashmap_delete(r_locator, &id);
+    UNUSED_VAR(delete_result);
+    ASSERT(delete_result);
+}
+
 // component garbage collection
 void Component_FreeComponent(SG_ID id)
 {
@@ -1856,6 +3298,13 @@ void Component_FreeComponent(SG_ID id)
             R_Shader::free((R_Shader*)comp);
             _Component_FreeComponent(id, sizeof(R_Shader));
         } break;
+        case SG_COMPONENT_MESH: {
+            // only GText meshes are collected, other meshes are kept alive
+            R_Location* loc = (R_Location*)hashmap_get(r_locator, &id);
+            if (loc->arena != &textArena) break;
+            log_trace("graphics thread freeing text %d", comp->id);
+            _Component_FreeText((R_Text*)comp);
+        } break;
         default: {
             // other types not yet supported
         }
@@ -1933,8 +3382,22 @@ R_Camera* Component_CreateCamera(GraphicsContext* gctx, SG_Command_CameraCreate*
     return cam;
 }
 
-R_Text* Component_CreateText(GraphicsContext* gctx, FT_Library ft,
-                             SG_Command_TextRebuild* cmd, R_Font* default_font)
+// lays out text with its font, or a stand-in while that font is loading (or
+// failed to load)
+static void R_Text_rebuild(GraphicsContext* gctx, R_Text* text, R_Font* default_font)
+{
+    R_Font* font = text->font;
+    if (!font->ready) font = default_font;
+    if (!font->ready) font = font_fallback;
+    R_Font::updateText(gctx, font, text);
+
+    // GText.bounds()
+    BoundingBox bb = text->layout_bounds;
+    CQ_PushCommand_G2A_TextBounds(text->id, bb.minX, bb.minY, bb.maxX, bb.maxY);
+}
+
+R_Text* Component_CreateText(GraphicsContext* gctx, SG_Command_TextRebuild* cmd,
+                             R_Font* default_font)
 {
     // see if text is already created
     R_Text* text = Component_GetText(cmd->text_id);
@@ -1983,9 +3446,14 @@ R_Text* Component_CreateText(GraphicsContext* gctx, FT_Library ft,
     text->alignment        = cmd->alignment;
     text->size             = cmd->size;
 
-    R_Font* font = Component_GetFont(gctx, ft, text->font_path.c_str());
+    R_Font* font = Component_GetFont(gctx, text->font_path.c_str());
     if (!font) font = default_font;
-    R_Font::updateText(gctx, font, text);
+    if (font != text->font) {
+        Component_FontAcquire(font);
+        if (text->font) Component_FontRelease(text->font);
+        text->font = font;
+    }
+    R_Text_rebuild(gctx, text, default_font);
 
     return text;
 }
@@ -2034,6 +3502,8 @@ R_Geometry* Component_CreateGeometry(GraphicsContext* gctx, SG_ID geo_id)
     geo->type          = SG_COMPONENT_GEOMETRY;
     geo->vertex_count  = -1; // -1 means draw all vertices
     geo->indices_count = -1; // -1 means draw all vertices
+    geo->lod_levels    = 1;  // LODs off until set by SG_Geometry
+    geo->lod_force     = -1;
 
     // for now not storing geo_type (cube, sphere, custom etc.)
     // we only store the GPU vertex data, and don't care about semantics
@@ -2134,141 +3604,767 @@ R_Texture* Component_CreateTexture(GraphicsContext* gctx, SG_Command_TextureCrea
     // R_Texture init
     R_Texture::init(gctx, tex, &cmd->desc, framebuffer_width, framebuffer_height);
 
-    // store offset
-    R_Location loc = { tex->id, Arena::offsetOf(&textureArena, tex), &textureArena };
-    const void* result = hashmap_set(r_locator, &loc);
-    ASSERT(result == NULL); // ensure id is unique
-    UNUSED_VAR(result);
+    // store offset
+    R_Location loc = { tex->id, Arena::offsetOf(&textureArena, tex), &textureArena };
+    const void* result = hashmap_set(r_locator, &loc);
+    ASSERT(result == NULL); // ensure id is unique
+    UNUSED_VAR(result);
+
+    return tex;
+}
+
+R_Pass* Component_CreatePass(SG_ID pass_id, WGPUDevice device)
+{
+    Arena* arena = &passArena;
+    R_Pass* pass = ARENA_PUSH_TYPE(arena, R_Pass);
+    *pass        = {};
+
+    // SG_Component init
+    pass->id   = pass_id;
+    pass->type = SG_COMPONENT_PASS;
+
+    // init frame uniform buffer
+    char label[64];
+    snprintf(label, sizeof(label), "Pass[%d] Frame Uniform Buffer", pass_id);
+    WGPUBufferDescriptor desc  = {};
+    desc.label                 = label;
+    desc.usage                 = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+    desc.size                  = NEXT_MULT4(sizeof(FrameUniforms));
+    pass->frame_uniform_buffer = wgpuDeviceCreateBuffer(device, &desc);
+    ASSERT(pass->frame_uniform_buffer);
+
+    // store offset
+    R_Location loc     = { pass->id, Arena::offsetOf(arena, pass), arena };
+    const void* result = hashmap_set(r_locator, &loc);
+    ASSERT(result == NULL); // ensure id is unique
+    UNUSED_VAR(result);
+
+    return pass;
+}
+
+R_Buffer* Component_CreateBuffer(SG_ID id)
+{
+    Arena* arena     = &bufferArena;
+    R_Buffer* buffer = ARENA_PUSH_TYPE(arena, R_Buffer);
+    *buffer          = {};
+
+    // SG_Component init
+    buffer->id   = id;
+    buffer->type = SG_COMPONENT_BUFFER;
+
+    // store offset
+    R_Location loc     = { buffer->id, Arena::offsetOf(arena, buffer), arena };
+    const void* result = hashmap_set(r_locator, &loc);
+    ASSERT(result == NULL); // ensure id is unique
+    UNUSED_VAR(result);
+
+    return buffer;
+}
+
+R_Light* Component_CreateLight(SG_ID id, SG_LightDesc* desc, WGPUDevice device,
+                               WGPULimits* limits)
+{
+    R_Light* light = ARENA_PUSH_ZERO_TYPE(&lightArena, R_Light);
+
+    R_Transform_init(light, id, SG_COMPONENT_LIGHT);
+
+    // light init
+    light->desc = *desc;
+    light->shadow_render_id_set
+      = hashmap_new_simple(sizeof(SG_ID), hashSGID, compareSGIDs);
+    light->draw_storage_buffer = NULL;
+
+    // init frame uniform buffer, one FrameUniforms per shadow view
+    light->frame_uniform_stride
+      = NEXT_MULT(sizeof(FrameUniforms), limits->minUniformBufferOffsetAlignment);
+    char label[64];
+    snprintf(label, sizeof(label), "Light[%d] Frame Uniform Buffer", id);
+    WGPUBufferDescriptor buffer_desc = {};
+    buffer_desc.label                = label;
+    buffer_desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+    buffer_desc.size  = CHUGL_SHADOW_MAX_VIEWS * light->frame_uniform_stride;
+    light->frame_uniform_buffer = wgpuDeviceCreateBuffer(device, &buffer_desc);
+    ASSERT(light->frame_uniform_buffer);
+
+    // store offset
+    R_Location loc = { light->id, Arena::offsetOf(&lightArena, light), &lightArena };
+    const void* result = hashmap_set(r_locator, &loc);
+    ASSERT(result == NULL); // ensure id is unique
+    UNUSED_VAR(result);
+
+    return light;
+}
+
+// ----------------------------------------------------------------------------
+// R_Video decoding
+// ----------------------------------------------------------------------------
+// Each video owns an R_VideoDecoder, heap allocated so that its address stays
+// stable while the video arena grows. A decode job on the Jobs pool fills the
+// free slots of a single-producer/single-consumer ring with copies of the
+// decoded YUV planes; the render thread consumes frames by presentation time.
+// At most one job per video is in flight, and only that job touches plm.
+//
+// Seeking and reverse playback go through a keyframe index, built once per file
+// on the Jobs pool. Until it is ready, seeks fall back to plm's own search and
+// reverse playback waits.
+
+#define R_VIDEO_RING_SIZE 4
+
+// frames kept for reverse playback. Covers a whole GOP for common encodes
+// (ffmpeg defaults to 12 frames), longer GOPs are decoded in several windows
+#define R_VIDEO_GOP_CACHE_SIZE 16
+
+struct R_VideoFrame {
+    double pts;         // presentation time in seconds, monotonic across loops
+    double stream_time; // time within the file
+    u32 generation;     // R_Video::generation at the time of decoding
+    plm_frame_t frame;  // planes point into data_OWNED
+    u8* data_OWNED;     // Y, Cr, Cb planes back to back
+};
+
+struct R_VideoKeyframe {
+    double time; // stream time of the intra frame
+    size_t pos;  // byte offset of its packet, for plm_seek_frame_at
+};
+
+struct R_VideoIndex {
+    // a file replaced at the same path gets a new index
+    u64 path_hash;
+    u64 file_size;
+    i64 file_mtime;
+    std::atomic<bool> ready; // keyframes are immutable once set
+    Arena keyframes;         // R_VideoKeyframe, ascending time
+};
+
+// indices are shared by every video of the same file and live until exit
+static spinlock r_video_index_lock;
+static Arena r_video_indices;           // R_VideoIndex*
+static Jobs_Counter r_video_index_jobs; // R_VideoIndex_Build() in flight
+
+struct R_VideoIndexJob {
+    R_VideoIndex* index;
+    char* path_OWNED;
+};
+
+static void R_VideoIndex_Build(void* udata)
+{
+    R_VideoIndexJob* job = (R_VideoIndexJob*)udata;
+    R_VideoIndex* index  = job->index;
+
+    // separate demuxer, the decoders' plm instances belong to their own jobs
+    plm_buffer_t* buffer = plm_buffer_create_with_filename(job->path_OWNED);
+    plm_demux_t* demux   = buffer ? plm_demux_create(buffer, TRUE) : NULL;
+
+    size_t pos  = 0;
+    double time = 0;
+    while (demux && plm_demux_find_next_intra(demux, &pos, &time)) {
+        R_VideoKeyframe* keyframe = ARENA_PUSH_TYPE(&index->keyframes, R_VideoKeyframe);
+        keyframe->time            = time;
+        keyframe->pos             = pos;
+    }
+
+    if (demux) plm_demux_destroy(demux);
+    log_trace("indexed %d keyframes in %s",
+              (int)ARENA_LENGTH(&index->keyframes, R_VideoKeyframe), job->path_OWNED);
+
+    index->ready.store(true, std::memory_order_release);
+    FREE(job->path_OWNED);
+    FREE_TYPE(R_VideoIndexJob, job);
+}
+
+static R_VideoIndex* R_VideoIndex_Get(const char* path)
+{
+    u64 path_hash  = hashmap_xxhash3(path, strlen(path), 0, 0);
+    u64 file_size  = 0;
+    i64 file_mtime = 0;
+    struct stat file_stat;
+    if (stat(path, &file_stat) == 0) {
+        file_size  = (u64)file_stat.st_size;
+        file_mtime = (i64)file_stat.st_mtime;
+    }
+
+    spinlock::lock(&r_video_index_lock);
+    defer(spinlock::unlock(&r_video_index_lock));
+
+    int count = (int)ARENA_LENGTH(&r_video_indices, R_VideoIndex*);
+    for (int i = 0; i < count; i++) {
+        R_VideoIndex* index = *ARENA_GET_TYPE(&r_video_indices, R_VideoIndex*, i);
+        if (index->path_hash == path_hash && index->file_size == file_size
+            && index->file_mtime == file_mtime)
+            return index;
+    }
+
+    R_VideoIndex* index = new (ALLOCATE_TYPE(R_VideoIndex)) R_VideoIndex{};
+    index->path_hash    = path_hash;
+    index->file_size    = file_size;
+    index->file_mtime   = file_mtime;
+    *ARENA_PUSH_TYPE(&r_video_indices, R_VideoIndex*) = index;
+
+    R_VideoIndexJob* job = ALLOCATE_TYPE(R_VideoIndexJob);
+    job->index           = index;
+    job->path_OWNED      = ALLOCATE_BYTES(char, strlen(path) + 1);
+    memcpy(job->path_OWNED, path, strlen(path) + 1);
+    Jobs_Submit(R_VideoIndex_Build, job, &r_video_index_jobs);
+
+    return index;
+}
+
+// last keyframe at or before time, NULL if there is none
+static R_VideoKeyframe* R_VideoIndex_Find(R_VideoIndex* index, double time)
+{
+    R_VideoKeyframe* keyframes = (R_VideoKeyframe*)index->keyframes.base;
+    int lo = 0, hi = (int)ARENA_LENGTH(&index->keyframes, R_VideoKeyframe);
+    while (lo < hi) { // first keyframe after time
+        int mid = lo + (hi - lo) / 2;
+        if (keyframes[mid].time <= time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? &keyframes[lo - 1] : NULL;
+}
+
+struct R_VideoDecoder {
+    plm_t* plm; // only touched by the decode job
+    R_VideoIndex* index;
+    double duration_secs;
+    double frame_secs; // 1 / framerate
+
+    R_VideoFrame ring[R_VIDEO_RING_SIZE];
+    std::atomic<u32> head; // next slot to decode into, written by the worker
+    std::atomic<u32> tail; // next slot to present, written by the render thread
+
+    Jobs_Counter decode_job; // R_VideoDecoder_Run() in flight
+    std::atomic<bool> ended; // end of stream reached (and not looping)
+
+    // requests from the render thread, applied at the start of the next job
+    spinlock lock;
+    bool requests_pending;
+    bool seek_requested;
+    double seek_time;
+    u32 generation;
+    bool loop;
+    bool reverse;
+    double clock; // render thread playback clock, refreshed every frame
+
+    // worker only
+    u32 decode_generation;
+    bool decode_loop;
+    bool decode_reverse;
+    double pts_offset;   // added to the stream time, moves by one duration per loop
+    double last_raw_pts; // stream time of the last decoded frame
+    bool rewound;        // plm looped back to the start since the last frame
+
+    // reverse playback: a window of decoded frames ending right before the
+    // last frame pushed, sorted by stream time
+    R_VideoFrame gop[R_VIDEO_GOP_CACHE_SIZE];
+    int gop_count;
+    double reverse_cursor; // stream time of the last frame pushed in reverse
+
+    // stats, accumulated by the worker and collected by the render thread
+    std::atomic<u64> window_ticks;     // total decode time since the last collect
+    std::atomic<u64> window_max_ticks; // slowest frame since the last collect
+    std::atomic<u32> window_frames;    // frames decoded since the last collect
+    std::atomic<u32> frames_decoded;   // lifetime
+};
+
+static R_VideoIndex* R_VideoDecoder_ReadyIndex(R_VideoDecoder* dec)
+{
+    if (!dec->index || !dec->index->ready.load(std::memory_order_acquire)) return NULL;
+    return dec->index;
+}
+
+static void R_VideoDecoder_RecordDecode(R_VideoDecoder* dec, u64 start)
+{
+    u64 ticks = stm_since(start);
+    dec->window_ticks += ticks;
+    if (ticks > dec->window_max_ticks.load(std::memory_order_relaxed))
+        dec->window_max_ticks.store(ticks, std::memory_order_relaxed);
+    dec->window_frames++;
+    dec->frames_decoded++;
+}
+
+// copies frame out of plm's internal buffers, which are reused by the next decode
+static void R_VideoFrame_Copy(R_VideoFrame* dst, plm_frame_t* frame)
+{
+    size_t y_size = frame->y.width * frame->y.height;
+    size_t c_size = frame->cr.width * frame->cr.height;
+    if (!dst->data_OWNED) {
+        // plane sizes are fixed for the lifetime of the stream
+        dst->data_OWNED = ALLOCATE_BYTES(u8, y_size + 2 * c_size);
+    }
+
+    dst->stream_time   = frame->time;
+    dst->frame         = *frame;
+    dst->frame.y.data  = dst->data_OWNED;
+    dst->frame.cr.data = dst->data_OWNED + y_size;
+    dst->frame.cb.data = dst->data_OWNED + y_size + c_size;
+    memcpy(dst->frame.y.data, frame->y.data, y_size);
+    memcpy(dst->frame.cr.data, frame->cr.data, c_size);
+    memcpy(dst->frame.cb.data, frame->cb.data, c_size);
+}
+
+static void R_VideoDecoder_Push(R_VideoDecoder* dec, plm_frame_t* frame, double pts)
+{
+    u32 head          = dec->head.load(std::memory_order_relaxed);
+    R_VideoFrame* dst = &dec->ring[head % R_VIDEO_RING_SIZE];
+
+    R_VideoFrame_Copy(dst, frame);
+    dst->pts        = pts;
+    dst->generation = dec->decode_generation;
+
+    // publish
+    dec->head.store(head + 1, std::memory_order_release);
+}
+
+static void R_VideoDecoder_PushForward(R_VideoDecoder* dec, plm_frame_t* frame)
+{
+    // stream time restarts at 0 when plm loops, keep presentation time monotonic
+    if (dec->rewound) {
+        dec->pts_offset += dec->last_raw_pts + dec->frame_secs;
+        dec->rewound = false;
+    }
+    dec->last_raw_pts = frame->time;
+    R_VideoDecoder_Push(dec, frame, dec->pts_offset + frame->time);
+}
+
+// decodes the frame showing at stream time t. Jumps straight to the keyframe
+// before it when the index is ready, otherwise plm searches the stream
+static plm_frame_t* R_VideoDecoder_SeekExact(R_VideoDecoder* dec, double t)
+{
+    // nearest frame rather than the first one at or after t
+    double target          = t - 0.5 * dec->frame_secs;
+    R_VideoIndex* index    = R_VideoDecoder_ReadyIndex(dec);
+    R_VideoKeyframe* start = index ? R_VideoIndex_Find(index, t + 0.5 * dec->frame_secs) : NULL;
+    if (start) return plm_seek_frame_at(dec->plm, start->pos, target, TRUE);
+    return plm_seek_frame(dec->plm, MAX(target, 0.0), TRUE);
+}
+
+static void R_VideoDecoder_FillForward(R_VideoDecoder* dec, u32 head, u32 tail,
+                                       double clock)
+{
+    // when playback is more than a GOP ahead of the decoder (high rates, slow
+    // machine) jump to the keyframe before the clock instead of decoding every
+    // frame in between
+    R_VideoIndex* index = R_VideoDecoder_ReadyIndex(dec);
+    double stream_clock = clock - dec->pts_offset;
+    if (index && !dec->rewound && head - tail < R_VIDEO_RING_SIZE
+        && stream_clock < dec->duration_secs) {
+        R_VideoKeyframe* keyframe = R_VideoIndex_Find(index, stream_clock);
+        if (keyframe && keyframe->time > dec->last_raw_pts + dec->frame_secs) {
+            u64 start          = stm_now();
+            plm_frame_t* frame = plm_seek_frame_at(dec->plm, keyframe->pos, keyframe->time, FALSE);
+            if (frame) {
+                R_VideoDecoder_PushForward(dec, frame);
+                R_VideoDecoder_RecordDecode(dec, start);
+                head++;
+            }
+        }
+    }
+
+    // fill the rest of the ring. Bounded so a single job doesn't hog a worker
+    // when the decoder is behind
+    int misses = 0;
+    while (head - tail < R_VIDEO_RING_SIZE && !dec->ended.load(std::memory_order_relaxed)) {
+        u64 start          = stm_now();
+        plm_frame_t* frame = plm_decode_video(dec->plm);
+        if (!frame) {
+            if (plm_has_ended(dec->plm)) {
+                dec->ended.store(true, std::memory_order_relaxed);
+                break;
+            }
+            // plm rewound the stream (looping), or a corrupt packet
+            dec->rewound = true;
+            if (++misses > 1) break;
+            continue;
+        }
+        misses = 0;
+
+        R_VideoDecoder_PushForward(dec, frame);
+        R_VideoDecoder_RecordDecode(dec, start);
+        head++;
+    }
+}
+
+// fills the GOP cache with the frames from keyframe up to (excluding) before,
+// keeping the last R_VIDEO_GOP_CACHE_SIZE of them
+static void R_VideoDecoder_DecodeGop(R_VideoDecoder* dec, R_VideoKeyframe* keyframe,
+                                     double before)
+{
+    dec->gop_count = 0;
+
+    u64 start          = stm_now();
+    plm_frame_t* frame = plm_seek_frame_at(dec->plm, keyframe->pos, keyframe->time, FALSE);
+    double prev_time   = -1.0;
+    // a smaller time means plm looped back to the start
+    while (frame && frame->time < before && frame->time > prev_time) {
+        if (dec->gop_count == R_VIDEO_GOP_CACHE_SIZE) {
+            // slide the window, recycling the oldest frame's planes
+            R_VideoFrame oldest = dec->gop[0];
+            memmove(dec->gop, dec->gop + 1,
+                    (R_VIDEO_GOP_CACHE_SIZE - 1) * sizeof(R_VideoFrame));
+            dec->gop[R_VIDEO_GOP_CACHE_SIZE - 1] = oldest;
+            dec->gop_count--;
+        }
+        R_VideoFrame_Copy(&dec->gop[dec->gop_count++], frame);
+        R_VideoDecoder_RecordDecode(dec, start);
+
+        prev_time = frame->time;
+        start     = stm_now();
+        frame     = plm_decode_video(dec->plm);
+    }
+}
+
+static void R_VideoDecoder_FillReverse(R_VideoDecoder* dec, u32 head, u32 tail)
+{
+    R_VideoIndex* index = R_VideoDecoder_ReadyIndex(dec);
+    if (!index) return; // try again once the index is built
+
+    // tolerance for comparing frame times
+    double eps   = 0.25 * dec->frame_secs;
+    bool wrapped = false;
+    int decodes  = 0;
+    while (head - tail < R_VIDEO_RING_SIZE) {
+        // newest cached frame before the cursor
+        R_VideoFrame* cached = NULL;
+        for (int i = dec->gop_count - 1; i >= 0; i--) {
+            if (dec->gop[i].stream_time < dec->reverse_cursor - eps) {
+                cached = &dec->gop[i];
+                break;
+            }
+        }
+
+        if (cached) {
+            R_VideoDecoder_Push(dec, &cached->frame, dec->pts_offset + cached->stream_time);
+            dec->reverse_cursor = cached->stream_time;
+            head++;
+            continue;
+        }
+
+        R_VideoKeyframe* keyframe = R_VideoIndex_Find(index, dec->reverse_cursor - eps);
+        if (!keyframe) { // went past the first frame
+            if (!dec->decode_loop) {
+                dec->ended.store(true, std::memory_order_relaxed);
+                break;
+            }
+            if (wrapped) break; // nothing decodable in the whole stream
+            wrapped = true;
+            // continue from the last frame, one frame before the first
+            dec->pts_offset -= dec->duration_secs + dec->frame_secs;
+            dec->reverse_cursor = dec->duration_secs + dec->frame_secs;
+            dec->gop_count      = 0;
+            continue;
+        }
 
-    return tex;
+        // one GOP per job at most, a long GOP can take a while to decode
+        if (decodes++ > 0) break;
+        R_VideoDecoder_DecodeGop(dec, keyframe, dec->reverse_cursor - eps);
+        if (dec->gop_count == 0) break; // corrupt GOP
+    }
 }
 
-R_Pass* Component_CreatePass(SG_ID pass_id, WGPUDevice device)
+static void R_VideoDecoder_Run(void* udata)
 {
-    Arena* arena = &passArena;
-    R_Pass* pass = ARENA_PUSH_TYPE(arena, R_Pass);
-    *pass        = {};
+    R_VideoDecoder* dec = (R_VideoDecoder*)udata;
+
+    bool seek        = false;
+    double seek_time = 0;
+    bool apply       = false;
+    spinlock::lock(&dec->lock);
+    double clock = dec->clock;
+    if (dec->requests_pending) {
+        seek                   = dec->seek_requested;
+        seek_time              = dec->seek_time;
+        apply                  = true;
+        dec->decode_loop       = dec->loop;
+        dec->decode_reverse    = dec->reverse;
+        dec->decode_generation = dec->generation;
+        dec->seek_requested    = false;
+        dec->requests_pending  = false;
+    }
+    spinlock::unlock(&dec->lock);
 
-    // SG_Component init
-    pass->id   = pass_id;
-    pass->type = SG_COMPONENT_PASS;
+    if (apply) {
+        plm_set_loop(dec->plm, dec->decode_loop);
+        // rewinds on the next decode if we stopped at the end of the stream
+        if (dec->decode_loop) dec->ended.store(false, std::memory_order_relaxed);
+    }
 
-    // init frame uniform buffer
-    char label[64];
-    snprintf(label, sizeof(label), "Pass[%d] Frame Uniform Buffer", pass_id);
-    WGPUBufferDescriptor desc  = {};
-    desc.label                 = label;
-    desc.usage                 = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-    desc.size                  = NEXT_MULT4(sizeof(FrameUniforms));
-    pass->frame_uniform_buffer = wgpuDeviceCreateBuffer(device, &desc);
-    ASSERT(pass->frame_uniform_buffer);
+    // stale frames still in the ring are skipped by the render thread, but
+    // they take up slots until then
+    u32 tail = dec->tail.load(std::memory_order_acquire);
+    u32 head = dec->head.load(std::memory_order_relaxed);
+
+    if (seek && head - tail < R_VIDEO_RING_SIZE) {
+        double t        = CLAMP(seek_time, 0.0, dec->duration_secs);
+        dec->pts_offset = 0;
+        dec->rewound    = false;
+        dec->ended.store(false, std::memory_order_relaxed);
+        if (dec->decode_reverse) {
+            // include the frame showing at t
+            dec->reverse_cursor = t + 0.5 * dec->frame_secs;
+        } else {
+            u64 start          = stm_now();
+            plm_frame_t* frame = R_VideoDecoder_SeekExact(dec, t);
+            if (frame) {
+                // presented immediately
+                R_VideoDecoder_PushForward(dec, frame);
+                R_VideoDecoder_RecordDecode(dec, start);
+                head++;
+            }
+        }
+    } else if (seek) {
+        // no free slot, retry on the next job. Decoding on from here would tag
+        // pre-seek frames with the new generation
+        spinlock::lock(&dec->lock);
+        if (!dec->seek_requested) {
+            dec->seek_requested = true;
+            dec->seek_time      = seek_time;
+        }
+        dec->requests_pending = true;
+        spinlock::unlock(&dec->lock);
+        return;
+    }
 
-    // store offset
-    R_Location loc     = { pass->id, Arena::offsetOf(arena, pass), arena };
-    const void* result = hashmap_set(r_locator, &loc);
-    ASSERT(result == NULL); // ensure id is unique
-    UNUSED_VAR(result);
+    if (dec->decode_reverse)
+        R_VideoDecoder_FillReverse(dec, head, tail);
+    else
+        R_VideoDecoder_FillForward(dec, head, tail, clock);
+}
 
-    return pass;
+// how often decode stats are sent to the audio thread
+#define R_VIDEO_STATS_INTERVAL_SECS 0.5f
+
+static void R_Video_SendStats(R_Video* video, bool resync = false)
+{
+    R_VideoDecoder* dec = video->decoder;
+
+    u64 ticks  = dec->window_ticks.exchange(0, std::memory_order_relaxed);
+    u64 max    = dec->window_max_ticks.exchange(0, std::memory_order_relaxed);
+    u32 frames = dec->window_frames.exchange(0, std::memory_order_relaxed);
+
+    SG_VideoStats stats  = {};
+    stats.decode_ms      = frames ? (float)stm_ms(ticks) / frames : 0.0f;
+    stats.decode_ms_max  = (float)stm_ms(max);
+    stats.frames_decoded = (int)dec->frames_decoded.load(std::memory_order_relaxed);
+    stats.frames_dropped = video->frames_dropped;
+    stats.frames_queued  = (int)(dec->head.load(std::memory_order_acquire)
+                                - dec->tail.load(std::memory_order_relaxed));
+    stats.resync         = resync;
+    stats.stream_time    = video->presented_stream_time;
+    CQ_PushCommand_G2A_VideoStats(video->id, &stats);
 }
 
-R_Buffer* Component_CreateBuffer(SG_ID id)
+// uploads one plane of a YUV frame, (re)creating the texture when the plane's
+// size or format changes. Returns true if the texture was (re)created, bind
+// groups referencing the old one must be rebuilt
+static bool R_WriteYUVPlane(GraphicsContext* gctx, WGPUTexture* texture,
+                            WGPUTextureFormat format, u32 width, u32 height,
+                            u32 bytes_per_texel, const void* data, const char* label)
 {
-    Arena* arena     = &bufferArena;
-    R_Buffer* buffer = ARENA_PUSH_TYPE(arena, R_Buffer);
-    *buffer          = {};
+    bool created = false;
+    if (*texture
+        && (wgpuTextureGetWidth(*texture) != width
+            || wgpuTextureGetHeight(*texture) != height
+            || wgpuTextureGetFormat(*texture) != format)) {
+        WGPU_RELEASE_RESOURCE(Texture, *texture);
+    }
+    if (*texture == NULL) {
+        WGPUTextureDescriptor desc = {};
+        desc.label                 = label;
+        desc.usage         = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+        desc.dimension     = WGPUTextureDimension_2D;
+        desc.size          = { width, height, 1 };
+        desc.format        = format;
+        desc.mipLevelCount = 1;
+        desc.sampleCount   = 1;
+        *texture           = wgpuDeviceCreateTexture(gctx->device, &desc);
+        created            = true;
+    }
 
-    // SG_Component init
-    buffer->id   = id;
-    buffer->type = SG_COMPONENT_BUFFER;
+    WGPUImageCopyTexture destination = {};
+    destination.texture              = *texture;
+    destination.aspect               = WGPUTextureAspect_All;
 
-    // store offset
-    R_Location loc     = { buffer->id, Arena::offsetOf(arena, buffer), arena };
-    const void* result = hashmap_set(r_locator, &loc);
-    ASSERT(result == NULL); // ensure id is unique
-    UNUSED_VAR(result);
+    WGPUTextureDataLayout layout = {};
+    layout.bytesPerRow           = width * bytes_per_texel;
+    layout.rowsPerImage          = height;
 
-    return buffer;
+    WGPUExtent3D size = { width, height, 1 };
+    wgpuQueueWriteTexture(gctx->queue, &destination, data,
+                          width * height * bytes_per_texel, &layout, &size);
+    return created;
 }
 
-R_Light* Component_CreateLight(SG_ID id, SG_LightDesc* desc, WGPUDevice device,
-                               WGPULimits* limits)
+void R_Video::update(GraphicsContext* gctx, WGPUCommandEncoder cmd_encoder,
+                     R_Video* video, f32 dt)
 {
-    R_Light* light = ARENA_PUSH_ZERO_TYPE(&lightArena, R_Light);
-
-    R_Transform_init(light, id, SG_COMPONENT_LIGHT);
+    R_VideoDecoder* dec = video->decoder;
+    if (!dec) return;
+
+    video->clock += dt * video->rate;
+
+    // the decoder skips ahead when it falls behind the clock
+    spinlock::lock(&dec->lock);
+    dec->clock = video->clock;
+    spinlock::unlock(&dec->lock);
+
+    // pick the newest frame that is due. Slots are only handed back to the
+    // worker after the upload, so the frame can't be overwritten while in use
+    u32 tail               = dec->tail.load(std::memory_order_relaxed);
+    u32 head               = dec->head.load(std::memory_order_acquire);
+    R_VideoFrame* presented = NULL;
+    while (tail != head) {
+        R_VideoFrame* f = &dec->ring[tail % R_VIDEO_RING_SIZE];
+        if (f->generation != video->generation) { // decoded before a seek
+            ++tail;
+            continue;
+        }
+        // in reverse, presentation times count down
+        if (video->reverse ? f->pts < video->clock : f->pts > video->clock) break;
+        if (presented) ++video->frames_dropped;
+        presented = f;
+        ++tail;
+    }
 
-    // light init
-    light->desc = *desc;
-    light->shadow_render_id_set
-      = hashmap_new_simple(sizeof(SG_ID), hashSGID, compareSGIDs);
-    light->draw_storage_buffer = NULL;
+    if (presented) {
+        R_Texture* video_texture_rgba
+          = Component_GetTexture(video->video_texture_rgba_id);
+        plm_frame_t* frame = &presented->frame;
 
-    // init frame uniform buffer
-    char label[64];
-    snprintf(label, sizeof(label), "Light[%d] Frame Uniform Buffer", id);
-    WGPUBufferDescriptor buffer_desc = {};
-    buffer_desc.label                = label;
-    buffer_desc.usage           = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-    buffer_desc.size            = NEXT_MULT4(sizeof(FrameUniforms));
-    light->frame_uniform_buffer = wgpuDeviceCreateBuffer(device, &buffer_desc);
-    ASSERT(light->frame_uniform_buffer);
+        ASSERT(video_texture_rgba);
+        ASSERT(video_texture_rgba->desc.width == frame->width);
+        ASSERT(video_texture_rgba->desc.height == frame->height);
+        ASSERT(video_texture_rgba->desc.format == WGPUTextureFormat_RGBA8Unorm);
+
+        // 1.5 bytes per pixel instead of 4 for rgba
+        // plane sizes are fixed for the lifetime of the stream
+        R_WriteYUVPlane(gctx, &video->planes[0], WGPUTextureFormat_R8Unorm,
+                        frame->y.width, frame->y.height, 1, frame->y.data,
+                        "video Y plane");
+        R_WriteYUVPlane(gctx, &video->planes[1], WGPUTextureFormat_R8Unorm,
+                        frame->cb.width, frame->cb.height, 1, frame->cb.data,
+                        "video Cb plane");
+        R_WriteYUVPlane(gctx, &video->planes[2], WGPUTextureFormat_R8Unorm,
+                        frame->cr.width, frame->cr.height, 1, frame->cr.data,
+                        "video Cr plane");
+
+        if (video->yuv_bind_group_dst != video_texture_rgba->gpu_texture) {
+            WGPU_RELEASE_RESOURCE(BindGroup, video->yuv_bind_group);
+            video->yuv_bind_group = YUVToRGBA_createBindGroup(
+              gctx, video->planes[0], video->planes[1], video->planes[2],
+              video_texture_rgba->gpu_texture);
+            video->yuv_bind_group_dst = video_texture_rgba->gpu_texture;
+        }
+        YUVToRGBA_convert(gctx, cmd_encoder, video->yuv_bind_group, YUV_LAYOUT_I420,
+                          frame->width, frame->height);
 
-    // store offset
-    R_Location loc = { light->id, Arena::offsetOf(&lightArena, light), &lightArena };
-    const void* result = hashmap_set(r_locator, &loc);
-    ASSERT(result == NULL); // ensure id is unique
-    UNUSED_VAR(result);
+        video->presented_pts         = presented->pts;
+        video->presented_stream_time = presented->stream_time;
+    }
+    dec->tail.store(tail, std::memory_order_release);
+
+    // keep the ring topped up
+    if (Jobs_Done(&dec->decode_job) && head - tail < R_VIDEO_RING_SIZE) {
+        bool can_decode = !dec->ended.load(std::memory_order_relaxed);
+        if (!can_decode) { // a seek or loop may restart playback
+            spinlock::lock(&dec->lock);
+            can_decode = dec->requests_pending;
+            spinlock::unlock(&dec->lock);
+        }
+        if (can_decode) Jobs_Submit(R_VideoDecoder_Run, dec, &dec->decode_job);
+    }
 
-    return light;
+    video->stats_timer += dt;
+    if (video->stats_timer >= R_VIDEO_STATS_INTERVAL_SECS) {
+        video->stats_timer = 0;
+        R_Video_SendStats(video);
+    }
 }
 
-static void R_Video_OnVideo(plm_t* player, plm_frame_t* frame, void* video_id)
+void R_Video::seek(R_Video* video, double time_secs)
 {
-    R_Video* video = Component_GetVideo((intptr_t)video_id);
+    R_VideoDecoder* dec = video->decoder;
+    if (!dec) return;
+
+    spinlock::lock(&dec->lock);
+    dec->seek_requested   = true;
+    dec->seek_time        = time_secs;
+    dec->reverse          = video->reverse;
+    dec->generation       = ++video->generation;
+    dec->requests_pending = true;
+    spinlock::unlock(&dec->lock);
+
+    // the decoder clamps to [0, duration]
+    video->clock                 = CLAMP(time_secs, 0.0, dec->duration_secs);
+    video->presented_pts         = video->clock;
+    video->presented_stream_time = video->clock;
+}
 
-    // log_info("Video frame time %f", frame->time);
+void R_Video::setRate(R_Video* video, f32 rate)
+{
+    bool reverse = rate < 0;
+    video->rate  = rate;
 
-    // Hand the decoded data over to OpenGL. For the RGB texture mode, the
-    // YCrCb->RGB conversion is done on the CPU.
+    R_VideoDecoder* dec = video->decoder;
+    if (!dec || reverse == video->reverse) return;
 
-    // TODO support YCrCb mode
-    // if (self->texture_mode == APP_TEXTURE_MODE_YCRCB) {
-    //     app_update_texture(self, GL_TEXTURE0, self->texture_y, &frame->y);
-    //     app_update_texture(self, GL_TEXTURE1, self->texture_cb, &frame->cb);
-    //     app_update_texture(self, GL_TEXTURE2, self->texture_cr, &frame->cr);
-    // } else {
+    // frames in the ring go the wrong way, restart from what is on screen.
+    // The offset accounts for time passed since it was presented
+    double stream_time = video->presented_stream_time
+                         + (video->clock - video->presented_pts);
+    video->reverse     = reverse;
+    R_Video::seek(video, stream_time);
 
-    R_Texture* video_texture_rgba = Component_GetTexture(video->video_texture_rgba_id);
+    // audio can't play in reverse, it resumes from where decoding restarted
+    if (!reverse) R_Video_SendStats(video, true);
+}
 
-    { // memory bounds check
-        // check texture
-        ASSERT(video_texture_rgba);
-        ASSERT(video_texture_rgba->desc.width == frame->width);
-        ASSERT(video_texture_rgba->desc.height == frame->height);
-        ASSERT(video_texture_rgba->desc.depth == 1);
-        ASSERT(!video_texture_rgba->desc.gen_mips);
-        ASSERT(video_texture_rgba->desc.format
-               == WGPUTextureFormat_RGBA8Unorm); // TODO might need to go srgb
+void R_Video::setLoop(R_Video* video, bool loop)
+{
+    R_VideoDecoder* dec = video->decoder;
+    if (!dec) return;
+
+    spinlock::lock(&dec->lock);
+    dec->loop             = loop;
+    dec->reverse          = video->reverse;
+    dec->generation       = video->generation;
+    dec->requests_pending = true;
+    spinlock::unlock(&dec->lock);
+}
 
-        // check cpu pixel buffer size
-        ASSERT(video->rgba_data_size == frame->width * frame->height * 4);
-        ASSERT(video->rgba_data_OWNED);
+void R_Video::free(R_Video* video)
+{
+    R_VideoDecoder* dec = video->decoder;
+    if (dec) {
+        // only runs this video's decode, not whatever else is queued
+        Jobs_WaitOwn(&dec->decode_job);
+        plm_destroy(dec->plm);
+        for (int i = 0; i < R_VIDEO_RING_SIZE; i++) FREE(dec->ring[i].data_OWNED);
+        for (int i = 0; i < R_VIDEO_GOP_CACHE_SIZE; i++) FREE(dec->gop[i].data_OWNED);
+        FREE_TYPE(R_VideoDecoder, dec);
+        video->decoder = NULL;
     }
+    WGPU_RELEASE_RESOURCE(BindGroup, video->yuv_bind_group);
+    for (u32 i = 0; i < ARRAY_LENGTH(video->planes); i++) {
+        WGPU_RELEASE_RESOURCE(Texture, video->planes[i]);
+    }
+}
 
-    // convert yCrCb to rgba
-    plm_frame_to_rgba(frame, video->rgba_data_OWNED, frame->width * 4);
-
-    SG_TextureWriteDesc write_desc = {};
-    write_desc.width               = frame->width;
-    write_desc.height              = frame->height;
-    R_Texture::write(video->gctx, video_texture_rgba, &write_desc,
-                     video->rgba_data_OWNED, video->rgba_data_size);
+void R_Webcam::free(R_Webcam* webcam)
+{
+    WGPU_RELEASE_RESOURCE(BindGroup, webcam->yuv_bind_group);
+    for (u32 i = 0; i < ARRAY_LENGTH(webcam->planes); i++) {
+        WGPU_RELEASE_RESOURCE(Texture, webcam->planes[i]);
+    }
+    webcam->yuv_bind_group_dst = NULL;
 }
 
 R_Video* Component_CreateVideo(GraphicsContext* gctx, SG_ID id, const char* filename,
                                SG_ID rgba_texture_id)
 {
+    UNUSED_VAR(gctx);
+
     Arena* arena   = &videoArena;
     R_Video* video = ARENA_PUSH_TYPE(arena, R_Video);
     *video         = {};
@@ -2285,73 +4381,100 @@ R_Video* Component_CreateVideo(GraphicsContext* gctx, SG_ID id, const char* file
     UNUSED_VAR(result);
 
     { // video init (TODO move to video Desc struct)
-        video->gctx                  = gctx;
         video->video_texture_rgba_id = rgba_texture_id;
 
-        video->plm = plm_create_with_filename(filename);
+        plm_t* plm = plm_create_with_filename(filename);
 
         // validation
-        if (video->plm) {
-            if (!plm_probe(video->plm, 5000 * 1024)) {
+        if (plm) {
+            if (!plm_probe(plm, 5000 * 1024)) {
                 // no streams found, destroy
-                plm_destroy(video->plm);
-                video->plm = NULL;
+                plm_destroy(plm);
+                plm = NULL;
             }
         }
 
-        if (video->plm) {
-            // allocate pixel memory
-            int num_pixels = plm_get_width(video->plm) * plm_get_height(video->plm);
-            video->rgba_data_OWNED = ALLOCATE_BYTES(u8, num_pixels * 4);
-            video->rgba_data_size  = num_pixels * 4;
-
-            // memset to 256 for alpha
-            memset(video->rgba_data_OWNED, 255, video->rgba_data_size);
-
-            plm_set_video_decode_callback(video->plm, R_Video_OnVideo,
-                                          (void*)(intptr_t)video->id);
-
-            // don't process audio
-            plm_set_audio_enabled(video->plm, FALSE);
+        if (plm) {
+            // don't process audio, the audio thread decodes its own copy
+            plm_set_audio_enabled(plm, FALSE);
+
+            R_VideoDecoder* dec = ALLOCATE_TYPE(R_VideoDecoder);
+            memset(dec, 0, sizeof(*dec));
+            dec->plm           = plm;
+            dec->index         = R_VideoIndex_Get(filename);
+            dec->duration_secs = plm_get_duration(plm);
+            dec->frame_secs    = 1.0 / plm_get_framerate(plm);
+            video->decoder     = dec;
         }
     }
 
     return video;
 }
 
-void R_Webcam::updateTexture(GraphicsContext* gctx, R_Webcam* webcam)
+void R_Webcam::updateTexture(GraphicsContext* gctx, WGPUCommandEncoder cmd_encoder,
+                             R_Webcam* webcam)
 {
     if (webcam->freeze) return;
 
-    R_WebcamData* webcam_data = &_r_webcam_data[webcam->device_id];
-    R_Texture* texture        = Component_GetTexture(webcam->webcam_texture_id);
-    ASSERT(texture);
-
-    // lock
-    spinlock::lock(&webcam_data->lock);
-    defer(spinlock::unlock(&webcam_data->lock));
+    R_WebcamDevice* dev  = webcam->device;
+    R_WebcamFrame* frame = R_WebcamDevice_Acquire(dev);
 
-    // validate texture dimensions
-    int webcam_width{}, webcam_height{};
-    sr_webcam_get_dimensions(webcam_data->webcam, &webcam_width, &webcam_height);
-    ASSERT(texture->desc.width == webcam_width);
-    ASSERT(texture->desc.height == webcam_height);
+    // nothing new since the last upload
+    if (frame->frame_count == webcam->last_frame_count) return;
+    ASSERT(webcam->last_frame_count < frame->frame_count);
 
-    ASSERT(webcam->last_frame_count <= webcam_data->frame_count);
+    R_Texture* texture = Component_GetTexture(webcam->webcam_texture_id);
+    ASSERT(texture);
 
-    // check if has_frame
-    if (webcam_data->frame_count == webcam->last_frame_count) {
-        return;
+    // webcams sharing a device capture at the size of the first one created,
+    // match the texture to it
+    u32 width  = (u32)dev->width;
+    u32 height = (u32)dev->height;
+    if (texture->desc.width != width || texture->desc.height != height) {
+        texture->desc.width       = width;
+        texture->desc.height      = height;
+        texture->desc.resize_mode = SG_TextureResizeMode_Fixed;
+        R_Texture::resize(texture, width, height, gctx->device);
     }
+    if (frame->format == SG_WEBCAM_FORMAT_RGBA) {
+        SG_TextureWriteDesc write_desc = {};
+        write_desc.width               = width;
+        write_desc.height              = height;
+        R_Texture::write(gctx, texture, &write_desc, frame->data_OWNED,
+                         (size_t)width * height * 4);
+    } else {
+        bool created     = false;
+        YUVLayout layout = YUV_LAYOUT_YUYV;
+        if (frame->format == SG_WEBCAM_FORMAT_YUYV) {
+            created = R_WriteYUVPlane(gctx, &webcam->planes[0], WGPUTextureFormat_RGBA8Unorm,
+                                      (width + 1) / 2, height, 4, frame->data_OWNED,
+                                      "webcam YUYV plane");
+        } else {
+            layout  = YUV_LAYOUT_NV12;
+            created = R_WriteYUVPlane(gctx, &webcam->planes[0], WGPUTextureFormat_R8Unorm,
+                                      width, height, 1, frame->data_OWNED,
+                                      "webcam Y plane");
+            created |= R_WriteYUVPlane(gctx, &webcam->planes[1], WGPUTextureFormat_RG8Unorm,
+                                       (width + 1) / 2, (height + 1) / 2, 2,
+                                       frame->data_OWNED + (size_t)width * height,
+                                       "webcam CbCr plane");
+        }
 
-    // write to texture
-    SG_TextureWriteDesc write_desc = {};
-    write_desc.width               = texture->desc.width;
-    write_desc.height              = texture->desc.height;
-    R_Texture::write(gctx, texture, &write_desc, webcam_data->data, webcam_data->size);
+        // YUYV is a single packed plane
+        WGPUTexture chroma = (layout == YUV_LAYOUT_YUYV) ? webcam->planes[0] : webcam->planes[1];
+        if (created || layout != webcam->yuv_bind_group_layout
+            || webcam->yuv_bind_group_dst != texture->gpu_texture) {
+            WGPU_RELEASE_RESOURCE(BindGroup, webcam->yuv_bind_group);
+            webcam->yuv_bind_group = YUVToRGBA_createBindGroup(
+              gctx, webcam->planes[0], chroma, chroma, texture->gpu_texture);
+            webcam->yuv_bind_group_layout = layout;
+            webcam->yuv_bind_group_dst = texture->gpu_texture;
+        }
+        YUVToRGBA_convert(gctx, cmd_encoder, webcam->yuv_bind_group, layout, width,
+                          height);
+    }
 
-    // update frame count
-    webcam->last_frame_count = webcam_data->frame_count;
+    webcam->last_frame_count = frame->frame_count;
 }
 
 void R_Webcam::update(SG_Command_WebcamUpdate* cmd)
@@ -2361,45 +4484,13 @@ void R_Webcam::update(SG_Command_WebcamUpdate* cmd)
 
     webcam->freeze = cmd->freeze;
 
-    // update R_WebcamData
-    R_WebcamData* webcam_data = &_r_webcam_data[webcam->device_id];
-    spinlock::lock(&webcam_data->lock);
-    webcam_data->capture = cmd->capture;
-    spinlock::unlock(&webcam_data->lock);
-}
-
-// EXECUTED ON SEPARATE THREAD
-static void R_Webcam_Callback(sr_webcam_device* device, void* data)
-{
-    // static u64 last_time{ stm_now() };
-    // double time_sec = stm_sec(stm_laptime(&last_time));
-    // log_trace("%f sec since last webcam update; framerate: %f", time_sec,
-    //           1.0 / time_sec);
-
-    int device_id             = (intptr_t)(sr_webcam_get_user(device));
-    R_WebcamData* webcam_data = &_r_webcam_data[device_id];
-
-    // lock
-    spinlock::lock(&webcam_data->lock);
-    defer(spinlock::unlock(&webcam_data->lock));
-
-    // if capture disabled, early exit
-    if (!webcam_data->capture) return;
-
-    // copy data, scaling up size from rgb to rgba
-    int data_size     = sr_webcam_get_format_size(device);
-    webcam_data->size = data_size;
-    webcam_data->data = (u8*)data;
-
-    // bump frame count
-    webcam_data->frame_count++;
+    // capture and format are per device, shared by all webcams using it
+    webcam->device->capture.store(cmd->capture, std::memory_order_relaxed);
+    webcam->device->format.store(cmd->format, std::memory_order_relaxed);
 }
 
 R_Webcam* Component_CreateWebcam(SG_Command_WebcamCreate* cmd)
 {
-    // bounds check
-    ASSERT(cmd->device_id < ARRAY_LENGTH(_r_webcam_data));
-
     Arena* arena     = &webcamArena;
     R_Webcam* webcam = ARENA_PUSH_TYPE(arena, R_Webcam);
     *webcam          = {};
@@ -2418,49 +4509,177 @@ R_Webcam* Component_CreateWebcam(SG_Command_WebcamCreate* cmd)
         webcam->device_id         = cmd->device_id;
         webcam->webcam_texture_id = cmd->webcam_texture_id;
 
-        R_WebcamData* webcam_data = &_r_webcam_data[cmd->device_id];
-        spinlock::lock(&webcam_data->lock);
-        defer(spinlock::unlock(&webcam_data->lock));
-
         // support multiple ChuGL Webcams using the same device id
-        if (webcam_data->webcam == NULL) {
-            ASSERT(webcam_data->count == 0);
-            sr_webcam_set_user(cmd->device, (void*)(intptr_t)cmd->device_id);
-            sr_webcam_set_callback(cmd->device, R_Webcam_Callback);
+        R_WebcamDevice* dev = R_WebcamDevice_Get(cmd->device_id);
+        if (dev == NULL) {
+            dev = ALLOCATE_TYPE(R_WebcamDevice);
+            memset(dev, 0, sizeof(*dev));
+            dev->device_id = cmd->device_id;
+            dev->width     = cmd->width;
+            dev->height    = cmd->height;
+            dev->fps       = cmd->fps;
+            dev->capture.store(true, std::memory_order_relaxed);
+            for (u32 i = 0; i < ARRAY_LENGTH(dev->frames); i++) {
+                dev->frames[i].data_OWNED
+                  = ALLOCATE_BYTES(u8, (size_t)dev->width * dev->height * 4);
+            }
+            dev->back = 0;
+            dev->middle.store(1, std::memory_order_relaxed);
+            dev->front = 2;
+            *ARENA_PUSH_TYPE(&r_webcam_devices, R_WebcamDevice*) = dev;
+
+            if (cmd->device) {
+                sr_webcam_set_user(cmd->device, dev);
+                sr_webcam_set_callback(cmd->device, R_Webcam_Callback);
 
-            // Start. (already openned on audio thread in SG_CreateWebcam())
-            sr_webcam_start(cmd->device);
+                // Start. (already openned on audio thread in SG_CreateWebcam())
+                sr_webcam_start(cmd->device);
 
-            webcam_data->webcam = cmd->device;
+                dev->webcam = cmd->device;
+            } else {
+                ASSERT(cmd->device_id == SG_WEBCAM_DEVICE_SYNTHETIC);
+                dev->running.store(true, std::memory_order_relaxed);
+                dev->generator = new std::thread(R_WebcamDevice_Generate, dev);
+            }
         }
 
         // update webcam refcount
-        webcam_data->count++;
+        dev->count++;
+        webcam->device = dev;
     }
 
     return webcam;
 }
 
-// linear search by font path, lazily creates if not found
-R_Font* Component_GetFont(GraphicsContext* gctx, FT_Library library,
-                          const char* font_path)
+static void R_Font_uploadBuffers(GraphicsContext* gctx, R_Font* font);
+
+static void R_Font_loadJob(void* udata)
+{
+    R_Font* font      = (R_Font*)udata;
+    font->load_failed = !R_Font::load(font);
+}
+
+// render thread side of loading, once the load job is done
+static void R_Font_finishLoad(GraphicsContext* gctx, R_Font* font)
+{
+    ASSERT(font->loading && Jobs_Done(&font->load_job));
+    font->loading = false;
+    if (font->load_failed) {
+        log_error("failed to load font %s", font->font_path.c_str());
+        return;
+    }
+
+    R_Font_uploadBuffers(gctx, font);
+    font->ready = true;
+    if (!font_fallback) font_fallback = font;
+}
+
+R_Font* Component_GetFont(GraphicsContext* gctx, const char* font_path)
 {
     if (font_path == NULL || strlen(font_path) == 0) return NULL;
 
-    for (int i = 0; i < component_font_count; ++i) {
-        // this lookup won't work for loading fonts from memory
-        // actually it will if we give builtin fonts special names
-        if (component_fonts[i].font_path == font_path) {
-            return &component_fonts[i];
+    auto it = font_registry.find(font_path);
+    if (it != font_registry.end()) return it->second;
+
+    auto failed = font_failed_frame.find(font_path);
+    if (failed != font_failed_frame.end()) {
+        if (font_frame - failed->second <= R_FONT_EVICT_FRAMES) return NULL;
+        font_failed_frame.erase(failed);
+    }
+
+    static u32 font_id_counter = 0;
+
+    R_Font* font                   = new R_Font();
+    font->id                       = ++font_id_counter;
+    font->font_path                = font_path;
+    font->unused_since_frame       = font_frame;
+    font->loading                  = true;
+    font_registry[font->font_path] = font;
+
+    log_debug("Creating new R_Font with font path: %s", font_path);
+
+    // builtin fonts are decompressed from memory, no file io to hide
+    if (strncmp(font_path, "chugl:", 6) == 0) {
+        R_Font_loadJob(font);
+        R_Font_finishLoad(gctx, font);
+    } else {
+        Jobs_Submit(R_Font_loadJob, font, &font->load_job);
+    }
+
+    return font;
+}
+
+void Component_FontAcquire(R_Font* font)
+{
+    font->refcount++;
+    font_references++;
+}
+
+void Component_FontRelease(R_Font* font)
+{
+    ASSERT(font->refcount > 0);
+    font_references--;
+    if (--font->refcount == 0) font->unused_since_frame = font_frame;
+}
+
+void Component_UpdateFonts(GraphicsContext* gctx, R_Font* default_font)
+{
+    font_frame++;
+
+    for (auto it = font_registry.begin(); it != font_registry.end();) {
+        R_Font* font = it->second;
+
+        if (font->loading && Jobs_Done(&font->load_job)) {
+            R_Font_finishLoad(gctx, font);
+
+            // texts holding it keep laying out with a stand-in until they're
+            // rebuilt, which switches them to the default font
+            if (font->load_failed) {
+                font_failed_frame[font->font_path] = font_frame;
+                font_failed.push_back(font);
+                it = font_registry.erase(it);
+                continue;
+            }
+
+            // texts requesting this font were laid out with a stand-in
+            if (font->ready) {
+                R_Text* texts   = (R_Text*)textArena.base;
+                u64 text_count = ARENA_LENGTH(&textArena, R_Text);
+                for (u64 i = 0; i < text_count; i++) {
+                    if (texts[i].font == font)
+                        R_Text_rebuild(gctx, &texts[i], default_font);
+                }
+            }
+        }
+
+        bool evict = !font->loading && font->refcount == 0 && font != font_fallback
+                     && font_frame - font->unused_since_frame > R_FONT_EVICT_FRAMES;
+        if (evict) {
+            log_debug("evicting unused font %s", font->font_path.c_str());
+            R_Font::free(font);
+            delete font;
+            it = font_registry.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (size_t i = 0; i < font_failed.size();) {
+        R_Font* font = font_failed[i];
+        if (font->refcount > 0) {
+            i++;
+            continue;
         }
+        R_Font::free(font);
+        delete font;
+        font_failed[i] = font_failed.back();
+        font_failed.pop_back();
     }
 
-    R_Font* font = &component_fonts[component_font_count];
-    if (R_Font::init(gctx, library, font, font_path)) {
-        component_font_count++;
-        return font;
+    if (font_references != font_references_sent) {
+        CQ_PushCommand_G2A_FontStats(font_references);
+        font_references_sent = font_references;
     }
-    return NULL;
 }
 
 R_Component* Component_GetComponent(SG_ID id)
@@ -2513,6 +4732,42 @@ R_Geometry* Component_GetGeometry(SG_ID id)
     return (R_Geometry*)comp;
 }
 
+R_Geometry* Component_GetDrawGeometry(SG_ID id)
+{
+    R_Geometry* geo = Component_GetGeometry(id);
+    return (geo && geo->shared_id) ? Component_GetGeometry(geo->shared_id) : geo;
+}
+
+void R_Geometry::setShared(R_Geometry* geo, SG_ID shared_id)
+{
+    if (geo->shared_id == shared_id) return;
+    if (!geo->mesh_id_set || hashmap_count(geo->mesh_id_set) == 0) {
+        geo->shared_id = shared_id;
+        return;
+    }
+
+    // pull the meshes out of the batches of the old geometry...
+    static Arena meshes{};
+    defer(Arena::clear(&meshes));
+    size_t mesh_idx_DONT_USE = 0;
+    SG_ID* mesh_id           = NULL;
+    while (hashmap_iter(geo->mesh_id_set, &mesh_idx_DONT_USE, (void**)&mesh_id)) {
+        *ARENA_PUSH_TYPE(&meshes, R_Transform*) = Component_GetMesh(*mesh_id);
+    }
+    // unregistering edits mesh_id_set, so not while iterating it
+    for (u32 i = 0; i < ARENA_LENGTH(&meshes, R_Transform*); i++) {
+        R_Transform* xform = *ARENA_GET_TYPE(&meshes, R_Transform*, i);
+        R_Scene::unregisterMesh(Component_GetScene(xform->scene_id), xform);
+    }
+
+    // ...and into the new one's
+    geo->shared_id = shared_id;
+    for (u32 i = 0; i < ARENA_LENGTH(&meshes, R_Transform*); i++) {
+        R_Transform* xform = *ARENA_GET_TYPE(&meshes, R_Transform*, i);
+        R_Scene::registerMesh(Component_GetScene(xform->scene_id), xform);
+    }
+}
+
 R_Shader* Component_GetShader(SG_ID id)
 {
     R_Component* comp = Component_GetComponent(id);
@@ -2708,7 +4963,7 @@ void R_Shader::free(R_Shader* shader)
 // advances *text to point at the next code point. If the encoding is invalid, advances
 // *text by one byte and returns 0. *text should not be empty, because it will be
 // advanced past the null terminator.
-static u32 R_Font_decodeCharcode(char** text)
+u32 R_Font_decodeCharcode(char** text)
 {
     uint8_t first = static_cast<uint8_t>((*text)[0]);
 
@@ -2982,42 +5237,71 @@ static void R_Font_buildGlyph(R_Font* font, u32 charcode, FT_UInt glyphIndex)
     glyph.bearingX         = font->face->glyph->metrics.horiBearingX;
     glyph.bearingY         = font->face->glyph->metrics.horiBearingY;
     glyph.advance          = font->face->glyph->metrics.horiAdvance;
-    font->glyphs[charcode] = glyph;
+
+    BoundingBox bounds = {};
+    bounds.minX        = (float)(glyph.bearingX) / font->emSize;
+    bounds.minY        = (float)(glyph.bearingY - glyph.height) / font->emSize;
+    bounds.maxX        = (float)(glyph.bearingX + glyph.width) / font->emSize;
+    bounds.maxY        = (float)(glyph.bearingY) / font->emSize;
+    font->bufferGlyphBounds.push_back(bounds);
+
+    Glyph* stored = &(font->glyphs[charcode] = glyph);
+    if (charcode < ARRAY_LENGTH(font->asciiGlyphs)) font->asciiGlyphs[charcode] = stored;
 }
 
-// updates gpu buffers with new glyph/curve data
-static void R_Font_uploadBuffers(GraphicsContext* gctx, R_Font* font)
+Glyph* R_Font_getGlyph(R_Font* font, u32 charcode)
+{
+    if (charcode < ARRAY_LENGTH(font->asciiGlyphs) && font->asciiGlyphs[charcode])
+        return font->asciiGlyphs[charcode];
+
+    auto it = font->glyphs.find(charcode);
+    return (it == font->glyphs.end()) ? font->asciiGlyphs[0] : &it->second;
+}
+
+// appends bytes [gpu_buffer->size, size) of data. Growing goes through
+// GPU_Buffer::write, which doubles capacity, so appends are amortized O(1)
+static void R_Font_appendBuffer(GraphicsContext* gctx, GPU_Buffer* gpu_buffer,
+                                const void* data, u64 size)
 {
-    // could only write new data (can calculate offset from bufferGlyphs.size - gpu
-    // buffer curr size)
-    // check limits->minStorageBufferOffsetAlignment first
-    // but not needed as these are small buffers relative to PCIe bandwidth
+    ASSERT(size >= gpu_buffer->size);
+    if (gpu_buffer->buf && size == gpu_buffer->size) return;
 
-    // make sure we only rewrite on getting new glyph data
-    ASSERT(sizeof(BufferGlyph) * font->bufferGlyphs.size() > font->glyph_buffer.size);
-    ASSERT(sizeof(BufferCurve) * font->bufferCurves.size() > font->curve_buffer.size);
+    if (gpu_buffer->buf == NULL || size > gpu_buffer->capacity) {
+        GPU_Buffer::write(gctx, gpu_buffer, WGPUBufferUsage_Storage, data, size);
+    } else {
+        u64 offset = gpu_buffer->size;
+        GPU_Buffer::write(gctx, gpu_buffer, WGPUBufferUsage_Storage, offset,
+                          (const char*)data + offset, size - offset);
+    }
+}
 
-    GPU_Buffer::write(gctx, &font->glyph_buffer, WGPUBufferUsage_Storage,
-                      font->bufferGlyphs.data(),
-                      sizeof(BufferGlyph) * font->bufferGlyphs.size());
-    GPU_Buffer::write(gctx, &font->curve_buffer, WGPUBufferUsage_Storage,
-                      font->bufferCurves.data(),
-                      sizeof(BufferCurve) * font->bufferCurves.size());
+// uploads glyph/curve/bounds data built since the last upload
+static void R_Font_uploadBuffers(GraphicsContext* gctx, R_Font* font)
+{
+    R_Font_appendBuffer(gctx, &font->glyph_buffer, font->bufferGlyphs.data(),
+                        sizeof(BufferGlyph) * font->bufferGlyphs.size());
+    R_Font_appendBuffer(gctx, &font->curve_buffer, font->bufferCurves.data(),
+                        sizeof(BufferCurve) * font->bufferCurves.size());
+    R_Font_appendBuffer(gctx, &font->bounds_buffer, font->bufferGlyphBounds.data(),
+                        sizeof(BoundingBox) * font->bufferGlyphBounds.size());
 }
 
 // impl in imgui_draw.cpp
 unsigned char* imgui_decompressBase85TTF(const char* compressed_ttf_data_base85,
                                          int* out_size);
 
-bool R_Font::init(GraphicsContext* gctx, FT_Library library, R_Font* font,
-                  const char* font_path)
+bool R_Font::load(R_Font* font)
 {
     ASSERT(font->face == NULL);
-    *font           = {}; // init defaults
-    font->font_path = std::string(font_path);
     ASSERT(font->worldSize > 0.0f);
+    const char* font_path = font->font_path.c_str();
 
-    log_debug("Creating new R_Font with font path: %s", font_path);
+    // FT_Library is not thread-safe, each font parses with its own
+    if (FT_Init_FreeType(&font->library)) {
+        log_error("error while initializing FreeType for font %s", font_path);
+        return false;
+    }
+    FT_Library library = font->library;
 
     // DEFAULT FONTS
     // if font path starts with chugl:
@@ -3091,36 +5375,21 @@ bool R_Font::init(GraphicsContext* gctx, FT_Library library, R_Font* font,
         R_Font_buildGlyph(font, charcode, glyphIndex);
     }
 
-    R_Font_uploadBuffers(gctx, font);
-    font->font_path = std::string(font_path);
     return true;
 }
 
-static bool R_Font_isWhiteSpace(char c)
-{
-    switch (c) {
-        case ' ':
-        case '\t': return true;
-        default: return false;
-    }
-}
-
 void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
 {
-    R_Font_isWhiteSpace(0); // to compile in RELEASE
+    // layout built this update. Swapped with the text's cached layout at the end
+    static Arena paragraphs;
+    static Arena lines;
+    static Arena glyphs;
 
-    static Arena positions;
-    static Arena uvs;
-    static Arena glyph_indices;
-    static Arena indices;
-    static Arena line_offsets;
+    static Arena instances;
 
-    // clear the buffers
-    Arena::clear(&positions);
-    Arena::clear(&uvs);
-    Arena::clear(&glyph_indices);
-    Arena::clear(&indices);
-    Arena::clear(&line_offsets);
+    Arena::clear(&paragraphs);
+    Arena::clear(&lines);
+    Arena::clear(&glyphs);
 
     // generate new glyps for this font
     R_Font::prepareGlyphsForText(gctx, font, text->text.c_str());
@@ -3129,159 +5398,94 @@ void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
     R_Material* mat = Component_GetMaterial(text->_matID);
     R_Material::setExternalStorageBinding(gctx, mat, 0, &font->glyph_buffer);
     R_Material::setExternalStorageBinding(gctx, mat, 1, &font->curve_buffer);
+    R_Material::setExternalStorageBinding(gctx, mat, 9, &font->bounds_buffer);
+
+    // cached lines are only valid for the font/size/width they were wrapped with
+    if (text->layout_font_id != font->id || text->layout_size != text->size
+        || text->layout_width != text->width) {
+        Arena::clear(&text->layout_paragraphs);
+        Arena::clear(&text->layout_lines);
+        Arena::clear(&text->layout_glyphs);
+    }
 
-    // get whitespace glyphs
-    auto space_glyph_it = font->glyphs.find(' ');
-    Glyph& space_glyph  = (space_glyph_it == font->glyphs.end()) ?
-                            font->glyphs[0] :
-                            space_glyph_it->second;
-    auto tab_glyph_it   = font->glyphs.find('\t');
-    Glyph& tab_glyph
-      = (tab_glyph_it == font->glyphs.end()) ? font->glyphs[0] : tab_glyph_it->second;
-
-    // compute line offsets for alignment
-    bool align_text = (text->width > 0);
-    if (align_text) {
-        FT_UInt previous = 0;
-        char* text_start = (char*)text->text.c_str();
-        char* text_it    = text_start;
-
-        float line_width               = 0;
-        char* last_whitespace          = NULL;
-        float width_at_last_whitespace = 0;
-        while (*text_it) {
-            // calculate width of next charcode
-            u32 charcode = R_Font_decodeCharcode(&text_it);
-
-            if (charcode == '\r') continue;
-            if (charcode == '\n') {
-                if (line_width > text->width && last_whitespace) {
-                    ASSERT(R_Font_isWhiteSpace(*last_whitespace));
-                    char replaced_char = text->text[last_whitespace - text_start];
-                    text->text[last_whitespace - text_start] = '\n';
-                    *ARENA_PUSH_TYPE(&line_offsets, float)
-                      = text->width - width_at_last_whitespace;
-
-                    // update new linewidth after adding line break
-                    // alignment_repeat_1
-                    switch (replaced_char) {
-                        case ' ': {
-                            line_width -= ((float)space_glyph.advance / font->emSize)
-                                          * text->size;
-                        } break;
-                        case '\t': {
-                            line_width
-                              -= ((float)tab_glyph.advance / font->emSize) * text->size;
-                        } break;
-                        default: ASSERT(false);
-                    }
-
-                    *ARENA_PUSH_TYPE(&line_offsets, float)
-                      = text->width - (line_width - width_at_last_whitespace);
-                } else {
-                    *ARENA_PUSH_TYPE(&line_offsets, float) = text->width - line_width;
-                }
-                line_width               = 0;
-                last_whitespace          = NULL;
-                width_at_last_whitespace = 0;
-                continue;
+    // split into paragraphs, reusing cached layout for unchanged ones
+    u32 cached_count = ARENA_LENGTH(&text->layout_paragraphs, R_TextParagraph);
+    u32 reused_count = 0;
+    bool in_place    = true; // every paragraph matched the cache at the same index
+    {
+        const char* text_begin = text->text.c_str();
+        const char* text_end   = text_begin + text->text.length();
+        const char* para_begin = text_begin;
+        while (true) {
+            const char* para_end = (const char*)memchr(
+              para_begin, '\n', text_end - para_begin);
+            if (!para_end) para_end = text_end;
+
+            u32 para_idx = ARENA_LENGTH(&paragraphs, R_TextParagraph);
+            R_TextParagraph* para
+              = ARENA_PUSH_ZERO_TYPE(&paragraphs, R_TextParagraph);
+            para->byte_count  = (u32)(para_end - para_begin);
+            para->hash        = hashmap_xxhash3(para_begin, para->byte_count, 0, 0);
+            para->line_offset = ARENA_LENGTH(&lines, R_TextLine);
+            R_TextParagraph* cached = NULL;
+
+            // common case is editing in place, so try the same index first
+            if (para_idx < cached_count) {
+                R_TextParagraph* p
+                  = ARENA_GET_TYPE(&text->layout_paragraphs, R_TextParagraph, para_idx);
+                if (p->hash == para->hash && p->byte_count == para->byte_count)
+                    cached = p;
             }
-
-            // line break if too long
-            bool is_whitespace = (charcode == ' ' || charcode == '\t');
-            if (is_whitespace) {
-                if (line_width > text->width) {
-                    if (last_whitespace) {
-                        ASSERT(R_Font_isWhiteSpace(*last_whitespace));
-
-                        char replaced_char = text->text[last_whitespace - text_start];
-                        text->text[last_whitespace - text_start] = '\n';
-                        *ARENA_PUSH_TYPE(&line_offsets, float)
-                          = text->width - width_at_last_whitespace;
-
-                        // update new linewidth after adding line break
-                        // alignment_repeat_2
-                        line_width -= width_at_last_whitespace;
-                        switch (replaced_char) {
-                            case ' ': {
-                                line_width -= ((float)space_glyph.advance / font->emSize
-                                               * text->size);
-                            } break;
-                            case '\t': {
-                                line_width -= ((float)tab_glyph.advance / font->emSize
-                                               * text->size);
-                            } break;
-                            default: ASSERT(false);
-                        }
-
-                        last_whitespace          = text_it - 1;
-                        width_at_last_whitespace = line_width;
-                    } else {
-                        ASSERT(
-                          R_Font_isWhiteSpace(text->text[text_it - text_start - 1]));
-                        text->text[text_it - text_start - 1] = '\n';
-                        *ARENA_PUSH_TYPE(&line_offsets, float)
-                          = text->width - line_width;
-
-                        line_width               = 0;
-                        last_whitespace          = NULL;
-                        width_at_last_whitespace = 0;
+            if (!cached) {
+                in_place = false;
+                for (u32 i = 0; i < cached_count; i++) {
+                    R_TextParagraph* p
+                      = ARENA_GET_TYPE(&text->layout_paragraphs, R_TextParagraph, i);
+                    if (p->hash == para->hash && p->byte_count == para->byte_count) {
+                        cached = p;
+                        break;
                     }
-                } else {
-                    last_whitespace = text_it - 1;
-                    ASSERT(R_Font_isWhiteSpace(*last_whitespace));
-                    width_at_last_whitespace = line_width;
                 }
             }
 
-            // get glyph
-            auto glyphIt = font->glyphs.find(charcode);
-            Glyph& glyph
-              = (glyphIt == font->glyphs.end()) ? font->glyphs[0] : glyphIt->second;
-
-            if (previous != 0 && glyph.index != 0) {
-                FT_Vector kerning;
-                FT_Error error = FT_Get_Kerning(font->face, previous, glyph.index,
-                                                font->kerningMode, &kerning);
-                if (!error) {
-                    line_width += (float)kerning.x / font->emSize * text->size;
-                }
-            }
-            line_width += (float)glyph.advance / font->emSize * text->size;
-            previous = glyph.index;
-        }
-
-        // final line
-        if (line_width > text->width && last_whitespace) {
-            ASSERT(R_Font_isWhiteSpace(*last_whitespace));
-            char replaced_char = text->text[last_whitespace - text_start];
-            text->text[last_whitespace - text_start] = '\n';
-            *ARENA_PUSH_TYPE(&line_offsets, float)
-              = text->width - width_at_last_whitespace;
-
-            // update new linewidth after adding line break
-            // alignment_repeat_3
-            switch (replaced_char) {
-                case ' ': {
-                    line_width
-                      -= ((float)space_glyph.advance / font->emSize) * text->size;
-                } break;
-                case '\t': {
-                    line_width
-                      -= ((float)tab_glyph.advance / font->emSize) * text->size;
-                } break;
-                default: ASSERT(false);
+            if (cached) {
+                TextLayout_CopyLines(ARENA_GET_TYPE(&text->layout_lines, R_TextLine,
+                                                    cached->line_offset),
+                                     cached->line_count, &text->layout_glyphs, &lines,
+                                     &glyphs);
+                reused_count++;
+            } else {
+                TextLayout_Paragraph(font, text->size, text->width, para_begin,
+                                     para_end, para->hash, &lines, &glyphs);
             }
+            para->line_count = ARENA_LENGTH(&lines, R_TextLine) - para->line_offset;
 
-            *ARENA_PUSH_TYPE(&line_offsets, float)
-              = text->width - (line_width - width_at_last_whitespace);
-        } else {
-            *ARENA_PUSH_TYPE(&line_offsets, float) = text->width - line_width;
+            if (para_end == text_end) break;
+            para_begin = para_end + 1;
         }
     }
 
-    int line_offset_count = ARENA_LENGTH(&line_offsets, float);
-    int line_offset_idx   = 0;
+    u32 paragraph_count = ARENA_LENGTH(&paragraphs, R_TextParagraph);
+    bool unchanged = in_place && reused_count == paragraph_count
+                     && paragraph_count == cached_count
+                     && text->layout_font_id == font->id
+                     && text->layout_vertical_spacing == text->vertical_spacing
+                     && text->layout_alignment == text->alignment;
+
+    // keep this layout as the cache for the next update
+    std::swap(text->layout_paragraphs, paragraphs);
+    std::swap(text->layout_lines, lines);
+    std::swap(text->layout_glyphs, glyphs);
+    text->layout_font_id          = font->id;
+    text->layout_size             = text->size;
+    text->layout_width            = text->width;
+    text->layout_vertical_spacing = text->vertical_spacing;
+    text->layout_alignment        = text->alignment;
+
+    // same glyphs in the same place, instances and bb are still valid
+    if (unchanged) return;
+
+    Arena::clear(&instances);
 
     // compute new bounding box
     BoundingBox bb = {};
@@ -3289,66 +5493,38 @@ void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
     bb.minY        = +std::numeric_limits<float>::infinity();
     bb.maxX        = -std::numeric_limits<float>::infinity();
     bb.maxY        = -std::numeric_limits<float>::infinity();
-    {
-        float x = 0;
+
+    // place glyph instances, quads are expanded in the vertex shader
+    bool align_text    = (text->width > 0);
+    float line_height  = text->vertical_spacing * (float)font->face->height
+                        / (float)font->face->units_per_EM * text->size;
+    u32 line_count     = ARENA_LENGTH(&text->layout_lines, R_TextLine);
+    R_TextLine* text_lines = (R_TextLine*)text->layout_lines.base;
+    for (u32 l = 0; l < line_count; l++) {
+        float line_x = 0;
+        float line_y = -line_height * l;
         if (align_text) {
-            float offset = *ARENA_GET_TYPE(&line_offsets, float, line_offset_idx);
+            float offset = text->width - text_lines[l].width;
             switch (text->alignment) {
                 case SG_Text_AlignmentType_Left: break;
-                case SG_Text_AlignmentType_Center: x = offset / 2.0f; break;
-                case SG_Text_AlignmentType_Right: x = offset; break;
+                case SG_Text_AlignmentType_Center: line_x = offset / 2.0f; break;
+                case SG_Text_AlignmentType_Right: line_x = offset; break;
                 default: UNREACHABLE;
             }
-            line_offset_idx++;
-        }
-        float y          = 0;
-        FT_UInt previous = 0;
-        char* textIt     = (char*)text->text.c_str();
-        while (*textIt != '\0') {
-            uint32_t charcode = R_Font_decodeCharcode(&textIt);
-
-            if (charcode == '\r') continue;
-            if (charcode == '\n') {
-                x = 0;
-                if (align_text) {
-                    float offset
-                      = *ARENA_GET_TYPE(&line_offsets, float, line_offset_idx);
-                    switch (text->alignment) {
-                        case SG_Text_AlignmentType_Left: break;
-                        case SG_Text_AlignmentType_Center: x = offset / 2.0f; break;
-                        case SG_Text_AlignmentType_Right: x = offset; break;
-                        default: UNREACHABLE;
-                    }
-                    line_offset_idx++;
-                }
-                y -= text->vertical_spacing * (float)font->face->height
-                     / (float)font->face->units_per_EM * text->size;
-                continue;
-            }
-
-            auto glyphIt = font->glyphs.find(charcode);
-            Glyph& glyph
-              = (glyphIt == font->glyphs.end()) ? font->glyphs[0] : glyphIt->second;
-
-            if (previous != 0 && glyph.index != 0) {
-                FT_Vector kerning;
-                FT_Error error = FT_Get_Kerning(font->face, previous, glyph.index,
-                                                font->kerningMode, &kerning);
-                if (!error) {
-                    x += (float)kerning.x / font->emSize * text->size;
-                }
-            }
+        }
 
+        R_TextGlyph* line_glyphs = ARENA_GET_TYPE(&text->layout_glyphs, R_TextGlyph,
+                                                  text_lines[l].glyph_offset);
+        for (u32 g = 0; g < text_lines[l].glyph_count; g++) {
+            i32 buffer_index = line_glyphs[g].buffer_index;
             // Note: Do not apply dilation here, we want to calculate exact bounds.
-            float u0 = (float)(glyph.bearingX) / font->emSize;
-            float v0 = (float)(glyph.bearingY - glyph.height) / font->emSize;
-            float u1 = (float)(glyph.bearingX + glyph.width) / font->emSize;
-            float v1 = (float)(glyph.bearingY) / font->emSize;
+            BoundingBox uv = font->bufferGlyphBounds[buffer_index];
 
-            float x0 = x + u0 * text->size;
-            float y0 = y + v0 * text->size;
-            float x1 = x + u1 * text->size;
-            float y1 = y + v1 * text->size;
+            float x  = line_x + line_glyphs[g].x;
+            float x0 = x + uv.minX * text->size;
+            float y0 = line_y + uv.minY * text->size;
+            float x1 = x + uv.maxX * text->size;
+            float y1 = line_y + uv.maxY * text->size;
 
             // update bb
             if (x0 < bb.minX) bb.minX = x0;
@@ -3356,51 +5532,31 @@ void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
             if (x1 > bb.maxX) bb.maxX = x1;
             if (y1 > bb.maxY) bb.maxY = y1;
 
-            if (glyph.curveCount) {
-                u32 base = ARENA_LENGTH(&positions, glm::vec2);
-                *ARENA_PUSH_TYPE(&positions, glm::vec2) = glm::vec2(x0, y0);
-                *ARENA_PUSH_TYPE(&positions, glm::vec2) = glm::vec2(x1, y0);
-                *ARENA_PUSH_TYPE(&positions, glm::vec2) = glm::vec2(x1, y1);
-                *ARENA_PUSH_TYPE(&positions, glm::vec2) = glm::vec2(x0, y1);
-
-                *ARENA_PUSH_TYPE(&uvs, glm::vec2) = glm::vec2(u0, v0);
-                *ARENA_PUSH_TYPE(&uvs, glm::vec2) = glm::vec2(u1, v0);
-                *ARENA_PUSH_TYPE(&uvs, glm::vec2) = glm::vec2(u1, v1);
-                *ARENA_PUSH_TYPE(&uvs, glm::vec2) = glm::vec2(u0, v1);
-
-                *ARENA_PUSH_TYPE(&glyph_indices, u32) = glyph.bufferIndex;
-                *ARENA_PUSH_TYPE(&glyph_indices, u32) = glyph.bufferIndex;
-                *ARENA_PUSH_TYPE(&glyph_indices, u32) = glyph.bufferIndex;
-                *ARENA_PUSH_TYPE(&glyph_indices, u32) = glyph.bufferIndex;
-
-                *ARENA_PUSH_TYPE(&indices, u32) = base;
-                *ARENA_PUSH_TYPE(&indices, u32) = base + 1;
-                *ARENA_PUSH_TYPE(&indices, u32) = base + 2;
-                *ARENA_PUSH_TYPE(&indices, u32) = base + 2;
-                *ARENA_PUSH_TYPE(&indices, u32) = base + 3;
-                *ARENA_PUSH_TYPE(&indices, u32) = base;
-            }
+            if (font->bufferGlyphs[buffer_index].count == 0) continue;
 
-            x += (float)glyph.advance / font->emSize * text->size;
-            previous = glyph.index;
+            R_TextGlyphInstance* instance
+              = ARENA_PUSH_ZERO_TYPE(&instances, R_TextGlyphInstance);
+            instance->offset       = glm::vec2(x, line_y);
+            instance->buffer_index = buffer_index;
         }
     }
-    ASSERT(line_offset_idx == line_offset_count);
 
-    // write buffer data to geometry
+    // write instances to geometry. Always upload at least one so the storage
+    // binding is never empty, the vertex count is what limits the draw
+    u32 instance_count = ARENA_LENGTH(&instances, R_TextGlyphInstance);
+    if (instance_count == 0) ARENA_PUSH_ZERO_TYPE(&instances, R_TextGlyphInstance);
     R_Geometry* geo = Component_GetGeometry(text->_geoID);
-    R_Geometry::setVertexAttribute(gctx, geo, 0, 2, positions.base, positions.curr);
-    R_Geometry::setVertexAttribute(gctx, geo, 1, 2, uvs.base, uvs.curr);
-    R_Geometry::setVertexAttribute(gctx, geo, 2, 1, glyph_indices.base,
-                                   glyph_indices.curr);
-    R_Geometry::setIndices(gctx, geo, (u32*)indices.base, ARENA_LENGTH(&indices, u32));
+    R_Geometry::setPulledVertexAttribute(gctx, geo, 0, instances.base, instances.curr);
+    geo->vertex_count = instance_count * 6;
 
     // set internal uniforms
     // recompute bb adjusted by control points
     R_Material::setUniformBinding(gctx, mat, 5, &bb, sizeof(bb));
+    R_Material::setUniformBinding(gctx, mat, 10, &text->size, sizeof(text->size));
+    text->layout_bounds = bb;
 
     // leq because whitespaces are skipped
-    ASSERT(ARENA_LENGTH(&indices, u32) <= text->text.length() * 6);
+    ASSERT(instance_count <= text->text.length());
 }
 
 // build new glyphs if text has unseen characters
@@ -3413,6 +5569,8 @@ void R_Font::prepareGlyphsForText(GraphicsContext* gctx, R_Font* font, const cha
         uint32_t charcode = R_Font_decodeCharcode(&textIt);
 
         if (charcode == '\r' || charcode == '\n') continue;
+        if (charcode < ARRAY_LENGTH(font->asciiGlyphs) && font->asciiGlyphs[charcode])
+            continue;
         if (font->glyphs.count(charcode) != 0) continue; // if already exists, move on
 
         FT_UInt glyphIndex = FT_Get_Char_Index(font->face, charcode);
@@ -3429,23 +5587,18 @@ void R_Font::prepareGlyphsForText(GraphicsContext* gctx, R_Font* font, const cha
         changed = true;
     }
 
-    if (changed) {
-        // Reupload the full buffer contents. To make this even more
-        // dynamic, the buffers could be overallocated and only the added
-        // data could be uploaded.
-        // not necessary, glyph+curve buffers are only ~200kb for ASCII chars
-        // 3080 PCI has 32GB/s bandwidth, these buffers are nothing
-        R_Font_uploadBuffers(gctx, font);
-    }
+    // only the newly built glyphs/curves are uploaded
+    if (changed) R_Font_uploadBuffers(gctx, font);
 }
 
-void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
+void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer,
+                         WGPUBuffer light_cluster_buffer, GraphicsContext* gctx,
                          G_DrawCall* d, G_Graph* graph, R_Shader* shader,
-                         R_Scene* scene, bool is_shadow_pass)
+                         R_Scene* scene, bool is_shadow_pass, u32 frame_uniform_offset)
 {
     // group(0) must be bound if group(1) is (no holes in bindgroups allowed)
     // so for now we always bind the per-frame uniforms
-    graph->bindBuffer(d, PER_FRAME_GROUP, 0, frame_uniform_buffer, 0,
+    graph->bindBuffer(d, PER_FRAME_GROUP, 0, frame_uniform_buffer, frame_uniform_offset,
                       sizeof(FrameUniforms));
 
     if (scene) {
@@ -3481,6 +5634,23 @@ void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
               d, PER_FRAME_GROUP, 5,
               { dir_shadow_map_array, WGPUTextureViewDimension_2DArray, 0, 1, 0,
                 (int)wgpuTextureGetDepthOrArrayLayers(dir_shadow_map_array) });
+
+            WGPUTexture point_shadow_map_array
+              = is_shadow_pass ? gctx->sentinel_pointlight_depth_2d_array :
+                                 scene->point_shadow_map_array;
+            graph->bindTexture(
+              d, PER_FRAME_GROUP, 8,
+              { point_shadow_map_array, WGPUTextureViewDimension_2DArray, 0, 1, 0,
+                (int)wgpuTextureGetDepthOrArrayLayers(point_shadow_map_array) });
+        }
+
+        if (shader->includes.clustered) {
+            // shadow passes zero num_lights, so the sentinel is never read
+            WGPUBuffer clusters = (is_shadow_pass || !light_cluster_buffer) ?
+                                    gctx->sentinel_light_cluster_buffer :
+                                    light_cluster_buffer;
+            graph->bindBuffer(d, PER_FRAME_GROUP, 6, clusters, 0,
+                              wgpuBufferGetSize(clusters));
         }
     }
 }
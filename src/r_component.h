@@ -33,6 +33,7 @@
 #include "sg_component.h"
 
 #include "core/macros.h"
+#include "core/jobs.h"
 #include "core/memory.h"
 
 #include <glm/glm.hpp>
@@ -118,6 +119,12 @@ struct R_Transform : public R_Component {
     SG_ID _matID;
     b32 receives_shadows;
 
+    u32 world_version; // bumped every time the world matrix is rebuilt
+
+    // shadow caster tracking, see R_Scene::rebuildLightInfoBuffer()
+    u64 shadow_caster_key;      // world, geometry + material version last seen
+    u64 shadow_caster_moved_fc; // frame count when shadow_caster_key last changed
+
     SG_ID scene_id; // the scene this transform belongs to
 
     static void init(R_Transform* transform);
@@ -192,13 +199,46 @@ struct R_Geometry : public R_Component {
     int vertex_count  = -1; // if set, overrides vertex count from vertices
     int indices_count = -1; // if set, overrides index count from indices
 
+    // unique edges as a line list, rebuilt only when the topology changes (indices,
+    // or the vertex count of non-indexed geometry), not when vertex data does
     b32 gpu_wireframe_index_buffer_stale;
     GPU_Buffer gpu_wireframe_index_buffer;
+    u32* wireframe_tri_edge_end_MALLOC; // edges used by triangles 0..i
+    u32 wireframe_tri_count;
+
+    u32 version; // bumped when vertex data or draw counts change, for shadow caching
+
+    // bounds of the position attribute, xyz center and w radius. w < 0 if unknown
+    // (e.g. positions are pulled), then instances are never culled
+    glm::vec4 bounding_sphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+
+    // LOD chain. levels past 0 are simplified on the Jobs pool and appended after
+    // level 0 in gpu_index_buffer, sharing the vertex buffers
+    int lod_levels = 1; // requested level count, 1 means LODs are off
+    f32 lod_thresholds[CHUGL_GEOMETRY_MAX_LODS - 1]; // screen size each level starts
+    int lod_force = -1; // if >= 0, always draw this level
+    int lod_count;      // levels in gpu_index_buffer, 0 until the chain is uploaded
+    u32 lod_index_offset[CHUGL_GEOMETRY_MAX_LODS]; // in indices
+    u32 lod_index_count[CHUGL_GEOMETRY_MAX_LODS];
+    f32* positions_MALLOC; // xyz copy of the positions, simplification input
+    u32 positions_count;
+    b32 lod_stale;         // chain needs to be regenerated by flushLODJobs()
+    struct R_GeometryLODJob* pending_lod;
+
+    // identical built-in geometries draw with one hidden geometry's buffers, so
+    // their meshes batch together. 0 if this geometry draws with its own
+    SG_ID shared_id;
+    // SG_IDs of the meshes using this geometry that are registered in a scene.
+    // NULL until the first one is
+    hashmap* mesh_id_set;
 
     static void init(R_Geometry* geo);
 
     static u32 indexCount(R_Geometry* geo);
     static u32 vertexCount(R_Geometry* geo);
+    // vertices a non-indexed draw covers. vertex_count if set, else every vertex,
+    // cut short by indices_count if set (e.g. GText.characters() on glyph quads)
+    static u32 drawVertexCount(R_Geometry* geo);
     static u32 vertexAttributeCount(R_Geometry* geo);
 
     static void setVertexAttribute(GraphicsContext* gctx, R_Geometry* geo, u32 location,
@@ -217,8 +257,26 @@ struct R_Geometry : public R_Component {
     static void setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
                            u32 indices_count);
 
-    static u32 wireframeIndicesCount(R_Geometry* geo);
+    // wireframe indices drawing the edges of the first tri_count triangles
+    static u32 wireframeIndicesCount(R_Geometry* geo, u32 tri_count = UINT32_MAX);
     static void rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx);
+
+    // levels <= 1 drops the chain. thresholds has CHUGL_GEOMETRY_MAX_LODS - 1
+    // entries, force < 0 selects levels by screen size
+    static void setLOD(R_Geometry* geo, int levels, f32* thresholds, int force);
+
+    // true if draws of geo with material can use the LOD index ranges
+    static bool usesLOD(R_Geometry* geo, R_Material* material);
+
+    // screen_size is the fraction of the viewport height covered by an instance
+    static int selectLOD(R_Geometry* geo, f32 screen_size);
+
+    // submits simplification jobs for geometries whose LOD chain went stale and
+    // uploads chains finished since the last call. Called once per frame
+    static void flushLODJobs(GraphicsContext* gctx);
+
+    // moves meshes of geo to the batches of the geometry they now draw with
+    static void setShared(R_Geometry* geo, SG_ID shared_id);
 };
 
 // =============================================================================
@@ -229,6 +287,10 @@ struct R_Texture : public R_Component {
     WGPUTexture gpu_texture;
     SG_TextureDesc desc; // TODO redundant with R_Texture.gpu_texture
 
+    // most recent async load, NULL once uploaded. Older jobs for the same
+    // texture are dropped when they complete
+    struct R_TextureLoadJob* pending_load;
+
     static int sizeBytes(R_Texture* texture);
 
     // validates that the WGPUTexture matches the sg_texturedesc
@@ -237,13 +299,10 @@ struct R_Texture : public R_Component {
         ASSERT(wgpuTextureGetFormat(t->gpu_texture) == t->desc.format);
         ASSERT(wgpuTextureGetDimension(t->gpu_texture) == t->desc.dimension);
         ASSERT(wgpuTextureGetDepthOrArrayLayers(t->gpu_texture) == t->desc.depth);
-        if (t->desc.gen_mips) {
-            ASSERT(wgpuTextureGetMipLevelCount(t->gpu_texture)
-                   == G_mipLevels(wgpuTextureGetWidth(t->gpu_texture),
-                                  wgpuTextureGetHeight(t->gpu_texture)));
-        } else {
-            ASSERT(wgpuTextureGetMipLevelCount(t->gpu_texture) == 1);
-        }
+        ASSERT(wgpuTextureGetMipLevelCount(t->gpu_texture)
+               == SG_TextureDesc::mipLevelCount(&t->desc,
+                                                wgpuTextureGetWidth(t->gpu_texture),
+                                                wgpuTextureGetHeight(t->gpu_texture)));
         ASSERT(wgpuTextureGetUsage(t->gpu_texture) == t->desc.usage);
 
         if (t->desc.resize_mode == SG_TextureResizeMode_Fixed) {
@@ -298,7 +357,7 @@ struct R_Texture : public R_Component {
             wgpu_texture_desc.format                = r_tex->desc.format;
             wgpu_texture_desc.sampleCount           = 1;
             wgpu_texture_desc.mipLevelCount
-              = r_tex->desc.gen_mips ? G_mipLevels(width, height) : 1;
+              = SG_TextureDesc::mipLevelCount(&r_tex->desc, width, height);
 
             WGPU_RELEASE_RESOURCE(Texture, r_tex->gpu_texture);
             r_tex->gpu_texture = wgpuDeviceCreateTexture(device, &wgpu_texture_desc);
@@ -365,6 +424,35 @@ struct R_Texture : public R_Component {
                             const char* back_face_path, const char* front_face_path,
                             bool flip_y);
 
+    // async variants of the above. Images are decoded on the Jobs pool and
+    // uploaded by flushAsyncLoads(), the texture is cleared to a placeholder
+    // color in the meantime.
+    // KTX2/DDS files, and images transcoded when `compress` is set, replace the
+    // WGPUTexture with one in the image's (compressed) format and mip chain
+    static void loadAsync(GraphicsContext* gctx, R_Texture* texture,
+                          const char* filepath, bool flip_vertically, bool gen_mips,
+                          bool compress = false);
+
+    static void loadAsync(GraphicsContext* gctx, R_Texture* texture, u8* buffer,
+                          int buffer_len, bool flip_vertically, bool gen_mips,
+                          bool compress = false);
+
+    static void loadCubemapAsync(GraphicsContext* gctx, R_Texture* texture,
+                                 const char* right_face_path,
+                                 const char* left_face_path, const char* top_face_path,
+                                 const char* bottom_face_path,
+                                 const char* back_face_path,
+                                 const char* front_face_path, bool flip_y);
+
+    // blocks until the texture's pending async load (if any) is decoded, then
+    // uploads it. Called before commands that read or overwrite texture contents
+    // so they see the same order as the chuck code that issued them
+    static void finishAsyncLoad(GraphicsContext* gctx, R_Texture* texture);
+
+    // uploads every image decoded since the last call, mip generation for all of
+    // them is batched into a single submit. Called once per frame.
+    static void flushAsyncLoads(GraphicsContext* gctx);
+
     // creates and returns the mapped GPU buffer for holding the readback texture data
     static WGPUBuffer read(GraphicsContext* gctx, R_Texture* tex)
     {
@@ -488,6 +576,7 @@ struct MaterialTextureView {
 
 struct R_Material : public R_Component {
     SG_MaterialPipelineState pso;
+    u32 version; // bumped when the pso or a binding changes, for shadow caching
     // bindgroup state (uniforms, storage buffers, textures, samplers)
     R_Binding bindings[CHUGL_MATERIAL_MAX_BINDINGS];
     WGPUBuffer uniform_buffer;
@@ -523,6 +612,18 @@ struct R_Material : public R_Component {
     }
 };
 
+// =============================================================================
+// R_Frustum
+// =============================================================================
+
+// world space view frustum, planes point inwards as (normal, distance)
+struct R_Frustum {
+    glm::vec4 planes[6];
+
+    static R_Frustum fromProjectionView(const glm::mat4& proj_view);
+    static bool intersectsSphere(R_Frustum* frustum, glm::vec3 center, f32 radius);
+};
+
 // =============================================================================
 // R_Camera
 // =============================================================================
@@ -558,10 +659,39 @@ struct R_Light : public R_Transform {
 
     hashmap* shadow_render_id_set;   // set of all Mesh SGIDs that cast a shadow
     WGPUBuffer draw_storage_buffer;  // @group(2) draw params
-    WGPUBuffer frame_uniform_buffer; // @group(0) frame uniforms
+    WGPUBuffer frame_uniform_buffer; // @group(0) frame uniforms, one per shadow view
+    u32 frame_uniform_stride;
+
+    // shadow map cache. the shadow map is only re-rendered when the hash of its
+    // inputs changes. casters that moved recently are drawn on top of a cached
+    // copy of the still ones (the static layer)
+    u64 shadow_hash;        // inputs of the shadow map as last rendered
+    u64 shadow_static_hash; // inputs of the static layer as last rendered
+    b32 shadow_static_cached;
+
+    // slot in the scene light buffer, valid while the light is in a scene
+    u32 scene_light_idx;
+    // desc or world matrix changed since the slot was last uploaded
+    b32 light_uniforms_stale;
 
     void shadowAddMesh(SG_ID* mesh_list, int mesh_count, bool add);
 
+    // number of shadow map array layers this light renders into
+    int shadowViewCount()
+    {
+        switch (desc.type) {
+            case SG_LightType_Spot: return 1;
+            case SG_LightType_Point: return 6;
+            case SG_LightType_Directional:
+                return CLAMP(desc.dirlight_shadow_cascades.count, 1,
+                             CHUGL_MAX_SHADOW_CASCADES);
+            default: return 0;
+        }
+    }
+
+    // projection * view of shadow view `view_idx`, `cascades` from LightUniforms
+    glm::mat4 shadowView(int view_idx, const glm::vec4* cascades);
+
     glm::mat4x4 projection(bool offset_depth)
     {
         switch (desc.type) {
@@ -574,13 +704,17 @@ struct R_Light : public R_Transform {
                 return proj;
             } break;
             case SG_LightType_Directional: {
-                return glm::ortho(-desc.dirlight_shadow_bounds.size * .5f,
-                                  desc.dirlight_shadow_bounds.size * .5f,
-                                  -desc.dirlight_shadow_bounds.size * .5f,
-                                  desc.dirlight_shadow_bounds.size * .5f,
+                // xy stays in light space units. each cascade maps its own square
+                // of it to the shadow map, see shadowView()
+                return glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f,
                                   -desc.dirlight_shadow_bounds.depth * .5f,
                                   desc.dirlight_shadow_bounds.depth * .5f);
             } break;
+            case SG_LightType_Point: {
+                // one 90 degree view per cube face
+                return glm::perspective(glm::half_pi<float>(), 1.0f,
+                                        CHUGL_POINT_SHADOW_NEAR, desc.radius);
+            } break;
             default: UNREACHABLE;
         }
         return glm::mat4(1.0);
@@ -594,10 +728,17 @@ struct R_Light : public R_Transform {
 struct R_Scene : R_Transform {
     SG_SceneDesc sg_scene_desc;
     hashmap* geo_to_xform;        // map from (Material, Geometry) to list of xforms
-    hashmap* light_id_set;        // set of SG_IDs
+    Arena light_ids;              // SG_ID of the light in each light buffer slot
+    Arena light_uniforms;         // LightUniforms, cpu copy of light_info_buffer
     GPU_Buffer light_info_buffer; // lighting storage buffer
     u64 last_fc_updated;          // frame count of last light update
 
+    // light stats, sent to the audio thread when they change
+    u32 lights_uploaded; // LightUniforms written to the gpu in the last update
+    u32 lights_active;   // lights that passed culling in the last scene pass
+    u32 lights_uploaded_sent;
+    u32 lights_active_sent;
+
     // shadows
     WGPUTexture spot_shadow_map_array;       // depth
     WGPUTexture spot_shadow_color_map_array; // color
@@ -605,9 +746,22 @@ struct R_Scene : R_Transform {
     WGPUTexture dir_shadow_map_array;       // depth
     WGPUTexture dir_shadow_color_map_array; // color
 
+    WGPUTexture point_shadow_map_array;       // depth, 6 layers per light
+    WGPUTexture point_shadow_color_map_array; // color
+
+    // depth of each light's still shadow casters, same layout as the arrays above
+    WGPUTexture static_shadow_map_arrays[SG_LightType_Count];
+    // bumped when a shadow map array is recreated, invalidating cached shadows
+    u32 shadow_map_generation[SG_LightType_Count];
+    // some light's shadow passes didn't fit in the render graph last update.
+    // warns once each time the budget runs out
+    b32 shadow_pass_budget_exhausted;
+
+    // camera is the camera of the first ScenePass to render the scene this frame,
+    // directional shadow cascades are fit to its view
     static void update(R_Scene* scene, GraphicsContext* gctx, u64 frame_count,
                        Arena* frame_arena, G_Graph* graph,
-                       FrameUniforms* frame_uniforms)
+                       FrameUniforms* frame_uniforms, R_Camera* camera, f32 aspect)
     {
         if (frame_count == scene->last_fc_updated) return;
         scene->last_fc_updated = frame_count;
@@ -616,7 +770,8 @@ struct R_Scene : R_Transform {
         R_Transform::rebuildMatrices(scene, frame_arena);
 
         // update lights
-        R_Scene::rebuildLightInfoBuffer(gctx, scene, graph, frame_uniforms);
+        R_Scene::rebuildLightInfoBuffer(gctx, scene, graph, frame_uniforms,
+                                        frame_count, camera, aspect);
     }
 
     static void initFromSG(GraphicsContext* gctx, R_Scene* r_scene, SG_ID scene_id,
@@ -626,13 +781,23 @@ struct R_Scene : R_Transform {
     static void addSubgraphToRenderState(R_Scene* scene, R_Transform* xform);
 
     static void rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
-                                       G_Graph* graph, FrameUniforms* frame_uniforms);
+                                       G_Graph* graph, FrameUniforms* frame_uniforms,
+                                       u64 frame_count, R_Camera* camera, f32 aspect);
 
     static i32 numLights(R_Scene* scene)
     {
-        return (i32)hashmap_count(scene->light_id_set);
+        return (i32)ARENA_LENGTH(&scene->light_ids, SG_ID);
     }
 
+    // writes the light buffer slots of lights that can reach the camera frustum to
+    // active_light_buffer, which must already hold numLights() indices.
+    // returns the number of active lights
+    static u32 cullLights(GraphicsContext* gctx, R_Scene* scene,
+                          const glm::mat4& proj_view, GPU_Buffer* active_light_buffer);
+
+    // pushes light stats to the audio thread if they changed
+    static void sendLightStats(R_Scene* scene);
+
     static void registerMesh(R_Scene* scene, R_Transform* mesh);
     static void unregisterMesh(R_Scene* scene, R_Transform* mesh);
     static void markPrimitiveStale(R_Scene* scene, R_Transform* mesh);
@@ -644,9 +809,12 @@ struct R_Scene : R_Transform {
 // R_Pass
 // =============================================================================
 
-void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
+// light_cluster_buffer may be NULL for passes without a cluster grid
+void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer,
+                         WGPUBuffer light_cluster_buffer, GraphicsContext* gctx,
                          G_DrawCall* d, G_Graph* graph, R_Shader* shader,
-                         R_Scene* scene, bool is_shadow_pass = false);
+                         R_Scene* scene, bool is_shadow_pass = false,
+                         u32 frame_uniform_offset = 0);
 
 struct R_Pass : public R_Component {
     SG_Pass sg_pass;
@@ -655,6 +823,24 @@ struct R_Pass : public R_Component {
     // ScenePass --------------------
     WGPUTexture depth_texture;
     WGPUTexture msaa_color_target;
+    GPU_Buffer light_cluster_buffer; // per-camera light lists, see LightClusterPass
+    GPU_Buffer active_light_buffer;  // u32 light slots that survived frustum culling
+
+    // gpu instance culling, see _R_RenderScene()
+    GPU_Buffer instance_cull_params_buffer; // InstanceCullParams per opaque draw
+    GPU_Buffer draw_args_buffer;            // indirect args, counted by the cull pass
+    GPU_Buffer visible_draw_buffer;         // DrawUniforms of the visible instances
+    GPU_Buffer lod_draw_buffer;             // DrawUniforms of LOD meshes, by level
+    GPU_Buffer occlusion_params_buffer;     // OcclusionCullParams
+    GPU_Buffer cull_stats_buffer;           // u32 visible, occluded instance counts
+    WGPUBuffer cull_stats_readback;         // MapRead copy of cull_stats_buffer
+    b32 cull_stats_mapping;                 // readback copied or mapped, not yet read
+
+    // occlusion culling against the previous frame's depth, see HiZGenerator
+    WGPUTexture hiz_texture;         // R32Float max-depth pyramid of depth_texture
+    glm::mat4 hiz_projection_view;   // camera of the frame the pyramid was built from
+    glm::vec4 hiz_viewport;          // viewport of that frame, in pixels
+    b32 hiz_valid;                   // false until a pyramid has been built
 
     // updates the scenepass depth texture to match the color target
     // also rebuilds the msaa color target if msaa is enabled
@@ -704,7 +890,9 @@ struct R_Pass : public R_Component {
         texture_desc.sampleCount           = samps;
         texture_desc.dimension             = WGPUTextureDimension_2D;
         texture_desc.format                = WGPUTextureFormat_Depth32Float;
-        texture_desc.usage                 = WGPUTextureUsage_RenderAttachment;
+        // sampled when building the Hi-Z pyramid for occlusion culling
+        texture_desc.usage
+          = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding;
 
         if (rebuild_depth_texture) {
             WGPUTexture new_depth_texture
@@ -745,6 +933,37 @@ struct R_Pass : public R_Component {
               (void*)pass->msaa_color_target);
         }
     }
+
+    // resizes the Hi-Z pyramid to match the depth texture, invalidating it. call
+    // after updateScenePass() and before the pyramid is bound for the frame
+    static void updateHiZ(R_Pass* pass, WGPUDevice device)
+    {
+        u32 width  = wgpuTextureGetWidth(pass->depth_texture);
+        u32 height = wgpuTextureGetHeight(pass->depth_texture);
+        if (pass->hiz_texture && wgpuTextureGetWidth(pass->hiz_texture) == width
+            && wgpuTextureGetHeight(pass->hiz_texture) == height) {
+            return;
+        }
+
+        static char label[128] = {};
+        snprintf(label, sizeof(label), "Hi-Z Texture for ScenePass[%d:%s]", pass->id,
+                 pass->sg_pass.name);
+
+        WGPUTextureDescriptor texture_desc = {};
+        texture_desc.label                 = label;
+        texture_desc.size                  = { width, height, 1 };
+        texture_desc.mipLevelCount         = G_mipLevels(width, height);
+        texture_desc.sampleCount           = 1;
+        texture_desc.dimension             = WGPUTextureDimension_2D;
+        texture_desc.format                = WGPUTextureFormat_R32Float;
+        texture_desc.usage
+          = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding;
+
+        WGPU_RELEASE_RESOURCE(Texture, pass->hiz_texture);
+        pass->hiz_texture = wgpuDeviceCreateTexture(device, &texture_desc);
+        pass->hiz_valid   = false;
+        ASSERT(pass->hiz_texture);
+    }
 };
 
 // =============================================================================
@@ -786,6 +1005,37 @@ struct BoundingBox {
     float minX, minY, maxX, maxY;
 };
 
+// compact per-glyph instance produced by text layout. x is relative to the
+// start of its line, buffer_index indexes R_Font::bufferGlyphs
+struct R_TextGlyph {
+    float x;
+    i32 buffer_index;
+};
+
+// one drawn glyph, uploaded per R_Text. The vertex shader expands it into a quad
+// from the font's glyph bounds, see gtext_shader_string
+struct R_TextGlyphInstance {
+    glm::vec2 offset; // origin of the glyph quad, before control points
+    i32 buffer_index;
+    i32 _pad;
+};
+static_assert(sizeof(R_TextGlyphInstance) == 16, "glyph instance size");
+
+struct R_TextLine {
+    u32 glyph_offset; // into R_Text::layout_glyphs
+    u32 glyph_count;
+    float width;
+};
+
+// a run of text between two '\n'. Wrapping never crosses paragraphs, so each
+// paragraph's layout is cached and only re-laid out when its bytes change
+struct R_TextParagraph {
+    u64 hash;
+    u32 byte_count;
+    u32 line_offset; // into R_Text::layout_lines
+    u32 line_count;
+};
+
 struct R_Text : public R_Transform {
     std::string text;
     std::string font_path;
@@ -795,12 +1045,31 @@ struct R_Text : public R_Transform {
     float width; // max width in worldspace units, used for alignment
     SG_Text_AlignmentType alignment;
     float size = 1.0f;
+
+    R_Font* font; // font requested by font_path (or the default), holds a reference
+
+    // cached layout, see R_Font::updateText
+    Arena layout_paragraphs; // R_TextParagraph
+    Arena layout_lines;      // R_TextLine
+    Arena layout_glyphs;     // R_TextGlyph
+    // R_TextGlyphInstance per visible glyph are written to pull buffer 0 of the
+    // text's geometry, which draws 6 vertices per instance
+
+    // params the cached layout was built with
+    u32 layout_font_id;
+    float layout_size;
+    float layout_width;
+    float layout_vertical_spacing;
+    SG_Text_AlignmentType layout_alignment;
+    BoundingBox layout_bounds; // of the laid out glyph quads, before control points
 };
 
+// One R_Font per font path, shared by every GText using that path. Fonts are
+// reference counted and loaded on the Jobs pool, see Component_GetFont()
 struct R_Font {
     std::string font_path;
-    FT_Face face; // TODO multiplex faces across R_Font. multiple R_Font with same
-                  // font but different text can share the same face
+    FT_Library library; // owned. One per font so faces can be parsed off-thread
+    FT_Face face;
 
     FT_Int32 loadFlags;
     FT_Kerning_Mode kerningMode;
@@ -819,43 +1088,104 @@ struct R_Font {
 
     GPU_Buffer glyph_buffer;
     GPU_Buffer curve_buffer;
+    GPU_Buffer bounds_buffer; // bufferGlyphBounds, expands glyph instances to quads
 
+    // glyph, curve and bounds data is append-only. The gpu buffers are
+    // overallocated and only the tail past their size is uploaded when new glyphs
+    // are built
     std::vector<BufferGlyph> bufferGlyphs;
     std::vector<BufferCurve> bufferCurves;
+    std::vector<BoundingBox> bufferGlyphBounds; // em-relative quad per bufferGlyph
     std::unordered_map<u32, Glyph> glyphs;
 
+    // direct lookup for ASCII charcodes, points into glyphs (node addresses of
+    // an unordered_map are stable across rehashing)
+    Glyph* asciiGlyphs[128];
+
+    // kerning in font units keyed by (left glyph index << 32 | right glyph index)
+    std::unordered_map<u64, FT_Pos> kerningPairs;
+
+    u32 id; // unique per loaded font, never reused. Keys the shared layout cache
+
+    // registry state. The load job owns every other field until load_job is done
+    Jobs_Counter load_job;
+    b32 load_failed; // written by the load job
+    b32 loading;     // load job submitted and not yet finished, render thread only
+    b32 ready;       // loaded and uploaded, render thread only
+    i32 refcount;    // R_Text and default font references
+    u64 unused_since_frame;
+
     // The glyph quads are expanded by this amount to enable proper
     // anti-aliasing. Value is relative to emSize.
     float dilation = 0.1f;
 
-    // given a text object, updates its geo vertex buffers
-    // and material bindgroup
+    // given a text object, updates its glyph instances and material bindgroup
     static void updateText(GraphicsContext* gctx, R_Font* font, R_Text* text);
-    static bool init(GraphicsContext* gctx, FT_Library library, R_Font* font,
-                     const char* font_path);
+    // parses the face and builds the ASCII glyphs. Touches no gpu state, safe to
+    // call from any thread. Glyph data is uploaded by prepareGlyphsForText()
+    static bool load(R_Font* font);
 
-    static void free(R_Font* text)
+    static void free(R_Font* font)
     {
-        GPU_Buffer::destroy(&text->glyph_buffer);
-        GPU_Buffer::destroy(&text->curve_buffer);
-        FT_Done_Face(text->face);
+        GPU_Buffer::destroy(&font->glyph_buffer);
+        GPU_Buffer::destroy(&font->curve_buffer);
+        GPU_Buffer::destroy(&font->bounds_buffer);
+        if (font->face) FT_Done_Face(font->face);
+        if (font->library) FT_Done_FreeType(font->library);
     }
 
     static void prepareGlyphsForText(GraphicsContext* gctx, R_Font* font,
                                      const char* text);
 };
 
+u32 R_Font_decodeCharcode(char** text);
+
+// returns the undefined glyph if charcode has no glyph in this font
+Glyph* R_Font_getGlyph(R_Font* font, u32 charcode);
+
 // =============================================================================
 // R_Video
 // =============================================================================
 
+// MPEG1 frames are decoded on the Jobs pool into a small ring of YUV frames
+// (see R_VideoDecoder in r_component.cpp). The render thread only advances the
+// playback clock and uploads whichever decoded frame is due. The Y/Cb/Cr
+// planes are uploaded as-is and converted into the RGBA texture on the GPU.
 struct R_Video : public R_Component {
-    plm_t* plm;            // plm_destroy(plm) to free
-    GraphicsContext* gctx; // messy workaround for plm callbacks
+    struct R_VideoDecoder* decoder; // NULL if the file could not be opened
     SG_ID video_texture_rgba_id;
-    u8* rgba_data_OWNED; // free with free(rgba_data)
-    int rgba_data_size;
     float rate = 1.0f;
+
+    // Y, Cb, Cr planes (R8Unorm), sized to the decoder's macroblock-aligned
+    // planes. Created on the first presented frame
+    WGPUTexture planes[3];
+    WGPUBindGroup yuv_bind_group;
+    WGPUTexture yuv_bind_group_dst; // rgba texture the bind group writes to
+
+    // playback, render thread only
+    double clock;       // presentation time in seconds, monotonic across loops
+    u32 generation;     // bumped on seek, frames decoded before the seek are skipped
+    bool reverse;       // rate < 0, clock and presentation times count down
+    float stats_timer;  // seconds since stats were last sent to the audio thread
+    int frames_dropped; // decoded frames that were never presented
+
+    // last presented frame, to resume from it when the direction changes
+    double presented_pts;
+    double presented_stream_time;
+
+    // advance playback by dt seconds (scaled by rate), upload the newest frame
+    // that is due and keep the decoder busy. The YUV to RGBA conversion is
+    // recorded into cmd_encoder
+    static void update(GraphicsContext* gctx, WGPUCommandEncoder cmd_encoder,
+                       R_Video* video, f32 dt);
+    // frame accurate. Decoding restarts from the keyframe before time_secs
+    static void seek(R_Video* video, double time_secs);
+    // negative rates play in reverse
+    static void setRate(R_Video* video, f32 rate);
+    static void setLoop(R_Video* video, bool loop);
+
+    // waits for any decode in flight, then releases the decoder
+    static void free(R_Video* video);
 };
 
 // =============================================================================
@@ -865,12 +1195,25 @@ struct R_Video : public R_Component {
 struct R_Webcam : public R_Component {
     SG_ID webcam_texture_id;
     int device_id;
+    struct R_WebcamDevice* device; // shared by all webcams using device_id
     u64 last_frame_count; // last webcame frame count, used to detect new frames and
                           // prevent reuploading old frames
     bool freeze;
 
-    static void updateTexture(GraphicsContext* gctx, R_Webcam* webcam);
+    // planes uploaded for the YUYV / NV12 formats, converted to RGBA on the GPU.
+    // Created on the first frame in that format
+    WGPUTexture planes[2];
+    WGPUBindGroup yuv_bind_group;
+    YUVLayout yuv_bind_group_layout;
+    WGPUTexture yuv_bind_group_dst; // rgba texture the bind group writes to
+
+    // uploads the newest captured frame if it hasn't been uploaded yet. YUV
+    // formats record their conversion into cmd_encoder
+    static void updateTexture(GraphicsContext* gctx, WGPUCommandEncoder cmd_encoder,
+                              R_Webcam* webcam);
     static void update(SG_Command_WebcamUpdate* cmd);
+    // releases the YUV planes and conversion bind group
+    static void free(R_Webcam* webcam);
 };
 
 // =============================================================================
@@ -883,8 +1226,8 @@ R_Transform* Component_CreateTransform(SG_Command_CreateXform* cmd);
 R_Transform* Component_CreateMesh(SG_ID mesh_id, SG_ID geo_id, SG_ID mat_id);
 R_Camera* Component_CreateCamera(GraphicsContext* gctx, SG_Command_CameraCreate* cmd);
 
-R_Text* Component_CreateText(GraphicsContext* gctx, FT_Library ft,
-                             SG_Command_TextRebuild* cmd, R_Font* default_font);
+R_Text* Component_CreateText(GraphicsContext* gctx, SG_Command_TextRebuild* cmd,
+                             R_Font* default_font);
 
 R_Scene* Component_CreateScene(GraphicsContext* gctx, SG_ID scene_id,
                                SG_SceneDesc* sg_scene_desc);
@@ -915,13 +1258,28 @@ R_Transform* Component_GetXform(SG_ID id);
 R_Transform* Component_GetMesh(SG_ID id);
 R_Scene* Component_GetScene(SG_ID id);
 R_Geometry* Component_GetGeometry(SG_ID id);
+// the geometry whose buffers draw geometry id, see R_Geometry::shared_id
+R_Geometry* Component_GetDrawGeometry(SG_ID id);
 R_Shader* Component_GetShader(SG_ID id);
 R_Material* Component_GetMaterial(SG_ID id);
 R_Texture* Component_GetTexture(SG_ID id);
 R_Camera* Component_GetCamera(SG_ID id);
 R_Text* Component_GetText(SG_ID id);
-R_Font* Component_GetFont(GraphicsContext* gctx, FT_Library library,
-                          const char* font_path);
+
+#define R_FONT_EVICT_FRAMES 300
+
+// Font registry, keyed by font path. Lookups that miss create the font and
+// start loading it on the Jobs pool; builtin "chugl:" fonts are decompressed
+// from memory and load immediately. Returns NULL for an empty path.
+// Until R_Font::ready the font must not be used for layout.
+R_Font* Component_GetFont(GraphicsContext* gctx, const char* font_path);
+void Component_FontAcquire(R_Font* font);
+void Component_FontRelease(R_Font* font);
+
+// once per frame: finishes fonts whose load job is done and re-lays out the
+// texts waiting on them, then evicts fonts that have had no references for
+// R_FONT_EVICT_FRAMES frames
+void Component_UpdateFonts(GraphicsContext* gctx, R_Font* default_font);
 R_Pass* Component_GetPass(SG_ID id);
 R_Buffer* Component_GetBuffer(SG_ID id);
 R_Light* Component_GetLight(SG_ID id);
@@ -977,13 +1335,13 @@ struct G_DrawCallPipelineDesc {
 };
 
 struct G_CacheComputePipeline {
-    WGPUShaderModule key; // TODO refcount
+    WGPUShaderModule key; // refcounted, ensures the module address is not reused
+                          // so long as its in the G_Cache
     struct {
         WGPUComputePipeline pipeline;
         WGPUBindGroupLayout
           bind_group_layout; // currently compute pipelines are only
                              // allowed to use @group(0)
-                             // TODO remember to release the BGLayout too
     } val;
 
     static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
@@ -1031,7 +1389,7 @@ struct G_CacheRenderPipelineKey {
 struct G_CacheRenderPipelineVal {
     WGPURenderPipeline pipeline;
     WGPUBindGroupLayout
-      bind_group_layout_list[CHUGL_MAX_BINDGROUPS]; // TODO free on delete
+      bind_group_layout_list[CHUGL_MAX_BINDGROUPS]; // released on eviction
 
     // lazy evaluate bindGroups because getting bindGroupLayout of
     // a group that doesn't exist throughs a WGPU validation error
@@ -1065,6 +1423,57 @@ struct G_CacheRenderPipeline {
     }
 };
 
+// Intrusive LRU list for cache entries that expire after going unused for some
+// number of frames. Entries are individually heap allocated (the hashmaps store
+// pointers), so prev/next stay valid as the hashmaps grow and shuffle items.
+// T must have `lru_prev`, `lru_next`, and `lru_last_used_frame` members.
+template <typename T>
+struct G_CacheLRU {
+    T* head; // least recently used
+    T* tail; // most recently used
+
+    void touch(T* entry, u64 frame)
+    {
+        entry->lru_last_used_frame = frame;
+        if (tail == entry) return;
+
+        if (entry->lru_prev || head == entry) unlink(entry);
+
+        entry->lru_prev = tail;
+        entry->lru_next = NULL;
+        if (tail)
+            tail->lru_next = entry;
+        else
+            head = entry;
+        tail = entry;
+    }
+
+    void unlink(T* entry)
+    {
+        if (entry->lru_prev)
+            entry->lru_prev->lru_next = entry->lru_next;
+        else
+            head = entry->lru_next;
+
+        if (entry->lru_next)
+            entry->lru_next->lru_prev = entry->lru_prev;
+        else
+            tail = entry->lru_prev;
+
+        entry->lru_prev = NULL;
+        entry->lru_next = NULL;
+    }
+
+    // returns the least recently used entry if it has gone unused for at least
+    // `frames_till_expired` frames, otherwise NULL
+    T* expired(u64 frame, u64 frames_till_expired)
+    {
+        if (head && frame - head->lru_last_used_frame >= frames_till_expired)
+            return head;
+        return NULL;
+    }
+};
+
 struct G_CacheBindGroupEntryBuffer {
     WGPUBuffer buffer;
     u32 offset;
@@ -1091,13 +1500,17 @@ struct G_CacheTextureViewDesc {
     }
 };
 
+// texture_view_map stores G_CacheTextureView*
 struct G_CacheTextureView {
-    G_CacheTextureViewDesc key;
+    G_CacheTextureViewDesc key; // must be first, lookups cast the key to an entry
     struct {
         WGPUTextureView view; // owned
-        int frames_till_expired = CHUGL_CACHE_TEXTURE_VIEW_FRAMES_TILL_EXPIRED;
     } val;
 
+    G_CacheTextureView* lru_prev;
+    G_CacheTextureView* lru_next;
+    u64 lru_last_used_frame;
+
     static void print(G_CacheTextureView* tv)
     {
         G_CacheTextureViewDesc::print(&tv->key);
@@ -1105,15 +1518,15 @@ struct G_CacheTextureView {
 
     static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
     {
-        G_CacheTextureView* entry = (G_CacheTextureView*)item;
+        G_CacheTextureView* entry = *(G_CacheTextureView**)item;
         ASSERT(sizeof(entry->key) == sizeof(G_CacheTextureViewDesc));
         return hashmap_xxhash3(&entry->key, sizeof(entry->key), seed0, seed1);
     }
 
     static int compare(const void* a, const void* b, void* udata)
     {
-        G_CacheTextureView* ga = (G_CacheTextureView*)a;
-        G_CacheTextureView* gb = (G_CacheTextureView*)b;
+        G_CacheTextureView* ga = *(G_CacheTextureView**)a;
+        G_CacheTextureView* gb = *(G_CacheTextureView**)b;
         return memcmp(&ga->key, &gb->key, sizeof(ga->key));
     }
 };
@@ -1182,17 +1595,21 @@ struct G_CacheBindGroupKey {
 
 struct G_CacheBindGroupVal {
     WGPUBindGroup bg;
-    int frames_till_expired = CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED;
 };
 
+// bindgroup_map stores G_CacheBindGroup*
 struct G_CacheBindGroup {
-    G_CacheBindGroupKey key;
+    G_CacheBindGroupKey key; // must be first, lookups cast the key to an entry
     G_CacheBindGroupVal val;
 
+    G_CacheBindGroup* lru_prev;
+    G_CacheBindGroup* lru_next;
+    u64 lru_last_used_frame;
+
     static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
     {
         // ==optimize== cache the hash
-        G_CacheBindGroupKey* key = (G_CacheBindGroupKey*)item;
+        G_CacheBindGroupKey* key = *(G_CacheBindGroupKey**)item;
         const size_t base_len    = offsetof(G_CacheBindGroupKey, bg_entry_list);
         return hashmap_xxhash3(
           key, base_len + key->bg_entry_count * sizeof(key->bg_entry_list[0]), seed0,
@@ -1201,8 +1618,8 @@ struct G_CacheBindGroup {
 
     static int compare(const void* a, const void* b, void* udata)
     {
-        G_CacheBindGroupKey* ga = (G_CacheBindGroupKey*)a;
-        G_CacheBindGroupKey* gb = (G_CacheBindGroupKey*)b;
+        G_CacheBindGroupKey* ga = *(G_CacheBindGroupKey**)a;
+        G_CacheBindGroupKey* gb = *(G_CacheBindGroupKey**)b;
         return memcmp(ga, gb, sizeof(*ga));
     }
 };
@@ -1220,16 +1637,58 @@ struct G_CacheStats {
     int bindgroup_misses;
     int texture_view_misses;
 
+    int render_pipeline_hits;
+    int compute_pipeline_hits;
+    int bindgroup_hits;
+    int texture_view_hits;
+
+    int render_pipeline_evictions;
+    int compute_pipeline_evictions;
+    int bindgroup_evictions;
+    int texture_view_evictions;
+
+    // live entry counts, sampled at the end of G_Cache::update()
+    int render_pipeline_count;
+    int compute_pipeline_count;
+    int bindgroup_count;
+    int texture_view_count;
+
+    void accumulate(G_CacheStats* frame)
+    {
+        render_pipeline_misses += frame->render_pipeline_misses;
+        compute_pipeline_misses += frame->compute_pipeline_misses;
+        bindgroup_misses += frame->bindgroup_misses;
+        texture_view_misses += frame->texture_view_misses;
+
+        render_pipeline_hits += frame->render_pipeline_hits;
+        compute_pipeline_hits += frame->compute_pipeline_hits;
+        bindgroup_hits += frame->bindgroup_hits;
+        texture_view_hits += frame->texture_view_hits;
+
+        render_pipeline_evictions += frame->render_pipeline_evictions;
+        compute_pipeline_evictions += frame->compute_pipeline_evictions;
+        bindgroup_evictions += frame->bindgroup_evictions;
+        texture_view_evictions += frame->texture_view_evictions;
+
+        render_pipeline_count  = frame->render_pipeline_count;
+        compute_pipeline_count = frame->compute_pipeline_count;
+        bindgroup_count        = frame->bindgroup_count;
+        texture_view_count     = frame->texture_view_count;
+    }
+
     void log()
     {
         log_trace(
           "\n"
-          "Render Pipeline Misses: %d\n"
-          "Compute Pipeline Misses: %d\n"
-          "Bindgroup Misses: %d\n"
-          "TextureView Misses: %d\n",
-          render_pipeline_misses, compute_pipeline_misses, bindgroup_misses,
-          texture_view_misses);
+          "Render Pipeline  hits: %d misses: %d evictions: %d live: %d\n"
+          "Compute Pipeline hits: %d misses: %d evictions: %d live: %d\n"
+          "Bindgroup        hits: %d misses: %d evictions: %d live: %d\n"
+          "TextureView      hits: %d misses: %d evictions: %d live: %d\n",
+          render_pipeline_hits, render_pipeline_misses, render_pipeline_evictions,
+          render_pipeline_count, compute_pipeline_hits, compute_pipeline_misses,
+          compute_pipeline_evictions, compute_pipeline_count, bindgroup_hits,
+          bindgroup_misses, bindgroup_evictions, bindgroup_count, texture_view_hits,
+          texture_view_misses, texture_view_evictions, texture_view_count);
     }
 };
 
@@ -1238,8 +1697,14 @@ struct G_Cache {
 
     hashmap* render_pipeline_map;
     hashmap* compute_pipeline_map;
-    hashmap* bindgroup_map;
-    hashmap* texture_view_map;
+    hashmap* bindgroup_map;    // G_CacheBindGroup*
+    hashmap* texture_view_map; // G_CacheTextureView*
+
+    // expiry order for bindgroups and texture views, so update() only touches
+    // entries that actually expire rather than scanning the whole cache
+    G_CacheLRU<G_CacheBindGroup> bindgroup_lru;
+    G_CacheLRU<G_CacheTextureView> texture_view_lru;
+    u64 frame_count;
 
     Arena deletion_queue;
 
@@ -1259,10 +1724,10 @@ struct G_Cache {
                                                   G_CacheComputePipeline::compare);
 
         bindgroup_map = hashmap_new_simple(
-          sizeof(G_CacheBindGroup), G_CacheBindGroup::hash, G_CacheBindGroup::compare);
+          sizeof(G_CacheBindGroup*), G_CacheBindGroup::hash, G_CacheBindGroup::compare);
 
         texture_view_map
-          = hashmap_new_simple(sizeof(G_CacheTextureView), G_CacheTextureView::hash,
+          = hashmap_new_simple(sizeof(G_CacheTextureView*), G_CacheTextureView::hash,
                                G_CacheTextureView::compare);
     }
 
@@ -1274,7 +1739,8 @@ struct G_Cache {
 
         if (result == NULL) { // create new pipeline
             ++frame_stats.compute_pipeline_misses;
-            log_trace("Cache miss [ComputePipeline], creating new from %p", module);
+            log_trace("Cache miss [ComputePipeline], creating new from %p",
+                      (void*)module);
 
             WGPUComputePipelineDescriptor desc = {};
             desc.label                         = label;
@@ -1290,12 +1756,15 @@ struct G_Cache {
                     wgpuComputePipelineGetBindGroupLayout(
                       pipeline, 0) // caching because this wgpu call leaks memory
                   } };
+            WGPU_REFERENCE_RESOURCE(ShaderModule, module); // released on eviction
 
             const void* replaced = hashmap_set(compute_pipeline_map, &item);
             ASSERT(!replaced);
 
             result = (G_CacheComputePipeline*)hashmap_get(compute_pipeline_map, &item);
             ASSERT(result);
+        } else {
+            ++frame_stats.compute_pipeline_hits;
         }
 
         return *result;
@@ -1461,6 +1930,8 @@ struct G_Cache {
             result = (G_CacheRenderPipeline*)hashmap_get(render_pipeline_map,
                                                          &pipeline_item);
             ASSERT(result);
+        } else {
+            ++frame_stats.render_pipeline_hits;
         }
 
         return result;
@@ -1469,8 +1940,10 @@ struct G_Cache {
     WGPUTextureView textureView(G_CacheTextureViewDesc desc)
     {
         // check if present in cache
-        G_CacheTextureView* cache_view
-          = (G_CacheTextureView*)hashmap_get(texture_view_map, &desc);
+        G_CacheTextureView* lookup = (G_CacheTextureView*)&desc;
+        G_CacheTextureView** cache_view_ptr
+          = (G_CacheTextureView**)hashmap_get(texture_view_map, &lookup);
+        G_CacheTextureView* cache_view = cache_view_ptr ? *cache_view_ptr : NULL;
 
         if (cache_view == NULL) {
             ++frame_stats.texture_view_misses;
@@ -1487,24 +1960,25 @@ struct G_Cache {
             view_desc.baseArrayLayer  = desc.base_array_layer;
             view_desc.arrayLayerCount = desc.array_layer_count;
 
-            G_CacheTextureView item = {};
-            COPY_STRUCT(&item.key, &desc);
+            G_CacheTextureView* item = ALLOCATE_TYPE(G_CacheTextureView);
+            memset(item, 0, sizeof(*item));
+            COPY_STRUCT(&item->key, &desc);
 
             // WTF cpp this copy doesn't even work.............
             // item.key = desc;
 
-            item.val.view = wgpuTextureCreateView(texture, &view_desc);
-            ASSERT(item.val.view);
+            item->val.view = wgpuTextureCreateView(texture, &view_desc);
+            ASSERT(item->val.view);
             const void* replaced = hashmap_set(texture_view_map, &item);
             ASSERT(!replaced);
-            ASSERT(memcmp(&item, &desc, sizeof(desc)) == 0);
+            ASSERT(memcmp(item, &desc, sizeof(desc)) == 0);
 
             log_trace(
               "Cache miss [TextureView: %p], creating new from Texture[%p] mips[%d:%d]",
-              (void*)item.val.view, (void*)texture, desc.base_mip_level,
+              (void*)item->val.view, (void*)texture, desc.base_mip_level,
               desc.base_mip_level + desc.mip_level_count - 1);
 
-            cache_view = (G_CacheTextureView*)hashmap_get(texture_view_map, &desc);
+            cache_view = item;
 
 #if 0
             if (!cache_view) {
@@ -1518,6 +1992,7 @@ struct G_Cache {
                 G_CacheTextureView* tv            = NULL;
                 while (hashmap_iter(texture_view_map, &bindgroup_map_idx_DONT_USE,
                                     (void**)&tv)) {
+                    tv = *(G_CacheTextureView**)tv;
                     tv->print();
                     printf("comparison with item: %d\n",
                            memcmp(tv, &item, sizeof(tv->key)));
@@ -1527,10 +2002,11 @@ struct G_Cache {
             }
 #endif
             // ASSERT(cache_view);
+        } else {
+            ++frame_stats.texture_view_hits;
         }
 
-        cache_view->val.frames_till_expired
-          = CHUGL_CACHE_TEXTURE_VIEW_FRAMES_TILL_EXPIRED;
+        texture_view_lru.touch(cache_view, frame_count);
         return cache_view->val.view;
     }
 
@@ -1545,14 +2021,13 @@ struct G_Cache {
         // allocate on the stack and initialize ourselves.
         u8 item_buff[sizeof(G_CacheBindGroup)] = {};
         G_CacheBindGroup* item                 = (G_CacheBindGroup*)item_buff;
-        item->val.frames_till_expired = CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED;
 
         ASSERT(bg_entry_count <= ARRAY_LENGTH(item->key.bg_entry_list));
         item->key.layout         = layout;
         item->key.bg_entry_count = bg_entry_count;
 
-        // loop over all bg_entries to copy into lookup item and refcount & update
-        // frames_till_expired of any buffer or texture sources
+        // loop over all bg_entries to copy into lookup item and refcount & refresh
+        // the LRU position of any texture sources
         for (int bg_idx = 0; bg_idx < bg_entry_count; ++bg_idx) {
             G_CacheBindGroupEntry* bg = bg_entry_list + bg_idx;
             switch (bg->type) {
@@ -1562,7 +2037,7 @@ struct G_Cache {
                 case G_CacheBindGroupEntryType_Sampler: break;
                 case G_CacheBindGroupEntryType_TextureView: {
                     textureView(
-                      bg->as.texture_view_desc); // refreshes frames_till_expired
+                      bg->as.texture_view_desc); // refreshes texture view LRU
                 } break;
                 default: UNREACHABLE;
             }
@@ -1570,8 +2045,9 @@ struct G_Cache {
         memcpy(item->key.bg_entry_list, bg_entry_list,
                sizeof(*bg_entry_list) * bg_entry_count);
 
-        G_CacheBindGroup* result
-          = (G_CacheBindGroup*)hashmap_get(bindgroup_map, &item->key);
+        G_CacheBindGroup** result_ptr
+          = (G_CacheBindGroup**)hashmap_get(bindgroup_map, &item);
+        G_CacheBindGroup* result = result_ptr ? *result_ptr : NULL;
 
         if (result == NULL) {
             ++frame_stats.bindgroup_misses;
@@ -1618,131 +2094,139 @@ struct G_Cache {
             desc.entryCount = bg_entry_count;
             desc.entries    = wgpu_bg_entry_list;
 
-            item->val.bg                  = wgpuDeviceCreateBindGroup(device, &desc);
-            item->val.frames_till_expired = CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED;
+            item->val.bg = wgpuDeviceCreateBindGroup(device, &desc);
             log_trace("created bind group %p", (void*)item->val.bg);
 
-            const void* replaced = hashmap_set(bindgroup_map, item);
+            G_CacheBindGroup* entry = ALLOCATE_TYPE(G_CacheBindGroup);
+            memcpy(entry, item, sizeof(*entry));
+
+            const void* replaced = hashmap_set(bindgroup_map, &entry);
             ASSERT(!replaced);
 
-            return item->val.bg;
+            bindgroup_lru.touch(entry, frame_count);
+            return entry->val.bg;
         }
 
-        // reset lifetime counter
-        result->val.frames_till_expired = CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED;
+        // reset lifetime
+        ++frame_stats.bindgroup_hits;
+        bindgroup_lru.touch(result, frame_count);
         return result->val.bg;
     }
 
-    void update()
+    // Called by the graphics thread GC before an R_Shader is freed. Releases all
+    // pipelines (and their bind group layouts) built from the shader.
+    // Bindgroups created against those layouts hold their own reference and
+    // expire normally.
+    void releaseShaderPipelines(SG_ID shader_id, WGPUShaderModule compute_module)
     {
-        // TODO: loop over all pipelines, and if associated R_Shader is destroyed,
-        // free the pipeline and WGPU_RELEASE the cached bindgroup layouts
+        if (compute_module) {
+            G_CacheComputePipeline* deleted = (G_CacheComputePipeline*)hashmap_delete(
+              compute_pipeline_map, &compute_module);
+            if (deleted) {
+                ++frame_stats.compute_pipeline_evictions;
+                log_trace("evicting compute pipeline for shader module %p",
+                          (void*)compute_module);
+                WGPU_RELEASE_RESOURCE(ComputePipeline, deleted->val.pipeline);
+                WGPU_RELEASE_RESOURCE(BindGroupLayout, deleted->val.bind_group_layout);
+                WGPU_RELEASE_RESOURCE(ShaderModule, deleted->key);
+            }
+        }
+
+        // a shader typically has only a handful of pipeline variants, and there
+        // are few pipelines overall, so a scan on shader death is fine
+        Arena::clearZero(&deletion_queue);
+        size_t pipeline_map_idx_DONT_USE = 0;
+        G_CacheRenderPipeline* cache_pipeline = NULL;
+        while (hashmap_iter(render_pipeline_map, &pipeline_map_idx_DONT_USE,
+                            (void**)&cache_pipeline)) {
+            if (cache_pipeline->key.drawcall_pipeline_desc.sg_shader_id == shader_id) {
+                G_CacheRenderPipelineKey* key
+                  = ARENA_PUSH_TYPE(&deletion_queue, G_CacheRenderPipelineKey);
+                memcpy(key, &cache_pipeline->key, sizeof(*key));
+            }
+        }
 
-        // Actually, for compute pipelines, the graphics thread GC can explicitly
-        // tell the rendergraph to release the compute pipeline and bind group layout!
+        int num_to_delete = ARENA_LENGTH(&deletion_queue, G_CacheRenderPipelineKey);
+        for (int i = 0; i < num_to_delete; i++) {
+            G_CacheRenderPipeline* deleted = (G_CacheRenderPipeline*)hashmap_delete(
+              render_pipeline_map,
+              ARENA_GET_TYPE(&deletion_queue, G_CacheRenderPipelineKey, i));
+            ASSERT(deleted);
+            ++frame_stats.render_pipeline_evictions;
+            log_trace("evicting render pipeline %p for Shader[%d]",
+                      (void*)deleted->val.pipeline, shader_id);
+            WGPU_RELEASE_RESOURCE(RenderPipeline, deleted->val.pipeline);
+            WGPU_RELEASE_RESOURCE_ARRAY(BindGroupLayout,
+                                        deleted->val.bind_group_layout_list,
+                                        ARRAY_LENGTH(deleted->val.bind_group_layout_list));
+        }
+    }
+
+    void update()
+    {
+        // pipelines are released explicitly by releaseShaderPipelines()
 
-        // loop over bindgroups. delete expired.
+        // release expired bindgroups, least recently used first.
         // intentionally NOT refcounting non-texture-view WGPU resources here under
         // assumption that chuck-side refcounting will handle that for us
-        {
-            Arena::clearZero(&deletion_queue);
-
-            size_t bindgroup_map_idx_DONT_USE = 0;
-            G_CacheBindGroup* cache_bg        = NULL;
-            while (hashmap_iter(bindgroup_map, &bindgroup_map_idx_DONT_USE,
-                                (void**)&cache_bg)) {
-                if (--cache_bg->val.frames_till_expired <= 0) {
-                    *ARENA_PUSH_TYPE(&deletion_queue, G_CacheBindGroup) = *cache_bg;
+        G_CacheBindGroup* bg_del = NULL;
+        while ((bg_del = bindgroup_lru.expired(
+                  frame_count, CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED))) {
+            bindgroup_lru.unlink(bg_del);
+
+            // remove from hashmap
+            const void* deleted = hashmap_delete(bindgroup_map, &bg_del);
+            UNUSED_VAR(deleted);
+            ASSERT(deleted);
+
+            // deref resources in the key
+            WGPU_RELEASE_RESOURCE(BindGroupLayout, bg_del->key.layout);
+            for (int bg_idx = 0; bg_idx < bg_del->key.bg_entry_count; ++bg_idx) {
+                G_CacheBindGroupEntry* bg = bg_del->key.bg_entry_list + bg_idx;
+                if (bg->type == G_CacheBindGroupEntryType_Buffer) {
+                    WGPU_RELEASE_RESOURCE(Buffer, bg->as.buffer.buffer);
                 }
             }
-            int num_bg_to_delete = ARENA_LENGTH(&deletion_queue, G_CacheBindGroup);
-            for (int i = 0; i < num_bg_to_delete; i++) {
-                G_CacheBindGroup* bg_del
-                  = ARENA_GET_TYPE(&deletion_queue, G_CacheBindGroup, i);
-                ASSERT(bg_del->val.frames_till_expired <= 0);
-
-                // remove from hashmap
-                const void* deleted = hashmap_delete(bindgroup_map, bg_del);
-                ASSERT(deleted);
-
-                // deref resources in the key
-                WGPU_RELEASE_RESOURCE(BindGroupLayout, bg_del->key.layout);
-                for (int bg_idx = 0; bg_idx < bg_del->key.bg_entry_count; ++bg_idx) {
-                    G_CacheBindGroupEntry* bg = bg_del->key.bg_entry_list + bg_idx;
-                    if (bg->type == G_CacheBindGroupEntryType_Buffer) {
-                        WGPU_RELEASE_RESOURCE(Buffer, bg->as.buffer.buffer);
-                    }
-                }
 
-                log_trace("deleting expired bindgroup %p", (void*)bg_del->val.bg);
-                WGPU_RELEASE_RESOURCE(BindGroup, bg_del->val.bg);
-                // G_Util::printBindGroupEntryList(bg_del->key.bg_entry_list,
-                //                                 bg_del->key.bg_entry_count);
-            }
+            log_trace("deleting expired bindgroup %p", (void*)bg_del->val.bg);
+            WGPU_RELEASE_RESOURCE(BindGroup, bg_del->val.bg);
+            FREE_TYPE(G_CacheBindGroup, bg_del);
+            ++frame_stats.bindgroup_evictions;
         }
 
-        { // release unused texture views
-            Arena::clearZero(&deletion_queue);
-
-            size_t texview_map_idx_DONT_USE = 0;
-            G_CacheTextureView* cache_tv    = NULL;
-            while (hashmap_iter(texture_view_map, &texview_map_idx_DONT_USE,
-                                (void**)&cache_tv)) {
-                if (--cache_tv->val.frames_till_expired <= 0) {
+        // release unused texture views
+        G_CacheTextureView* tv_del = NULL;
+        while ((tv_del = texture_view_lru.expired(
+                  frame_count, CHUGL_CACHE_TEXTURE_VIEW_FRAMES_TILL_EXPIRED))) {
+            texture_view_lru.unlink(tv_del);
 
-                    // sanity check the WGPUTexture is still good (heuristic)
+            // sanity check the WGPUTexture is still good (heuristic)
 #ifdef CHUGL_DEBUG
-                    u32 sc = wgpuTextureGetSampleCount(cache_tv->key.texture);
-                    ASSERT(sc == 1 || sc == 4); // webgpu only allows 4xMSAA
+            u32 sc = wgpuTextureGetSampleCount(tv_del->key.texture);
+            ASSERT(sc == 1 || sc == 4); // webgpu only allows 4xMSAA
 #endif
 
-                    G_CacheTextureViewDesc* desc
-                      = ARENA_PUSH_TYPE(&deletion_queue, G_CacheTextureViewDesc);
-                    memcpy(desc, &cache_tv->key, sizeof(*desc));
-
-                    // on macos this * copy doesn't zero out struct padding, results in
-                    // undefined behavior *desc = cache_tv->key;
+            const void* deleted = hashmap_delete(texture_view_map, &tv_del);
+            UNUSED_VAR(deleted);
+            ASSERT(deleted && tv_del->val.view);
 
-                    // sanity check that bits+padding were copied correctly
-#ifdef CHUGL_DEBUG
-                    if (memcmp(desc, &cache_tv->key, sizeof(*desc)) != 0) {
-                        hexDump("copied G_CacheTextureViewDesc", desc, sizeof(*desc));
-                        hexDump("original G_CacheTextureViewDesc", &cache_tv->key,
-                                sizeof(cache_tv->key));
-                        printf("dimensions %dx%d\n",
-                               wgpuTextureGetWidth(cache_tv->key.texture),
-                               wgpuTextureGetHeight(cache_tv->key.texture));
-                        ASSERT(0);
-                    }
-#endif
-                }
-            }
-            int num_to_delete = ARENA_LENGTH(&deletion_queue, G_CacheTextureViewDesc);
-            for (int i = 0; i < num_to_delete; i++) {
-                G_CacheTextureViewDesc* tv_del
-                  = ARENA_GET_TYPE(&deletion_queue, G_CacheTextureViewDesc, i);
-
-                G_CacheTextureView* deleted
-                  = (G_CacheTextureView*)hashmap_delete(texture_view_map, tv_del);
-                ASSERT(deleted && deleted->val.frames_till_expired <= 0
-                       && deleted->val.view);
-
-                log_trace("deleting expired textureview %p", (void*)deleted->val.view);
-                WGPU_RELEASE_RESOURCE(TextureView, deleted->val.view);
-                WGPU_RELEASE_RESOURCE(Texture, deleted->key.texture);
-            }
+            log_trace("deleting expired textureview %p", (void*)tv_del->val.view);
+            WGPU_RELEASE_RESOURCE(TextureView, tv_del->val.view);
+            WGPU_RELEASE_RESOURCE(Texture, tv_del->key.texture);
+            FREE_TYPE(G_CacheTextureView, tv_del);
+            ++frame_stats.texture_view_evictions;
         }
 
+        ++frame_count;
+
         // update stats
-        // improve: track resource deletions too
-        // log_trace("--Cache Lifetime Stats--");
-        // lifetime_stats.log();
+        frame_stats.render_pipeline_count  = (int)hashmap_count(render_pipeline_map);
+        frame_stats.compute_pipeline_count = (int)hashmap_count(compute_pipeline_map);
+        frame_stats.bindgroup_count        = (int)hashmap_count(bindgroup_map);
+        frame_stats.texture_view_count     = (int)hashmap_count(texture_view_map);
         // log_trace("--Cache Frame Stats--");
         // frame_stats.log();
-        lifetime_stats.bindgroup_misses += frame_stats.bindgroup_misses;
-        lifetime_stats.compute_pipeline_misses += frame_stats.compute_pipeline_misses;
-        lifetime_stats.render_pipeline_misses += frame_stats.render_pipeline_misses;
-        lifetime_stats.texture_view_misses += frame_stats.texture_view_misses;
+        lifetime_stats.accumulate(&frame_stats);
         frame_stats = {};
     }
 };
@@ -1831,6 +2315,11 @@ struct G_DrawCall {
 
     u32 instance_count;
 
+    // if set, the draw args (including instance_count) are read from this buffer,
+    // laid out as DrawIndexedIndirect or DrawIndirect args
+    WGPUBuffer indirect_buffer;
+    u64 indirect_offset;
+
     struct {
         u32 start, count;
     } bg_list[CHUGL_MAX_BINDGROUPS];
@@ -1908,7 +2397,8 @@ struct G_DrawCallList {
             bool draw_indexed = (d->index_buffer != NULL);
 
 #ifdef CHUGL_DEBUG // drawcall validation
-            if (d->instance_count == 0) log_warn("drawcall instance count of 0");
+            if (d->instance_count == 0 && !d->indirect_buffer)
+                log_warn("drawcall instance count of 0");
             // sortkey should match pipeline desc
             ASSERT((bool)d->_pipeline_desc.is_transparent
                    == G_SortKey::transparent(d->sort_key));
@@ -1991,7 +2481,16 @@ struct G_DrawCallList {
             }
 
             // set index buffer
-            if (draw_indexed) {
+            if (draw_indexed && d->indirect_buffer) {
+                wgpuRenderPassEncoderSetIndexBuffer(
+                  pass_encoder, d->index_buffer, WGPUIndexFormat_Uint32,
+                  d->index_buffer_offset, d->index_buffer_size);
+                wgpuRenderPassEncoderDrawIndexedIndirect(
+                  pass_encoder, d->indirect_buffer, d->indirect_offset);
+            } else if (d->indirect_buffer) {
+                wgpuRenderPassEncoderDrawIndirect(pass_encoder, d->indirect_buffer,
+                                                  d->indirect_offset);
+            } else if (draw_indexed) {
                 wgpuRenderPassEncoderSetIndexBuffer(
                   pass_encoder, d->index_buffer, WGPUIndexFormat_Uint32,
                   d->index_buffer_offset, d->index_buffer_size);
@@ -2010,6 +2509,10 @@ enum G_PassType : u8 {
     G_PassType_None = 0,
     G_PassType_Render,
     G_PassType_Compute,
+    G_PassType_LightCluster, // builtin compute, bins lights into a camera's froxels
+    G_PassType_TextureCopy,
+    G_PassType_InstanceCull, // builtin compute, frustum culls instanced draws
+    G_PassType_HiZ,          // builtin compute, max-depth pyramid for occlusion culling
     G_PassType_Count,
 };
 
@@ -2052,6 +2555,7 @@ struct G_RenderPassParams {
     WGPUStoreOp color_store_op;
 
     G_CacheTextureViewDesc _depth_target;
+    WGPULoadOp depth_load_op; // Undefined means clear
 
     float viewport_x;
     float viewport_y;
@@ -2074,12 +2578,43 @@ struct G_ComputePassParams {
     u32 bg_start, bg_count; // bindgroup entries
 };
 
+// copies whole mip 0 array layers between textures of the same size and format
+struct G_TextureCopyPassParams {
+    WGPUTexture src, dst;
+    u32 src_layer, dst_layer, layer_count;
+};
+
+// one dispatch per culled (material, geometry) draw, all sharing one pipeline
+struct G_InstanceCullPassParams {
+    WGPUShaderModule module;
+    u32 dispatch_start, dispatch_count; // G_InstanceCullDispatch
+
+    // bound by every dispatch of the pass
+    WGPUBuffer frame_uniform_buffer;
+    WGPUBuffer occlusion_params_buffer; // OcclusionCullParams
+    WGPUBuffer stats_buffer;            // 2 u32
+    WGPUTexture hiz_texture;
+    WGPUBuffer stats_readback; // if not NULL, stats are copied here after culling
+};
+
+struct G_HiZPassParams {
+    WGPUTexture depth, hiz;
+};
+
+struct G_InstanceCullDispatch {
+    u32 workgroup_count;
+    u32 bg_start, bg_count; // bindgroup entries
+};
+
 struct G_Pass {
     G_PassType type;
     char name[64];
     union {
         G_RenderPassParams rp;
         G_ComputePassParams cp;
+        G_TextureCopyPassParams tc;
+        G_InstanceCullPassParams ic;
+        G_HiZPassParams hz;
     };
 };
 
@@ -2100,6 +2635,8 @@ struct G_Graph {
     G_Pass pass_list[CHUGL_RENDERGRAPH_MAX_PASSES];
     int pass_count;
 
+    Arena instance_cull_dispatch_list; // G_InstanceCullDispatch
+
     void init()
     {
         cache.init();
@@ -2209,6 +2746,13 @@ struct G_Graph {
         renderPassDepthTarget(tex, 0, 1);
     }
 
+    void renderPassDepthOp(WGPULoadOp load)
+    {
+        G_Pass* pass = pass_list + (pass_count - 1);
+        ASSERT(pass->type == G_PassType_Render);
+        pass->rp.depth_load_op = load;
+    }
+
     // returns aspect of viewport
     float viewport(float x, float y, float w, float h, WGPUTexture target)
     {
@@ -2380,6 +2924,133 @@ struct G_Graph {
               0 };
     }
 
+    void addTextureCopyPass(const char* name, WGPUTexture src, u32 src_layer,
+                            WGPUTexture dst, u32 dst_layer, u32 layer_count)
+    {
+        if (pass_count == CHUGL_RENDERGRAPH_MAX_PASSES) {
+            log_error("Reached max pass count %d", pass_count);
+            return;
+        }
+        ASSERT(wgpuTextureGetWidth(src) == wgpuTextureGetWidth(dst)
+               && wgpuTextureGetHeight(src) == wgpuTextureGetHeight(dst));
+        G_Pass* pass = &pass_list[pass_count++];
+        COPY_STRING(pass->name, name);
+        pass->type = G_PassType_TextureCopy;
+        pass->tc   = { src, dst, src_layer, dst_layer, layer_count };
+    }
+
+    // bins the scene lights into the per-camera cluster grid read by lit shaders.
+    // must be added before the render pass that draws with cluster_buffer
+    void addLightClusterPass(const char* name, WGPUShaderModule module,
+                             WGPUBuffer frame_uniform_buffer, WGPUBuffer light_buffer,
+                             u32 light_buffer_size, WGPUBuffer active_light_buffer,
+                             u32 active_light_buffer_size, WGPUBuffer cluster_buffer)
+    {
+        if (pass_count == CHUGL_RENDERGRAPH_MAX_PASSES) {
+            log_error("Reached max pass count %d", pass_count);
+            return;
+        }
+
+        // one workgroup per depth slice
+        addComputePass(name, module, 1, 1, CHUGL_LIGHT_CLUSTER_Z);
+        computePassBindBuffer(0, frame_uniform_buffer, 0, sizeof(FrameUniforms));
+        computePassBindBuffer(1, light_buffer, 0, light_buffer_size);
+        computePassBindBuffer(6, cluster_buffer, 0, CHUGL_LIGHT_CLUSTER_BUFFER_SIZE);
+        computePassBindBuffer(7, active_light_buffer, 0, active_light_buffer_size);
+        pass_list[pass_count - 1].type = G_PassType_LightCluster;
+    }
+
+    // returns the pass index to add dispatches to with instanceCullDispatch(), or
+    // -1 if out of passes. must be added before the render pass that draws the
+    // culled instances. hiz_texture is the previous frame's pyramid, or a sentinel
+    // if occlusion_params_buffer has occlusion disabled
+    int addInstanceCullPass(const char* name, WGPUShaderModule module,
+                            WGPUBuffer frame_uniform_buffer,
+                            WGPUBuffer occlusion_params_buffer, WGPUBuffer stats_buffer,
+                            WGPUTexture hiz_texture, WGPUBuffer stats_readback)
+    {
+        if (pass_count == CHUGL_RENDERGRAPH_MAX_PASSES) {
+            log_error("Reached max pass count %d", pass_count);
+            return -1;
+        }
+        G_Pass* pass = &pass_list[pass_count++];
+        COPY_STRING(pass->name, name);
+        pass->type      = G_PassType_InstanceCull;
+        pass->ic.module = module;
+        pass->ic.dispatch_start
+          = (u32)ARENA_LENGTH(&instance_cull_dispatch_list, G_InstanceCullDispatch);
+        pass->ic.dispatch_count          = 0;
+        pass->ic.frame_uniform_buffer    = frame_uniform_buffer;
+        pass->ic.occlusion_params_buffer = occlusion_params_buffer;
+        pass->ic.stats_buffer            = stats_buffer;
+        pass->ic.hiz_texture             = hiz_texture;
+        pass->ic.stats_readback          = stats_readback;
+        return pass_count - 1;
+    }
+
+    // culls instance_count DrawUniforms from instance_buffer into visible_buffer,
+    // counting survivors into the indirect args at params.draw_args_idx
+    void instanceCullDispatch(int pass_idx, u32 instance_count,
+                              WGPUBuffer params_buffer, u32 params_offset,
+                              WGPUBuffer instance_buffer, u32 instance_offset,
+                              u32 instance_size,
+                              WGPUBuffer visible_buffer, u32 visible_offset,
+                              u32 visible_size, WGPUBuffer draw_args_buffer,
+                              u32 draw_args_size)
+    {
+        ASSERT(pass_idx >= 0 && pass_list[pass_idx].type == G_PassType_InstanceCull);
+        G_InstanceCullPassParams* ic = &pass_list[pass_idx].ic;
+        // dispatches of a pass are contiguous
+        ASSERT(ic->dispatch_start + ic->dispatch_count
+               == ARENA_LENGTH(&instance_cull_dispatch_list, G_InstanceCullDispatch));
+
+        G_InstanceCullDispatch* dispatch
+          = ARENA_PUSH_ZERO_TYPE(&instance_cull_dispatch_list, G_InstanceCullDispatch);
+        dispatch->workgroup_count = (instance_count + 63) / 64; // workgroup_size(64)
+        dispatch->bg_start
+          = (u32)ARENA_LENGTH(&bind_group_entry_list[0], G_CacheBindGroupEntry);
+        dispatch->bg_count = 8;
+        ++ic->dispatch_count;
+
+        G_CacheBindGroupEntry* entries = ARENA_PUSH_ZERO_COUNT(
+          bind_group_entry_list, G_CacheBindGroupEntry, dispatch->bg_count);
+        entries[0].as.buffer = { ic->frame_uniform_buffer, 0, sizeof(FrameUniforms) };
+        entries[1].as.buffer
+          = { params_buffer, params_offset, sizeof(InstanceCullParams) };
+        entries[2].as.buffer = { instance_buffer, instance_offset, instance_size };
+        entries[3].as.buffer = { visible_buffer, visible_offset, visible_size };
+        entries[4].as.buffer = { draw_args_buffer, 0, draw_args_size };
+        entries[5].as.buffer = { ic->stats_buffer, 0, 2 * sizeof(u32) };
+        entries[7].as.buffer
+          = { ic->occlusion_params_buffer, 0, sizeof(OcclusionCullParams) };
+        for (u32 i = 0; i < dispatch->bg_count; ++i) {
+            entries[i].type    = G_CacheBindGroupEntryType_Buffer;
+            entries[i].binding = i;
+        }
+
+        // whole mip chain, the shader picks a mip per instance
+        G_CacheTextureViewDesc hiz_view = {};
+        hiz_view.texture                = ic->hiz_texture;
+        hiz_view.mip_level_count        = wgpuTextureGetMipLevelCount(ic->hiz_texture);
+        entries[6].type                 = G_CacheBindGroupEntryType_TextureView;
+        entries[6].as.texture_view_desc = hiz_view;
+    }
+
+    // builds hiz from depth. add after the render pass that writes depth.
+    // returns false if out of passes, hiz is then left as it was
+    bool addHiZPass(const char* name, WGPUTexture depth, WGPUTexture hiz)
+    {
+        if (pass_count == CHUGL_RENDERGRAPH_MAX_PASSES) {
+            log_error("Reached max pass count %d", pass_count);
+            return false;
+        }
+        G_Pass* pass = &pass_list[pass_count++];
+        COPY_STRING(pass->name, name);
+        pass->type = G_PassType_HiZ;
+        pass->hz   = { depth, hiz };
+        return true;
+    }
+
     void executeAndReset(WGPUDevice device, WGPUCommandEncoder command_encoder)
     {
         // TODO add debug labels
@@ -2439,7 +3110,9 @@ struct G_Graph {
                         // defaults for render pass depth/stencil attachment
                         // The initial value of the depth buffer, meaning "far"
                         ds.depthClearValue = 1.0f;
-                        ds.depthLoadOp     = WGPULoadOp_Clear;
+                        ds.depthLoadOp     = pass->rp.depth_load_op ?
+                                               pass->rp.depth_load_op :
+                                               WGPULoadOp_Clear;
                         ds.depthStoreOp    = WGPUStoreOp_Store;
                         // we could turn off writing to the depth buffer globally
                         // here
@@ -2485,7 +3158,8 @@ struct G_Graph {
                     WGPU_RELEASE_RESOURCE(TextureView,
                                           pass->rp.resolve_target.texture_view);
                 } break;
-                case G_PassType_Compute: {
+                case G_PassType_Compute:
+                case G_PassType_LightCluster: {
                     G_CacheComputePipeline cp
                       = cache.computePipeline(pass->cp.module, device, NULL);
                     WGPUComputePassDescriptor cp_desc = {};
@@ -2512,6 +3186,66 @@ struct G_Graph {
                     wgpuComputePassEncoderEnd(compute_pass);
                     WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
                 } break;
+                case G_PassType_TextureCopy: {
+                    WGPUImageCopyTexture src = {};
+                    src.texture              = pass->tc.src;
+                    src.origin               = { 0, 0, pass->tc.src_layer };
+                    src.aspect               = WGPUTextureAspect_All;
+                    WGPUImageCopyTexture dst = {};
+                    dst.texture              = pass->tc.dst;
+                    dst.origin               = { 0, 0, pass->tc.dst_layer };
+                    dst.aspect               = WGPUTextureAspect_All;
+                    WGPUExtent3D copy_size   = { wgpuTextureGetWidth(pass->tc.src),
+                                                 wgpuTextureGetHeight(pass->tc.src),
+                                                 pass->tc.layer_count };
+                    wgpuCommandEncoderCopyTextureToTexture(command_encoder, &src, &dst,
+                                                           &copy_size);
+                } break;
+                case G_PassType_InstanceCull: {
+                    // the stats were cleared this frame, so copy them even if empty
+                    if (pass->ic.dispatch_count > 0) {
+                        G_CacheComputePipeline cp
+                          = cache.computePipeline(pass->ic.module, device, NULL);
+                        WGPUComputePassDescriptor cp_desc = {};
+                        cp_desc.label                     = pass->name;
+                        WGPUComputePassEncoder compute_pass
+                          = wgpuCommandEncoderBeginComputePass(command_encoder,
+                                                               &cp_desc);
+                        wgpuComputePassEncoderSetPipeline(compute_pass,
+                                                          cp.val.pipeline);
+
+                        for (u32 d = 0; d < pass->ic.dispatch_count; ++d) {
+                            G_InstanceCullDispatch* dispatch
+                              = ARENA_GET_TYPE(&instance_cull_dispatch_list,
+                                               G_InstanceCullDispatch,
+                                               pass->ic.dispatch_start + d);
+                            WGPUBindGroup bg = cache.bindGroup(
+                              device,
+                              ARENA_GET_TYPE(bind_group_entry_list,
+                                             G_CacheBindGroupEntry,
+                                             dispatch->bg_start),
+                              dispatch->bg_count, cp.val.bind_group_layout, 0,
+                              pass->name);
+                            wgpuComputePassEncoderSetBindGroup(compute_pass, 0, bg,
+                                                               0, NULL);
+                            wgpuComputePassEncoderDispatchWorkgroups(
+                              compute_pass, dispatch->workgroup_count, 1, 1);
+                        }
+
+                        wgpuComputePassEncoderEnd(compute_pass);
+                        WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
+                    }
+
+                    if (pass->ic.stats_readback) {
+                        wgpuCommandEncoderCopyBufferToBuffer(
+                          command_encoder, pass->ic.stats_buffer, 0,
+                          pass->ic.stats_readback, 0, 2 * sizeof(u32));
+                    }
+                } break;
+                case G_PassType_HiZ: {
+                    HiZGenerator_generate(device, command_encoder, pass->hz.depth,
+                                          pass->hz.hiz);
+                } break;
                 default: UNREACHABLE
             }
         }
@@ -2525,6 +3259,7 @@ struct G_Graph {
 
         ZERO_ARRAY(pass_list);
         pass_count = 0;
+        Arena::clear(&instance_cull_dispatch_list);
 
         ZERO_ARRAY(drawcall_list_pool);
         drawcall_list_count = 0;
@@ -33,6 +33,8 @@
 // include for static assert
 #include <type_traits>
 
+#include <glm/gtc/packing.hpp>
+
 // command queue
 struct CQ {
     // command queue lock
@@ -535,6 +537,24 @@ void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count)
     END_COMMAND();
 }
 
+void CQ_PushCommand_GeometrySetLOD(SG_Geometry* geo)
+{
+    BEGIN_COMMAND(SG_Command_GeometrySetLOD, SG_COMMAND_GEO_SET_LOD);
+    command->sg_id  = geo->id;
+    command->levels = geo->lod_levels;
+    command->force  = geo->lod_force;
+    memcpy(command->thresholds, geo->lod_thresholds, sizeof(command->thresholds));
+    END_COMMAND();
+}
+
+void CQ_PushCommand_GeometrySetShared(SG_Geometry* geo)
+{
+    BEGIN_COMMAND(SG_Command_GeometrySetShared, SG_COMMAND_GEO_SET_SHARED);
+    command->sg_id         = geo->id;
+    command->shared_geo_id = geo->shared_geo_id;
+    END_COMMAND();
+}
+
 // Textures ====================================================================
 
 // maybe change to TextureUpdate + lazy creation to support mutable texture
@@ -582,7 +602,12 @@ void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
             CQ_TEXTURE_WRITE(u8, UINT8_MAX);
         } break;
         case WGPUTextureFormat_RGBA16Float: {
-            ASSERT(false); // not impl
+            ASSERT(write_region_num_components <= API->object->array_float_size(ck_array));
+            u16* pixel_data = (u16*)memory;
+            for (int i = 0; i < write_region_num_components; i++) {
+                pixel_data[i]
+                  = glm::packHalf1x16(API->object->array_float_get_idx(ck_array, i));
+            }
         } break;
         case WGPUTextureFormat_R32Float:
         case WGPUTextureFormat_RGBA32Float: {
@@ -628,6 +653,7 @@ void CQ_PushCommand_TextureFromFile(SG_Texture* texture, const char* filepath,
     command->filepath_offset = Arena::offsetOf(cq.write_q, filepath_copy);
     command->flip_vertically = desc->flip_y;
     command->gen_mips        = desc->gen_mips;
+    command->compress        = desc->compress;
     END_COMMAND();
 }
 
@@ -643,6 +669,7 @@ void CQ_PushCommand_TextureFromRawData(SG_Texture* texture, u8* buffer, int buff
     command->buffer_offset   = Arena::offsetOf(cq.write_q, buffer_copy);
     command->flip_vertically = desc->flip_y ? 1 : 0;
     command->gen_mips        = desc->gen_mips ? 1 : 0;
+    command->compress        = desc->compress ? 1 : 0;
     END_COMMAND();
 }
 
@@ -711,6 +738,15 @@ void CQ_PushCommand_CopyTextureToCPU(SG_Texture* texture)
     END_COMMAND();
 }
 
+void CQ_PushCommand_TextureEquirectToCubemap(SG_Texture* equirect, SG_Texture* cubemap)
+{
+    BEGIN_COMMAND(SG_Command_TextureEquirectToCubemap,
+                  SG_COMMAND_TEXTURE_EQUIRECT_TO_CUBEMAP);
+    command->equirect_id = equirect->id;
+    command->cubemap_id  = cubemap->id;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_SaveTexture(SG_Texture* texture, const char* fp,
                                 Chuck_Event* save_event)
 {
@@ -971,6 +1007,14 @@ void CQ_PushCommand_b2World_Set(b2_SimulateDesc desc)
     END_COMMAND();
 }
 
+void CQ_PushCommand_b2Body_Bind(SG_ID sg_id, u64 body_id)
+{
+    BEGIN_COMMAND(SG_Command_b2Body_Bind, SG_COMMAND_b2_BODY_BIND);
+    command->sg_id   = sg_id;
+    command->body_id = body_id;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_BufferUpdate(SG_Buffer* buffer)
 {
     BEGIN_COMMAND(SG_Command_BufferUpdate, SG_COMMAND_BUFFER_UPDATE);
@@ -1085,6 +1129,9 @@ void CQ_PushCommand_WebcamCreate(SG_Webcam* webcam, sr_webcam_device* device)
     command->webcam_texture_id = webcam->texture_id;
     command->device            = device;
     command->device_id         = webcam->device_id;
+    command->width             = webcam->width;
+    command->height            = webcam->height;
+    command->fps               = webcam->fps;
     END_COMMAND();
 }
 
@@ -1094,6 +1141,7 @@ void CQ_PushCommand_WebcamUpdate(SG_Webcam* webcam)
     command->webcam_id = webcam->id;
     command->freeze    = webcam->freeze;
     command->capture   = webcam->capture;
+    command->format    = webcam->format;
     END_COMMAND();
 }
 
@@ -1171,4 +1219,61 @@ void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state)
     END_COMMAND();
 }
 
+void CQ_PushCommand_G2A_TextureLoaded(SG_ID id, bool success, SG_TextureDesc* desc)
+{
+    BEGIN_COMMAND(SG_Command_G2A_TextureLoaded, SG_COMMAND_G2A_TEXTURE_LOADED);
+    command->texture_id = id;
+    command->success    = success;
+    command->desc       = *desc;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_G2A_VideoStats(SG_ID video_id, SG_VideoStats* stats)
+{
+    BEGIN_COMMAND(SG_Command_G2A_VideoStats, SG_COMMAND_G2A_VIDEO_STATS);
+    command->video_id = video_id;
+    command->stats    = *stats;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_G2A_TextBounds(SG_ID text_id, float min_x, float min_y,
+                                   float max_x, float max_y)
+{
+    BEGIN_COMMAND(SG_Command_G2A_TextBounds, SG_COMMAND_G2A_TEXT_BOUNDS);
+    command->text_id = text_id;
+    command->min_x   = min_x;
+    command->min_y   = min_y;
+    command->max_x   = max_x;
+    command->max_y   = max_y;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_G2A_FontStats(u32 font_references)
+{
+    BEGIN_COMMAND(SG_Command_G2A_FontStats, SG_COMMAND_G2A_FONT_STATS);
+    command->font_references = font_references;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_G2A_SceneLightStats(SG_ID scene_id, u32 lights_active,
+                                        u32 lights_uploaded)
+{
+    BEGIN_COMMAND(SG_Command_G2A_SceneLightStats, SG_COMMAND_G2A_SCENE_LIGHT_STATS);
+    command->scene_id        = scene_id;
+    command->lights_active   = lights_active;
+    command->lights_uploaded = lights_uploaded;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_G2A_ScenePassCullStats(SG_ID pass_id, u32 visible_instances,
+                                           u32 occluded_instances)
+{
+    BEGIN_COMMAND(SG_Command_G2A_ScenePassCullStats,
+                  SG_COMMAND_G2A_SCENE_PASS_CULL_STATS);
+    command->pass_id            = pass_id;
+    command->visible_instances  = visible_instances;
+    command->occluded_instances = occluded_instances;
+    END_COMMAND();
+}
+
 #undef cq
@@ -98,6 +98,7 @@ enum SG_CommandType : u32 {
 
     // b2 physics
     SG_COMMAND_b2_WORLD_SET,
+    SG_COMMAND_b2_BODY_BIND,
 
     // components
     SG_COMMAND_COMPONENT_UPDATE_NAME,
@@ -147,6 +148,8 @@ enum SG_CommandType : u32 {
     SG_COMMAND_GEO_SET_VERTEX_COUNT,
     SG_COMMAND_GEO_SET_INDICES_COUNT,
     SG_COMMAND_GEO_SET_INDICES,
+    SG_COMMAND_GEO_SET_LOD,
+    SG_COMMAND_GEO_SET_SHARED,
 
     // texture
     SG_COMMAND_TEXTURE_CREATE,
@@ -157,6 +160,7 @@ enum SG_CommandType : u32 {
     SG_COMMAND_COPY_TEXTURE_TO_TEXTURE,
     SG_COMMAND_COPY_TEXTURE_TO_CPU,
     SG_COMMAND_SAVE_TEXTURE,
+    SG_COMMAND_TEXTURE_EQUIRECT_TO_CUBEMAP,
 
     // buffer
     SG_COMMAND_BUFFER_UPDATE,
@@ -188,6 +192,12 @@ enum SG_CommandType : u32 {
     SG_COMMAND_G2A_TEXTURE_SAVE,
     SG_COMMAND_G2A_GAMEPAD_STATE,
     SG_COMMAND_G2A_GAMEPAD_CONNECT,
+    SG_COMMAND_G2A_TEXTURE_LOADED,
+    SG_COMMAND_G2A_VIDEO_STATS,
+    SG_COMMAND_G2A_TEXT_BOUNDS,
+    SG_COMMAND_G2A_FONT_STATS,
+    SG_COMMAND_G2A_SCENE_LIGHT_STATS,
+    SG_COMMAND_G2A_SCENE_PASS_CULL_STATS,
 
     SG_COMMAND_COUNT
 };
@@ -382,6 +392,18 @@ struct SG_Command_GeoSetIndices : public SG_Command {
     ptrdiff_t indices_offset;
 };
 
+struct SG_Command_GeometrySetLOD : public SG_Command {
+    SG_ID sg_id;
+    int levels;
+    f32 thresholds[CHUGL_GEOMETRY_MAX_LODS - 1];
+    int force;
+};
+
+struct SG_Command_GeometrySetShared : public SG_Command {
+    SG_ID sg_id;
+    SG_ID shared_geo_id; // 0 to draw with its own buffers
+};
+
 struct SG_Command_TextureCreate : public SG_Command {
     SG_ID sg_id;
     SG_TextureDesc desc;
@@ -400,6 +422,7 @@ struct SG_Command_TextureFromFile : public SG_Command {
     ptrdiff_t filepath_offset;
     bool flip_vertically;
     bool gen_mips;
+    bool compress;
 };
 
 struct SG_Command_TextureFromRawData : public SG_Command {
@@ -408,6 +431,7 @@ struct SG_Command_TextureFromRawData : public SG_Command {
     ptrdiff_t buffer_offset;
     b32 flip_vertically;
     b32 gen_mips;
+    b32 compress;
 };
 
 struct SG_Command_CubemapTextureFromFile : public SG_Command {
@@ -435,6 +459,11 @@ struct SG_Command_CopyTextureToCPU : public SG_Command {
     SG_ID id;
 };
 
+struct SG_Command_TextureEquirectToCubemap : public SG_Command {
+    SG_ID equirect_id;
+    SG_ID cubemap_id;
+};
+
 struct SG_Command_SaveTexture : public SG_Command {
     SG_ID id;
     Chuck_Event* save_event;
@@ -539,14 +568,21 @@ struct SG_Command_PassConnect : public SG_Command {
 
 struct b2_SimulateDesc {
     u32 world_id;
-    int substeps = 4;
-    float rate   = 1.0f;
+    int substeps         = 4;
+    float rate           = 1.0f;
+    float fixed_timestep = 0.0f;  // seconds. <= 0 steps once per frame, by frame dt
+    bool threaded        = false; // step on the physics thread, see physics.h
 };
 
 struct SG_Command_b2World_Set : public SG_Command {
     b2_SimulateDesc desc;
 };
 
+struct SG_Command_b2Body_Bind : public SG_Command {
+    SG_ID sg_id;
+    u64 body_id; // b2BodyId, 0 unbinds
+};
+
 // buffer commands -----------------------------------------------------
 
 struct SG_Command_BufferUpdate : public SG_Command {
@@ -607,14 +643,18 @@ typedef struct _sr_webcam_device sr_webcam_device;
 struct SG_Command_WebcamCreate : public SG_Command {
     SG_ID webcam_id;
     SG_ID webcam_texture_id;
-    sr_webcam_device* device;
+    sr_webcam_device* device; // NULL for SG_WEBCAM_DEVICE_SYNTHETIC
     int device_id;
+    int width;
+    int height;
+    int fps;
 };
 
 struct SG_Command_WebcamUpdate : public SG_Command {
     SG_ID webcam_id;
     bool freeze;
     bool capture;
+    SG_WebcamFormat format;
 };
 
 // ============================================================================
@@ -652,6 +692,39 @@ struct SG_Command_G2A_GamepadConnect : public SG_Command {
     char name[128];
 };
 
+// async texture load (decode + upload) finished
+struct SG_Command_G2A_TextureLoaded : public SG_Command {
+    SG_ID texture_id;
+    b32 success;
+    SG_TextureDesc desc; // format / size / mips may change for compressed images
+};
+
+struct SG_Command_G2A_VideoStats : public SG_Command {
+    SG_ID video_id;
+    SG_VideoStats stats;
+};
+
+struct SG_Command_G2A_TextBounds : public SG_Command {
+    SG_ID text_id;
+    float min_x, min_y, max_x, max_y; // layout space, before control points
+};
+
+struct SG_Command_G2A_FontStats : public SG_Command {
+    u32 font_references; // sum of every font's refcount
+};
+
+struct SG_Command_G2A_SceneLightStats : public SG_Command {
+    SG_ID scene_id;
+    u32 lights_active;   // lights that passed frustum culling
+    u32 lights_uploaded; // lights whose LightUniforms were written to the gpu
+};
+
+struct SG_Command_G2A_ScenePassCullStats : public SG_Command {
+    SG_ID pass_id;
+    u32 visible_instances;  // drawn after gpu culling
+    u32 occluded_instances; // in the frustum but behind the previous frame's depth
+};
+
 // ============================================================================
 // Command Queue API
 // ============================================================================
@@ -727,6 +800,8 @@ void CQ_PushCommand_GeometrySetPulledVertexAttribute(SG_Geometry* geo, int locat
                                                      void* data, size_t bytes);
 void CQ_PushCommand_GeometrySetVertexCount(SG_Geometry* geo, int count);
 void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count);
+void CQ_PushCommand_GeometrySetLOD(SG_Geometry* geo);
+void CQ_PushCommand_GeometrySetShared(SG_Geometry* geo);
 
 // texture
 void CQ_PushCommand_TextureCreate(SG_Texture* texture);
@@ -749,6 +824,7 @@ void CQ_PushCommand_CopyTextureToTexture(SG_Texture* dst_texture,
                                          SG_TextureLocation* src_location, int width,
                                          int height, int depth);
 void CQ_PushCommand_CopyTextureToCPU(SG_Texture* texture);
+void CQ_PushCommand_TextureEquirectToCubemap(SG_Texture* equirect, SG_Texture* cubemap);
 void CQ_PushCommand_SaveTexture(SG_Texture* texture, const char* fp,
                                 Chuck_Event* save_event);
 
@@ -782,6 +858,7 @@ void CQ_PushCommand_PassDisconnect(SG_Pass* pass, SG_Pass* next_pass);
 
 // b2
 void CQ_PushCommand_b2World_Set(b2_SimulateDesc desc);
+void CQ_PushCommand_b2Body_Bind(SG_ID sg_id, u64 body_id);
 
 // buffer
 void CQ_PushCommand_BufferUpdate(SG_Buffer* buffer);
@@ -815,4 +892,14 @@ void CQ_PushCommand_G2A_TextureRead(SG_ID id, void* data, int size_bytes,
 void CQ_PushCommand_G2A_TextureSave(Chuck_Event* texture_save_event, int status);
 
 void CQ_PushCommand_G2A_GamepadConnect(int gp_id, int connected, const char* name);
-void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state);
\ No newline at end of file
+void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state);
+void CQ_PushCommand_G2A_TextureLoaded(SG_ID id, bool success, SG_TextureDesc* desc);
+void CQ_PushCommand_G2A_VideoStats(SG_ID video_id, SG_VideoStats* stats);
+void CQ_PushCommand_G2A_TextBounds(SG_ID text_id, float min_x, float min_y,
+                                   float max_x, float max_y);
+void CQ_PushCommand_G2A_FontStats(u32 font_references);
+void CQ_PushCommand_G2A_SceneLightStats(SG_ID scene_id, u32 lights_active,
+                                        u32 lights_uploaded);
+
+void CQ_PushCommand_G2A_ScenePassCullStats(SG_ID pass_id, u32 visible_instances,
+                                           u32 occluded_instances);
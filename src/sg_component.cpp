@@ -33,6 +33,7 @@
 #include "core/log.h"
 #include "ulib_helper.h"
 
+#include <glm/gtc/packing.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <sr_webcam/include/sr_webcam.h>
 
@@ -480,6 +481,7 @@ void SG_Geometry::initGABandNumComponents(GeometryArenaBuilder* b, SG_Geometry*
         Arena::clear(b->norm_arena);
         Arena::clear(b->uv_arena);
         Arena::clear(b->indices_arena);
+        ++g->indices_version;
     }
 
     // set num components
@@ -675,6 +677,7 @@ u32* SG_Geometry::setIndices(SG_Geometry* geo, CK_DL_API API, Chuck_ArrayInt* in
                              int index_count)
 {
     Arena::clear(&geo->indices);
+    ++geo->indices_version;
 
     u32* arena_data = ARENA_PUSH_COUNT(&geo->indices, u32, index_count);
 
@@ -694,6 +697,219 @@ f32* SG_Geometry::getAttributeData(SG_Geometry* geo, int location)
     return (f32*)geo->vertex_attribute_data[location].base;
 }
 
+bool SG_Geometry::optimize(SG_Geometry* geo, f32* acmr_before, f32* acmr_after)
+{
+    // partial draws and pulled vertices depend on the current vertex order
+    if (geo->vertex_count >= 0 || geo->index_count >= 0) return false;
+    for (int i = 0; i < CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS; i++) {
+        if (geo->vertex_pull_buffers[i].curr > 0) return false;
+    }
+
+    u32 vertex_count = SG_Geometry::vertexCount(geo);
+    if (vertex_count == 0) return false;
+
+    // every attribute must have a value per vertex to be reordered with it
+    const u32* attributes[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
+    int num_components[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
+    int locations[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
+    int attribute_count = 0;
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        int n = geo->vertex_attribute_num_components[i];
+        if (n == 0) continue;
+        Arena* arena = &geo->vertex_attribute_data[i];
+        if (ARENA_LENGTH(arena, u32) != (u64)vertex_count * n) return false;
+        attributes[attribute_count]     = (u32*)arena->base;
+        num_components[attribute_count] = n;
+        locations[attribute_count]      = i;
+        attribute_count++;
+    }
+
+    // non-indexed geometry draws vertices in order
+    bool indexed    = SG_Geometry::indexCount(geo) > 0;
+    u32 index_count = indexed ? SG_Geometry::indexCount(geo) : vertex_count;
+    if (index_count % 3 != 0) return false;
+    u32* indices = ALLOCATE_COUNT(u32, index_count);
+    for (u32 i = 0; i < index_count; i++) {
+        indices[i] = indexed ? SG_Geometry::getIndices(geo)[i] : i;
+        if (indices[i] >= vertex_count) {
+            FREE_ARRAY(u32, indices, index_count);
+            return false;
+        }
+    }
+    if (acmr_before) {
+        *acmr_before = Geometry_acmr(indices, index_count, vertex_count,
+                                     GEOMETRY_VERTEX_CACHE_SIZE);
+    }
+
+    // weld. remap[v] <= v, so attributes compact in place
+    u32* remap = ALLOCATE_COUNT(u32, vertex_count);
+    u32 unique_count
+      = Geometry_weldVertices(remap, attributes, num_components, attribute_count,
+                              vertex_count);
+    for (u32 i = 0; i < index_count; i++) indices[i] = remap[indices[i]];
+    for (int a = 0; a < attribute_count; a++) {
+        u32* data = (u32*)attributes[a];
+        int n     = num_components[a];
+        for (u32 v = 0; v < vertex_count; v++) {
+            memmove(data + (u64)remap[v] * n, data + (u64)v * n, n * sizeof(u32));
+        }
+    }
+
+    u32* reordered = ALLOCATE_COUNT(u32, index_count);
+    Geometry_optimizeVertexCache(reordered, indices, index_count, unique_count,
+                                 GEOMETRY_VERTEX_CACHE_SIZE);
+    if (geo->vertex_attribute_num_components[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION]
+        == 3) {
+        Geometry_optimizeOverdraw(
+          indices, reordered, index_count,
+          SG_Geometry::getAttributeData(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION),
+          unique_count, GEOMETRY_VERTEX_CACHE_SIZE);
+    } else {
+        memcpy(indices, reordered, index_count * sizeof(u32));
+    }
+
+    // renumber vertices in the order they are first drawn, dropping unused ones
+    u32 used_count
+      = Geometry_optimizeVertexFetch(remap, indices, index_count, unique_count);
+    FREE_ARRAY(u32, reordered, index_count);
+    for (int a = 0; a < attribute_count; a++) {
+        Arena* arena = &geo->vertex_attribute_data[locations[a]];
+        int n        = num_components[a];
+        u32* src     = (u32*)arena->base;
+        u32* dst     = ALLOCATE_COUNT(u32, (u64)used_count * n);
+        for (u32 v = 0; v < unique_count; v++) {
+            if (remap[v] == UINT32_MAX) continue;
+            memcpy(dst + (u64)remap[v] * n, src + (u64)v * n, n * sizeof(u32));
+        }
+        memcpy(src, dst, (u64)used_count * n * sizeof(u32));
+        Arena::pop(arena, ((u64)vertex_count - used_count) * n * sizeof(u32));
+        FREE_ARRAY(u32, dst, (u64)used_count * n);
+    }
+
+    Arena::clear(&geo->indices);
+    memcpy(ARENA_PUSH_COUNT(&geo->indices, u32, index_count), indices,
+           index_count * sizeof(u32));
+    ++geo->indices_version;
+    if (acmr_after) {
+        *acmr_after
+          = Geometry_acmr(indices, index_count, used_count, GEOMETRY_VERTEX_CACHE_SIZE);
+    }
+
+    FREE_ARRAY(u32, remap, vertex_count);
+    FREE_ARRAY(u32, indices, index_count);
+    return true;
+}
+
+// triangle list for the topology functions, NULL if non-indexed
+static const u32* SG_Geometry_triangles(SG_Geometry* geo, u32* index_count)
+{
+    *index_count = SG_Geometry::indexCount(geo);
+    if (*index_count > 0) return SG_Geometry::getIndices(geo);
+    *index_count = SG_Geometry::vertexCount(geo);
+    return NULL;
+}
+
+// resizes the attribute at location to num_components per vertex. Returns false
+// if it had to, since its previous data is then lost
+static bool SG_Geometry_fitAttribute(SG_Geometry* geo, int location, int num_components)
+{
+    Arena* arena = &geo->vertex_attribute_data[location];
+    u64 length   = (u64)SG_Geometry::vertexCount(geo) * num_components;
+    if (geo->vertex_attribute_num_components[location] == num_components
+        && ARENA_LENGTH(arena, f32) == length)
+        return true;
+
+    Arena::clear(arena);
+    ARENA_PUSH_COUNT(arena, f32, length);
+    geo->vertex_attribute_num_components[location] = num_components;
+    return false;
+}
+
+const GeometryTopology* SG_Geometry::getTopology(SG_Geometry* geo)
+{
+    u32 index_count;
+    const u32* indices = SG_Geometry_triangles(geo, &index_count);
+    u32 vertex_count   = SG_Geometry::vertexCount(geo);
+
+    // non-indexed topology only depends on the vertex count
+    GeometryTopology* topo = &geo->topology;
+    if (topo->offsets && topo->vertex_count == vertex_count
+        && topo->index_count == index_count - index_count % 3
+        && topo->index_version == geo->indices_version)
+        return topo;
+
+    GeometryTopology_build(topo, indices, index_count, vertex_count);
+    topo->index_version = geo->indices_version;
+    return topo;
+}
+
+bool SG_Geometry::computeNormals(SG_Geometry* geo, const u32* vertices, u32 count)
+{
+    u32 vertex_count = SG_Geometry::vertexCount(geo);
+    if (vertex_count == 0
+        || geo->vertex_attribute_num_components[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION]
+             != 3)
+        return false;
+
+    const GeometryTopology* topo = SG_Geometry::getTopology(geo);
+    u32 index_count;
+    const u32* indices = SG_Geometry_triangles(geo, &index_count);
+
+    // a partial update keeps the other normals, so they must exist
+    if (!SG_Geometry_fitAttribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3)) {
+        vertices = NULL;
+    }
+    Geometry_computeNormals(
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION),
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION),
+      indices, topo, vertices, vertices ? count : vertex_count);
+    return true;
+}
+
+bool SG_Geometry::computeTangents(SG_Geometry* geo, const u32* vertices, u32 count)
+{
+    u32 vertex_count = SG_Geometry::vertexCount(geo);
+    if (vertex_count == 0) return false;
+    const int required_components[] = { 3, 3, 2 };
+    const int required_locations[]  = { SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION,
+                                        SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION,
+                                        SG_GEOMETRY_UV_ATTRIBUTE_LOCATION };
+    for (int i = 0; i < ARRAY_LENGTH(required_locations); i++) {
+        int location = required_locations[i];
+        int n        = required_components[i];
+        if (geo->vertex_attribute_num_components[location] != n
+            || ARENA_LENGTH(&geo->vertex_attribute_data[location], f32)
+                 != (u64)vertex_count * n)
+            return false;
+    }
+
+    const GeometryTopology* topo = SG_Geometry::getTopology(geo);
+    u32 index_count;
+    const u32* indices = SG_Geometry_triangles(geo, &index_count);
+
+    if (!SG_Geometry_fitAttribute(geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION, 4)) {
+        vertices = NULL;
+    }
+    Geometry_computeTangents(
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION),
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION),
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION),
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION), indices,
+      topo, vertices, vertices ? count : vertex_count);
+    return true;
+}
+
+u32 SG_Geometry::movedVertices(SG_Geometry* geo, const f32* prev_positions, u32* dst)
+{
+    const GeometryTopology* topo = SG_Geometry::getTopology(geo);
+    u32 index_count;
+    const u32* indices = SG_Geometry_triangles(geo, &index_count);
+    return Geometry_movedNeighborhood(
+      dst, topo, indices,
+      SG_Geometry::getAttributeData(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION),
+      prev_positions);
+}
+
 // ============================================================================
 // SG_Mesh
 // ============================================================================
@@ -909,16 +1125,27 @@ SG_Scene* SG_CreateScene(Chuck_Object* ckobj)
     return scene;
 }
 
-SG_Geometry* SG_CreateGeometry(Chuck_Object* ckobj)
+static void _SG_GeometryInit(SG_Geometry* geo)
 {
-    Arena* arena      = &SG_GeoArena;
-    size_t offset     = arena->curr;
-    SG_Geometry* geo  = ARENA_PUSH_ZERO_TYPE(arena, SG_Geometry);
     geo->vertex_count = -1;
     geo->index_count  = -1;
+    geo->lod_levels   = 1;
+    geo->lod_force    = -1;
+    // level i + 1 is drawn below 0.5 / 2^i of the screen height
+    for (int i = 0; i < ARRAY_LENGTH(geo->lod_thresholds); i++) {
+        geo->lod_thresholds[i] = 0.5f / (1 << i);
+    }
+
+    geo->id   = SG_GetNewComponentID();
+    geo->type = SG_COMPONENT_GEOMETRY;
+}
 
-    geo->id    = SG_GetNewComponentID();
-    geo->type  = SG_COMPONENT_GEOMETRY;
+SG_Geometry* SG_CreateGeometry(Chuck_Object* ckobj)
+{
+    Arena* arena     = &SG_GeoArena;
+    size_t offset    = arena->curr;
+    SG_Geometry* geo = ARENA_PUSH_ZERO_TYPE(arena, SG_Geometry);
+    _SG_GeometryInit(geo);
     geo->ckobj = ckobj;
 
     // store in map
@@ -928,6 +1155,14 @@ SG_Geometry* SG_CreateGeometry(Chuck_Object* ckobj)
     return geo;
 }
 
+SG_Geometry* SG_CreateHiddenGeometry()
+{
+    SG_Geometry* geo = ALLOCATE_TYPE(SG_Geometry);
+    *geo             = {};
+    _SG_GeometryInit(geo);
+    return geo;
+}
+
 SG_Texture* SG_CreateTexture(SG_TextureDesc* desc, Chuck_Object* ckobj,
                              Chuck_VM_Shred* shred, bool add_ref, const char* name)
 {
@@ -1256,42 +1491,43 @@ SG_Webcam* SG_CreateWebcam(Chuck_Object* ckobj, Chuck_VM_Shred* shred, int devic
         webcam->texture_id         = webcam_texture->id;
         webcam->device_id          = device_id;
 
-        // bounds check (hardcoded to 8 webcams)
-        if (device_id >= 8) {
-            log_warn(
-              "only webcam device ids 0-7 are supported. Defaulting to magenta "
-              "texture");
-            return webcam;
-        }
+        sr_webcam_device* device = NULL;
+        if (device_id == SG_WEBCAM_DEVICE_SYNTHETIC) {
+            // frames are generated on the graphics side, nothing to open
+            webcam->width  = MAX(width, 1);
+            webcam->height = MAX(height, 1);
+            webcam->fps    = MAX(fps, 1);
+            strncpy(webcam->device_name, "ChuGL Synthetic Webcam",
+                    sizeof(webcam->device_name));
+        } else {
+            sr_webcam_create(&device, device_id);
+            sr_webcam_set_format(device, width, height, fps);
+
+            /*
+            on macos, sr_webcam_delete causes segfault.
+            furthermore, openning the same webcam multiple times, even if closing the
+            earlier opens, causes webcam framerate to half from 30 -> 15. Probably an
+            implementation bug in sr_webcam. workaround: given a webcam id, only ever
+            open it once on the audio thread, and pass it to the graphics thread over
+            the command queue.
+            */
+            if (sr_webcam_open(device) != 0) {
+                log_warn("could not open webcam device %d. defaulting to magenta texture",
+                         device_id);
+                return webcam;
+            }
 
-        sr_webcam_device* device;
-        sr_webcam_create(&device, device_id);
-        sr_webcam_set_format(device, width, height, fps);
-        int webcam_open_success = sr_webcam_open(device) == 0;
-
-        /*
-        on macos, sr_webcam_delete causes segfault.
-        furthermore, openning the same webcam multiple times, even if closing the
-        earlier opens, causes webcam framerate to half from 30 -> 15. Probably an
-        implementation bug in sr_webcam. workaround: given a webcam id, only ever open
-        it once on the audio thread, and pass it to the graphics thread over the command
-        queue.
-        */
-
-        if (!webcam_open_success) {
-            log_warn("could not open webcam device %d. defaulting to magenta texture",
-                     device_id);
-        } else { // successful
             // Get back video parameters.
-            int vidW, vidH, vidFps;
-            sr_webcam_get_dimensions(device, &vidW, &vidH);
-            sr_webcam_get_framerate(device, &vidFps);
-            webcam->fps = vidFps;
+            sr_webcam_get_dimensions(device, &webcam->width, &webcam->height);
+            sr_webcam_get_framerate(device, &webcam->fps);
+            strncpy(webcam->device_name, sr_webcam_get_user_friendly_name(device),
+                    sizeof(webcam->device_name));
+        }
 
-            // if successful, create webcam texture
+        { // successful, create webcam texture
             SG_TextureDesc desc = {};
-            desc.width          = vidW;
-            desc.height         = vidH;
+            desc.width          = webcam->width;
+            desc.height         = webcam->height;
             desc.dimension      = WGPUTextureDimension_2D;
             desc.format         = WGPUTextureFormat_RGBA8Unorm;
             desc.usage          = WGPUTextureUsage_All;
@@ -1299,8 +1535,6 @@ SG_Webcam* SG_CreateWebcam(Chuck_Object* ckobj, Chuck_VM_Shred* shred, int devic
 
             webcam_texture     = SG_CreateTexture(&desc, NULL, shred, true);
             webcam->texture_id = webcam_texture->id;
-            strncpy(webcam->device_name, sr_webcam_get_user_friendly_name(device),
-                    sizeof(webcam->device_name));
 
             // if successful, create graphics component
             CQ_PushCommand_WebcamCreate(webcam, device);
@@ -1506,9 +1740,39 @@ static void _SG_ComponentManagerFree(SG_ID id, int component_size)
     UNUSED_VAR(delete_result);
 }
 
+// SG_Text holds std::strings, which can't be moved with the memcpy in
+// _SG_ComponentManagerFree. Swap-deletes with a move instead
+static void _SG_TextFree(SG_Text* text)
+{
+    SG_ID id = text->id;
+
+    // a collected GText has no parent or children, both would hold a reference
+    ASSERT(text->parentID == 0);
+    Arena::free(&text->childrenIDs);
+
+    // release the refs taken by SG_Mesh::setMaterial / setGeometry
+    SG_DecrementRef(text->_mat_id);
+    SG_DecrementRef(text->_geo_id);
+
+    SG_Text* last = ARENA_GET_LAST_TYPE(&SG_TextArena, SG_Text);
+    if (text != last) {
+        *text              = std::move(*last);
+        SG_Location* moved = (SG_Location*)hashmap_get(locator, &text->id);
+        ASSERT(moved && moved->arena == &SG_TextArena);
+        moved->offset = Arena::offsetOf(&SG_TextArena, text);
+    }
+    last->~SG_Text();
+    ARENA_POP_TYPE(&SG_TextArena, SG_Text);
+
+    const void* delete_result = hashmap_delete(locator, &id);
+    ASSERT(delete_result);
+    UNUSED_VAR(delete_result);
+}
+
 void SG_ComponentFree(SG_Component* comp)
 {
     // chugl v0.2.3 10/30/24 azaday: only implementing gc for shader class
+    // (and GText, so the renderer can release its font)
     switch (comp->type) {
         case SG_COMPONENT_SHADER: {
             // push free command
@@ -1519,6 +1783,15 @@ void SG_ComponentFree(SG_Component* comp)
             SG_Shader::free((SG_Shader*)comp);
             _SG_ComponentManagerFree(comp->id, sizeof(SG_Shader));
         } break;
+        case SG_COMPONENT_MESH: {
+            // only GText meshes are collected, other meshes are kept alive
+            SG_Location* loc = (SG_Location*)hashmap_get(locator, &comp->id);
+            if (loc->arena != &SG_TextArena) break;
+
+            CQ_PushCommand_ComponentFree(comp);
+            log_trace("freeing text %d", comp->id);
+            _SG_TextFree((SG_Text*)comp);
+        } break;
         default: break; // TODO impl other types
     }
 }
@@ -1772,6 +2045,13 @@ void SG_Texture::updateTextureData(SG_Texture* texture, void* data, int data_siz
                 g_chuglAPI->object->array_float_push_back(ck_arr, arr[i] / 255.0f);
             }
         } break;
+        case WGPUTextureFormat_RGBA16Float: {
+            u16* arr = (u16*)data;
+            for (int i = 0; i < num_texels * num_components; i++) {
+                g_chuglAPI->object->array_float_push_back(ck_arr,
+                                                          glm::unpackHalf1x16(arr[i]));
+            }
+        } break;
         case WGPUTextureFormat_RGBA32Float:
         case WGPUTextureFormat_R32Float: {
             f32* arr = (f32*)data;
@@ -175,6 +175,15 @@ struct SG_TextureDesc {
     int height                       = 1;
     int depth                        = 1;
     b32 gen_mips                     = 1L;
+    // textures loaded with their own mip chain (KTX2/DDS) set this, otherwise 0
+    // and the count follows gen_mips
+    int mip_levels = 0;
+
+    static u32 mipLevelCount(SG_TextureDesc* desc, u32 width, u32 height)
+    {
+        if (desc->mip_levels > 0) return desc->mip_levels;
+        return desc->gen_mips ? G_mipLevels(width, height) : 1;
+    }
 };
 
 struct SG_TextureWriteDesc {
@@ -195,6 +204,10 @@ struct SG_TextureLoadDesc {
     bool gen_mips         = true;
     bool read_to_ck_array = false; // on audio thread, during load also read data into
                                    // Texture.data() ck array
+    // Undefined picks RGBA16Float for hdr and 16-bit images, RGBA8Unorm otherwise
+    WGPUTextureFormat format = WGPUTextureFormat_Undefined;
+    // transcode 8-bit images to BC1/BC3 through the on-disk TextureCache
+    bool compress = false;
 };
 
 struct SG_TextureLocation {
@@ -225,6 +238,10 @@ struct SG_Texture : SG_Component {
     Chuck_ArrayFloat* texture_data;
     Chuck_Event* texture_read_event;
 
+    // async loading from Texture.load(), cleared by SG_COMMAND_G2A_TEXTURE_LOADED
+    b32 loading;
+    Chuck_Event* texture_loaded_event; // created on first call to Texture.loaded()
+
     static void updateTextureData(SG_Texture* texture, void* data, int data_size_bytes);
 };
 
@@ -303,6 +320,10 @@ struct SG_Scene : public SG_Transform {
     SG_SceneDesc desc;
     Arena light_ids;
 
+    // light stats from the last rendered frame, updated by the render thread
+    u32 lights_active;
+    u32 lights_uploaded;
+
     // bookkeeping for automatic update (to prevent multiple updates per frame)
     i64 last_auto_update_frame = 0;
 
@@ -366,6 +387,7 @@ union SG_GeometryParams {
 #define SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION 0
 #define SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION 1
 #define SG_GEOMETRY_UV_ATTRIBUTE_LOCATION 2
+#define SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION 3
 
 #define CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS 4
 
@@ -384,6 +406,22 @@ struct SG_Geometry : SG_Component {
     int vertex_count = -1;
     int index_count  = -1;
 
+    // hidden geometry whose GPU buffers this one draws with. Set while a built-in
+    // geometry shares identical data, cleared on edit. see ulib_geometry_build
+    SG_ID shared_geo_id;
+
+    // LOD chain, simplified by the renderer. see R_Geometry
+    int lod_levels;
+    f32 lod_thresholds[CHUGL_GEOMETRY_MAX_LODS - 1];
+    int lod_force;
+
+    // vertex -> face adjacency, rebuilt lazily when the indices or vertex count
+    // change. see SG_Geometry::getTopology
+    GeometryTopology topology;
+    u32 indices_version; // bumped whenever the indices are replaced
+    // recompute normals (and tangents, if present) when positions are set
+    bool auto_normals;
+
     static u32 vertexCount(SG_Geometry* geo);
     static u32 indexCount(SG_Geometry* geo);
 
@@ -397,6 +435,30 @@ struct SG_Geometry : SG_Component {
 
     static f32* getAttributeData(SG_Geometry* geo, int location);
 
+    // welds duplicate vertices and reorders indices and vertices for the vertex
+    // cache, overdraw and vertex fetch. Non-indexed triangles become indexed.
+    // Returns false and leaves the geometry untouched if it uses vertex pulling,
+    // partial draw counts, or attributes with mismatched lengths
+    static bool optimize(SG_Geometry* geo, f32* acmr_before, f32* acmr_after);
+
+    // topology of the current triangles, only rebuilt if they changed since the
+    // last call
+    static const GeometryTopology* getTopology(SG_Geometry* geo);
+
+    // smooth normals from the positions, written to the normal attribute. If
+    // vertices is non-NULL only those count vertices are updated, which requires
+    // normals to already exist. Returns false if positions aren't vec3
+    static bool computeNormals(SG_Geometry* geo, const u32* vertices, u32 count);
+
+    // vec4 tangents at SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION from positions,
+    // normals and uvs. vertices and count as in computeNormals. Returns false if
+    // any of those attributes is missing
+    static bool computeTangents(SG_Geometry* geo, const u32* vertices, u32 count);
+
+    // vertices whose normals and tangents change when positions were previously
+    // prev_positions. dst holds vertexCount() entries. Returns the count written
+    static u32 movedVertices(SG_Geometry* geo, const f32* prev_positions, u32* dst);
+
     // builder functions
     static void initGABandNumComponents(GeometryArenaBuilder* b, SG_Geometry* g,
                                         bool clear);
@@ -420,6 +482,7 @@ struct SG_ShaderIncludes {
     bool lit;          // if true, renderer will pass lighting storage buffer
     bool uses_env_map; // if true, renderer will pass env map texture
     bool shadows;      // if true, renderer will pass shadow params
+    bool clustered;    // if true, renderer will pass the camera's light cluster grid
 };
 
 struct SG_Shader : SG_Component {
@@ -807,6 +870,10 @@ struct SG_Text : public SG_Mesh {
     float width;
     SG_Text_AlignmentType alignment;
     float size = 1.0f;
+
+    // (min x, min y, max x, max y) of the laid out text, written back by the
+    // renderer after each rebuild. Does not include control points
+    t_CKVEC4 bounds = {};
 };
 
 // ============================================================================
@@ -847,6 +914,10 @@ struct SG_Pass : public SG_Component {
     SG_ID scene_id;
     SG_ID camera_id;
     b32 scene_pass_msaa;
+    b32 scene_pass_gpu_culling;        // frustum cull opaque instances on the gpu
+    b32 scene_pass_occlusion_culling;  // also cull against last frame's depth (Hi-Z)
+    u32 scene_pass_visible_instances;  // of the last gpu culled frame read back
+    u32 scene_pass_occluded_instances; // of the last gpu culled frame read back
 
     // ScreenPass params
     SG_ID screen_material_id; // created implicitly, material.pos.shader_id =
@@ -929,6 +1000,14 @@ struct SG_LightDesc {
         float size  = 20.0f;
         float depth = 500.0f; // far - near
     } dirlight_shadow_bounds;
+
+    // dirlight cascaded shadows. with more than 1 cascade, the cascades cover the
+    // first `distance` units in front of the camera instead of a fixed
+    // dirlight_shadow_bounds.size square around the light
+    struct {
+        int count      = 1; // 1 to CHUGL_MAX_SHADOW_CASCADES
+        float distance = 100.0f;
+    } dirlight_shadow_cascades;
 };
 
 struct SG_Light : public SG_Transform {
@@ -952,6 +1031,20 @@ struct SG_Light : public SG_Transform {
 // SG Video
 // ============================================================================
 
+// sent periodically by the graphics thread, see R_Video::update()
+struct SG_VideoStats {
+    float decode_ms;     // average time to decode one frame, recent frames only
+    float decode_ms_max; // slowest frame decode, recent frames only
+    int frames_decoded;
+    int frames_dropped; // decoded but skipped because playback was ahead
+    int frames_queued;  // decoded frames waiting to be presented
+
+    // set once when playback turns forward again after reverse. stream_time is
+    // where the graphics thread restarted decoding, audio resumes from there
+    bool resync;
+    double stream_time;
+};
+
 struct SG_Video : public SG_Component {
     plm_t* plm;
     const char* path_OWNED; // malloced, must free
@@ -966,6 +1059,13 @@ struct SG_Video : public SG_Component {
     plm_samples_t* samples;
     float last_audio_samples[2]; // last audio samples (left/right channel) from
                                  // previous audio frame. used for interpolation
+    double reverse_secs; // video time travelled at negative rates, audio is
+                         // paused meanwhile and resynced on playing forward
+    bool awaiting_resync; // forward again, muted until SG_VideoStats::resync
+    double resync_secs;   // video time travelled while awaiting the resync
+
+    // graphics thread decoding
+    SG_VideoStats stats;
 
     // get length of video in samples
     static int audioFrames(SG_Video* video)
@@ -978,12 +1078,26 @@ struct SG_Video : public SG_Component {
 // webcam
 // ============================================================================
 
+// pixel layout frames are uploaded in, converted to RGBA on the GPU
+enum SG_WebcamFormat : u8 {
+    SG_WEBCAM_FORMAT_RGBA = 0, // 4 bytes per pixel, no conversion
+    SG_WEBCAM_FORMAT_YUYV,     // packed 4:2:2, 2 bytes per pixel
+    SG_WEBCAM_FORMAT_NV12,     // Y plane + interleaved 4:2:0 CbCr plane, 1.5 bytes per pixel
+    SG_WEBCAM_FORMAT_COUNT
+};
+
+// device id of a generated test pattern, for testing without a camera
+#define SG_WEBCAM_DEVICE_SYNTHETIC -2
+
 struct SG_Webcam : public SG_Component {
     SG_ID texture_id;
     int device_id;
+    int width;
+    int height;
     int fps;
     bool freeze;
     bool capture = true;
+    SG_WebcamFormat format;
     char device_name[64];
 };
 
@@ -997,6 +1111,9 @@ void SG_Free();
 SG_Transform* SG_CreateTransform(Chuck_Object* ckobj);
 SG_Scene* SG_CreateScene(Chuck_Object* ckobj);
 SG_Geometry* SG_CreateGeometry(Chuck_Object* ckobj);
+// not owned by a ChucK object and not findable by id on the audio thread, only
+// the renderer knows it. Holds the data shared by identical built-in geometries
+SG_Geometry* SG_CreateHiddenGeometry();
 SG_Texture* SG_CreateTexture(SG_TextureDesc* desc, Chuck_Object* ckobj,
                              Chuck_VM_Shred* shred, bool add_ref,
                              const char* name = NULL);
@@ -74,6 +74,13 @@ struct FrameUniforms {
     glm::ivec2 mouse_click; // at byte offset 272
     float sample_rate;      // at byte offset 280
     float _pad1;
+
+    // clustered lighting
+    glm::mat4x4 projection_inverse; // at byte offset 288
+    float cluster_near;             // at byte offset 352
+    float cluster_far;              // at byte offset 356
+    int32_t cluster_log_depth;      // at byte offset 360
+    int32_t num_active_lights;      // at byte offset 364
 };
 
 void FrameUniforms_ZeroCameraFields(FrameUniforms* f)
@@ -82,13 +89,18 @@ void FrameUniforms_ZeroCameraFields(FrameUniforms* f)
     f->view                                   = {};
     f->projection_view_inverse_no_translation = {};
     f->camera_pos                             = {};
+    f->projection_inverse                     = {};
+    f->cluster_near                           = 0;
+    f->cluster_far                            = 0;
+    f->cluster_log_depth                      = 0;
 }
 
 void FrameUniforms_ZeroLightingFields(FrameUniforms* f)
 {
     f->ambient_light    = {};
-    f->num_lights       = 0;
-    f->background_color = {};
+    f->num_lights        = 0;
+    f->background_color  = {};
+    f->num_active_lights = 0;
 }
 
 struct LightUniforms {
@@ -106,8 +118,11 @@ struct LightUniforms {
     glm::mat4x4 proj_view;     // at byte offset 64
     int32_t generates_shadows; // at byte offset 128
     int32_t shadow_map_idx;    // at byte offset 132
-    float bias;
-    float _pad1[1];
+    float bias;                // at byte offset 136
+    int32_t cascade_count;     // at byte offset 140
+    // directional shadow cascades as
+    // (light space center xy, half size, camera depth covered)
+    glm::vec4 cascades[CHUGL_MAX_SHADOW_CASCADES]; // at byte offset 144
 };
 
 struct DrawUniforms {
@@ -118,6 +133,23 @@ struct DrawUniforms {
     float _pad0[2];
 };
 
+// per (material, geometry) draw of a gpu culled ScenePass
+struct InstanceCullParams {
+    glm::vec4 bounding_sphere; // at byte offset 0, geometry space. w < 0 is unbounded
+    uint32_t instance_count;   // at byte offset 16
+    uint32_t draw_args_idx;    // at byte offset 20, index of the indirect args
+    uint32_t _pad0[2];
+};
+
+// per gpu culled ScenePass, tests instances against the previous frame's Hi-Z
+struct OcclusionCullParams {
+    glm::mat4 prev_projection_view; // at byte offset 0
+    glm::vec4 viewport;             // at byte offset 64, in hi-z mip 0 texels
+    uint32_t mip_count;             // at byte offset 80
+    uint32_t enabled;               // at byte offset 84, 0 if there is no pyramid yet
+    uint32_t _pad0[2];
+};
+
 struct b2_DebugDraw_SolidPolygon {
     glm::vec4 transform; // at byte offset 0
     glm::vec4 points12;  // at byte offset 16
@@ -155,7 +187,14 @@ static std::unordered_map<std::string, std::string> shader_table = {
             frame_count: i32,       // frames since window was opened
             mouse: vec2f,           // normalized mouse coords (range 0-1, (0,0) is bottom left)
             mouse_click: vec2i,     // mouse click state
-            sample_rate: f32        // chuck VM sound sample rate (e.g. 44100)
+            sample_rate: f32,       // chuck VM sound sample rate (e.g. 44100)
+
+            // clustered lighting params (only set in ScenePass)
+            projection_inverse: mat4x4f,
+            cluster_near: f32,      // view-space depth of the first cluster slice
+            cluster_far: f32,       // view-space depth of the last cluster slice
+            cluster_log_depth: i32, // 1 if slices are spaced logarithmically (perspective)
+            num_active_lights: i32, // length of the culled light list
         };
                 
 
@@ -191,14 +230,75 @@ static std::unordered_map<std::string, std::string> shader_table = {
             // shadow info
             proj_view: mat4x4f,
             generates_shadows: i32,
-            shadow_map_array_layer: i32,
+            shadow_map_array_layer: i32, // first layer, point lights use 6 and dirlights 1 per cascade
             bias: f32,
+            cascade_count: i32,
+            cascades: array<vec4f, 4>, // (light space center xy, half size, camera depth covered)
         };
 
         @group(0) @binding(1) var<storage, read> u_lights: array<LightUniforms>;
 
         )glsl"
     },
+    { // clustered lighting grid layout, shared by the cluster build and lit shaders
+        "LIGHT_CLUSTER_PARAMS",
+        R"glsl(
+
+        // must match CHUGL_LIGHT_CLUSTER_* in chugl_defines.h
+        const LIGHT_CLUSTER_X = 16u;
+        const LIGHT_CLUSTER_Y = 9u;
+        const LIGHT_CLUSTER_Z = 24u;
+        const LIGHT_CLUSTER_MAX_LIGHTS = 63u;
+        // each cluster is a light count followed by up to MAX_LIGHTS indices into u_lights
+        const LIGHT_CLUSTER_STRIDE = 64u;
+
+        // view-space depth (positive, distance in front of camera) of slice boundary k
+        fn lightClusterSliceDepth(k : u32) -> f32 {
+            let t = f32(k) / f32(LIGHT_CLUSTER_Z);
+            if (u_frame.cluster_log_depth != 0) {
+                return u_frame.cluster_near * pow(u_frame.cluster_far / u_frame.cluster_near, t);
+            }
+            return mix(u_frame.cluster_near, u_frame.cluster_far, t);
+        }
+
+        fn lightClusterSlice(view_depth : f32) -> u32 {
+            var t = 0.0;
+            if (u_frame.cluster_log_depth != 0) {
+                t = log(max(view_depth, u_frame.cluster_near) / u_frame.cluster_near) 
+                    / log(u_frame.cluster_far / u_frame.cluster_near);
+            } else {
+                t = (view_depth - u_frame.cluster_near) / (u_frame.cluster_far - u_frame.cluster_near);
+            }
+            return u32(clamp(t * f32(LIGHT_CLUSTER_Z), 0.0, f32(LIGHT_CLUSTER_Z - 1u)));
+        }
+
+        )glsl"
+    },
+    { // per-camera light lists built by the light cluster pass
+        "LIGHT_CLUSTER_UNIFORMS",
+        R"glsl(
+
+        #include LIGHT_CLUSTER_PARAMS
+
+        @group(0) @binding(6) var<storage, read> u_light_clusters: array<u32>;
+
+        // returns the offset into u_light_clusters of the cluster containing worldpos.
+        // u_light_clusters[offset] is the light count, followed by the light indices
+        fn lightCluster(worldpos : vec3f) -> u32 {
+            let view_pos = u_frame.view * vec4f(worldpos, 1.0);
+            let clip_pos = u_frame.projection * view_pos;
+            let grid = vec2f(f32(LIGHT_CLUSTER_X), f32(LIGHT_CLUSTER_Y));
+            let tile = vec2u(clamp(
+                (clip_pos.xy / clip_pos.w * 0.5 + 0.5) * grid, 
+                vec2f(0.0), 
+                grid - 1.0
+            ));
+            let slice = lightClusterSlice(-view_pos.z);
+            return ((slice * LIGHT_CLUSTER_Y + tile.y) * LIGHT_CLUSTER_X + tile.x) * LIGHT_CLUSTER_STRIDE;
+        }
+
+        )glsl"
+    },
     { // for environment mapping
         "ENVIRONMENT_MAP_UNIFORMS",
         R"glsl(
@@ -531,6 +631,7 @@ static const char* phong_shader_string = R"glsl(
 
     #include FRAME_UNIFORMS
     #include LIGHTING_UNIFORMS
+    #include LIGHT_CLUSTER_UNIFORMS
     #include ENVIRONMENT_MAP_UNIFORMS
     #include DRAW_UNIFORMS
     #include STANDARD_VERTEX_INPUT
@@ -540,6 +641,7 @@ static const char* phong_shader_string = R"glsl(
     @group(0) @binding(3) var shadow_sampler: sampler_comparison;
     @group(0) @binding(4) var spot_shadow_map_array: texture_depth_2d_array;
     @group(0) @binding(5) var dir_shadow_map_array: texture_depth_2d_array;
+    @group(0) @binding(8) var point_shadow_map_array: texture_depth_2d_array;
 
     @group(1) @binding(0) var<uniform> u_specular_color : vec3f;
     @group(1) @binding(1) var<uniform> u_diffuse_color : vec4f;
@@ -602,56 +704,84 @@ static const char* phong_shader_string = R"glsl(
             p.xy * vec2(0.5, -0.5) + vec2(0.5),
             p.z
         );
+        return sampleShadowPCF(spot_shadow_map_array, p, layer, bias);
+    }
 
-        // Percentage-closer filtering. Sample texels in the region
-        // to smooth the result.
+    // Percentage-closer filtering. Sample the 3x3 texels around p.xy
+    // on one layer of a shadow map array to smooth the result
+    fn sampleShadowPCF(shadow_map: texture_depth_2d_array, p: vec3f, layer: i32, bias: f32) -> f32 {
         var visibility = 0.0;
-        let oneOverShadowDepthTextureSize = 1.0 / f32(textureDimensions(spot_shadow_map_array).x);
+        let oneOverShadowDepthTextureSize = 1.0 / f32(textureDimensions(shadow_map).x);
         for (var y = -1; y <= 1; y++) {
             for (var x = -1; x <= 1; x++) {
                 let offset = vec2<f32>(vec2(x, y)) * oneOverShadowDepthTextureSize;
-
-                visibility += textureSampleCompare(
-                    spot_shadow_map_array, shadow_sampler,
+                visibility += textureSampleCompareLevel(
+                    shadow_map, shadow_sampler,
                     p.xy + offset, // coords
                     layer, // array layer
                     p.z - bias // shadowBias
                 );
             }
         }
-        visibility /= 9.0;
-
-        return visibility;
+        return visibility / 9.0;
     }
 
-    fn calculateDirShadow(worldpos: vec3f, layer: i32, proj_view: mat4x4f, bias: f32) -> f32 {
-        let shadow_coord = proj_view * vec4f(worldpos, 1.0);
-        var p = shadow_coord.xyz / shadow_coord.w;
+    // proj_view maps into a unit light space square, each cascade is a sub-square of it.
+    // use the finest cascade that contains the fragment, falling back to the last one
+    fn calculateDirShadow(worldpos: vec3f, light: LightUniforms) -> f32 {
+        let shadow_coord = light.proj_view * vec4f(worldpos, 1.0);
+        let margin = 1.0 - 2.0 / f32(textureDimensions(dir_shadow_map_array).x);
+        var cascade = light.cascade_count - 1;
+        for (var c = 0; c < light.cascade_count - 1; c++) {
+            let ndc = (shadow_coord.xy - light.cascades[c].xy) / light.cascades[c].z;
+            if (all(abs(ndc) < vec2f(margin))) {
+                cascade = c;
+                break;
+            }
+        }
+        let ndc = (shadow_coord.xy - light.cascades[cascade].xy) / light.cascades[cascade].z;
         // Y is flipped because texture coords are Y-down.
-        p = vec3(
-            p.xy * vec2(0.5, -0.5) + vec2(0.5),
-            p.z
-        );
+        let p = vec3(ndc * vec2(0.5, -0.5) + vec2(0.5), shadow_coord.z);
+        return sampleShadowPCF(dir_shadow_map_array, p, light.shadow_map_array_layer + cascade, light.bias);
+    }
 
-        // Percentage-closer filtering. Sample texels in the region
-        // to smooth the result.
-        var visibility = 0.0;
-        let oneOverShadowDepthTextureSize = 1.0 / f32(textureDimensions(dir_shadow_map_array).x);
-        for (var y = -1; y <= 1; y++) {
-            for (var x = -1; x <= 1; x++) {
-                let offset = vec2<f32>(vec2(x, y)) * oneOverShadowDepthTextureSize;
+    // point light shadows are 6 perspective views (one per cube face) stored as
+    // consecutive array layers. face order and up vectors must match R_Light::shadowView()
+    const POINT_SHADOW_NEAR = 0.1;
+    var<private> POINT_SHADOW_FACE_DIR : array<vec3f, 6> = array<vec3f, 6>(
+        vec3f(1.0, 0.0, 0.0), vec3f(-1.0, 0.0, 0.0),
+        vec3f(0.0, 1.0, 0.0), vec3f(0.0, -1.0, 0.0),
+        vec3f(0.0, 0.0, 1.0), vec3f(0.0, 0.0, -1.0),
+    );
+    var<private> POINT_SHADOW_FACE_UP : array<vec3f, 6> = array<vec3f, 6>(
+        vec3f(0.0, -1.0, 0.0), vec3f(0.0, -1.0, 0.0),
+        vec3f(0.0, 0.0, 1.0), vec3f(0.0, 0.0, -1.0),
+        vec3f(0.0, -1.0, 0.0), vec3f(0.0, -1.0, 0.0),
+    );
 
-                visibility += textureSampleCompare(
-                    dir_shadow_map_array, shadow_sampler,
-                    p.xy + offset, // coords
-                    layer, // array layer
-                    p.z - bias // shadowBias
-                );
-            }
+    fn calculatePointShadow(worldpos: vec3f, light: LightUniforms) -> f32 {
+        let l = worldpos - light.position;
+        let a = abs(l);
+        var face = select(1, 0, l.x > 0.0);
+        if (a.y > a.x && a.y >= a.z) {
+            face = select(3, 2, l.y > 0.0);
+        } else if (a.z > a.x && a.z > a.y) {
+            face = select(5, 4, l.z > 0.0);
         }
-        visibility /= 9.0;
 
-        return visibility;
+        // project onto the face's 90 degree frustum (same basis as glm::lookAt)
+        let dir = POINT_SHADOW_FACE_DIR[face];
+        let right = normalize(cross(dir, POINT_SHADOW_FACE_UP[face]));
+        let up = cross(right, dir);
+        let d = dot(l, dir);
+        let ndc = vec2f(dot(l, right), dot(l, up)) / d;
+
+        // perspective depth with near = POINT_SHADOW_NEAR, far = radius, in [0, 1]
+        let far = light.point_and_spot_radius;
+        let depth = far / (far - POINT_SHADOW_NEAR) * (1.0 - POINT_SHADOW_NEAR / d);
+
+        let p = vec3(ndc * vec2(0.5, -0.5) + vec2(0.5), depth);
+        return sampleShadowPCF(point_shadow_map_array, p, light.shadow_map_array_layer + face, light.bias);
     }
 
 // main =====================================================================================
@@ -677,8 +807,15 @@ static const char* phong_shader_string = R"glsl(
         let specular_color : vec3f = (specularTex.rgb * u_specular_color);
 
         var lighting = vec3f(0.0); // accumulate lighting
-        for (var i = 0; i < u_frame.num_lights; i++) {
-            let light = u_lights[i];
+
+        // only visit the lights binned into this fragment's cluster
+        let cluster = lightCluster(in.v_worldpos);
+        var cluster_light_count = 0u;
+        if (u_frame.num_lights > 0) {
+            cluster_light_count = u_light_clusters[cluster];
+        }
+        for (var c = 0u; c < cluster_light_count; c++) {
+            let light = u_lights[u_light_clusters[cluster + 1u + c]];
 
             // these need to be computed based on light type
             var attenuation = 1.0;
@@ -689,7 +826,7 @@ static const char* phong_shader_string = R"glsl(
                     lightdir = normalize(-light.direction);
 
                     if (bool(in.receives_shadow) && bool(light.generates_shadows)) { 
-                        attenuation *= calculateDirShadow(in.v_worldpos, light.shadow_map_array_layer, light.proj_view, light.bias);
+                        attenuation *= calculateDirShadow(in.v_worldpos, light);
                     }
                 } 
                 case 2: { // point
@@ -702,6 +839,10 @@ static const char* phong_shader_string = R"glsl(
                         saturate(1.0 - dist2 / r2),
                         light.point_and_spot_falloff
                     );
+
+                    if (bool(in.receives_shadow) && bool(light.generates_shadows)) { 
+                        attenuation *= calculatePointShadow(in.v_worldpos, light);
+                    }
                 }
                 case 3: { // spot
                     let l = light.position - in.v_worldpos;
@@ -1006,6 +1147,7 @@ static const char* pbr_shader_string = R"glsl(
     #include FRAME_UNIFORMS
     #include DRAW_UNIFORMS
     #include LIGHTING_UNIFORMS
+    #include LIGHT_CLUSTER_UNIFORMS
     #include STANDARD_VERTEX_INPUT
     #include STANDARD_VERTEX_OUTPUT
     #include STANDARD_VERTEX_SHADER
@@ -1085,9 +1227,14 @@ static const char* pbr_shader_string = R"glsl(
         F0 = mix(F0, albedo.rgb, metallic); // reflectivity for metals
 
         var Lo : vec3f = vec3(0.0);
-        // loop over all lights
-        for (var i = 0; i < u_frame.num_lights; i++) {
-            let light = u_lights[i];
+        // loop over the lights binned into this fragment's cluster
+        let cluster = lightCluster(in.v_worldpos);
+        var cluster_light_count = 0u;
+        if (u_frame.num_lights > 0) {
+            cluster_light_count = u_light_clusters[cluster];
+        }
+        for (var c = 0u; c < cluster_light_count; c++) {
+            let light = u_lights[u_light_clusters[cluster + 1u + c]];
             var L : vec3f = vec3(0.0);
             var radiance : vec3f = vec3(0.0);
             switch (light.light_type) {
@@ -1172,6 +1319,19 @@ static const char* mipMapShader = CODE(
     fn fs_main(@location(0) texCoord : vec2<f32>) -> @location(0) vec4<f32> {
         return textureSample(img, imgSampler, texCoord);
     }
+
+    // for formats that can't be filtered (e.g. rgba32float), average the 2x2
+    // block of source texels by hand
+    @fragment
+    fn fs_main_unfilterable(@builtin(position) fragCoord : vec4<f32>) -> @location(0) vec4<f32> {
+        let max_coord = vec2<i32>(textureDimensions(img)) - vec2<i32>(1);
+        let base = vec2<i32>(fragCoord.xy) * 2;
+        var sum = textureLoad(img, min(base, max_coord), 0);
+        sum += textureLoad(img, min(base + vec2<i32>(1, 0), max_coord), 0);
+        sum += textureLoad(img, min(base + vec2<i32>(0, 1), max_coord), 0);
+        sum += textureLoad(img, min(base + vec2<i32>(1, 1), max_coord), 0);
+        return sum * 0.25;
+    }
 );
 
 const char* gtext_shader_string = R"glsl(
@@ -1202,12 +1362,30 @@ const char* gtext_shader_string = R"glsl(
     @group(1) @binding(6) var texture_map: texture_2d<f32>;
     @group(1) @binding(7) var texture_sampler: sampler;
     @group(1) @binding(8) var<uniform> cp : vec2f; // control points. (0.5, 0.5) means center
+    @group(1) @binding(9) var<storage, read> u_GlyphBounds: array<vec4f>; // em-relative quads
+    @group(1) @binding(10) var<uniform> u_Size: f32; // font size scale
+
+    // one per drawn glyph, written by R_Font::updateText
+    struct GlyphInstance {
+        offset : vec2f, // quad origin in text space
+        glyph_index : i32, // index into u_Glyphs and u_GlyphBounds
+        _pad : i32,
+    };
 
+    @group(3) @binding(0) var<storage, read> u_GlyphInstances: array<GlyphInstance>;
+
+    // 6 vertices per glyph instance, as 2 triangles of the unit quad
+    var<private> QUAD_CORNERS : array<vec2f, 6> = array(
+        vec2f(0.0, 0.0), // bottom left
+        vec2f(1.0, 0.0), // bottom right
+        vec2f(1.0, 1.0), // top right
+        vec2f(1.0, 1.0), // top right
+        vec2f(0.0, 1.0), // top left
+        vec2f(0.0, 0.0)  // bottom left
+    );
 
     struct VertexInput {
-        @location(0) position : vec2f,
-        @location(1) uv : vec2f,
-        @location(2) glyph_index : i32, // index into glyphs array (which itself is slice into curves array)
+        @builtin(vertex_index) vertex : u32,
         @builtin(instance_index) instance : u32,
     };
 
@@ -1224,16 +1402,22 @@ const char* gtext_shader_string = R"glsl(
         var out : VertexOutput;
         var u_Draw : DrawUniforms = u_draw_instances[in.instance];
 
+        // expand the glyph quad
+        let glyph = u_GlyphInstances[in.vertex / 6u];
+        let bounds = u_GlyphBounds[glyph.glyph_index];
+        let uv = mix(bounds.xy, bounds.zw, QUAD_CORNERS[in.vertex % 6u]);
+        let position = glyph.offset + uv * u_Size;
+
         let bb_w = bb.z - bb.x;
         let bb_h = bb.w - bb.y;
         let cx = bb.x + cp.x * bb_w;
         let cy = bb.y + cp.y * bb_h;
-        let pos = in.position - vec2f(cx, cy);
+        let pos = position - vec2f(cx, cy);
 
         out.position = (u_frame.projection * u_frame.view) * u_Draw.model * vec4f(pos, 0.0f, 1.0f);
-        out.v_uv     = in.uv;
-        out.v_buffer_index = in.glyph_index;
-        out.v_uv_textbox = (in.position - bb.xy) / vec2f(bb_w, bb_h);
+        out.v_uv     = uv;
+        out.v_buffer_index = glyph.glyph_index;
+        out.v_uv_textbox = (position - bb.xy) / vec2f(bb_w, bb_h);
 
         return out;
     }
@@ -1804,6 +1988,371 @@ const char* skybox_shader_string = R"glsl(
     }
 )glsl";
 
+// Equirectangular to cubemap -------------------------
+// one invocation per cubemap texel, global_invocation_id.z is the face.
+// Bilinear filtering is done by hand so that unfilterable (32-bit float) sources
+// work too
+
+const char* equirect_to_cubemap_shader_string = R"glsl(
+    @group(0) @binding(0) var u_equirect : texture_2d<f32>;
+    @group(0) @binding(1) var u_cubemap : texture_storage_2d_array<rgba16float, write>;
+
+    const PI = 3.14159265359;
+
+    // wraps horizontally, clamps vertically
+    fn equirectTexel(coord : vec2i, size : vec2i) -> vec4f {
+        let x = ((coord.x % size.x) + size.x) % size.x;
+        let y = clamp(coord.y, 0, size.y - 1);
+        return textureLoad(u_equirect, vec2i(x, y), 0);
+    }
+
+    // face order +X, -X, +Y, -Y, +Z, -Z, uv in [-1, 1] with v pointing down
+    fn cubemapDirection(face : u32, uv : vec2f) -> vec3f {
+        switch face {
+            case 0u: { return vec3f(1.0, -uv.y, -uv.x); }
+            case 1u: { return vec3f(-1.0, -uv.y, uv.x); }
+            case 2u: { return vec3f(uv.x, 1.0, uv.y); }
+            case 3u: { return vec3f(uv.x, -1.0, -uv.y); }
+            case 4u: { return vec3f(uv.x, -uv.y, 1.0); }
+            default: { return vec3f(-uv.x, -uv.y, -1.0); }
+        }
+    }
+
+    @compute @workgroup_size(8, 8, 1)
+    fn main(@builtin(global_invocation_id) gid : vec3u) {
+        let face_size = textureDimensions(u_cubemap);
+        if (gid.x >= face_size.x || gid.y >= face_size.y) { return; }
+
+        let uv = (vec2f(gid.xy) + 0.5) / vec2f(face_size) * 2.0 - 1.0;
+        var dir = normalize(cubemapDirection(gid.z, uv));
+        // skybox looks up the cubemap with z flipped, undo so that the center of
+        // the equirect image faces -z (the default camera forward)
+        dir.z = -dir.z;
+
+        let src_size = vec2i(textureDimensions(u_equirect));
+        let equirect_uv = vec2f(atan2(dir.x, -dir.z) / (2.0 * PI) + 0.5, acos(dir.y) / PI);
+        let p = equirect_uv * vec2f(src_size) - 0.5;
+        let p0 = vec2i(floor(p));
+        let f = fract(p);
+        let color = mix(
+            mix(equirectTexel(p0, src_size), equirectTexel(p0 + vec2i(1, 0), src_size), f.x),
+            mix(equirectTexel(p0 + vec2i(0, 1), src_size), equirectTexel(p0 + vec2i(1, 1), src_size), f.x),
+            f.y
+        );
+        textureStore(u_cubemap, vec2i(gid.xy), i32(gid.z), color);
+    }
+)glsl";
+
+// BT.601 video range to RGB, same coefficients as pl_mpeg's plm_frame_to_rgba.
+// Chroma is sampled nearest (one Cb/Cr pair per 2x2 or 2x1 luma block) to match.
+// One entry point per YUVLayout
+const char* yuv_to_rgba_shader_string = R"glsl(
+    @group(0) @binding(0) var u_y : texture_2d<f32>;
+    @group(0) @binding(1) var u_cb : texture_2d<f32>;
+    @group(0) @binding(2) var u_cr : texture_2d<f32>;
+    @group(0) @binding(3) var u_rgba : texture_storage_2d<rgba8unorm, write>;
+
+    fn store(gid : vec2u, y : f32, cb : f32, cr : f32) {
+        let luma = 1.16438 * (y - 16.0 / 255.0);
+        let u = cb - 128.0 / 255.0;
+        let v = cr - 128.0 / 255.0;
+        let rgb = vec3f(
+            luma + 1.59603 * v,
+            luma - 0.39176 * u - 0.81297 * v,
+            luma + 2.01723 * u
+        );
+        textureStore(u_rgba, vec2i(gid), vec4f(clamp(rgb, vec3f(0.0), vec3f(1.0)), 1.0));
+    }
+
+    fn inBounds(gid : vec2u) -> bool {
+        let size = textureDimensions(u_rgba);
+        return gid.x < size.x && gid.y < size.y;
+    }
+
+    @compute @workgroup_size(8, 8, 1)
+    fn main_i420(@builtin(global_invocation_id) gid : vec3u) {
+        if (!inBounds(gid.xy)) { return; }
+        let c = vec2i(gid.xy / 2u);
+        store(
+            gid.xy,
+            textureLoad(u_y, vec2i(gid.xy), 0).r,
+            textureLoad(u_cb, c, 0).r,
+            textureLoad(u_cr, c, 0).r
+        );
+    }
+
+    @compute @workgroup_size(8, 8, 1)
+    fn main_nv12(@builtin(global_invocation_id) gid : vec3u) {
+        if (!inBounds(gid.xy)) { return; }
+        let cbcr = textureLoad(u_cb, vec2i(gid.xy / 2u), 0).rg;
+        store(gid.xy, textureLoad(u_y, vec2i(gid.xy), 0).r, cbcr.x, cbcr.y);
+    }
+
+    @compute @workgroup_size(8, 8, 1)
+    fn main_yuyv(@builtin(global_invocation_id) gid : vec3u) {
+        if (!inBounds(gid.xy)) { return; }
+        let yuyv = textureLoad(u_y, vec2i(i32(gid.x / 2u), i32(gid.y)), 0);
+        let y = select(yuyv.r, yuyv.b, (gid.x & 1u) == 1u);
+        store(gid.xy, y, yuyv.g, yuyv.a);
+    }
+)glsl";
+
+// Light clustering -------------------------
+// one invocation per froxel of the camera's cluster grid, one workgroup per depth
+// slice. Finds the froxel's view-space AABB and lists every light whose range
+// touches it. Directional lights touch every froxel. Only lights that survived
+// CPU frustum culling (u_active_lights) are tested
+const char* light_cluster_shader_string = R"glsl(
+    #include FRAME_UNIFORMS
+    #include LIGHTING_UNIFORMS
+    #include LIGHT_CLUSTER_PARAMS
+
+    @group(0) @binding(6) var<storage, read_write> u_light_clusters: array<u32>;
+    @group(0) @binding(7) var<storage, read> u_active_lights: array<u32>; // light indices
+
+    fn unproject(ndc : vec3f) -> vec3f {
+        let p = u_frame.projection_inverse * vec4f(ndc, 1.0);
+        return p.xyz / p.w;
+    }
+
+    @compute @workgroup_size(16, 9, 1)
+    fn main(@builtin(global_invocation_id) gid : vec3u) {
+        if (gid.x >= LIGHT_CLUSTER_X || gid.y >= LIGHT_CLUSTER_Y || gid.z >= LIGHT_CLUSTER_Z) { 
+            return; 
+        }
+        let cluster = ((gid.z * LIGHT_CLUSTER_Y + gid.y) * LIGHT_CLUSTER_X + gid.x) * LIGHT_CLUSTER_STRIDE;
+
+        // tile bounds in ndc
+        let tile_size = 2.0 / vec2f(f32(LIGHT_CLUSTER_X), f32(LIGHT_CLUSTER_Y));
+        let ndc_min = vec2f(gid.xy) * tile_size - 1.0;
+        let ndc_max = ndc_min + tile_size;
+
+        // slice bounds as view-space depth
+        let depth_near = lightClusterSliceDepth(gid.z);
+        let depth_far = lightClusterSliceDepth(gid.z + 1u);
+
+        // intersect the 4 tile corner rays with the slice's near and far planes.
+        // works for both perspective and orthographic projections
+        var aabb_min = vec3f(3.402823e38);
+        var aabb_max = vec3f(-3.402823e38);
+        for (var i = 0u; i < 4u; i++) {
+            let ndc = select(ndc_min, ndc_max, vec2<bool>((i & 1u) != 0u, (i & 2u) != 0u));
+            let a = unproject(vec3f(ndc, 0.0)); // on the camera near plane
+            let b = unproject(vec3f(ndc, 1.0)); // on the camera far plane
+            let p_near = mix(a, b, (-depth_near - a.z) / (b.z - a.z));
+            let p_far = mix(a, b, (-depth_far - a.z) / (b.z - a.z));
+            aabb_min = min(aabb_min, min(p_near, p_far));
+            aabb_max = max(aabb_max, max(p_near, p_far));
+        }
+
+        var count = 0u;
+        for (var a = 0; a < u_frame.num_active_lights && count < LIGHT_CLUSTER_MAX_LIGHTS; a++) {
+            let i = u_active_lights[a];
+            let light = u_lights[i];
+            var touches = light.light_type == LightType_Directional;
+            if (light.light_type == LightType_Point || light.light_type == LightType_Spot) {
+                // sphere vs aabb, spotlights are bounded by their range sphere
+                let center = (u_frame.view * vec4f(light.position, 1.0)).xyz;
+                let d = clamp(center, aabb_min, aabb_max) - center;
+                touches = dot(d, d) <= light.point_and_spot_radius * light.point_and_spot_radius;
+            }
+            if (touches) {
+                u_light_clusters[cluster + 1u + count] = i;
+                count++;
+            }
+        }
+        u_light_clusters[cluster] = count;
+    }
+)glsl";
+
+// Instance culling -------------------------
+// one invocation per instance of a (material, geometry) draw. Instances whose
+// bounding sphere touches the camera frustum, and isn't hidden behind the previous
+// frame's depth, are appended to u_visible, and the instance count of the draw's
+// indirect args is bumped. u_visible is then bound as the draw's u_draw_instances,
+// so vertex shaders are unchanged
+const char* instance_cull_shader_string = R"glsl(
+    #include FRAME_UNIFORMS
+
+    struct DrawUniforms {
+        model: mat4x4f,
+        normal: mat4x4f,
+        id: i32,
+        receives_shadow: i32,
+    };
+
+    struct InstanceCullParams {
+        bounding_sphere: vec4f,
+        instance_count: u32,
+        draw_args_idx: u32,
+    };
+
+    struct OcclusionCullParams {
+        prev_projection_view: mat4x4f,
+        viewport: vec4f,
+        mip_count: u32,
+        enabled: u32,
+    };
+
+    @group(0) @binding(1) var<uniform> u_cull: InstanceCullParams;
+    @group(0) @binding(2) var<storage, read> u_instances: array<DrawUniforms>;
+    @group(0) @binding(3) var<storage, read_write> u_visible: array<DrawUniforms>;
+    // 5 u32 per draw, laid out as DrawIndexedIndirect args. instance count is [1]
+    @group(0) @binding(4) var<storage, read_write> u_draw_args: array<atomic<u32>>;
+    // [0] visible, [1] occluded instances of the whole pass
+    @group(0) @binding(5) var<storage, read_write> u_cull_stats: array<atomic<u32>>;
+    // max-depth pyramid of the previous frame, see hiz_shader_string
+    @group(0) @binding(6) var u_hiz: texture_2d<f32>;
+    @group(0) @binding(7) var<uniform> u_occlusion: OcclusionCullParams;
+
+    var<workgroup> wg_visible: atomic<u32>;
+    var<workgroup> wg_occluded: atomic<u32>;
+
+    fn row(m: mat4x4f, i: u32) -> vec4f {
+        return vec4f(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    fn outside(plane: vec4f, center: vec3f, radius: f32) -> bool {
+        return dot(plane.xyz, center) + plane.w < -radius * length(plane.xyz);
+    }
+
+    // true if the sphere's screen bounds were behind everything drawn there last frame
+    fn occluded(center: vec3f, radius: f32) -> bool {
+        if (u_occlusion.enabled == 0u) { return false; }
+
+        var uv_min = vec2f(1.0);
+        var uv_max = vec2f(0.0);
+        var depth_min = 1.0;
+        for (var i = 0u; i < 8u; i++) {
+            let corner = center + radius * vec3f(select(-1.0, 1.0, (i & 1u) != 0u),
+                                                 select(-1.0, 1.0, (i & 2u) != 0u),
+                                                 select(-1.0, 1.0, (i & 4u) != 0u));
+            let clip = u_occlusion.prev_projection_view * vec4f(corner, 1.0);
+            // crosses the camera plane, no reliable screen bounds
+            if (clip.w <= 0.0) { return false; }
+            let ndc = clip.xyz / clip.w;
+            let uv = vec2f(ndc.x, -ndc.y) * 0.5 + 0.5;
+            uv_min = min(uv_min, uv);
+            uv_max = max(uv_max, uv);
+            depth_min = min(depth_min, ndc.z);
+        }
+        // off screen last frame, nothing is known about what was in front of it
+        if (any(uv_max < vec2f(0.0)) || any(uv_min > vec2f(1.0))) { return false; }
+
+        let vp = u_occlusion.viewport;
+        let px_min = vp.xy + clamp(uv_min, vec2f(0.0), vec2f(1.0)) * vp.zw;
+        let px_max = vp.xy + clamp(uv_max, vec2f(0.0), vec2f(1.0)) * vp.zw;
+
+        // first mip where the bounds cover at most 2x2 texels
+        let extent = max(px_max.x - px_min.x, px_max.y - px_min.y);
+        let mip = min(u32(ceil(log2(max(extent, 1.0)))), u_occlusion.mip_count - 1u);
+        let last_texel = textureDimensions(u_hiz, mip) - vec2u(1u);
+        let t_min = min(vec2u(px_min) >> vec2u(mip), last_texel);
+        let t_max = min(vec2u(px_max) >> vec2u(mip), last_texel);
+        let hiz = max(max(textureLoad(u_hiz, t_min, mip).r,
+                          textureLoad(u_hiz, vec2u(t_max.x, t_min.y), mip).r),
+                      max(textureLoad(u_hiz, vec2u(t_min.x, t_max.y), mip).r,
+                          textureLoad(u_hiz, t_max, mip).r));
+        return depth_min > hiz;
+    }
+
+    @compute @workgroup_size(64, 1, 1)
+    fn main(@builtin(global_invocation_id) gid : vec3u,
+            @builtin(local_invocation_index) lid : u32) {
+        let i = gid.x;
+        if (i < u_cull.instance_count) {
+            let draw = u_instances[i];
+            var visible = true;
+
+            if (u_cull.bounding_sphere.w >= 0.0) {
+                // world space sphere, scaled by the largest axis scale
+                let center = (draw.model * vec4f(u_cull.bounding_sphere.xyz, 1.0)).xyz;
+                let scale = max(length(draw.model[0].xyz),
+                                max(length(draw.model[1].xyz),
+                                    length(draw.model[2].xyz)));
+                let radius = u_cull.bounding_sphere.w * scale;
+
+                // frustum planes of a [0, 1] depth projection (Gribb-Hartmann)
+                let pv = u_frame.projection * u_frame.view;
+                let r0 = row(pv, 0u);
+                let r1 = row(pv, 1u);
+                let r2 = row(pv, 2u);
+                let r3 = row(pv, 3u);
+                if (outside(r3 + r0, center, radius)
+                    || outside(r3 - r0, center, radius)
+                    || outside(r3 + r1, center, radius)
+                    || outside(r3 - r1, center, radius)
+                    || outside(r2, center, radius)
+                    || outside(r3 - r2, center, radius)) {
+                    visible = false;
+                } else if (occluded(center, radius)) {
+                    visible = false;
+                    atomicAdd(&wg_occluded, 1u);
+                }
+            }
+
+            if (visible) {
+                let slot = atomicAdd(&u_draw_args[u_cull.draw_args_idx + 1u], 1u);
+                u_visible[slot] = draw;
+                atomicAdd(&wg_visible, 1u);
+            }
+        }
+
+        // one global atomic per workgroup for the pass stats
+        workgroupBarrier();
+        if (lid == 0u) {
+            atomicAdd(&u_cull_stats[0], atomicLoad(&wg_visible));
+            atomicAdd(&u_cull_stats[1], atomicLoad(&wg_occluded));
+        }
+    }
+)glsl";
+
+// Hi-Z pyramid -------------------------
+// max-depth pyramid of a ScenePass depth buffer, for occlusion culling the next
+// frame. copy_depth writes mip 0, then reduce writes every following mip from the
+// one above it, see HiZGenerator_generate()
+const char* hiz_shader_string = R"glsl(
+    @group(0) @binding(0) var u_src: texture_2d<f32>;
+    @group(0) @binding(1) var u_dst: texture_storage_2d<r32float, write>;
+    @group(0) @binding(2) var u_depth: texture_depth_2d;
+    @group(0) @binding(3) var u_depth_msaa: texture_depth_multisampled_2d;
+
+    @compute @workgroup_size(8, 8, 1)
+    fn copy_depth(@builtin(global_invocation_id) gid: vec3u) {
+        if (any(gid.xy >= textureDimensions(u_dst))) { return; }
+        textureStore(u_dst, gid.xy, vec4f(textureLoad(u_depth, gid.xy, 0)));
+    }
+
+    @compute @workgroup_size(8, 8, 1)
+    fn copy_depth_msaa(@builtin(global_invocation_id) gid: vec3u) {
+        if (any(gid.xy >= textureDimensions(u_dst))) { return; }
+        var depth = 0.0;
+        for (var s = 0u; s < textureNumSamples(u_depth_msaa); s++) {
+            depth = max(depth, textureLoad(u_depth_msaa, gid.xy, s));
+        }
+        textureStore(u_dst, gid.xy, vec4f(depth));
+    }
+
+    // max of the 2x2 source texels. the last texel of an odd sized source row or
+    // column also takes the leftover texel, so no depth is dropped
+    @compute @workgroup_size(8, 8, 1)
+    fn reduce(@builtin(global_invocation_id) gid: vec3u) {
+        let dst_size = textureDimensions(u_dst);
+        if (any(gid.xy >= dst_size)) { return; }
+        let src_last = textureDimensions(u_src) - vec2u(1u);
+        let extent = vec2u(2u) + select(vec2u(0u), (src_last + vec2u(1u)) & vec2u(1u),
+                                        gid.xy == dst_size - vec2u(1u));
+        var depth = 0.0;
+        for (var y = 0u; y < extent.y; y++) {
+            for (var x = 0u; x < extent.x; x++) {
+                let texel = min(gid.xy * 2u + vec2u(x, y), src_last);
+                depth = max(depth, textureLoad(u_src, texel, 0).r);
+            }
+        }
+        textureStore(u_dst, gid.xy, vec4f(depth));
+    }
+)glsl";
+
 // ======================================
 // box2d debug shaders
 // ======================================
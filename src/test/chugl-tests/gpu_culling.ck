@@ -0,0 +1,25 @@
+// ScenePass.gpuCulling(): instances outside the camera frustum are not drawn
+
+GG.scenePass().gpuCulling(true);
+
+// default camera is at (0, 0, 5) looking down -z with its far plane at 100
+GCube inside[5];
+for (int i; i < inside.size(); i++) {
+    inside[i] --> GG.scene();
+    @(i - 2, 0, 0) => inside[i].pos;
+}
+
+GCube outside[3];
+outside[0].pos(@(0, 0, 50));   // behind the camera
+outside[1].pos(@(100, 0, 0));  // off to the side
+outside[2].pos(@(0, 0, -500)); // past the far plane
+for (int i; i < outside.size(); i++) outside[i] --> GG.scene();
+
+// the count is read back from the gpu, a few frames late
+repeat (10) GG.nextFrame() => now;
+<<< "visible instances", GG.scenePass().visibleInstances() >>>;
+
+// bringing the culled cubes into view draws them again
+for (int i; i < outside.size(); i++) @(i - 1, 1.5, 0) => outside[i].pos;
+repeat (10) GG.nextFrame() => now;
+<<< "visible instances after moving into view", GG.scenePass().visibleInstances() >>>;
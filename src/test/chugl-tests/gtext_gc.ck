@@ -0,0 +1,16 @@
+// a garbage collected GText releases the font it was holding
+
+// let the renderer load the builtin fonts
+repeat (3) GG.nextFrame() => now;
+GText.fontReferences() => int base;
+
+fun void createText() {
+    GText text;
+    "hello" => text.text;
+    repeat (3) GG.nextFrame() => now;
+    <<< "font references while text is alive", GText.fontReferences() - base >>>;
+}
+
+createText();
+repeat (3) GG.nextFrame() => now;
+<<< "font references after text is collected", GText.fontReferences() - base >>>;
@@ -0,0 +1,37 @@
+// GScene light stats: point lights outside the camera frustum are culled, and
+// a light's uniforms are only uploaded again when it changes
+
+// default camera is at (0, 0, 5) looking down -z with its far plane at 100
+GPointLight inside[4];
+for (int i; i < inside.size(); i++) {
+    inside[i] --> GG.scene();
+    inside[i].radius(1);
+    @(i - 1.5, 0, 0) => inside[i].pos;
+}
+
+GPointLight outside[3];
+outside[0].pos(@(0, 0, 50));   // behind the camera
+outside[1].pos(@(100, 0, 0));  // off to the side
+outside[2].pos(@(0, 0, -500)); // past the far plane
+for (int i; i < outside.size(); i++) {
+    outside[i] --> GG.scene();
+    outside[i].radius(1);
+}
+
+repeat (5) GG.nextFrame() => now;
+// the default directional light reaches everything
+<<< "active lights", GG.scene().activeLights() >>>;
+<<< "uploaded lights while still", GG.scene().uploadedLights() >>>;
+
+repeat (3) {
+    .1 => inside[0].posY;
+    GG.nextFrame() => now;
+    0 => inside[0].posY;
+    GG.nextFrame() => now;
+}
+<<< "uploaded lights while one moves", GG.scene().uploadedLights() >>>;
+
+// moving an outside light into view activates it
+@(0, 0, 0) => outside[0].pos;
+repeat (3) GG.nextFrame() => now;
+<<< "active lights after moving one into view", GG.scene().activeLights() >>>;
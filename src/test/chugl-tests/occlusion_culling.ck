@@ -0,0 +1,26 @@
+// ScenePass.occlusionCulling(): instances hidden behind a wall are not drawn.
+// Culling tests against the previous frame's depth, so it takes a couple of
+// frames to kick in
+
+GG.scenePass().occlusionCulling(true);
+
+// wall at z = 0 filling the view of the default camera at (0, 0, 5)
+GPlane wall --> GG.scene();
+@(20, 20, 1) => wall.sca;
+
+// cubes behind the wall
+GCube hidden[4];
+for (int i; i < hidden.size(); i++) {
+    hidden[i] --> GG.scene();
+    @(i - 1.5, 0, -5) => hidden[i].pos;
+}
+
+repeat (10) GG.nextFrame() => now;
+<<< "visible instances", GG.scenePass().visibleInstances() >>>;
+<<< "occluded instances", GG.scenePass().occludedInstances() >>>;
+
+// removing the wall uncovers them
+wall.detach();
+repeat (10) GG.nextFrame() => now;
+<<< "occluded instances without the wall", GG.scenePass().occludedInstances() >>>;
+<<< "visible instances without the wall", GG.scenePass().visibleInstances() >>>;
@@ -12,6 +12,16 @@ T.assert(!b2World.isValid(0), "invalid world");
 b2.destroyWorld(world_id);
 T.assert(!b2World.isValid(world_id), "destroyed world");
 
+// multithreaded worlds
+b2WorldDef threaded_def;
+T.assert(threaded_def.workerCount >= 1, "workerCount default value");
+4 => threaded_def.workerCount;
+b2.createWorld(threaded_def) => int threaded_world_id;
+T.assert(b2World.isValid(threaded_world_id), "threaded world created");
+T.assert(T.feq(b2World.stepTime(threaded_world_id), 0), "stepTime before stepping");
+b2.destroyWorld(threaded_world_id);
+T.assert(!b2World.isValid(threaded_world_id), "destroyed threaded world");
+
 b2Filter filter;
 T.assert(filter.categoryBits == 0x0001, "categoryBits default value");
 T.assert(filter.maskBits & 0xFFFFFFFF == 0xFFFFFFFF, "maskBits default value");
@@ -37,6 +47,20 @@ b2.createWorld(world_def) => world_id;
 b2.createBody(world_id, body_def) => int body_id;
 T.assert(b2Body.isValid(body_id), "body created");
 T.assert(T.feq(1337, b2Body.position(body_id).x), "position.x set");
+T.assert(T.feq(1337, b2Body.interpolatedPosition(body_id).x), "unsimulated body interpolatedPosition");
+T.assert(T.feq(b2.interpolationAlpha(), 1.0), "interpolationAlpha default value");
+
+vec2 body_positions[0];
+float body_angles[0];
+b2Body.positions([body_id, body_id], body_positions);
+b2Body.angles([body_id], body_angles);
+T.assert(body_positions.size() == 2 && T.feq(body_positions[1].x, 1337), "bulk positions");
+T.assert(body_angles.size() == 1 && T.feq(body_angles[0], 0), "bulk angles");
+
+GGen body_ggen;
+b2Body.bind(body_id, body_ggen);
+T.assert(T.feq(body_ggen.posX(), 1337) && T.feq(body_ggen.posY(), 2.3), "bind copies body transform");
+b2Body.unbind(body_ggen);
 
 b2.makeBox(.5, .5) @=> b2Polygon@ box_poly;
 b2.createPolygonShape(body_id, shape_def, box_poly) => int shape_id;
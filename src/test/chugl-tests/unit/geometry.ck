@@ -81,3 +81,79 @@ T.assert(T.arrayEquals(pulled_vertex_data, pulled_vertex_data_copy), "pulledVert
 
 pulled_geo.pulledVertexAttribute(1, indices);
 T.assert(T.arrayEquals(indices,pulled_geo.pulledVertexAttributeInt(1)), "pulledVertexAttributeInt equality");
+
+// LOD
+Geometry lod_geo;
+T.assert(lod_geo.lodLevels() == 1, "default lodLevels");
+T.assert(lod_geo.lodForce() == -1, "default lodForce");
+T.assert(T.arrayEquals(lod_geo.lodThresholds(), [.5, .25, .125, .0625, .03125]), "default lodThresholds");
+lod_geo.lodLevels(4);
+T.assert(lod_geo.lodLevels() == 4, "lodLevels");
+lod_geo.lodLevels(100);
+T.assert(lod_geo.lodLevels() == 6, "lodLevels clamped");
+lod_geo.lodThresholds([.3, .1]);
+T.assert(T.arrayEquals(lod_geo.lodThresholds(), [.3, .1, .125, .0625, .03125]), "lodThresholds");
+lod_geo.lodForce(2);
+T.assert(lod_geo.lodForce() == 2, "lodForce");
+
+// optimize
+T.assert(Geometry.autoOptimize() == 0, "default autoOptimize");
+Geometry opt_geo;
+opt_geo.vertexAttribute(0, 3, [0.0, 0., 0.,  1., 0., 0.,  0., 1., 0.,  1., 0., 0.,  1., 1., 0.,  0., 1., 0.]);
+opt_geo.optimize() => vec2 acmr;
+T.assert(T.feq(acmr.x, 3) && T.feq(acmr.y, 2), "optimize acmr");
+T.assert(T.arrayEquals(opt_geo.vertexAttributeData(0), [0.0, 0., 0.,  1., 0., 0.,  0., 1., 0.,  1., 1., 0.]), "optimize welds vertices");
+T.assert(T.arrayEquals(opt_geo.indices(), [0, 1, 2, 1, 3, 2]), "optimize indices");
+pulled_geo.optimize() => vec2 pulled_acmr;
+T.assert(T.feq(pulled_acmr.x, 0) && T.feq(pulled_acmr.y, 0), "optimize skips pulled geometry");
+
+// shared geometry
+T.assert(Geometry.autoShare() == 1, "default autoShare");
+SphereGeometry share_a, share_b;
+T.assert(share_a.shared() && share_b.shared(), "identical built-in geometries share");
+T.assert(!opt_geo.shared(), "custom geometry doesn't share");
+share_b.positions(share_b.positions());
+T.assert(!share_b.shared(), "editing unshares");
+T.assert(share_a.shared(), "other sharer unaffected");
+T.assert(T.arrayEquals(share_a.vertexAttributeData(0), share_b.vertexAttributeData(0)), "unshared copy keeps data");
+share_b.build(.5, 32, 16, 0, Math.two_pi, 0, Math.pi);
+T.assert(share_b.shared(), "rebuilding shares again");
+
+// async build
+T.assert(Geometry.asyncBuild() == 0, "default asyncBuild");
+true => Geometry.asyncBuild;
+SphereGeometry async_geo(.5, 64, 32, 0, Math.two_pi, 0, Math.pi);
+T.assert(async_geo.building(), "async build pending");
+T.assert(!async_geo.shared(), "async builds aren't shared");
+T.assert(async_geo.widthSegments() == 64, "async build params");
+T.assert(async_geo.positions().size() == 65 * 33, "reading waits for async build");
+T.assert(!async_geo.building(), "async build applied");
+false => Geometry.asyncBuild;
+
+// normals and tangents
+Geometry quad_geo;
+quad_geo.positions([@(0., 0., 0.), @(1., 0., 0.), @(0., 1., 0.), @(1., 1., 0.)]);
+quad_geo.uvs([@(0., 0.), @(1., 0.), @(0., 1.), @(1., 1.)]);
+quad_geo.indices([0, 1, 2, 1, 3, 2]);
+T.assert(quad_geo.computeNormals(), "computeNormals");
+T.assert(T.arrayEquals(quad_geo.normals(), [@(0., 0., 1.), @(0., 0., 1.), @(0., 0., 1.), @(0., 0., 1.)]), "computeNormals values");
+T.assert(Geometry.ATTRIBUTE_TANGENT == 3, "TANGENT_ATTRIBUTE_LOCATION");
+T.assert(quad_geo.computeTangents(), "computeTangents");
+T.assert(quad_geo.vertexAttributeNumComponents()[3] == 4, "computeTangents vec4");
+T.assert(T.arrayEquals(quad_geo.vertexAttributeData(3), [1., 0., 0., 1.,  1., 0., 0., 1.,  1., 0., 0., 1.,  1., 0., 0., 1.]), "computeTangents values");
+Geometry empty_geo;
+T.assert(!empty_geo.computeNormals(), "computeNormals needs positions");
+T.assert(!opt_geo.computeTangents(), "computeTangents needs uvs");
+
+// auto normals only update the vertices around moved ones
+T.assert(!quad_geo.autoNormals(), "default autoNormals");
+true => quad_geo.autoNormals;
+quad_geo.positions([@(0., 0., 0.), @(1., 0., 0.), @(0., 1., 0.), @(1., 1., 1.)]);
+quad_geo.normals() @=> vec3 auto_normals[];
+T.assert(T.veq(auto_normals[0], @(0., 0., 1.)), "autoNormals keeps unaffected vertex");
+// vertex 3 is only in face (1, 3, 2), whose normal is (-1, -1, 1) / sqrt(3)
+1. / Math.sqrt(3.) => float inv_sqrt3;
+T.assert(T.veq(auto_normals[3], @(-inv_sqrt3, -inv_sqrt3, inv_sqrt3)), "autoNormals moved vertex");
+T.assert(!T.feq(quad_geo.vertexAttributeData(3)[12 + 2], 0.), "autoNormals updates tangents");
+quad_geo.computeNormals();
+T.assert(T.arrayEquals(auto_normals, quad_geo.normals()), "autoNormals matches computeNormals");
@@ -24,5 +24,15 @@ T.assert(!rpass.clear(), "auto clear color is false");
 
 T.assert(GG.renderPass().next() == GG.outputPass(), "default render pass next is output pass");
 
+ScenePass spass;
+T.assert(!spass.gpuCulling(), "default gpu culling is false");
+spass.gpuCulling(true);
+T.assert(spass.gpuCulling(), "gpu culling is true");
+T.assert(!spass.occlusionCulling(), "default occlusion culling is false");
+spass.occlusionCulling(true);
+T.assert(spass.occlusionCulling(), "occlusion culling is true");
+T.assert(spass.visibleInstances() == 0, "no visible instances before rendering");
+T.assert(spass.occludedInstances() == 0, "no occluded instances before rendering");
+
 OutputPass opass;
 T.assert(opass.gamma(), "default apply gamma correction");
\ No newline at end of file
@@ -20,6 +20,10 @@ T.assert(GG.scene().lights().size() == 2, "adding lights increases lights size")
 point_light.detach();
 T.assert(GG.scene().lights().size() == 1, "detaching lights decreases lights size");
 
+// light stats are written back by the renderer
+T.assert(GG.scene().activeLights() == 0, "no active lights before rendering");
+T.assert(GG.scene().uploadedLights() == 0, "no uploaded lights before rendering");
+
 // test ambient light
 GG.scene().ambient(@(0.1, 0.2, 0.3));
 T.assert(T.veq(GG.scene().ambient(), @(0.1, 0.2, 0.3)), "set ambient light");
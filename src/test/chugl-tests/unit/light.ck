@@ -21,4 +21,10 @@ point_light.color(@(.1, .2, .3));
 T.assert(T.veq(point_light.color(), @(.1, .2, .3)), "Set point light color");
 
 point_light.intensity(0.5);
-T.assert(point_light.intensity() == 0.5, "Set point light intensity");
\ No newline at end of file
+T.assert(point_light.intensity() == 0.5, "Set point light intensity");
+// shadow cascades
+T.assert(T.veq(dir_light.shadowCascades(), @(1, 100)), "default shadow cascades");
+dir_light.shadowCascades(3, 60);
+T.assert(T.veq(dir_light.shadowCascades(), @(3, 60)), "set shadow cascades");
+dir_light.shadowCascades(9, -1);
+T.assert(T.veq(dir_light.shadowCascades(), @(4, 0)), "shadow cascades clamped");
@@ -19,3 +19,6 @@ T.assert(T.feq(text.spacing(), 2.0), "set spacing");
 Texture tex;
 text.texture(tex);
 T.assert(text.texture() == tex, "set texture");
+
+// bounds are written back by the renderer, nothing laid out yet
+T.assert(T.veq(text.bounds(), @(0, 0, 0, 0)), "bounds before layout");
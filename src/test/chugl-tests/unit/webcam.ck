@@ -11,3 +11,15 @@ webcam.freeze(true);
 T.assert(webcam.freeze() == true, "webcam.freeze() can be set to true");
 webcam.freeze(false);
 T.assert(webcam.freeze() == false, "webcam.freeze() can be set to false");
+
+// synthetic device, works without a camera
+Webcam synthetic(Webcam.SYNTHETIC, 320, 240, 30);
+T.assert(synthetic.deviceID() == Webcam.SYNTHETIC, "synthetic webcam device ID");
+T.assert(synthetic.width() == 320, "synthetic webcam width");
+T.assert(synthetic.height() == 240, "synthetic webcam height");
+T.assert(synthetic.fps() == 30, "synthetic webcam fps");
+T.assert(synthetic.format() == Webcam.FORMAT_RGBA, "default webcam.format() is FORMAT_RGBA");
+synthetic.format(Webcam.FORMAT_NV12);
+T.assert(synthetic.format() == Webcam.FORMAT_NV12, "webcam.format() can be set to FORMAT_NV12");
+synthetic.format(Webcam.FORMAT_YUYV);
+T.assert(synthetic.format() == Webcam.FORMAT_YUYV, "webcam.format() can be set to FORMAT_YUYV");
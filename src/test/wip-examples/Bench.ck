@@ -0,0 +1,38 @@
+// Frame timing shared by the *_benchmark.ck scripts. Load it first, e.g.
+//   chuck Bench.ck lod_benchmark.ck
+// To change the scene every frame, or to measure something other than frame
+// time, extend Bench and override frame() or sample()
+public class Bench {
+    120 => int frames; // frames averaged per measurement
+
+    // called before each measured frame
+    fun void frame(int f) {}
+
+    // what is averaged, default is the frame time in ms
+    fun float sample() {
+        return GG.dt() * 1000;
+    }
+
+    // average of sample() over the next `frames` frames
+    fun float measure() {
+        0.0 => float total;
+        for (int f; f < frames; f++) {
+            frame(f);
+            GG.nextFrame() => now;
+            sample() +=> total;
+        }
+        return total / frames;
+    }
+
+    // measure() once to let buffers upload and caches settle, ignoring the result
+    fun void warmup() {
+        measure();
+    }
+
+    // measure() and print it under label
+    fun float report(string label) {
+        measure() => float ms;
+        <<< label, ms, "ms" >>>;
+        return ms;
+    }
+}
@@ -0,0 +1,27 @@
+// Rebuilds a high resolution sphere every frame with an audio-driven segment
+// count, first in the graphics shred and then with Geometry.asyncBuild().
+// Large grids are also split across the worker pool. Run with Bench.ck
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 0, 3) => GG.scene().camera().pos;
+
+SphereGeometry geo;
+GMesh mesh(geo, new NormalMaterial) --> GG.scene();
+
+SinOsc lfo => blackhole;
+.5 => lfo.freq;
+
+class RebuildBench extends Bench {
+    fun void frame(int f) {
+        (512 + 256 * lfo.last()) $ int => int seg;
+        geo.build(1, seg, seg / 2, 0, Math.two_pi, 0, Math.pi);
+    }
+}
+RebuildBench bench;
+
+bench.warmup();
+bench.report("sync build:");
+
+true => Geometry.asyncBuild;
+bench.warmup();
+bench.report("async build:");
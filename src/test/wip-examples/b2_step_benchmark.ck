@@ -0,0 +1,62 @@
+// Compares the single-threaded box2d step against the multithreaded one.
+// Builds the same pile of boxes in two worlds and averages b2World.stepTime()
+// of each. Run with Bench.ck
+
+5000 => int NUM_BODIES;
+
+fun int createWorld(int worker_count)
+{
+    b2WorldDef world_def;
+    worker_count => world_def.workerCount;
+    b2.createWorld(world_def) => int world_id;
+
+    // ground
+    b2BodyDef ground_def;
+    b2.createBody(world_id, ground_def) => int ground_id;
+    b2ShapeDef shape_def;
+    b2.createPolygonShape(ground_id, shape_def, b2.makeOffsetBox(200, 1, @(0, -1), 0));
+
+    // pile of boxes
+    b2BodyDef body_def;
+    b2BodyType.dynamicBody => body_def.type;
+    b2.makeBox(.4, .4) @=> b2Polygon box;
+    100 => int cols;
+    for (int i; i < NUM_BODIES; i++) {
+        @(i % cols - cols / 2.0, 1 + (i / cols) * .85) => body_def.position;
+        b2.createBody(world_id, body_def) => int body_id;
+        b2.createPolygonShape(body_id, shape_def, box);
+    }
+
+    return world_id;
+}
+
+class StepBench extends Bench {
+    int world_id;
+    fun float sample() {
+        return b2World.stepTime(world_id);
+    }
+}
+StepBench bench;
+300 => bench.frames;
+
+fun float averageStepTime(int world_id)
+{
+    world_id => bench.world_id;
+    b2.world(world_id);
+    GG.nextFrame() => now; // world takes effect on the next frame
+    return bench.measure();
+}
+
+b2WorldDef default_def;
+default_def.workerCount => int max_workers;
+
+createWorld(1) => int serial_world;
+createWorld(max_workers) => int parallel_world;
+
+averageStepTime(serial_world) => float serial_ms;
+averageStepTime(parallel_world) => float parallel_ms;
+
+<<< NUM_BODIES, "bodies,", bench.frames, "frames" >>>;
+<<< "1 worker:", serial_ms, "ms/step" >>>;
+<<< max_workers, "workers:", parallel_ms, "ms/step" >>>;
+<<< "speedup:", serial_ms / parallel_ms >>>;
@@ -0,0 +1,42 @@
+// Deforms a small patch of a high resolution plane every frame, recomputing
+// normals in full with computeNormals() and then incrementally with
+// autoNormals(). The mesh is drawn as a wireframe, whose edges are only rebuilt
+// when the indices change, not the positions. Run with Bench.ck
+
+256 => int SEGMENTS;
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 0, 3) => GG.scene().camera().pos;
+
+PlaneGeometry geo(2, 2, SEGMENTS, SEGMENTS);
+NormalMaterial mat;
+mat.wireframe(true);
+GMesh mesh(geo, mat) --> GG.scene();
+
+geo.positions() @=> vec3 rest[];
+vec3 positions[rest.size()];
+
+SinOsc lfo => blackhole;
+.5 => lfo.freq;
+
+// bump of radius .1 following the lfo around the plane
+class DeformBench extends Bench {
+    fun void frame(int f) {
+        @(.8 * lfo.last(), .8 * Math.sin(now / second), 0) => vec3 center;
+        for (int i; i < rest.size(); i++) {
+            rest[i] => vec3 p;
+            Math.hypot(p.x - center.x, p.y - center.y) => float d;
+            if (d < .1) .1 * Math.cos(d / .1 * Math.pi / 2) => p.z;
+            p => positions[i];
+        }
+        geo.positions(positions);
+        if (!geo.autoNormals()) geo.computeNormals();
+    }
+}
+DeformBench bench;
+
+false => geo.autoNormals;
+bench.warmup();
+bench.report("computeNormals:");
+true => geo.autoNormals;
+bench.report("autoNormals:");
@@ -0,0 +1,29 @@
+// 100k instances of one mesh, with and without GPU culling. With
+// ScenePass.gpuCulling(true) the instances are frustum culled in a compute pass
+// and drawn with one indirect draw, so the CPU cost doesn't grow with the
+// instance count and off-screen instances aren't shaded. Run with Bench.ck
+
+100000 => int NUM_INSTANCES;
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 5, 40) => GG.scene().camera().pos;
+
+CubeGeometry geo;
+PhongMaterial mat;
+GMesh meshes[NUM_INSTANCES];
+for (int i; i < NUM_INSTANCES; i++) {
+    meshes[i].mesh(geo, mat);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-200, 200), Math.random2f(-200, 200), Math.random2f(-200, 200))
+        => meshes[i].pos;
+}
+
+Bench bench;
+
+// let the instance buffers upload
+bench.warmup();
+
+GG.scenePass().gpuCulling(false);
+bench.report("cpu instancing:");
+GG.scenePass().gpuCulling(true);
+bench.report("gpu culling:");
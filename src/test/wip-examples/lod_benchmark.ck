@@ -0,0 +1,37 @@
+// Field of dense spheres stretching away from the camera. With
+// Geometry.lodLevels() the distant spheres draw simplified copies of the mesh,
+// so far fewer triangles are rasterized per frame. Run with Bench.ck
+
+40 => int GRID;
+
+GG.scene().camera( new GFlyCamera );
+@(0, 2, 4) => GG.scene().camera().pos;
+
+// ~32k triangles per sphere
+SphereGeometry geo(.5, 128, 128, 0, Math.two_pi, 0, Math.pi);
+PhongMaterial mat;
+GMesh meshes[0];
+
+for (int x; x < GRID; x++) {
+    for (int z; z < GRID; z++) {
+        GMesh mesh(geo, mat) --> GG.scene();
+        @((x - GRID / 2) * 1.5, 0, -z * 1.5) => mesh.pos;
+        meshes << mesh;
+    }
+}
+
+Bench bench;
+
+// let the instance buffers upload
+bench.warmup();
+bench.report("no LODs:");
+
+// levels are simplified in the background and used once uploaded
+geo.lodLevels(5);
+bench.warmup();
+bench.report("5 LODs:");
+
+for (int level; level < geo.lodLevels(); level++) {
+    geo.lodForce(level);
+    bench.report("forced level " + level + ":");
+}
@@ -0,0 +1,37 @@
+// Lit floor under a growing number of small point lights. With clustered
+// lighting each fragment only shades the lights whose range reaches its
+// cluster, so frame time should grow slowly with the light count. Run with
+// Bench.ck
+
+[16, 64, 256, 1024] @=> int LIGHT_COUNTS[];
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 12, 12) => GG.scene().camera().pos;
+GG.scene().light().intensity(0);
+
+GPlane ground --> GG.scene();
+@(20, 20, 1) => ground.sca;
+ground.rotateX(Math.PI/2);
+
+GGen light_group --> GG.scene();
+GPointLight lights[0];
+
+fun void addLights(int count)
+{
+    while (lights.size() < count) {
+        GPointLight light --> light_group;
+        light.radius(1.5);
+        light.color(@(Math.random2f(0, 1), Math.random2f(0, 1), Math.random2f(0, 1)));
+        @(Math.random2f(-10, 10), .5, Math.random2f(-10, 10)) => light.pos;
+        lights << light;
+    }
+}
+
+Bench bench;
+
+for (int i; i < LIGHT_COUNTS.size(); i++) {
+    addLights(LIGHT_COUNTS[i]);
+    bench.report(LIGHT_COUNTS[i] + " point lights:");
+    <<< GG.scene().activeLights(), "active,", GG.scene().uploadedLights(),
+        "uploaded" >>>;
+}
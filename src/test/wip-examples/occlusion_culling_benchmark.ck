@@ -0,0 +1,52 @@
+// Grid of rooms, each holding many meshes behind its walls. With
+// ScenePass.occlusionCulling(true) meshes hidden behind the walls are culled
+// against last frame's depth before they are drawn. Run with Bench.ck
+
+20 => int NUM_ROOMS;
+500 => int MESHES_PER_ROOM;
+
+GG.scene().camera( new GFlyCamera );
+@(0, 1, 0) => GG.scene().camera().pos;
+
+CubeGeometry geo;
+PhongMaterial mat;
+GMesh walls[0];
+GMesh meshes[0];
+
+for (int r; r < NUM_ROOMS; r++) {
+    // a closed room down the -z axis, the camera sits in the first one
+    -r * 12.0 => float z;
+    for (int side; side < 4; side++) {
+        GMesh wall(geo, mat) --> GG.scene();
+        // sides 0, 1 face z, sides 2, 3 face x
+        (side % 2) * 10 - 5 => float offset;
+        if (side < 2) {
+            @(10, 4, .2) => wall.sca;
+            @(0, 2, z + offset) => wall.pos;
+        } else {
+            @(.2, 4, 10) => wall.sca;
+            @(offset, 2, z) => wall.pos;
+        }
+        walls << wall;
+    }
+    for (int i; i < MESHES_PER_ROOM; i++) {
+        GMesh mesh(geo, mat) --> GG.scene();
+        .2 => mesh.sca;
+        @(Math.random2f(-4, 4), Math.random2f(0, 3), z + Math.random2f(-4, 4))
+            => mesh.pos;
+        meshes << mesh;
+    }
+}
+
+Bench bench;
+
+// let the instance buffers upload
+bench.warmup();
+
+GG.scenePass().gpuCulling(true);
+bench.report("frustum culling:");
+<<< GG.scenePass().visibleInstances(), "visible" >>>;
+GG.scenePass().occlusionCulling(true);
+bench.report("occlusion culling:");
+<<< GG.scenePass().visibleInstances(), "visible,",
+    GG.scenePass().occludedInstances(), "occluded" >>>;
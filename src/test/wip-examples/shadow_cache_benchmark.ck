@@ -0,0 +1,51 @@
+// Shadowed scene of many still cubes and a few moving ones. Shadow maps are
+// only re-rendered when a light or caster changes, and the still cubes are
+// cached in a static layer, so adding still cubes should barely change the
+// frame time once they have settled. Run with Bench.ck
+
+[0, 4] @=> int MOVING_COUNTS[];
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 15, 20) => GG.scene().camera().pos;
+GG.scene().light() @=> GLight sun;
+sun.shadow(true);
+(sun $ GDirLight).shadowCascades(3, 60);
+sun.rotateX(-Math.PI/3);
+
+GPlane ground --> GG.scene();
+@(40, 40, 1) => ground.sca;
+ground.rotateX(-Math.PI/2);
+ground.shadowed(true);
+
+GPointLight lamp --> GG.scene();
+@(0, 3, 0) => lamp.pos;
+lamp.radius(20);
+lamp.shadow(true);
+
+GCube cubes[0];
+for (int i; i < 400; i++) {
+    GCube cube --> GG.scene();
+    @(Math.random2f(-18, 18), .5, Math.random2f(-18, 18)) => cube.pos;
+    cube.shadowed(true);
+    sun.shadowAdd(cube, false);
+    lamp.shadowAdd(cube, false);
+    cubes << cube;
+}
+
+class MovingBench extends Bench {
+    int moving;
+    fun void frame(int f) {
+        for (int i; i < moving; i++) {
+            cubes[i].posY(1 + Math.sin((now/second) * 2 + i));
+        }
+    }
+}
+MovingBench bench;
+
+// let every cube settle into the static layer
+bench.warmup();
+
+for (int i; i < MOVING_COUNTS.size(); i++) {
+    MOVING_COUNTS[i] => bench.moving;
+    bench.report(MOVING_COUNTS[i] + " moving casters:");
+}
@@ -0,0 +1,36 @@
+// Grid of meshes that each have their own SphereGeometry, with and without
+// Geometry.autoShare(). Shared geometries draw from the same GPU buffers, so
+// all meshes batch into a single instanced draw instead of one draw (and one
+// set of vertex buffers) per mesh. Run with Bench.ck
+
+30 => int GRID;
+
+GG.scene().camera( new GOrbitCamera );
+@(0, 0, 40) => GG.scene().camera().pos;
+
+SphereGeometry geos[GRID * GRID];
+PhongMaterial mat;
+
+for (int i; i < geos.size(); i++) {
+    GMesh mesh(geos[i], mat) --> GG.scene();
+    @((i % GRID - GRID / 2) * 1.2, (i / GRID - GRID / 2) * 1.2, 0) => mesh.pos;
+}
+
+fun void rebuildAll()
+{
+    for (int i; i < geos.size(); i++) {
+        geos[i].build(.5, 64, 32, 0, Math.two_pi, 0, Math.pi);
+    }
+}
+
+Bench bench;
+
+false => Geometry.autoShare;
+rebuildAll();
+bench.warmup(); // let the buffers upload
+bench.report("unshared:");
+
+true => Geometry.autoShare;
+rebuildAll();
+bench.warmup();
+bench.report("shared:");
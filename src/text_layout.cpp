@@ -0,0 +1,230 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "text_layout.h"
+#include "core/hashmap.h"
+
+#include <unordered_map>
+
+struct TextLayout_Key {
+    u64 hash;
+    u32 byte_count;
+    u32 font_id;
+    float size;
+    float wrap_width;
+
+    bool operator==(const TextLayout_Key& other) const
+    {
+        return hash == other.hash && byte_count == other.byte_count
+               && font_id == other.font_id && size == other.size
+               && wrap_width == other.wrap_width;
+    }
+};
+
+struct TextLayout_KeyHash {
+    size_t operator()(const TextLayout_Key& key) const
+    {
+        return (size_t)hashmap_xxhash3(&key, sizeof(key), 0, 0);
+    }
+};
+
+struct TextLayout_Entry {
+    u32 line_offset; // into TextLayout_Cache::lines
+    u32 line_count;
+};
+
+struct TextLayout_Cache {
+    std::unordered_map<TextLayout_Key, TextLayout_Entry, TextLayout_KeyHash> entries;
+    Arena lines;  // R_TextLine, glyph_offset indexes glyphs
+    Arena glyphs; // R_TextGlyph
+
+    // scratch for TextLayout_layoutParagraph
+    Arena charcodes; // u32
+    Arena pen_x;     // float, pen position before each charcode
+};
+
+static TextLayout_Cache text_layout_cache;
+
+static bool TextLayout_isWhiteSpace(u32 c)
+{
+    switch (c) {
+        case ' ':
+        case '\t': return true;
+        default: return false;
+    }
+}
+
+FT_Pos TextLayout_Kerning(R_Font* font, FT_UInt left, FT_UInt right)
+{
+    if (left == 0 || right == 0 || !FT_HAS_KERNING(font->face)) return 0;
+
+    u64 pair = ((u64)left << 32) | (u64)right;
+    auto it  = font->kerningPairs.find(pair);
+    if (it != font->kerningPairs.end()) return it->second;
+
+    FT_Vector kerning = {};
+    FT_Error error
+      = FT_Get_Kerning(font->face, left, right, font->kerningMode, &kerning);
+    FT_Pos result             = error ? 0 : kerning.x;
+    font->kerningPairs[pair] = result;
+    return result;
+}
+
+// uncached layout, see TextLayout_Paragraph
+static void TextLayout_layoutParagraph(R_Font* font, float size, float wrap_width,
+                                       const char* begin, const char* end,
+                                       Arena* lines, Arena* glyphs)
+{
+    Arena* charcodes = &text_layout_cache.charcodes;
+    Arena* pen_x     = &text_layout_cache.pen_x;
+
+    Arena::clear(charcodes);
+    char* it = (char*)begin;
+    while (it < end) {
+        u32 charcode = R_Font_decodeCharcode(&it);
+        if (charcode == '\r') continue;
+        *ARENA_PUSH_TYPE(charcodes, u32) = charcode;
+    }
+
+    u32 n        = ARENA_LENGTH(charcodes, u32);
+    u32* cc      = (u32*)charcodes->base;
+    bool wrap    = (wrap_width > 0);
+    float scale  = size / font->emSize;
+    u32 line_beg = 0;
+
+    Arena::clear(pen_x);
+    float* xs = ARENA_PUSH_ZERO_COUNT(pen_x, float, n + 1);
+
+    while (true) {
+        // measure until the line must break
+        float x          = 0;
+        FT_UInt previous = 0;
+        i64 last_ws      = -1;
+        u32 line_end     = n;
+        u32 next_beg     = n;
+        bool broke       = false;
+        for (u32 i = line_beg; i <= n; i++) {
+            xs[i] = x;
+
+            bool at_end = (i == n);
+            bool is_ws  = !at_end && TextLayout_isWhiteSpace(cc[i]);
+            if ((at_end || is_ws) && wrap && x > wrap_width) {
+                if (last_ws >= 0) {
+                    line_end = (u32)last_ws;
+                    next_beg = (u32)last_ws + 1;
+                } else {
+                    line_end = i;
+                    next_beg = MIN(i + 1, n);
+                }
+                broke = true;
+                break;
+            }
+            if (at_end) break;
+            if (is_ws) last_ws = i;
+
+            Glyph* glyph = R_Font_getGlyph(font, cc[i]);
+            x += (float)TextLayout_Kerning(font, previous, glyph->index) * scale;
+            x += (float)glyph->advance * scale;
+            previous = glyph->index;
+        }
+
+        R_TextLine* line   = ARENA_PUSH_TYPE(lines, R_TextLine);
+        line->glyph_offset = ARENA_LENGTH(glyphs, R_TextGlyph);
+        line->glyph_count  = line_end - line_beg;
+        line->width        = xs[line_end];
+        R_TextGlyph* out   = ARENA_PUSH_COUNT(glyphs, R_TextGlyph, line->glyph_count);
+        for (u32 i = line_beg; i < line_end; i++) {
+            out[i - line_beg].x            = xs[i];
+            out[i - line_beg].buffer_index = R_Font_getGlyph(font, cc[i])->bufferIndex;
+        }
+
+        if (!broke || next_beg >= n) break;
+        line_beg = next_beg;
+    }
+}
+
+void TextLayout_CopyLines(R_TextLine* src, u32 count, Arena* src_glyphs,
+                                 Arena* dst_lines, Arena* dst_glyphs)
+{
+    for (u32 i = 0; i < count; i++) {
+        R_TextLine* line   = ARENA_PUSH_TYPE(dst_lines, R_TextLine);
+        *line              = src[i];
+        line->glyph_offset = ARENA_LENGTH(dst_glyphs, R_TextGlyph);
+        if (src[i].glyph_count == 0) continue;
+        memcpy(ARENA_PUSH_COUNT(dst_glyphs, R_TextGlyph, src[i].glyph_count),
+               ARENA_GET_TYPE(src_glyphs, R_TextGlyph, src[i].glyph_offset),
+               sizeof(R_TextGlyph) * src[i].glyph_count);
+    }
+}
+
+void TextLayout_Paragraph(R_Font* font, float size, float wrap_width, const char* begin,
+                          const char* end, u64 hash, Arena* lines, Arena* glyphs)
+{
+    TextLayout_Cache* cache = &text_layout_cache;
+
+    TextLayout_Key key = {};
+    key.hash           = hash;
+    key.byte_count     = (u32)(end - begin);
+    key.font_id        = font->id;
+    key.size           = size;
+    key.wrap_width     = wrap_width;
+
+    auto it = cache->entries.find(key);
+    if (it != cache->entries.end()) {
+        TextLayout_CopyLines(
+          ARENA_GET_TYPE(&cache->lines, R_TextLine, it->second.line_offset),
+          it->second.line_count, &cache->glyphs, lines, glyphs);
+        return;
+    }
+
+    // miss: lay out into the cache, then copy out
+    if (ARENA_LENGTH(&cache->glyphs, R_TextGlyph) > TEXT_LAYOUT_CACHE_MAX_GLYPHS) {
+        cache->entries.clear();
+        Arena::clear(&cache->lines);
+        Arena::clear(&cache->glyphs);
+    }
+
+    TextLayout_Entry entry = {};
+    entry.line_offset      = ARENA_LENGTH(&cache->lines, R_TextLine);
+    TextLayout_layoutParagraph(font, size, wrap_width, begin, end, &cache->lines,
+                               &cache->glyphs);
+    entry.line_count    = ARENA_LENGTH(&cache->lines, R_TextLine) - entry.line_offset;
+    cache->entries[key] = entry;
+
+    TextLayout_CopyLines(ARENA_GET_TYPE(&cache->lines, R_TextLine, entry.line_offset),
+                         entry.line_count, &cache->glyphs, lines, glyphs);
+}
+
+void TextLayout_Free()
+{
+    TextLayout_Cache* cache = &text_layout_cache;
+    cache->entries.clear();
+    Arena::free(&cache->lines);
+    Arena::free(&cache->glyphs);
+    Arena::free(&cache->charcodes);
+    Arena::free(&cache->pen_x);
+}
@@ -0,0 +1,69 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+#include "core/memory.h"
+#include "r_component.h"
+
+// ============================================================================
+// Text Layout
+// ============================================================================
+// Lays out GText paragraphs (text between two '\n') into lines of R_TextGlyph
+// instances for R_Font::updateText().
+//
+// Lines are greedily wrapped at the last whitespace before they exceed the
+// wrap width. A single word wider than the wrap width is not broken. Kerning
+// comes from the font's kerning table and is cached per glyph pair on the
+// R_Font.
+//
+// Layouts are cached in a table shared by every GText and keyed by
+// (paragraph hash, R_Font::id, size, wrap width), so repeated labels are laid
+// out once. Font ids are never reused, so entries of a freed font are simply
+// never hit again. The cache is reset when it grows past
+// TEXT_LAYOUT_CACHE_MAX_GLYPHS.
+// Render thread only.
+
+#define TEXT_LAYOUT_CACHE_MAX_GLYPHS (1 << 18)
+
+// kerning between two glyph indices in font units
+FT_Pos TextLayout_Kerning(R_Font* font, FT_UInt left, FT_UInt right);
+
+// Appends the lines of paragraph [begin, end) to lines (R_TextLine) and its
+// glyphs to glyphs (R_TextGlyph). line.glyph_offset indexes into glyphs.
+// hash must be hashmap_xxhash3(begin, end - begin, 0, 0).
+// Always appends at least one (possibly empty) line.
+void TextLayout_Paragraph(R_Font* font, float size, float wrap_width, const char* begin,
+                          const char* end, u64 hash, Arena* lines, Arena* glyphs);
+
+// appends count lines (and their glyphs, read from src_glyphs) to dst_lines,
+// rebasing glyph offsets onto dst_glyphs
+void TextLayout_CopyLines(R_TextLine* src, u32 count, Arena* src_glyphs,
+                          Arena* dst_lines, Arena* dst_glyphs);
+
+void TextLayout_Free();
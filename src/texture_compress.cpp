@@ -0,0 +1,819 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "texture_compress.h"
+#include "graphics.h"
+
+#include "core/hashmap.h"
+#include "core/log.h"
+#include "core/spinlock.h"
+
+#include <atomic>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>  // _mkdir
+#include <process.h> // _getpid
+#else
+#include <sys/stat.h> // mkdir
+#include <unistd.h>   // getpid
+#endif
+
+static thread_local const char* compressed_image_failure_reason = "";
+
+static bool CompressedImage_fail(const char* reason)
+{
+    compressed_image_failure_reason = reason;
+    return false;
+}
+
+const char* CompressedImage_failureReason()
+{
+    return compressed_image_failure_reason;
+}
+
+static u32 CompressedImage_readU32(const u8* p)
+{
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u64 CompressedImage_readU64(const u8* p)
+{
+    return (u64)CompressedImage_readU32(p) | ((u64)CompressedImage_readU32(p + 4) << 32);
+}
+
+static void CompressedImage_writeU32(u8* p, u32 v)
+{
+    p[0] = (u8)v;
+    p[1] = (u8)(v >> 8);
+    p[2] = (u8)(v >> 16);
+    p[3] = (u8)(v >> 24);
+}
+
+// size of one layer of the given mip, in bytes
+static size_t CompressedImage_mipSize(WGPUTextureFormat format, u32 width, u32 height,
+                                      u32 mip)
+{
+    G_FormatBlockInfo block = {};
+    G_formatBlockInfo(format, &block);
+    u32 w = MAX(width >> mip, 1u);
+    u32 h = MAX(height >> mip, 1u);
+    return (size_t)((w + block.width - 1) / block.width)
+           * ((h + block.height - 1) / block.height) * block.bytes;
+}
+
+// checks shared by both containers once format, size, layers and mips are known
+static bool CompressedImage_validate(CompressedImage* image)
+{
+    G_FormatBlockInfo block = {};
+    if (image->format == WGPUTextureFormat_Undefined
+        || !G_formatBlockInfo(image->format, &block))
+        return CompressedImage_fail("unsupported texture format");
+    if (image->width == 0 || image->height == 0)
+        return CompressedImage_fail("image has zero size");
+    // webgpu requires mip 0 of compressed textures to be whole blocks
+    if (image->width % block.width || image->height % block.height)
+        return CompressedImage_fail("image size is not a multiple of the block size");
+    if (image->layers != 1 && image->layers != 6)
+        return CompressedImage_fail("only 2D textures and cubemaps are supported");
+    if (image->mip_levels > COMPRESSED_IMAGE_MAX_MIPS
+        || image->mip_levels > G_mipLevels(image->width, image->height))
+        return CompressedImage_fail("too many mip levels");
+
+    for (u32 mip = 0; mip < image->mip_levels; mip++) {
+        image->sizes[mip]
+          = CompressedImage_mipSize(image->format, image->width, image->height, mip);
+    }
+    return true;
+}
+
+// ============================================================================
+// KTX2
+// ============================================================================
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+// Only non-supercompressed files are supported (no Basis Universal / zstd)
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+static const u8 ktx2_identifier[12]
+  = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+static WGPUTextureFormat CompressedImage_formatFromVk(u32 vk_format)
+{
+    // ASTC formats come in UNORM, SRGB pairs starting at 157
+    static const WGPUTextureFormat astc_formats[] = {
+        WGPUTextureFormat_ASTC4x4Unorm,   WGPUTextureFormat_ASTC5x4Unorm,
+        WGPUTextureFormat_ASTC5x5Unorm,   WGPUTextureFormat_ASTC6x5Unorm,
+        WGPUTextureFormat_ASTC6x6Unorm,   WGPUTextureFormat_ASTC8x5Unorm,
+        WGPUTextureFormat_ASTC8x6Unorm,   WGPUTextureFormat_ASTC8x8Unorm,
+        WGPUTextureFormat_ASTC10x5Unorm,  WGPUTextureFormat_ASTC10x6Unorm,
+        WGPUTextureFormat_ASTC10x8Unorm,  WGPUTextureFormat_ASTC10x10Unorm,
+        WGPUTextureFormat_ASTC12x10Unorm, WGPUTextureFormat_ASTC12x12Unorm,
+    };
+    if (vk_format >= 157 && vk_format <= 184) return astc_formats[(vk_format - 157) / 2];
+
+    switch (vk_format) {
+        case 37:  // VK_FORMAT_R8G8B8A8_UNORM
+        case 43:  // VK_FORMAT_R8G8B8A8_SRGB
+            return WGPUTextureFormat_RGBA8Unorm;
+        case 97:  // VK_FORMAT_R16G16B16A16_SFLOAT
+            return WGPUTextureFormat_RGBA16Float;
+        case 109: // VK_FORMAT_R32G32B32A32_SFLOAT
+            return WGPUTextureFormat_RGBA32Float;
+        case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+            return WGPUTextureFormat_BC1RGBAUnorm;
+        case 135:
+        case 136: return WGPUTextureFormat_BC2RGBAUnorm;
+        case 137:
+        case 138: return WGPUTextureFormat_BC3RGBAUnorm;
+        case 139: return WGPUTextureFormat_BC4RUnorm;
+        case 140: return WGPUTextureFormat_BC4RSnorm;
+        case 141: return WGPUTextureFormat_BC5RGUnorm;
+        case 142: return WGPUTextureFormat_BC5RGSnorm;
+        case 143: return WGPUTextureFormat_BC6HRGBUfloat;
+        case 144: return WGPUTextureFormat_BC6HRGBFloat;
+        case 145:
+        case 146: return WGPUTextureFormat_BC7RGBAUnorm;
+        case 147:
+        case 148: return WGPUTextureFormat_ETC2RGB8Unorm;
+        case 149:
+        case 150: return WGPUTextureFormat_ETC2RGB8A1Unorm;
+        case 151:
+        case 152: return WGPUTextureFormat_ETC2RGBA8Unorm;
+        case 153: return WGPUTextureFormat_EACR11Unorm;
+        case 154: return WGPUTextureFormat_EACR11Snorm;
+        case 155: return WGPUTextureFormat_EACRG11Unorm;
+        case 156: return WGPUTextureFormat_EACRG11Snorm;
+        default: return WGPUTextureFormat_Undefined;
+    }
+}
+
+static bool CompressedImage_parseKTX2(const u8* data, size_t size, bool header_only,
+                                      CompressedImage* image)
+{
+    if (size < KTX2_HEADER_SIZE) return CompressedImage_fail("truncated KTX2 header");
+
+    u32 vk_format      = CompressedImage_readU32(data + 12);
+    u32 pixel_depth    = CompressedImage_readU32(data + 28);
+    u32 layer_count    = CompressedImage_readU32(data + 32);
+    u32 face_count     = CompressedImage_readU32(data + 36);
+    u32 level_count    = CompressedImage_readU32(data + 40);
+    u32 supercompression = CompressedImage_readU32(data + 44);
+
+    if (supercompression != 0)
+        return CompressedImage_fail(
+          "supercompressed KTX2 (Basis Universal, zstd) is not supported");
+    if (pixel_depth > 1 || layer_count > 1)
+        return CompressedImage_fail("3D and array KTX2 textures are not supported");
+
+    image->format     = CompressedImage_formatFromVk(vk_format);
+    image->width      = CompressedImage_readU32(data + 20);
+    image->height     = CompressedImage_readU32(data + 24);
+    image->layers     = face_count;
+    image->mip_levels = MAX(level_count, 1u); // 0 means "generate mips"
+    if (!CompressedImage_validate(image)) return false;
+
+    size_t level_index_end
+      = KTX2_HEADER_SIZE + (size_t)image->mip_levels * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+    if (header_only) return true;
+    if (size < level_index_end) return CompressedImage_fail("truncated KTX2 level index");
+
+    for (u32 mip = 0; mip < image->mip_levels; mip++) {
+        const u8* entry = data + KTX2_HEADER_SIZE + mip * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        u64 byte_offset = CompressedImage_readU64(entry);
+        u64 byte_length = CompressedImage_readU64(entry + 8);
+
+        if (byte_length < (u64)image->sizes[mip] * image->layers
+            || byte_length > size || byte_offset > size - byte_length)
+            return CompressedImage_fail("KTX2 level data out of bounds");
+
+        // faces of a level are tightly packed
+        for (u32 layer = 0; layer < image->layers; layer++) {
+            image->offsets[layer][mip] = byte_offset + layer * image->sizes[mip];
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// DDS
+// ============================================================================
+// https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 128  // magic + DDS_HEADER
+#define DDS_HEADER_DX10_SIZE 20
+#define DDSD_LINEARSIZE 0x80000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_DEPTH 0x800000
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xFC00
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+#define DDS_FOURCC(a, b, c, d) ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+static WGPUTextureFormat CompressedImage_formatFromDXGI(u32 dxgi_format)
+{
+    switch (dxgi_format) {
+        case 2: return WGPUTextureFormat_RGBA32Float;  // R32G32B32A32_FLOAT
+        case 10: return WGPUTextureFormat_RGBA16Float; // R16G16B16A16_FLOAT
+        case 28:                                       // R8G8B8A8_UNORM
+        case 29: return WGPUTextureFormat_RGBA8Unorm;  // R8G8B8A8_UNORM_SRGB
+        case 71:
+        case 72: return WGPUTextureFormat_BC1RGBAUnorm;
+        case 74:
+        case 75: return WGPUTextureFormat_BC2RGBAUnorm;
+        case 77:
+        case 78: return WGPUTextureFormat_BC3RGBAUnorm;
+        case 80: return WGPUTextureFormat_BC4RUnorm;
+        case 81: return WGPUTextureFormat_BC4RSnorm;
+        case 83: return WGPUTextureFormat_BC5RGUnorm;
+        case 84: return WGPUTextureFormat_BC5RGSnorm;
+        case 95: return WGPUTextureFormat_BC6HRGBUfloat;
+        case 96: return WGPUTextureFormat_BC6HRGBFloat;
+        case 98:
+        case 99: return WGPUTextureFormat_BC7RGBAUnorm;
+        default: return WGPUTextureFormat_Undefined;
+    }
+}
+
+static WGPUTextureFormat CompressedImage_formatFromDDSPixelFormat(const u8* pf)
+{
+    u32 flags = CompressedImage_readU32(pf + 4);
+    if (flags & DDPF_FOURCC) {
+        switch (CompressedImage_readU32(pf + 8)) {
+            case DDS_FOURCC('D', 'X', 'T', '1'): return WGPUTextureFormat_BC1RGBAUnorm;
+            case DDS_FOURCC('D', 'X', 'T', '2'):
+            case DDS_FOURCC('D', 'X', 'T', '3'): return WGPUTextureFormat_BC2RGBAUnorm;
+            case DDS_FOURCC('D', 'X', 'T', '4'):
+            case DDS_FOURCC('D', 'X', 'T', '5'): return WGPUTextureFormat_BC3RGBAUnorm;
+            case DDS_FOURCC('A', 'T', 'I', '1'):
+            case DDS_FOURCC('B', 'C', '4', 'U'): return WGPUTextureFormat_BC4RUnorm;
+            case DDS_FOURCC('B', 'C', '4', 'S'): return WGPUTextureFormat_BC4RSnorm;
+            case DDS_FOURCC('A', 'T', 'I', '2'):
+            case DDS_FOURCC('B', 'C', '5', 'U'): return WGPUTextureFormat_BC5RGUnorm;
+            case DDS_FOURCC('B', 'C', '5', 'S'): return WGPUTextureFormat_BC5RGSnorm;
+            default: return WGPUTextureFormat_Undefined;
+        }
+    }
+
+    // uncompressed, only RGBA byte order (no BGRA swizzle)
+    if ((flags & DDPF_RGB) && CompressedImage_readU32(pf + 12) == 32
+        && CompressedImage_readU32(pf + 16) == 0x000000FF
+        && CompressedImage_readU32(pf + 20) == 0x0000FF00
+        && CompressedImage_readU32(pf + 24) == 0x00FF0000) {
+        return WGPUTextureFormat_RGBA8Unorm;
+    }
+    return WGPUTextureFormat_Undefined;
+}
+
+static bool CompressedImage_parseDDS(const u8* data, size_t size, bool header_only,
+                                     CompressedImage* image)
+{
+    if (size < DDS_HEADER_SIZE) return CompressedImage_fail("truncated DDS header");
+
+    u32 flags      = CompressedImage_readU32(data + 8);
+    u32 depth      = CompressedImage_readU32(data + 24);
+    u32 mip_count  = CompressedImage_readU32(data + 28);
+    const u8* pf   = data + 76;
+    u32 caps2      = CompressedImage_readU32(data + 112);
+    size_t offset  = DDS_HEADER_SIZE;
+    bool is_cube   = (caps2 & DDSCAPS2_CUBEMAP) != 0;
+
+    if ((flags & DDSD_DEPTH) && depth > 1)
+        return CompressedImage_fail("volume DDS textures are not supported");
+
+    if (CompressedImage_readU32(pf + 8) == DDS_FOURCC('D', 'X', '1', '0')) {
+        if (size < DDS_HEADER_SIZE + DDS_HEADER_DX10_SIZE)
+            return CompressedImage_fail("truncated DDS DX10 header");
+        const u8* dx10 = data + DDS_HEADER_SIZE;
+        image->format  = CompressedImage_formatFromDXGI(CompressedImage_readU32(dx10));
+        is_cube = (CompressedImage_readU32(dx10 + 8) & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+        if (CompressedImage_readU32(dx10 + 12) > 1)
+            return CompressedImage_fail("array DDS textures are not supported");
+        offset += DDS_HEADER_DX10_SIZE;
+    } else {
+        image->format = CompressedImage_formatFromDDSPixelFormat(pf);
+        if (is_cube
+            && (caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+            return CompressedImage_fail("DDS cubemap is missing faces");
+    }
+
+    image->height     = CompressedImage_readU32(data + 12);
+    image->width      = CompressedImage_readU32(data + 16);
+    image->layers     = is_cube ? 6 : 1;
+    image->mip_levels = (flags & DDSD_MIPMAPCOUNT) ? MAX(mip_count, 1u) : 1;
+    if (!CompressedImage_validate(image)) return false;
+    if (header_only) return true;
+
+    // each face stores its full mip chain before the next face
+    for (u32 layer = 0; layer < image->layers; layer++) {
+        for (u32 mip = 0; mip < image->mip_levels; mip++) {
+            image->offsets[layer][mip] = offset;
+            offset += image->sizes[mip];
+        }
+    }
+    if (offset > size) return CompressedImage_fail("truncated DDS data");
+    return true;
+}
+
+// ============================================================================
+// CompressedImage
+// ============================================================================
+
+static bool CompressedImage_parse(const u8* data, size_t size, bool header_only,
+                                  CompressedImage* image)
+{
+    if (size >= sizeof(ktx2_identifier)
+        && memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0) {
+        return CompressedImage_parseKTX2(data, size, header_only, image);
+    }
+    if (size >= 4 && CompressedImage_readU32(data) == DDS_MAGIC) {
+        return CompressedImage_parseDDS(data, size, header_only, image);
+    }
+    return CompressedImage_fail("not a KTX2 or DDS file");
+}
+
+bool CompressedImage_isContainer(const char* filepath)
+{
+    const char* dot = strrchr(filepath, '.');
+    if (!dot) return false;
+    char ext[6] = {};
+    for (int i = 0; i < 5 && dot[i + 1]; i++) ext[i] = (char)tolower(dot[i + 1]);
+    return strcmp(ext, "ktx2") == 0 || strcmp(ext, "dds") == 0;
+}
+
+bool CompressedImage_readInfo(const char* filepath, CompressedImage* info)
+{
+    *info = {};
+
+    // big enough for either header plus a full KTX2 level index
+    u8 header[KTX2_HEADER_SIZE + COMPRESSED_IMAGE_MAX_MIPS * KTX2_LEVEL_INDEX_ENTRY_SIZE];
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return CompressedImage_fail("can't open file");
+    size_t size = fread(header, 1, sizeof(header), file);
+    fclose(file);
+
+    return CompressedImage_parse(header, size, true, info);
+}
+
+bool CompressedImage_load(const char* filepath, CompressedImage* image)
+{
+    *image = {};
+
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return CompressedImage_fail("can't open file");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(file);
+        return CompressedImage_fail("empty file");
+    }
+
+    u8* data    = (u8*)malloc(size);
+    size_t read = fread(data, 1, size, file);
+    fclose(file);
+
+    if (read != (size_t)size || !CompressedImage_parse(data, size, false, image)) {
+        if (read != (size_t)size) CompressedImage_fail("can't read file");
+        free(data);
+        *image = {};
+        return false;
+    }
+
+    image->data_OWNED = data;
+    image->data_size  = size;
+    return true;
+}
+
+void CompressedImage_free(CompressedImage* image)
+{
+    free(image->data_OWNED);
+    *image = {};
+}
+
+// ============================================================================
+// BC encoder
+// ============================================================================
+// Simple single-pass encoder: endpoints from the principal axis of each block,
+// then nearest-palette indices. Not as good as an offline encoder but fast
+// enough to run at load time, and it only runs once per image thanks to
+// TextureCache.
+
+static u16 CompressedImage_pack565(const f32 c[3])
+{
+    int r = (int)(CLAMP(c[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    int g = (int)(CLAMP(c[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+    int b = (int)(CLAMP(c[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void CompressedImage_unpack565(u16 c, int out[3])
+{
+    int r  = (c >> 11) & 31;
+    int g  = (c >> 5) & 63;
+    int b  = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+static void CompressedImage_encodeColorBlock(const u8 block[16][4], u8 out[8])
+{
+    f32 mean[3] = {};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++) mean[c] += block[i][c] / 16.0f;
+
+    // covariance: xx xy xz yy yz zz
+    f32 cov[6] = {};
+    for (int i = 0; i < 16; i++) {
+        f32 d[3] = { block[i][0] - mean[0], block[i][1] - mean[1],
+                     block[i][2] - mean[2] };
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    // principal axis by power iteration
+    f32 axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter = 0; iter < 4; iter++) {
+        f32 x   = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        f32 y   = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        f32 z   = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        f32 len = MAX(MAX(fabsf(x), fabsf(y)), fabsf(z));
+        if (len < 1e-6f) break; // flat block, keep previous axis
+        axis[0] = x / len;
+        axis[1] = y / len;
+        axis[2] = z / len;
+    }
+    f32 axis_len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+    f32 t_min = 0.0f, t_max = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        f32 t = ((block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1]
+                 + (block[i][2] - mean[2]) * axis[2])
+                / axis_len2;
+        t_min = MIN(t_min, t);
+        t_max = MAX(t_max, t);
+    }
+    // inset endpoints slightly, reduces error for the interpolated colors
+    f32 inset = (t_max - t_min) / 16.0f;
+    t_min += inset;
+    t_max -= inset;
+
+    f32 e0[3], e1[3];
+    for (int c = 0; c < 3; c++) {
+        e0[c] = mean[c] + axis[c] * t_max;
+        e1[c] = mean[c] + axis[c] * t_min;
+    }
+    u16 c0 = CompressedImage_pack565(e0);
+    u16 c1 = CompressedImage_pack565(e1);
+    // c0 > c1 selects the 4 color (opaque) mode
+    if (c0 < c1) {
+        u16 tmp = c0;
+        c0      = c1;
+        c1      = tmp;
+    }
+
+    u32 indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        CompressedImage_unpack565(c0, palette[0]);
+        CompressedImage_unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0, best_dist = INT32_MAX;
+            for (int p = 0; p < 4; p++) {
+                int dr   = block[i][0] - palette[p][0];
+                int dg   = block[i][1] - palette[p][1];
+                int db   = block[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best      = p;
+                }
+            }
+            indices |= (u32)best << (2 * i);
+        }
+    }
+
+    out[0] = (u8)c0;
+    out[1] = (u8)(c0 >> 8);
+    out[2] = (u8)c1;
+    out[3] = (u8)(c1 >> 8);
+    CompressedImage_writeU32(out + 4, indices);
+}
+
+static void CompressedImage_encodeAlphaBlock(const u8 block[16][4], u8 out[8])
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        a0 = MAX(a0, (int)block[i][3]);
+        a1 = MIN(a1, (int)block[i][3]);
+    }
+
+    u64 indices = 0;
+    if (a0 != a1) {
+        // a0 > a1 selects the 8 value mode
+        int palette[8] = { a0, a1 };
+        for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0, best_dist = INT32_MAX;
+            for (int p = 0; p < 8; p++) {
+                int dist = abs((int)block[i][3] - palette[p]);
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best      = p;
+                }
+            }
+            indices |= (u64)best << (3 * i);
+        }
+    }
+
+    out[0] = (u8)a0;
+    out[1] = (u8)a1;
+    for (int i = 0; i < 6; i++) out[2 + i] = (u8)(indices >> (8 * i));
+}
+
+// 2x2 box filter, odd sizes clamp to the edge
+static void CompressedImage_downsample(const u8* src, u32 src_w, u32 src_h, u8* dst)
+{
+    u32 dst_w = MAX(src_w / 2, 1u), dst_h = MAX(src_h / 2, 1u);
+    for (u32 y = 0; y < dst_h; y++) {
+        u32 y0 = MIN(2 * y, src_h - 1), y1 = MIN(2 * y + 1, src_h - 1);
+        for (u32 x = 0; x < dst_w; x++) {
+            u32 x0 = MIN(2 * x, src_w - 1), x1 = MIN(2 * x + 1, src_w - 1);
+            for (u32 c = 0; c < 4; c++) {
+                u32 sum = src[(y0 * src_w + x0) * 4 + c] + src[(y0 * src_w + x1) * 4 + c]
+                          + src[(y1 * src_w + x0) * 4 + c]
+                          + src[(y1 * src_w + x1) * 4 + c];
+                dst[(y * dst_w + x) * 4 + c] = (u8)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+bool CompressedImage_encodeBC(const u8* rgba, u32 width, u32 height, bool gen_mips,
+                              CompressedImage* image)
+{
+    *image = {};
+    if (width % 4 || height % 4)
+        return CompressedImage_fail("image size is not a multiple of 4");
+
+    bool has_alpha = false;
+    for (size_t i = 0; i < (size_t)width * height && !has_alpha; i++)
+        has_alpha = rgba[i * 4 + 3] < 255;
+
+    image->format = has_alpha ? WGPUTextureFormat_BC3RGBAUnorm :
+                                WGPUTextureFormat_BC1RGBAUnorm;
+    image->width      = width;
+    image->height     = height;
+    image->layers     = 1;
+    image->mip_levels = gen_mips ? MIN(G_mipLevels(width, height),
+                                       (u32)COMPRESSED_IMAGE_MAX_MIPS) :
+                                   1;
+    if (!CompressedImage_validate(image)) return false;
+
+    for (u32 mip = 0; mip < image->mip_levels; mip++) {
+        image->offsets[0][mip] = image->data_size;
+        image->data_size += image->sizes[mip];
+    }
+    image->data_OWNED = (u8*)malloc(image->data_size);
+
+    // scratch for the current and next mip
+    u8* mip_pixels  = (u8*)malloc((size_t)width * height * 4);
+    u8* next_pixels = (u8*)malloc((size_t)MAX(width / 2, 1u) * MAX(height / 2, 1u) * 4);
+    memcpy(mip_pixels, rgba, (size_t)width * height * 4);
+
+    u32 w = width, h = height;
+    for (u32 mip = 0; mip < image->mip_levels; mip++) {
+        u8* out = image->data_OWNED + image->offsets[0][mip];
+        for (u32 by = 0; by < (h + 3) / 4; by++) {
+            for (u32 bx = 0; bx < (w + 3) / 4; bx++) {
+                // gather block, mips smaller than 4x4 repeat their edge texels
+                u8 block[16][4];
+                for (u32 i = 0; i < 16; i++) {
+                    u32 x = MIN(bx * 4 + i % 4, w - 1);
+                    u32 y = MIN(by * 4 + i / 4, h - 1);
+                    memcpy(block[i], mip_pixels + (y * w + x) * 4, 4);
+                }
+                if (has_alpha) {
+                    CompressedImage_encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+                CompressedImage_encodeColorBlock(block, out);
+                out += 8;
+            }
+        }
+
+        if (mip + 1 < image->mip_levels) {
+            CompressedImage_downsample(mip_pixels, w, h, next_pixels);
+            w = MAX(w / 2, 1u);
+            h = MAX(h / 2, 1u);
+            u8* tmp     = mip_pixels;
+            mip_pixels  = next_pixels;
+            next_pixels = tmp;
+        }
+    }
+
+    free(mip_pixels);
+    free(next_pixels);
+    return true;
+}
+
+bool CompressedImage_writeDDS(const char* filepath, CompressedImage* image)
+{
+    ASSERT(image->layers == 1);
+
+    u8 header[DDS_HEADER_SIZE] = {};
+    CompressedImage_writeU32(header, DDS_MAGIC);
+    CompressedImage_writeU32(header + 4, 124);     // dwSize
+    CompressedImage_writeU32(header + 8, // caps|h|w|fmt
+                             0x1007 | DDSD_LINEARSIZE | DDSD_MIPMAPCOUNT);
+    CompressedImage_writeU32(header + 12, image->height);
+    CompressedImage_writeU32(header + 16, image->width);
+    CompressedImage_writeU32(header + 20, (u32)image->sizes[0]); // linear size
+    CompressedImage_writeU32(header + 28, image->mip_levels);
+    CompressedImage_writeU32(header + 76, 32); // ddspf.dwSize
+    switch (image->format) {
+        case WGPUTextureFormat_BC1RGBAUnorm:
+            CompressedImage_writeU32(header + 80, DDPF_FOURCC);
+            CompressedImage_writeU32(header + 84, DDS_FOURCC('D', 'X', 'T', '1'));
+            break;
+        case WGPUTextureFormat_BC3RGBAUnorm:
+            CompressedImage_writeU32(header + 80, DDPF_FOURCC);
+            CompressedImage_writeU32(header + 84, DDS_FOURCC('D', 'X', 'T', '5'));
+            break;
+        case WGPUTextureFormat_RGBA8Unorm:
+            CompressedImage_writeU32(header + 80, DDPF_RGB | 0x1); // | ALPHAPIXELS
+            CompressedImage_writeU32(header + 88, 32);
+            CompressedImage_writeU32(header + 92, 0x000000FF);
+            CompressedImage_writeU32(header + 96, 0x0000FF00);
+            CompressedImage_writeU32(header + 100, 0x00FF0000);
+            CompressedImage_writeU32(header + 104, 0xFF000000);
+            break;
+        default: return CompressedImage_fail("format can't be written to DDS");
+    }
+    // DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX
+    CompressedImage_writeU32(header + 108, 0x1000 | 0x400000 | 0x8);
+
+    FILE* file = fopen(filepath, "wb");
+    if (!file) return CompressedImage_fail("can't open file for writing");
+
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    for (u32 mip = 0; mip < image->mip_levels && ok; mip++) {
+        ok = fwrite(image->data_OWNED + image->offsets[0][mip], 1, image->sizes[mip],
+                    file)
+             == image->sizes[mip];
+    }
+    ok = (fclose(file) == 0) && ok;
+    return ok ? true : CompressedImage_fail("can't write file");
+}
+
+// ============================================================================
+// TextureCache
+// ============================================================================
+
+// bump when the encoder output changes to invalidate old entries
+#define TEXTURE_CACHE_VERSION 1
+
+static struct {
+    spinlock lock; // guards directory
+    std::string directory;
+    std::atomic<u32> tmp_counter;
+} texture_cache;
+
+static std::string TextureCache_defaultDirectory()
+{
+#if defined(_WIN32)
+    const char* local_app_data = getenv("LOCALAPPDATA");
+    if (local_app_data) return std::string(local_app_data) + "\\ChuGL\\texture-cache";
+#elif defined(__APPLE__)
+    const char* home = getenv("HOME");
+    if (home) return std::string(home) + "/Library/Caches/ChuGL/texture-cache";
+#else
+    const char* xdg_cache = getenv("XDG_CACHE_HOME");
+    if (xdg_cache && xdg_cache[0]) return std::string(xdg_cache) + "/chugl/texture-cache";
+    const char* home = getenv("HOME");
+    if (home) return std::string(home) + "/.cache/chugl/texture-cache";
+#endif
+    return ".chugl-texture-cache";
+}
+
+// mkdir -p, existing directories are fine
+static void TextureCache_makeDirectories(const std::string& path)
+{
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i < path.size() && path[i] != '/' && path[i] != '\\') continue;
+        std::string prefix = path.substr(0, i);
+#ifdef _WIN32
+        _mkdir(prefix.c_str());
+#else
+        mkdir(prefix.c_str(), 0755);
+#endif
+    }
+}
+
+static int TextureCache_processID()
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
+
+void TextureCache_setDirectory(const char* dir)
+{
+    spinlock::lock(&texture_cache.lock);
+    texture_cache.directory = dir ? dir : "";
+    spinlock::unlock(&texture_cache.lock);
+}
+
+std::string TextureCache_directory()
+{
+    spinlock::lock(&texture_cache.lock);
+    if (texture_cache.directory.empty()) {
+        texture_cache.directory = TextureCache_defaultDirectory();
+    }
+    std::string dir = texture_cache.directory;
+    spinlock::unlock(&texture_cache.lock);
+    return dir;
+}
+
+std::string TextureCache_entryPath(const void* data, size_t size, bool flip_y,
+                                   bool gen_mips)
+{
+    u64 options = ((u64)TEXTURE_CACHE_VERSION << 2) | (flip_y ? 2 : 0) | (gen_mips ? 1 : 0);
+    u64 hash    = hashmap_xxhash3(data, size, options, size);
+
+    std::string dir = TextureCache_directory();
+    TextureCache_makeDirectories(dir);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx.dds", (unsigned long long)hash);
+    return dir + name;
+}
+
+bool TextureCache_store(const std::string& entry_path, CompressedImage* image)
+{
+    // write to a temporary file and rename, so that a concurrent reader (e.g.
+    // another ChuGL instance) never sees a partially written entry
+    // the pid keeps temporary names from colliding across processes
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", TextureCache_processID(),
+             texture_cache.tmp_counter.fetch_add(1, std::memory_order_relaxed));
+    std::string tmp_path = entry_path + suffix;
+
+    if (!CompressedImage_writeDDS(tmp_path.c_str(), image)) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    if (rename(tmp_path.c_str(), entry_path.c_str()) != 0) {
+        // windows won't replace an existing file, someone else already wrote it
+        remove(tmp_path.c_str());
+    }
+    return true;
+}
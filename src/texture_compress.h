@@ -0,0 +1,107 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+#include <webgpu/webgpu.h>
+
+#include <string>
+
+// ============================================================================
+// CompressedImage
+// ============================================================================
+// GPU-ready texture data loaded from a KTX2 or DDS container, or produced by
+// the BC encoder below. Mip levels are stored as-is and uploaded directly,
+// compressed formats can't be rendered to so MipMapGenerator is never used.
+//
+// All functions are CPU-only and thread-safe, they run on the Jobs workers.
+// Uploading lives in R_Texture.
+//
+// sRGB variants are loaded as their UNORM equivalent (same bits). ChuGL
+// textures are never sRGB, shaders do the conversion themselves.
+
+#define COMPRESSED_IMAGE_MAX_MIPS 16
+#define COMPRESSED_IMAGE_MAX_LAYERS 6
+
+struct CompressedImage {
+    WGPUTextureFormat format;
+    u32 width;
+    u32 height;
+    u32 layers; // 1, or 6 for cubemaps
+    u32 mip_levels;
+
+    u8* data_OWNED; // free with CompressedImage_free()
+    size_t data_size;
+    // byte offset of each (layer, mip) image within data_OWNED
+    size_t offsets[COMPRESSED_IMAGE_MAX_LAYERS][COMPRESSED_IMAGE_MAX_MIPS];
+    // byte size of a single layer at each mip
+    size_t sizes[COMPRESSED_IMAGE_MAX_MIPS];
+};
+
+// true for .ktx2 and .dds files
+bool CompressedImage_isContainer(const char* filepath);
+
+// parses only the header, enough to create the texture before the data is
+// loaded. info->data_OWNED is left NULL
+bool CompressedImage_readInfo(const char* filepath, CompressedImage* info);
+
+bool CompressedImage_load(const char* filepath, CompressedImage* image);
+
+// encodes RGBA8 pixels as BC1, or BC3 if any pixel is translucent. Width and
+// height must be multiples of 4. Builds a box-filtered mip chain if gen_mips
+bool CompressedImage_encodeBC(const u8* rgba, u32 width, u32 height, bool gen_mips,
+                              CompressedImage* image);
+
+// writes BC1/BC3/RGBA8 images as a .dds file (used by TextureCache)
+bool CompressedImage_writeDDS(const char* filepath, CompressedImage* image);
+
+void CompressedImage_free(CompressedImage* image);
+
+// reason the last call on this thread failed, like stbi_failure_reason()
+const char* CompressedImage_failureReason();
+
+// ============================================================================
+// TextureCache
+// ============================================================================
+// Content-addressed on-disk cache of images transcoded to BC formats, so that
+// later runs skip the png/jpg decode and upload compressed data directly.
+// Entries are keyed by a hash of the source file bytes + load options, stale
+// entries are never read because any change to the source changes the key.
+
+// defaults to the platform cache folder, e.g. ~/.cache/chugl/texture-cache
+void TextureCache_setDirectory(const char* dir);
+std::string TextureCache_directory();
+
+// path of the cache entry for the given source bytes, creates the cache
+// directory if needed
+std::string TextureCache_entryPath(const void* data, size_t size, bool flip_y,
+                                   bool gen_mips);
+
+// atomically writes image to entry_path
+bool TextureCache_store(const std::string& entry_path, CompressedImage* image);
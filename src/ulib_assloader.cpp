@@ -104,6 +104,7 @@ CK_DLL_CTOR(gmodel_ctor_with_fp_and_desc);
 // ModelLoadDesc offsets
 static t_CKUINT model_load_desc_offset_flip_texture_y = 0;
 static t_CKUINT model_load_desc_offset_combine_geos   = 0;
+static t_CKUINT model_load_desc_offset_optimize       = 0;
 
 CK_DLL_CTOR(model_load_desc_ctor);
 
@@ -144,6 +145,12 @@ void ulib_assloader_query(Chuck_DL_Query* QUERY)
           "is a quick fix to account for differences in Y-axis convention across "
           "different asset creation tools");
 
+        model_load_desc_offset_optimize = MVAR("int", "optimize", false);
+        DOC_VAR(
+          "Default false. If true, will merge duplicate vertices and reorder each "
+          "model geometry for faster rendering, see Geometry.optimize(). Always done "
+          "when Geometry.autoOptimize() is enabled");
+
         CTOR(model_load_desc_ctor);
 
         END_CLASS();
@@ -208,6 +215,7 @@ void ulib_assloader_query(Chuck_DL_Query* QUERY)
 struct SG_AssetLoadDesc {
     int combine_geos    = 0;
     int textures_flip_y = 0;
+    int optimize        = 0;
 
     static SG_AssetLoadDesc from(Chuck_Object* ckobj)
     {
@@ -215,6 +223,7 @@ struct SG_AssetLoadDesc {
         return {
             (int)OBJ_MEMBER_INT(ckobj, model_load_desc_offset_combine_geos),
             (int)OBJ_MEMBER_INT(ckobj, model_load_desc_offset_flip_texture_y),
+            (int)OBJ_MEMBER_INT(ckobj, model_load_desc_offset_optimize),
         };
     }
 };
@@ -575,6 +584,9 @@ static ModelLoadObjResult ulib_assloader_tinyobj_load(const char* filepath,
                 SG_Material* mat = SG_GetMaterial(material_ids[i]);
 
                 // update
+                if (desc.optimize || ulib_geometry_auto_optimize()) {
+                    ulib_geometry_optimize(geo, NULL);
+                }
                 CQ_UpdateAllVertexAttributes(geo);
 
                 // create mesh
@@ -758,4 +770,5 @@ CK_DLL_CTOR(model_load_desc_ctor)
 {
     OBJ_MEMBER_INT(SELF, model_load_desc_offset_combine_geos)   = 0;
     OBJ_MEMBER_INT(SELF, model_load_desc_offset_flip_texture_y) = 0;
+    OBJ_MEMBER_INT(SELF, model_load_desc_offset_optimize)       = 0;
 }
@@ -30,6 +30,10 @@
 
 #include "ulib_helper.h"
 
+#include "physics.h"
+
+#include "core/jobs.h"
+
 /*
 Experiment to integrate Box2D without OOP.
 This is true to the original Box2D API, and has better performance.
@@ -48,7 +52,7 @@ body_def)
 
 // box2d is not threadsafe, only registered graphics shreds can call the b2 API
 // OR box2d can be safely called before the first GG.nextFrame()
-#define ulib_box2d_accessAllowed                                                       \
+#define ulib_box2d_accessChecked                                                       \
     {                                                                                  \
         static bool printed      = false;                                              \
         bool is_shred_registered = Sync_IsShredRegistered(SHRED);                      \
@@ -61,6 +65,13 @@ body_def)
         if (access_denied) return;                                                     \
     }
 
+// Also waits out any steps still running on the physics thread. Body accessors
+// that go through the snapshot and Physics_BodyWrite() only need
+// ulib_box2d_accessChecked
+#define ulib_box2d_accessAllowed                                                       \
+    ulib_box2d_accessChecked;                                                          \
+    Physics_Wait()
+
 // make sure we can fit b2 ids within a t_CKINT
 static_assert(sizeof(void*) == sizeof(t_CKUINT), "pointer size mismatch");
 static_assert(sizeof(b2WorldId) <= sizeof(t_CKINT), "b2Worldsize mismatch");
@@ -425,9 +436,15 @@ CK_DLL_DTOR(b2_DebugDraw_dtor);
 
 // b2
 struct b2_SimulateDesc b2_sim_desc = {};
+// GGens following a body, see Physics_Bindings. Audio thread only
+static Physics_Bindings b2_ggen_bindings;
+static void b2_UnbindDestroyedBodies();
 CK_DLL_SFUN(chugl_set_b2World);
 CK_DLL_SFUN(b2_set_substep_count);
 CK_DLL_SFUN(b2_set_simulation_rate);
+CK_DLL_SFUN(b2_set_fixed_timestep);
+CK_DLL_SFUN(b2_set_physics_thread);
+CK_DLL_SFUN(b2_get_interpolation_alpha);
 
 CK_DLL_SFUN(b2_CreateWorld);
 CK_DLL_SFUN(b2_DestroyWorld);
@@ -511,6 +528,7 @@ CK_DLL_SFUN(b2_World_SetGravity);
 CK_DLL_SFUN(b2_World_GetGravity);
 CK_DLL_SFUN(b2_World_Explode);
 CK_DLL_SFUN(b2_World_SetContactTuning);
+CK_DLL_SFUN(b2_World_GetStepTime);
 
 // b2Polygon ----------------------------------------------------------
 CK_DLL_DTOR(b2Polygon_dtor);
@@ -597,6 +615,13 @@ CK_DLL_SFUN(b2_Body_get_type);
 CK_DLL_SFUN(b2_Body_get_rotation);
 CK_DLL_SFUN(b2_Body_set_rotation);
 CK_DLL_SFUN(b2_Body_get_angle);
+CK_DLL_SFUN(b2_Body_get_interpolated_position);
+CK_DLL_SFUN(b2_Body_get_interpolated_angle);
+CK_DLL_SFUN(b2_Body_get_positions);
+CK_DLL_SFUN(b2_Body_get_angles);
+CK_DLL_SFUN(b2_Body_get_interpolated_transforms);
+CK_DLL_SFUN(b2_Body_bind_ggen);
+CK_DLL_SFUN(b2_Body_unbind_ggen);
 CK_DLL_SFUN(b2_Body_set_transform);
 CK_DLL_SFUN(b2_Body_set_transform_with_dir);
 CK_DLL_SFUN(b2_Body_set_position);
@@ -1211,8 +1236,10 @@ DOC_CLASS("Result of computing the distance between two line segments. https://b
 
         b2WorldDef_workerCount_offset = MVAR("int", "workerCount", false);
         DOC_VAR(
-          "CURRENTLY UNSUPPORTED. "
-          "Number of workers to use with the provided task system. Box2D performs "
+          "Number of threads used to step this world, including the graphics "
+          "thread. Work is spread over ChuGL's shared worker pool. Defaults to the "
+          "size of the pool + 1; clamped to that. Set to 1 for a single-threaded "
+          "step. Box2D performs "
           "best when using only performance cores and accessing a single L2 cache. "
           "Efficiency cores and hyper-threading provide little benefit and may "
           "even harm performance.");
@@ -1306,6 +1333,31 @@ DOC_CLASS("Result of computing the distance between two line segments. https://b
           "Set the rate modifier at which the physics simulation runs. Default 1.0. "
           "E.g. A rate of 2.0 will run the simulation at twice the speed.");
 
+        SFUN(b2_set_fixed_timestep, "void", "fixedTimestep");
+        ARG("float", "seconds");
+        DOC_FUNC(
+          "Step the physics simulation in fixed increments of `seconds`, e.g. 1.0/60, "
+          "independent of the frame rate. Frame time is accumulated and the world "
+          "is stepped as many times as fit (up to 8 per frame). Use "
+          "b2Body.interpolatedPosition() and b2Body.interpolatedAngle() to draw "
+          "bodies smoothly between steps. Contact, sensor and body events cover "
+          "every step taken during the frame. Default 0, which steps once per frame "
+          "by the frame's delta time.");
+
+        SFUN(b2_set_physics_thread, "void", "physicsThread");
+        ARG("int", "enabled");
+        DOC_FUNC(
+          "If true, step the physics simulation on a dedicated thread, so that it "
+          "runs alongside your shreds' next frame instead of delaying it. Calling "
+          "any other b2 function waits for the in-progress step to finish; "
+          "b2Body.interpolatedPosition() and b2Body.interpolatedAngle() read from a "
+          "snapshot and never wait. Default false.");
+
+        SFUN(b2_get_interpolation_alpha, "float", "interpolationAlpha");
+        DOC_FUNC(
+          "How far between the last two physics steps the current frame is, in "
+          "[0, 1]. Always 1 without a fixed timestep. See b2.fixedTimestep().");
+
         SFUN(b2_CreateWorld, "int", "createWorld");
         ARG("b2WorldDef", "def");
         DOC_FUNC(
@@ -1621,6 +1673,56 @@ DOC_CLASS("Result of computing the distance between two line segments. https://b
         ARG("int", "b2Body_id");
         DOC_FUNC(" Get the body angle in radians in the range [-pi, pi]");
 
+        SFUN(b2_Body_get_interpolated_position, "vec2", "interpolatedPosition");
+        ARG("int", "b2Body_id");
+        DOC_FUNC(
+          "Get the body position blended between the last two physics steps by "
+          "b2.interpolationAlpha(). Use this for drawing when b2.fixedTimestep() is "
+          "set. Reads from a snapshot, so it never waits on b2.physicsThread(). "
+          "Bodies the simulation hasn't moved yet return their current position.");
+
+        SFUN(b2_Body_get_interpolated_angle, "float", "interpolatedAngle");
+        ARG("int", "b2Body_id");
+        DOC_FUNC(
+          "Get the body angle in radians blended between the last two physics steps. "
+          "See b2Body.interpolatedPosition()");
+
+        SFUN(b2_Body_get_positions, "void", "positions");
+        ARG("int[]", "b2Body_ids");
+        ARG("vec2[]", "positions");
+        DOC_FUNC(
+          "Bulk version of b2Body.position(). Writes the world position of each body "
+          "in `b2Body_ids` to the same index of `positions`, resizing it to match.");
+
+        SFUN(b2_Body_get_angles, "void", "angles");
+        ARG("int[]", "b2Body_ids");
+        ARG("float[]", "angles");
+        DOC_FUNC(
+          "Bulk version of b2Body.angle(). Writes the angle in radians of each body "
+          "in `b2Body_ids` to the same index of `angles`, resizing it to match.");
+
+        SFUN(b2_Body_get_interpolated_transforms, "void", "interpolatedTransforms");
+        ARG("int[]", "b2Body_ids");
+        ARG("vec2[]", "positions");
+        ARG("float[]", "angles");
+        DOC_FUNC(
+          "Bulk version of b2Body.interpolatedPosition() and "
+          "b2Body.interpolatedAngle(). Either output array can be null.");
+
+        SFUN(b2_Body_bind_ggen, "void", "bind");
+        ARG("int", "b2Body_id");
+        ARG("GGen", "ggen");
+        DOC_FUNC(
+          "Make `ggen` follow this body. ChuGL copies the body's (interpolated) "
+          "position and angle into the GGen's x/y position and z rotation every "
+          "frame, with no per-frame ChucK code. The GGen's z position and scale are "
+          "left alone. A GGen follows at most one body; binding again replaces the "
+          "previous body. The binding ends when either is destroyed.");
+
+        SFUN(b2_Body_unbind_ggen, "void", "unbind");
+        ARG("GGen", "ggen");
+        DOC_FUNC("Stop `ggen` from following the body it was bound to");
+
         SFUN(b2_Body_set_transform, "void", "transform");
         ARG("int", "b2Body_id");
         ARG("vec2", "position");
@@ -2531,6 +2633,12 @@ DOC_CLASS("Result of computing the distance between two line segments. https://b
           "damping (non-dimensional), `pushVelocity` is the maximum contact constraint "
           "push out velocity in m/s. Advanced feature.");
 
+        SFUN(b2_World_GetStepTime, "float", "stepTime");
+        ARG("int", "world_id");
+        DOC_FUNC(
+          "Time in milliseconds the last b2World_Step of this world took, as "
+          "measured by box2d. Useful for comparing b2WorldDef.workerCount settings.");
+
         END_CLASS();
     } // b2World
 }
@@ -2551,6 +2659,160 @@ static void b2BodyMoveEvent_to_ckobj(CK_DL_API API, Chuck_Object* ckobj,
     OBJ_MEMBER_INT(ckobj, b2BodyMoveEvent_fellAsleep_offset)         = obj->fellAsleep;
 }
 
+// ============================================================================
+// b2 task scheduler
+// ============================================================================
+// Runs box2d's parallel-for tasks on the shared Jobs pool. Each multithreaded
+// world owns a scheduler, passed to box2d as b2WorldDef.userTaskContext.
+//
+// A task is split into at most workerCount partitions, claimed through an
+// atomic cursor by whoever gets there first: a pool worker, or the stepping
+// thread once box2d calls finishTask. The partition number doubles as the
+// box2d worker index. box2d only indexes per-worker scratch memory from tasks
+// that never run concurrently with each other (collide, finalize, continuous),
+// so uniqueness within a task is sufficient.
+//
+// enqueueTask and finishTask are only ever called from the thread stepping the
+// world, so the task slots themselves need no locking.
+
+#define B2_SCHEDULER_MAX_TASKS 128 // worst case: one solver task per worker + 2
+#define B2_SCHEDULER_MAX_WORKERS 64 // box2d b2_maxWorkers
+#define B2_SCHEDULER_MAX_WORLDS 128 // box2d b2_maxWorlds
+
+struct b2_Task {
+    b2TaskCallback* fn;
+    void* context;
+    int item_count;
+    int partition_size;
+    int partition_count;
+    std::atomic<int> next_partition;
+    Jobs_Counter counter;
+    bool in_use;
+};
+
+struct b2_TaskScheduler {
+    int worker_count;
+    b2_Task tasks[B2_SCHEDULER_MAX_TASKS];
+};
+
+// indexed by b2WorldId.index1 - 1
+static b2_TaskScheduler* b2_schedulers[B2_SCHEDULER_MAX_WORLDS] = {};
+
+static int b2_Scheduler_MaxWorkers()
+{
+    Jobs_Init();
+    return MIN(Jobs_WorkerCount() + 1, B2_SCHEDULER_MAX_WORKERS);
+}
+
+static b2_TaskScheduler* b2_Scheduler_Create(int worker_count)
+{
+    b2_TaskScheduler* scheduler = new b2_TaskScheduler;
+    scheduler->worker_count     = worker_count;
+    for (int i = 0; i < B2_SCHEDULER_MAX_TASKS; i++) {
+        scheduler->tasks[i].in_use = false;
+    }
+    return scheduler;
+}
+
+// takes ownership of scheduler, freeing whatever was previously attached to
+// the world slot
+static void b2_Scheduler_Set(b2WorldId world_id, b2_TaskScheduler* scheduler)
+{
+    u32 index = world_id.index1 - 1;
+    ASSERT(index < ARRAY_LENGTH(b2_schedulers));
+    delete b2_schedulers[index];
+    b2_schedulers[index] = scheduler;
+}
+
+// worlds still alive at exit are never destroyed, free their schedulers
+static void b2_Scheduler_FreeAll()
+{
+    for (u32 i = 0; i < ARRAY_LENGTH(b2_schedulers); i++) {
+        delete b2_schedulers[i];
+        b2_schedulers[i] = NULL;
+    }
+}
+
+// returns false once every partition has been claimed
+static bool b2_Task_RunPartition(b2_Task* task)
+{
+    int partition = task->next_partition.fetch_add(1);
+    if (partition >= task->partition_count) return false;
+
+    int start = partition * task->partition_size;
+    int end   = MIN(start + task->partition_size, task->item_count);
+    task->fn(start, end, (u32)partition, task->context);
+    return true;
+}
+
+static void b2_Task_Job(void* udata)
+{
+    b2_Task* task = (b2_Task*)udata;
+    while (b2_Task_RunPartition(task)) {
+    }
+}
+
+static void* b2_Scheduler_EnqueueTask(b2TaskCallback* fn, int item_count,
+                                      int min_range, void* task_context,
+                                      void* user_context)
+{
+    b2_TaskScheduler* scheduler = (b2_TaskScheduler*)user_context;
+    if (item_count <= 0) return NULL;
+
+    b2_Task* task = NULL;
+    for (int i = 0; i < B2_SCHEDULER_MAX_TASKS; i++) {
+        if (!scheduler->tasks[i].in_use) {
+            task = &scheduler->tasks[i];
+            break;
+        }
+    }
+
+    if (task == NULL) {
+        // should never happen, box2d keeps at most workerCount + 2 tasks in
+        // flight. Returning NULL tells box2d the work was done serially.
+        ASSERT(false);
+        fn(0, item_count, 0, task_context);
+        return NULL;
+    }
+
+    min_range           = MAX(min_range, 1);
+    int partition_count = (item_count + min_range - 1) / min_range;
+    partition_count     = CLAMP(partition_count, 1, scheduler->worker_count);
+
+    task->in_use          = true;
+    task->fn              = fn;
+    task->context         = task_context;
+    task->item_count      = item_count;
+    task->partition_size  = (item_count + partition_count - 1) / partition_count;
+    task->partition_count
+      = (item_count + task->partition_size - 1) / task->partition_size;
+    task->next_partition.store(0);
+
+    // one job per partition. The box2d solver enqueues one single-item task per
+    // worker and expects them to run concurrently, so even a single partition
+    // goes to the pool rather than running inline.
+    for (int i = 0; i < task->partition_count; i++) {
+        Jobs_Submit(b2_Task_Job, task, &task->counter);
+    }
+
+    return task;
+}
+
+static void b2_Scheduler_FinishTask(void* user_task, void* user_context)
+{
+    UNUSED_VAR(user_context);
+    b2_Task* task = (b2_Task*)user_task;
+
+    // help with whatever hasn't been picked up by the pool yet, then wait for
+    // the jobs that are still in flight (or queued no-ops) to drain so the
+    // slot can be reused. Only this task's jobs are run here, the stepping
+    // thread may be the audio thread
+    while (b2_Task_RunPartition(task)) {
+    }
+    Jobs_WaitOwn(&task->counter);
+    task->in_use = false;
+}
+
 // ============================================================================
 // b2
 // ============================================================================
@@ -2578,19 +2840,53 @@ CK_DLL_SFUN(b2_set_simulation_rate)
     CQ_PushCommand_b2World_Set(b2_sim_desc);
 }
 
+CK_DLL_SFUN(b2_set_fixed_timestep)
+{
+    ulib_box2d_accessAllowed;
+    b2_sim_desc.fixed_timestep = GET_NEXT_FLOAT(ARGS);
+    CQ_PushCommand_b2World_Set(b2_sim_desc);
+}
+
+CK_DLL_SFUN(b2_set_physics_thread)
+{
+    ulib_box2d_accessAllowed;
+    b2_sim_desc.threaded = (GET_NEXT_INT(ARGS) != 0);
+    CQ_PushCommand_b2World_Set(b2_sim_desc);
+}
+
+CK_DLL_SFUN(b2_get_interpolation_alpha)
+{
+    RETURN->v_float = Physics_Alpha();
+}
+
 CK_DLL_SFUN(b2_CreateWorld)
 {
     ulib_box2d_accessAllowed;
     b2WorldDef def = b2DefaultWorldDef();
-    // TODO impl enqueueTask and finishTask callbacks
     ckobj_to_b2WorldDef(API, &def, GET_NEXT_OBJECT(ARGS));
-    RETURN_B2_ID(b2WorldId, b2CreateWorld(&def));
+
+    def.workerCount = CLAMP(def.workerCount, 1, b2_Scheduler_MaxWorkers());
+    b2_TaskScheduler* scheduler = NULL;
+    if (def.workerCount > 1) {
+        scheduler           = b2_Scheduler_Create(def.workerCount);
+        def.enqueueTask     = b2_Scheduler_EnqueueTask;
+        def.finishTask      = b2_Scheduler_FinishTask;
+        def.userTaskContext = scheduler;
+    }
+
+    b2WorldId world_id = b2CreateWorld(&def);
+    b2_Scheduler_Set(world_id, scheduler);
+    RETURN_B2_ID(b2WorldId, world_id);
 }
 
 CK_DLL_SFUN(b2_DestroyWorld)
 {
     ulib_box2d_accessAllowed;
-    b2DestroyWorld(GET_B2_ID(b2WorldId, ARGS));
+    b2WorldId world_id = GET_B2_ID(b2WorldId, ARGS);
+    if (!b2World_IsValid(world_id)) return;
+    b2DestroyWorld(world_id);
+    b2_Scheduler_Set(world_id, NULL);
+    b2_UnbindDestroyedBodies();
 }
 
 CK_DLL_SFUN(b2_CreateBody)
@@ -2607,6 +2903,7 @@ CK_DLL_SFUN(b2_DestroyBody)
 {
     ulib_box2d_accessAllowed;
     b2DestroyBody(GET_B2_ID(b2BodyId, ARGS));
+    b2_UnbindDestroyedBodies();
 }
 
 CK_DLL_SFUN(b2_MakeBox)
@@ -2903,7 +3200,7 @@ CK_DLL_SFUN(b2_World_GetBodyEvents)
     GET_NEXT_INT(ARGS); // advance to next arg
     Chuck_ArrayInt* body_event_array = GET_NEXT_OBJECT_ARRAY(ARGS);
 
-    b2BodyEvents body_events = b2World_GetBodyEvents(world_id);
+    b2BodyEvents body_events = Physics_GetBodyEvents(world_id);
 
     // first create new body events in pool
     int pool_len = ARENA_LENGTH(&b2Body_move_event_pool, Chuck_Object*);
@@ -2940,7 +3237,7 @@ CK_DLL_SFUN(b2_World_GetSensorEvents)
 
     // TODO switch to use array_int_set after updating chuck version
 
-    b2SensorEvents sensor_events = b2World_GetSensorEvents(world_id);
+    b2SensorEvents sensor_events = Physics_GetSensorEvents(world_id);
 
     if (begin_sensor_events) {
         API->object->array_int_clear(begin_sensor_events);
@@ -2985,7 +3282,7 @@ CK_DLL_SFUN(b2_World_GetContactEvents)
     Chuck_ArrayInt* end_contact_events   = GET_NEXT_OBJECT_ARRAY(ARGS);
     Chuck_ArrayInt* hit_events           = GET_NEXT_OBJECT_ARRAY(ARGS);
 
-    b2ContactEvents contact_events = b2World_GetContactEvents(world_id);
+    b2ContactEvents contact_events = Physics_GetContactEvents(world_id);
 
     // TODO switch to use array_int_set after updating chuck version
 
@@ -3346,6 +3643,12 @@ CK_DLL_SFUN(b2_World_SetContactTuning)
     b2World_SetContactTuning(world_id, hertz, dampingRatio, pushVelocity);
 }
 
+CK_DLL_SFUN(b2_World_GetStepTime)
+{
+    ulib_box2d_accessAllowed;
+    RETURN->v_float = b2World_GetProfile(GET_B2_ID(b2WorldId, ARGS)).step;
+}
+
 // ============================================================================
 // b2WorldDef
 // ============================================================================
@@ -3391,7 +3694,8 @@ static void ckobj_to_b2WorldDef(CK_DL_API API, b2WorldDef* obj, Chuck_Object* ck
 
 CK_DLL_CTOR(b2WorldDef_ctor)
 {
-    b2WorldDef default_world_def = b2DefaultWorldDef();
+    b2WorldDef default_world_def  = b2DefaultWorldDef();
+    default_world_def.workerCount = b2_Scheduler_MaxWorkers();
     b2WorldDef_to_ckobj(API, SELF, &default_world_def);
 }
 
@@ -4219,6 +4523,37 @@ CK_DLL_CTOR(b2BodyDef_ctor)
 // b2Body
 // ============================================================================
 
+// reads a body without waiting on the physics thread. While it's stepping the
+// body comes from the last published snapshot, otherwise box2d is idle and is
+// read directly
+static Physics_BodyView b2_Body_Read(b2BodyId body_id)
+{
+    Physics_BodyView view;
+    if (Physics_Busy() && Physics_BodySnapshot(body_id, &view)) return view;
+
+    // not in the snapshot, the simulation hasn't moved it yet
+    Physics_Wait();
+    view.xform            = b2Body_GetTransform(body_id);
+    view.linear_velocity  = b2Body_GetLinearVelocity(body_id);
+    view.angular_velocity = b2Body_GetAngularVelocity(body_id);
+    return view;
+}
+
+static void b2_Body_Write(Physics_WriteType type, b2BodyId body_id, b2Vec2 v,
+                          b2Rot q = b2Rot_identity, f32 f = 0.0f,
+                          b2Vec2 point = b2Vec2_zero, bool wake = true)
+{
+    Physics_Write write = {};
+    write.type          = type;
+    write.body_id       = body_id;
+    write.v             = v;
+    write.point         = point;
+    write.q             = q;
+    write.f             = f;
+    write.wake          = wake;
+    Physics_BodyWrite(&write);
+}
+
 CK_DLL_SFUN(b2_Body_is_valid)
 {
     RETURN->v_int = b2Body_IsValid(GET_B2_ID(b2BodyId, ARGS));
@@ -4241,216 +4576,433 @@ CK_DLL_SFUN(b2_Body_set_type)
 
 CK_DLL_SFUN(b2_Body_get_position)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    b2Vec2 pos     = b2Body_GetPosition(body_id);
+    b2Vec2 pos     = b2_Body_Read(body_id).xform.p;
     RETURN->v_vec2 = { pos.x, pos.y };
 }
 
 CK_DLL_SFUN(b2_Body_get_rotation)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    b2Rot rot      = b2Body_GetRotation(body_id);
+    b2Rot rot      = b2_Body_Read(body_id).xform.q;
     RETURN->v_vec2 = { rot.c, rot.s };
 }
 
 CK_DLL_SFUN(b2_Body_get_angle)
+{
+    ulib_box2d_accessChecked;
+    b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
+    GET_NEXT_INT(ARGS); // advance
+    RETURN->v_float = b2Rot_GetAngle(b2_Body_Read(body_id).xform.q);
+}
+
+CK_DLL_SFUN(b2_Body_get_interpolated_position)
+{
+    b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
+    b2Transform xform;
+    if (!Physics_InterpolatedTransform(body_id, &xform)) {
+        // not in the snapshot, read box2d directly
+        ulib_box2d_accessAllowed;
+        xform.p = b2Body_GetPosition(body_id);
+    }
+    RETURN->v_vec2 = { xform.p.x, xform.p.y };
+}
+
+// resizes ck_arr to count if needed. Returns true if elements should be set
+// with push_back, false for set_idx
+static bool b2_ResizeVec2Array(Chuck_ArrayVec2* ck_arr, t_CKINT count)
+{
+    if (g_chuglAPI->object->array_vec2_size(ck_arr) == count) return false;
+    g_chuglAPI->object->array_vec2_clear(ck_arr);
+    return true;
+}
+
+static bool b2_ResizeFloatArray(Chuck_ArrayFloat* ck_arr, t_CKINT count)
+{
+    if (g_chuglAPI->object->array_float_size(ck_arr) == count) return false;
+    g_chuglAPI->object->array_float_clear(ck_arr);
+    return true;
+}
+
+CK_DLL_SFUN(b2_Body_get_positions)
+{
+    ulib_box2d_accessChecked;
+    Chuck_ArrayInt* ck_body_ids   = GET_NEXT_INT_ARRAY(ARGS);
+    Chuck_ArrayVec2* ck_positions = GET_NEXT_VEC2_ARRAY(ARGS);
+    if (!ck_body_ids || !ck_positions) return;
+
+    t_CKINT count = API->object->array_int_size(ck_body_ids);
+    bool push     = b2_ResizeVec2Array(ck_positions, count);
+    for (t_CKINT i = 0; i < count; i++) {
+        t_CKINT ck_id = API->object->array_int_get_idx(ck_body_ids, i);
+        b2Vec2 pos    = b2_Body_Read(*(b2BodyId*)&ck_id).xform.p;
+        t_CKVEC2 vec2 = { pos.x, pos.y };
+        if (push)
+            API->object->array_vec2_push_back(ck_positions, vec2);
+        else
+            API->object->array_vec2_set_idx(ck_positions, i, vec2);
+    }
+}
+
+CK_DLL_SFUN(b2_Body_get_angles)
+{
+    ulib_box2d_accessChecked;
+    Chuck_ArrayInt* ck_body_ids = GET_NEXT_INT_ARRAY(ARGS);
+    Chuck_ArrayFloat* ck_angles = GET_NEXT_FLOAT_ARRAY(ARGS);
+    if (!ck_body_ids || !ck_angles) return;
+
+    t_CKINT count = API->object->array_int_size(ck_body_ids);
+    bool push     = b2_ResizeFloatArray(ck_angles, count);
+    for (t_CKINT i = 0; i < count; i++) {
+        t_CKINT ck_id = API->object->array_int_get_idx(ck_body_ids, i);
+        f32 angle     = b2Rot_GetAngle(b2_Body_Read(*(b2BodyId*)&ck_id).xform.q);
+        if (push)
+            API->object->array_float_push_back(ck_angles, angle);
+        else
+            API->object->array_float_set_idx(ck_angles, i, angle);
+    }
+}
+
+CK_DLL_SFUN(b2_Body_get_interpolated_transforms)
+{
+    Chuck_ArrayInt* ck_body_ids   = GET_NEXT_INT_ARRAY(ARGS);
+    Chuck_ArrayVec2* ck_positions = GET_NEXT_VEC2_ARRAY(ARGS);
+    Chuck_ArrayFloat* ck_angles   = GET_NEXT_FLOAT_ARRAY(ARGS);
+    if (!ck_body_ids) return;
+
+    t_CKINT count   = API->object->array_int_size(ck_body_ids);
+    bool push_pos   = ck_positions && b2_ResizeVec2Array(ck_positions, count);
+    bool push_angle = ck_angles && b2_ResizeFloatArray(ck_angles, count);
+    bool waited     = false;
+    for (t_CKINT i = 0; i < count; i++) {
+        t_CKINT ck_id    = API->object->array_int_get_idx(ck_body_ids, i);
+        b2BodyId body_id = *(b2BodyId*)&ck_id;
+
+        b2Transform xform;
+        if (!Physics_InterpolatedTransform(body_id, &xform)) {
+            // not in the snapshot, read box2d directly
+            if (!waited) {
+                waited = true;
+                ulib_box2d_accessAllowed;
+            }
+            xform = b2Body_GetTransform(body_id);
+        }
+
+        if (ck_positions) {
+            t_CKVEC2 pos = { xform.p.x, xform.p.y };
+            if (push_pos)
+                API->object->array_vec2_push_back(ck_positions, pos);
+            else
+                API->object->array_vec2_set_idx(ck_positions, i, pos);
+        }
+        if (ck_angles) {
+            f32 angle = b2Rot_GetAngle(xform.q);
+            if (push_angle)
+                API->object->array_float_push_back(ck_angles, angle);
+            else
+                API->object->array_float_set_idx(ck_angles, i, angle);
+        }
+    }
+}
+
+// body transforms are in world space. Writes the body's x/y position and
+// rotation into the GGen's parent-local transform, keeping its world z
+static void b2_SetWorldXform(SG_Transform* xform, const b2Transform& body_xform)
+{
+    glm::quat rot
+      = glm::angleAxis(b2Rot_GetAngle(body_xform.q), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    SG_Transform* parent = SG_GetTransform(xform->parentID);
+    if (!parent) {
+        xform->pos.x = body_xform.p.x;
+        xform->pos.y = body_xform.p.y;
+        xform->rot   = rot;
+        return;
+    }
+
+    glm::vec3 world_pos = SG_Transform::worldPosition(xform);
+    world_pos.x         = body_xform.p.x;
+    world_pos.y         = body_xform.p.y;
+    SG_Transform::worldPosition(xform, world_pos);
+    xform->rot = glm::inverse(SG_Transform::worldRotation(parent)) * rot;
+}
+
+// drops bindings to destroyed bodies on both threads, otherwise their GGens
+// would keep following whatever the snapshot last held for the body
+static void b2_UnbindDestroyedBodies()
+{
+    for (u32 i = 0; i < Physics_Bindings::count(&b2_ggen_bindings); i++) {
+        Physics_Binding* binding = Physics_Bindings::get(&b2_ggen_bindings, i);
+        if (b2Body_IsValid(binding->body_id)) continue;
+        CQ_PushCommand_b2Body_Bind(binding->sg_id, 0);
+        Physics_Bindings::remove(&b2_ggen_bindings, i--);
+    }
+}
+
+CK_DLL_SFUN(b2_Body_bind_ggen)
 {
     ulib_box2d_accessAllowed;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    RETURN->v_float = b2Rot_GetAngle(b2Body_GetRotation(body_id));
+    Chuck_Object* ck_ggen = GET_NEXT_OBJECT(ARGS);
+    if (!ck_ggen) return;
+    if (!b2Body_IsValid(body_id)) {
+        log_warn("b2Body.bind(...) called with an invalid body id");
+        return;
+    }
+
+    SG_Transform* xform = GET_XFORM(ck_ggen);
+
+    // start from the body's current transform. The snapshot only holds bodies
+    // that the simulation has moved
+    b2_SetWorldXform(xform, b2Body_GetTransform(body_id));
+    CQ_PushCommand_SetPosition(xform);
+    CQ_PushCommand_SetRotation(xform);
+
+    Physics_Bindings::bind(&b2_ggen_bindings, xform->id, body_id);
+    CQ_PushCommand_b2Body_Bind(xform->id, (u64)B2_ID_TO_CKINT(body_id));
+}
+
+CK_DLL_SFUN(b2_Body_unbind_ggen)
+{
+    Chuck_Object* ck_ggen = GET_NEXT_OBJECT(ARGS);
+    if (!ck_ggen) return;
+    SG_Transform* xform = GET_XFORM(ck_ggen);
+    Physics_Bindings::bind(&b2_ggen_bindings, xform->id, b2_nullBodyId);
+    CQ_PushCommand_b2Body_Bind(xform->id, 0);
+}
+
+// called on the audio thread once all graphics shreds have finished their
+// frame, before the renderer steps physics for it. Bound GGens get the
+// interpolated transforms of the last published step. The renderer copies
+// again after stepping (Physics_SyncTransforms()), so chuck may read
+// transforms one frame behind what gets drawn
+static void ulib_box2d_syncBoundGGens()
+{
+    for (u32 i = 0; i < Physics_Bindings::count(&b2_ggen_bindings); i++) {
+        Physics_Binding* binding = Physics_Bindings::get(&b2_ggen_bindings, i);
+        SG_Transform* xform      = SG_GetTransform(binding->sg_id);
+        if (!xform) { // GGen was garbage collected
+            Physics_Bindings::remove(&b2_ggen_bindings, i--);
+            continue;
+        }
+
+        b2Transform body_xform;
+        if (!Physics_InterpolatedTransform(binding->body_id, &body_xform)) continue;
+        b2_SetWorldXform(xform, body_xform);
+    }
+}
+
+CK_DLL_SFUN(b2_Body_get_interpolated_angle)
+{
+    b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
+    b2Transform xform;
+    if (!Physics_InterpolatedTransform(body_id, &xform)) {
+        ulib_box2d_accessAllowed;
+        xform.q = b2Body_GetRotation(body_id);
+    }
+    RETURN->v_float = b2Rot_GetAngle(xform.q);
 }
 
 CK_DLL_SFUN(b2_Body_set_transform)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 pos = GET_NEXT_VEC2(ARGS);
     float angle  = GET_NEXT_FLOAT(ARGS);
-    b2Body_SetTransform(body_id, { (float)pos.x, (float)pos.y }, b2MakeRot(angle));
+    b2_Body_Write(PHYSICS_WRITE_TRANSFORM, body_id, { (float)pos.x, (float)pos.y },
+                  b2MakeRot(angle));
 }
 
 CK_DLL_SFUN(b2_Body_set_transform_with_dir)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 pos = GET_NEXT_VEC2(ARGS);
     b2Vec2 dir   = b2Normalize(vec2_to_b2Vec2(GET_NEXT_VEC2(ARGS)));
-    b2Body_SetTransform(body_id, { (float)pos.x, (float)pos.y }, *(b2Rot*)&dir);
+    b2_Body_Write(PHYSICS_WRITE_TRANSFORM, body_id, { (float)pos.x, (float)pos.y },
+                  *(b2Rot*)&dir);
 }
 
 CK_DLL_SFUN(b2_Body_set_position)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     GET_NEXT_B2_ID(b2BodyId, body_id);
     t_CKVEC2 pos = GET_NEXT_VEC2(ARGS);
-    b2Body_SetTransform(body_id, { (float)pos.x, (float)pos.y },
-                        b2Body_GetTransform(body_id).q);
+    b2_Body_Write(PHYSICS_WRITE_POSITION, body_id, { (float)pos.x, (float)pos.y });
 }
 
 CK_DLL_SFUN(b2_Body_set_angle)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     GET_NEXT_B2_ID(b2BodyId, body_id);
-    b2Body_SetTransform(body_id, b2Body_GetTransform(body_id).p,
-                        b2MakeRot(GET_NEXT_FLOAT(ARGS)));
+    b2_Body_Write(PHYSICS_WRITE_ROTATION, body_id, b2Vec2_zero,
+                  b2MakeRot(GET_NEXT_FLOAT(ARGS)));
 }
 
 CK_DLL_SFUN(b2_Body_set_rotation)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     GET_NEXT_B2_ID(b2BodyId, body_id);
     b2Vec2 dir = b2Normalize(vec2_to_b2Vec2(GET_NEXT_VEC2(ARGS)));
-    b2Body_SetTransform(body_id, b2Body_GetTransform(body_id).p, *(b2Rot*)&dir);
+    b2_Body_Write(PHYSICS_WRITE_ROTATION, body_id, b2Vec2_zero, *(b2Rot*)&dir);
 }
 
 CK_DLL_SFUN(b2_Body_get_local_point)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 world_point = GET_NEXT_VEC2(ARGS);
-    b2Vec2 local_point
-      = b2Body_GetLocalPoint(body_id, { (float)world_point.x, (float)world_point.y });
+    b2Vec2 local_point   = b2InvTransformPoint(
+      b2_Body_Read(body_id).xform, { (float)world_point.x, (float)world_point.y });
     RETURN->v_vec2 = { local_point.x, local_point.y };
 }
 
 CK_DLL_SFUN(b2_Body_get_world_point)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 local_point = GET_NEXT_VEC2(ARGS);
-    b2Vec2 world_point
-      = b2Body_GetWorldPoint(body_id, { (float)local_point.x, (float)local_point.y });
+    b2Vec2 world_point   = b2TransformPoint(
+      b2_Body_Read(body_id).xform, { (float)local_point.x, (float)local_point.y });
     RETURN->v_vec2 = { world_point.x, world_point.y };
 }
 
 CK_DLL_SFUN(b2_Body_get_local_vector)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 world_vector = GET_NEXT_VEC2(ARGS);
-    b2Vec2 local_vector   = b2Body_GetLocalVector(
-      body_id, { (float)world_vector.x, (float)world_vector.y });
+    b2Vec2 local_vector   = b2InvRotateVector(
+      b2_Body_Read(body_id).xform.q, { (float)world_vector.x, (float)world_vector.y });
     RETURN->v_vec2 = { local_vector.x, local_vector.y };
 }
 
 CK_DLL_SFUN(b2_Body_get_world_vector)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 local_vector = GET_NEXT_VEC2(ARGS);
-    b2Vec2 world_vector   = b2Body_GetWorldVector(
-      body_id, { (float)local_vector.x, (float)local_vector.y });
+    b2Vec2 world_vector   = b2RotateVector(
+      b2_Body_Read(body_id).xform.q, { (float)local_vector.x, (float)local_vector.y });
     RETURN->v_vec2 = { world_vector.x, world_vector.y };
 }
 
 CK_DLL_SFUN(b2_Body_get_linear_velocity)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    b2Vec2 vel     = b2Body_GetLinearVelocity(body_id);
+    b2Vec2 vel     = b2_Body_Read(body_id).linear_velocity;
     RETURN->v_vec2 = { vel.x, vel.y };
 }
 
 CK_DLL_SFUN(b2_Body_set_linear_velocity)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 vel = GET_NEXT_VEC2(ARGS);
-    b2Body_SetLinearVelocity(body_id, { (float)vel.x, (float)vel.y });
+    b2_Body_Write(PHYSICS_WRITE_LINEAR_VELOCITY, body_id,
+                  { (float)vel.x, (float)vel.y });
 }
 
 CK_DLL_SFUN(b2_Body_get_angular_velocity)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    RETURN->v_float = b2Body_GetAngularVelocity(body_id);
+    RETURN->v_float = b2_Body_Read(body_id).angular_velocity;
 }
 
 CK_DLL_SFUN(b2_Body_set_angular_velocity)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
-    b2Body_SetAngularVelocity(body_id, GET_NEXT_FLOAT(ARGS));
+    b2_Body_Write(PHYSICS_WRITE_ANGULAR_VELOCITY, body_id, b2Vec2_zero, b2Rot_identity,
+                  (f32)GET_NEXT_FLOAT(ARGS));
 }
 
 CK_DLL_SFUN(b2_Body_apply_force)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 force = GET_NEXT_VEC2(ARGS);
     t_CKVEC2 point = GET_NEXT_VEC2(ARGS);
     t_CKINT wake   = GET_NEXT_INT(ARGS);
-    b2Body_ApplyForce(body_id, { (float)force.x, (float)force.y },
-                      { (float)point.x, (float)point.y }, wake);
+    b2_Body_Write(PHYSICS_WRITE_FORCE, body_id, { (float)force.x, (float)force.y },
+                  b2Rot_identity, 0.0f, { (float)point.x, (float)point.y }, wake);
 }
 
 CK_DLL_SFUN(b2_Body_apply_force_to_center)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 force = GET_NEXT_VEC2(ARGS);
     t_CKINT wake   = GET_NEXT_INT(ARGS);
-    b2Body_ApplyForceToCenter(body_id, { (float)force.x, (float)force.y }, wake);
+    b2_Body_Write(PHYSICS_WRITE_FORCE_TO_CENTER, body_id,
+                  { (float)force.x, (float)force.y }, b2Rot_identity, 0.0f, b2Vec2_zero,
+                  wake);
 }
 
 CK_DLL_SFUN(b2_Body_apply_torque)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKFLOAT torque = GET_NEXT_FLOAT(ARGS);
     t_CKINT wake     = GET_NEXT_INT(ARGS);
-    b2Body_ApplyTorque(body_id, torque, wake);
+    b2_Body_Write(PHYSICS_WRITE_TORQUE, body_id, b2Vec2_zero, b2Rot_identity,
+                  (f32)torque, b2Vec2_zero, wake);
 }
 
 CK_DLL_SFUN(b2_Body_apply_linear_impulse)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 impulse = GET_NEXT_VEC2(ARGS);
     t_CKVEC2 point   = GET_NEXT_VEC2(ARGS);
     t_CKINT wake     = GET_NEXT_INT(ARGS);
-    b2Body_ApplyLinearImpulse(body_id, { (float)impulse.x, (float)impulse.y },
-                              { (float)point.x, (float)point.y }, wake);
+    b2_Body_Write(PHYSICS_WRITE_LINEAR_IMPULSE, body_id,
+                  { (float)impulse.x, (float)impulse.y }, b2Rot_identity, 0.0f,
+                  { (float)point.x, (float)point.y }, wake);
 }
 
 CK_DLL_SFUN(b2_Body_apply_linear_impulse_to_center)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKVEC2 impulse = GET_NEXT_VEC2(ARGS);
     t_CKINT wake     = GET_NEXT_INT(ARGS);
-    b2Body_ApplyLinearImpulseToCenter(body_id, { (float)impulse.x, (float)impulse.y },
-                                      wake);
+    b2_Body_Write(PHYSICS_WRITE_LINEAR_IMPULSE_TO_CENTER, body_id,
+                  { (float)impulse.x, (float)impulse.y }, b2Rot_identity, 0.0f,
+                  b2Vec2_zero, wake);
 }
 
 CK_DLL_SFUN(b2_Body_apply_angular_impulse)
 {
-    ulib_box2d_accessAllowed;
+    ulib_box2d_accessChecked;
     b2BodyId body_id = GET_B2_ID(b2BodyId, ARGS);
     GET_NEXT_INT(ARGS); // advance
     t_CKFLOAT impulse = GET_NEXT_FLOAT(ARGS);
     t_CKINT wake      = GET_NEXT_INT(ARGS);
-    b2Body_ApplyAngularImpulse(body_id, impulse, wake);
+    b2_Body_Write(PHYSICS_WRITE_ANGULAR_IMPULSE, body_id, b2Vec2_zero, b2Rot_identity,
+                  (f32)impulse, b2Vec2_zero, wake);
 }
 
 CK_DLL_SFUN(b2_Body_get_mass)
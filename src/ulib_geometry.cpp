@@ -32,8 +32,65 @@
 
 #include "geometry.h"
 
+#include "core/jobs.h"
+
 #define GET_GEOMETRY(ckobj) SG_GetGeometry(OBJ_MEMBER_UINT(ckobj, component_offset_id))
 
+// optimize built-in geometry and loaded models as they are built
+static bool g_geometry_auto_optimize = false;
+
+// Built-in geometries built with identical parameters share one hidden geometry.
+// Each keeps a CPU copy of the data for getters, but draws with the hidden
+// geometry's GPU buffers, so their meshes batch into one instanced draw. Any edit
+// other than a rebuild gives a geometry its own buffers again (copy-on-write)
+static bool g_geometry_auto_share = true;
+
+struct GeometryCacheKey {
+    SG_GeometryType type;
+    SG_GeometryParams params; // zeroed past the fields of type
+};
+
+struct GeometryCacheEntry {
+    GeometryCacheKey key;
+    SG_Geometry* geo; // hidden geometry holding the shared data
+    u32 sharers;
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        UNUSED_VAR(udata);
+        return memcmp(&((GeometryCacheEntry*)a)->key, &((GeometryCacheEntry*)b)->key,
+                      sizeof(GeometryCacheKey));
+    }
+
+    static uint64_t hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        GeometryCacheEntry* entry = (GeometryCacheEntry*)item;
+        return hashmap_xxhash3(&entry->key, sizeof(entry->key), seed0, seed1);
+    }
+};
+
+static hashmap* g_geometry_cache = NULL;
+// hidden geometries nothing shares anymore, rebuilt for the next new entry
+static Arena g_geometry_cache_unused;
+
+// With async builds, rebuilding a built-in geometry generates its data on the job
+// pool instead of in the calling shred. The geometry keeps its previous data until
+// the next GG.nextFrame(), where finished builds are swapped in and uploaded.
+// Reading or editing the geometry before then waits for its build
+static bool g_geometry_async_build = false;
+
+struct GeometryBuildJob {
+    SG_ID geo_id;
+    bool optimize;
+    bool superseded; // a later build replaced this one, the result is dropped
+    SG_GeometryParams params;
+    SG_Geometry scratch; // built on a worker, not in the locator
+    Jobs_Counter counter;
+};
+
+// GeometryBuildJob*, in flight or finished but not applied yet
+static Arena g_geometry_build_jobs;
+
 // ===============================================================
 // Geometry  (for now, immutable)
 // ===============================================================
@@ -66,6 +123,29 @@ CK_DLL_MFUN(geo_get_vertex_count);
 CK_DLL_MFUN(geo_set_index_count);
 CK_DLL_MFUN(geo_get_index_count);
 
+CK_DLL_MFUN(geo_set_lod_levels);
+CK_DLL_MFUN(geo_get_lod_levels);
+CK_DLL_MFUN(geo_set_lod_thresholds);
+CK_DLL_MFUN(geo_get_lod_thresholds);
+CK_DLL_MFUN(geo_set_lod_force);
+CK_DLL_MFUN(geo_get_lod_force);
+
+CK_DLL_MFUN(geo_optimize);
+CK_DLL_MFUN(geo_compute_normals);
+CK_DLL_MFUN(geo_compute_tangents);
+CK_DLL_MFUN(geo_set_auto_normals);
+CK_DLL_MFUN(geo_get_auto_normals);
+CK_DLL_SFUN(geo_set_auto_optimize);
+CK_DLL_SFUN(geo_get_auto_optimize);
+
+CK_DLL_MFUN(geo_get_shared);
+CK_DLL_SFUN(geo_set_auto_share);
+CK_DLL_SFUN(geo_get_auto_share);
+
+CK_DLL_MFUN(geo_get_building);
+CK_DLL_SFUN(geo_set_async_build);
+CK_DLL_SFUN(geo_get_async_build);
+
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute);
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute_vec2);
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute_vec3);
@@ -174,6 +254,7 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     static t_CKINT pos_attr_loc{ SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION };
     static t_CKINT norm_attr_loc{ SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION };
     static t_CKINT uv_attr_loc{ SG_GEOMETRY_UV_ATTRIBUTE_LOCATION };
+    static t_CKINT tangent_attr_loc{ SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION };
 
     SVAR("int", "ATTRIBUTE_MAX", &sg_geometry_max_attributes);
     DOC_VAR("Maximum number of vertex attributes.");
@@ -195,6 +276,9 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     SVAR("int", "AttributeLocation_UV", &uv_attr_loc);
     DOC_VAR("(hidden) ");
 
+    SVAR("int", "ATTRIBUTE_TANGENT", &tangent_attr_loc);
+    DOC_VAR("Tangent attribute location written by computeTangents()");
+
     // ctor
     CTOR(geo_ctor);
 
@@ -355,6 +439,125 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     MFUN(geo_get_index_count, "int", "indexCount");
     DOC_FUNC("Get the number of indices to be drawn. Default is -1, which means all");
 
+    MFUN(geo_set_lod_levels, "void", "lodLevels");
+    ARG("int", "levels");
+    DOC_FUNC(
+      "Set the number of levels of detail to generate for this geometry, up to 6. "
+      "Each level after the first is simplified to about half the triangles of the "
+      "previous one in the background, and shares this geometry's vertex data. "
+      "Meshes pick a level per instance from their size on screen, see "
+      "lodThresholds(). Only indexed triangle geometry is simplified. "
+      "Default is 1, which disables LODs.");
+
+    MFUN(geo_get_lod_levels, "int", "lodLevels");
+    DOC_FUNC("Get the number of levels of detail requested for this geometry.");
+
+    MFUN(geo_set_lod_thresholds, "void", "lodThresholds");
+    ARG("float[]", "thresholds");
+    DOC_FUNC(
+      "Set the screen size at which each level of detail starts, as the fraction of "
+      "the viewport height covered by a mesh's bounding sphere. Level i + 1 is drawn "
+      "once a mesh is smaller than thresholds[i]. Values should be decreasing. "
+      "Default is [0.5, 0.25, 0.125, 0.0625, 0.03125].");
+
+    MFUN(geo_get_lod_thresholds, "float[]", "lodThresholds");
+    DOC_FUNC("Get the screen size at which each level of detail starts.");
+
+    MFUN(geo_set_lod_force, "void", "lodForce");
+    ARG("int", "level");
+    DOC_FUNC(
+      "Always draw this level of detail, clamped to the levels generated so far. "
+      "Default is -1, which selects levels by screen size.");
+
+    MFUN(geo_get_lod_force, "int", "lodForce");
+    DOC_FUNC("Get the forced level of detail. -1 if levels are selected by size.");
+
+    MFUN(geo_optimize, "vec2", "optimize");
+    DOC_FUNC(
+      "Reorder this geometry for faster rendering. Duplicate vertices are merged, "
+      "triangles are reordered to reuse recently transformed vertices and to draw "
+      "outward facing triangles first, and vertices are reordered to match. "
+      "Non-indexed geometry becomes indexed. Triangles and their appearance are "
+      "unchanged, but vertex and index order are not. Returns the average cache miss "
+      "ratio (vertices transformed per triangle, lower is better) before and after "
+      "as @(before, after), or @(0, 0) if the geometry cannot be optimized because "
+      "it uses pulled vertex attributes or vertexCount()/indexCount().");
+
+    MFUN(geo_compute_normals, "int", "computeNormals");
+    DOC_FUNC(
+      "Replace this geometry's normals with smooth normals computed from its "
+      "positions and triangles, weighting each face by its area. Vertices on a seam "
+      "that are split into copies get separate normals. Returns false if the "
+      "geometry has no vec3 positions.");
+
+    MFUN(geo_compute_tangents, "int", "computeTangents");
+    DOC_FUNC(
+      "Compute tangents from positions, normals and UVs and set them as the vec4 "
+      "vertex attribute at Geometry.ATTRIBUTE_TANGENT, following the MikkTSpace "
+      "conventions: xyz is the tangent and w the bitangent sign, so bitangent = w * "
+      "cross(normal, tangent). For custom shaders, built-in materials derive their "
+      "tangent frame in the fragment shader. Returns false if positions, normals or "
+      "UVs are missing.");
+
+    MFUN(geo_set_auto_normals, "void", "autoNormals");
+    ARG("int", "enabled");
+    DOC_FUNC(
+      "If true, normals (and tangents, if computed before) are recomputed whenever "
+      "positions() or indices() are set. When only positions change, just the "
+      "vertices around the ones that moved are updated, and the triangle adjacency "
+      "is reused, which makes deforming a mesh every frame cheap. Default is "
+      "false.");
+
+    MFUN(geo_get_auto_normals, "int", "autoNormals");
+    DOC_FUNC("Get whether normals are recomputed when positions change.");
+
+    SFUN(geo_set_auto_optimize, "void", "autoOptimize");
+    ARG("int", "enabled");
+    DOC_FUNC(
+      "If true, built-in geometries such as SphereGeometry are optimized every time "
+      "they are built, and models are optimized when loaded. See optimize(). "
+      "Default is false.");
+
+    SFUN(geo_get_auto_optimize, "int", "autoOptimize");
+    DOC_FUNC("Get whether built-in geometries and loaded models are optimized.");
+
+    MFUN(geo_get_shared, "int", "shared");
+    DOC_FUNC(
+      "True if this built-in geometry shares its GPU data with other geometries "
+      "built with the same parameters. Meshes of shared geometries with the same "
+      "material are drawn together in one instanced draw call. Editing the geometry "
+      "(e.g. setting positions(), indices(), vertexCount() or lodLevels()) gives it "
+      "its own copy of the data. Rebuilding it shares again if possible.");
+
+    SFUN(geo_set_auto_share, "void", "autoShare");
+    ARG("int", "enabled");
+    DOC_FUNC(
+      "If true, built-in geometries such as SphereGeometry that are built with "
+      "identical parameters share their GPU data, see shared(). Only affects "
+      "geometries built afterwards. Default is true.");
+
+    SFUN(geo_get_auto_share, "int", "autoShare");
+    DOC_FUNC("Get whether identical built-in geometries share their GPU data.");
+
+    MFUN(geo_get_building, "int", "building");
+    DOC_FUNC(
+      "True while an async build of this geometry is in progress, see asyncBuild(). "
+      "Until the build is applied at the next GG.nextFrame(), the geometry keeps "
+      "drawing its previous data.");
+
+    SFUN(geo_set_async_build, "void", "asyncBuild");
+    ARG("int", "enabled");
+    DOC_FUNC(
+      "If true, building a built-in geometry (other than PolygonGeometry and "
+      "Lines2DGeometry) generates its data on a background thread, so rebuilding "
+      "high resolution geometry every frame doesn't stall the shred. The result is "
+      "applied at the next GG.nextFrame(). Reading or editing the geometry's data "
+      "before then waits for the build to finish. Async builds are never shared, "
+      "see shared(). Default is false.");
+
+    SFUN(geo_get_async_build, "int", "asyncBuild");
+    DOC_FUNC("Get whether built-in geometries are built on a background thread.");
+
     END_CLASS();
 
     // Plane -----------------------------------------------------
@@ -772,10 +975,10 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
 // Geometry -----------------------------------------------------
 
 // if params is NULL, uses default values
-void ulib_geometry_build(SG_Geometry* geo, SG_GeometryType geo_type, void* params)
+// builds the CPU data for geo->geo_type. Only touches geo, so async builds run it
+// on a worker for built-in types other than lines2d and polygon
+static void ulib_geometry_build_cpu(SG_Geometry* geo, void* params, bool optimize)
 {
-    geo->geo_type = geo_type;
-
     switch (geo->geo_type) {
         case SG_GEOMETRY: {
             // custom geometry has no setup
@@ -837,9 +1040,385 @@ void ulib_geometry_build(SG_Geometry* geo, SG_GeometryType geo_type, void* param
         default: ASSERT(false);
     }
 
+    if (optimize && geo->geo_type != SG_GEOMETRY
+        && geo->geo_type != SG_GEOMETRY_LINES2D) {
+        ulib_geometry_optimize(geo, NULL);
+    }
+}
+
+// builds the CPU data for geo->geo_type and uploads it
+static void ulib_geometry_build_data(SG_Geometry* geo, void* params)
+{
+    ulib_geometry_build_cpu(geo, params, g_geometry_auto_optimize);
     CQ_UpdateAllVertexAttributes(geo);
 }
 
+// params as passed to ulib_geometry_build, NULL for defaults
+static GeometryCacheKey ulib_geometry_cache_key(SG_GeometryType type, void* params)
+{
+    GeometryCacheKey key;
+    memset(&key, 0, sizeof(key)); // hashed as bytes, padding must be zero
+    key.type = type;
+    switch (type) {
+        case SG_GEOMETRY_PLANE: {
+            key.params.plane = params ? *(PlaneParams*)params : PlaneParams();
+        } break;
+        case SG_GEOMETRY_CUBE: {
+            key.params.box = params ? *(BoxParams*)params : BoxParams();
+        } break;
+        case SG_GEOMETRY_CIRCLE: {
+            key.params.circle = params ? *(CircleParams*)params : CircleParams();
+        } break;
+        case SG_GEOMETRY_SPHERE: {
+            key.params.sphere = params ? *(SphereParams*)params : SphereParams();
+        } break;
+        case SG_GEOMETRY_CYLINDER: {
+            // field by field, CylinderParams is padded after openEnded
+            CylinderParams p = params ? *(CylinderParams*)params : CylinderParams();
+            CylinderParams* k = &key.params.cylinder;
+            k->radiusTop      = p.radiusTop;
+            k->radiusBottom   = p.radiusBottom;
+            k->height         = p.height;
+            k->radialSegments = p.radialSegments;
+            k->heightSegments = p.heightSegments;
+            k->openEnded      = p.openEnded;
+            k->thetaStart     = p.thetaStart;
+            k->thetaLength    = p.thetaLength;
+        } break;
+        case SG_GEOMETRY_TORUS: {
+            key.params.torus = params ? *(TorusParams*)params : TorusParams();
+        } break;
+        case SG_GEOMETRY_KNOT: {
+            key.params.knot = params ? *(KnotParams*)params : KnotParams();
+        } break;
+        case SG_GEOMETRY_POLYHEDRON: {
+            key.params.polyhedron
+              = params ? *(PolyhedronType*)params : PolyhedronType_Tetrahedron;
+        } break;
+        default: break; // suzanne has no parameters
+    }
+    return key;
+}
+
+// true if geo can draw with shared buffers without losing any of its draw state
+static bool ulib_geometry_shareable(SG_Geometry* geo)
+{
+    switch (geo->geo_type) {
+        case SG_GEOMETRY:
+        case SG_GEOMETRY_LINES2D:
+        case SG_GEOMETRY_POLYGON: return false;
+        default: break;
+    }
+    if (geo->vertex_count >= 0 || geo->index_count >= 0 || geo->lod_levels > 1)
+        return false;
+    for (int i = 0; i < CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS; i++) {
+        if (geo->vertex_pull_buffers[i].curr > 0) return false;
+    }
+    return true;
+}
+
+static SG_Geometry* ulib_geometry_cache_acquire(SG_GeometryType type, void* params)
+{
+    if (!g_geometry_cache) {
+        g_geometry_cache = hashmap_new(sizeof(GeometryCacheEntry), 0, 0, 0,
+                                       GeometryCacheEntry::hash,
+                                       GeometryCacheEntry::compare, NULL, NULL);
+    }
+
+    GeometryCacheEntry lookup = {};
+    lookup.key                = ulib_geometry_cache_key(type, params);
+    GeometryCacheEntry* entry
+      = (GeometryCacheEntry*)hashmap_get(g_geometry_cache, &lookup);
+    if (!entry) {
+        if (ARENA_LENGTH(&g_geometry_cache_unused, SG_Geometry*) > 0) {
+            lookup.geo = *ARENA_GET_LAST_TYPE(&g_geometry_cache_unused, SG_Geometry*);
+            ARENA_POP_TYPE(&g_geometry_cache_unused, SG_Geometry*);
+        } else {
+            lookup.geo = SG_CreateHiddenGeometry();
+            CQ_PushCommand_GeometryCreate(lookup.geo);
+        }
+        lookup.geo->geo_type = type;
+        ulib_geometry_build_data(lookup.geo, params);
+
+        hashmap_set(g_geometry_cache, &lookup);
+        entry = (GeometryCacheEntry*)hashmap_get(g_geometry_cache, &lookup);
+    }
+
+    entry->sharers++;
+    return entry->geo;
+}
+
+static void ulib_geometry_cache_release(GeometryCacheKey key)
+{
+    GeometryCacheEntry lookup = {};
+    lookup.key                = key;
+    GeometryCacheEntry* entry
+      = (GeometryCacheEntry*)hashmap_get(g_geometry_cache, &lookup);
+    ASSERT(entry && entry->sharers > 0);
+    if (--entry->sharers > 0) return;
+
+    // keep the hidden geometry and its GPU buffers around for reuse
+    *ARENA_PUSH_TYPE(&g_geometry_cache_unused, SG_Geometry*) = entry->geo;
+    hashmap_delete(g_geometry_cache, &lookup);
+}
+
+// pushes the vertex attribute at location
+static void ulib_geometry_upload_attribute(SG_Geometry* geo, int location)
+{
+    Arena* arena = &geo->vertex_attribute_data[location];
+    CQ_PushCommand_GeometrySetVertexAttribute(
+      geo, location, geo->vertex_attribute_num_components[location], arena->base,
+      arena->curr);
+}
+
+// pushes every vertex attribute and the indices, for when more than the built-in
+// attributes may have changed
+static void ulib_geometry_upload_all(SG_Geometry* geo)
+{
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        if (geo->vertex_attribute_num_components[i] == 0) continue;
+        ulib_geometry_upload_attribute(geo, i);
+    }
+    if (SG_Geometry::indexCount(geo) > 0) {
+        CQ_PushCommand_GeometrySetIndices(geo, SG_Geometry::getIndices(geo),
+                                          SG_Geometry::indexCount(geo));
+    }
+}
+
+static bool ulib_geometry_async_buildable(SG_GeometryType type)
+{
+    switch (type) {
+        case SG_GEOMETRY_PLANE:
+        case SG_GEOMETRY_CUBE:
+        case SG_GEOMETRY_CIRCLE:
+        case SG_GEOMETRY_SPHERE:
+        case SG_GEOMETRY_CYLINDER:
+        case SG_GEOMETRY_TORUS:
+        case SG_GEOMETRY_KNOT:
+        case SG_GEOMETRY_POLYHEDRON: return true;
+        default: return false;
+    }
+}
+
+static void ulib_geometry_build_job_run(void* udata)
+{
+    GeometryBuildJob* job = (GeometryBuildJob*)udata;
+    ulib_geometry_build_cpu(&job->scratch, &job->params, job->optimize);
+}
+
+// builds geo->geo_type with geo->params on the job pool
+static void ulib_geometry_build_submit(SG_Geometry* geo)
+{
+    GeometryBuildJob* job     = new GeometryBuildJob();
+    job->geo_id               = geo->id;
+    job->optimize             = g_geometry_auto_optimize;
+    job->params               = geo->params;
+    job->scratch.geo_type     = geo->geo_type;
+    job->scratch.vertex_count = -1;
+    job->scratch.index_count  = -1;
+
+    *ARENA_PUSH_TYPE(&g_geometry_build_jobs, GeometryBuildJob*) = job;
+    Jobs_Submit(ulib_geometry_build_job_run, job, &job->counter);
+}
+
+// swaps a finished build's data into its geometry and uploads it, then frees the
+// job. Removes the job at index i (swapping in the last one)
+static void ulib_geometry_build_apply(u64 i)
+{
+    GeometryBuildJob** jobs = (GeometryBuildJob**)g_geometry_build_jobs.base;
+    GeometryBuildJob* job   = jobs[i];
+    ASSERT(Jobs_Done(&job->counter));
+    jobs[i] = *ARENA_GET_LAST_TYPE(&g_geometry_build_jobs, GeometryBuildJob*);
+    ARENA_POP_TYPE(&g_geometry_build_jobs, GeometryBuildJob*);
+
+    SG_Geometry* geo = SG_GetGeometry(job->geo_id);
+    if (geo && !job->superseded) {
+        // the scratch arenas get the old data and are freed below
+        for (int a = 0; a < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; a++) {
+            std::swap(geo->vertex_attribute_data[a],
+                      job->scratch.vertex_attribute_data[a]);
+        }
+        std::swap(geo->indices, job->scratch.indices);
+        ++geo->indices_version;
+        memcpy(geo->vertex_attribute_num_components,
+               job->scratch.vertex_attribute_num_components,
+               sizeof(geo->vertex_attribute_num_components));
+        // the builders store the params they were actually built with
+        geo->params = job->scratch.params;
+        CQ_UpdateAllVertexAttributes(geo);
+    }
+
+    for (int a = 0; a < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; a++) {
+        Arena::free(&job->scratch.vertex_attribute_data[a]);
+    }
+    Arena::free(&job->scratch.indices);
+    delete job;
+}
+
+// the build that will replace geo's data, NULL if none
+static GeometryBuildJob* ulib_geometry_build_pending(SG_Geometry* geo, u64* index)
+{
+    u64 count               = ARENA_LENGTH(&g_geometry_build_jobs, GeometryBuildJob*);
+    GeometryBuildJob** jobs = (GeometryBuildJob**)g_geometry_build_jobs.base;
+    for (u64 i = 0; i < count; i++) {
+        if (jobs[i]->geo_id == geo->id && !jobs[i]->superseded) {
+            if (index) *index = i;
+            return jobs[i];
+        }
+    }
+    return NULL;
+}
+
+// waits for geo's pending build, if any, and applies it
+static void ulib_geometry_build_finish(SG_Geometry* geo)
+{
+    u64 index             = 0;
+    GeometryBuildJob* job = ulib_geometry_build_pending(geo, &index);
+    if (!job) return;
+    // runs the build here if no worker has started it, but no other queued jobs
+    Jobs_WaitOwn(&job->counter);
+    ulib_geometry_build_apply(index);
+}
+
+// drops geo's pending build when something newer replaces its data. The job
+// still runs, its result is freed once it finishes
+static void ulib_geometry_build_cancel(SG_Geometry* geo)
+{
+    GeometryBuildJob* job = ulib_geometry_build_pending(geo, NULL);
+    if (job) job->superseded = true;
+}
+
+// called once per frame on the audio thread, before the frame's commands are
+// flushed to the renderer
+static void ulib_geometry_applyAsyncBuilds()
+{
+    u64 i = 0;
+    while (i < ARENA_LENGTH(&g_geometry_build_jobs, GeometryBuildJob*)) {
+        GeometryBuildJob* job = *ARENA_GET_TYPE(&g_geometry_build_jobs,
+                                                GeometryBuildJob*, i);
+        if (Jobs_Done(&job->counter)) {
+            ulib_geometry_build_apply(i); // moves the last job into i
+        } else {
+            i++;
+        }
+    }
+}
+
+// call before editing a geometry. Finishes its pending async build. If it was
+// sharing data, it gets its own GPU buffers, uploaded from its CPU copy
+static void ulib_geometry_unshare(SG_Geometry* geo)
+{
+    ulib_geometry_build_finish(geo);
+    if (!geo->shared_geo_id) return;
+
+    ulib_geometry_cache_release(ulib_geometry_cache_key(geo->geo_type, &geo->params));
+    geo->shared_geo_id = 0;
+    CQ_PushCommand_GeometrySetShared(geo);
+    ulib_geometry_upload_all(geo);
+}
+
+void ulib_geometry_build(SG_Geometry* geo, SG_GeometryType geo_type, void* params)
+{
+    // a build still in flight is replaced by this one
+    ulib_geometry_build_cancel(geo);
+
+    if (g_geometry_async_build && ulib_geometry_async_buildable(geo_type)) {
+        // draws its current data from its own buffers until the build is applied.
+        // Async builds aren't shared, a new shared copy would be built right here
+        ulib_geometry_unshare(geo);
+        geo->geo_type = geo_type;
+        geo->params   = ulib_geometry_cache_key(geo_type, params).params;
+        ulib_geometry_build_submit(geo);
+        return;
+    }
+
+    // the data being replaced is released after acquiring the new data, so
+    // rebuilding with the same parameters doesn't rebuild the shared copy
+    SG_ID prev_shared_id      = geo->shared_geo_id;
+    GeometryCacheKey prev_key = {};
+    if (prev_shared_id) prev_key = ulib_geometry_cache_key(geo->geo_type, &geo->params);
+
+    geo->geo_type       = geo_type;
+    SG_Geometry* shared = NULL;
+    if (g_geometry_auto_share && ulib_geometry_shareable(geo)) {
+        shared = ulib_geometry_cache_acquire(geo_type, params);
+    }
+    if (prev_shared_id) ulib_geometry_cache_release(prev_key);
+
+    if (shared) {
+        // CPU copy for getters and for unsharing later
+        geo->params = shared->params;
+        memcpy(geo->vertex_attribute_num_components,
+               shared->vertex_attribute_num_components,
+               sizeof(geo->vertex_attribute_num_components));
+        for (int i = 0; i <= SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+            Arena* src = (i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES) ?
+                           &shared->vertex_attribute_data[i] :
+                           &shared->indices;
+            Arena* dst = (i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES) ?
+                           &geo->vertex_attribute_data[i] :
+                           &geo->indices;
+            Arena::clear(dst);
+            if (src->curr) memcpy(Arena::push(dst, src->curr), src->base, src->curr);
+        }
+        ++geo->indices_version;
+        geo->shared_geo_id = shared->id;
+    } else {
+        geo->shared_geo_id = 0;
+        ulib_geometry_build_data(geo, params);
+    }
+
+    if (geo->shared_geo_id != prev_shared_id) CQ_PushCommand_GeometrySetShared(geo);
+}
+
+bool ulib_geometry_auto_optimize()
+{
+    return g_geometry_auto_optimize;
+}
+
+bool ulib_geometry_optimize(SG_Geometry* geo, glm::vec2* acmr)
+{
+    u32 vertex_count = SG_Geometry::vertexCount(geo);
+    f32 acmr_before  = 0.0f;
+    f32 acmr_after   = 0.0f;
+    if (!SG_Geometry::optimize(geo, &acmr_before, &acmr_after)) return false;
+
+    log_trace("optimized geometry %s: %u -> %u vertices, ACMR %.3f -> %.3f",
+              geo->name, vertex_count, SG_Geometry::vertexCount(geo), acmr_before,
+              acmr_after);
+    if (acmr) *acmr = glm::vec2(acmr_before, acmr_after);
+    return true;
+}
+
+// recomputes normals, and tangents if the geometry has them, after its positions
+// changed. With prev_positions only the neighborhood of moved vertices is updated,
+// NULL recomputes every vertex
+static void ulib_geometry_update_normals(SG_Geometry* geo, const f32* prev_positions)
+{
+    u32 vertex_count = SG_Geometry::vertexCount(geo);
+    u32* moved       = NULL;
+    u32 moved_count  = 0;
+    if (prev_positions) {
+        moved       = ALLOCATE_COUNT(u32, vertex_count);
+        moved_count = SG_Geometry::movedVertices(geo, prev_positions, moved);
+        if (moved_count == 0) {
+            FREE_ARRAY(u32, moved, vertex_count);
+            return;
+        }
+    }
+
+    if (SG_Geometry::computeNormals(geo, moved, moved_count)) {
+        ulib_geometry_upload_attribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION);
+    }
+    int tangent_components
+      = geo->vertex_attribute_num_components[SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION];
+    if (tangent_components == 4
+        && SG_Geometry::computeTangents(geo, moved, moved_count)) {
+        ulib_geometry_upload_attribute(geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION);
+    }
+    FREE_ARRAY(u32, moved, vertex_count);
+}
+
 SG_Geometry* ulib_geometry_create(SG_GeometryType type, Chuck_VM_Shred* shred,
                                   void* geo_params = NULL)
 {
@@ -884,6 +1463,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute)
     */
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -902,6 +1482,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec2)
     Chuck_ArrayVec2* ck_arr = GET_NEXT_VEC2_ARRAY(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -920,6 +1501,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec3)
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -938,6 +1520,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec4)
     Chuck_ArrayVec4* ck_arr = GET_NEXT_VEC4_ARRAY(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -956,6 +1539,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute_int)
     Chuck_ArrayInt* ck_arr = GET_NEXT_INT_ARRAY(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -971,7 +1555,20 @@ CK_DLL_MFUN(geo_set_positions)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
+
+    // the previous positions tell which normals need updating
     Arena* attrib_arena
+      = &geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION];
+    u64 prev_length     = 0;
+    f32* prev_positions = NULL;
+    if (geo->auto_normals) {
+        prev_length    = ARENA_LENGTH(attrib_arena, f32);
+        prev_positions = ALLOCATE_COUNT(f32, prev_length);
+        memcpy(prev_positions, attrib_arena->base, prev_length * sizeof(f32));
+    }
+
+    attrib_arena
       = SG_Geometry::setAttribute(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, API,
                                   (Chuck_Object*)ck_arr, 3, false);
 
@@ -979,12 +1576,19 @@ CK_DLL_MFUN(geo_set_positions)
     CQ_PushCommand_GeometrySetVertexAttribute(
       geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, attrib_arena->base,
       attrib_arena->curr);
+
+    if (geo->auto_normals) {
+        bool same_count = (ARENA_LENGTH(attrib_arena, f32) == prev_length);
+        ulib_geometry_update_normals(geo, same_count ? prev_positions : NULL);
+        FREE_ARRAY(f32, prev_positions, prev_length);
+    }
 }
 
 CK_DLL_MFUN(geo_set_normals)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena
       = SG_Geometry::setAttribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3, API,
                                   (Chuck_Object*)ck_arr, 3, false);
@@ -998,7 +1602,8 @@ CK_DLL_MFUN(geo_set_normals)
 CK_DLL_MFUN(geo_set_uvs)
 {
     Chuck_ArrayVec2* ck_arr = GET_NEXT_VEC2_ARRAY(ARGS);
-    SG_Geometry* geo    = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena = SG_Geometry::setAttribute(
       geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2, API, (Chuck_Object*)ck_arr, 2, false);
 
@@ -1010,6 +1615,7 @@ CK_DLL_MFUN(geo_set_uvs)
 CK_DLL_MFUN(geo_get_positions)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     glm::vec3* data
       = (glm::vec3*)geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION]
@@ -1023,6 +1629,7 @@ CK_DLL_MFUN(geo_get_positions)
 CK_DLL_MFUN(geo_get_normals)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     glm::vec3* data
       = (glm::vec3*)geo->vertex_attribute_data[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION]
@@ -1036,6 +1643,7 @@ CK_DLL_MFUN(geo_get_normals)
 CK_DLL_MFUN(geo_get_uvs)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     glm::vec2* data
       = (glm::vec2*)geo->vertex_attribute_data[SG_GEOMETRY_UV_ATTRIBUTE_LOCATION].base;
@@ -1048,6 +1656,7 @@ CK_DLL_MFUN(geo_get_uvs)
 CK_DLL_MFUN(geo_get_vertex_attribute_num_components)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     Chuck_ArrayInt* ck_arr
       = chugin_createCkIntArray(geo->vertex_attribute_num_components,
@@ -1060,6 +1669,7 @@ CK_DLL_MFUN(geo_get_vertex_attribute_data)
 {
     t_CKINT location = GET_NEXT_INT(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     f32* data      = (f32*)geo->vertex_attribute_data[location].base;
     int data_count = ARENA_LENGTH(&geo->vertex_attribute_data[location], f32);
@@ -1071,6 +1681,7 @@ CK_DLL_MFUN(geo_get_vertex_attribute_data_int)
 {
     t_CKINT location = GET_NEXT_INT(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     i32* data      = (i32*)geo->vertex_attribute_data[location].base;
     int data_count = ARENA_LENGTH(&geo->vertex_attribute_data[location], i32);
@@ -1084,15 +1695,19 @@ CK_DLL_MFUN(geo_set_indices)
     t_CKINT ck_arr_len     = API->object->array_int_size(ck_arr);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     u32* indices = SG_Geometry::setIndices(geo, API, ck_arr, ck_arr_len);
 
     CQ_PushCommand_GeometrySetIndices(geo, indices, ck_arr_len);
+
+    if (geo->auto_normals) ulib_geometry_update_normals(geo, NULL);
 }
 
 CK_DLL_MFUN(geo_get_indices)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_build_finish(geo);
 
     u32* indices    = SG_Geometry::getIndices(geo);
     int index_count = SG_Geometry::indexCount(geo);
@@ -1107,6 +1722,8 @@ CK_DLL_MFUN(geo_get_indices)
 void ulib_geo_set_pulled_vertex_attribute_data(SG_Geometry* geo, t_CKINT location,
                                                f32* data, int data_len)
 {
+    ulib_geometry_unshare(geo);
+
     // store locally on SG_Geometry
     Arena* pull_buffer = &geo->vertex_pull_buffers[location];
     Arena::clear(pull_buffer);
@@ -1122,6 +1739,7 @@ void ulib_geo_set_pulled_vertex_attribute_data(SG_Geometry* geo, t_CKINT locatio
 void geoSetPulledVertexAttribute(SG_Geometry* geo, t_CKINT location,
                                  Chuck_Object* ck_arr, int num_components, bool is_int)
 {
+    ulib_geometry_unshare(geo);
     int ck_arr_len = 0;
 
     // store locally on SG_Geometry
@@ -1259,8 +1877,9 @@ CK_DLL_MFUN(geo_get_pulled_vertex_attribute_int)
 
 CK_DLL_MFUN(geo_set_vertex_count)
 {
-    t_CKINT count     = GET_NEXT_INT(ARGS);
-    SG_Geometry* geo  = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    t_CKINT count    = GET_NEXT_INT(ARGS);
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     geo->vertex_count = count;
     CQ_PushCommand_GeometrySetVertexCount(geo, count);
 }
@@ -1275,6 +1894,7 @@ CK_DLL_MFUN(geo_set_index_count)
 {
     t_CKINT count    = GET_NEXT_INT(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     geo->index_count = count;
     CQ_PushCommand_GeometrySetIndicesCount(geo, count);
 }
@@ -1285,6 +1905,137 @@ CK_DLL_MFUN(geo_get_index_count)
       = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id))->index_count;
 }
 
+CK_DLL_MFUN(geo_set_lod_levels)
+{
+    t_CKINT levels   = GET_NEXT_INT(ARGS);
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    // LODs are generated per R_Geometry, a shared one stays at a single level
+    ulib_geometry_unshare(geo);
+    geo->lod_levels = CLAMP(levels, 1, CHUGL_GEOMETRY_MAX_LODS);
+    CQ_PushCommand_GeometrySetLOD(geo);
+}
+
+CK_DLL_MFUN(geo_get_lod_levels)
+{
+    RETURN->v_int
+      = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id))->lod_levels;
+}
+
+CK_DLL_MFUN(geo_set_lod_thresholds)
+{
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    chugin_copyCkFloatArray(GET_NEXT_FLOAT_ARRAY(ARGS), geo->lod_thresholds,
+                            ARRAY_LENGTH(geo->lod_thresholds));
+    CQ_PushCommand_GeometrySetLOD(geo);
+}
+
+CK_DLL_MFUN(geo_get_lod_thresholds)
+{
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    RETURN->v_object = (Chuck_Object*)chugin_createCkFloatArray(
+      geo->lod_thresholds, ARRAY_LENGTH(geo->lod_thresholds));
+}
+
+CK_DLL_MFUN(geo_set_lod_force)
+{
+    t_CKINT level    = GET_NEXT_INT(ARGS);
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    geo->lod_force   = MAX(level, -1);
+    CQ_PushCommand_GeometrySetLOD(geo);
+}
+
+CK_DLL_MFUN(geo_get_lod_force)
+{
+    RETURN->v_int
+      = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id))->lod_force;
+}
+
+CK_DLL_MFUN(geo_optimize)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    glm::vec2 acmr   = {};
+    ulib_geometry_unshare(geo);
+    // every attribute was reordered, not just the built-in ones
+    if (ulib_geometry_optimize(geo, &acmr)) ulib_geometry_upload_all(geo);
+    RETURN->v_vec2 = { acmr.x, acmr.y };
+}
+
+CK_DLL_MFUN(geo_compute_normals)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    ulib_geometry_unshare(geo);
+    RETURN->v_int = SG_Geometry::computeNormals(geo, NULL, 0);
+    if (RETURN->v_int) {
+        ulib_geometry_upload_attribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION);
+    }
+}
+
+CK_DLL_MFUN(geo_compute_tangents)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    ulib_geometry_unshare(geo);
+    RETURN->v_int = SG_Geometry::computeTangents(geo, NULL, 0);
+    if (RETURN->v_int) {
+        ulib_geometry_upload_attribute(geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION);
+    }
+}
+
+CK_DLL_MFUN(geo_set_auto_normals)
+{
+    SG_Geometry* geo  = GET_GEOMETRY(SELF);
+    bool was_enabled  = geo->auto_normals;
+    geo->auto_normals = (GET_NEXT_INT(ARGS) != 0);
+    if (geo->auto_normals && !was_enabled) {
+        ulib_geometry_unshare(geo);
+        ulib_geometry_update_normals(geo, NULL);
+    }
+}
+
+CK_DLL_MFUN(geo_get_auto_normals)
+{
+    RETURN->v_int = GET_GEOMETRY(SELF)->auto_normals;
+}
+
+CK_DLL_SFUN(geo_set_auto_optimize)
+{
+    g_geometry_auto_optimize = (GET_NEXT_INT(ARGS) != 0);
+}
+
+CK_DLL_SFUN(geo_get_auto_optimize)
+{
+    RETURN->v_int = g_geometry_auto_optimize;
+}
+
+CK_DLL_MFUN(geo_get_shared)
+{
+    RETURN->v_int = (GET_GEOMETRY(SELF)->shared_geo_id != 0);
+}
+
+CK_DLL_SFUN(geo_set_auto_share)
+{
+    g_geometry_auto_share = (GET_NEXT_INT(ARGS) != 0);
+}
+
+CK_DLL_SFUN(geo_get_auto_share)
+{
+    RETURN->v_int = g_geometry_auto_share;
+}
+
+CK_DLL_MFUN(geo_get_building)
+{
+    RETURN->v_int = (ulib_geometry_build_pending(GET_GEOMETRY(SELF), NULL) != NULL);
+}
+
+CK_DLL_SFUN(geo_set_async_build)
+{
+    g_geometry_async_build = (GET_NEXT_INT(ARGS) != 0);
+}
+
+CK_DLL_SFUN(geo_get_async_build)
+{
+    RETURN->v_int = g_geometry_async_build;
+}
+
 // Plane Geometry -----------------------------------------------------
 
 void CQ_UpdateAllVertexAttributes(SG_Geometry* geo)
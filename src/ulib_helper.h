@@ -453,6 +453,8 @@ void ulib_geo_lines2d_set_lines_points(SG_Geometry* geo, Chuck_Object* ck_arr, i
 void ulib_geo_lines2d_set_line_colors(SG_Geometry* geo, Chuck_Object* ck_arr);
 void ulib_geo_lines2d_set_line_colors(SG_Geometry* geo, f32* data, int data_len);
 void CQ_UpdateAllVertexAttributes(SG_Geometry* geo);
+bool ulib_geometry_auto_optimize();
+bool ulib_geometry_optimize(SG_Geometry* geo, glm::vec2* acmr);
 void ulib_geo_set_pulled_vertex_attribute_data(SG_Geometry* geo, t_CKINT location,
                                                f32* data, int data_len);
 void geoSetPulledVertexAttribute(SG_Geometry* geo, t_CKINT location,
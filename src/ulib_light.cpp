@@ -57,6 +57,8 @@ CK_DLL_MFUN(ulib_light_shadow_bias_get);
 CK_DLL_CTOR(ulib_dir_light_ctor);
 CK_DLL_MFUN(ulib_dir_light_shadow_size_set);
 CK_DLL_MFUN(ulib_dir_light_shadow_size_get);
+CK_DLL_MFUN(ulib_dir_light_shadow_cascades_set);
+CK_DLL_MFUN(ulib_dir_light_shadow_cascades_get);
 
 CK_DLL_CTOR(ulib_point_light_ctor);
 CK_DLL_MFUN(ulib_point_light_get_radius);
@@ -243,6 +245,21 @@ static void ulib_light_query(Chuck_DL_Query* QUERY)
       "mapping. .x and .y are the width/height, .z is the depth. During rendering, "
       "the near plane is -z/2, and the far plane is z/2");
 
+    MFUN(ulib_dir_light_shadow_cascades_set, "void", "shadowCascades");
+    ARG("int", "count");
+    ARG("float", "distance");
+    DOC_FUNC(
+      "Split the shadow map of this light into `count` cascades (1 to 4) that "
+      "cover the view of the scene camera out to `distance` units. Cascades close to "
+      "the camera get more shadow resolution. With 1 cascade (the default) the shadow "
+      "covers a fixed square around the light, see shadowBounds(). The depth from "
+      "shadowBounds() is used for every cascade.");
+
+    MFUN(ulib_dir_light_shadow_cascades_get, "vec2", "shadowCascades");
+    DOC_FUNC(
+      "Returns the shadow cascade settings. .x is the cascade count, .y is the "
+      "distance from the camera covered by the cascades");
+
     END_CLASS();
 
     { // Spotlight
@@ -373,11 +390,6 @@ CK_DLL_MFUN(ulib_light_generates_shadow_set)
 {
     SG_Light* light = GET_LIGHT(SELF);
 
-    if (light->desc.type == SG_LightType_Point) {
-        log_warn("PointLight Shadows are not implemented.");
-        return;
-    }
-
     light->desc.generates_shadows = GET_NEXT_INT(ARGS) ? 1 : 0;
     CQ_PushCommand_LightUpdate(light);
 }
@@ -468,6 +480,25 @@ CK_DLL_MFUN(ulib_dir_light_shadow_size_get)
     };
 }
 
+CK_DLL_MFUN(ulib_dir_light_shadow_cascades_set)
+{
+    SG_Light* light = GET_LIGHT(SELF);
+    t_CKINT count   = GET_NEXT_INT(ARGS);
+    light->desc.dirlight_shadow_cascades.count
+      = CLAMP(count, 1, CHUGL_MAX_SHADOW_CASCADES);
+    light->desc.dirlight_shadow_cascades.distance = MAX(GET_NEXT_FLOAT(ARGS), 0.0);
+    CQ_PushCommand_LightUpdate(light);
+}
+
+CK_DLL_MFUN(ulib_dir_light_shadow_cascades_get)
+{
+    SG_Light* light = GET_LIGHT(SELF);
+    RETURN->v_vec2  = {
+        (t_CKFLOAT)light->desc.dirlight_shadow_cascades.count,
+        light->desc.dirlight_shadow_cascades.distance,
+    };
+}
+
 // Spotlight =====================================================
 
 CK_DLL_CTOR(ulib_spot_light_ctor)
@@ -3041,12 +3041,6 @@ void chugl_initDefaultMaterials()
         WGPUVertexFormat_Float32x2, // uv
     };
 
-    static WGPUVertexFormat gtext_vertex_layout[] = {
-        WGPUVertexFormat_Float32x2, // position
-        WGPUVertexFormat_Float32x2, // uv
-        WGPUVertexFormat_Sint32,    // glyph_index
-    };
-
     {
         CHUGL_ShaderDesc lines_2d_shader_desc = {};
         lines_2d_shader_desc.vertex_string    = lines2d_shader_string;
@@ -3066,12 +3060,10 @@ void chugl_initDefaultMaterials()
     }
 
     {
-
-        CHUGL_ShaderDesc gtext_shader_desc    = {};
-        gtext_shader_desc.vertex_string       = gtext_shader_string;
-        gtext_shader_desc.fragment_string     = gtext_shader_string;
-        gtext_shader_desc.vertex_layout       = gtext_vertex_layout;
-        gtext_shader_desc.vertex_layout_count = ARRAY_LENGTH(gtext_vertex_layout);
+        // glyph quads are pulled from instances, no vertex layout
+        CHUGL_ShaderDesc gtext_shader_desc = {};
+        gtext_shader_desc.vertex_string    = gtext_shader_string;
+        gtext_shader_desc.fragment_string  = gtext_shader_string;
         g_material_builtin_shaders.gtext_shader_id
           = chugl_createShader(&gtext_shader_desc, "GText");
     }
@@ -3112,6 +3104,7 @@ void chugl_initDefaultMaterials()
         pbr_shader_desc.vertex_layout       = standard_vertex_layout;
         pbr_shader_desc.vertex_layout_count = ARRAY_LENGTH(standard_vertex_layout);
         pbr_shader_desc.includes.lit        = true;
+        pbr_shader_desc.includes.clustered  = true;
         g_material_builtin_shaders.pbr_shader_id
           = chugl_createShader(&pbr_shader_desc, "PBR");
     }
@@ -3156,6 +3149,7 @@ void chugl_initDefaultMaterials()
         phong_shader_desc.includes.lit          = true;
         phong_shader_desc.includes.uses_env_map = true;
         phong_shader_desc.includes.shadows      = true;
+        phong_shader_desc.includes.clustered    = true;
         g_material_builtin_shaders.phong_shader_id
           = chugl_createShader(&phong_shader_desc, "Phong");
     }
@@ -84,6 +84,12 @@ CK_DLL_MFUN(scenepass_get_camera);
 
 CK_DLL_MFUN(scenepass_get_msaa);
 CK_DLL_MFUN(scenepass_set_msaa);
+CK_DLL_MFUN(scenepass_get_gpu_culling);
+CK_DLL_MFUN(scenepass_set_gpu_culling);
+CK_DLL_MFUN(scenepass_get_occlusion_culling);
+CK_DLL_MFUN(scenepass_set_occlusion_culling);
+CK_DLL_MFUN(scenepass_get_visible_instances);
+CK_DLL_MFUN(scenepass_get_occluded_instances);
 
 // TODO add set/get HDR?
 
@@ -325,6 +331,46 @@ void ulib_pass_query(Chuck_DL_Query* QUERY)
           "render the scene into a 4xMSAA texture and perform an MSAA resolve "
           "into the texture set with ScenePass.colorOutput(). Default false.");
 
+        MFUN(scenepass_get_gpu_culling, "int", "gpuCulling");
+        DOC_FUNC(
+          "Returns whether this scenepass culls instances of opaque meshes on the GPU");
+
+        MFUN(scenepass_set_gpu_culling, "void", "gpuCulling");
+        ARG("int", "gpu_culling");
+        DOC_FUNC(
+          "Set whether this scenepass culls instances of opaque meshes on the GPU. If "
+          "true, a compute pass tests every instance against the camera frustum and "
+          "only the visible ones are drawn, using indirect draws. CPU cost then stays "
+          "the same however many meshes share a geometry and material. Useful for "
+          "scenes with tens of thousands of meshes. Transparent meshes are not "
+          "culled. Default false.");
+
+        MFUN(scenepass_get_occlusion_culling, "int", "occlusionCulling");
+        DOC_FUNC("Returns whether this scenepass culls instances hidden behind other "
+                 "meshes");
+
+        MFUN(scenepass_set_occlusion_culling, "void", "occlusionCulling");
+        ARG("int", "occlusion_culling");
+        DOC_FUNC(
+          "Set whether this scenepass culls instances of opaque meshes hidden behind "
+          "other meshes. Implies ScenePass.gpuCulling(). Each frame a depth pyramid "
+          "is built from the scenepass depth buffer, and the next frame instances "
+          "whose bounds lie entirely behind it are not drawn. Useful for indoor "
+          "scenes where walls hide most meshes. Since last frame's depth is used, a "
+          "mesh that is suddenly uncovered, e.g. by a fast moving occluder, can "
+          "appear one frame late. Default false.");
+
+        MFUN(scenepass_get_visible_instances, "int", "visibleInstances");
+        DOC_FUNC(
+          "Number of opaque mesh instances drawn after GPU culling. Read back from "
+          "the GPU, so lags a few frames behind. 0 if gpu culling is off.");
+
+        MFUN(scenepass_get_occluded_instances, "int", "occludedInstances");
+        DOC_FUNC(
+          "Number of opaque mesh instances in the camera view that occlusion culling "
+          "skipped because they were hidden. Read back from the GPU, so lags a few "
+          "frames behind. 0 if occlusion culling is off.");
+
         END_CLASS();
     }
 
@@ -894,6 +940,52 @@ CK_DLL_MFUN(scenepass_set_msaa)
     CQ_PushCommand_PassUpdate(pass);
 }
 
+CK_DLL_MFUN(scenepass_get_gpu_culling)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    RETURN->v_int = pass->scene_pass_gpu_culling;
+}
+
+CK_DLL_MFUN(scenepass_set_gpu_culling)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    pass->scene_pass_gpu_culling = GET_NEXT_INT(ARGS) ? 1 : 0;
+
+    CQ_PushCommand_PassUpdate(pass);
+}
+
+CK_DLL_MFUN(scenepass_get_occlusion_culling)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    RETURN->v_int = pass->scene_pass_occlusion_culling;
+}
+
+CK_DLL_MFUN(scenepass_set_occlusion_culling)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    pass->scene_pass_occlusion_culling = GET_NEXT_INT(ARGS) ? 1 : 0;
+
+    CQ_PushCommand_PassUpdate(pass);
+}
+
+CK_DLL_MFUN(scenepass_get_visible_instances)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    RETURN->v_int = pass->scene_pass_visible_instances;
+}
+
+CK_DLL_MFUN(scenepass_get_occluded_instances)
+{
+    SG_Pass* pass = GET_PASS(SELF);
+    ASSERT(pass->pass_type == SG_PassType_Scene);
+    RETURN->v_int = pass->scene_pass_occluded_instances;
+}
+
 // ============================================================================
 // ScreenPass
 // ============================================================================
@@ -47,6 +47,8 @@ CK_DLL_MFUN(gscene_get_ambient_light);
 
 CK_DLL_MFUN(gscene_get_default_light);
 CK_DLL_MFUN(gscene_get_lights);
+CK_DLL_MFUN(gscene_get_active_lights);
+CK_DLL_MFUN(gscene_get_uploaded_lights);
 
 CK_DLL_MFUN(gscene_set_environment_map);
 CK_DLL_MFUN(gscene_get_environment_map);
@@ -151,6 +153,18 @@ static void ulib_gscene_query(Chuck_DL_Query* QUERY)
     MFUN(gscene_get_lights, "GLight[]", "lights");
     DOC_FUNC("Get array of all lights in the scene");
 
+    MFUN(gscene_get_active_lights, "int", "activeLights");
+    DOC_FUNC(
+      "Get the number of lights that reached the camera view in the last rendered "
+      "frame. Point and spot lights whose radius lies outside the camera frustum are "
+      "culled and skip lighting calculations entirely");
+
+    MFUN(gscene_get_uploaded_lights, "int", "uploadedLights");
+    DOC_FUNC(
+      "Get the number of lights whose data was re-uploaded to the GPU in the last "
+      "rendered frame. A light is only re-uploaded when its parameters or transform "
+      "change");
+
     MFUN(gscene_set_environment_map, "void", "envMap");
     ARG(SG_CKNames[SG_COMPONENT_TEXTURE], "envMap");
     DOC_FUNC(
@@ -293,6 +307,18 @@ CK_DLL_MFUN(gscene_get_lights)
     RETURN->v_object = (Chuck_Object*)light_ck_array;
 }
 
+CK_DLL_MFUN(gscene_get_active_lights)
+{
+    SG_Scene* scene = SG_GetScene(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    RETURN->v_int   = scene->lights_active;
+}
+
+CK_DLL_MFUN(gscene_get_uploaded_lights)
+{
+    SG_Scene* scene = SG_GetScene(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    RETURN->v_int   = scene->lights_uploaded;
+}
+
 CK_DLL_MFUN(gscene_set_environment_map)
 {
     SG_Scene* scene      = SG_GetScene(OBJ_MEMBER_UINT(SELF, component_offset_id));
@@ -34,7 +34,11 @@
 
 #define GET_TEXT(ckobj) (SG_GetText(OBJ_MEMBER_UINT(ckobj, component_offset_id)))
 
+// written back by the renderer, see SG_COMMAND_G2A_FONT_STATS
+static u32 ulib_text_font_references = 0;
+
 CK_DLL_SFUN(gtext_set_default_font);
+CK_DLL_SFUN(gtext_get_font_references);
 
 CK_DLL_CTOR(gtext_ctor);
 
@@ -76,6 +80,8 @@ CK_DLL_MFUN(gtext_get_align);
 CK_DLL_MFUN(gtext_set_size);
 CK_DLL_MFUN(gtext_get_size);
 
+CK_DLL_MFUN(gtext_get_bounds);
+
 void ulib_text_query(Chuck_DL_Query* QUERY)
 {
     BEGIN_CLASS("GText", SG_CKNames[SG_COMPONENT_TRANSFORM]);
@@ -89,6 +95,12 @@ void ulib_text_query(Chuck_DL_Query* QUERY)
     ARG("string", "default_font");
     DOC_FUNC("Set default font file to be used by all GText not given a font path");
 
+    SFUN(gtext_get_font_references, "int", "fontReferences");
+    DOC_FUNC(
+      "Get the number of references held on loaded fonts, one per GText plus the "
+      "renderer's own. A GText releases its font when it is garbage collected. "
+      "Updated by the renderer, so changes are visible after the next GG.nextFrame()");
+
     CTOR(gtext_ctor);
 
     MFUN(gtext_set_color, "void", "color");
@@ -114,7 +126,8 @@ void ulib_text_query(Chuck_DL_Query* QUERY)
     DOC_FUNC(
       "Set path to a font file (supported types: .otf and .ttf). If not provided, will "
       "default to the font set via GText.defaultFont(). See top of class doc for list "
-      "of builtin font names");
+      "of builtin font names. Font files are loaded in the background; until loaded "
+      "the text is drawn with the default font");
 
     MFUN(gtext_get_font, "string", "font");
     DOC_FUNC("Get path to font file");
@@ -213,6 +226,13 @@ void ulib_text_query(Chuck_DL_Query* QUERY)
     MFUN(gtext_get_size, "float", "size");
     DOC_FUNC("Get the font size scale. Default 1.0");
 
+    MFUN(gtext_get_bounds, "vec4", "bounds");
+    DOC_FUNC(
+      "Get the bounding box of the laid out text in local space as (min x, min y, max "
+      "x, max y), offset by GText.controlPoints(). Updated by the renderer after the "
+      "text changes, so the new bounds are available after the next GG.nextFrame(). "
+      "Returns all zeros for empty text");
+
     END_CLASS();
 }
 
@@ -221,6 +241,11 @@ CK_DLL_SFUN(gtext_set_default_font)
     CQ_PushCommand_TextDefaultFont(API->object->str(GET_NEXT_STRING(ARGS)));
 }
 
+CK_DLL_SFUN(gtext_get_font_references)
+{
+    RETURN->v_int = ulib_text_font_references;
+}
+
 CK_DLL_CTOR(gtext_ctor)
 {
     // not extend GMesh for now to not expose underlying geometry/material
@@ -484,3 +509,18 @@ CK_DLL_MFUN(gtext_get_size)
 {
     RETURN->v_float = GET_TEXT(SELF)->size;
 }
+
+CK_DLL_MFUN(gtext_get_bounds)
+{
+    SG_Text* text = GET_TEXT(SELF);
+    t_CKVEC4 bb   = text->bounds;
+    if (bb.x > bb.z || bb.y > bb.w) { // nothing laid out
+        RETURN->v_vec4 = { 0, 0, 0, 0 };
+        return;
+    }
+
+    // origin is placed by control points, see gtext_shader_string
+    double cx      = bb.x + text->control_points.x * (bb.z - bb.x);
+    double cy      = bb.y + text->control_points.y * (bb.w - bb.y);
+    RETURN->v_vec4 = { bb.x - cx, bb.y - cy, bb.z - cx, bb.w - cy };
+}
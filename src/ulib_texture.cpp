@@ -35,6 +35,8 @@
 #include "core/file.h"
 #include "core/log.h"
 
+#include "texture_compress.h"
+
 #include <stb/stb_image.h>
 
 void ulib_texture_createDefaults(CK_DL_API API);
@@ -90,6 +92,8 @@ CK_DLL_CTOR(texture_load_desc_ctor);
 static t_CKUINT texture_load_desc_flip_y_offset      = 0;
 static t_CKUINT texture_load_desc_gen_mips_offset    = 0;
 static t_CKUINT texture_load_desc_load_to_cpu_offset = 0;
+static t_CKUINT texture_load_desc_format_offset      = 0;
+static t_CKUINT texture_load_desc_compress_offset    = 0;
 
 // TextureSaveEvent -----------------------------------------------------------------
 static t_CKUINT texture_save_event_status_offset = 0;
@@ -122,6 +126,9 @@ CK_DLL_SFUN(texture_load_2d_file);
 CK_DLL_SFUN(texture_load_2d_raw);
 CK_DLL_SFUN(texture_load_2d_file_with_params);
 CK_DLL_SFUN(texture_load_cubemap);
+CK_DLL_SFUN(texture_equirect_to_cubemap);
+CK_DLL_SFUN(texture_set_cache_directory);
+CK_DLL_SFUN(texture_get_cache_directory);
 
 // copy texture
 CK_DLL_SFUN(texture_copy_texture_to_texture);
@@ -130,6 +137,10 @@ CK_DLL_SFUN(texture_copy_texture_to_texture_with_desc);
 // saving to drive
 CK_DLL_MFUN(texture_save);
 
+// async loading
+CK_DLL_MFUN(texture_loaded);
+CK_DLL_MFUN(texture_is_loaded);
+
 static void ulib_texture_query(Chuck_DL_Query* QUERY)
 {
     { // Sampler (only passed by value)
@@ -329,6 +340,27 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
           "When loading, also write the texture data to a chuck array, accessible via "
           "Texture.data(). Default false, due to the steep performance cost.");
 
+        texture_load_desc_format_offset = MVAR("int", "format", false);
+        DOC_VAR(
+          "Texture format to decode into. One of Texture.FORMAT_RGBA8UNORM, "
+          "Texture.FORMAT_RGBA16FLOAT, or Texture.FORMAT_RGBA32FLOAT. Default 0, "
+          "which picks RGBA16FLOAT for HDR (.hdr) and 16-bit images and RGBA8UNORM "
+          "for everything else. HDR images keep their full range in float formats, "
+          "other images are normalized to [0, 1]. Use RGBA32FLOAT to keep the exact "
+          "values of 16-bit images, e.g. heightmaps.");
+
+        texture_load_desc_compress_offset = MVAR("int", "compress", false);
+        DOC_VAR(
+          "Store 8-bit images in a GPU-compressed format (BC1, or BC3 for images with "
+          "transparency), using 4-8x less video memory at a small cost in quality. "
+          "The first load transcodes the image in the background and saves the result "
+          "to the texture cache (see Texture.cacheDirectory()), later loads of the "
+          "same file skip decoding entirely. Only applies to images whose width and "
+          "height are multiples of 4, and GPUs that support BC compression. Compressed "
+          "textures can't be written to, read back or saved. Default false. "
+          "Note: .ktx2 and .dds files are always loaded in their own compressed "
+          "format, regardless of this option.");
+
         END_CLASS();
     }
 
@@ -461,6 +493,29 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
         ARG("string", "front");
         DOC_FUNC("Load a cubemap texture from 6 filepaths, one for each face");
 
+        SFUN(texture_equirect_to_cubemap, SG_CKNames[SG_COMPONENT_TEXTURE],
+             "equirectToCubemap");
+        ARG(SG_CKNames[SG_COMPONENT_TEXTURE], "equirect");
+        ARG("int", "face_size");
+        DOC_FUNC(
+          "Create a cubemap from an equirectangular (latitude-longitude) panorama, "
+          "e.g. an .hdr environment map loaded with Texture.load(). Each face is "
+          "face_size x face_size pixels, format Texture.FORMAT_RGBA16FLOAT. The "
+          "conversion runs on the GPU once the source texture has finished loading. "
+          "The center of the panorama faces the -Z direction");
+
+        SFUN(texture_set_cache_directory, "void", "cacheDirectory");
+        ARG("string", "path");
+        DOC_FUNC(
+          "Set the directory where textures loaded with TextureLoadDesc.compress are "
+          "cached. Created on first use. Pass an empty string to restore the default "
+          "location.");
+
+        SFUN(texture_get_cache_directory, "string", "cacheDirectory");
+        DOC_FUNC(
+          "Get the directory where textures loaded with TextureLoadDesc.compress are "
+          "cached. Deleting its contents is always safe.");
+
         SFUN(texture_copy_texture_to_texture, "void", "copy");
         ARG(SG_CKNames[SG_COMPONENT_TEXTURE], "dst_texture");
         ARG(SG_CKNames[SG_COMPONENT_TEXTURE], "src_texture");
@@ -573,6 +628,20 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
           "returned by this method, which will be broadcast when the texture data is "
           "finished saving.");
 
+        MFUN(texture_loaded, "Event", "loaded");
+        DOC_FUNC(
+          "Event broadcast once a texture created by Texture.load() has been decoded "
+          "and uploaded to the GPU. Images are decoded in the background, and the "
+          "texture shows a grey placeholder until then. The event is broadcast only "
+          "once, so check isLoaded() before waiting on it, e.g. `if "
+          "(!tex.isLoaded()) tex.loaded() => now;`");
+
+        MFUN(texture_is_loaded, "int", "isLoaded");
+        DOC_FUNC(
+          "Returns 0 while a texture created by Texture.load() is still being decoded "
+          "in the background, 1 otherwise. Also 1 if loading failed, in which case "
+          "the texture keeps its placeholder contents");
+
         END_CLASS();
     }
 
@@ -741,6 +810,8 @@ CK_DLL_CTOR(texture_load_desc_ctor)
     OBJ_MEMBER_INT(SELF, texture_load_desc_flip_y_offset)      = false;
     OBJ_MEMBER_INT(SELF, texture_load_desc_gen_mips_offset)    = true;
     OBJ_MEMBER_INT(SELF, texture_load_desc_load_to_cpu_offset) = false;
+    OBJ_MEMBER_INT(SELF, texture_load_desc_format_offset)      = 0; // auto
+    OBJ_MEMBER_INT(SELF, texture_load_desc_compress_offset)    = false;
 }
 
 static SG_TextureLoadDesc ulib_texture_textureLoadDescFromCkobj(Chuck_Object* ckobj)
@@ -751,6 +822,9 @@ static SG_TextureLoadDesc ulib_texture_textureLoadDescFromCkobj(Chuck_Object* ck
     desc.flip_y             = OBJ_MEMBER_INT(ckobj, texture_load_desc_flip_y_offset);
     desc.gen_mips           = OBJ_MEMBER_INT(ckobj, texture_load_desc_gen_mips_offset);
     desc.read_to_ck_array = OBJ_MEMBER_INT(ckobj, texture_load_desc_load_to_cpu_offset);
+    desc.format
+      = (WGPUTextureFormat)OBJ_MEMBER_INT(ckobj, texture_load_desc_format_offset);
+    desc.compress = OBJ_MEMBER_INT(ckobj, texture_load_desc_compress_offset) ? true : false;
 
     return desc;
 }
@@ -888,7 +962,8 @@ CK_DLL_MFUN(texture_get_usage)
 
 CK_DLL_MFUN(texture_get_mips)
 {
-    RETURN->v_int = GET_TEXTURE(SELF)->desc.gen_mips;
+    SG_Texture* tex = GET_TEXTURE(SELF);
+    RETURN->v_int   = tex->desc.gen_mips || tex->desc.mip_levels > 1;
 }
 
 CK_DLL_MFUN(texture_get_resizable)
@@ -934,7 +1009,8 @@ static void ulib_texture_write(SG_Texture* tex, Chuck_ArrayFloat* ck_arr,
         // check mip level valid (only checking for fixed size textures because how do
         // we know the size of a resizable one?)
         if (tex->desc.resize_mode == SG_TextureResizeMode_Fixed) {
-            int max_mips = G_mipLevels(tex->desc.width, tex->desc.height);
+            int max_mips = SG_TextureDesc::mipLevelCount(&tex->desc, tex->desc.width,
+                                                         tex->desc.height);
             if (desc->mip >= max_mips) {
                 snprintf(err_msg, sizeof(err_msg),
                          "invalid mip level. texture has %d mips, but tried to "
@@ -999,29 +1075,68 @@ CK_DLL_MFUN(texture_write_external_ptr)
     CQ_PushCommand_TextureWriteExternalPtr(tex, &desc, external_ptr);
 }
 
-SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_desc,
-                              Chuck_VM_Shred* shred)
+// texture format to decode an image into, see TextureLoadDesc.format
+static WGPUTextureFormat ulib_texture_loadFormat(SG_TextureLoadDesc* load_desc,
+                                                 bool is_hdr, bool is_16_bit)
 {
-    int width = 0, height = 0, num_components = 0;
-    int desired_comps      = STBI_rgb_alpha;
-    void* pixel_data_OWNED = NULL;
-    bool stbi_error        = false;
+    switch (load_desc->format) {
+        case WGPUTextureFormat_Undefined: break;
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_RGBA16Float:
+        case WGPUTextureFormat_RGBA32Float: return load_desc->format;
+        default: {
+            log_warn("TextureLoadDesc.format %d is not supported for loading images",
+                     load_desc->format);
+            log_warn(" |- Defaulting based on image type");
+        }
+    }
+    return (is_hdr || is_16_bit) ? WGPUTextureFormat_RGBA16Float :
+                                   WGPUTextureFormat_RGBA8Unorm;
+}
 
-    defer(stbi_image_free(pixel_data_OWNED));
+// KTX2 / DDS. Texture is created as an RGBA8 placeholder of the right size,
+// the renderer switches it to the file's format and mip chain once loaded
+static SG_Texture* ulib_texture_loadContainer(const char* filepath,
+                                              SG_TextureLoadDesc* load_desc,
+                                              Chuck_VM_Shred* shred)
+{
+    CompressedImage info = {};
+    if (!CompressedImage_readInfo(filepath, &info)) {
+        log_warn("could not load texture file '%s'", filepath);
+        log_warn(" |- Reason: %s", CompressedImage_failureReason());
+        log_warn(" |- Defaulting to magenta texture");
+        return SG_GetTexture(g_builtin_textures.magenta_pixel_id);
+    }
+    if (load_desc->read_to_ck_array || load_desc->flip_y) {
+        log_warn("TextureLoadDesc.read and .flip_y are ignored for '%s'", filepath);
+    }
 
-    if (load_desc->read_to_ck_array) {
-        pixel_data_OWNED = stbi_load(filepath,        //
-                                     &width,          //
-                                     &height,         //
-                                     &num_components, //
-                                     desired_comps    //
-        );
-        stbi_error       = (pixel_data_OWNED == NULL);
-    } else {
-        stbi_error = !(stbi_info(filepath, &width, &height, &num_components));
+    SG_TextureDesc desc = {};
+    desc.width          = info.width;
+    desc.height         = info.height;
+    desc.depth          = info.layers;
+    desc.dimension      = WGPUTextureDimension_2D;
+    desc.format         = WGPUTextureFormat_RGBA8Unorm;
+    desc.usage          = WGPUTextureUsage_All;
+    desc.gen_mips       = false;
+
+    SG_Texture* tex
+      = SG_CreateTexture(&desc, NULL, shred, false, File_basename(filepath));
+    tex->loading = true;
+
+    CQ_PushCommand_TextureFromFile(tex, filepath, load_desc);
+    return tex;
+}
+
+SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_desc,
+                              Chuck_VM_Shred* shred)
+{
+    if (CompressedImage_isContainer(filepath)) {
+        return ulib_texture_loadContainer(filepath, load_desc, shred);
     }
 
-    if (stbi_error) {
+    int width = 0, height = 0, num_components = 0;
+    if (!stbi_info(filepath, &width, &height, &num_components)) {
         log_warn("could not load texture file '%s'", filepath);
         log_warn(" |- Reason: %s", stbi_failure_reason());
         log_warn(" |- Defaulting to magenta texture");
@@ -1030,22 +1145,45 @@ SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_des
         return SG_GetTexture(g_builtin_textures.magenta_pixel_id);
     }
 
+    WGPUTextureFormat format = ulib_texture_loadFormat(
+      load_desc, stbi_is_hdr(filepath), stbi_is_16_bit(filepath));
+
+    LoadImageResult pixels = {};
+    defer(if (pixels.pixel_data_OWNED) stbi_image_free(pixels.pixel_data_OWNED););
+
+    if (load_desc->read_to_ck_array) {
+        LoadImageParams params = {};
+        params.type            = LoadImageType_File;
+        params.format          = format;
+        params.flip_y          = load_desc->flip_y;
+        params.filepath        = filepath;
+        pixels                 = R_Texture_LoadImage(params);
+
+        if (pixels.pixel_data_OWNED == NULL) {
+            log_warn("could not load texture file '%s'", filepath);
+            log_warn(" |- Reason: %s", stbi_failure_reason());
+            log_warn(" |- Defaulting to magenta texture");
+            return SG_GetTexture(g_builtin_textures.magenta_pixel_id);
+        }
+    }
+
     SG_TextureDesc desc = {};
     desc.width          = abs(width);
     desc.height         = abs(height);
     desc.dimension      = WGPUTextureDimension_2D;
-    desc.format         = WGPUTextureFormat_RGBA8Unorm;
+    desc.format         = format;
     desc.usage          = WGPUTextureUsage_All;
     desc.gen_mips       = load_desc->gen_mips ? true : false;
 
     SG_Texture* tex
       = SG_CreateTexture(&desc, NULL, shred, false, File_basename(filepath));
+    tex->loading = true;
 
     CQ_PushCommand_TextureFromFile(tex, filepath, load_desc);
 
-    if (pixel_data_OWNED) {
-        int size_bytes = width * height * desired_comps;
-        SG_Texture::updateTextureData(tex, pixel_data_OWNED, size_bytes);
+    if (pixels.pixel_data_OWNED) {
+        SG_Texture::updateTextureData(tex, pixels.pixel_data_OWNED,
+                                      pixels.pixel_data_size);
     }
 
     return tex;
@@ -1070,11 +1208,14 @@ SG_Texture* ulib_texture_load(unsigned char* buffer, int buffer_len,
     desc.width          = width;
     desc.height         = height;
     desc.dimension      = WGPUTextureDimension_2D;
-    desc.format         = WGPUTextureFormat_RGBA8Unorm;
+    desc.format         = ulib_texture_loadFormat(
+      load_desc, stbi_is_hdr_from_memory(buffer, buffer_len),
+      stbi_is_16_bit_from_memory(buffer, buffer_len));
     desc.usage          = WGPUTextureUsage_All;
     desc.gen_mips       = load_desc->gen_mips ? true : false;
 
     SG_Texture* tex = SG_CreateTexture(&desc, NULL, shred, false, "Raw Data Texture");
+    tex->loading    = true;
 
     CQ_PushCommand_TextureFromRawData(tex, buffer, buffer_len, load_desc);
 
@@ -1121,6 +1262,21 @@ CK_DLL_MFUN(texture_save)
     RETURN->v_object = (Chuck_Object*)e;
 }
 
+CK_DLL_MFUN(texture_loaded)
+{
+    SG_Texture* tex = GET_TEXTURE(SELF);
+    if (!tex->texture_loaded_event) {
+        tex->texture_loaded_event
+          = (Chuck_Event*)chugin_createCkObj("Event", true, SHRED);
+    }
+    RETURN->v_object = (Chuck_Object*)tex->texture_loaded_event;
+}
+
+CK_DLL_MFUN(texture_is_loaded)
+{
+    RETURN->v_int = !GET_TEXTURE(SELF)->loading;
+}
+
 CK_DLL_SFUN(texture_load_2d_file)
 {
     SG_TextureLoadDesc load_desc = {};
@@ -1198,11 +1354,13 @@ SG_Texture* ulib_texture_load_cubemap(const char* right_face, const char* left_f
     desc.height         = cubemap_height;
     desc.depth          = 6; // 6 faces
     desc.dimension      = WGPUTextureDimension_2D;
-    desc.format         = WGPUTextureFormat_RGBA8Unorm;
+    desc.format         = ulib_texture_loadFormat(load_desc, stbi_is_hdr(right_face),
+                                                  stbi_is_16_bit(right_face));
     desc.usage          = WGPUTextureUsage_All;
     desc.gen_mips       = false;
 
     SG_Texture* tex = SG_CreateTexture(&desc, NULL, shred, false);
+    tex->loading    = true;
 
     CQ_PushCommand_CubemapTextureFromFile(tex, load_desc, right_face, left_face,
                                           top_face, bottom_face, back_face, front_face);
@@ -1249,7 +1407,8 @@ static void ulib_texture_copyTextureToTexture(SG_Texture* dst, SG_Texture* src,
     { // validation
         // make sure location is within bounds of texture
         if (dst->desc.resize_mode == SG_TextureResizeMode_Fixed) {
-            int dst_mips = G_mipLevels(dst->desc.width, dst->desc.height);
+            int dst_mips = SG_TextureDesc::mipLevelCount(&dst->desc, dst->desc.width,
+                                                         dst->desc.height);
 
             if (dst_loc.origin_x > dst->desc.width
                 || dst_loc.origin_y > dst->desc.height
@@ -1266,7 +1425,8 @@ static void ulib_texture_copyTextureToTexture(SG_Texture* dst, SG_Texture* src,
         }
 
         if (src->desc.resize_mode == SG_TextureResizeMode_Fixed) {
-            int src_mips = G_mipLevels(src->desc.width, src->desc.height);
+            int src_mips = SG_TextureDesc::mipLevelCount(&src->desc, src->desc.width,
+                                                         src->desc.height);
             if (src_loc.origin_x > src->desc.width
                 || src_loc.origin_y > src->desc.height
                 || src_loc.origin_z > src->desc.depth || src_loc.mip >= src_mips) {
@@ -1340,6 +1500,43 @@ static void ulib_texture_copyTextureToTexture(SG_Texture* dst, SG_Texture* src,
                                         depth);
 }
 
+CK_DLL_SFUN(texture_equirect_to_cubemap)
+{
+    Chuck_Object* equirect_ckobj = GET_NEXT_OBJECT(ARGS);
+    t_CKINT face_size            = GET_NEXT_INT(ARGS);
+
+    if (!equirect_ckobj) {
+        log_warn("could not convert equirect texture to cubemap");
+        log_warn(" |- Reason: null texture object");
+        RETURN->v_object = SG_GetTexture(g_builtin_textures.default_cubemap_id)->ckobj;
+        return;
+    }
+
+    SG_Texture* equirect = GET_TEXTURE(equirect_ckobj);
+    if (equirect->desc.dimension != WGPUTextureDimension_2D
+        || equirect->desc.depth != 1) {
+        log_warn("could not convert texture '%s' to cubemap", equirect->name);
+        log_warn(" |- Reason: equirect source must be a single-layer 2D texture");
+        RETURN->v_object = SG_GetTexture(g_builtin_textures.default_cubemap_id)->ckobj;
+        return;
+    }
+    if (face_size <= 0) face_size = MAX(1, equirect->desc.width / 4);
+
+    SG_TextureDesc desc = {};
+    desc.width          = face_size;
+    desc.height         = face_size;
+    desc.depth          = 6; // 6 faces
+    desc.dimension      = WGPUTextureDimension_2D;
+    desc.format         = WGPUTextureFormat_RGBA16Float;
+    desc.usage          = WGPUTextureUsage_All; // needs StorageBinding
+    desc.gen_mips       = false;
+
+    SG_Texture* cubemap = SG_CreateTexture(&desc, NULL, SHRED, false);
+    CQ_PushCommand_TextureEquirectToCubemap(equirect, cubemap);
+
+    RETURN->v_object = cubemap->ckobj;
+}
+
 CK_DLL_SFUN(texture_copy_texture_to_texture)
 {
     Chuck_Object* dst_ckobj = (GET_NEXT_OBJECT(ARGS));
@@ -1387,3 +1584,15 @@ CK_DLL_SFUN(texture_copy_texture_to_texture_with_desc)
     ulib_texture_copyTextureToTexture(dst_texture, src_texture, dst_loc, src_loc,
                                       copy_size_x, copy_size_y, copy_size_z);
 }
+
+CK_DLL_SFUN(texture_set_cache_directory)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    TextureCache_setDirectory(ck_str ? API->object->str(ck_str) : "");
+}
+
+CK_DLL_SFUN(texture_get_cache_directory)
+{
+    RETURN->v_string
+      = chugin_createCkString(TextureCache_directory().c_str(), false);
+}
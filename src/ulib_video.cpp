@@ -5,13 +5,10 @@ TODO
         - don't destroy the texture, just decrement texture refcount.
         - video texture will no longer be updated, frozen on last decoded video frame
 
-- try to make seek sample-accurate for audio
 - Video.load, allow switching video file dynamically
     - but what about the texture? what should be behavior if new video has different
 dimensions/aspect?
 - default constructor
-- implement frame-skip in plm_decode so that high playback rates do not decode all
-intermediate frames
 - SIMD optimize decoding
 - Support HAP
     - https://github.com/keijiro/KlakHap/blob/master/Plugin/Source/KlakHap.cpp
@@ -71,6 +68,12 @@ CK_DLL_MFUN(video_get_rate);
 CK_DLL_MFUN(video_set_loop);
 CK_DLL_MFUN(video_get_loop);
 
+// decode stats
+CK_DLL_MFUN(video_get_decode_time);
+CK_DLL_MFUN(video_get_decode_time_max);
+CK_DLL_MFUN(video_get_frames_decoded);
+CK_DLL_MFUN(video_get_frames_dropped);
+
 //
 // webcam
 //
@@ -82,6 +85,8 @@ CK_DLL_MFUN(webcam_set_capture);
 CK_DLL_MFUN(webcam_get_capture);
 CK_DLL_MFUN(webcam_set_freeze);
 CK_DLL_MFUN(webcam_get_freeze);
+CK_DLL_MFUN(webcam_set_format);
+CK_DLL_MFUN(webcam_get_format);
 
 CK_DLL_MFUN(webcam_get_width);
 CK_DLL_MFUN(webcam_get_height);
@@ -171,17 +176,17 @@ void ulib_video_query(Chuck_DL_Query* QUERY)
         MFUN(video_set_rate, "void", "rate");
         ARG("float", "rate");
         DOC_FUNC(
-          "Set the playback rate of the video. 1.0 is normal speed. Due to limitations "
-          "in "
-          "the MPEG encoding format, rate cannot be set to less than 0.0. Reverse "
-          "playback "
-          "is NOT supported. Negative rates will be clamped to 0");
+          "Set the playback rate of the video. 1.0 is normal speed. Negative rates "
+          "play the video in reverse; audio is muted while playing in reverse and "
+          "resyncs when the rate becomes positive again. Reverse playback decodes "
+          "one group of frames at a time from the preceding keyframe, and needs the "
+          "keyframe index, which is built in the background when the video is "
+          "opened");
 
         MFUN(video_get_rate, "void", "rate");
         DOC_FUNC(
-          "Get the playback rate of the video. 1.0 is normal speed. Negative rates are "
-          "not "
-          "supported and will be clamped to 0");
+          "Get the playback rate of the video. 1.0 is normal speed. Negative rates "
+          "play in reverse");
 
         MFUN(video_get_loop, "int", "loop");
         DOC_FUNC("Get whether the video is looping. Default false");
@@ -195,14 +200,31 @@ void ulib_video_query(Chuck_DL_Query* QUERY)
         DOC_FUNC(
           "Seek to a specific time in the video. Negative values and values greater "
           "than "
-          "the video length will wrap around. Note that seek is *not* sample-accurate; "
-          "due "
-          "to the nature of MPEG encoding (and the demands of real-time performance), "
-          "the "
-          "seek will be to the nearest keyframe, which in practice is within a few "
-          "frames "
-          "of the target time. For sample-accurate seeking and audio manipulation, we "
-          "recommend loading the audio data separately into a SndBuf");
+          "the video length will wrap around. The video seeks to the exact frame at "
+          "the target time, decoding forward from the preceding keyframe. Audio "
+          "resumes at the target time, rounded to the audio stream's sample rate. "
+          "For sample-accurate audio manipulation, we recommend loading the audio "
+          "data separately into a SndBuf");
+
+        MFUN(video_get_decode_time, "float", "decodeTime");
+        DOC_FUNC(
+          "Average time in milliseconds to decode one video frame, measured over "
+          "the last half second. Frames are decoded on background threads, so this "
+          "does not count against the frame time of the graphics thread, but "
+          "decoding needs to keep up with framerate() * rate() for smooth playback");
+
+        MFUN(video_get_decode_time_max, "float", "decodeTimeMax");
+        DOC_FUNC(
+          "Slowest single frame decode in milliseconds over the last half second");
+
+        MFUN(video_get_frames_decoded, "int", "framesDecoded");
+        DOC_FUNC("Total number of video frames decoded so far");
+
+        MFUN(video_get_frames_dropped, "int", "framesDropped");
+        DOC_FUNC(
+          "Number of decoded video frames that were never shown, because "
+          "decoding fell behind playback or the playback rate is higher than the "
+          "window framerate");
 
         END_CLASS();
     }
@@ -210,12 +232,34 @@ void ulib_video_query(Chuck_DL_Query* QUERY)
     { // webcam
         BEGIN_CLASS(SG_CKNames[SG_COMPONENT_WEBCAM], SG_CKNames[SG_COMPONENT_BASE]);
         DOC_CLASS(
-          "ChuGL Webcam class. Opens a webcam at any device id 0-7, and "
+          "ChuGL Webcam class. Opens a webcam by device id, and "
           "updates a texture with the webcam feed. The webcam texture may be "
-          "accessed with the `.texture()` member function");
+          "accessed with the `.texture()` member function. Each device captures "
+          "on its own thread; the graphics thread only uploads the newest frame, "
+          "and skips the upload when no new frame arrived");
         ADD_EX("basic/webcam.ck");
         ADD_EX("deep/webcam-echo.ck");
 
+        static t_CKINT webcam_synthetic   = SG_WEBCAM_DEVICE_SYNTHETIC;
+        static t_CKINT webcam_format_rgba = SG_WEBCAM_FORMAT_RGBA;
+        static t_CKINT webcam_format_yuyv = SG_WEBCAM_FORMAT_YUYV;
+        static t_CKINT webcam_format_nv12 = SG_WEBCAM_FORMAT_NV12;
+        SVAR("int", "SYNTHETIC", &webcam_synthetic);
+        DOC_VAR(
+          "Device id of a synthetic webcam that generates a scrolling color bar "
+          "test pattern at the requested width, height and fps. Works without a "
+          "camera, on every platform");
+        SVAR("int", "FORMAT_RGBA", &webcam_format_rgba);
+        DOC_VAR("Upload frames as RGBA, 4 bytes per pixel. Default");
+        SVAR("int", "FORMAT_YUYV", &webcam_format_yuyv);
+        DOC_VAR(
+          "Upload frames as packed YUYV 4:2:2, 2 bytes per pixel, converted to RGBA "
+          "on the GPU");
+        SVAR("int", "FORMAT_NV12", &webcam_format_nv12);
+        DOC_VAR(
+          "Upload frames as NV12 4:2:0, 1.5 bytes per pixel, converted to RGBA on "
+          "the GPU");
+
         CTOR(webcam_ctor);
         DOC_FUNC(
           "Create a webcam object with default device id 0. On laptops this is "
@@ -282,6 +326,18 @@ void ulib_video_query(Chuck_DL_Query* QUERY)
         MFUN(webcam_get_freeze, "int", "freeze");
         DOC_FUNC("Get whether the webcam texture is frozen (not updating).");
 
+        MFUN(webcam_set_format, "void", "format");
+        ARG("int", "format");
+        DOC_FUNC(
+          "Set the pixel format frames are uploaded to the GPU in, one of "
+          "Webcam.FORMAT_RGBA, Webcam.FORMAT_YUYV or Webcam.FORMAT_NV12. The YUV "
+          "formats cut upload bandwidth for high resolutions or many cameras, at a "
+          "small cost in color resolution; the conversion to YUV happens on the "
+          "capture thread. Shared by all webcam objects using the same device id");
+
+        MFUN(webcam_get_format, "int", "format");
+        DOC_FUNC("Get the pixel format frames are uploaded in. Default FORMAT_RGBA");
+
         END_CLASS();
     }
 }
@@ -300,6 +356,18 @@ CK_DLL_TICKF(video_tick_multichannel)
         return TRUE;
     }
 
+    // MP2 audio can't be decoded backwards. Mute and keep track of how far the
+    // video went, audio is resynced once the graphics thread reports where
+    // forward playback restarted (ulib_video_resync)
+    if (video->rate < 0 || video->awaiting_resync) {
+        double secs = video->rate / video->samplerate;
+        video->reverse_secs += secs;
+        if (video->awaiting_resync) video->resync_secs += secs;
+        out[0] = 0;
+        out[1] = 0;
+        return TRUE;
+    }
+
     while (video->samples == NULL
            || video->audio_playhead >= (float)video->samples->count - 1) {
 
@@ -509,22 +577,35 @@ CK_DLL_MFUN(video_get_height_texels)
 
 CK_DLL_MFUN(video_get_time)
 {
-    plm_t* plm = GET_VIDEO(SELF)->plm;
+    SG_Video* video = GET_VIDEO(SELF);
+    plm_t* plm      = video->plm;
     if (plm) {
-        RETURN->v_dur = plm_get_time(plm) * API->vm->srate(VM);
+        RETURN->v_dur = (plm_get_time(plm) + video->reverse_secs) * API->vm->srate(VM);
     } else {
         RETURN->v_dur = 0;
     }
 }
 
+static void ulib_video_seek_seconds(SG_Video* video, double time_seconds);
+
 CK_DLL_MFUN(video_set_rate)
 {
-    SG_Video* video = GET_VIDEO(SELF);
-    video->rate     = GET_NEXT_FLOAT(ARGS);
-    video->rate     = MAX(0.0, video->rate);
+    SG_Video* video  = GET_VIDEO(SELF);
+    bool was_reverse = video->rate < 0;
+    video->rate      = GET_NEXT_FLOAT(ARGS);
+
+    if (!video->plm) return;
 
-    if (video->plm) {
-        CQ_PushCommand_VideoRate(video->id, video->rate, plm_get_loop(video->plm));
+    // graphics thread restarts decoding in the new direction
+    CQ_PushCommand_VideoRate(video->id, video->rate, plm_get_loop(video->plm));
+
+    if (was_reverse && video->rate >= 0) {
+        // audio stayed where reverse playback started. The graphics thread
+        // restarts from the frame on screen and reports its position back
+        video->awaiting_resync = true;
+        video->resync_secs     = 0;
+    } else if (video->rate < 0) {
+        video->awaiting_resync = false; // reversed again before the resync
     }
 }
 
@@ -552,19 +633,34 @@ CK_DLL_MFUN(video_get_loop)
     }
 }
 
-CK_DLL_MFUN(video_seek)
+CK_DLL_MFUN(video_get_decode_time)
 {
-    SG_Video* video = GET_VIDEO(SELF);
-    if (!video->plm) return;
+    RETURN->v_float = GET_VIDEO(SELF)->stats.decode_ms;
+}
 
-    // get time and wrap around video length (allows negative indexing)
-    int time_samples = (int)GET_NEXT_DUR(ARGS);
-    while (time_samples < 0) {
-        time_samples += SG_Video::audioFrames(video);
-    }
-    time_samples = time_samples % SG_Video::audioFrames(video);
+CK_DLL_MFUN(video_get_decode_time_max)
+{
+    RETURN->v_float = GET_VIDEO(SELF)->stats.decode_ms_max;
+}
+
+CK_DLL_MFUN(video_get_frames_decoded)
+{
+    RETURN->v_int = GET_VIDEO(SELF)->stats.frames_decoded;
+}
+
+CK_DLL_MFUN(video_get_frames_dropped)
+{
+    RETURN->v_int = GET_VIDEO(SELF)->stats.frames_dropped;
+}
 
-    double time_seconds = (double)time_samples / API->vm->srate(VM);
+// moves audio playback to time_seconds, the graphics thread is left alone
+static void ulib_video_seek_audio(SG_Video* video, double time_seconds)
+{
+    video->reverse_secs    = 0;
+    video->awaiting_resync = false;
+
+    // video-only files have nothing to seek on the audio thread
+    if (plm_get_num_audio_streams(video->plm) == 0) return;
 
     // log_error("seeking to %f seconds from %f seconds", time_seconds,
     //           plm_get_time(video->plm));
@@ -578,11 +674,51 @@ CK_DLL_MFUN(video_seek)
         return;
     }
 
-    // else seek succeeded, tell video to seek as well
-    // log_error("targeted seek time %f, actual seek time %f, difference: %f",
-    //           time_seconds, out_seek_time, time_seconds - out_seek_time);
+    // plm_seek_audio lands on the packet before the keyframe preceding the
+    // target. ulib_video_on_audio reset the playhead to the start of the first
+    // audio frame there, skip ahead to the target. The tick decodes the audio
+    // frames in between
+    if (video->samples && video->samples->time < time_seconds) {
+        video->audio_playhead
+          = (float)((time_seconds - video->samples->time) * video->samplerate);
+    }
+}
+
+static void ulib_video_seek_seconds(SG_Video* video, double time_seconds)
+{
+    ulib_video_seek_audio(video, time_seconds);
+
+    // the graphics thread seeks to the exact frame
+    CQ_PushCommand_VideoSeek(video->id, time_seconds);
+}
+
+// called with the position the graphics thread restarted forward playback from.
+// Audio picks up there, plus however far the video played since
+static void ulib_video_resync(SG_Video* video, double stream_time)
+{
+    if (!video->plm || !video->awaiting_resync) return;
+
+    double time = stream_time + video->resync_secs;
+    if (plm_get_loop(video->plm)) {
+        time = fmod(time, (double)video->duration_secs);
+        if (time < 0) time += video->duration_secs;
+    }
+    ulib_video_seek_audio(video, CLAMP(time, 0.0, (double)video->duration_secs));
+}
+
+CK_DLL_MFUN(video_seek)
+{
+    SG_Video* video = GET_VIDEO(SELF);
+    if (!video->plm) return;
+
+    // get time and wrap around video length (allows negative indexing)
+    int time_samples = (int)GET_NEXT_DUR(ARGS);
+    while (time_samples < 0) {
+        time_samples += SG_Video::audioFrames(video);
+    }
+    time_samples = time_samples % SG_Video::audioFrames(video);
 
-    CQ_PushCommand_VideoSeek(video->id, out_seek_time);
+    ulib_video_seek_seconds(video, (double)time_samples / API->vm->srate(VM));
 }
 
 // =================================================================================================
@@ -591,19 +727,21 @@ CK_DLL_MFUN(video_seek)
 
 // currently unsupported on linux.
 // logs warning if Webcam constructor is called on linux
-static void ulib_webcam_validate()
+static void ulib_webcam_validate(int device_id)
 {
+    if (device_id == SG_WEBCAM_DEVICE_SYNTHETIC) return; // no camera involved
 #if defined(_WIN32)
 #elif defined(__APPLE__)
 #elif defined(__EMSCRIPTEN__)
 #else /* anything else, this will need more care for non-Linux platforms */
     log_warn("webcam is not supported on this platform");
 #endif
+    UNUSED_VAR(device_id);
 }
 
 CK_DLL_CTOR(webcam_ctor)
 {
-    ulib_webcam_validate();
+    ulib_webcam_validate(0);
     // SG_CreateWebcam(SELF, SHRED, 0, 640, 480, 60);
     // default to really high resolution (should fallback to largest supported)
     SG_CreateWebcam(SELF, SHRED, 0, 4096, 4096, 60);
@@ -611,15 +749,15 @@ CK_DLL_CTOR(webcam_ctor)
 
 CK_DLL_CTOR(webcam_ctor_with_device_id)
 {
-    ulib_webcam_validate();
     int device_id = GET_NEXT_INT(ARGS);
+    ulib_webcam_validate(device_id);
     SG_CreateWebcam(SELF, SHRED, device_id, 640, 480, 60);
 }
 
 CK_DLL_CTOR(webcam_ctor_with_device_id_and_format)
 {
-    ulib_webcam_validate();
     int device_id = GET_NEXT_INT(ARGS);
+    ulib_webcam_validate(device_id);
     int width     = GET_NEXT_INT(ARGS);
     int height    = GET_NEXT_INT(ARGS);
     int fps       = GET_NEXT_INT(ARGS);
@@ -692,3 +830,20 @@ CK_DLL_MFUN(webcam_get_freeze)
 {
     RETURN->v_int = GET_WEBCAM(SELF)->freeze;
 }
+
+CK_DLL_MFUN(webcam_set_format)
+{
+    SG_Webcam* webcam = GET_WEBCAM(SELF);
+    t_CKINT format    = GET_NEXT_INT(ARGS);
+    if (format < 0 || format >= SG_WEBCAM_FORMAT_COUNT) {
+        log_warn("invalid webcam format %d, keeping the current format", (int)format);
+        return;
+    }
+    webcam->format = (SG_WebcamFormat)format;
+    CQ_PushCommand_WebcamUpdate(webcam);
+}
+
+CK_DLL_MFUN(webcam_get_format)
+{
+    RETURN->v_int = GET_WEBCAM(SELF)->format;
+}